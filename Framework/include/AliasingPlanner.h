@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct AliasingPlanStats
+{
+	uint32_t ResourceCount = 0;
+	// 寿命の重ならないリソースで共有する区画の数。寿命の重なりの最大数になる
+	uint32_t SlotCount = 0;
+	// リソースを個別に確保した場合の量
+	uint64_t TotalSize = 0;
+	// 区画を並べたときの量
+	uint64_t AliasedSize = 0;
+};
+
+// 寿命(最初と最後に使うパスのインデックスの閉区間)と大きさを持つリソースに、寿命の重ならないもの同士で
+// メモリを共有するオフセットを割り当てる。配置を計算するだけでヒープもリソースも作らないので、
+// 実際に共有するには呼び出し側がヒープにCreatePlacedResource()で置き、使い始めにエイリアシングバリアと初期化をする。
+// SampleAppのターゲットはコミットされたリソースのままで、RenderGraphの寿命から共有した場合のメモリ量を見積もるのにだけ使っている
+class AliasingPlanner
+{
+public:
+	static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+	AliasingPlanner();
+	~AliasingPlanner();
+
+	// 登録したリソースと計画を空にする
+	void Reset();
+
+	// 戻り値はGetOffset()に渡すインデックス
+	uint32_t AddResource(uint64_t size, uint64_t alignment, uint32_t firstPass, uint32_t lastPass);
+
+	// 開始の早い順に区間グラフを彩色し、区画ごとのオフセットを決める
+	void Plan();
+
+	// 区画の先頭からのオフセット。Plan()する前はINVALID_OFFSET
+	uint64_t GetOffset(uint32_t resourceIdx) const;
+	uint32_t GetResourceCount() const { return static_cast<uint32_t>(m_Resources.size()); }
+	const AliasingPlanStats& GetStats() const { return m_Stats; }
+
+private:
+	struct Resource
+	{
+		uint64_t Size;
+		uint64_t Alignment;
+		uint32_t FirstPass;
+		uint32_t LastPass;
+		// 以下はPlan()で求める
+		uint32_t SlotIdx;
+		uint64_t Offset;
+	};
+
+	// 寿命が重ならないリソースで共有するメモリの区画
+	struct Slot
+	{
+		uint64_t Size;
+		uint64_t Alignment;
+		uint64_t Offset;
+		uint32_t LastPass;
+	};
+
+	std::vector<Resource> m_Resources;
+	std::vector<Slot> m_Slots;
+	// Plan()の作業用。計画し直すたびに確保し直さないように持っておく
+	std::vector<uint32_t> m_SortedResources;
+	AliasingPlanStats m_Stats;
+
+	AliasingPlanner(const AliasingPlanner&) = delete;
+	void operator=(const AliasingPlanner&) = delete;
+};
@@ -11,6 +11,8 @@
 #include "DepthTarget.h"
 #include "CommandList.h"
 #include "Fence.h"
+#include "FramePacer.h"
+#include "UploadRing.h"
 
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -26,6 +28,7 @@ class App
 {
 public:
 	// Number of frame buffers
+	// CPUGPUőFRAME_COUNT - 1t[ɐiނ̂ŁAt[Ƃɏ萔obt@FRAME_COUNTɂ
 	static const uint32_t FRAME_COUNT = 2;
 
 	App(uint32_t width, uint32_t height, DXGI_FORMAT format);
@@ -62,6 +65,9 @@ protected:
 	ColorTarget m_BackBuffer[FRAME_COUNT];
 	CommandList m_CommandList;
 	Fence m_Fence;
+	// obNobt@̃CfbNXƂɁÃt[̃R}h̊ŃVOitFX̒l
+	FramePacer m_FramePacer;
+	UploadRing m_UploadRing;
 	uint32_t m_FrameIndex;
 	D3D12_VIEWPORT m_Viewport;
 	D3D12_RECT m_Scissor;
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include <d3d12.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ComPtr.h"
+#include "TlsfAllocator.h"
+
+class UploadRing;
+
+// BufferSuballocatorから切り出した範囲
+struct BufferAllocation
+{
+	ID3D12Resource* pResource = nullptr;
+	uint64_t Offset = 0;
+	uint64_t Size = 0;
+	uint32_t PageIdx = UINT32_MAX;
+	// ページのTlsfAllocatorのブロック
+	uint32_t BlockIdx = UINT32_MAX;
+};
+
+struct BufferSuballocatorStats
+{
+	uint32_t PageCount = 0;
+	// ページの大きさの合計
+	uint64_t PageSize = 0;
+	uint64_t UsedSize = 0;
+	uint64_t LargestFreeBlockSize = 0;
+	uint32_t AllocationCount = 0;
+	uint32_t FreeBlockCount = 0;
+	// 全ページの空きの合計に対する、最大の空きブロック以外の空きの割合
+	float Fragmentation = 0.0f;
+	// 確保中の範囲ごとにコミットされたリソースを作った場合のメモリ量。バッファは64KB単位で確保されるので、その単位に切り上げて合計する
+	uint64_t CommittedEquivalentSize = 0;
+};
+
+// DEFAULTヒープの大きなバッファをページとして作り、ページごとのTlsfAllocatorで範囲を切り出すアロケータ。
+// 空きのあるページがなければページを足し、ページより大きい範囲はその大きさの専用のページにする。
+// 解放した範囲は前後の空きと結合されるので、ロードと破棄を繰り返しても同じページを使い回せる。
+// ページはCOMMONの状態で作り、切り出した範囲は暗黙の状態遷移で使う。
+// 書き込みはUploadRingのコマンドリストで暗黙にCOPY_DESTにしてコピーするので、ページを共有する範囲の状態を気にしなくてよい
+class BufferSuballocator
+{
+public:
+	BufferSuballocator();
+	~BufferSuballocator();
+
+	bool Init(ID3D12Device* pDevice, uint64_t pageSize, D3D12_RESOURCE_FLAGS flags, LPCWSTR name);
+	void Term();
+
+	// alignmentの倍数のオフセットからsizeを切り出す。StructuredBufferならalignmentに要素の大きさを渡せば、
+	// OffsetがFirstElementの倍数になる
+	bool Allocate(uint64_t size, uint64_t alignment, BufferAllocation& allocation);
+	void Free(const BufferAllocation& allocation);
+
+	// allocationの範囲の先頭にpUploadRingを通してsizeだけコピーする。範囲を読むコマンドリストを実行する前にUploadRing::Submit()すること
+	bool Upload(UploadRing* pUploadRing, const BufferAllocation& allocation, uint64_t size, const void* pData);
+
+	BufferSuballocatorStats GetStats() const;
+
+	// allocationの範囲をstride単位の要素として見るSRVの設定。OffsetはAllocate()にstrideをalignmentとして渡しておく
+	static D3D12_SHADER_RESOURCE_VIEW_DESC GetStructuredBufferSRVDesc(const BufferAllocation& allocation, uint32_t stride);
+
+private:
+	struct Page
+	{
+		ComPtr<ID3D12Resource> pResource;
+		std::unique_ptr<TlsfAllocator> pAllocator;
+	};
+
+	ComPtr<ID3D12Device> m_pDevice;
+	uint64_t m_PageSize;
+	D3D12_RESOURCE_FLAGS m_Flags;
+	std::wstring m_Name;
+	std::vector<Page> m_Pages;
+	uint64_t m_CommittedEquivalentSize;
+
+	bool AddPage(uint64_t size);
+
+	BufferSuballocator(const BufferSuballocator&) = delete;
+	void operator=(const BufferSuballocator&) = delete;
+};
@@ -0,0 +1,174 @@
+﻿#pragma once
+
+#include <SimpleMath.h>
+#include <cassert>
+#include <cfloat>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// BVHの深さの上限。探索のスタックの大きさになるので、構築ではこれより深くなる前に葉にする
+static constexpr uint32_t BVH_MAX_DEPTH = 64;
+
+// 32バイトのBVHのノード。2つの子は隣り合わせに置く
+struct BvhNode
+{
+	DirectX::SimpleMath::Vector3 BoundsMin;
+	// 内部ノードなら左の子のインデックスで、右の子はその次。葉ならBvh::GetPrimIndices()の最初のインデックス
+	uint32_t LeftOrFirst;
+	DirectX::SimpleMath::Vector3 BoundsMax;
+	// 葉ならプリミティブ数、内部ノードなら0
+	uint32_t PrimCount;
+
+	bool IsLeaf() const { return PrimCount > 0; }
+};
+
+static_assert(sizeof(BvhNode) == 32);
+
+struct BvhPrimitiveBounds
+{
+	DirectX::SimpleMath::Vector3 Min;
+	DirectX::SimpleMath::Vector3 Max;
+};
+
+struct BvhBuildSettings
+{
+	// SAHのビンの数。32以下
+	uint32_t BinCount = 16;
+	// これ以下のプリミティブ数で、分割してもSAHのコストが下がらなければ葉にする
+	uint32_t MaxLeafSize = 4;
+	// SAHのコストの、ノードの走査とプリミティブの交差判定の比
+	float TraversalCost = 1.0f;
+	float IntersectionCost = 1.0f;
+	// falseなら呼び出しスレッドだけで構築する
+	bool Multithreaded = true;
+	// trueならRefit()のために、ノードの親とプリミティブを含む葉のインデックスを持つ
+	bool Refittable = false;
+};
+
+struct BvhBuildStats
+{
+	double BuildMilliseconds = 0.0;
+	uint32_t NodeCount = 0;
+	uint32_t LeafCount = 0;
+	uint32_t MaxDepth = 0;
+	uint32_t MaxLeafPrimCount = 0;
+	// ルートのAABBの表面積に対する、各ノードのAABBの表面積の割合で重みをつけたコスト
+	float SAHCost = 0.0f;
+};
+
+// ビンで近似したSAHで分割する2分木のBVH。
+// 上の方のノードはプリミティブ数が多いので、ビンの集計をParallelForで並列に行う。
+// 部分木がスレッド数より十分多くなったところで、残りの部分木をParallelForでスレッドごとに構築して最後につなげる。
+// Ingo Wald, "On fast Construction of SAH-based Bounding Volume Hierarchies", 2007を参考にしている
+class Bvh
+{
+public:
+	// プリミティブごとのAABBから構築する。プリミティブ数は1以上であること
+	bool Build(uint32_t primCount, const BvhPrimitiveBounds* pBounds, const BvhBuildSettings& settings);
+	void Term();
+
+	const std::vector<BvhNode>& GetNodes() const { return m_Nodes; }
+	// 葉の順に並べたプリミティブのインデックス
+	const std::vector<uint32_t>& GetPrimIndices() const { return m_PrimIndices; }
+	const BvhBuildStats& GetBuildStats() const { return m_BuildStats; }
+	size_t GetMemorySize() const { return m_Nodes.size() * sizeof(BvhNode) + (m_PrimIndices.size() + m_ParentIndices.size() + m_PrimLeafIndices.size()) * sizeof(uint32_t); }
+
+	// Refittableで構築したBVHで、pPrimIndicesのcount個のプリミティブのAABBがpBoundsに変わったとき、
+	// 木の形はそのままで、それらを含む葉から根までのノードのAABBを求め直す。pBoundsはBuild()と同じ並びの全プリミティブ分。
+	// 動いたプリミティブの数と木の深さに比例する時間で済むが、大きく動くとSAHの質が落ちるので、そのときはBuild()し直す
+	bool Refit(const uint32_t* pPrimIndices, uint32_t count, const BvhPrimitiveBounds* pBounds);
+
+	// originからdirectionの光線と[0, tMax]で交差する葉ごとに、近い順にfunc(葉のBvhNode)を呼ぶ。
+	// funcはプリミティブと交差したらtMaxを縮め、trueを返すと探索を打ち切る
+	template<typename Func>
+	void Traverse(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& direction, float& tMax, Func&& func) const
+	{
+		if (m_Nodes.empty())
+		{
+			return;
+		}
+
+		const float invDir[3] = {1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z};
+		const float org[3] = {origin.x, origin.y, origin.z};
+
+		uint32_t stack[BVH_MAX_DEPTH];
+		uint32_t stackSize = 0;
+
+		const BvhNode* pNode = &m_Nodes[0];
+		if (IntersectBounds(*pNode, org, invDir, tMax) == FLT_MAX)
+		{
+			return;
+		}
+
+		while (true)
+		{
+			if (pNode->IsLeaf())
+			{
+				if (func(*pNode))
+				{
+					return;
+				}
+			}
+			else
+			{
+				const BvhNode* pLeft = &m_Nodes[pNode->LeftOrFirst];
+				const BvhNode* pRight = pLeft + 1;
+				float leftT = IntersectBounds(*pLeft, org, invDir, tMax);
+				float rightT = IntersectBounds(*pRight, org, invDir, tMax);
+
+				if (leftT > rightT)
+				{
+					std::swap(leftT, rightT);
+					std::swap(pLeft, pRight);
+				}
+
+				if (leftT != FLT_MAX)
+				{
+					// 遠い方は後で調べる
+					if (rightT != FLT_MAX)
+					{
+						assert(stackSize < BVH_MAX_DEPTH);
+						stack[stackSize++] = static_cast<uint32_t>(pRight - m_Nodes.data());
+					}
+					pNode = pLeft;
+					continue;
+				}
+			}
+
+			if (stackSize == 0)
+			{
+				return;
+			}
+			pNode = &m_Nodes[stack[--stackSize]];
+		}
+	}
+
+	// スラブ法で光線とノードのAABBの交差を調べ、入る距離を返す。交差しなければFLT_MAXを返す
+	static float IntersectBounds(const BvhNode& node, const float origin[3], const float invDir[3], float tMax)
+	{
+		const float* pMin = &node.BoundsMin.x;
+		const float* pMax = &node.BoundsMax.x;
+
+		float tNear = 0.0f;
+		float tFar = tMax;
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			float t0 = (pMin[axis] - origin[axis]) * invDir[axis];
+			float t1 = (pMax[axis] - origin[axis]) * invDir[axis];
+			// NaNのときは範囲を狭めないよう、比較の順番に気をつける
+			tNear = (t0 < t1) ? ((t0 > tNear) ? t0 : tNear) : ((t1 > tNear) ? t1 : tNear);
+			tFar = (t0 < t1) ? ((t1 < tFar) ? t1 : tFar) : ((t0 < tFar) ? t0 : tFar);
+		}
+
+		return (tNear <= tFar) ? tNear : FLT_MAX;
+	}
+
+private:
+	std::vector<BvhNode> m_Nodes;
+	std::vector<uint32_t> m_PrimIndices;
+	// Refittableのときだけ持つ。根の親はUINT32_MAX
+	std::vector<uint32_t> m_ParentIndices;
+	std::vector<uint32_t> m_PrimLeafIndices;
+	BvhBuildStats m_BuildStats;
+};
@@ -0,0 +1,127 @@
+﻿#pragma once
+
+#include <SimpleMath.h>
+#include <cstdint>
+#include <vector>
+#include "StencilTable.h"
+#include "SubdTopology.h"
+
+// Catmull-Clark細分割。
+// Init()でトポロジの細分割とステンシルテーブルの計算をメッシュにつき一度だけ行い、
+// 以後のコントロールポイントの変形に対してはEvaluate()でステンシルを適用するだけで細分割後の頂点が求まる。
+// 細分割後の頂点の並びは面の点、エッジの点、頂点の点の順。境界はエッジとコーナーをシャープに扱う。
+class CatmullClarkRefiner
+{
+public:
+	CatmullClarkRefiner() = default;
+	~CatmullClarkRefiner();
+
+	bool Init(const SubdTopology& cage, uint32_t maxLevel);
+	void Term();
+
+	uint32_t GetMaxLevel() const;
+	// level == 0はコントロールケージ
+	const SubdTopology& GetTopology(uint32_t level) const;
+	uint32_t GetVertexCount(uint32_t level) const;
+	// コントロールポイントからlevelの頂点への直接のステンシル。level >= 1
+	const StencilTable& GetStencilTable(uint32_t level) const;
+
+	// pDstにはGetVertexCount(level)個の要素が必要
+	void Evaluate(uint32_t level, const DirectX::SimpleMath::Vector3* pControlPoints, DirectX::SimpleMath::Vector3* pDst) const;
+
+	// levelの各頂点を極限曲面上に移すステンシル。level >= 1。
+	// セミシャープなクリースはシャープとして扱うので、シャープネスが残っているレベルでは近似になる
+	bool ComputeLimitStencilTable(uint32_t level, StencilTable& result) const;
+
+private:
+	std::vector<SubdTopology> m_Topologies;
+	// 要素数はmaxLevel + 1。[0]は使わない
+	std::vector<StencilTable> m_StencilTables;
+
+	CatmullClarkRefiner(const CatmullClarkRefiner&) = delete;
+	void operator=(const CatmullClarkRefiner&) = delete;
+};
+
+enum SUBD_PATCH_TYPE
+{
+	SUBD_PATCH_TYPE_REGULAR, // 4x4のコントロールポイントによる双三次一様Bスプライン
+	SUBD_PATCH_TYPE_BILINEAR, // 孤立の最大レベルで残った不規則な面。4隅の極限位置の双一次補間
+};
+
+struct SubdPatch
+{
+	SUBD_PATCH_TYPE Type;
+	// パッチを切り出した細分割レベル
+	uint32_t Level;
+	// GetPatchPointIndices()の先頭。REGULARは行優先の16個、BILINEARは面の頂点順の4個
+	uint32_t FirstIndex;
+};
+
+// 特徴適応細分割。
+// 非正則頂点（価数4以外）、クリース、境界、四角形以外の面の周囲だけを指定レベルまで細分割して孤立させ、
+// それ以外は細分割せずにそのレベルの正則な面を双三次Bスプラインパッチとして出力する。
+// 細分割後のメッシュ全体ではなく、パッチのコントロールポイントへのステンシルだけを保持する。
+//
+// パラメータ空間はケージの四角形の面ごとに1つ、四角形以外のn角形の面はレベル1の子の面ごとにn個の[0, 1]^2のドメインになる。
+// ドメインのuは面の0番目の頂点から1番目の頂点へ、vは0番目の頂点から最後の頂点へ向かう。
+// CHWTessellatorの四角形ドメインの点をそのまま渡して評価できる。
+class AdaptiveCatmullClarkRefiner
+{
+public:
+	AdaptiveCatmullClarkRefiner() = default;
+	~AdaptiveCatmullClarkRefiner();
+
+	// isolationLevel >= 1
+	bool Init(const SubdTopology& cage, uint32_t isolationLevel);
+	void Term();
+
+	uint32_t GetIsolationLevel() const { return m_IsolationLevel; }
+	uint32_t GetDomainCount() const { return static_cast<uint32_t>(m_DomainNodes.size()); }
+	const std::vector<SubdPatch>& GetPatches() const { return m_Patches; }
+	const std::vector<uint32_t>& GetPatchPointIndices() const { return m_PatchPointIndices; }
+	uint32_t GetPatchPointCount() const { return m_PatchPointStencils.GetStencilCount(); }
+	// コントロールポイントからパッチのコントロールポイントへのステンシル
+	const StencilTable& GetPatchPointStencilTable() const { return m_PatchPointStencils; }
+	// 評価に必要なデータの合計サイズ
+	size_t GetMemorySize() const;
+
+	// pPatchPointsにはGetPatchPointCount()個の要素が必要
+	void EvaluatePatchPoints(const DirectX::SimpleMath::Vector3* pControlPoints, DirectX::SimpleMath::Vector3* pPatchPoints) const;
+
+	// ドメインの(u, v)の極限曲面上の位置とu, vによる偏微分。pDu, pDvはnullptrでもよい
+	void Evaluate(
+		uint32_t domain,
+		float u,
+		float v,
+		const DirectX::SimpleMath::Vector3* pPatchPoints,
+		DirectX::SimpleMath::Vector3* pPosition,
+		DirectX::SimpleMath::Vector3* pDu,
+		DirectX::SimpleMath::Vector3* pDv) const;
+	void Evaluate(
+		uint32_t domain,
+		uint32_t count,
+		const DirectX::SimpleMath::Vector2* pUVs,
+		const DirectX::SimpleMath::Vector3* pPatchPoints,
+		DirectX::SimpleMath::Vector3* pPositions,
+		DirectX::SimpleMath::Vector3* pDus,
+		DirectX::SimpleMath::Vector3* pDvs) const;
+
+private:
+	// ドメインを4分木で分割したノード。Patch != UINT32_MAXなら葉
+	struct PatchNode
+	{
+		uint32_t Patch;
+		uint32_t FirstChild;
+	};
+
+	uint32_t m_IsolationLevel = 0;
+	std::vector<SubdPatch> m_Patches;
+	std::vector<uint32_t> m_PatchPointIndices;
+	std::vector<PatchNode> m_Nodes;
+	// ドメインごとの4分木のルートノード
+	std::vector<uint32_t> m_DomainNodes;
+	StencilTable m_PatchPointStencils;
+
+	AdaptiveCatmullClarkRefiner(const AdaptiveCatmullClarkRefiner&) = delete;
+	void operator=(const AdaptiveCatmullClarkRefiner&) = delete;
+};
@@ -20,8 +20,11 @@ public:
 
 	void Term();
 
+	// Resets the allocators in turn. The GPU must have finished the commands recorded with the allocator to be reset.
 	ID3D12GraphicsCommandList6* Reset();
 
+	ID3D12GraphicsCommandList6* Get() const;
+
 private:
 	ComPtr<ID3D12GraphicsCommandList6> m_pCmdList;
 	std::vector<ComPtr<ID3D12CommandAllocator>> m_pAllocators;
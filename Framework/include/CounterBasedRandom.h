@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include <cstdint>
+
+// カウンタベースの乱数Philox4x32-10。
+// (ID, フレーム, ストリーム, 0)をカウンタ、(シード, 0)をキーにして、4つの32ビットの乱数を生成する。
+// Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC 2011を参考にしている。
+// 状態を持たないのでどの順番でもどのスレッドからでも同じ値を生成できる。
+// 32ビット整数どうしの乗算の上位と下位、XOR、加算しか使わないので、ParticleSample/res/CounterBasedRandom.hlsliとビット単位で一致する
+static constexpr uint32_t PHILOX_MULTIPLIER_0 = 0xD2511F53u;
+static constexpr uint32_t PHILOX_MULTIPLIER_1 = 0xCD9E8D57u;
+static constexpr uint32_t PHILOX_WEYL_0 = 0x9E3779B9u;
+static constexpr uint32_t PHILOX_WEYL_1 = 0xBB67AE85u;
+static constexpr uint32_t PHILOX_ROUNDS = 10;
+
+inline void GeneratePhilox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4])
+{
+	uint32_t c0 = counter[0];
+	uint32_t c1 = counter[1];
+	uint32_t c2 = counter[2];
+	uint32_t c3 = counter[3];
+	uint32_t k0 = key[0];
+	uint32_t k1 = key[1];
+
+	for (uint32_t round = 0; round < PHILOX_ROUNDS; round++)
+	{
+		uint64_t product0 = static_cast<uint64_t>(PHILOX_MULTIPLIER_0) * c0;
+		uint64_t product1 = static_cast<uint64_t>(PHILOX_MULTIPLIER_1) * c2;
+
+		c0 = static_cast<uint32_t>(product1 >> 32) ^ c1 ^ k0;
+		c1 = static_cast<uint32_t>(product1);
+		c2 = static_cast<uint32_t>(product0 >> 32) ^ c3 ^ k1;
+		c3 = static_cast<uint32_t>(product0);
+
+		k0 += PHILOX_WEYL_0;
+		k1 += PHILOX_WEYL_1;
+	}
+
+	result[0] = c0;
+	result[1] = c1;
+	result[2] = c2;
+	result[3] = c3;
+}
+
+inline void GenerateRandom4(uint32_t id, uint32_t frame, uint32_t stream, uint32_t seed, uint32_t result[4])
+{
+	const uint32_t counter[4] = {id, frame, stream, 0};
+	const uint32_t key[2] = {seed, 0};
+	GeneratePhilox4x32(counter, key, result);
+}
+
+// 上位24ビットを[0, 1)のfloatにする。
+// 24ビットの整数はfloatで正確に表せて2のべき乗の乗算も丸めが起きないので、GPUと同じ値になる
+inline float RandomToUnitFloat(uint32_t value)
+{
+	return static_cast<float>(value >> 8) * (1.0f / 16777216.0f);
+}
+
+// IDが[firstId, firstId + count)の乱数をまとめて生成し、4つの出力をそれぞれの配列に書き込む。
+// pResults[i]がnullptrならi番目の出力は書き込まない。useAVX2がtrueでもCPUが対応していなければスカラーで生成する
+void GenerateRandomBatch(uint32_t firstId, uint32_t count, uint32_t frame, uint32_t stream, uint32_t seed, uint32_t* const pResults[4], bool useAVX2);
+
+// GenerateRandomBatch()の出力をRandomToUnitFloat()で変換したもの
+void GenerateRandomUnitFloatBatch(uint32_t firstId, uint32_t count, uint32_t frame, uint32_t stream, uint32_t seed, float* const pResults[4], bool useAVX2);
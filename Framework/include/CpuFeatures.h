@@ -0,0 +1,4 @@
+﻿#pragma once
+
+// 実行中のCPUがAVX2に対応し、OSがYMMレジスタを退避するならtrue
+bool IsAVX2Supported();
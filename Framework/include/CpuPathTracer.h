@@ -0,0 +1,137 @@
+﻿#pragma once
+
+#include <SimpleMath.h>
+#include <cstdint>
+#include <vector>
+#include "TriangleBvh.h"
+
+// マテリアルのパラメータ。意味はBRDF.hlsliのComputeBRDF()の引数と同じ
+struct PathTracerMaterial
+{
+	DirectX::SimpleMath::Vector3 BaseColor;
+	float Metallic;
+	float Roughness;
+	DirectX::SimpleMath::Vector3 Emissive;
+};
+
+// ライトのパラメータ。意味はDeferredLightingPS.hlslの定数バッファと同じ
+struct PathTracerDirectionalLight
+{
+	// 強度も含む
+	DirectX::SimpleMath::Vector3 Color;
+	DirectX::SimpleMath::Vector3 Forward;
+};
+
+struct PathTracerPointLight
+{
+	DirectX::SimpleMath::Vector3 Position;
+	float InvSqrRadius;
+	DirectX::SimpleMath::Vector3 Color;
+	float Intensity;
+};
+
+struct PathTracerSpotLight
+{
+	DirectX::SimpleMath::Vector3 Position;
+	float InvSqrRadius;
+	DirectX::SimpleMath::Vector3 Color;
+	float Intensity;
+	DirectX::SimpleMath::Vector3 Forward;
+	float AngleScale;
+	float AngleOffset;
+};
+
+struct PathTracerSettings
+{
+	// カメラからのレイを含まない反射の回数
+	uint32_t MaxBounces = 8;
+	// これより後の反射ではロシアンルーレットで打ち切る
+	uint32_t RussianRouletteBounce = 3;
+	uint32_t TileSize = 16;
+	uint32_t RandomSeed = 0;
+	// どこにも当たらなかったレイの放射輝度
+	DirectX::SimpleMath::Vector3 SkyRadiance = DirectX::SimpleMath::Vector3(0.0f, 0.0f, 0.0f);
+};
+
+// シーンのリファレンス画像を作るCPUのパストレーサ。
+// ライトはDeferredLightingPS.hlslと同じ式で評価し、シャドウマップの代わりにシャドウレイで遮蔽を調べる。
+// 間接光はComputeBRDF()を拡散と鏡面の混合分布で重点的サンプリングする。
+// RenderSample()を呼ぶたびに全ピクセルに1サンプルずつ加えて平均を取るので、呼ぶほど収束する。
+// タイルごとにParallelForで並列に描画し、乱数はピクセルとサンプル番号から決まるのでスレッド数によらず結果は同じになる
+class CpuPathTracer
+{
+public:
+	// positionsとnormalsは三角形ごとに3頂点ずつ。meshIndicesは三角形ごとのmeshMaterialsのインデックス
+	bool Init
+	(
+		const std::vector<DirectX::SimpleMath::Vector3>& positions,
+		const std::vector<DirectX::SimpleMath::Vector3>& normals,
+		const std::vector<uint32_t>& meshIndices,
+		const std::vector<PathTracerMaterial>& meshMaterials,
+		const PathTracerSettings& settings
+	);
+	void Term();
+
+	// 解像度やカメラ、ライトを変えたら蓄積をリセットする
+	void SetResolution(uint32_t width, uint32_t height);
+	// invViewProjはReverseZのプロジェクションの逆行列。NDCのz = 1をニアクリップ面として扱う
+	void SetCamera(const DirectX::SimpleMath::Vector3& position, const DirectX::SimpleMath::Matrix& invViewProj);
+	void SetLights
+	(
+		const std::vector<PathTracerDirectionalLight>& directionalLights,
+		const std::vector<PathTracerPointLight>& pointLights,
+		const std::vector<PathTracerSpotLight>& spotLights
+	);
+	void ResetAccumulation();
+
+	// 全ピクセルに1サンプルずつ加える
+	void RenderSample();
+
+	uint32_t GetWidth() const { return m_Width; }
+	uint32_t GetHeight() const { return m_Height; }
+	uint32_t GetSampleCount() const { return m_SampleCount; }
+	// 直前のRenderSample()で飛ばしたレイの数（カメラ、反射、シャドウレイの合計）と時間
+	uint64_t GetLastRayCount() const { return m_LastRayCount; }
+	double GetLastMilliseconds() const { return m_LastMilliseconds; }
+	const TriangleBvh& GetBvh() const { return m_Bvh; }
+
+	// 蓄積した平均をRGBの順に書き込む。要素数はWidth * Height * 3
+	void Resolve(std::vector<float>& pixels) const;
+	// 蓄積した平均をRadiance HDR(.hdr)で書き出す
+	bool SaveHDR(const wchar_t* path) const;
+
+private:
+	PathTracerSettings m_Settings;
+	TriangleBvh m_Bvh;
+	// Init()に渡した三角形の順に、頂点法線は3頂点ずつ、幾何法線は1つずつ
+	std::vector<DirectX::SimpleMath::Vector3> m_Normals;
+	std::vector<DirectX::SimpleMath::Vector3> m_GeometricNormals;
+	std::vector<PathTracerMaterial> m_Materials;
+
+	std::vector<PathTracerDirectionalLight> m_DirectionalLights;
+	std::vector<PathTracerPointLight> m_PointLights;
+	std::vector<PathTracerSpotLight> m_SpotLights;
+
+	DirectX::SimpleMath::Vector3 m_CameraPosition;
+	DirectX::SimpleMath::Matrix m_InvViewProj;
+
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	uint32_t m_SampleCount = 0;
+	// ピクセルごとのRGBの合計。長く蓄積しても丸め誤差が溜まらないようdoubleにする
+	std::vector<double> m_Accumulation;
+	uint64_t m_LastRayCount = 0;
+	double m_LastMilliseconds = 0.0;
+
+	// 1ピクセルの1サンプルの放射輝度を返し、飛ばしたレイの数をrayCountに加える
+	DirectX::SimpleMath::Vector3 TracePath(uint32_t pixelIdx, uint32_t x, uint32_t y, uint64_t& rayCount) const;
+	// 交点での直接光
+	DirectX::SimpleMath::Vector3 EvaluateLights
+	(
+		const PathTracerMaterial& material,
+		const DirectX::SimpleMath::Vector3& position,
+		const DirectX::SimpleMath::Vector3& N,
+		const DirectX::SimpleMath::Vector3& V,
+		uint64_t& rayCount
+	) const;
+};
@@ -3,7 +3,8 @@
 #include <d3d12.h>
 #include <atomic>
 #include "ComPtr.h"
-#include "Pool.h"
+#include "LockFreePool.h"
+#include "RingAllocator.h"
 
 class DescriptorHandle
 {
@@ -23,9 +24,12 @@ public:
 class DescriptorPool
 {
 public:
+	// q[v̖transientCountAllocHandle()ł͎g킸AAllocTransientHandles()̃Oɂ
 	static bool Create(
 		ID3D12Device* pDevice,
 		const D3D12_DESCRIPTOR_HEAP_DESC* pDesc,
+		uint32_t transientCount,
+		uint32_t maxTransientFrameCount,
 		DescriptorPool** ppPool
 	);
 
@@ -36,14 +40,26 @@ public:
 	DescriptorHandle* AllocHandle();
 	void FreeHandle(DescriptorHandle*& pHandle);
 
+	// ̃t[̊Ԃgcount̘AfBXNv^mۂA擪handleɕԂB
+	// ͕svŁAEndTransientFrame()ŋ؂t[̃tFX܂Ƃ߂ĕԋpBbNȂ
+	bool AllocTransientHandles(uint32_t count, DescriptorHandle& handle);
+	// ܂łɊmۂꎞIȃfBXNv^AfenceValuẽtFXԋpt[Ƃċ؂
+	bool EndTransientFrame(uint64_t fenceValue);
+	void RetireTransientFrames(uint64_t completedFenceValue);
+	const RingAllocatorFrameStats& GetLastTransientFrameStats() const;
+	uint64_t GetTransientHighWaterMark() const;
+
 	uint32_t GetAvailableHandleCount() const;
 	uint32_t GetAllocatedHandleCount() const;
 	uint32_t GetHandleCount() const;
+	uint32_t GetDescriptorSize() const;
 	ID3D12DescriptorHeap* const GetHeap() const;
 
 private:
 	std::atomic<uint32_t> m_RefCount;
-	Pool<DescriptorHandle> m_Pool;
+	LockFreePool<DescriptorHandle> m_Pool;
+	// q[v̒ŁAm_PooľɂꎞIȃfBXNv^͈̔
+	RingAllocator m_TransientRing;
 	ComPtr<ID3D12DescriptorHeap> m_pHeap;
 	uint32_t m_DescriptorSize;
 	bool m_IsShaderVisible;
@@ -17,6 +17,16 @@ public:
 
 	void Sync(ID3D12CommandQueue* pQueue);
 
+	// ̒lVOiA̒lԂB҂ȂBs0
+	UINT64 Signal(ID3D12CommandQueue* pQueue);
+
+	// Signal()ŕԂl܂ő҂
+	void WaitForValue(UINT64 fenceValue, UINT timeout);
+
+	UINT64 GetNextValue() const;
+
+	UINT64 GetCompletedValue() const;
+
 private:
 	ComPtr<ID3D12Fence> m_pFence;
 	HANDLE m_Event;
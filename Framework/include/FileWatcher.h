@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ファイルの更新時刻をポーリングして、変わったファイルを返す。
+// 保存するときに一度消してから書き直すエディタもあるので、消えている間は知らせず、
+// 前と違う時刻で現れたときに変わったものとして知らせる。スレッドセーフではない
+class FileWatcher
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	// 今の更新時刻を覚える。同じパスを2回渡しても1つとして扱う
+	void Watch(const std::wstring& path);
+	void Clear();
+
+	// 前のWatch()かPoll()から更新時刻が変わったファイルをchangedFilesにパスの順で入れる
+	void Poll(std::vector<std::wstring>& changedFiles);
+
+	uint32_t GetFileCount() const { return static_cast<uint32_t>(m_Files.size()); }
+
+private:
+	struct Entry
+	{
+		bool Exists = false;
+		std::filesystem::file_time_type WriteTime;
+	};
+
+	std::unordered_map<std::wstring, Entry> m_Files;
+
+	FileWatcher(const FileWatcher&) = delete;
+	void operator=(const FileWatcher&) = delete;
+};
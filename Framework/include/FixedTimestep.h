@@ -0,0 +1,33 @@
+﻿#pragma once
+
+#include <cstdint>
+
+// 可変のフレームの経過時間を、固定の刻みのステップ数に変換するアキュムレータ。
+// シミュレーションをフレームレートによらず同じ刻みで進め、描画はGetAlpha()で直前のステップとの間を補間する。
+// Glenn Fiedler, "Fix Your Timestep!"を参考にしている
+class FixedTimestep
+{
+public:
+	// 1フレームのステップ数がmaxStepsPerFrameを超える分の時間は捨てる。
+	// 処理が追いつかないときにステップ数が増え続けて、さらに遅くなるのを防ぐ
+	void Init(double stepTime, uint32_t maxStepsPerFrame);
+	// 溜まった時間を捨てる。ステップの総数はそのまま
+	void Reset();
+
+	// 経過時間を加えて、このフレームで進めるステップ数を返す
+	uint32_t Advance(double elapsedTime);
+
+	double GetStepTime() const { return m_StepTime; }
+	// 最後のステップから次のステップまでの経過の割合。[0, 1)
+	float GetAlpha() const { return static_cast<float>(m_Accumulator / m_StepTime); }
+	uint64_t GetTotalStepCount() const { return m_TotalStepCount; }
+	// 追いつかずに捨てた時間の合計
+	double GetDroppedTime() const { return m_DroppedTime; }
+
+private:
+	double m_StepTime = 1.0 / 60.0;
+	uint32_t m_MaxStepsPerFrame = 1;
+	double m_Accumulator = 0.0;
+	uint64_t m_TotalStepCount = 0;
+	double m_DroppedTime = 0.0;
+};
@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+struct FramePacerStats
+{
+	// EndFrame()したフレームの数
+	uint32_t FrameCount = 0;
+	// BeginFrame()でGPUの完了を待ったフレームの数
+	uint32_t WaitCount = 0;
+};
+
+// フレームごとに使い回す資源(コマンドアロケータ、フレームごとの定数バッファ、バックバッファ)のリングについて、
+// それぞれを最後に使ったフレームのコマンドの完了でシグナルされるフェンスの値を覚えておく。
+// 記録を始めるフレームの資源を最後に使ったフレームだけを待てばいいので、CPUはGPUより最大でframeCount - 1フレーム先に進める。
+// フェンスの値だけを扱い、待ち方は呼び出し側が渡すので、デバイスがなくてもキューのシミュレーションで動く。スレッドセーフではない
+class FramePacer
+{
+public:
+	FramePacer();
+	~FramePacer();
+
+	bool Init(uint32_t frameCount);
+	void Term();
+
+	// frameIndexのフレームの記録を始める前に呼ぶ。そのフレームの資源を最後に使ったフレームのフェンスの値が
+	// completedFenceValueより大きければ、wait(uint64_t fenceValue)でその値の完了を待つ。待ったらtrueを返す
+	template<typename WaitFunc>
+	bool BeginFrame(uint32_t frameIndex, uint64_t completedFenceValue, WaitFunc&& wait)
+	{
+		assert(frameIndex < m_FenceValues.size());
+
+		uint64_t fenceValue = m_FenceValues[frameIndex];
+		if (fenceValue <= completedFenceValue)
+		{
+			return false;
+		}
+
+		wait(fenceValue);
+		m_Stats.WaitCount++;
+		return true;
+	}
+
+	// frameIndexのフレームのコマンドを全て実行したらfenceValueがシグナルされる。fenceValueは前のフレームより大きくする
+	void EndFrame(uint32_t frameIndex, uint64_t fenceValue);
+
+	// GPUの完了を全て待ってから呼ぶ。覚えているフェンスの値を忘れ、次のBeginFrame()では待たない
+	void Reset();
+
+	uint32_t GetFrameCount() const { return static_cast<uint32_t>(m_FenceValues.size()); }
+	// EndFrame()したフレームのうち、completedFenceValueの時点でGPUが終えていないものの数
+	uint32_t GetFramesInFlight(uint64_t completedFenceValue) const;
+	const FramePacerStats& GetStats() const { return m_Stats; }
+
+private:
+	// フレームのインデックスごとに、最後に使ったフレームのフェンスの値。使っていなければ0
+	std::vector<uint64_t> m_FenceValues;
+	uint64_t m_LastFenceValue;
+	FramePacerStats m_Stats;
+
+	FramePacer(const FramePacer&) = delete;
+	void operator=(const FramePacer&) = delete;
+};
@@ -0,0 +1,94 @@
+﻿#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct JobGraphStats
+{
+	uint32_t JobCount = 0;
+	uint32_t WorkerCount = 0;
+	// Run()の開始から全てのジョブを終えるまで
+	double TotalMilliseconds = 0.0;
+	// ジョブの時間の合計。1つのスレッドで順に実行したときにかかる時間になる
+	double SerialMilliseconds = 0.0;
+	// 依存を辿った鎖のうち、ジョブの時間の合計が最も長いもの。ワーカーをいくら増やしてもこれより速くはならない
+	double CriticalPathMilliseconds = 0.0;
+};
+
+// Run()で実行したジョブの時刻。時刻はRun()の開始から
+struct JobTimelineEntry
+{
+	uint32_t WorkerIndex = 0;
+	double StartMilliseconds = 0.0;
+	double EndMilliseconds = 0.0;
+	// クリティカルパスの上にあるか
+	bool IsCritical = false;
+};
+
+// 依存関係のあるジョブを、依存するジョブを全て終えたものから順にワーカーで並列に実行する。
+// 起動時のシェーダのコンパイルとパイプラインステートの生成のように、1回だけ実行する処理をまとめて流すためのもの。
+// ワーカーはParallelFor()のスレッドで動かすので、ParallelFor()の中から呼ぶと呼び出しスレッドで順に実行する。
+// ジョブの登録とRun()はスレッドセーフではない
+class JobGraph
+{
+public:
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	JobGraph();
+	~JobGraph();
+
+	void Clear();
+
+	// dependenciesはこれより前にAddJob()したジョブのインデックス。funcにはジョブを実行するワーカーのインデックスが渡される。
+	// ワーカーごとに持つもの(DXCのコンパイラなど)はそのインデックスで選ぶ。funcがfalseを返すと、まだ始めていないジョブは実行しない
+	uint32_t AddJob(const char* name, const std::vector<uint32_t>& dependencies, std::function<bool(uint32_t workerIndex)> func);
+
+	// workerCount個のワーカーで全てのジョブを実行し、終わるまで待つ。失敗したジョブがあればfalseを返す
+	bool Run(uint32_t workerCount);
+
+	uint32_t GetJobCount() const { return static_cast<uint32_t>(m_Jobs.size()); }
+	const char* GetJobName(uint32_t jobIdx) const { return m_Jobs[jobIdx].Name.c_str(); }
+	// AddJob()の順。実行しなかったジョブは時刻が0のまま
+	const std::vector<JobTimelineEntry>& GetTimeline() const { return m_Timeline; }
+	const JobGraphStats& GetStats() const { return m_Stats; }
+
+	// 始めた順にジョブの時刻をログに出す。クリティカルパスの上にあるものには*を付ける
+	void LogTimeline() const;
+
+private:
+	struct Job
+	{
+		std::string Name;
+		std::vector<uint32_t> Dependencies;
+		std::vector<uint32_t> Dependents;
+		std::function<bool(uint32_t)> Func;
+	};
+
+	std::vector<Job> m_Jobs;
+	std::vector<JobTimelineEntry> m_Timeline;
+	JobGraphStats m_Stats;
+	// AddJob()に不正な依存が渡された
+	bool m_HasInvalidJob;
+
+	// 以下はRun()の間だけ使う
+	std::mutex m_Mutex;
+	std::condition_variable m_ReadyCV;
+	// 実行できるようになったジョブ。m_ReadyHeadより前は取り出し済み
+	std::vector<uint32_t> m_ReadyJobs;
+	uint32_t m_ReadyHead;
+	std::vector<uint32_t> m_RemainingDependencyCounts;
+	uint32_t m_FinishedJobCount;
+	bool m_IsFailed;
+	std::chrono::steady_clock::time_point m_StartTime;
+
+	void RunWorker(uint32_t workerIndex);
+	void FindCriticalPath();
+
+	JobGraph(const JobGraph&) = delete;
+	void operator=(const JobGraph&) = delete;
+};
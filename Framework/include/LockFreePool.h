@@ -0,0 +1,341 @@
+﻿#pragma once
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+// LockFreePoolのマガジンの要素数の上限
+static constexpr uint32_t LOCK_FREE_POOL_MAX_MAGAZINE_SIZE = 32;
+
+// Poolと同じAPIとインデックスを持つロックフリーのプール。
+// 空きはインデックスで繋いだスタックで持ち、先頭のインデックスに更新のたびに増えるタグを付けて
+// 1回の64bitのCASで取り外し、付け替えるので、ABA問題が起きない。
+// magazineSizeが0でなければスレッド番号で選んだマガジンにも同じ形のスタックで空きを貯める。
+// マガジンが空になったら(magazineSize + 1) / 2個を1回のCASで共有のスタックからまとめて取り、
+// magazineSize個までは解放したものを入れるので、共有のスタックへのCASの回数が減る。
+// マガジンも他のスレッドからCASで取り出せるので、どの操作もロックを取らない。
+// Alloc()は先に使用数を予約し、予約できたのに共有のスタックと自分のマガジンが空のときだけ、他のマガジンから取る。
+// まとめて取って自分のマガジンに移す途中の空きも使用数に予約しておくので、予約できれば空きはどこかのスタックに必ずあり、
+// 取り損ねるのは他のスレッドが確保か解放を進めたときだけになる
+template<typename T>
+class LockFreePool
+{
+public:
+	LockFreePool()
+	: m_pValues(nullptr)
+	, m_pNextIndices(nullptr)
+	, m_pMagazines(nullptr)
+	, m_Capacity(0)
+	, m_MagazineSize(0)
+	, m_Head(EMPTY_HEAD)
+	, m_Count(0)
+	{
+	}
+
+	~LockFreePool()
+	{
+		Term();
+	}
+
+	// magazineSizeはLOCK_FREE_POOL_MAX_MAGAZINE_SIZE以下。0ならマガジンを使わず、Pool::Init(count)と同じに使える。
+	// マガジンに残った空きは他のスレッドからも最後に探すので、Alloc()が失敗するのは本当に空きがないときだけ
+	bool Init(uint32_t count, uint32_t magazineSize = 0)
+	{
+		Term();
+
+		if (count == 0 || count == INVALID_INDEX || magazineSize > LOCK_FREE_POOL_MAX_MAGAZINE_SIZE)
+		{
+			return false;
+		}
+
+		m_pValues = static_cast<T*>(malloc(sizeof(T) * count));
+		m_pNextIndices = static_cast<std::atomic<uint32_t>*>(malloc(sizeof(std::atomic<uint32_t>) * count));
+		if (m_pValues == nullptr || m_pNextIndices == nullptr)
+		{
+			Term();
+			return false;
+		}
+
+		if (magazineSize > 0)
+		{
+			m_pMagazines = new (std::nothrow) Magazine[MAGAZINE_COUNT];
+			if (m_pMagazines == nullptr)
+			{
+				Term();
+				return false;
+			}
+		}
+
+		m_Capacity = count;
+		m_MagazineSize = magazineSize;
+
+		// 最初はインデックスの小さい順に取り出されるようにつなぐ
+		for (uint32_t i = 0; i < m_Capacity; i++)
+		{
+			new (&m_pNextIndices[i]) std::atomic<uint32_t>((i + 1 < m_Capacity) ? i + 1 : INVALID_INDEX);
+		}
+
+		m_Head.store(0, std::memory_order_release);
+		m_Count.store(0, std::memory_order_release);
+
+		return true;
+	}
+
+	void Term()
+	{
+		if (m_pValues != nullptr)
+		{
+			free(m_pValues);
+			m_pValues = nullptr;
+		}
+
+		if (m_pNextIndices != nullptr)
+		{
+			free(m_pNextIndices);
+			m_pNextIndices = nullptr;
+		}
+
+		if (m_pMagazines != nullptr)
+		{
+			delete[] m_pMagazines;
+			m_pMagazines = nullptr;
+		}
+
+		m_Capacity = 0;
+		m_MagazineSize = 0;
+		m_Head.store(EMPTY_HEAD, std::memory_order_release);
+		m_Count.store(0, std::memory_order_release);
+	}
+
+	T* Alloc()
+	{
+		return Alloc([](uint32_t, T*) {});
+	}
+
+	// funcはfunc(uint32_t index, T* pValue)の形で呼べるもの。構築した直後に呼ぶ
+	template<typename Func>
+	T* Alloc(Func&& func)
+	{
+		// 先に使用数を予約する。予約できれば、空きは共有のスタックかどこかのマガジンに必ずある
+		if (Reserve(1) == 0)
+		{
+			return nullptr;
+		}
+
+		uint32_t index = INVALID_INDEX;
+
+		if (m_pMagazines != nullptr)
+		{
+			Magazine& magazine = m_pMagazines[GetThreadIndex() % MAGAZINE_COUNT];
+			if (PopBatch(magazine.Head, &index, 1) > 0)
+			{
+				magazine.Count.fetch_sub(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				// 自分の分に加えて、マガジンに移す分も予約してからまとめて取る
+				uint32_t extraCount = Reserve(GetRefillCount() - 1);
+				uint32_t indices[LOCK_FREE_POOL_MAX_MAGAZINE_SIZE];
+				uint32_t count = PopBatch(m_Head, indices, 1 + extraCount);
+				if (count > 0)
+				{
+					index = indices[0];
+					PushBatch(magazine.Head, indices + 1, count - 1);
+					magazine.Count.fetch_add(static_cast<int32_t>(count - 1), std::memory_order_relaxed);
+				}
+				m_Count.fetch_sub(extraCount, std::memory_order_release);
+			}
+		}
+
+		// 共有のスタックが空でも、他のスレッドのマガジンに空きが残っていることがある。
+		// 予約した数だけの空きはどこかのスタックにあるので、見落とすのは探している間に他のスレッドが取るか戻したときだけ
+		while (index == INVALID_INDEX)
+		{
+			if (PopBatch(m_Head, &index, 1) > 0)
+			{
+				break;
+			}
+
+			for (uint32_t i = 0; m_pMagazines != nullptr && i < MAGAZINE_COUNT; i++)
+			{
+				if (PopBatch(m_pMagazines[i].Head, &index, 1) > 0)
+				{
+					m_pMagazines[i].Count.fetch_sub(1, std::memory_order_relaxed);
+					break;
+				}
+			}
+		}
+
+		T* val = new ((void*)&m_pValues[index]) T();
+
+		assert(index < m_Capacity);
+		func(index, val);
+
+		return val;
+	}
+
+	void Free(T* pValue)
+	{
+		if (pValue == nullptr)
+		{
+			return;
+		}
+
+		uint32_t index = static_cast<uint32_t>(pValue - m_pValues);
+		assert(index < m_Capacity);
+
+		// 空きをスタックに入れてから使用数を減らすので、予約できたAlloc()から見えない空きはない。
+		// マガジンが一杯なら、移す途中の空きを作らないように解放したものだけを共有のスタックに戻す
+		Magazine* pMagazine = (m_pMagazines != nullptr) ? &m_pMagazines[GetThreadIndex() % MAGAZINE_COUNT] : nullptr;
+		if (pMagazine != nullptr && pMagazine->Count.load(std::memory_order_relaxed) < static_cast<int32_t>(m_MagazineSize))
+		{
+			PushBatch(pMagazine->Head, &index, 1);
+			pMagazine->Count.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			PushBatch(m_Head, &index, 1);
+		}
+
+		m_Count.fetch_sub(1, std::memory_order_release);
+	}
+
+	uint32_t GetSize() const
+	{
+		return m_Capacity;
+	}
+
+	uint32_t GetUsedCount() const
+	{
+		return m_Count.load(std::memory_order_relaxed);
+	}
+
+	uint32_t GetAvailableCount() const
+	{
+		return m_Capacity - GetUsedCount();
+	}
+
+private:
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+	// 上位32bitがタグ、下位32bitが先頭のインデックス
+	static constexpr uint64_t EMPTY_HEAD = INVALID_INDEX;
+	// スレッド番号をこの数で割った余りでマガジンを選ぶ。32スレッドまでは衝突しない
+	static constexpr uint32_t MAGAZINE_COUNT = 64;
+
+	// 共有のスタックと同じ形のスタック。同じマガジンを選んだスレッドどうしや、空きを探す他のスレッドも同時に触る
+	struct alignas(64) Magazine
+	{
+		std::atomic<uint64_t> Head = EMPTY_HEAD;
+		// 入れてから足し、取り出してから引くので、途中では実際の数とずれたり負になったりする。溢れるかの目安にだけ使う
+		std::atomic<int32_t> Count = 0;
+	};
+
+	T* m_pValues;
+	// 空きのスタックで次の空きのインデックス。最後はINVALID_INDEX
+	std::atomic<uint32_t>* m_pNextIndices;
+	Magazine* m_pMagazines;
+	uint32_t m_Capacity;
+	uint32_t m_MagazineSize;
+	alignas(64) std::atomic<uint64_t> m_Head;
+	alignas(64) std::atomic<uint32_t> m_Count;
+
+	static uint64_t MakeHead(uint64_t tag, uint32_t index)
+	{
+		return (tag << 32) | index;
+	}
+
+	uint32_t GetRefillCount() const
+	{
+		return (m_MagazineSize + 1) / 2;
+	}
+
+	// 使用数をm_Capacityを超えない範囲で最大maxCountだけ増やし、増やした数を返す
+	uint32_t Reserve(uint32_t maxCount)
+	{
+		uint32_t count = m_Count.load(std::memory_order_relaxed);
+		while (true)
+		{
+			uint32_t reserveCount = (count < m_Capacity) ? std::min(maxCount, m_Capacity - count) : 0;
+			if (reserveCount == 0)
+			{
+				return 0;
+			}
+
+			if (m_Count.compare_exchange_weak(count, count + reserveCount, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				return reserveCount;
+			}
+		}
+	}
+
+	// スタックの先頭から最大maxCount個を1回のCASで取り出し、取り出した数を返す
+	uint32_t PopBatch(std::atomic<uint64_t>& stackHead, uint32_t* pIndices, uint32_t maxCount)
+	{
+		uint64_t head = stackHead.load(std::memory_order_acquire);
+		while (true)
+		{
+			uint32_t index = static_cast<uint32_t>(head);
+			uint32_t count = 0;
+			// 途中で他のスレッドが先頭を変えていると辿った値は正しくないが、そのときはタグが変わってCASが失敗する
+			while (index != INVALID_INDEX && count < maxCount)
+			{
+				pIndices[count++] = index;
+				index = m_pNextIndices[index].load(std::memory_order_relaxed);
+				if (index >= m_Capacity)
+				{
+					index = INVALID_INDEX;
+				}
+			}
+
+			if (count == 0)
+			{
+				return 0;
+			}
+
+			uint64_t newHead = MakeHead((head >> 32) + 1, index);
+			if (stackHead.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire))
+			{
+				return count;
+			}
+		}
+	}
+
+	// count個を互いにつないでから、1回のCASでスタックの先頭に付ける
+	void PushBatch(std::atomic<uint64_t>& stackHead, const uint32_t* pIndices, uint32_t count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		for (uint32_t i = 0; i + 1 < count; i++)
+		{
+			m_pNextIndices[pIndices[i]].store(pIndices[i + 1], std::memory_order_relaxed);
+		}
+
+		uint32_t last = pIndices[count - 1];
+		uint64_t head = stackHead.load(std::memory_order_relaxed);
+		while (true)
+		{
+			m_pNextIndices[last].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+			uint64_t newHead = MakeHead((head >> 32) + 1, pIndices[0]);
+			if (stackHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed))
+			{
+				return;
+			}
+		}
+	}
+
+	// スレッドごとに一意な番号
+	static uint32_t GetThreadIndex()
+	{
+		static std::atomic<uint32_t> s_ThreadCount = 0;
+		thread_local uint32_t t_ThreadIndex = s_ThreadCount.fetch_add(1, std::memory_order_relaxed);
+		return t_ThreadIndex;
+	}
+
+	LockFreePool(const LockFreePool&) = delete;
+	void operator=(const LockFreePool&) = delete;
+};
@@ -1,8 +1,389 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ȌdvxBLOG_MIN_SEVERITYႢ̂̃}N͉WJȂ̂ŁA]Ȃ
+#define LOG_SEVERITY_DEBUG 0
+#define LOG_SEVERITY_INFO 1
+#define LOG_SEVERITY_WARNING 2
+#define LOG_SEVERITY_ERROR 3
+
+#ifndef LOG_MIN_SEVERITY
+#if defined(DEBUG) || defined(_DEBUG)
+#define LOG_MIN_SEVERITY LOG_SEVERITY_DEBUG
+#else
+#define LOG_MIN_SEVERITY LOG_SEVERITY_INFO
+#endif
+#endif
+
+// ĂяoXbhŃtH[}bgāAR\[VisualStudiȍo̓EBhEɏo
 void OutputLog(const char* format, ...);
 
-#ifndef ELOG
-#define ELOG(x, ...) OutputLog("[File : %s, Line : %d]" x "\n", __FILE__, __LINE__, ##__VA_ARGS__)
+struct LogStats
+{
+	// obZ[W̐
+	uint64_t WrittenCount = 0;
+	// L[tŎ̂ĂbZ[W̐
+	uint64_t DroppedCount = 0;
+	// ̈q[vɂuArŐ؂bZ[W̐
+	uint64_t TruncatedCount = 0;
+};
+
+// 1̃R[hɓ̑傫B͎̈cɓAȂ΃q[vɃRs[
+static constexpr uint32_t LOG_RECORD_PAYLOAD_SIZE = 448;
+// Ō1́AȂƂ̋󕶎Ƃċ󂯂Ă
+static constexpr uint32_t LOG_RECORD_STRING_END = LOG_RECORD_PAYLOAD_SIZE - sizeof(wchar_t);
+
+// AsyncLogger̃R[hɈl߂āAoXbhŎo߂̂
+namespace LogDetail
+{
+	// WriteArgs()̌
+	static constexpr uint32_t ARG_FLAG_TRUNCATED = 0x1;
+	static constexpr uint32_t ARG_FLAG_HEAP = 0x2;
+
+	// ̃ItZbgɂꂪĂAɂ̓q[vɃRs[̃|C^
+	static constexpr uint32_t HEAP_STRING_FLAG = 0x80000000;
+
+	// ̔zconst̕tĂȂ|C^́Aconst̕t|C^ƂĈ
+	template<typename T>
+	using ArgType = std::conditional_t<std::is_same_v<std::decay_t<T>, char*>, const char*,
+		std::conditional_t<std::is_same_v<std::decay_t<T>, wchar_t*>, const wchar_t*, std::decay_t<T>>>;
+
+	template<typename T>
+	constexpr bool IS_STRING_ARG = std::is_same_v<T, const char*> || std::is_same_v<T, const wchar_t*>;
+
+	// Payloaďɒug̃ItZbgAȊO͒l̂܂ܓ
+	template<typename T>
+	using StoredArg = std::conditional_t<IS_STRING_ARG<T>, uint32_t, T>;
+
+	// ɁAꂼ̃ACgɂ낦ĒuƂ̃ItZbgBŌ̗vf͑Ŝ̑傫
+	template<typename... Args>
+	constexpr std::array<size_t, sizeof...(Args) + 1> ComputeArgOffsets()
+	{
+		constexpr size_t sizes[] = {sizeof(StoredArg<Args>)..., 0};
+		constexpr size_t alignments[] = {alignof(StoredArg<Args>)..., 1};
+		std::array<size_t, sizeof...(Args) + 1> offsets = {};
+		size_t offset = 0;
+		for (size_t i = 0; i < sizeof...(Args); i++)
+		{
+			offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+			offsets[i] = offset;
+			offset += sizes[i];
+		}
+		offsets[sizeof...(Args)] = offset;
+		return offsets;
+	}
+
+	template<typename... Args>
+	struct ArgLayout
+	{
+		static constexpr std::array<size_t, sizeof...(Args) + 1> OFFSETS = ComputeArgOffsets<Args...>();
+		// ̒g͂ɒu
+		static constexpr size_t FIXED_SIZE = OFFSETS[sizeof...(Args)];
+	};
+
+	inline size_t AlignOffset(size_t offset, size_t alignment)
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+	template<typename CharType>
+	uint32_t WriteString(uint8_t* pPayload, const CharType* value, uint32_t& offset, size_t& stringOffset)
+	{
+		static constexpr CharType NULL_STRING[] = {'(', 'n', 'u', 'l', 'l', ')', '\0'};
+		if (value == nullptr)
+		{
+			value = NULL_STRING;
+		}
+
+		size_t length = std::char_traits<CharType>::length(value);
+		size_t inlineOffset = AlignOffset(stringOffset, alignof(CharType));
+		if (inlineOffset + (length + 1) * sizeof(CharType) <= LOG_RECORD_STRING_END)
+		{
+			offset = static_cast<uint32_t>(inlineOffset);
+			memcpy(pPayload + inlineOffset, value, (length + 1) * sizeof(CharType));
+			stringOffset = inlineOffset + (length + 1) * sizeof(CharType);
+			return 0;
+		}
+
+		// VF[_̃RpCG[̂悤Ȓ̂AĂяoŃq[vɃRs[BoXbh
+		size_t pointerOffset = AlignOffset(stringOffset, alignof(CharType*));
+		if (pointerOffset + sizeof(CharType*) <= LOG_RECORD_STRING_END)
+		{
+			CharType* pCopy = static_cast<CharType*>(malloc((length + 1) * sizeof(CharType)));
+			if (pCopy != nullptr)
+			{
+				memcpy(pCopy, value, (length + 1) * sizeof(CharType));
+				memcpy(pPayload + pointerOffset, &pCopy, sizeof(pCopy));
+				offset = static_cast<uint32_t>(pointerOffset) | HEAP_STRING_FLAG;
+				stringOffset = pointerOffset + sizeof(CharType*);
+				return ARG_FLAG_HEAP;
+			}
+		}
+
+		// mۂłȂΓ镪
+		size_t capacity = (inlineOffset < LOG_RECORD_STRING_END) ? (LOG_RECORD_STRING_END - inlineOffset) / sizeof(CharType) : 0;
+		if (capacity == 0)
+		{
+			offset = LOG_RECORD_STRING_END;
+			memset(pPayload + offset, 0, sizeof(wchar_t));
+			return ARG_FLAG_TRUNCATED;
+		}
+
+		offset = static_cast<uint32_t>(inlineOffset);
+		memcpy(pPayload + inlineOffset, value, (capacity - 1) * sizeof(CharType));
+		reinterpret_cast<CharType*>(pPayload + inlineOffset)[capacity - 1] = 0;
+		stringOffset = inlineOffset + capacity * sizeof(CharType);
+		return ARG_FLAG_TRUNCATED;
+	}
+
+	template<typename T>
+	uint32_t WriteArg(uint8_t* pPayload, size_t argOffset, const T& value, size_t& stringOffset)
+	{
+		if constexpr (IS_STRING_ARG<ArgType<T>>)
+		{
+			uint32_t offset;
+			uint32_t flags = WriteString(pPayload, static_cast<ArgType<T>>(value), offset, stringOffset);
+			memcpy(pPayload + argOffset, &offset, sizeof(offset));
+			return flags;
+		}
+		else
+		{
+			static_assert(std::is_trivially_copyable_v<ArgType<T>>, "Log arguments must be trivially copyable.");
+			memcpy(pPayload + argOffset, &value, sizeof(value));
+			return 0;
+		}
+	}
+
+	// ARG_FLAG_*Ԃ
+	template<typename... Args, size_t... I>
+	uint32_t WriteArgs([[maybe_unused]] uint8_t* pPayload, std::index_sequence<I...>, const Args&... args)
+	{
+		using Layout = ArgLayout<ArgType<Args>...>;
+		[[maybe_unused]] size_t stringOffset = Layout::FIXED_SIZE;
+		uint32_t flags = 0;
+		((flags |= WriteArg(pPayload, Layout::OFFSETS[I], args, stringOffset)), ...);
+		return flags;
+	}
+
+	template<typename T>
+	auto ReadArg(const uint8_t* pPayload, size_t argOffset)
+	{
+		StoredArg<T> value;
+		memcpy(&value, pPayload + argOffset, sizeof(value));
+		if constexpr (IS_STRING_ARG<T>)
+		{
+			using CharType = std::remove_cv_t<std::remove_pointer_t<T>>;
+			const CharType* pString = reinterpret_cast<const CharType*>(pPayload + (value & ~HEAP_STRING_FLAG));
+			if ((value & HEAP_STRING_FLAG) != 0)
+			{
+				memcpy(&pString, pPayload + (value & ~HEAP_STRING_FLAG), sizeof(pString));
+			}
+			return pString;
+		}
+		else
+		{
+			return value;
+		}
+	}
+
+	template<typename T>
+	void ReleaseArg(const uint8_t* pPayload, size_t argOffset)
+	{
+		if constexpr (IS_STRING_ARG<T>)
+		{
+			uint32_t offset;
+			memcpy(&offset, pPayload + argOffset, sizeof(offset));
+			if ((offset & HEAP_STRING_FLAG) != 0)
+			{
+				free(const_cast<void*>(static_cast<const void*>(ReadArg<T>(pPayload, argOffset))));
+			}
+		}
+	}
+
+	template<typename... Args, size_t... I>
+	int FormatArgs(char* buffer, size_t size, const char* format, [[maybe_unused]] const uint8_t* pPayload, std::index_sequence<I...>)
+	{
+		using Layout = ArgLayout<Args...>;
+		return snprintf(buffer, size, format, ReadArg<Args>(pPayload, Layout::OFFSETS[I])...);
+	}
+
+	template<typename... Args>
+	int FormatRecordArgs(char* buffer, size_t size, const char* format, const uint8_t* pPayload)
+	{
+		return FormatArgs<Args...>(buffer, size, format, pPayload, std::index_sequence_for<Args...>());
+	}
+
+	template<typename... Args, size_t... I>
+	void ReleaseArgs([[maybe_unused]] const uint8_t* pPayload, std::index_sequence<I...>)
+	{
+		using Layout = ArgLayout<Args...>;
+		(ReleaseArg<Args>(pPayload, Layout::OFFSETS[I]), ...);
+	}
+
+	template<typename... Args>
+	void ReleaseRecordArgs(const uint8_t* pPayload)
+	{
+		ReleaseArgs<Args...>(pPayload, std::index_sequence_for<Args...>());
+	}
+}
+
+// Ăяoł̓tH[}bgɁAtH[}bg̃|C^A̒lAŒ蒷̃R[h̃Oɐς݁A
+// ʃXbhł܂Ƃ߂ătH[}bgďoK[B
+// O͊eXbgɏݍς݂̎\ԍLẼL[ŁAރXbg̊mۂ1CASȂ̂ŁA
+// ̃Xbh瓯Write()ĂbNȂBt̂Ƃ͑҂Ɏ̂ĂĐB
+// tH[}bg͕񃊃ê悤ɏo܂ŎĉnB̈͒gR[hɃRs[̂ŁA
+// ꎞIuWFNgc_str()nĂ
+class AsyncLogger
+{
+public:
+	// oeLXgB̃bZ[W܂Ƃ߂ēnBtext̓kI[Ă
+	using Sink = std::function<void(const char* text, size_t length)>;
+
+	AsyncLogger();
+	~AsyncLogger();
+
+	// capacity̓R[h̐2ׂ̂
+	bool Init(uint32_t capacity, Sink sink);
+	// ςł̂SďoĂXbh~߂B~߂Write()͌ĂяoXbhŏoB
+	// Write()ĂXbh΁AꂪXbgI܂ő҂Ă烊O
+	void Term();
+
+	template<typename... Args>
+	void Write(uint32_t severity, const char* file, uint32_t line, const char* format, const Args&... args)
+	{
+		using Layout = LogDetail::ArgLayout<LogDetail::ArgType<Args>...>;
+		static_assert(Layout::FIXED_SIZE <= LOG_RECORD_STRING_END, "Too many log arguments.");
+
+		uint64_t position;
+		Record* pRecord = BeginRecord(position);
+		if (pRecord == nullptr)
+		{
+			return;
+		}
+
+		pRecord->Timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+		pRecord->File = file;
+		pRecord->Line = line;
+		pRecord->Severity = severity;
+		pRecord->Format = format;
+		pRecord->pFormatFunc = &LogDetail::FormatRecordArgs<LogDetail::ArgType<Args>...>;
+		pRecord->ArgFlags = LogDetail::WriteArgs(pRecord->Payload, std::index_sequence_for<Args...>(), args...);
+		pRecord->pReleaseFunc = ((pRecord->ArgFlags & LogDetail::ARG_FLAG_HEAP) != 0) ? &LogDetail::ReleaseRecordArgs<LogDetail::ArgType<Args>...> : nullptr;
+
+		EndRecord(pRecord, position);
+	}
+
+	// ĂԑOWrite()̂Sďo܂ő҂BTerm()n܂ĂΑ҂ɖ߂
+	void Flush();
+
+	LogStats GetStats() const;
+
+private:
+	using FormatFunc = int (*)(char* buffer, size_t size, const char* format, const uint8_t* pPayload);
+	using ReleaseFunc = void (*)(const uint8_t* pPayload);
+
+	struct Record
+	{
+		// std::chrono::steady_clock̒l
+		int64_t Timestamp;
+		const char* File;
+		uint32_t Line;
+		uint32_t Severity;
+		const char* Format;
+		// ̌^ƂɍAPayloadoătH[}bg֐
+		FormatFunc pFormatFunc;
+		// q[vɃRs[񂪂΁Aoɂ֐
+		ReleaseFunc pReleaseFunc;
+		// LogDetail::ARG_FLAG_*
+		uint32_t ArgFlags;
+		alignas(8) uint8_t Payload[LOG_RECORD_PAYLOAD_SIZE];
+	};
+
+	struct alignas(64) Slot
+	{
+		// positioñR[h߂ƂpositionAݏIposition + 1
+		std::atomic<uint64_t> Sequence;
+		Record Data;
+	};
+
+	Slot* m_pSlots;
+	uint32_t m_Capacity;
+	Sink m_Sink;
+	std::chrono::steady_clock::time_point m_StartTime;
+	std::thread m_Thread;
+	std::atomic<bool> m_IsRunning;
+	// m_IsRunningOɑAXbgIBTerm()͂ꂪ0ɂȂ܂ŃOȂ
+	std::atomic<uint32_t> m_WriterCount;
+
+	// ޑƏoXbhŕʂ̃LbVCɒu
+	alignas(64) std::atomic<uint64_t> m_EnqueuePosition;
+	alignas(64) std::atomic<uint64_t> m_DequeuePosition;
+	std::atomic<uint64_t> m_WrittenCount;
+	alignas(64) std::atomic<uint64_t> m_DroppedCount;
+	std::atomic<uint64_t> m_TruncatedCount;
+
+	// oXbhQĂƂWrite()N
+	std::atomic<bool> m_IsSleeping;
+	std::mutex m_Mutex;
+	std::condition_variable m_WakeCV;
+	std::condition_variable m_FlushedCV;
+	bool m_IsTerminating;
+	// Term()̌Write()ɏoȂ悤ɂ
+	std::mutex m_SyncMutex;
+	std::vector<char> m_SyncText;
+
+	// mۂXbg̃R[hԂBtȂnullptrBTerm()̌̓XbhƂ̃R[hԂApositionUINT64_MAXɂB
+	// XbgԂƂEndRecord()܂m_WriterCount𑫂܂܂ɂ
+	Record* BeginRecord(uint64_t& position);
+	void EndRecord(Record* pRecord, uint64_t position);
+	// At@CAstătH[}bgAtexťɑ
+	void FormatRecord(const Record& record, std::vector<char>& text);
+	void Run();
+
+	AsyncLogger(const AsyncLogger&) = delete;
+	void operator=(const AsyncLogger&) = delete;
+};
+
+// ELOGȂǂgK[BŏɌĂ񂾂ƂɍAvȌIɎco
+AsyncLogger& GetLogger();
+
+#if LOG_MIN_SEVERITY <= LOG_SEVERITY_DEBUG
+#define DLOG(x, ...) GetLogger().Write(LOG_SEVERITY_DEBUG, __FILE__, __LINE__, x "\n", ##__VA_ARGS__)
+#else
+#define DLOG(x, ...) ((void)0)
 #endif
 
+#if LOG_MIN_SEVERITY <= LOG_SEVERITY_INFO
+#define ILOG(x, ...) GetLogger().Write(LOG_SEVERITY_INFO, __FILE__, __LINE__, x "\n", ##__VA_ARGS__)
+#else
+#define ILOG(x, ...) ((void)0)
+#endif
+
+#if LOG_MIN_SEVERITY <= LOG_SEVERITY_WARNING
+#define WLOG(x, ...) GetLogger().Write(LOG_SEVERITY_WARNING, __FILE__, __LINE__, x "\n", ##__VA_ARGS__)
+#else
+#define WLOG(x, ...) ((void)0)
+#endif
+
+#ifndef ELOG
+#if LOG_MIN_SEVERITY <= LOG_SEVERITY_ERROR
+#define ELOG(x, ...) GetLogger().Write(LOG_SEVERITY_ERROR, __FILE__, __LINE__, x "\n", ##__VA_ARGS__)
+#else
+#define ELOG(x, ...) ((void)0)
+#endif
+#endif
@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ResMesh.h"
+#include "StencilTable.h"
+#include "SubdTopology.h"
+
+// 三角形メッシュのLoop細分割。
+// ResMeshの頂点は法線やUVの不連続で分割されているので、位置が同じ頂点を溶接したトポロジで位置を細分割し、
+// 法線、UV、接線はResMeshの頂点のまま面ごとの属性（face-varying）として細分割する。
+// 属性が不連続なエッジ（UVシーム）では属性を両側で別々に持ち、シームに沿ってはクリースのルールで補間する。
+// 境界エッジ、指定したクリースは位置をシャープに扱う。
+// Init()で各レベルの1レベル上からのステンシルテーブルを一度だけ作り、Evaluate()ではレベルごとに並列に適用する。
+class LoopSubdivision
+{
+public:
+	struct LevelInfo
+	{
+		// 位置を溶接した頂点数
+		uint32_t VertexCount;
+		// ResMeshとしての頂点数
+		uint32_t AttributeCount;
+		uint32_t TriangleCount;
+		// ステンシルテーブルとトポロジのサイズ
+		size_t MemorySize;
+		double BuildMilliseconds;
+	};
+
+	LoopSubdivision() = default;
+	~LoopSubdivision();
+
+	// creasesのV0, V1はmeshの頂点インデックス。
+	// creaseSplitNormals == trueなら、法線が分割されているエッジを無限にシャープなクリースにする
+	bool Init(const ResMesh& mesh, uint32_t maxLevel, bool creaseSplitNormals, const std::vector<SubdCrease>& creases = {});
+	void Term();
+
+	uint32_t GetMaxLevel() const;
+	const LevelInfo& GetLevelInfo(uint32_t level) const;
+
+	// Init()に渡したメッシュの頂点を変形したものをlevelまで細分割する。Meshletは作らないのでBuildMeshlet()を呼ぶこと。
+	// pLevelMillisecondsには各レベルの評価時間が入る
+	bool Evaluate(const ResMesh& mesh, uint32_t level, ResMesh& result, std::vector<double>* pLevelMilliseconds = nullptr) const;
+
+private:
+	struct Level
+	{
+		uint32_t PositionCount = 0;
+		// 3要素で1三角形。ResMeshの頂点インデックス
+		std::vector<uint32_t> Indices;
+		std::vector<uint32_t> AttributeToPosition;
+		// 1レベル上からのステンシル。レベル0では使わない
+		StencilTable PositionStencils;
+		StencilTable AttributeStencils;
+		LevelInfo Info;
+	};
+
+	std::vector<Level> m_Levels;
+
+	LoopSubdivision(const LoopSubdivision&) = delete;
+	void operator=(const LoopSubdivision&) = delete;
+};
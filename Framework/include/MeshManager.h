@@ -4,6 +4,7 @@
 #include "ResMesh.h"
 #include "Resource.h"
 #include "Texture.h"
+#include "SceneBvh.h"
 
 #include <SimpleMath.h>
 
@@ -55,6 +56,25 @@ public:
 	size_t GetMeshletCount() const;
 
 	uint32_t GetMaterialIdx(uint32_t meshIdx) const;
+	const ResMaterial& GetResMaterial(uint32_t materialIdx) const;
+
+	// `ΏۂƂėLResMesh̑SMeshletAABB[hԂɕΐB
+	// SetMovableWorldMatrix()ɂύX͔fꂸAo^̃[hsg
+	void GetMeshletWorldAABBs(std::vector<AABB>& aabbs) const;
+
+	// `ΏۂƂėLResMesh̑SOp`̒_[hԂɕΐBOp`Ƃ3_ׂB
+	// meshIndicesɂ͎Op`ƂɗLResMesh̒ł̃CfbNXBSetMovableWorldMatrix()ɂύX͔fȂ
+	void GetWorldTriangles(std::vector<DirectX::SimpleMath::Vector3>& positions, std::vector<uint32_t>& meshIndices) const;
+	// GetWorldTriangles()ƓɁAOp`Ƃ3_[hԂ̒_@Ԃ
+	void GetWorldTriangleNormals(std::vector<DirectX::SimpleMath::Vector3>& normals) const;
+	// `ΏۂƂėLResMeshƂɁAIuWFNgԂ̎Op`̒_3_Ɠo^̃[hsԂB
+	// bV̏ƎOp`̏GetWorldTriangles()Ɠ
+	void GetLocalTriangles(std::vector<std::vector<DirectX::SimpleMath::Vector3>>& meshPositions, std::vector<DirectX::SimpleMath::Matrix>& worldMatrices) const;
+
+	// CPUł̌pɁALResMeshƂBLASTLAS2iBVH\zB
+	// \zSetMovableWorldMatrix()̂тɓbṼCX^XTLASRefit
+	bool BuildSceneBvh(const BvhBuildSettings& settings);
+	const SceneBvh& GetSceneBvh() const;
 
 	//TODO:pXgBindlessΉ܂ł̉̂
 	const Resource& GetVB(uint32_t meshIdx) const;
@@ -73,9 +93,15 @@ private:
 
 	std::vector<DirectX::SimpleMath::Matrix> m_worldMatrices;
 
+	// BuildSceneBvh()܂ł͋
+	SceneBvh m_SceneBvh;
+
 	class DescriptorPool* m_pPoolGpuVisible;
 	class DescriptorPool* m_pPoolCpuVisible;
 
+	// m_VBsAm_Meshlets*SBsAm_PositionVBsAm_IBs͂؂oBɔjȂ悤ɑOɒu
+	BufferSuballocator m_MeshBufferAllocator;
+
 	// vf͓o^ꂽMesh
 	std::vector<Resource> m_MeshCBs;
 	std::vector<Resource> m_VBs;
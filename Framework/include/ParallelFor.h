@@ -0,0 +1,12 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// [0, count)をgrainSize個ずつのチャンクに分割し、常駐ワーカースレッドと呼び出しスレッドで並列に処理する。
+// funcには各チャンクの[begin, end)が渡される。全チャンクの完了を待ってから戻る。
+// funcの中から入れ子で呼ばれた場合はデッドロックを避けるため呼び出しスレッドで逐次処理する。
+void ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)>& func);
+
+// ParallelForの処理に参加するスレッド数。呼び出しスレッドを含む
+uint32_t GetParallelForThreadCount();
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ParticleSimulator.h"
+
+// パーティクルの更新の入力列（生成スクリプト）。初期状態のスナップショットと、ステップごとのParticleUpdateDescを持つ。
+// ParticleSimulatorは入力が同じなら結果がビット単位で一致するので、記録した入力を描画なしで再生すると
+// シミュレーションの計測や回帰テストを毎回同じ条件で行える
+class ParticleReplay
+{
+public:
+	// 空の状態を初期状態にして記録を始める
+	void BeginRecording(uint32_t maxParticles);
+	// simulatorの現在の状態を初期状態にして記録を始める
+	void BeginRecording(const ParticleSimulator& simulator);
+	void RecordStep(const ParticleUpdateDesc& desc);
+
+	// ファイルの形式が違う場合はfalseを返す
+	bool Save(const wchar_t* path) const;
+	bool Load(const wchar_t* path);
+
+	uint32_t GetMaxParticles() const { return m_MaxParticles; }
+	uint32_t GetStepCount() const { return static_cast<uint32_t>(m_Steps.size()); }
+	const ParticleUpdateDesc& GetStep(uint32_t step) const { return m_Steps[step]; }
+
+	// 全ステップを再生した後のComputeStateHash()の値。回帰テストの期待値としてファイルに残す
+	void SetExpectedHash(uint64_t hash) { m_ExpectedHash = hash; m_HasExpectedHash = true; }
+	bool HasExpectedHash() const { return m_HasExpectedHash; }
+	uint64_t GetExpectedHash() const { return m_ExpectedHash; }
+
+	// simulatorを初期状態に戻す。最大パーティクル数が違う場合はInit()し直す
+	bool Restart(ParticleSimulator& simulator) const;
+	// [beginStep, endStep)のステップを順に更新する
+	void Play(ParticleSimulator& simulator, uint32_t beginStep, uint32_t endStep) const;
+
+private:
+	uint32_t m_MaxParticles = 0;
+	// 空なら初期状態にパーティクルはない
+	std::vector<uint8_t> m_InitialSnapshot;
+	std::vector<ParticleUpdateDesc> m_Steps;
+	uint64_t m_ExpectedHash = 0;
+	bool m_HasExpectedHash = false;
+};
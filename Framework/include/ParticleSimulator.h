@@ -0,0 +1,131 @@
+﻿#pragma once
+
+#include <SimpleMath.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Particle.hlsliのParticleDataと同じレイアウト
+struct ParticleData
+{
+	DirectX::SimpleMath::Vector3 Position;
+	DirectX::SimpleMath::Vector3 Velocity;
+	uint32_t Life;
+};
+
+// UpdateParticlesCS.hlslのルート定数と定数バッファ
+struct ParticleUpdateDesc
+{
+	uint32_t NumSpawnPerFrame;
+	uint32_t InitialLife;
+	float DeltaTime;
+	float InitialVelocityScale;
+	// 生成の乱数のキー。同じFrameIndexとRandomSeedなら生成されるパーティクルも同じになるので、フレームごとに変えること
+	uint32_t FrameIndex;
+	uint32_t RandomSeed;
+};
+
+enum PARTICLE_SIMD_MODE
+{
+	PARTICLE_SIMD_MODE_SCALAR,
+	PARTICLE_SIMD_MODE_AVX2,
+};
+
+// UpdateParticlesCS.hlslと同じ規則でパーティクルを更新するCPU実装。
+// 寿命の減算、重力による積分、生成、生存したパーティクルの詰め直しを行う。
+// パーティクルは要素ごとの配列（SoA）で前フレームと現フレームの2組を持ち、Update()のたびに入れ替える。
+// 詰め直しはチャンクごとの生存数の数え上げ、チャンクのオフセットの前置和、チャンクごとの書き込みの3段階で並列に行う。
+// 生存したパーティクルは元の順番を保ち、その後ろに生成したパーティクルが続く。
+// GPUはWave単位のアトミックで詰めるので順番は一致しないが、集合としては同じになる。
+// SCALARとAVX2の結果はビット単位で一致する
+class ParticleSimulator
+{
+public:
+	ParticleSimulator() = default;
+	~ParticleSimulator();
+
+	bool Init(uint32_t maxParticles);
+	void Term();
+
+	// UpdateParticlesCS.hlslの1回のDispatchに相当する。
+	// 生成の乱数は(生成の番号, FrameIndex)をキーにしたカウンタベースの乱数で、シェーダと同じ値になる。
+	// シェーダと違い、生成はmaxParticlesを超えないように切り詰める
+	void Update(const ParticleUpdateDesc& desc);
+
+	// パーティクルを全て消す
+	void Clear();
+
+	uint32_t GetNumParticles() const { return m_NumParticles; }
+	uint32_t GetMaxParticles() const { return m_MaxParticles; }
+	// 直前のUpdate()で積分したパーティクル数。[0, GetNumParticles())のうち、これより後ろは生成したばかりのパーティクル
+	uint32_t GetNumSurvivors() const { return m_NumSurvivors; }
+	// 直前のUpdate()のDeltaTime
+	float GetLastDeltaTime() const { return m_LastDeltaTime; }
+
+	// 現フレームのSoAの各配列。GetNumParticles()個が有効
+	const float* GetPositionX() const { return m_Streams[m_CurrStream].PositionX.data(); }
+	const float* GetPositionY() const { return m_Streams[m_CurrStream].PositionY.data(); }
+	const float* GetPositionZ() const { return m_Streams[m_CurrStream].PositionZ.data(); }
+	const float* GetVelocityX() const { return m_Streams[m_CurrStream].VelocityX.data(); }
+	const float* GetVelocityY() const { return m_Streams[m_CurrStream].VelocityY.data(); }
+	const float* GetVelocityZ() const { return m_Streams[m_CurrStream].VelocityZ.data(); }
+	const uint32_t* GetLife() const { return m_Streams[m_CurrStream].Life.data(); }
+
+	// 半径radiusの球としてgridのAABBとの衝突を解決する。
+	// AABBに入り込んだパーティクルは最も浅い軸の面まで押し戻し、その軸の速度をrestitution倍で反転する。
+	// gridのマージンはradius以上であること。衝突したパーティクル数を返す
+	uint32_t CollideWithAABBs(const class AABBHashGrid& grid, float radius, float restitution);
+
+	// 現フレームのパーティクルごとに、alphaで補間した位置のviewで変換した視点からの深度をソート用のキーにしてpKeysに書き込む。
+	// 右手系のビュー行列を前提とし、backToFrontなら奥のパーティクルほどキーが小さくなる。
+	// pKeysにはGetNumParticles()個の要素が必要
+	void ComputeViewDepthKeys(const DirectX::SimpleMath::Matrix& view, float alpha, bool backToFront, uint32_t* pKeys) const;
+
+	// ParticleDataの配列に変換する。pDstにはGetNumParticles()個の要素が必要
+	void CopyParticles(ParticleData* pDst) const;
+	// 位置を直前のUpdate()の前後の間でalphaで補間してParticleDataの配列に変換する。alphaが1なら現フレームの位置になる。
+	// 積分の逆算で前の位置を求めるので、前フレームの配列は使わない。生成したばかりのパーティクルは補間しない
+	void CopyInterpolatedParticles(float alpha, ParticleData* pDst) const;
+
+	// 現フレームの全状態をバイナリにしてdataに書き込む。LoadSnapshot()で戻すと以降のUpdate()の結果はビット単位で一致する
+	void SaveSnapshot(std::vector<uint8_t>& data) const;
+	// SaveSnapshot()の内容に戻す。形式が違うか、パーティクル数がGetMaxParticles()を超える場合はfalseを返し、状態は変えない
+	bool LoadSnapshot(const uint8_t* pData, size_t size);
+	// 現フレームの全状態のハッシュ（64ビットのFNV-1a）。決定性の検証や回帰テストの期待値に使う
+	uint64_t ComputeStateHash() const;
+
+	// CPUが対応していないモードならfalseを返し、モードは変えない
+	bool SetSIMDMode(PARTICLE_SIMD_MODE mode);
+	PARTICLE_SIMD_MODE GetSIMDMode() const { return m_SIMDMode; }
+	// falseなら呼び出しスレッドだけで処理する
+	void SetMultithreaded(bool multithreaded) { m_Multithreaded = multithreaded; }
+	bool IsMultithreaded() const { return m_Multithreaded; }
+
+private:
+	struct Stream
+	{
+		std::vector<float> PositionX;
+		std::vector<float> PositionY;
+		std::vector<float> PositionZ;
+		std::vector<float> VelocityX;
+		std::vector<float> VelocityY;
+		std::vector<float> VelocityZ;
+		std::vector<uint32_t> Life;
+	};
+
+	uint32_t m_MaxParticles = 0;
+	uint32_t m_NumParticles = 0;
+	uint32_t m_NumSurvivors = 0;
+	float m_LastDeltaTime = 0.0f;
+	uint32_t m_CurrStream = 0;
+	Stream m_Streams[2];
+	// チャンクごとの生存数。前置和を取って書き込み先のオフセットにする
+	std::vector<uint32_t> m_ChunkOffsets;
+	PARTICLE_SIMD_MODE m_SIMDMode = PARTICLE_SIMD_MODE_SCALAR;
+	bool m_Multithreaded = true;
+
+	void ForEachChunk(uint32_t count, const std::function<void(uint32_t begin, uint32_t end)>& func) const;
+
+	ParticleSimulator(const ParticleSimulator&) = delete;
+	void operator=(const ParticleSimulator&) = delete;
+};
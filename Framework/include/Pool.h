@@ -1,16 +1,22 @@
 #pragma once
 #include <mutex>
-#include <functional>
 #include <cassert>
-
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+// vfT͘AzɒuAANeBuXgƃt[Xg̃N͕ʂ̔z32bit̃CfbNXŎB
+// ANeBuXg̓CfbNXm_Capacity̔ԕn܂ȍzXgŁAmۂɕԁB
+// t[XgNextłȂAŌINVALID_INDEX
 template<typename T>
 class Pool
 {
 public:
 	Pool()
-	: m_pBuffer(nullptr),
-	m_pActive(nullptr),
-	m_pFree(nullptr),
+	: m_pValues(nullptr),
+	m_pLinks(nullptr),
+	m_FreeHead(INVALID_INDEX),
 	m_Capacity(0),
 	m_Count(0)
 	{
@@ -25,37 +31,30 @@ public:
 	{
 		std::lock_guard<std::mutex> guard(m_Mutex);
 
-		m_pBuffer = static_cast<uint8_t*>(malloc(sizeof(Item) * (count + 2)));
-		if (m_pBuffer == nullptr)
+		// ԕ̕N1
+		m_pValues = static_cast<T*>(malloc(sizeof(T) * count));
+		m_pLinks = static_cast<Link*>(malloc(sizeof(Link) * (count + 1)));
+		if (m_pValues == nullptr || m_pLinks == nullptr)
 		{
+			free(m_pValues);
+			free(m_pLinks);
+			m_pValues = nullptr;
+			m_pLinks = nullptr;
 			return false;
 		}
 
 		m_Capacity = count;
 
-		for (uint32_t i = 2u; i < m_Capacity + 2; i++)
-		{
-			Item* item = GetItem(i);
-			item->m_Index = i - 2u;
-		}
-
-		m_pActive = GetItem(0);
-		m_pActive->m_pPrev = m_pActive->m_pNext = m_pActive;
-		m_pActive->m_Index = uint32_t(-1);
-
-		m_pFree = GetItem(1);
-		m_pFree->m_Index = uint32_t(-2);
-		m_pFree->m_pPrev = nullptr;
-		m_pFree->m_pNext = GetItem(2);
+		Link& sentinel = m_pLinks[m_Capacity];
+		sentinel.Prev = sentinel.Next = m_Capacity;
 
-		for (uint32_t i = 2u; i < m_Capacity + 1; i++)
+		// ŏ̓CfbNX̏Ɏo悤ɂȂ
+		for (uint32_t i = 0; i < m_Capacity; i++)
 		{
-			GetItem(i)->m_pPrev = nullptr;
-			GetItem(i)->m_pNext = GetItem(i + 1); // m_pFree->m_pNextm_Index==2̃ACeɂȂBׂm_pNextʂm_pFreeɂȂĂ`Bt[Xgm_pNext݂̂łȂĂBm_pPrev̂̓ANeBuXgɓĂB
+			m_pLinks[i].Prev = INVALID_INDEX;
+			m_pLinks[i].Next = (i + 1 < m_Capacity) ? i + 1 : INVALID_INDEX;
 		}
-
-		GetItem(m_Capacity + 1)->m_pPrev = nullptr;
-		GetItem(m_Capacity + 1)->m_pNext = m_pFree;
+		m_FreeHead = (m_Capacity > 0) ? 0 : INVALID_INDEX;
 
 		m_Count = 0;
 
@@ -66,46 +65,56 @@ public:
 	{
 		std::lock_guard<std::mutex> guard(m_Mutex);
 
-		if (m_pBuffer != nullptr)
+		if (m_pValues != nullptr)
+		{
+			free(m_pValues);
+			m_pValues = nullptr;
+		}
+
+		if (m_pLinks != nullptr)
 		{
-			free(m_pBuffer);
-			m_pBuffer = nullptr;
+			free(m_pLinks);
+			m_pLinks = nullptr;
 		}
 
-		m_pActive = nullptr;
-		m_pFree = nullptr;
+		m_FreeHead = INVALID_INDEX;
 		m_Capacity = 0;
 		m_Count = 0;
 	}
 
-	T* Alloc(std::function<void(uint32_t, T*)> func = nullptr)
+	T* Alloc()
+	{
+		return Alloc([](uint32_t, T*) {});
+	}
+
+	// funcfunc(uint32_t index, T* pValue)̌`ŌẮׂB\zɃbN܂܌Ă
+	template<typename Func>
+	T* Alloc(Func&& func)
 	{
 		std::lock_guard<std::mutex> guard(m_Mutex);
 
-		if (m_pFree->m_pNext == m_pFree || m_Count >= m_Capacity)
+		if (m_FreeHead == INVALID_INDEX)
 		{
 			return nullptr;
 		}
 
-		// t[Xg̕m_pFreem_pNextʂĂȂĂƂRȌ`Ȃ̂AȂANeBuXgm_Activem_pPrev̕ɂ̂ڂ`ŘAĂƂ̎
+		// t[Xg̐擪ƂĂăANeBuXg̖ɑ}
+		uint32_t index = m_FreeHead;
+		Link& link = m_pLinks[index];
+		m_FreeHead = link.Next;
 
-		// t[Xg̐擪ƂĂăANeBuXg̐擪ɑ}
-		Item* item = m_pFree->m_pNext;
-		m_pFree->m_pNext = item->m_pNext;
-
-		item->m_pPrev = m_pActive->m_pPrev;
-		item->m_pNext = m_pActive;
-		item->m_pPrev->m_pNext = item->m_pNext->m_pPrev = item;
+		Link& sentinel = m_pLinks[m_Capacity];
+		link.Prev = sentinel.Prev;
+		link.Next = m_Capacity;
+		m_pLinks[sentinel.Prev].Next = index;
+		sentinel.Prev = index;
 
 		m_Count++;
 
-		T* val = new ((void*)item) T();
+		T* val = new ((void*)&m_pValues[index]) T();
 
-		if (func != nullptr)
-		{
-			assert(item->m_Index >= 0 && item->m_Index < m_Capacity);
-			func(item->m_Index, val);
-		}
+		assert(index < m_Capacity);
+		func(index, val);
 
 		return val;
 	}
@@ -119,19 +128,38 @@ public:
 
 		std::lock_guard<std::mutex> guard(m_Mutex);
 
-		// t[Xg̐擪ɑ}
-		Item* item = reinterpret_cast<Item*>(pValue);
-		item->m_pPrev->m_pNext = item->m_pNext;
-		item->m_pNext->m_pPrev = item->m_pPrev;
+		uint32_t index = static_cast<uint32_t>(pValue - m_pValues);
+		assert(index < m_Capacity);
 
-		item->m_pPrev = nullptr;
-		item->m_pNext = m_pFree->m_pNext;
+		// ANeBuXgOăt[Xg̐擪ɑ}
+		Link& link = m_pLinks[index];
+		m_pLinks[link.Prev].Next = link.Next;
+		m_pLinks[link.Next].Prev = link.Prev;
 
-		m_pFree->m_pNext = item;
+		link.Prev = INVALID_INDEX;
+		link.Next = m_FreeHead;
+		m_FreeHead = index;
 
 		m_Count--;
 	}
 
+	// mے̗vfƂɁAmۂfunc(uint32_t index, T* pValue)ĂԁBĂłԂ̓bN̂ŁAfunc̒Alloc()Free()͂łȂ
+	template<typename Func>
+	void ForEachActive(Func&& func)
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+
+		if (m_pLinks == nullptr)
+		{
+			return;
+		}
+
+		for (uint32_t index = m_pLinks[m_Capacity].Next; index != m_Capacity; index = m_pLinks[index].Next)
+		{
+			func(index, &m_pValues[index]);
+		}
+	}
+
 	uint32_t GetSize() const
 	{
 		return m_Capacity;
@@ -147,38 +175,28 @@ public:
 		return m_Capacity - m_Count;
 	}
 
-private:
-	struct Item
+	// 1vf̃BvfƃN̍v
+	static constexpr size_t GetSlotSize()
 	{
-		T m_Value;
-		uint32_t m_Index;
-		Item* m_pPrev;
-		Item* m_pNext;
-
-		Item()
-		: m_Value()
-		, m_Index(0)
-		, m_pPrev(nullptr)
-		, m_pNext(nullptr)
-		{
-		}
+		return sizeof(T) + sizeof(Link);
+	}
+
+private:
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
 
-		~Item() {}
+	struct Link
+	{
+		uint32_t Prev;
+		uint32_t Next;
 	};
 
-	uint8_t* m_pBuffer;
-	Item* m_pActive;
-	Item* m_pFree;
+	T* m_pValues;
+	Link* m_pLinks;
+	uint32_t m_FreeHead;
 	uint32_t m_Capacity;
 	uint32_t m_Count;
 	std::mutex m_Mutex;
 
-	Item* GetItem(uint32_t index)
-	{
-		assert(0 <= index && index < m_Capacity + 2);
-		return reinterpret_cast<Item*>(m_pBuffer + sizeof(Item) * index);
-	}
-
 	Pool(const Pool&) = delete;
 	void operator=(const Pool&) = delete;
 };
@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// floatを、大小関係を保ったままuint32_tの昇順で並ぶキーにする。
+// 正の数は符号ビットを立て、負の数は全ビットを反転する
+inline uint32_t FloatToSortableKey(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// 32ビットのキーとその値の組を、キーの昇順に安定にソートするLSD基数ソート。
+// 8ビットずつ4パスで、各パスはチャンクごとのヒストグラムの計数、桁とチャンクの順の前置和、チャンクごとの書き込みの3段階で行う。
+// ヒストグラムはチャンク（ParallelForで1スレッドが処理する単位）ごとに持つので、計数と書き込みでアトミックは使わない。
+// 全要素で同じ値の桁のパスは飛ばす
+class RadixSorter
+{
+public:
+	// pKeysとpValuesのcount個の組をソートする。作業用のバッファは次の呼び出しでも使い回す
+	void Sort(uint32_t count, uint32_t* pKeys, uint32_t* pValues);
+
+	// falseなら呼び出しスレッドだけで処理する
+	void SetMultithreaded(bool multithreaded) { m_Multithreaded = multithreaded; }
+	bool IsMultithreaded() const { return m_Multithreaded; }
+
+	// 直前のSort()で実際に行ったパス数
+	uint32_t GetLastPassCount() const { return m_LastPassCount; }
+
+private:
+	std::vector<uint32_t> m_TempKeys;
+	std::vector<uint32_t> m_TempValues;
+	// チャンクごとの256要素のヒストグラム。前置和を取ってチャンクごとの書き込み先にする
+	std::vector<uint32_t> m_Histograms;
+	bool m_Multithreaded = true;
+	uint32_t m_LastPassCount = 0;
+};
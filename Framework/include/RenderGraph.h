@@ -0,0 +1,100 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+struct RenderGraphStats
+{
+	uint32_t PassCount = 0;
+	uint32_t CulledPassCount = 0;
+	// 生き残ったパスが使う一時リソースの数
+	uint32_t TransientResourceCount = 0;
+	// 登録した一時リソースを全て個別に確保した場合の量
+	uint64_t DeclaredSize = 0;
+	// 生き残ったパスが使う一時リソースを個別に確保した場合の量
+	uint64_t TransientSize = 0;
+};
+
+// パスごとに読み書きするリソースを宣言し、Compile()で出力が使われないパスを除いて、
+// 一時リソースの寿命を求めるレンダーグラフ。寿命からメモリを共有する配置はAliasingPlannerで求める。
+// リソースは起動時にAddTransientResource()とAddImportedResource()で登録しておき、
+// パスは毎フレームResetPasses()してから実行する順にAddPass()し直す。
+// インポートしたリソース(バックバッファや前のフレームの結果を持つもの)を書くパスが出力になる。
+// 大きさとアラインメントは呼び出し側が渡すので、コンパイルはデバイスがなくても動く。スレッドセーフではない
+class RenderGraph
+{
+public:
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	RenderGraph();
+	~RenderGraph();
+
+	void Term();
+
+	// フレームの中だけで使うリソース。sizeとalignmentはID3D12Device::GetResourceAllocationInfo()の値を渡す
+	uint32_t AddTransientResource(const char* name, uint64_t size, uint64_t alignment);
+	// フレームをまたいで中身を持つリソース。書くパスは除かれず、メモリの共有もしない
+	uint32_t AddImportedResource(const char* name);
+
+	// 登録したリソースは残してパスだけを空にする
+	void ResetPasses();
+	// readsとwritesはリソースのインデックス。同じリソースを両方に入れれば上書きではなく重ね描きになる。
+	// 読むリソースは、このパスより前に書いたものを読む
+	uint32_t AddPass(const char* name, std::initializer_list<uint32_t> reads, std::initializer_list<uint32_t> writes, std::function<void()> execute);
+
+	// 使われないパスを除き、一時リソースの寿命を求める
+	void Compile();
+	// 除かれていないパスをAddPass()した順に実行する
+	void Execute() const;
+
+	bool IsPassCulled(uint32_t passIdx) const;
+	// 一時リソースを最初と最後に使うパスのインデックス。使われないものとインポートしたものはINVALID_INDEX
+	uint32_t GetFirstPass(uint32_t resourceIdx) const;
+	uint32_t GetLastPass(uint32_t resourceIdx) const;
+	// AddTransientResource()で渡した大きさとアラインメント。インポートしたものは0と1
+	uint64_t GetSize(uint32_t resourceIdx) const;
+	uint64_t GetAlignment(uint32_t resourceIdx) const;
+	uint32_t GetResourceCount() const { return static_cast<uint32_t>(m_Resources.size()); }
+	uint32_t GetPassCount() const { return m_PassCount; }
+	const RenderGraphStats& GetStats() const { return m_Stats; }
+
+private:
+	struct Resource
+	{
+		std::string Name;
+		uint64_t Size;
+		uint64_t Alignment;
+		bool IsImported;
+		// 以下はCompile()で求める
+		bool IsNeeded;
+		uint32_t FirstPass;
+		uint32_t LastPass;
+	};
+
+	struct Pass
+	{
+		std::string Name;
+		std::vector<uint32_t> Reads;
+		std::vector<uint32_t> Writes;
+		std::function<void()> Execute;
+		// Compile()で求める
+		bool IsCulled;
+	};
+
+	std::vector<Resource> m_Resources;
+	// ResetPasses()では要素を消さずにm_PassCountだけを戻し、読み書きのvectorを使い回す
+	std::vector<Pass> m_Passes;
+	uint32_t m_PassCount;
+	RenderGraphStats m_Stats;
+
+	uint32_t AddResource(const char* name, uint64_t size, uint64_t alignment, bool isImported);
+	void CullPasses();
+	void ComputeLifetimes();
+	void ComputeStats();
+
+	RenderGraph(const RenderGraph&) = delete;
+	void operator=(const RenderGraph&) = delete;
+};
@@ -96,3 +96,6 @@ bool LoadMesh
 	std::vector<ResMesh>& meshes,
 	std::vector<ResMaterial>& materials
 );
+
+// LoadMesh()ȊOōbVMeshlet蒼
+void BuildMeshlet(ResMesh& mesh, bool useMetis);
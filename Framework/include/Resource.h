@@ -3,9 +3,11 @@
 #include <d3d12.h>
 #include <cstdint>
 #include "ComPtr.h"
+#include "BufferSuballocator.h"
 
 class DescriptorPool;
 class DescriptorHandle;
+class UploadRing;
 
 class Resource
 {
@@ -127,6 +129,28 @@ public:
 		);
 	}
 
+	// ̃\[X͍炸ApSuballocator̃y[WcountT͈̔͂؂oĎgB
+	// SRVFirstElement炵č̂ŁAVF[_͒PƂStructuredBufferƓɌB
+	// VBV͈͂ŵŒ_obt@ɂgBTerm()Ŕ͈͂ԋp
+	template<typename T>
+	bool InitAsSubAllocatedStructuredBuffer
+	(
+		ID3D12Device* pDevice,
+		BufferSuballocator* pSuballocator,
+		size_t count,
+		DescriptorPool* pPoolSRV
+	)
+	{
+		return InitAsSubAllocatedStructuredBuffer
+		(
+			pDevice,
+			pSuballocator,
+			count,
+			sizeof(T),
+			pPoolSRV
+		);
+	}
+
 	bool InitAsByteAddressBuffer
 	(
 		ID3D12Device* pDevice,
@@ -166,6 +190,8 @@ public:
 		);
 	}
 
+	// SetUploadRing()Őݒ肵OʂăRs[BRs[pCmdListł͂ȂÕR}hXgɋL^̂ŁA
+	// pCmdListsOUploadRing::Submit()邱ƁBOȂƂ̓ÕR}hXgsđ҂
 	bool UploadBufferData
 	(
 		ID3D12Device* pDevice,
@@ -174,6 +200,9 @@ public:
 		const void* pData
 	);
 
+	// UploadBufferData()őSĂResourceLAbv[hp̃Oݒ肷
+	static void SetUploadRing(UploadRing* pUploadRing);
+
 	template<typename T>
 	T* Map() const
 	{
@@ -192,12 +221,13 @@ public:
 	DescriptorHandle* GetHandleSRV() const;
 	DescriptorHandle* GetHandleUAV() const;
 	ID3D12Resource* GetResource() const;
+	// ؂o͈͂Ȃ炻̐擪̃AhX
+	D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const;
 	size_t GetSize() const;
 
 private:
 	D3D12_RESOURCE_STATES m_state = D3D12_RESOURCE_STATE_COMMON;
 	ComPtr<ID3D12Resource> m_pResource;
-	ComPtr<ID3D12Resource> m_pUploadBuffer;
 	D3D12_VERTEX_BUFFER_VIEW m_VBV;
 	D3D12_INDEX_BUFFER_VIEW m_IBV;
 	DescriptorHandle* m_pHandleSRV = nullptr;
@@ -207,6 +237,11 @@ private:
 	DescriptorPool* m_pPoolUAVGpuVisible = nullptr;
 	DescriptorPool* m_pPoolUAVCpuVisible = nullptr;
 	size_t m_size = 0;
+	// InitAsSubAllocatedStructuredBuffer()Ő؂oƂgBm_pResource̓y[Ww
+	BufferSuballocator* m_pSuballocator = nullptr;
+	BufferAllocation m_Allocation;
+
+	static UploadRing* s_pUploadRing;
 
 	bool InitAsVertexBuffer
 	(
@@ -242,6 +277,15 @@ private:
 		LPCWSTR name = nullptr
 	);
 
+	bool InitAsSubAllocatedStructuredBuffer
+	(
+		ID3D12Device* pDevice,
+		BufferSuballocator* pSuballocator,
+		size_t count,
+		size_t structureSize,
+		DescriptorPool* pPoolSRV
+	);
+
 	void* Map() const;
 
 	void operator=(const Resource&) = delete;
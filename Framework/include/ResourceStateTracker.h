@@ -0,0 +1,119 @@
+﻿#pragma once
+
+#include <d3d12.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct ResourceStateTrackerStats
+{
+	// Transition()などで要求されたバリアの数。1つずつResourceBarrier()を呼んでいたときに発行していた数になる
+	uint32_t RequestedCount = 0;
+	// 打ち消し合う遷移と不要なUAVバリアを除いて実際に発行したバリアの数。分割バリアは開始と終了で2つと数える
+	uint32_t IssuedCount = 0;
+	// ResourceBarrier()を呼んだ回数
+	uint32_t FlushCount = 0;
+	// 開始した分割バリアの数
+	uint32_t SplitCount = 0;
+};
+
+// コマンドの記録中にリソースの状態をサブリソースごとに追跡し、要求された遷移をすぐには発行せずにためておくトラッカー。
+// Flush()でたまっている遷移とUAVバリアを1回のResourceBarrier()にまとめて発行するので、パスの終わりに元の状態に戻して
+// 次のパスの始めにまた遷移させるようなものは打ち消し合い、発行されない。
+// 追跡していないリソースは最初に渡されたbeforeの状態にあるものとして追跡を始め、Finish()で追跡を空にする。
+// フレームをまたいでリソースが置かれている状態は今まで通り呼び出し側が決める。
+// Flush()はResourceBarrier(UINT, const D3D12_RESOURCE_BARRIER*)を持つ型なら何でも受け取るので、コマンドリストのモックでも動く。
+// スレッドセーフではない
+class ResourceStateTracker
+{
+public:
+	ResourceStateTracker();
+	~ResourceStateTracker();
+
+	// 全サブリソースの遷移
+	void Transition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
+	// 1つのサブリソースの遷移。subresourceCountはリソースのサブリソースの数で、サブリソースごとの追跡を始めるときに使う。
+	// 追跡していないリソースは全サブリソースがbeforeの状態にあるものとする
+	void TransitionSubresource(ID3D12Resource* pResource, uint32_t subresourceCount, uint32_t subresource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
+	// 分割バリアの開始。次のFlush()でBEGIN_ONLYを発行し、EndSplitTransition()の後のFlush()でEND_ONLYを発行するので、
+	// 間に挟まったパスの分だけGPUが遷移を先に進められる。全サブリソースの遷移のみ
+	void BeginSplitTransition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
+	// 分割バリアを終える。開始していないリソースなら何もしない。BEGIN_ONLYを発行する前なら普通の遷移になる
+	void EndSplitTransition(ID3D12Resource* pResource);
+	// pResourceがnullptrなら全てのUAVアクセスを待つ
+	void UAVBarrier(ID3D12Resource* pResource);
+
+	// たまっているバリアを1回のResourceBarrier()で発行する。遷移した状態を使うDrawやDispatchなどの前に呼ぶ
+	template<class CommandList>
+	void Flush(CommandList* pCmdList)
+	{
+		const std::vector<D3D12_RESOURCE_BARRIER>& barriers = ResolveBarriers();
+		if (!barriers.empty())
+		{
+			pCmdList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+		}
+	}
+
+	// コマンドリストの記録の終わりに呼ぶ。終えていない分割バリアも終えて発行し、追跡を空にする
+	template<class CommandList>
+	void Finish(CommandList* pCmdList)
+	{
+		EndAllSplitTransitions();
+		Flush(pCmdList);
+		Reset();
+	}
+
+	// Finish()までに記録したフレームの統計
+	const ResourceStateTrackerStats& GetLastFrameStats() const { return m_LastFrameStats; }
+
+private:
+	enum class SPLIT_PHASE : uint8_t
+	{
+		NONE,
+		// BeginSplitTransition()の後でBEGIN_ONLYを発行する前
+		BEGIN_PENDING,
+		// BEGIN_ONLYを発行済み
+		BEGUN,
+		// EndSplitTransition()の後でEND_ONLYを発行する前
+		END_PENDING,
+	};
+
+	struct ResourceState
+	{
+		ID3D12Resource* pResource;
+		// 発行済みのバリアを全て通った後の状態。要素が1つなら全サブリソースが同じ状態
+		std::vector<D3D12_RESOURCE_STATES> Current;
+		// 要求された遷移を全て通った後の状態。呼び出し側から見える状態で、Currentと同じ数
+		std::vector<D3D12_RESOURCE_STATES> Pending;
+		D3D12_RESOURCE_STATES SplitBefore;
+		D3D12_RESOURCE_STATES SplitAfter;
+		SPLIT_PHASE SplitPhase;
+		// m_DirtyResourcesに入っているか
+		bool IsDirty;
+	};
+
+	std::unordered_map<ID3D12Resource*, uint32_t> m_ResourceIndices;
+	// Reset()では要素を消さずにm_ResourceCountだけを戻し、状態のvectorを使い回す
+	std::vector<ResourceState> m_Resources;
+	uint32_t m_ResourceCount;
+	// 遷移を要求されてからまだ発行していないリソースのインデックス
+	std::vector<uint32_t> m_DirtyResources;
+	std::vector<ID3D12Resource*> m_UAVBarriers;
+	// ResolveBarriers()の作業用。毎回確保し直さないように持っておく
+	std::vector<D3D12_RESOURCE_BARRIER> m_Barriers;
+	ResourceStateTrackerStats m_Stats;
+	ResourceStateTrackerStats m_LastFrameStats;
+
+	uint32_t FindOrAddResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES before);
+	void MarkDirty(uint32_t resourceIdx);
+	// 分割バリアを途中まで進めていれば、普通の遷移として続けられるようにする
+	void CompleteSplitTransition(uint32_t resourceIdx);
+	void EndAllSplitTransitions();
+	const std::vector<D3D12_RESOURCE_BARRIER>& ResolveBarriers();
+	void ResolveTransitions(ResourceState& state);
+	void AddTransitionBarrier(ID3D12Resource* pResource, uint32_t subresource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after, D3D12_RESOURCE_BARRIER_FLAGS flags);
+	void Reset();
+
+	ResourceStateTracker(const ResourceStateTracker&) = delete;
+	void operator=(const ResourceStateTracker&) = delete;
+};
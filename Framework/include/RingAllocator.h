@@ -0,0 +1,109 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+struct RingAllocatorFrameStats
+{
+	// そのフレームで確保した量。リングの末尾で折り返したときに飛ばした分も含む
+	uint64_t AllocatedSize = 0;
+	// フレームの終わりに、GPUが使い終わっていない前のフレームの分も含めて使っていた量
+	uint64_t InFlightSize = 0;
+};
+
+// [0, capacity)の範囲をリングバッファとして、フレームごとに先頭から詰めて確保し、
+// フレームのフェンスが完了したらそのフレームの分をまとめて返却するアロケータ。
+// 範囲の中身は持たず、オフセットだけを扱うのでデバイスがなくても使える。
+// Allocate()はCASで先頭を進めるだけなので、複数スレッドから同時に呼べる。
+// EndFrame()とRetire()はフレームの境目で1つのスレッドから呼び、Allocate()と同時には呼ばない
+class RingAllocator
+{
+public:
+	static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+	// maxFrameCountはEndFrame()してからRetire()されるまでのフレームの数の上限
+	bool Init(uint64_t capacity, uint32_t maxFrameCount);
+	void Term();
+
+	// alignmentの倍数のオフセットから連続したsizeを確保する。末尾をまたぐときは先頭に折り返す。
+	// 空きが足りなければINVALID_OFFSETを返す
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+	// sizeをmaxChunkSize以下のチャンクに分けて確保し、チャンクごとにfunc(uint64_t srcOffset, uint64_t ringOffset, uint64_t chunkSize)を呼ぶ。
+	// 空きが足りなければflush()を呼んでからやり直す。flush()はそれまでに確保した分を全て返却してtrueを返すものにする。
+	// maxChunkSizeが容量の1/4以下なら、全て返却した直後は折り返しても必ず確保できる。1つのスレッドから呼ぶ
+	template<typename Func, typename FlushFunc>
+	bool AllocateChunks(uint64_t size, uint64_t alignment, uint64_t maxChunkSize, Func&& func, FlushFunc&& flush)
+	{
+		if (maxChunkSize == 0)
+		{
+			return false;
+		}
+
+		uint64_t srcOffset = 0;
+		while (srcOffset < size)
+		{
+			uint64_t chunkSize = std::min(size - srcOffset, maxChunkSize);
+			uint64_t ringOffset = Allocate(chunkSize, alignment);
+			if (ringOffset == INVALID_OFFSET)
+			{
+				if (!flush())
+				{
+					return false;
+				}
+
+				ringOffset = Allocate(chunkSize, alignment);
+				if (ringOffset == INVALID_OFFSET)
+				{
+					return false;
+				}
+			}
+
+			func(srcOffset, ringOffset, chunkSize);
+			srcOffset += chunkSize;
+		}
+
+		return true;
+	}
+
+	// ここまでに確保した分を、fenceValueのフェンスが完了したら返却するフレームとして区切る。
+	// 返却待ちのフレームがmaxFrameCount個あるときはfalseを返す
+	bool EndFrame(uint64_t fenceValue);
+	// completedFenceValue以下のフェンスのフレームの分を返却する
+	void Retire(uint64_t completedFenceValue);
+
+	uint64_t GetCapacity() const { return m_Capacity; }
+	// 返却されていない量
+	uint64_t GetUsedSize() const;
+	// 返却待ちのフレームの数
+	uint32_t GetPendingFrameCount() const { return m_PendingFrameCount; }
+	// 直前のEndFrame()で区切ったフレームの統計
+	const RingAllocatorFrameStats& GetLastFrameStats() const { return m_LastFrameStats; }
+	// Init()してからのInFlightSizeの最大値
+	uint64_t GetHighWaterMark() const { return m_HighWaterMark; }
+
+private:
+	struct PendingFrame
+	{
+		uint64_t FenceValue;
+		// フレームの終わりのHeadの位置
+		uint64_t EndPosition;
+	};
+
+	// 位置は折り返さずに増え続ける値で持ち、capacityで割った余りをオフセットにする。
+	// Head - Tailが使っている量になる
+	std::atomic<uint64_t> m_Head = 0;
+	std::atomic<uint64_t> m_Tail = 0;
+	uint64_t m_Capacity = 0;
+	uint64_t m_FrameBeginPosition = 0;
+
+	// 返却待ちのフレームのリングバッファ
+	std::vector<PendingFrame> m_PendingFrames;
+	uint32_t m_FirstPendingFrame = 0;
+	uint32_t m_PendingFrameCount = 0;
+
+	RingAllocatorFrameStats m_LastFrameStats;
+	uint64_t m_HighWaterMark = 0;
+};
@@ -0,0 +1,71 @@
+﻿#pragma once
+
+#include <SimpleMath.h>
+#include <cstdint>
+#include <vector>
+#include "Bvh.h"
+#include "TriangleBvh.h"
+
+// メッシュごとにオブジェクト空間で構築した三角形のBVH(BLAS)と、それらをワールド行列で置いたインスタンスのAABBのBVH(TLAS)の2段のBVH。
+// ワールド行列を変えたときはTLASのうち動いたインスタンスの葉から根までのAABBを求め直すだけなので、
+// 更新の時間は三角形数ではなく動いたインスタンスの数に比例する。
+// インスタンスはメッシュと1対1で、インスタンスのインデックスはメッシュのインデックスと同じ
+class SceneBvh
+{
+public:
+	// meshPositionsはメッシュごとに、オブジェクト空間の三角形ごとに3頂点ずつ。worldMatricesはメッシュごとのワールド行列
+	bool Build
+	(
+		const std::vector<std::vector<DirectX::SimpleMath::Vector3>>& meshPositions,
+		const std::vector<DirectX::SimpleMath::Matrix>& worldMatrices,
+		const BvhBuildSettings& settings
+	);
+	void Term();
+
+	uint32_t GetInstanceCount() const { return static_cast<uint32_t>(m_Instances.size()); }
+	uint32_t GetTriangleCount() const { return m_TriangleCount; }
+	const DirectX::SimpleMath::Matrix& GetWorldMatrix(uint32_t instanceIdx) const;
+	const Bvh& GetTlas() const { return m_Tlas; }
+	const TriangleBvh& GetBlas(uint32_t instanceIdx) const;
+	size_t GetMemorySize() const;
+
+	// ワールド行列を変える。Refit()を呼ぶまで交差判定には反映されない
+	void SetWorldMatrix(uint32_t instanceIdx, const DirectX::SimpleMath::Matrix& world);
+	// SetWorldMatrix()で変えたインスタンスのAABBを求め直し、TLASをRefitする
+	bool Refit();
+	// 直前のRefit()で更新したインスタンスの数と時間
+	uint32_t GetLastRefitInstanceCount() const { return m_LastRefitInstanceCount; }
+	double GetLastRefitMilliseconds() const { return m_LastRefitMilliseconds; }
+
+	// [0, tMax]で最も近い交差を返す。裏面とも交差する。
+	// hit.MeshIdxはインスタンスのインデックス、hit.TriangleIdxはメッシュの順に全三角形を並べたときのインデックス
+	bool Intersect(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& direction, float tMax, TriangleHit& hit) const;
+	// [0, tMax]で何かと交差するか。シャドウレイ用
+	bool IsOccluded(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& direction, float tMax) const;
+
+private:
+	struct Instance
+	{
+		DirectX::SimpleMath::Matrix World;
+		// 光線をオブジェクト空間に戻すための逆行列
+		DirectX::SimpleMath::Matrix InvWorld;
+		// メッシュの順に全三角形を並べたときの、このインスタンスの最初の三角形のインデックス
+		uint32_t FirstTriangleIdx;
+		bool IsDirty;
+	};
+
+	// インスタンスごとに1つ
+	std::vector<TriangleBvh> m_Blases;
+	std::vector<Instance> m_Instances;
+	// TLASのプリミティブとしてのワールド空間のAABB
+	std::vector<BvhPrimitiveBounds> m_InstanceBounds;
+	Bvh m_Tlas;
+	// SetWorldMatrix()してからRefit()していないインスタンス
+	std::vector<uint32_t> m_DirtyInstances;
+	uint32_t m_TriangleCount = 0;
+	uint32_t m_LastRefitInstanceCount = 0;
+	double m_LastRefitMilliseconds = 0.0;
+
+	// BLASの根のAABBをワールド行列で変換してインスタンスのAABBを求める
+	void UpdateInstanceBounds(uint32_t instanceIdx);
+};
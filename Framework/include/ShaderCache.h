@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ShaderCacheKey
+{
+	uint64_t Hash[2] = {0, 0};
+
+	bool operator==(const ShaderCacheKey& other) const { return Hash[0] == other.Hash[0] && Hash[1] == other.Hash[1]; }
+	bool operator!=(const ShaderCacheKey& other) const { return !(*this == other); }
+};
+
+struct ShaderCacheStats
+{
+	uint32_t HitCount = 0;
+	uint32_t MissCount = 0;
+	// キャッシュのファイルを書き込めなかった回数
+	uint32_t StoreFailureCount = 0;
+	// Load()でキャッシュのファイルを探して読み込んだ時間の合計
+	double LoadMilliseconds = 0.0;
+	// ヒットしたシェーダを前にコンパイルしたときにかかった時間から、読み込みにかかった時間を引いたものの合計
+	double SavedMilliseconds = 0.0;
+};
+
+// コンパイル済みのシェーダのバイナリを、ソースとその入力から作ったハッシュをファイル名にしてディスクに置くキャッシュ。
+// キーにはソース、#includeで辿れる全てのファイルの中身、コンパイル引数、コンパイラのバージョンを入れるので、
+// どれかが変われば別のキーになり、古いバイナリを使うことはない。
+// コンパイラには触らないので、DXCがなくても動く。Load()とStore()は複数スレッドから同時に呼べる
+class ShaderCache
+{
+public:
+	ShaderCache();
+	~ShaderCache();
+
+	// directoryがなければ作る
+	bool Init(const wchar_t* directory);
+	void Term();
+	bool IsEnabled() const { return !m_Directory.empty(); }
+
+	// #includeはインクルードする側のファイルのディレクトリ、argsの-Iのディレクトリの順に探す。
+	// 条件コンパイルは評価しないので、使われない#includeのファイルもキーに入る。余計に作り直すことはあっても古いものは使わない。
+	// 見つからない#includeは名前だけをキーに入れる。pSourceFilesがnullptrでなければ、中身をキーに入れたファイル
+	// (メインのソースと見つかった#include)の絶対パスを入れる
+	static bool ComputeKey(const wchar_t* filePath, const std::vector<const wchar_t*>& args, const char* compilerVersion, ShaderCacheKey& key, std::vector<std::wstring>* pSourceFiles);
+
+	// ヒットしたらdataに中身を入れてtrueを返す。壊れているファイルはミスとして扱う
+	bool Load(const ShaderCacheKey& key, std::vector<uint8_t>& data);
+	// compileMillisecondsはコンパイルにかかった時間で、ヒットしたときに節約した時間として数える
+	bool Store(const ShaderCacheKey& key, const void* pData, size_t size, double compileMilliseconds);
+
+	ShaderCacheStats GetStats() const;
+
+private:
+	std::wstring m_Directory;
+	mutable std::mutex m_StatsMutex;
+	ShaderCacheStats m_Stats;
+
+	std::wstring GetFilePath(const ShaderCacheKey& key) const;
+
+	ShaderCache(const ShaderCache&) = delete;
+	void operator=(const ShaderCache&) = delete;
+};
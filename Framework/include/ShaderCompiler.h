@@ -1,19 +1,36 @@
-#pragma once
+﻿#pragma once
 
 #include "ComPtr.h"
+#include "ShaderCache.h"
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <dxcapi.h>
 
+// DXCのインスタンスはスレッドセーフではないので、ワーカーごとに持つ。
+// 違うworkerIndexのCompile()は別のスレッドから同時に呼べる
 class ShaderCompiler
 {
 public:
 	virtual ~ShaderCompiler();
-	bool Init();
+	// cacheDirectoryにコンパイル済みのシェーダをキャッシュする。nullptrならキャッシュしない
+	bool Init(const wchar_t* cacheDirectory, uint32_t workerCount);
 	void Term();
-	bool Compile(const wchar_t* filePath, std::vector<const wchar_t*>& args, ComPtr<struct IDxcBlob>& outBlob);
+	// pSourceFilesがnullptrでなければ、コンパイルに使ったファイル(メインのソースと#includeしたもの)の絶対パスを入れる
+	bool Compile(uint32_t workerIndex, const wchar_t* filePath, std::vector<const wchar_t*>& args, ComPtr<struct IDxcBlob>& outBlob, std::vector<std::wstring>* pSourceFiles);
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+	ShaderCacheStats GetCacheStats() const { return m_Cache.GetStats(); }
 
 private:
-	ComPtr<struct IDxcUtils> m_pUtils;
-	ComPtr<struct IDxcCompiler3> m_pCompiler;
-	ComPtr<struct IDxcIncludeHandler> m_pIncludeHandler;
+	struct Worker
+	{
+		ComPtr<struct IDxcUtils> pUtils;
+		ComPtr<struct IDxcCompiler3> pCompiler;
+		ComPtr<struct IDxcIncludeHandler> pIncludeHandler;
+	};
+
+	std::vector<Worker> m_Workers;
+	ShaderCache m_Cache;
+	// キャッシュのキーに入れる。DXCを更新したら古いキャッシュを使わない
+	std::string m_CompilerVersion;
 };
@@ -0,0 +1,53 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// シェーダと、そのコンパイルに使ったファイル(メインのソースと#includeで辿れる全てのファイル)の対応を持つ。
+// ファイルからシェーダへの逆引きを持つので、変わったファイルからコンパイルし直すシェーダだけを引ける。
+// 入れ子の#includeも辿った後のファイルを全て渡すので、深いところのファイルが変わってもそれを使うシェーダだけが引ける。
+// パスはNormalizePath()してから比べる。スレッドセーフではない
+class ShaderDependencyGraph
+{
+public:
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	ShaderDependencyGraph();
+	~ShaderDependencyGraph();
+
+	void Clear();
+
+	// シェーダを追加し、そのインデックスを返す。依存するファイルはSetDependencies()で入れる
+	uint32_t AddShader(const wchar_t* name);
+	// shaderIdxのシェーダが使うファイルを入れ替える。コンパイルし直して#includeが増えたり減ったりしたら呼ぶ
+	void SetDependencies(uint32_t shaderIdx, const std::vector<std::wstring>& files);
+
+	// changedFilesのどれかを使うシェーダのインデックスを、小さい順に重複なくshaderIndicesに入れる
+	void CollectAffectedShaders(const std::vector<std::wstring>& changedFiles, std::vector<uint32_t>& shaderIndices) const;
+	// どれかのシェーダが使うファイルを全てfilesに入れる
+	void CollectFiles(std::vector<std::wstring>& files) const;
+
+	uint32_t GetShaderCount() const { return static_cast<uint32_t>(m_Shaders.size()); }
+	const std::wstring& GetShaderName(uint32_t shaderIdx) const { return m_Shaders[shaderIdx].Name; }
+	const std::vector<std::wstring>& GetDependencies(uint32_t shaderIdx) const { return m_Shaders[shaderIdx].Files; }
+
+	// 絶対パスにして.や..を除く。Windowsではファイル名の大文字と小文字を区別しないので小文字にそろえる
+	static std::wstring NormalizePath(const std::wstring& path);
+
+private:
+	struct Shader
+	{
+		std::wstring Name;
+		// NormalizePath()したもの。重複はない
+		std::vector<std::wstring> Files;
+	};
+
+	std::vector<Shader> m_Shaders;
+	// ファイルから、それを使うシェーダのインデックスへの逆引き
+	std::unordered_map<std::wstring, std::vector<uint32_t>> m_FileToShaders;
+
+	ShaderDependencyGraph(const ShaderDependencyGraph&) = delete;
+	void operator=(const ShaderDependencyGraph&) = delete;
+};
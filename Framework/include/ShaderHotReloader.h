@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include "ComPtr.h"
+#include "FileWatcher.h"
+#include "ShaderDependencyGraph.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dxcapi.h>
+
+class ShaderCompiler;
+
+struct ShaderHotReloadStats
+{
+	// AddShader()したシェーダの数と、それらが使うファイルの数
+	uint32_t ShaderCount = 0;
+	uint32_t FileCount = 0;
+	// 監視しているファイルが変わったのを見つけた回数
+	uint32_t ChangeCount = 0;
+	uint32_t RecompileCount = 0;
+	// コンパイルに失敗した回数。失敗したシェーダは前のバイナリのまま
+	uint32_t FailureCount = 0;
+};
+
+struct ReloadedShader
+{
+	// AddShader()が返したインデックス
+	uint32_t ShaderIdx = 0;
+	ComPtr<IDxcBlob> pBlob;
+};
+
+// 実行時にShaderCompilerでコンパイルしたシェーダの、ソースと#includeで辿れる全てのファイルを別スレッドで監視する。
+// どれかが変わったら、それを使うシェーダだけをコンパイルし直して結果をためておく。
+// パイプラインステートはGPUが使っているかもしれないので、ここでは作り直さない。
+// 呼び出し側がフレームの区切りでTakeReloadedShaders()を呼び、GPUの完了を待ってから差し替える。
+// ビルド時にコンパイルした.csoを読み込むシェーダは監視しない。リロードしたいシェーダはShaderCompilerでコンパイルしてAddShader()する
+class ShaderHotReloader
+{
+public:
+	ShaderHotReloader();
+	~ShaderHotReloader();
+
+	// workerIndexはこのクラスだけが使うShaderCompilerのワーカー。ほかのスレッドのCompile()と同時に動く
+	bool Init(ShaderCompiler* pCompiler, uint32_t workerIndex, uint32_t pollIntervalMilliseconds);
+	void Term();
+
+	// ShaderCompiler::Compile()に渡したものと同じパスと引数、返ってきたsourceFilesを渡す。シェーダのインデックスを返す
+	uint32_t AddShader(const wchar_t* filePath, const std::vector<const wchar_t*>& args, const std::vector<std::wstring>& sourceFiles);
+
+	// 前に呼んでからコンパイルし直したシェーダをshadersに移す。同じシェーダが何度かコンパイルし直されていたら最後のものだけを入れる
+	void TakeReloadedShaders(std::vector<ReloadedShader>& shaders);
+
+	ShaderHotReloadStats GetStats() const;
+
+private:
+	struct Shader
+	{
+		std::wstring FilePath;
+		std::vector<std::wstring> Args;
+	};
+
+	ShaderCompiler* m_pCompiler;
+	uint32_t m_WorkerIndex;
+	uint32_t m_PollIntervalMilliseconds;
+	std::thread m_Thread;
+
+	// 以下はm_Mutexで守る
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_TerminateCV;
+	bool m_IsTerminating;
+	std::vector<Shader> m_Shaders;
+	ShaderDependencyGraph m_Graph;
+	FileWatcher m_Watcher;
+	std::vector<ReloadedShader> m_ReloadedShaders;
+	ShaderHotReloadStats m_Stats;
+
+	void Run();
+
+	ShaderHotReloader(const ShaderHotReloader&) = delete;
+	void operator=(const ShaderHotReloader&) = delete;
+};
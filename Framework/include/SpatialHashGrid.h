@@ -0,0 +1,156 @@
+﻿#pragma once
+
+#include <SimpleMath.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "ResMesh.h"
+
+// 一様グリッドのセル座標をハッシュでテーブルのバケットに割り当てる。
+// 空間の範囲を決めずに使えるが、別のセルが同じバケットに入ることがあるので問い合わせ側で距離や包含を判定すること
+class SpatialHash
+{
+public:
+	// tableSizeは2のべき乗に切り上げる
+	void Init(float cellSize, uint32_t tableSize);
+
+	float GetCellSize() const { return m_CellSize; }
+	uint32_t GetTableSize() const { return m_TableMask + 1; }
+
+	int32_t GetCellCoord(float value) const
+	{
+		return static_cast<int32_t>(floorf(value * m_InvCellSize));
+	}
+
+	uint32_t GetBucket(int32_t x, int32_t y, int32_t z) const
+	{
+		uint32_t hash = (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^ (static_cast<uint32_t>(z) * 83492791u);
+		return hash & m_TableMask;
+	}
+
+	uint32_t GetBucket(float x, float y, float z) const
+	{
+		return GetBucket(GetCellCoord(x), GetCellCoord(y), GetCellCoord(z));
+	}
+
+	// [minPos, maxPos]と重なるセルのバケットを重複なしでpBucketsに入れて数を返す。
+	// maxBucketsを超える場合はmaxBuckets + 1を返す
+	uint32_t GatherBuckets(const DirectX::SimpleMath::Vector3& minPos, const DirectX::SimpleMath::Vector3& maxPos, uint32_t maxBuckets, uint32_t* pBuckets) const;
+
+private:
+	float m_CellSize = 1.0f;
+	float m_InvCellSize = 1.0f;
+	uint32_t m_TableMask = 0;
+};
+
+// 点群のハッシュグリッド。
+// Build()でバケットごとの点の範囲を計数ソートで作り、点の座標もバケット順に並べ直して持つ。
+// 半径の問い合わせはconstなので複数スレッドから同時に呼んでよい
+class SpatialHashGrid
+{
+public:
+	// 問い合わせの半径がcellSize / 2以下なら8セル、cellSize以下なら27セルを調べる。
+	// セルを辿るたびにキャッシュミスが起きやすいので、cellSizeは半径の2倍程度がよい。tableSizeは点の数程度が目安
+	void Init(float cellSize, uint32_t tableSize);
+	void Term();
+
+	// 座標はSoAで渡す
+	void Build(uint32_t count, const float* pPositionX, const float* pPositionY, const float* pPositionZ);
+
+	uint32_t GetCount() const { return static_cast<uint32_t>(m_SortedIndices.size()); }
+	const SpatialHash& GetHash() const { return m_Hash; }
+	// バケットbの点はGetSortedIndices()の[GetBucketStarts()[b], GetBucketStarts()[b + 1])
+	const std::vector<uint32_t>& GetBucketStarts() const { return m_BucketStarts; }
+	const std::vector<uint32_t>& GetSortedIndices() const { return m_SortedIndices; }
+	size_t GetMemorySize() const;
+
+	// positionから距離radius以内の点ごとにfunc(点のインデックス, 距離の2乗)を呼ぶ
+	template<typename Func>
+	void ForEachNeighbor(const DirectX::SimpleMath::Vector3& position, float radius, Func&& func) const
+	{
+		static constexpr uint32_t MAX_BUCKETS = 64;
+
+		DirectX::SimpleMath::Vector3 extent(radius, radius, radius);
+		uint32_t buckets[MAX_BUCKETS];
+		uint32_t bucketCount = m_Hash.GatherBuckets(position - extent, position + extent, MAX_BUCKETS, buckets);
+
+		float radiusSq = radius * radius;
+		if (bucketCount > MAX_BUCKETS)
+		{
+			// セルに対して半径が大きすぎるので全点を調べる
+			for (uint32_t i = 0; i < GetCount(); i++)
+			{
+				TestPoint(position, radiusSq, i, func);
+			}
+			return;
+		}
+
+		for (uint32_t b = 0; b < bucketCount; b++)
+		{
+			for (uint32_t i = m_BucketStarts[buckets[b]]; i < m_BucketStarts[buckets[b] + 1]; i++)
+			{
+				TestPoint(position, radiusSq, i, func);
+			}
+		}
+	}
+
+private:
+	SpatialHash m_Hash;
+	// 要素数はテーブルサイズ + 1
+	std::vector<uint32_t> m_BucketStarts;
+	std::vector<uint32_t> m_SortedIndices;
+	// バケット順に並べ直した座標
+	std::vector<float> m_SortedX;
+	std::vector<float> m_SortedY;
+	std::vector<float> m_SortedZ;
+	// 点ごとのバケット。Build()の作業用
+	std::vector<uint32_t> m_PointBuckets;
+
+	template<typename Func>
+	void TestPoint(const DirectX::SimpleMath::Vector3& position, float radiusSq, uint32_t sortedIdx, Func& func) const
+	{
+		float dx = m_SortedX[sortedIdx] - position.x;
+		float dy = m_SortedY[sortedIdx] - position.y;
+		float dz = m_SortedZ[sortedIdx] - position.z;
+		float distanceSq = dx * dx + dy * dy + dz * dz;
+		if (distanceSq <= radiusSq)
+		{
+			func(m_SortedIndices[sortedIdx], distanceSq);
+		}
+	}
+};
+
+// 静的なAABBの集合のハッシュグリッド。AABBは重なる全セルのバケットに登録する
+class AABBHashGrid
+{
+public:
+	// marginだけ広げたAABBで登録するので、半径margin以下の球の問い合わせにも使える
+	bool Build(const std::vector<AABB>& aabbs, float cellSize, uint32_t tableSize, float margin);
+	void Term();
+
+	uint32_t GetAABBCount() const { return static_cast<uint32_t>(m_AABBs.size()); }
+	const AABB& GetAABB(uint32_t idx) const { return m_AABBs[idx]; }
+	float GetMargin() const { return m_Margin; }
+	// 全バケットへの登録数の合計
+	uint32_t GetEntryCount() const { return static_cast<uint32_t>(m_Entries.size()); }
+	size_t GetMemorySize() const;
+
+	// positionを含むセルに登録されたAABBごとにfunc(AABBのインデックス, AABB)を呼ぶ。
+	// 実際にpositionを含むかどうかは呼び出し側で判定すること
+	template<typename Func>
+	void ForEachCandidate(const DirectX::SimpleMath::Vector3& position, Func&& func) const
+	{
+		uint32_t bucket = m_Hash.GetBucket(position.x, position.y, position.z);
+		for (uint32_t i = m_BucketStarts[bucket]; i < m_BucketStarts[bucket + 1]; i++)
+		{
+			func(m_Entries[i], m_AABBs[m_Entries[i]]);
+		}
+	}
+
+private:
+	SpatialHash m_Hash;
+	float m_Margin = 0.0f;
+	std::vector<AABB> m_AABBs;
+	std::vector<uint32_t> m_BucketStarts;
+	std::vector<uint32_t> m_Entries;
+};
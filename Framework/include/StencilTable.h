@@ -0,0 +1,41 @@
+﻿#pragma once
+
+#include <SimpleMath.h>
+#include <cstdint>
+#include <vector>
+
+// 細分割後の頂点をコントロールポイントの重み付き和で表すステンシルのテーブル。
+// 1頂点が1行のCSR形式の疎行列で、Applyはその疎行列とコントロールポイントのベクトルの積になる。
+class StencilTable
+{
+public:
+	StencilTable() = default;
+	~StencilTable() = default;
+
+	void Clear();
+
+	// 1行ずつ末尾に追加する
+	void AddStencil(uint32_t count, const uint32_t* pIndices, const float* pWeights);
+	void Append(const StencilTable& table);
+
+	uint32_t GetStencilCount() const { return static_cast<uint32_t>(m_Offsets.size()) - 1; }
+	uint32_t GetSize(uint32_t row) const { return m_Offsets[row + 1] - m_Offsets[row]; }
+	const uint32_t* GetIndices(uint32_t row) const { return &m_Indices[m_Offsets[row]]; }
+	const float* GetWeights(uint32_t row) const { return &m_Weights[m_Offsets[row]]; }
+
+	// 全行の要素数の合計
+	size_t GetEntryCount() const { return m_Indices.size(); }
+	size_t GetMemorySize() const;
+
+	// pDst[row] = sum(weight * pSrc[index])。全行をワーカースレッドで並列に、DirectXMathのSIMDで評価する
+	void Apply(const DirectX::SimpleMath::Vector3* pSrc, DirectX::SimpleMath::Vector3* pDst) const;
+	void Apply(const DirectX::SimpleMath::Vector2* pSrc, DirectX::SimpleMath::Vector2* pDst) const;
+	// [beginRow, endRow)だけを呼び出しスレッドで評価する
+	void Apply(const DirectX::SimpleMath::Vector3* pSrc, DirectX::SimpleMath::Vector3* pDst, uint32_t beginRow, uint32_t endRow) const;
+	void Apply(const DirectX::SimpleMath::Vector2* pSrc, DirectX::SimpleMath::Vector2* pDst, uint32_t beginRow, uint32_t endRow) const;
+
+private:
+	std::vector<uint32_t> m_Offsets = {0};
+	std::vector<uint32_t> m_Indices;
+	std::vector<float> m_Weights;
+};
@@ -0,0 +1,48 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 境界エッジやこの値以上のシャープネスのエッジは細分割を繰り返しても常にシャープに扱う
+static constexpr float SUBD_INFINITE_SHARPNESS = 10.0f;
+
+struct SubdCrease
+{
+	uint32_t V0;
+	uint32_t V1;
+	// 1レベル細分割するごとに1減る。0でスムース
+	float Sharpness;
+};
+
+// 任意の多角形からなるメッシュのトポロジ。Catmull-Clarkでは細分割レベル1以降は全面が四角形になる
+struct SubdTopology
+{
+	uint32_t VertexCount = 0;
+	std::vector<uint32_t> FaceVertexCounts;
+	std::vector<uint32_t> FaceVertexIndices;
+	std::vector<SubdCrease> Creases;
+};
+
+// 1レベル分の隣接情報。エッジiはFaceVertexIndicesのi番目の頂点から次の頂点へのエッジ
+struct SubdAdjacency
+{
+	std::vector<uint32_t> FaceOffsets;
+	std::vector<uint32_t> FaceEdges;
+	std::vector<uint32_t> EdgeVertices; // エッジごとに2要素
+	std::vector<uint32_t> EdgeFaces; // エッジごとに2要素。3面以上で共有されるエッジは非多様体として先頭2面のみ
+	std::vector<uint32_t> EdgeFaceCounts;
+	std::vector<float> EdgeSharpness;
+	std::vector<uint32_t> VertexEdgeOffsets;
+	std::vector<uint32_t> VertexEdges;
+	std::vector<uint32_t> VertexFaceOffsets;
+	std::vector<uint32_t> VertexFaces;
+
+	uint32_t GetFaceCount() const { return static_cast<uint32_t>(FaceOffsets.size()) - 1; }
+	uint32_t GetEdgeCount() const { return static_cast<uint32_t>(EdgeFaceCounts.size()); }
+	uint32_t GetFaceSize(uint32_t face) const { return FaceOffsets[face + 1] - FaceOffsets[face]; }
+	bool IsBoundaryEdge(uint32_t edge) const { return EdgeFaceCounts[edge] != 2; }
+	bool IsSharpEdge(uint32_t edge) const { return IsBoundaryEdge(edge) || EdgeSharpness[edge] > 0.0f; }
+};
+
+// topologyの隣接情報を作る。インデックスが範囲外、2頂点以下の面があればfalse
+bool BuildAdjacency(const SubdTopology& topology, SubdAdjacency& adjacency);
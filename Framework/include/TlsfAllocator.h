@@ -0,0 +1,105 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct TlsfAllocatorStats
+{
+	// 管理している範囲の大きさ
+	uint64_t Size = 0;
+	// 確保中のブロックの合計。アラインメントのための詰め物も含む
+	uint64_t UsedSize = 0;
+	uint64_t FreeSize = 0;
+	uint64_t LargestFreeBlockSize = 0;
+	uint32_t AllocationCount = 0;
+	uint32_t FreeBlockCount = 0;
+	// 1 - LargestFreeBlockSize / FreeSize。空きが1つのブロックにまとまっていれば0で、細切れになるほど1に近づく
+	float Fragmentation = 0.0f;
+};
+
+// [0, size)の範囲からオフセットを切り出すTwo-Level Segregated Fitのアロケータ。
+// 空きブロックを大きさの2の冪の段(第1レベル)とそれを16等分した段(第2レベル)のリストに分けて持ち、
+// ビットマップで要求以上の大きさの空きがある最小の段を探すので、確保と解放は空きの数によらず定数時間になる。
+// 解放したブロックは前後の空きブロックとすぐに結合する。
+// 範囲の中身は持たず、オフセットだけを扱うのでデバイスがなくても使える。スレッドセーフではない
+class TlsfAllocator
+{
+public:
+	static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+	// ブロックの大きさとオフセットはこの単位に揃える
+	static constexpr uint64_t GRANULARITY = 16;
+
+	struct Allocation
+	{
+		uint64_t Offset = INVALID_OFFSET;
+		// 確保したブロック。Free()でオフセットから探さずに済むように持っておく
+		uint32_t BlockIdx = UINT32_MAX;
+	};
+
+	TlsfAllocator();
+	~TlsfAllocator();
+
+	bool Init(uint64_t size);
+	void Term();
+
+	// alignmentの倍数のオフセットから連続したsizeを確保する。alignmentは2の冪でなくてもよい。
+	// 空きが足りなければOffsetがINVALID_OFFSETになる
+	Allocation Allocate(uint64_t size, uint64_t alignment);
+	// Allocate()が返したものを解放する
+	void Free(const Allocation& allocation);
+
+	// Allocate(size, alignment)に必要な空きブロックの大きさ。この大きさの空きブロックがあれば確保は必ず成功する
+	static uint64_t GetRequiredBlockSize(uint64_t size, uint64_t alignment);
+
+	uint64_t GetSize() const { return m_Size; }
+	uint32_t GetAllocationCount() const { return m_AllocationCount; }
+	// 空きブロックの数と最大の大きさは空きリストを辿って数える
+	TlsfAllocatorStats GetStats() const;
+
+private:
+	static constexpr uint32_t SL_INDEX_COUNT_LOG2 = 4;
+	static constexpr uint32_t SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+	static constexpr uint32_t FL_INDEX_COUNT = 64;
+	static constexpr uint32_t INVALID_BLOCK = UINT32_MAX;
+
+	struct Block
+	{
+		uint64_t Offset;
+		uint64_t Size;
+		// オフセット順に隣り合うブロック
+		uint32_t PrevPhysical;
+		uint32_t NextPhysical;
+		// 同じ段の空きリスト
+		uint32_t PrevFree;
+		uint32_t NextFree;
+		bool IsFree;
+	};
+
+	// ブロックはインデックスで参照し、使わなくなった要素はm_UnusedBlocksで再利用する
+	std::vector<Block> m_Blocks;
+	std::vector<uint32_t> m_UnusedBlocks;
+
+	uint64_t m_FlBitmap;
+	uint32_t m_SlBitmaps[FL_INDEX_COUNT];
+	uint32_t m_FreeLists[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+	uint64_t m_Size;
+	uint64_t m_UsedSize;
+	uint32_t m_AllocationCount;
+
+	static void Mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+	// size以上の空きブロックを返す。なければINVALID_BLOCK
+	uint32_t FindFreeBlock(uint64_t size) const;
+
+	uint32_t CreateBlock(uint64_t offset, uint64_t size, uint32_t prevPhysical, uint32_t nextPhysical);
+	void DestroyBlock(uint32_t blockIdx);
+	void InsertFreeBlock(uint32_t blockIdx);
+	void RemoveFreeBlock(uint32_t blockIdx);
+	// blockIdxの先頭からsizeを残し、残りを後ろの空きブロックにしてそのインデックスを返す。空きリストには入れない
+	uint32_t SplitBlock(uint32_t blockIdx, uint64_t size);
+	// blockIdxを後ろのブロックと結合する。後ろのブロックは空きリストから外しておく
+	void MergeWithNext(uint32_t blockIdx);
+
+	TlsfAllocator(const TlsfAllocator&) = delete;
+	void operator=(const TlsfAllocator&) = delete;
+};
@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include <SimpleMath.h>
+#include <cstdint>
+#include <vector>
+#include "Bvh.h"
+
+struct TriangleHit
+{
+	float T;
+	// 重心座標。交点はV0 * (1 - U - V) + V1 * U + V2 * V
+	float U;
+	float V;
+	uint32_t MeshIdx;
+	// MeshIdxのメッシュの中ではなく、Build()に渡した全三角形の中でのインデックス
+	uint32_t TriangleIdx;
+};
+
+// 三角形のBVH。三角形は葉の順に並べ直し、交差判定に使うV0と2辺の形で持つ
+class TriangleBvh
+{
+public:
+	// positionsは三角形ごとに3頂点ずつ。meshIndicesは三角形ごとのメッシュのインデックス
+	bool Build(const std::vector<DirectX::SimpleMath::Vector3>& positions, const std::vector<uint32_t>& meshIndices, const BvhBuildSettings& settings);
+	void Term();
+
+	uint32_t GetTriangleCount() const { return static_cast<uint32_t>(m_Triangles.size()); }
+	const Bvh& GetBvh() const { return m_Bvh; }
+	size_t GetMemorySize() const { return m_Bvh.GetMemorySize() + m_Triangles.size() * sizeof(Triangle); }
+
+	// [0, tMax]で最も近い交差を返す。裏面とも交差する
+	bool Intersect(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& direction, float tMax, TriangleHit& hit) const;
+	// [0, tMax]で何かと交差するか。シャドウレイ用
+	bool IsOccluded(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& direction, float tMax) const;
+
+	// 全三角形と総当たりで交差を調べる。検証用
+	bool IntersectBruteForce(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& direction, float tMax, TriangleHit& hit) const;
+
+	// positionsの三角形ごとのAABBを求める。Bvh::Build()に渡す形
+	static void ComputeBounds(const std::vector<DirectX::SimpleMath::Vector3>& positions, std::vector<BvhPrimitiveBounds>& bounds);
+
+private:
+	struct Triangle
+	{
+		DirectX::SimpleMath::Vector3 V0;
+		DirectX::SimpleMath::Vector3 Edge1;
+		DirectX::SimpleMath::Vector3 Edge2;
+		uint32_t MeshIdx;
+		uint32_t TriangleIdx;
+	};
+
+	Bvh m_Bvh;
+	// Bvhの葉の順
+	std::vector<Triangle> m_Triangles;
+
+	// Möller-Trumboreの交差判定。[0, tMax)で交差したらtMaxとhitを更新する
+	static bool IntersectTriangle(const Triangle& triangle, const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& direction, float& tMax, TriangleHit& hit);
+};
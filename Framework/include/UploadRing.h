@@ -0,0 +1,93 @@
+﻿#pragma once
+
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+#include "ComPtr.h"
+#include "CommandList.h"
+#include "RingAllocator.h"
+
+class Fence;
+
+struct UploadRingStats
+{
+	// Upload()の回数
+	uint32_t UploadCount = 0;
+	// アップロードした量の合計
+	uint64_t UploadSize = 0;
+	// アップロードごとにコミットされたUPLOADヒープのバッファを作って持ち続けた場合のメモリ量。
+	// バッファは64KB単位で確保されるので、その単位に切り上げて合計する
+	uint64_t CommittedEquivalentSize = 0;
+	// リングで返却されていない量の最大値
+	uint64_t PeakUsedSize = 0;
+	// リングが足りずにリングのコマンドリストを実行して待った回数
+	uint32_t FlushCount = 0;
+};
+
+// 全てのResourceで共有するアップロード用のリングバッファ。
+// UPLOADヒープのバッファを1つだけ作ってMapしたままにし、RingAllocatorで切り出した範囲にデータを書いて、
+// リングが持つコマンドリストにコピーを記録する。アプリのコマンドリストには何も記録しないので、記録中の状態は失われない。
+// コピーはSubmit()で実行するので、コピー先を読むコマンドリストを実行する前に呼ぶこと。
+// コピー先のバッファはExecuteCommandLists()の終わりにCOMMONに戻り、コピーで暗黙にCOPY_DESTになるので、バリアは記録しない。
+// 大きなデータは容量の1/4以下のチャンクに分けてコピーし、リングが足りなくなったらリングのコマンドリストだけを実行して
+// 完了を待ち、返却してから記録し直す
+class UploadRing
+{
+public:
+	UploadRing();
+	~UploadRing();
+
+	// pFenceはアプリのものを使い、Submit()ごとにシグナルする。
+	// maxFrameCountはEndFrame()してからRetire()されるまでのフレームの数の上限
+	bool Init
+	(
+		ID3D12Device* pDevice,
+		ID3D12CommandQueue* pQueue,
+		Fence* pFence,
+		uint64_t capacity,
+		uint32_t maxFrameCount
+	);
+
+	void Term();
+
+	// pDstのdstOffsetの位置へのコピーをリングのコマンドリストに記録する。pDstはバッファで、Submit()するまで読まないこと
+	bool Upload
+	(
+		ID3D12Resource* pDst,
+		uint64_t dstOffset,
+		uint64_t size,
+		const void* pData
+	);
+
+	// 記録したコピーがあればリングのコマンドリストを閉じて実行する。記録していなければ何もしない
+	bool Submit();
+
+	// ここまでのアップロードを、fenceValueのフェンスが完了したら返却するフレームとして区切る。Submit()してから呼ぶ
+	bool EndFrame(uint64_t fenceValue);
+	// completedFenceValue以下のフェンスのフレームの分を返却する
+	void Retire(uint64_t completedFenceValue);
+
+	uint64_t GetCapacity() const;
+	const UploadRingStats& GetStats() const;
+
+private:
+	ComPtr<ID3D12Resource> m_pBuffer;
+	uint8_t* m_pMappedData;
+	RingAllocator m_Allocator;
+	uint64_t m_MaxChunkSize;
+	ID3D12CommandQueue* m_pQueue;
+	Fence* m_pFence;
+	CommandList m_CommandList;
+	// コマンドアロケータごとの、最後に使ったコマンドリストのフェンスの値。CommandList::Reset()と同じ順に使う
+	std::vector<uint64_t> m_AllocatorFenceValues;
+	uint32_t m_AllocatorIndex;
+	bool m_IsRecording;
+	UploadRingStats m_Stats;
+
+	bool BeginRecording();
+	uint64_t Execute();
+	bool Flush();
+
+	UploadRing(const UploadRing&) = delete;
+	void operator=(const UploadRing&) = delete;
+};
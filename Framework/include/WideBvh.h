@@ -0,0 +1,115 @@
+﻿#pragma once
+
+#include <SimpleMath.h>
+#include <cstdint>
+#include <vector>
+#include "Bvh.h"
+#include "TriangleBvh.h"
+
+// 子がWidth個あるBVHのノード。子のAABBは軸ごとのSoAで持ち、1本の光線とWidth個のAABBの交差を1回のSIMD演算で調べる。
+// 空きの子はChildrenをUINT32_MAXにし、AABBを反転させてどの光線とも交差しないようにする
+template<uint32_t Width>
+struct alignas(32) WideBvhNode
+{
+	float BoundsMinX[Width];
+	float BoundsMinY[Width];
+	float BoundsMinZ[Width];
+	float BoundsMaxX[Width];
+	float BoundsMaxY[Width];
+	float BoundsMaxZ[Width];
+	// 内部ノードの子ならノードのインデックス、葉の子なら最初の三角形パケットのインデックス
+	uint32_t Children[Width];
+	// 葉の子なら三角形パケットの数。内部ノードの子と空きは0
+	uint32_t PacketCounts[Width];
+};
+
+// Width個の三角形をSoAで持ち、1本の光線とWidth個の三角形の交差を1回のSIMD演算で調べる。
+// 余ったレーンは辺を0にして交差しないようにし、MeshIndicesをUINT32_MAXにする
+template<uint32_t Width>
+struct alignas(32) WideTrianglePacket
+{
+	float V0X[Width];
+	float V0Y[Width];
+	float V0Z[Width];
+	float Edge1X[Width];
+	float Edge1Y[Width];
+	float Edge1Z[Width];
+	float Edge2X[Width];
+	float Edge2Y[Width];
+	float Edge2Z[Width];
+	uint32_t MeshIndices[Width];
+	uint32_t TriangleIndices[Width];
+};
+
+struct WideBvhBuildStats
+{
+	// 元にする2分木のBVHの構築と、それを畳み込んでWidth分木にする時間
+	double BinaryBuildMilliseconds = 0.0;
+	double CollapseMilliseconds = 0.0;
+	uint32_t NodeCount = 0;
+	uint32_t LeafCount = 0;
+	uint32_t PacketCount = 0;
+	uint32_t MaxDepth = 0;
+	// ノードあたりの空きでない子の数の平均
+	float AverageChildCount = 0.0f;
+	// 三角形パケットのレーンのうち三角形が入っている割合
+	float PacketOccupancy = 0.0f;
+};
+
+// 2分木のBvhを、表面積の大きい子から順に開いてWidth分木に畳み込んだBVH。
+// Width == 4はSSE2、Width == 8はAVX2でノードのAABBと葉の三角形パケットを調べる。
+// AVX2が使えないCPUではWidth == 8でもレーンごとのループで同じ結果を返す。
+// 1本ずつの光線のほかに、Width本の光線をまとめて辿るパケットの探索も持つ
+template<uint32_t Width>
+class WideBvh
+{
+	static_assert(Width == 4 || Width == 8, "WideBvh supports only 4 or 8 children.");
+
+public:
+	// positionsは三角形ごとに3頂点ずつ。meshIndicesは三角形ごとのメッシュのインデックス。
+	// 2分木の三角形がWidth個以下の部分木は、まとめて1つのパケットにする
+	bool Build(const std::vector<DirectX::SimpleMath::Vector3>& positions, const std::vector<uint32_t>& meshIndices, const BvhBuildSettings& settings);
+	void Term();
+
+	uint32_t GetTriangleCount() const { return m_TriangleCount; }
+	const std::vector<WideBvhNode<Width>>& GetNodes() const { return m_Nodes; }
+	const WideBvhBuildStats& GetBuildStats() const { return m_BuildStats; }
+	size_t GetMemorySize() const { return m_Nodes.size() * sizeof(WideBvhNode<Width>) + m_Packets.size() * sizeof(WideTrianglePacket<Width>); }
+	// falseならSIMDを使わずレーンごとのループで調べる
+	bool IsSIMDEnabled() const { return m_UseSIMD; }
+
+	// [0, tMax]で最も近い交差を返す。裏面とも交差する
+	bool Intersect(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& direction, float tMax, TriangleHit& hit) const;
+	// [0, tMax]で何かと交差するか。シャドウレイ用
+	bool IsOccluded(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& direction, float tMax) const;
+
+	// rayCount本(Width以下)の光線をまとめて辿り、光線ごとの最も近い交差を返す。
+	// どれかの光線が交差する子はすべての光線で調べるので、カメラからの隣り合うピクセルのように向きの揃った光線に向く。
+	// 交差した光線のビットを立てて返し、pHitsはビットの立った光線の分だけ書き込む
+	uint32_t IntersectPacket
+	(
+		const DirectX::SimpleMath::Vector3* pOrigins,
+		const DirectX::SimpleMath::Vector3* pDirections,
+		const float* pTMax,
+		uint32_t rayCount,
+		TriangleHit* pHits
+	) const;
+
+private:
+	std::vector<WideBvhNode<Width>> m_Nodes;
+	// Bvhの葉の順
+	std::vector<WideTrianglePacket<Width>> m_Packets;
+	uint32_t m_TriangleCount = 0;
+	WideBvhBuildStats m_BuildStats;
+	bool m_UseSIMD = false;
+
+	struct CollapseContext;
+
+	// 2分木のノードbinaryIdxを根とする部分木を畳み込み、作ったノードのインデックスを返す
+	uint32_t Collapse(const CollapseContext& context, uint32_t binaryIdx, uint32_t depth);
+	// 2分木の部分木の三角形をパケットに詰め、最初のパケットのインデックスを返す
+	uint32_t AddLeafPackets(const CollapseContext& context, uint32_t binaryIdx);
+};
+
+using Bvh4 = WideBvh<4>;
+using Bvh8 = WideBvh<8>;
@@ -0,0 +1,151 @@
+﻿#include "AliasingPlanner.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	uint64_t RoundUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+AliasingPlanner::AliasingPlanner()
+{
+}
+
+AliasingPlanner::~AliasingPlanner()
+{
+	Reset();
+}
+
+void AliasingPlanner::Reset()
+{
+	m_Resources.clear();
+	m_Slots.clear();
+	m_SortedResources.clear();
+	m_Stats = AliasingPlanStats();
+}
+
+uint32_t AliasingPlanner::AddResource(uint64_t size, uint64_t alignment, uint32_t firstPass, uint32_t lastPass)
+{
+	if (size == 0 || alignment == 0 || firstPass > lastPass)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return UINT32_MAX;
+	}
+
+	m_Resources.push_back({size, alignment, firstPass, lastPass, UINT32_MAX, INVALID_OFFSET});
+	return static_cast<uint32_t>(m_Resources.size() - 1);
+}
+
+void AliasingPlanner::Plan()
+{
+	m_Stats = AliasingPlanStats();
+	m_Stats.ResourceCount = static_cast<uint32_t>(m_Resources.size());
+
+	m_SortedResources.clear();
+	for (uint32_t resourceIdx = 0; resourceIdx < m_Resources.size(); resourceIdx++)
+	{
+		m_Stats.TotalSize += m_Resources[resourceIdx].Size;
+		m_SortedResources.push_back(resourceIdx);
+	}
+
+	// 寿命の区間グラフの彩色。開始の早い順に、空いている区画(最後に使うパスが開始より前のもの)に入れていけば、
+	// 区画の数は同時に生きている数の最大値になる。空いている区画のうちは足りる中で最小のものを選び、
+	// 足りるものがなければ最大のものを広げる
+	std::sort(m_SortedResources.begin(), m_SortedResources.end(), [this](uint32_t a, uint32_t b)
+	{
+		const Resource& resourceA = m_Resources[a];
+		const Resource& resourceB = m_Resources[b];
+		if (resourceA.FirstPass != resourceB.FirstPass)
+		{
+			return resourceA.FirstPass < resourceB.FirstPass;
+		}
+		if (resourceA.Size != resourceB.Size)
+		{
+			return resourceA.Size > resourceB.Size;
+		}
+		return a < b;
+	});
+
+	m_Slots.clear();
+	for (uint32_t resourceIdx : m_SortedResources)
+	{
+		Resource& resource = m_Resources[resourceIdx];
+
+		uint32_t fitIdx = UINT32_MAX;
+		uint32_t largestIdx = UINT32_MAX;
+		for (uint32_t slotIdx = 0; slotIdx < m_Slots.size(); slotIdx++)
+		{
+			const Slot& slot = m_Slots[slotIdx];
+			if (slot.LastPass >= resource.FirstPass)
+			{
+				continue;
+			}
+
+			if (slot.Size >= resource.Size && (fitIdx == UINT32_MAX || slot.Size < m_Slots[fitIdx].Size))
+			{
+				fitIdx = slotIdx;
+			}
+			if (largestIdx == UINT32_MAX || slot.Size > m_Slots[largestIdx].Size)
+			{
+				largestIdx = slotIdx;
+			}
+		}
+
+		uint32_t slotIdx = (fitIdx != UINT32_MAX) ? fitIdx : largestIdx;
+		if (slotIdx == UINT32_MAX)
+		{
+			slotIdx = static_cast<uint32_t>(m_Slots.size());
+			m_Slots.push_back({resource.Size, resource.Alignment, 0, resource.LastPass});
+		}
+		else
+		{
+			Slot& slot = m_Slots[slotIdx];
+			slot.Size = std::max(slot.Size, resource.Size);
+			slot.Alignment = std::max(slot.Alignment, resource.Alignment);
+			slot.LastPass = resource.LastPass;
+		}
+
+		resource.SlotIdx = slotIdx;
+	}
+
+	uint64_t offset = 0;
+	for (Slot& slot : m_Slots)
+	{
+		offset = RoundUp(offset, slot.Alignment);
+		slot.Offset = offset;
+		offset += slot.Size;
+	}
+
+	for (Resource& resource : m_Resources)
+	{
+		resource.Offset = m_Slots[resource.SlotIdx].Offset;
+	}
+
+	m_Stats.SlotCount = static_cast<uint32_t>(m_Slots.size());
+	m_Stats.AliasedSize = offset;
+
+#if defined(DEBUG) || defined(_DEBUG)
+	// 寿命の重なるリソースはメモリも重ならない
+	for (size_t i = 0; i < m_Resources.size(); i++)
+	{
+		const Resource& resourceA = m_Resources[i];
+		for (size_t j = i + 1; j < m_Resources.size(); j++)
+		{
+			const Resource& resourceB = m_Resources[j];
+			bool isLifetimeOverlapped = (resourceA.FirstPass <= resourceB.LastPass && resourceB.FirstPass <= resourceA.LastPass);
+			bool isMemoryOverlapped = (resourceA.Offset < resourceB.Offset + resourceB.Size && resourceB.Offset < resourceA.Offset + resourceA.Size);
+			assert(!(isLifetimeOverlapped && isMemoryOverlapped));
+		}
+	}
+#endif
+}
+
+uint64_t AliasingPlanner::GetOffset(uint32_t resourceIdx) const
+{
+	assert(resourceIdx < m_Resources.size());
+	return m_Resources[resourceIdx].Offset;
+}
@@ -1,5 +1,7 @@
 #include "App.h"
 #include "FileUtil.h"
+#include "Logger.h"
+#include "Resource.h"
 #include <cassert>
 #include <algorithm>
 #include <pix3.h>
@@ -8,6 +10,12 @@ namespace
 {
 	const auto WindowClassName = TEXT("SampleWindowClass");
 
+	// VF[_猩CBV/SRV/UAṼq[v̂At[Ƃ̈ꎞIȃfBXNv^Ɏg
+	static constexpr uint32_t TRANSIENT_DESCRIPTOR_COUNT = 256;
+
+	// Resource::UploadBufferData()ŋLAbv[hp̃O̗eʁB𒴂镪̓`Nɕđ҂ȂRs[
+	static constexpr uint64_t UPLOAD_RING_SIZE = 16 * 1024 * 1024;
+
 	inline int ComputeIntersectionArea(
 		int ax1, int ay1,
 		int ax2, int ay2,
@@ -70,6 +78,9 @@ bool App::InitApp()
 
 void App::TermApp()
 {
+	// OnTerm()Ń\[XOɁAGPUs̃t[Sđ҂
+	m_Fence.Sync(m_pQueue.Get());
+
 	OnTerm();
 
 	TermD3D();
@@ -271,16 +282,18 @@ bool App::InitD3D()
 
 		desc.NodeMask = 1;
 		desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-		desc.NumDescriptors = 512;
+		desc.NumDescriptors = 512 + TRANSIENT_DESCRIPTOR_COUNT;
 		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-		if (!DescriptorPool::Create(m_pDevice.Get(), &desc, &m_pPool[POOL_TYPE_RES_GPU_VISIBLE]))
+		// Present()Ńt[؂Ãt[̎ŌɎgt[̃tFX҂ĕԋp̂ŁA
+		// ԋp҂͍őFRAME_COUNTt[
+		if (!DescriptorPool::Create(m_pDevice.Get(), &desc, TRANSIENT_DESCRIPTOR_COUNT, FRAME_COUNT, &m_pPool[POOL_TYPE_RES_GPU_VISIBLE]))
 		{
 			return false;
 		}
 
 		desc.NumDescriptors = 256;
 		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-		if (!DescriptorPool::Create(m_pDevice.Get(), &desc, &m_pPool[POOL_TYPE_RES_CPU_VISIBLE]))
+		if (!DescriptorPool::Create(m_pDevice.Get(), &desc, 0, 0, &m_pPool[POOL_TYPE_RES_CPU_VISIBLE]))
 		{
 			return false;
 		}
@@ -288,7 +301,7 @@ bool App::InitD3D()
 		desc.NumDescriptors = 128;
 		desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
 		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-		if (!DescriptorPool::Create(m_pDevice.Get(), &desc, &m_pPool[POOL_TYPE_SMP]))
+		if (!DescriptorPool::Create(m_pDevice.Get(), &desc, 0, 0, &m_pPool[POOL_TYPE_SMP]))
 		{
 			return false;
 		}
@@ -296,7 +309,7 @@ bool App::InitD3D()
 		desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
 		desc.NumDescriptors = 256;
 		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-		if (!DescriptorPool::Create(m_pDevice.Get(), &desc, &m_pPool[POOL_TYPE_RTV]))
+		if (!DescriptorPool::Create(m_pDevice.Get(), &desc, 0, 0, &m_pPool[POOL_TYPE_RTV]))
 		{
 			return false;
 		}
@@ -304,7 +317,7 @@ bool App::InitD3D()
 		desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
 		desc.NumDescriptors = 128;
 		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-		if (!DescriptorPool::Create(m_pDevice.Get(), &desc, &m_pPool[POOL_TYPE_DSV]))
+		if (!DescriptorPool::Create(m_pDevice.Get(), &desc, 0, 0, &m_pPool[POOL_TYPE_DSV]))
 		{
 			return false;
 		}
@@ -337,6 +350,25 @@ bool App::InitD3D()
 		}
 	}
 
+	// Create frame pacer.
+	{
+		if (!m_FramePacer.Init(FRAME_COUNT))
+		{
+			return false;
+		}
+	}
+
+	// Create upload ring.
+	{
+		// Present()ŋ؂t[ɉāAOȂȂƂɋ؂t[1
+		if (!m_UploadRing.Init(m_pDevice.Get(), m_pQueue.Get(), &m_Fence, UPLOAD_RING_SIZE, FRAME_COUNT + 1))
+		{
+			return false;
+		}
+
+		Resource::SetUploadRing(&m_UploadRing);
+	}
+
 	// Viewport settings.
 	{
 		m_Viewport.TopLeftX = 0;
@@ -370,6 +402,10 @@ void App::TermD3D()
 	// Wait command queue finishing.
 	m_Fence.Sync(m_pQueue.Get());
 
+	Resource::SetUploadRing(nullptr);
+	m_UploadRing.Term();
+
+	m_FramePacer.Term();
 	m_Fence.Term();
 
 	for (uint32_t i = 0u; i < FRAME_COUNT; ++i)
@@ -509,10 +545,37 @@ void App::Present(uint32_t interval)
 {
 	m_pSwapChain->Present(interval, 0);
 
-	// Wait command queue finishing.
-	m_Fence.Wait(m_pQueue.Get(), INFINITE);
+	// ŌExecuteCommandLists()̌ɋL^Abv[hÃt[̃tFXOɎsĂ
+	if (!m_UploadRing.Submit())
+	{
+		ELOG("Error : UploadRing::Submit() Failed.");
+	}
+
+	// ̃t[̈ꎞIȃfBXNv^́AɃVOitFX̒lŕԋp
+	if (!m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->EndTransientFrame(m_Fence.GetNextValue()))
+	{
+		ELOG("Error : DescriptorPool::EndTransientFrame() Failed.");
+	}
+	if (!m_UploadRing.EndFrame(m_Fence.GetNextValue()))
+	{
+		ELOG("Error : UploadRing::EndFrame() Failed.");
+	}
+
+	// GPŮ͑҂Ɏ̃t[̋L^ɐi
+	m_FramePacer.EndFrame(m_FrameIndex, m_Fence.Signal(m_pQueue.Get()));
 
 	m_FrameIndex = m_pSwapChain->GetCurrentBackBufferIndex();
+
+	// ̃t[̃obNobt@ƒ萔obt@ŌɎgAFRAME_COUNTt[Õt[҂B
+	// R}hAP[^CommandList::Reset()ƂɏɎg񂵁AłReset()
+	// GPUSđ҂ĂŝŁAReset()ŎgAP[^ő҂t[Ô̂ɂȂ
+	m_FramePacer.BeginFrame(m_FrameIndex, m_Fence.GetCompletedValue(), [this](uint64_t fenceValue)
+	{
+		m_Fence.WaitForValue(fenceValue, INFINITE);
+	});
+
+	m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->RetireTransientFrames(m_Fence.GetCompletedValue());
+	m_UploadRing.Retire(m_Fence.GetCompletedValue());
 }
 
 bool App::IsSupportHDR() const
@@ -634,6 +697,8 @@ LRESULT CALLBACK App::WndProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp)
 			{
 				// obNobt@̃_[^[Qbg蒼̂ŃR}hXgI܂ő҂
 				instance->m_Fence.Sync(instance->m_pQueue.Get());
+				// 蒼̃obNobt@̃CfbNX͑Õt[ƑΉȂASđ҂̂ŖYĂ悢
+				instance->m_FramePacer.Reset();
 
 				for (uint32_t i = 0u; i < FRAME_COUNT; ++i)
 				{
@@ -0,0 +1,235 @@
+﻿#include "BufferSuballocator.h"
+#include "UploadRing.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	uint64_t GetCommittedSize(uint64_t size)
+	{
+		return (size + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) / D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT * D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	}
+}
+
+BufferSuballocator::BufferSuballocator()
+: m_pDevice(nullptr)
+, m_PageSize(0)
+, m_Flags(D3D12_RESOURCE_FLAG_NONE)
+, m_CommittedEquivalentSize(0)
+{
+}
+
+BufferSuballocator::~BufferSuballocator()
+{
+	Term();
+}
+
+bool BufferSuballocator::Init(ID3D12Device* pDevice, uint64_t pageSize, D3D12_RESOURCE_FLAGS flags, LPCWSTR name)
+{
+	Term();
+
+	if (pDevice == nullptr || pageSize < TlsfAllocator::GRANULARITY)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return false;
+	}
+
+	m_pDevice = pDevice;
+	m_PageSize = GetCommittedSize(pageSize);
+	m_Flags = flags;
+	m_Name = (name != nullptr) ? name : L"BufferSuballocatorPage";
+	return true;
+}
+
+void BufferSuballocator::Term()
+{
+	m_Pages.clear();
+	m_Pages.shrink_to_fit();
+	m_pDevice.Reset();
+	m_PageSize = 0;
+	m_CommittedEquivalentSize = 0;
+}
+
+bool BufferSuballocator::Allocate(uint64_t size, uint64_t alignment, BufferAllocation& allocation)
+{
+	if (size == 0 || alignment == 0)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return false;
+	}
+
+	TlsfAllocator::Allocation pageAllocation;
+	uint32_t pageIdx = 0;
+	for (; pageIdx < m_Pages.size(); pageIdx++)
+	{
+		pageAllocation = m_Pages[pageIdx].pAllocator->Allocate(size, alignment);
+		if (pageAllocation.Offset != TlsfAllocator::INVALID_OFFSET)
+		{
+			break;
+		}
+	}
+
+	if (pageAllocation.Offset == TlsfAllocator::INVALID_OFFSET)
+	{
+		// アラインメントの詰め物が入っても収まる大きさのページを足す
+		if (!AddPage(std::max(m_PageSize, GetCommittedSize(TlsfAllocator::GetRequiredBlockSize(size, alignment)))))
+		{
+			ELOG("Error : BufferSuballocator::AddPage() Failed.");
+			return false;
+		}
+
+		pageIdx = static_cast<uint32_t>(m_Pages.size() - 1);
+		pageAllocation = m_Pages[pageIdx].pAllocator->Allocate(size, alignment);
+		if (pageAllocation.Offset == TlsfAllocator::INVALID_OFFSET)
+		{
+			ELOG("Error : TlsfAllocator::Allocate() Failed. size = %llu", static_cast<unsigned long long>(size));
+			return false;
+		}
+	}
+
+	allocation.pResource = m_Pages[pageIdx].pResource.Get();
+	allocation.Offset = pageAllocation.Offset;
+	allocation.Size = size;
+	allocation.PageIdx = pageIdx;
+	allocation.BlockIdx = pageAllocation.BlockIdx;
+
+	m_CommittedEquivalentSize += GetCommittedSize(size);
+	return true;
+}
+
+void BufferSuballocator::Free(const BufferAllocation& allocation)
+{
+	if (allocation.PageIdx >= m_Pages.size())
+	{
+		ELOG("Error : Invalid Page. pageIdx = %u", allocation.PageIdx);
+		return;
+	}
+
+	assert(allocation.pResource == m_Pages[allocation.PageIdx].pResource.Get());
+	m_Pages[allocation.PageIdx].pAllocator->Free({allocation.Offset, allocation.BlockIdx});
+	m_CommittedEquivalentSize -= GetCommittedSize(allocation.Size);
+}
+
+bool BufferSuballocator::Upload(UploadRing* pUploadRing, const BufferAllocation& allocation, uint64_t size, const void* pData)
+{
+	if (pUploadRing == nullptr || size > allocation.Size)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return false;
+	}
+
+	if (allocation.PageIdx >= m_Pages.size())
+	{
+		ELOG("Error : Invalid Page. pageIdx = %u", allocation.PageIdx);
+		return false;
+	}
+
+	assert(allocation.pResource == m_Pages[allocation.PageIdx].pResource.Get());
+	if (!pUploadRing->Upload(allocation.pResource, allocation.Offset, size, pData))
+	{
+		ELOG("Error : UploadRing::Upload() Failed.");
+		return false;
+	}
+
+	return true;
+}
+
+BufferSuballocatorStats BufferSuballocator::GetStats() const
+{
+	BufferSuballocatorStats stats;
+	stats.PageCount = static_cast<uint32_t>(m_Pages.size());
+	stats.CommittedEquivalentSize = m_CommittedEquivalentSize;
+
+	uint64_t freeSize = 0;
+	for (const Page& page : m_Pages)
+	{
+		const TlsfAllocatorStats& pageStats = page.pAllocator->GetStats();
+		stats.PageSize += pageStats.Size;
+		stats.UsedSize += pageStats.UsedSize;
+		stats.LargestFreeBlockSize = std::max(stats.LargestFreeBlockSize, pageStats.LargestFreeBlockSize);
+		stats.AllocationCount += pageStats.AllocationCount;
+		stats.FreeBlockCount += pageStats.FreeBlockCount;
+		freeSize += pageStats.FreeSize;
+	}
+
+	if (freeSize > 0)
+	{
+		stats.Fragmentation = 1.0f - static_cast<float>(static_cast<double>(stats.LargestFreeBlockSize) / static_cast<double>(freeSize));
+	}
+
+	return stats;
+}
+
+D3D12_SHADER_RESOURCE_VIEW_DESC BufferSuballocator::GetStructuredBufferSRVDesc(const BufferAllocation& allocation, uint32_t stride)
+{
+	assert(stride > 0);
+	assert(allocation.Offset % stride == 0);
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Buffer.FirstElement = allocation.Offset / stride;
+	srvDesc.Buffer.NumElements = static_cast<UINT>(allocation.Size / stride);
+	srvDesc.Buffer.StructureByteStride = stride;
+	srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+	return srvDesc;
+}
+
+bool BufferSuballocator::AddPage(uint64_t size)
+{
+	if (m_pDevice == nullptr)
+	{
+		ELOG("Error : BufferSuballocator is not initialized.");
+		return false;
+	}
+
+	D3D12_HEAP_PROPERTIES heapProp = {};
+	heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+	heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	heapProp.CreationNodeMask = 1;
+	heapProp.VisibleNodeMask = 1;
+
+	D3D12_RESOURCE_DESC desc = {};
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	desc.Alignment = 0;
+	desc.Width = size;
+	desc.Height = 1;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = 1;
+	desc.Format = DXGI_FORMAT_UNKNOWN;
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	desc.Flags = m_Flags;
+
+	Page page;
+	HRESULT hr = m_pDevice->CreateCommittedResource
+	(
+		&heapProp,
+		D3D12_HEAP_FLAG_NONE,
+		&desc,
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(page.pResource.GetAddressOf())
+	);
+	if (FAILED(hr))
+	{
+		ELOG("Error : ID3D12Device::CreateCommittedResource() Failed. retcode = 0x%x", hr);
+		return false;
+	}
+
+	page.pResource->SetName(m_Name.c_str());
+
+	page.pAllocator = std::make_unique<TlsfAllocator>();
+	if (!page.pAllocator->Init(size))
+	{
+		ELOG("Error : TlsfAllocator::Init() Failed.");
+		return false;
+	}
+
+	m_Pages.emplace_back(std::move(page));
+	return true;
+}
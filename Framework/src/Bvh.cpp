@@ -0,0 +1,670 @@
+﻿#include "Bvh.h"
+#include "ParallelFor.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+	static constexpr uint32_t MAX_BIN_COUNT = 32;
+	// これより多いプリミティブのノードは、重心の範囲とビンの集計をParallelForで並列に行う
+	static constexpr uint32_t PARALLEL_BINNING_THRESHOLD = 65536;
+	static constexpr uint32_t BINNING_GRAIN_SIZE = 16384;
+	// 部分木の数がスレッド数のこの倍数になるまでは、上から順に分割してから部分木をスレッドに割り当てる
+	static constexpr uint32_t SUBTREES_PER_THREAD = 8;
+	// これより少ないプリミティブの部分木はそれ以上分けずに1スレッドで構築する
+	static constexpr uint32_t MIN_TASK_PRIM_COUNT = 4096;
+
+	struct Bounds
+	{
+		float Min[3];
+		float Max[3];
+
+		void Reset()
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				Min[axis] = FLT_MAX;
+				Max[axis] = -FLT_MAX;
+			}
+		}
+
+		void Grow(const float point[3])
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				Min[axis] = std::min(Min[axis], point[axis]);
+				Max[axis] = std::max(Max[axis], point[axis]);
+			}
+		}
+
+		void Grow(const Bounds& bounds)
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				Min[axis] = std::min(Min[axis], bounds.Min[axis]);
+				Max[axis] = std::max(Max[axis], bounds.Max[axis]);
+			}
+		}
+
+		// 表面積の半分。SAHでは比しか使わないので半分で十分
+		float GetHalfArea() const
+		{
+			float extent[3];
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				extent[axis] = std::max(Max[axis] - Min[axis], 0.0f);
+			}
+			return extent[0] * extent[1] + extent[1] * extent[2] + extent[2] * extent[0];
+		}
+	};
+
+	// 分割中に並べ替えるプリミティブの参照。AABBを一緒に持って、分割のたびにメモリを連続で読めるようにする
+	struct PrimRef
+	{
+		Bounds PrimBounds;
+		uint32_t PrimIdx;
+		uint32_t Padding;
+
+		float GetCentroid(uint32_t axis) const
+		{
+			return (PrimBounds.Min[axis] + PrimBounds.Max[axis]) * 0.5f;
+		}
+	};
+
+	static_assert(sizeof(PrimRef) == 32);
+
+	struct Bin
+	{
+		Bounds PrimBounds;
+		uint32_t Count;
+	};
+
+	// 3軸分のビン
+	struct BinSet
+	{
+		Bin Bins[3][MAX_BIN_COUNT];
+
+		void Reset(uint32_t binCount)
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				for (uint32_t b = 0; b < binCount; b++)
+				{
+					Bins[axis][b].PrimBounds.Reset();
+					Bins[axis][b].Count = 0;
+				}
+			}
+		}
+	};
+
+	// 構築中の部分木。ノードのBoundsは設定済みで、[Begin, End)のプリミティブを分割する
+	struct PendingNode
+	{
+		uint32_t NodeIdx;
+		uint32_t Begin;
+		uint32_t End;
+		uint32_t Depth;
+	};
+
+	class Builder
+	{
+	public:
+		explicit Builder(const BvhBuildSettings& settings)
+		: m_Settings(settings)
+		{
+			m_Settings.BinCount = std::clamp(m_Settings.BinCount, 2u, MAX_BIN_COUNT);
+			m_Settings.MaxLeafSize = std::max(m_Settings.MaxLeafSize, 1u);
+		}
+
+		void InitPrimRefs(uint32_t primCount, const BvhPrimitiveBounds* pBounds)
+		{
+			static_assert(sizeof(BvhPrimitiveBounds) == sizeof(Bounds));
+			m_PrimRefs.resize(primCount);
+			ForEachRange(0, primCount, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					memcpy(&m_PrimRefs[i].PrimBounds, &pBounds[i], sizeof(Bounds));
+					m_PrimRefs[i].PrimIdx = i;
+					m_PrimRefs[i].Padding = 0;
+				}
+			});
+		}
+
+		// 葉の順に並んだプリミティブのインデックスを取り出す
+		void GetPrimIndices(uint32_t* pPrimIndices) const
+		{
+			ForEachRange(0, static_cast<uint32_t>(m_PrimRefs.size()), [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					pPrimIndices[i] = m_PrimRefs[i].PrimIdx;
+				}
+			});
+		}
+
+		// [begin, end)のプリミティブのAABBの和
+		Bounds ComputeBounds(uint32_t begin, uint32_t end) const
+		{
+			std::vector<Bounds> chunkBounds((end - begin + BINNING_GRAIN_SIZE - 1) / BINNING_GRAIN_SIZE);
+			ForEachRange(begin, end, [&](uint32_t chunkBegin, uint32_t chunkEnd)
+			{
+				Bounds bounds;
+				bounds.Reset();
+				for (uint32_t i = chunkBegin; i < chunkEnd; i++)
+				{
+					bounds.Grow(m_PrimRefs[i].PrimBounds);
+				}
+				chunkBounds[(chunkBegin - begin) / BINNING_GRAIN_SIZE] = bounds;
+			});
+
+			Bounds bounds;
+			bounds.Reset();
+			for (const Bounds& chunk : chunkBounds)
+			{
+				bounds.Grow(chunk);
+			}
+			return bounds;
+		}
+
+		// 分割したら子の範囲の境目を返し、葉にするならendを返す。分割したときはpLeftBoundsとpRightBoundsに子のAABBを返す
+		uint32_t Split(const BvhNode& node, uint32_t begin, uint32_t end, uint32_t depth, Bounds* pLeftBounds, Bounds* pRightBounds)
+		{
+			uint32_t count = end - begin;
+			if (count <= 1 || depth + 1 >= BVH_MAX_DEPTH)
+			{
+				return end;
+			}
+
+			// チャンクごとの集計先。ほとんどのノードは1チャンクなので、その場合はヒープを確保しない
+			uint32_t chunkCount = (count + BINNING_GRAIN_SIZE - 1) / BINNING_GRAIN_SIZE;
+			Bounds localBounds;
+			BinSet localBins;
+			std::vector<Bounds> chunkBoundsStorage;
+			std::vector<BinSet> chunkBinsStorage;
+			Bounds* pChunkBounds = &localBounds;
+			BinSet* pChunkBins = &localBins;
+			if (chunkCount > 1)
+			{
+				chunkBoundsStorage.resize(chunkCount);
+				chunkBinsStorage.resize(chunkCount);
+				pChunkBounds = chunkBoundsStorage.data();
+				pChunkBins = chunkBinsStorage.data();
+			}
+
+			// 重心の範囲
+			ForEachRange(begin, end, [&](uint32_t chunkBegin, uint32_t chunkEnd)
+			{
+				Bounds bounds;
+				bounds.Reset();
+				for (uint32_t i = chunkBegin; i < chunkEnd; i++)
+				{
+					const PrimRef& ref = m_PrimRefs[i];
+					const float centroid[3] = {ref.GetCentroid(0), ref.GetCentroid(1), ref.GetCentroid(2)};
+					bounds.Grow(centroid);
+				}
+				pChunkBounds[(chunkBegin - begin) / BINNING_GRAIN_SIZE] = bounds;
+			});
+
+			Bounds centroidBounds = pChunkBounds[0];
+			for (uint32_t chunk = 1; chunk < chunkCount; chunk++)
+			{
+				centroidBounds.Grow(pChunkBounds[chunk]);
+			}
+
+			// 小さいノードはビンを減らしても分割の質はほとんど変わらないので、ビンの集計と走査の手間を減らす
+			uint32_t binCount = std::min(std::max(count, 4u), m_Settings.BinCount);
+			float binScales[3];
+			bool isDegenerate = true;
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				float extent = centroidBounds.Max[axis] - centroidBounds.Min[axis];
+				// 範囲が極端に狭いと逆数が無限大になるので、その軸では分けない
+				binScales[axis] = (extent > 0.0f) ? binCount / extent : 0.0f;
+				if (!std::isfinite(binScales[axis]))
+				{
+					binScales[axis] = 0.0f;
+				}
+				isDegenerate &= (binScales[axis] == 0.0f);
+			}
+
+			if (isDegenerate)
+			{
+				// 重心が全て同じ点なのでSAHでは分けられない。葉が大きくなりすぎるなら半分に分ける
+				if (count <= m_Settings.MaxLeafSize)
+				{
+					return end;
+				}
+
+				uint32_t mid = begin + count / 2;
+				*pLeftBounds = ComputeBounds(begin, mid);
+				*pRightBounds = ComputeBounds(mid, end);
+				return mid;
+			}
+
+			// ビンの集計
+			ForEachRange(begin, end, [&](uint32_t chunkBegin, uint32_t chunkEnd)
+			{
+				BinSet& binSet = pChunkBins[(chunkBegin - begin) / BINNING_GRAIN_SIZE];
+				binSet.Reset(binCount);
+
+				for (uint32_t i = chunkBegin; i < chunkEnd; i++)
+				{
+					const PrimRef& ref = m_PrimRefs[i];
+					for (uint32_t axis = 0; axis < 3; axis++)
+					{
+						Bin& bin = binSet.Bins[axis][GetBinIdx(ref.GetCentroid(axis), centroidBounds.Min[axis], binScales[axis], binCount)];
+						bin.PrimBounds.Grow(ref.PrimBounds);
+						bin.Count++;
+					}
+				}
+			});
+
+			BinSet& bins = pChunkBins[0];
+			for (uint32_t chunk = 1; chunk < chunkCount; chunk++)
+			{
+				for (uint32_t axis = 0; axis < 3; axis++)
+				{
+					for (uint32_t b = 0; b < binCount; b++)
+					{
+						bins.Bins[axis][b].PrimBounds.Grow(pChunkBins[chunk].Bins[axis][b].PrimBounds);
+						bins.Bins[axis][b].Count += pChunkBins[chunk].Bins[axis][b].Count;
+					}
+				}
+			}
+
+			// ビンの境目ごとに左右の表面積 * プリミティブ数を両側から累積して、SAHのコストが最小の境目を探す
+			float nodeHalfArea = GetNodeBounds(node).GetHalfArea();
+			float bestCost = FLT_MAX;
+			uint32_t bestAxis = 0;
+			uint32_t bestBin = 0;
+
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				if (binScales[axis] == 0.0f)
+				{
+					continue;
+				}
+
+				const Bin* pBins = bins.Bins[axis];
+				float rightCosts[MAX_BIN_COUNT];
+				Bounds rightBounds;
+				rightBounds.Reset();
+				uint32_t rightCount = 0;
+				for (uint32_t b = binCount - 1; b > 0; b--)
+				{
+					rightBounds.Grow(pBins[b].PrimBounds);
+					rightCount += pBins[b].Count;
+					rightCosts[b] = rightBounds.GetHalfArea() * rightCount;
+				}
+
+				Bounds leftBounds;
+				leftBounds.Reset();
+				uint32_t leftCount = 0;
+				for (uint32_t b = 1; b < binCount; b++)
+				{
+					leftBounds.Grow(pBins[b - 1].PrimBounds);
+					leftCount += pBins[b - 1].Count;
+					if (leftCount == 0 || leftCount == count)
+					{
+						continue;
+					}
+
+					float cost = leftBounds.GetHalfArea() * leftCount + rightCosts[b];
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = b;
+					}
+				}
+			}
+
+			float splitCost = m_Settings.TraversalCost + m_Settings.IntersectionCost * bestCost / nodeHalfArea;
+			float leafCost = m_Settings.IntersectionCost * count;
+			if (count <= m_Settings.MaxLeafSize && splitCost >= leafCost)
+			{
+				return end;
+			}
+
+			float centroidMin = centroidBounds.Min[bestAxis];
+			float binScale = binScales[bestAxis];
+			// 部分木の構築は範囲が重ならないので、複数スレッドから同時に並べ替えてよい
+			PrimRef* pRefs = m_PrimRefs.data();
+			PrimRef* pMid = std::partition(pRefs + begin, pRefs + end, [&](const PrimRef& ref)
+			{
+				return GetBinIdx(ref.GetCentroid(bestAxis), centroidMin, binScale, binCount) < bestBin;
+			});
+			uint32_t mid = static_cast<uint32_t>(pMid - pRefs);
+
+			pLeftBounds->Reset();
+			pRightBounds->Reset();
+			for (uint32_t b = 0; b < binCount; b++)
+			{
+				(b < bestBin ? pLeftBounds : pRightBounds)->Grow(bins.Bins[bestAxis][b].PrimBounds);
+			}
+
+			return mid;
+		}
+
+		// nodes[pending.NodeIdx]以下の部分木を1スレッドで構築する
+		void BuildSubtree(std::vector<BvhNode>& nodes, const PendingNode& pending)
+		{
+			PendingNode stack[BVH_MAX_DEPTH * 2];
+			uint32_t stackSize = 0;
+			stack[stackSize++] = pending;
+
+			while (stackSize > 0)
+			{
+				PendingNode curr = stack[--stackSize];
+				uint32_t left = SplitNode(nodes, curr);
+				if (left == 0)
+				{
+					continue;
+				}
+
+				stack[stackSize++] = {left + 1, nodes[left + 1].LeftOrFirst, nodes[left + 1].LeftOrFirst + nodes[left + 1].PrimCount, curr.Depth + 1};
+				stack[stackSize++] = {left, nodes[left].LeftOrFirst, nodes[left].LeftOrFirst + nodes[left].PrimCount, curr.Depth + 1};
+			}
+		}
+
+		// nodes[pending.NodeIdx]を分割して子を2つ追加し、左の子のインデックスを返す。葉にしたら0を返す。
+		// 子は葉として範囲を設定しておき、さらに分割するときに内部ノードにする
+		uint32_t SplitNode(std::vector<BvhNode>& nodes, const PendingNode& pending)
+		{
+			Bounds leftBounds;
+			Bounds rightBounds;
+			uint32_t mid = Split(nodes[pending.NodeIdx], pending.Begin, pending.End, pending.Depth, &leftBounds, &rightBounds);
+			if (mid == pending.End)
+			{
+				return 0;
+			}
+
+			uint32_t left = static_cast<uint32_t>(nodes.size());
+			nodes.resize(left + 2);
+			nodes[left] = MakeLeaf(leftBounds, pending.Begin, mid - pending.Begin);
+			nodes[left + 1] = MakeLeaf(rightBounds, mid, pending.End - mid);
+
+			BvhNode& node = nodes[pending.NodeIdx];
+			node.LeftOrFirst = left;
+			node.PrimCount = 0;
+			return left;
+		}
+
+		static BvhNode MakeLeaf(const Bounds& bounds, uint32_t first, uint32_t count)
+		{
+			BvhNode node;
+			node.BoundsMin = DirectX::SimpleMath::Vector3(bounds.Min[0], bounds.Min[1], bounds.Min[2]);
+			node.BoundsMax = DirectX::SimpleMath::Vector3(bounds.Max[0], bounds.Max[1], bounds.Max[2]);
+			node.LeftOrFirst = first;
+			node.PrimCount = count;
+			return node;
+		}
+
+		const BvhBuildSettings& GetSettings() const { return m_Settings; }
+
+	private:
+		BvhBuildSettings m_Settings;
+		std::vector<PrimRef> m_PrimRefs;
+
+		static Bounds GetNodeBounds(const BvhNode& node)
+		{
+			Bounds bounds = {{node.BoundsMin.x, node.BoundsMin.y, node.BoundsMin.z}, {node.BoundsMax.x, node.BoundsMax.y, node.BoundsMax.z}};
+			return bounds;
+		}
+
+		static uint32_t GetBinIdx(float centroid, float centroidMin, float binScale, uint32_t binCount)
+		{
+			return std::min(static_cast<uint32_t>((centroid - centroidMin) * binScale), binCount - 1);
+		}
+
+		// [begin, end)をbeginからBINNING_GRAIN_SIZEごとのチャンクに分けて処理する。
+		// 部分木の構築中はParallelForの入れ子になるので逐次で処理される
+		void ForEachRange(uint32_t begin, uint32_t end, const std::function<void(uint32_t begin, uint32_t end)>& func) const
+		{
+			uint32_t count = end - begin;
+			if (m_Settings.Multithreaded && count > PARALLEL_BINNING_THRESHOLD)
+			{
+				ParallelFor(count, BINNING_GRAIN_SIZE, [&](uint32_t chunkBegin, uint32_t chunkEnd)
+				{
+					func(begin + chunkBegin, begin + chunkEnd);
+				});
+				return;
+			}
+
+			for (uint32_t chunkBegin = begin; chunkBegin < end; chunkBegin += BINNING_GRAIN_SIZE)
+			{
+				func(chunkBegin, std::min(chunkBegin + BINNING_GRAIN_SIZE, end));
+			}
+		}
+	};
+}
+
+bool Bvh::Build(uint32_t primCount, const BvhPrimitiveBounds* pBounds, const BvhBuildSettings& settings)
+{
+	Term();
+
+	if (primCount == 0 || pBounds == nullptr)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return false;
+	}
+
+	const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+
+	Builder builder(settings);
+	builder.InitPrimRefs(primCount, pBounds);
+
+	// 葉は1プリミティブ以上なのでノード数は2 * primCount - 1以下
+	m_Nodes.reserve(primCount * 2 - 1);
+	m_Nodes.push_back(Builder::MakeLeaf(builder.ComputeBounds(0, primCount), 0, primCount));
+
+	// 上の方はプリミティブ数の多い順に分割して、スレッドに割り当てる部分木を作る
+	std::vector<PendingNode> tasks;
+	if (settings.Multithreaded && GetParallelForThreadCount() > 1)
+	{
+		uint32_t targetTaskCount = GetParallelForThreadCount() * SUBTREES_PER_THREAD;
+		auto isSmaller = [](const PendingNode& a, const PendingNode& b) { return (a.End - a.Begin) < (b.End - b.Begin); };
+
+		std::vector<PendingNode> heap;
+		heap.push_back({0, 0, primCount, 0});
+		while (!heap.empty() && heap.size() + tasks.size() < targetTaskCount)
+		{
+			std::pop_heap(heap.begin(), heap.end(), isSmaller);
+			PendingNode curr = heap.back();
+			heap.pop_back();
+
+			if (curr.End - curr.Begin < MIN_TASK_PRIM_COUNT)
+			{
+				tasks.push_back(curr);
+				continue;
+			}
+
+			uint32_t left = builder.SplitNode(m_Nodes, curr);
+			if (left == 0)
+			{
+				continue;
+			}
+
+			for (uint32_t child = left; child < left + 2; child++)
+			{
+				heap.push_back({child, m_Nodes[child].LeftOrFirst, m_Nodes[child].LeftOrFirst + m_Nodes[child].PrimCount, curr.Depth + 1});
+				std::push_heap(heap.begin(), heap.end(), isSmaller);
+			}
+		}
+		tasks.insert(tasks.end(), heap.begin(), heap.end());
+	}
+	else
+	{
+		tasks.push_back({0, 0, primCount, 0});
+	}
+
+	// 部分木ごとに別の配列に構築する。根は[0]に置く
+	std::vector<std::vector<BvhNode>> subtrees(tasks.size());
+	auto buildTask = [&](uint32_t taskIdx)
+	{
+		std::vector<BvhNode>& nodes = subtrees[taskIdx];
+		nodes.reserve((tasks[taskIdx].End - tasks[taskIdx].Begin) * 2 - 1);
+		nodes.push_back(m_Nodes[tasks[taskIdx].NodeIdx]);
+		builder.BuildSubtree(nodes, {0, tasks[taskIdx].Begin, tasks[taskIdx].End, tasks[taskIdx].Depth});
+	};
+
+	if (tasks.size() > 1)
+	{
+		ParallelFor(static_cast<uint32_t>(tasks.size()), 1, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t taskIdx = begin; taskIdx < end; taskIdx++)
+			{
+				buildTask(taskIdx);
+			}
+		});
+	}
+	else
+	{
+		buildTask(0);
+	}
+
+	// 部分木の根を元のノードに戻し、残りを後ろにつなげる。子のインデックスは部分木の中での[1, )からずらす
+	for (size_t taskIdx = 0; taskIdx < tasks.size(); taskIdx++)
+	{
+		const std::vector<BvhNode>& nodes = subtrees[taskIdx];
+		uint32_t offset = static_cast<uint32_t>(m_Nodes.size()) - 1;
+
+		BvhNode& root = m_Nodes[tasks[taskIdx].NodeIdx];
+		root = nodes[0];
+		if (!root.IsLeaf())
+		{
+			root.LeftOrFirst += offset;
+		}
+
+		for (size_t i = 1; i < nodes.size(); i++)
+		{
+			BvhNode node = nodes[i];
+			if (!node.IsLeaf())
+			{
+				node.LeftOrFirst += offset;
+			}
+			m_Nodes.push_back(node);
+		}
+	}
+
+	m_PrimIndices.resize(primCount);
+	builder.GetPrimIndices(m_PrimIndices.data());
+
+	const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+	// 統計
+	m_BuildStats = BvhBuildStats();
+	m_BuildStats.BuildMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+	m_BuildStats.NodeCount = static_cast<uint32_t>(m_Nodes.size());
+
+	float rootHalfArea = std::max(Bounds{{m_Nodes[0].BoundsMin.x, m_Nodes[0].BoundsMin.y, m_Nodes[0].BoundsMin.z}, {m_Nodes[0].BoundsMax.x, m_Nodes[0].BoundsMax.y, m_Nodes[0].BoundsMax.z}}.GetHalfArea(), FLT_MIN);
+	double sahCost = 0.0;
+
+	std::vector<std::pair<uint32_t, uint32_t>> stack;
+	stack.push_back({0, 0});
+	while (!stack.empty())
+	{
+		auto [nodeIdx, depth] = stack.back();
+		stack.pop_back();
+
+		const BvhNode& node = m_Nodes[nodeIdx];
+		float halfArea = Bounds{{node.BoundsMin.x, node.BoundsMin.y, node.BoundsMin.z}, {node.BoundsMax.x, node.BoundsMax.y, node.BoundsMax.z}}.GetHalfArea();
+		m_BuildStats.MaxDepth = std::max(m_BuildStats.MaxDepth, depth);
+
+		if (node.IsLeaf())
+		{
+			m_BuildStats.LeafCount++;
+			m_BuildStats.MaxLeafPrimCount = std::max(m_BuildStats.MaxLeafPrimCount, node.PrimCount);
+			sahCost += settings.IntersectionCost * node.PrimCount * halfArea / rootHalfArea;
+		}
+		else
+		{
+			sahCost += settings.TraversalCost * halfArea / rootHalfArea;
+			stack.push_back({node.LeftOrFirst, depth + 1});
+			stack.push_back({node.LeftOrFirst + 1, depth + 1});
+		}
+	}
+	m_BuildStats.SAHCost = static_cast<float>(sahCost);
+
+	if (settings.Refittable)
+	{
+		m_ParentIndices.assign(m_Nodes.size(), UINT32_MAX);
+		m_PrimLeafIndices.resize(primCount);
+		for (uint32_t nodeIdx = 0; nodeIdx < m_Nodes.size(); nodeIdx++)
+		{
+			const BvhNode& node = m_Nodes[nodeIdx];
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = node.LeftOrFirst; i < node.LeftOrFirst + node.PrimCount; i++)
+				{
+					m_PrimLeafIndices[m_PrimIndices[i]] = nodeIdx;
+				}
+			}
+			else
+			{
+				m_ParentIndices[node.LeftOrFirst] = nodeIdx;
+				m_ParentIndices[node.LeftOrFirst + 1] = nodeIdx;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool Bvh::Refit(const uint32_t* pPrimIndices, uint32_t count, const BvhPrimitiveBounds* pBounds)
+{
+	if (m_PrimLeafIndices.empty())
+	{
+		ELOG("Error : Bvh is not built as Refittable.");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		assert(pPrimIndices[i] < m_PrimLeafIndices.size());
+		uint32_t nodeIdx = m_PrimLeafIndices[pPrimIndices[i]];
+
+		// 葉は含むプリミティブから、内部ノードは2つの子から求め直す。
+		// 縮むこともあるので、親のAABBを広げるだけでは済まない
+		BvhNode& leaf = m_Nodes[nodeIdx];
+		Bounds bounds;
+		bounds.Reset();
+		for (uint32_t j = leaf.LeftOrFirst; j < leaf.LeftOrFirst + leaf.PrimCount; j++)
+		{
+			const BvhPrimitiveBounds& primBounds = pBounds[m_PrimIndices[j]];
+			bounds.Grow(&primBounds.Min.x);
+			bounds.Grow(&primBounds.Max.x);
+		}
+		leaf.BoundsMin = DirectX::SimpleMath::Vector3(bounds.Min[0], bounds.Min[1], bounds.Min[2]);
+		leaf.BoundsMax = DirectX::SimpleMath::Vector3(bounds.Max[0], bounds.Max[1], bounds.Max[2]);
+
+		for (nodeIdx = m_ParentIndices[nodeIdx]; nodeIdx != UINT32_MAX; nodeIdx = m_ParentIndices[nodeIdx])
+		{
+			BvhNode& node = m_Nodes[nodeIdx];
+			const BvhNode& left = m_Nodes[node.LeftOrFirst];
+			const BvhNode& right = m_Nodes[node.LeftOrFirst + 1];
+			node.BoundsMin = DirectX::SimpleMath::Vector3::Min(left.BoundsMin, right.BoundsMin);
+			node.BoundsMax = DirectX::SimpleMath::Vector3::Max(left.BoundsMax, right.BoundsMax);
+		}
+	}
+
+	return true;
+}
+
+void Bvh::Term()
+{
+	m_Nodes.clear();
+	m_Nodes.shrink_to_fit();
+	m_PrimIndices.clear();
+	m_PrimIndices.shrink_to_fit();
+	m_ParentIndices.clear();
+	m_ParentIndices.shrink_to_fit();
+	m_PrimLeafIndices.clear();
+	m_PrimLeafIndices.shrink_to_fit();
+	m_BuildStats = BvhBuildStats();
+}
@@ -0,0 +1,1098 @@
+﻿#include "CatmullClark.h"
+#include "ParallelFor.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+
+using namespace DirectX;
+using namespace DirectX::SimpleMath;
+
+namespace
+{
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+	// ステンシルの合成を並列に行うときの1チャンクの頂点数
+	static constexpr uint32_t COMPOSE_GRAIN_SIZE = 4096;
+
+	// 1レベル上の頂点の重み付き和。同じ頂点が複数回入ることがある
+	struct LocalStencil
+	{
+		std::vector<uint32_t> Indices;
+		std::vector<float> Weights;
+
+		void Clear()
+		{
+			Indices.clear();
+			Weights.clear();
+		}
+
+		void Add(uint32_t index, float weight)
+		{
+			Indices.push_back(index);
+			Weights.push_back(weight);
+		}
+
+		void AddFaceCentroid(const SubdTopology& topology, const SubdAdjacency& adjacency, uint32_t face, float weight)
+		{
+			uint32_t size = adjacency.GetFaceSize(face);
+			for (uint32_t i = 0; i < size; i++)
+			{
+				Add(topology.FaceVertexIndices[adjacency.FaceOffsets[face] + i], weight / size);
+			}
+		}
+
+		void Scale(size_t begin, float scale)
+		{
+			for (size_t i = begin; i < Weights.size(); i++)
+			{
+				Weights[i] *= scale;
+			}
+		}
+	};
+
+	void ComputeFacePointStencil(const SubdTopology& topology, const SubdAdjacency& adjacency, uint32_t face, LocalStencil& stencil)
+	{
+		stencil.AddFaceCentroid(topology, adjacency, face, 1.0f);
+	}
+
+	void ComputeEdgePointStencil(const SubdTopology& topology, const SubdAdjacency& adjacency, uint32_t edge, LocalStencil& stencil)
+	{
+		uint32_t v0 = adjacency.EdgeVertices[edge * 2 + 0];
+		uint32_t v1 = adjacency.EdgeVertices[edge * 2 + 1];
+
+		float sharpness = adjacency.IsBoundaryEdge(edge) ? SUBD_INFINITE_SHARPNESS : adjacency.EdgeSharpness[edge];
+		if (sharpness >= 1.0f)
+		{
+			stencil.Add(v0, 0.5f);
+			stencil.Add(v1, 0.5f);
+			return;
+		}
+
+		// スムースルール : (v0 + v1 + f0 + f1) / 4
+		stencil.Add(v0, 0.25f);
+		stencil.Add(v1, 0.25f);
+		stencil.AddFaceCentroid(topology, adjacency, adjacency.EdgeFaces[edge * 2 + 0], 0.25f);
+		stencil.AddFaceCentroid(topology, adjacency, adjacency.EdgeFaces[edge * 2 + 1], 0.25f);
+
+		if (sharpness > 0.0f)
+		{
+			// セミシャープはスムースとシャープの線形補間
+			stencil.Scale(0, 1.0f - sharpness);
+			stencil.Add(v0, 0.5f * sharpness);
+			stencil.Add(v1, 0.5f * sharpness);
+		}
+	}
+
+	void ComputeVertexPointStencil(const SubdTopology& topology, const SubdAdjacency& adjacency, uint32_t vertex, LocalStencil& stencil)
+	{
+		uint32_t edgeBegin = adjacency.VertexEdgeOffsets[vertex];
+		uint32_t edgeEnd = adjacency.VertexEdgeOffsets[vertex + 1];
+		uint32_t faceBegin = adjacency.VertexFaceOffsets[vertex];
+		uint32_t faceEnd = adjacency.VertexFaceOffsets[vertex + 1];
+		uint32_t valence = edgeEnd - edgeBegin;
+		uint32_t faceCount = faceEnd - faceBegin;
+
+		uint32_t sharpEdges[2] = {};
+		uint32_t sharpEdgeCount = 0;
+		float sharpnessSum = 0.0f;
+		bool isBoundary = false;
+		bool isNonManifold = false;
+		for (uint32_t i = edgeBegin; i < edgeEnd; i++)
+		{
+			uint32_t edge = adjacency.VertexEdges[i];
+			if (adjacency.EdgeFaceCounts[edge] > 2)
+			{
+				isNonManifold = true;
+			}
+
+			if (adjacency.IsSharpEdge(edge))
+			{
+				if (sharpEdgeCount < 2)
+				{
+					sharpEdges[sharpEdgeCount] = edge;
+				}
+				sharpEdgeCount++;
+
+				if (adjacency.IsBoundaryEdge(edge))
+				{
+					isBoundary = true;
+					sharpnessSum += SUBD_INFINITE_SHARPNESS;
+				}
+				else
+				{
+					sharpnessSum += adjacency.EdgeSharpness[edge];
+				}
+			}
+		}
+
+		// 孤立頂点、非多様体、シャープエッジが3本以上、境界のコーナーはコーナールールで動かさない
+		bool isCorner = (valence == 0) || isNonManifold || (sharpEdgeCount > 2) || (isBoundary && faceCount == 1);
+		bool isCrease = !isCorner && (sharpEdgeCount == 2);
+
+		if (isCorner && (isBoundary || valence == 0 || isNonManifold))
+		{
+			stencil.Add(vertex, 1.0f);
+			return;
+		}
+
+		if (isCrease && isBoundary)
+		{
+			// 境界はスムースルールが定義できないのでブレンドしない
+			uint32_t e0 = sharpEdges[0];
+			uint32_t e1 = sharpEdges[1];
+			stencil.Add(vertex, 0.75f);
+			stencil.Add(adjacency.EdgeVertices[e0 * 2 + 0] == vertex ? adjacency.EdgeVertices[e0 * 2 + 1] : adjacency.EdgeVertices[e0 * 2 + 0], 0.125f);
+			stencil.Add(adjacency.EdgeVertices[e1 * 2 + 0] == vertex ? adjacency.EdgeVertices[e1 * 2 + 1] : adjacency.EdgeVertices[e1 * 2 + 0], 0.125f);
+			return;
+		}
+
+		if (isBoundary)
+		{
+			// シャープエッジが境界の1本だけ、のような境界上の不正な形状はコーナーとして扱う
+			stencil.Add(vertex, 1.0f);
+			return;
+		}
+
+		// 内部頂点のスムースルール : (n - 2) / n * v + sum(e) / n^2 + sum(f) / n^2
+		float n = static_cast<float>(valence);
+		float invN2 = 1.0f / (n * n);
+		stencil.Add(vertex, (n - 2.0f) / n);
+		for (uint32_t i = edgeBegin; i < edgeEnd; i++)
+		{
+			uint32_t edge = adjacency.VertexEdges[i];
+			uint32_t other = (adjacency.EdgeVertices[edge * 2 + 0] == vertex) ? adjacency.EdgeVertices[edge * 2 + 1] : adjacency.EdgeVertices[edge * 2 + 0];
+			stencil.Add(other, invN2);
+		}
+		for (uint32_t i = faceBegin; i < faceEnd; i++)
+		{
+			stencil.AddFaceCentroid(topology, adjacency, adjacency.VertexFaces[i], invN2);
+		}
+
+		if (!isCorner && !isCrease)
+		{
+			return;
+		}
+
+		// セミシャープを含むクリースとコーナーは、シャープネスの平均でスムースルールと線形補間する
+		float sharpness = std::min(sharpnessSum / sharpEdgeCount, 1.0f);
+		stencil.Scale(0, 1.0f - sharpness);
+
+		if (isCorner)
+		{
+			stencil.Add(vertex, sharpness);
+		}
+		else
+		{
+			uint32_t e0 = sharpEdges[0];
+			uint32_t e1 = sharpEdges[1];
+			stencil.Add(vertex, 0.75f * sharpness);
+			stencil.Add(adjacency.EdgeVertices[e0 * 2 + 0] == vertex ? adjacency.EdgeVertices[e0 * 2 + 1] : adjacency.EdgeVertices[e0 * 2 + 0], 0.125f * sharpness);
+			stencil.Add(adjacency.EdgeVertices[e1 * 2 + 0] == vertex ? adjacency.EdgeVertices[e1 * 2 + 1] : adjacency.EdgeVertices[e1 * 2 + 0], 0.125f * sharpness);
+		}
+	}
+
+	void RefineTopology(const SubdTopology& parent, const SubdAdjacency& adjacency, SubdTopology& child)
+	{
+		uint32_t faceCount = adjacency.GetFaceCount();
+		uint32_t edgeCount = adjacency.GetEdgeCount();
+		uint32_t edgePointBase = faceCount;
+		uint32_t vertexPointBase = faceCount + edgeCount;
+
+		child.VertexCount = faceCount + edgeCount + parent.VertexCount;
+		child.FaceVertexCounts.assign(parent.FaceVertexIndices.size(), 4);
+		child.FaceVertexIndices.resize(parent.FaceVertexIndices.size() * 4);
+		child.Creases.clear();
+
+		for (uint32_t face = 0; face < faceCount; face++)
+		{
+			uint32_t offset = adjacency.FaceOffsets[face];
+			uint32_t size = adjacency.GetFaceSize(face);
+
+			for (uint32_t i = 0; i < size; i++)
+			{
+				uint32_t prev = (i + size - 1) % size;
+				uint32_t* pQuad = &child.FaceVertexIndices[(offset + i) * 4];
+				pQuad[0] = vertexPointBase + parent.FaceVertexIndices[offset + i];
+				pQuad[1] = edgePointBase + adjacency.FaceEdges[offset + i];
+				pQuad[2] = face;
+				pQuad[3] = edgePointBase + adjacency.FaceEdges[offset + prev];
+			}
+		}
+
+		for (uint32_t edge = 0; edge < edgeCount; edge++)
+		{
+			float sharpness = adjacency.EdgeSharpness[edge];
+			if (adjacency.IsBoundaryEdge(edge) || sharpness <= 0.0f)
+			{
+				continue;
+			}
+
+			float childSharpness = (sharpness >= SUBD_INFINITE_SHARPNESS) ? SUBD_INFINITE_SHARPNESS : (sharpness - 1.0f);
+			if (childSharpness <= 0.0f)
+			{
+				continue;
+			}
+
+			uint32_t edgePoint = edgePointBase + edge;
+			child.Creases.push_back({vertexPointBase + adjacency.EdgeVertices[edge * 2 + 0], edgePoint, childSharpness});
+			child.Creases.push_back({edgePoint, vertexPointBase + adjacency.EdgeVertices[edge * 2 + 1], childSharpness});
+		}
+	}
+
+	// 細分割後のchild番目の頂点の、1レベル上の頂点によるステンシル
+	void ComputeLocalStencil(const SubdTopology& parent, const SubdAdjacency& adjacency, uint32_t child, LocalStencil& stencil)
+	{
+		uint32_t faceCount = adjacency.GetFaceCount();
+		uint32_t edgeCount = adjacency.GetEdgeCount();
+
+		stencil.Clear();
+		if (child < faceCount)
+		{
+			ComputeFacePointStencil(parent, adjacency, child, stencil);
+		}
+		else if (child < faceCount + edgeCount)
+		{
+			ComputeEdgePointStencil(parent, adjacency, child - faceCount, stencil);
+		}
+		else
+		{
+			ComputeVertexPointStencil(parent, adjacency, child - faceCount - edgeCount, stencil);
+		}
+	}
+
+	uint32_t GetOtherVertex(const SubdAdjacency& adjacency, uint32_t edge, uint32_t vertex)
+	{
+		return (adjacency.EdgeVertices[edge * 2 + 0] == vertex) ? adjacency.EdgeVertices[edge * 2 + 1] : adjacency.EdgeVertices[edge * 2 + 0];
+	}
+
+	uint32_t FindFaceVertex(const SubdTopology& topology, const SubdAdjacency& adjacency, uint32_t face, uint32_t vertex)
+	{
+		uint32_t offset = adjacency.FaceOffsets[face];
+		uint32_t size = adjacency.GetFaceSize(face);
+		for (uint32_t i = 0; i < size; i++)
+		{
+			if (topology.FaceVertexIndices[offset + i] == vertex)
+			{
+				return i;
+			}
+		}
+		return INVALID_INDEX;
+	}
+
+	// 頂点の極限位置のステンシル。スムースな頂点は四角形の面を前提にした式を使う
+	void ComputeLimitStencil(const SubdTopology& topology, const SubdAdjacency& adjacency, uint32_t vertex, LocalStencil& stencil)
+	{
+		stencil.Clear();
+
+		uint32_t edgeBegin = adjacency.VertexEdgeOffsets[vertex];
+		uint32_t edgeEnd = adjacency.VertexEdgeOffsets[vertex + 1];
+		uint32_t faceBegin = adjacency.VertexFaceOffsets[vertex];
+		uint32_t faceEnd = adjacency.VertexFaceOffsets[vertex + 1];
+		uint32_t valence = edgeEnd - edgeBegin;
+		uint32_t faceCount = faceEnd - faceBegin;
+
+		uint32_t sharpEdges[2] = {};
+		uint32_t sharpEdgeCount = 0;
+		bool isNonManifold = false;
+		for (uint32_t i = edgeBegin; i < edgeEnd; i++)
+		{
+			uint32_t edge = adjacency.VertexEdges[i];
+			if (adjacency.EdgeFaceCounts[edge] > 2)
+			{
+				isNonManifold = true;
+			}
+
+			if (adjacency.IsSharpEdge(edge))
+			{
+				if (sharpEdgeCount < 2)
+				{
+					sharpEdges[sharpEdgeCount] = edge;
+				}
+				sharpEdgeCount++;
+			}
+		}
+
+		if (valence == 0 || isNonManifold || sharpEdgeCount > 2 || (sharpEdgeCount == 2 && faceCount == 1))
+		{
+			stencil.Add(vertex, 1.0f);
+			return;
+		}
+
+		if (sharpEdgeCount == 2)
+		{
+			// クリース上の極限位置 : (e0 + 4v + e1) / 6
+			stencil.Add(vertex, 4.0f / 6.0f);
+			stencil.Add(GetOtherVertex(adjacency, sharpEdges[0], vertex), 1.0f / 6.0f);
+			stencil.Add(GetOtherVertex(adjacency, sharpEdges[1], vertex), 1.0f / 6.0f);
+			return;
+		}
+
+		// スムースな頂点の極限位置 : (n^2 v + 4 sum(e) + sum(f)) / (n (n + 5))。fは各面の対角の頂点
+		float n = static_cast<float>(valence);
+		float invDenom = 1.0f / (n * (n + 5.0f));
+		stencil.Add(vertex, n * n * invDenom);
+		for (uint32_t i = edgeBegin; i < edgeEnd; i++)
+		{
+			stencil.Add(GetOtherVertex(adjacency, adjacency.VertexEdges[i], vertex), 4.0f * invDenom);
+		}
+		for (uint32_t i = faceBegin; i < faceEnd; i++)
+		{
+			uint32_t face = adjacency.VertexFaces[i];
+			if (adjacency.GetFaceSize(face) == 4)
+			{
+				uint32_t corner = FindFaceVertex(topology, adjacency, face, vertex);
+				stencil.Add(topology.FaceVertexIndices[adjacency.FaceOffsets[face] + (corner + 2) % 4], invDenom);
+			}
+			else
+			{
+				// 四角形以外の面はレベル0にしかないので重心で近似する
+				stencil.AddFaceCentroid(topology, adjacency, face, invDenom);
+			}
+		}
+	}
+
+	// 正則な四角形の面なら、行優先4x4の双三次Bスプラインのコントロールポイントを集める。
+	// 面の頂点q0, q1, q2, q3はそれぞれpoints[5], [6], [10], [9]になる
+	bool GatherRegularPatchPoints(const SubdTopology& topology, const SubdAdjacency& adjacency, uint32_t face, uint32_t points[16])
+	{
+		// エッジkの隣の面の、q[k]側とq[k + 1]側の外側の点の位置
+		static constexpr uint32_t EDGE_NEAR_POINTS[4] = {1, 7, 14, 8};
+		static constexpr uint32_t EDGE_FAR_POINTS[4] = {2, 11, 13, 4};
+		static constexpr uint32_t CORNER_POINTS[4] = {0, 3, 15, 12};
+
+		if (adjacency.GetFaceSize(face) != 4)
+		{
+			return false;
+		}
+
+		uint32_t offset = adjacency.FaceOffsets[face];
+		const uint32_t* q = &topology.FaceVertexIndices[offset];
+
+		// 全ての頂点が価数4で、接するエッジが全てスムースで、接する面が全て四角形
+		for (uint32_t k = 0; k < 4; k++)
+		{
+			uint32_t vertex = q[k];
+			if (adjacency.VertexEdgeOffsets[vertex + 1] - adjacency.VertexEdgeOffsets[vertex] != 4
+			 || adjacency.VertexFaceOffsets[vertex + 1] - adjacency.VertexFaceOffsets[vertex] != 4)
+			{
+				return false;
+			}
+
+			for (uint32_t i = adjacency.VertexEdgeOffsets[vertex]; i < adjacency.VertexEdgeOffsets[vertex + 1]; i++)
+			{
+				uint32_t edge = adjacency.VertexEdges[i];
+				if (adjacency.EdgeFaceCounts[edge] != 2 || adjacency.EdgeSharpness[edge] > 0.0f)
+				{
+					return false;
+				}
+			}
+
+			for (uint32_t i = adjacency.VertexFaceOffsets[vertex]; i < adjacency.VertexFaceOffsets[vertex + 1]; i++)
+			{
+				if (adjacency.GetFaceSize(adjacency.VertexFaces[i]) != 4)
+				{
+					return false;
+				}
+			}
+		}
+
+		points[5] = q[0];
+		points[6] = q[1];
+		points[10] = q[2];
+		points[9] = q[3];
+
+		uint32_t edgeFaces[4];
+		for (uint32_t k = 0; k < 4; k++)
+		{
+			uint32_t edge = adjacency.FaceEdges[offset + k];
+			uint32_t neighbor = (adjacency.EdgeFaces[edge * 2 + 0] == face) ? adjacency.EdgeFaces[edge * 2 + 1] : adjacency.EdgeFaces[edge * 2 + 0];
+			const uint32_t* n = &topology.FaceVertexIndices[adjacency.FaceOffsets[neighbor]];
+
+			// 向きが揃っていれば隣の面ではq[k + 1], q[k]の順に並ぶ
+			uint32_t j = FindFaceVertex(topology, adjacency, neighbor, q[(k + 1) % 4]);
+			if (n[(j + 1) % 4] != q[k])
+			{
+				return false;
+			}
+
+			points[EDGE_NEAR_POINTS[k]] = n[(j + 2) % 4];
+			points[EDGE_FAR_POINTS[k]] = n[(j + 3) % 4];
+			edgeFaces[k] = neighbor;
+		}
+
+		for (uint32_t k = 0; k < 4; k++)
+		{
+			uint32_t vertex = q[k];
+			uint32_t prevEdgeFace = edgeFaces[(k + 3) % 4];
+
+			uint32_t diagonal = INVALID_INDEX;
+			for (uint32_t i = adjacency.VertexFaceOffsets[vertex]; i < adjacency.VertexFaceOffsets[vertex + 1]; i++)
+			{
+				uint32_t other = adjacency.VertexFaces[i];
+				if (other != face && other != edgeFaces[k] && other != prevEdgeFace)
+				{
+					diagonal = other;
+				}
+			}
+
+			if (diagonal == INVALID_INDEX)
+			{
+				return false;
+			}
+
+			uint32_t j = FindFaceVertex(topology, adjacency, diagonal, vertex);
+			points[CORNER_POINTS[k]] = topology.FaceVertexIndices[adjacency.FaceOffsets[diagonal] + (j + 2) % 4];
+		}
+
+		return true;
+	}
+
+	// 一様3次Bスプラインの基底関数とその微分
+	void EvaluateBSplineBasis(float t, float basis[4], float derivs[4])
+	{
+		float s = 1.0f - t;
+		float t2 = t * t;
+		float t3 = t2 * t;
+
+		basis[0] = s * s * s / 6.0f;
+		basis[1] = (3.0f * t3 - 6.0f * t2 + 4.0f) / 6.0f;
+		basis[2] = (-3.0f * t3 + 3.0f * t2 + 3.0f * t + 1.0f) / 6.0f;
+		basis[3] = t3 / 6.0f;
+
+		derivs[0] = -0.5f * s * s;
+		derivs[1] = 1.5f * t2 - 2.0f * t;
+		derivs[2] = -1.5f * t2 + t + 0.5f;
+		derivs[3] = 0.5f * t2;
+	}
+
+	// 1レベル上の頂点によるステンシルを、コントロールポイントからの直接のステンシルに合成する。
+	// コントロールポイント数の密な配列に重みを加算し、触れたインデックスだけを回収する
+	class StencilComposer
+	{
+	public:
+		explicit StencilComposer(uint32_t controlPointCount)
+		: m_AccumWeights(controlPointCount, 0.0f)
+		, m_Touched(controlPointCount, 0)
+		{
+		}
+
+		// pParentTableがnullptrなら1レベル上がコントロールケージ
+		void Compose(const LocalStencil& local, const StencilTable* pParentTable, StencilTable& dst)
+		{
+			m_TouchedIndices.clear();
+			for (size_t i = 0; i < local.Indices.size(); i++)
+			{
+				uint32_t parentVertex = local.Indices[i];
+				float weight = local.Weights[i];
+
+				uint32_t count = (pParentTable != nullptr) ? pParentTable->GetSize(parentVertex) : 1;
+				const uint32_t* pIndices = (pParentTable != nullptr) ? pParentTable->GetIndices(parentVertex) : &parentVertex;
+				const float* pWeights = (pParentTable != nullptr) ? pParentTable->GetWeights(parentVertex) : nullptr;
+
+				for (uint32_t j = 0; j < count; j++)
+				{
+					uint32_t control = pIndices[j];
+					if (m_Touched[control] == 0)
+					{
+						m_Touched[control] = 1;
+						m_TouchedIndices.push_back(control);
+					}
+					m_AccumWeights[control] += weight * ((pWeights != nullptr) ? pWeights[j] : 1.0f);
+				}
+			}
+
+			// Apply時のメモリアクセスが前方に進むようにソートしておく
+			std::sort(m_TouchedIndices.begin(), m_TouchedIndices.end());
+
+			m_Weights.resize(m_TouchedIndices.size());
+			for (size_t i = 0; i < m_TouchedIndices.size(); i++)
+			{
+				uint32_t control = m_TouchedIndices[i];
+				m_Weights[i] = m_AccumWeights[control];
+				m_AccumWeights[control] = 0.0f;
+				m_Touched[control] = 0;
+			}
+
+			dst.AddStencil(static_cast<uint32_t>(m_TouchedIndices.size()), m_TouchedIndices.data(), m_Weights.data());
+		}
+
+	private:
+		std::vector<float> m_AccumWeights;
+		std::vector<uint8_t> m_Touched;
+		std::vector<uint32_t> m_TouchedIndices;
+		std::vector<float> m_Weights;
+	};
+
+	// childCount個の頂点のステンシルを並列に合成する。computeLocalはchild番目の頂点のローカルステンシルを求める
+	void ComposeStencilTable(uint32_t childCount, uint32_t controlPointCount, const StencilTable* pParentTable, const std::function<void(uint32_t child, LocalStencil& local)>& computeLocal, StencilTable& result)
+	{
+		uint32_t chunkCount = (childCount + COMPOSE_GRAIN_SIZE - 1) / COMPOSE_GRAIN_SIZE;
+		std::vector<StencilTable> chunkTables(chunkCount);
+
+		ParallelFor(childCount, COMPOSE_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+		{
+			StencilTable& table = chunkTables[begin / COMPOSE_GRAIN_SIZE];
+			StencilComposer composer(controlPointCount);
+			LocalStencil local;
+
+			for (uint32_t child = begin; child < end; child++)
+			{
+				computeLocal(child, local);
+				composer.Compose(local, pParentTable, table);
+			}
+		});
+
+		result.Clear();
+		for (const StencilTable& table : chunkTables)
+		{
+			result.Append(table);
+		}
+	}
+}
+
+CatmullClarkRefiner::~CatmullClarkRefiner()
+{
+	Term();
+}
+
+bool CatmullClarkRefiner::Init(const SubdTopology& cage, uint32_t maxLevel)
+{
+	Term();
+
+	if (maxLevel == 0)
+	{
+		ELOG("Error : maxLevel must be 1 or more.");
+		return false;
+	}
+
+	m_Topologies.resize(maxLevel + 1);
+	m_StencilTables.resize(maxLevel + 1);
+	m_Topologies[0] = cage;
+
+	SubdAdjacency adjacency;
+	for (uint32_t level = 1; level <= maxLevel; level++)
+	{
+		const SubdTopology& parent = m_Topologies[level - 1];
+		if (!BuildAdjacency(parent, adjacency))
+		{
+			ELOG("Error : BuildAdjacency() Failed. level = %u", level - 1);
+			Term();
+			return false;
+		}
+
+		RefineTopology(parent, adjacency, m_Topologies[level]);
+
+		const StencilTable* pParentTable = (level == 1) ? nullptr : &m_StencilTables[level - 1];
+		ComposeStencilTable(m_Topologies[level].VertexCount, cage.VertexCount, pParentTable, [&](uint32_t child, LocalStencil& local)
+		{
+			ComputeLocalStencil(parent, adjacency, child, local);
+		}, m_StencilTables[level]);
+	}
+
+	return true;
+}
+
+void CatmullClarkRefiner::Term()
+{
+	m_Topologies.clear();
+	m_StencilTables.clear();
+}
+
+uint32_t CatmullClarkRefiner::GetMaxLevel() const
+{
+	return m_Topologies.empty() ? 0 : static_cast<uint32_t>(m_Topologies.size()) - 1;
+}
+
+const SubdTopology& CatmullClarkRefiner::GetTopology(uint32_t level) const
+{
+	assert(level < m_Topologies.size());
+	return m_Topologies[level];
+}
+
+uint32_t CatmullClarkRefiner::GetVertexCount(uint32_t level) const
+{
+	assert(level < m_Topologies.size());
+	return m_Topologies[level].VertexCount;
+}
+
+const StencilTable& CatmullClarkRefiner::GetStencilTable(uint32_t level) const
+{
+	assert(1 <= level && level < m_StencilTables.size());
+	return m_StencilTables[level];
+}
+
+void CatmullClarkRefiner::Evaluate(uint32_t level, const Vector3* pControlPoints, Vector3* pDst) const
+{
+	if (level == 0)
+	{
+		memcpy(pDst, pControlPoints, sizeof(Vector3) * m_Topologies[0].VertexCount);
+		return;
+	}
+
+	GetStencilTable(level).Apply(pControlPoints, pDst);
+}
+
+bool CatmullClarkRefiner::ComputeLimitStencilTable(uint32_t level, StencilTable& result) const
+{
+	if (level == 0 || level >= m_Topologies.size())
+	{
+		ELOG("Error : Invalid level. level = %u", level);
+		return false;
+	}
+
+	const SubdTopology& topology = m_Topologies[level];
+
+	SubdAdjacency adjacency;
+	if (!BuildAdjacency(topology, adjacency))
+	{
+		ELOG("Error : BuildAdjacency() Failed. level = %u", level);
+		return false;
+	}
+
+	ComposeStencilTable(topology.VertexCount, m_Topologies[0].VertexCount, &m_StencilTables[level], [&](uint32_t vertex, LocalStencil& local)
+	{
+		ComputeLimitStencil(topology, adjacency, vertex, local);
+	}, result);
+
+	return true;
+}
+
+AdaptiveCatmullClarkRefiner::~AdaptiveCatmullClarkRefiner()
+{
+	Term();
+}
+
+bool AdaptiveCatmullClarkRefiner::Init(const SubdTopology& cage, uint32_t isolationLevel)
+{
+	Term();
+
+	if (isolationLevel == 0)
+	{
+		ELOG("Error : isolationLevel must be 1 or more.");
+		return false;
+	}
+
+	m_IsolationLevel = isolationLevel;
+
+	// 細分割の途中のレベルは、孤立させる面とその周囲の面だけからなる部分メッシュとして持つ
+	SubdTopology topology = cage;
+	SubdAdjacency adjacency;
+	// コントロールポイントからtopologyの頂点へのステンシル。レベル0では使わない
+	StencilTable stencils;
+	// topologyの面に対応する4分木のノード。周囲の面のようにドメインに含まれない面はINVALID_INDEX
+	std::vector<uint32_t> faceNodes;
+	// topologyの頂点とその極限位置に対応するパッチのコントロールポイント
+	std::vector<uint32_t> pointIndices;
+	std::vector<uint32_t> limitPointIndices;
+
+	StencilComposer composer(cage.VertexCount);
+	LocalStencil local;
+
+	if (!BuildAdjacency(topology, adjacency))
+	{
+		ELOG("Error : BuildAdjacency() Failed.");
+		Term();
+		return false;
+	}
+
+	faceNodes.assign(adjacency.GetFaceCount(), INVALID_INDEX);
+	for (uint32_t face = 0; face < adjacency.GetFaceCount(); face++)
+	{
+		if (adjacency.GetFaceSize(face) == 4)
+		{
+			faceNodes[face] = static_cast<uint32_t>(m_Nodes.size());
+			m_DomainNodes.push_back(faceNodes[face]);
+			m_Nodes.push_back({INVALID_INDEX, INVALID_INDEX});
+		}
+	}
+
+	for (uint32_t level = 0; ; level++)
+	{
+		const StencilTable* pStencils = (level == 0) ? nullptr : &stencils;
+		uint32_t faceCount = adjacency.GetFaceCount();
+
+		pointIndices.assign(topology.VertexCount, INVALID_INDEX);
+		limitPointIndices.assign(topology.VertexCount, INVALID_INDEX);
+
+		// 0 : 細分割しない, 1 : 周囲の面として細分割する, 2 : 孤立させるために細分割する
+		std::vector<uint8_t> refineMask(faceCount, 0);
+		bool needsRefine = false;
+
+		for (uint32_t face = 0; face < faceCount; face++)
+		{
+			uint32_t node = faceNodes[face];
+			if (node == INVALID_INDEX)
+			{
+				// レベル0のn角形はレベル1の子の面がドメインになる
+				if (level == 0 && adjacency.GetFaceSize(face) != 4)
+				{
+					refineMask[face] = 2;
+					needsRefine = true;
+				}
+				continue;
+			}
+
+			uint32_t points[16];
+			if (GatherRegularPatchPoints(topology, adjacency, face, points))
+			{
+				m_Nodes[node].Patch = static_cast<uint32_t>(m_Patches.size());
+				m_Patches.push_back({SUBD_PATCH_TYPE_REGULAR, level, static_cast<uint32_t>(m_PatchPointIndices.size())});
+
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					uint32_t vertex = points[i];
+					if (pointIndices[vertex] == INVALID_INDEX)
+					{
+						pointIndices[vertex] = m_PatchPointStencils.GetStencilCount();
+						local.Clear();
+						local.Add(vertex, 1.0f);
+						composer.Compose(local, pStencils, m_PatchPointStencils);
+					}
+					m_PatchPointIndices.push_back(pointIndices[vertex]);
+				}
+			}
+			else if (level == isolationLevel)
+			{
+				m_Nodes[node].Patch = static_cast<uint32_t>(m_Patches.size());
+				m_Patches.push_back({SUBD_PATCH_TYPE_BILINEAR, level, static_cast<uint32_t>(m_PatchPointIndices.size())});
+
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					uint32_t vertex = topology.FaceVertexIndices[adjacency.FaceOffsets[face] + i];
+					if (limitPointIndices[vertex] == INVALID_INDEX)
+					{
+						limitPointIndices[vertex] = m_PatchPointStencils.GetStencilCount();
+						ComputeLimitStencil(topology, adjacency, vertex, local);
+						composer.Compose(local, pStencils, m_PatchPointStencils);
+					}
+					m_PatchPointIndices.push_back(limitPointIndices[vertex]);
+				}
+			}
+			else
+			{
+				refineMask[face] = 2;
+				needsRefine = true;
+			}
+		}
+
+		if (!needsRefine)
+		{
+			break;
+		}
+
+		// 孤立させる面の頂点に接する面を全て細分割すれば、孤立させる面の子とその1リングの頂点は正しく求まる
+		for (uint32_t face = 0; face < faceCount; face++)
+		{
+			if (refineMask[face] != 2)
+			{
+				continue;
+			}
+
+			uint32_t offset = adjacency.FaceOffsets[face];
+			for (uint32_t i = 0; i < adjacency.GetFaceSize(face); i++)
+			{
+				uint32_t vertex = topology.FaceVertexIndices[offset + i];
+				for (uint32_t j = adjacency.VertexFaceOffsets[vertex]; j < adjacency.VertexFaceOffsets[vertex + 1]; j++)
+				{
+					uint8_t& mask = refineMask[adjacency.VertexFaces[j]];
+					mask = std::max<uint8_t>(mask, 1);
+				}
+			}
+		}
+
+		// 子の頂点は親の面、エッジ、頂点のどれから作られたかを覚えておく
+		enum SOURCE_TYPE
+		{
+			SOURCE_FACE,
+			SOURCE_EDGE,
+			SOURCE_VERTEX,
+		};
+		std::vector<uint32_t> faceChildren(faceCount, INVALID_INDEX);
+		std::vector<uint32_t> edgeChildren(adjacency.GetEdgeCount(), INVALID_INDEX);
+		std::vector<uint32_t> vertexChildren(topology.VertexCount, INVALID_INDEX);
+		std::vector<uint32_t> sourceTypes;
+		std::vector<uint32_t> sourceElements;
+		auto getChild = [&](std::vector<uint32_t>& children, uint32_t element, SOURCE_TYPE type)
+		{
+			if (children[element] == INVALID_INDEX)
+			{
+				children[element] = static_cast<uint32_t>(sourceTypes.size());
+				sourceTypes.push_back(type);
+				sourceElements.push_back(element);
+			}
+			return children[element];
+		};
+
+		SubdTopology child;
+		std::vector<uint32_t> childFaceNodes;
+		std::vector<uint8_t> edgeVisited(adjacency.GetEdgeCount(), 0);
+
+		for (uint32_t face = 0; face < faceCount; face++)
+		{
+			if (refineMask[face] == 0)
+			{
+				continue;
+			}
+
+			uint32_t offset = adjacency.FaceOffsets[face];
+			uint32_t size = adjacency.GetFaceSize(face);
+			uint32_t facePoint = getChild(faceChildren, face, SOURCE_FACE);
+
+			uint32_t firstChildNode = INVALID_INDEX;
+			if (refineMask[face] == 2)
+			{
+				firstChildNode = static_cast<uint32_t>(m_Nodes.size());
+				for (uint32_t i = 0; i < size; i++)
+				{
+					m_Nodes.push_back({INVALID_INDEX, INVALID_INDEX});
+				}
+
+				if (faceNodes[face] != INVALID_INDEX)
+				{
+					m_Nodes[faceNodes[face]].FirstChild = firstChildNode;
+				}
+				else
+				{
+					for (uint32_t i = 0; i < size; i++)
+					{
+						m_DomainNodes.push_back(firstChildNode + i);
+					}
+				}
+			}
+
+			for (uint32_t i = 0; i < size; i++)
+			{
+				uint32_t prev = (i + size - 1) % size;
+				child.FaceVertexCounts.push_back(4);
+				child.FaceVertexIndices.push_back(getChild(vertexChildren, topology.FaceVertexIndices[offset + i], SOURCE_VERTEX));
+				child.FaceVertexIndices.push_back(getChild(edgeChildren, adjacency.FaceEdges[offset + i], SOURCE_EDGE));
+				child.FaceVertexIndices.push_back(facePoint);
+				child.FaceVertexIndices.push_back(getChild(edgeChildren, adjacency.FaceEdges[offset + prev], SOURCE_EDGE));
+				childFaceNodes.push_back((firstChildNode != INVALID_INDEX) ? firstChildNode + i : INVALID_INDEX);
+			}
+
+			for (uint32_t i = 0; i < size; i++)
+			{
+				uint32_t edge = adjacency.FaceEdges[offset + i];
+				float sharpness = adjacency.EdgeSharpness[edge];
+				if (edgeVisited[edge] != 0 || sharpness <= 0.0f)
+				{
+					continue;
+				}
+				edgeVisited[edge] = 1;
+
+				float childSharpness = (sharpness >= SUBD_INFINITE_SHARPNESS) ? SUBD_INFINITE_SHARPNESS : (sharpness - 1.0f);
+				if (childSharpness <= 0.0f)
+				{
+					continue;
+				}
+
+				uint32_t edgePoint = getChild(edgeChildren, edge, SOURCE_EDGE);
+				child.Creases.push_back({getChild(vertexChildren, adjacency.EdgeVertices[edge * 2 + 0], SOURCE_VERTEX), edgePoint, childSharpness});
+				child.Creases.push_back({edgePoint, getChild(vertexChildren, adjacency.EdgeVertices[edge * 2 + 1], SOURCE_VERTEX), childSharpness});
+			}
+		}
+
+		child.VertexCount = static_cast<uint32_t>(sourceTypes.size());
+
+		// 部分メッシュの縁の頂点は近傍が欠けているので正しくないが、パッチからもさらに細かいレベルからも参照されない
+		StencilTable childStencils;
+		ComposeStencilTable(child.VertexCount, cage.VertexCount, pStencils, [&](uint32_t vertex, LocalStencil& stencil)
+		{
+			stencil.Clear();
+			switch (sourceTypes[vertex])
+			{
+			case SOURCE_FACE:
+				ComputeFacePointStencil(topology, adjacency, sourceElements[vertex], stencil);
+				break;
+			case SOURCE_EDGE:
+				ComputeEdgePointStencil(topology, adjacency, sourceElements[vertex], stencil);
+				break;
+			default:
+				ComputeVertexPointStencil(topology, adjacency, sourceElements[vertex], stencil);
+				break;
+			}
+		}, childStencils);
+
+		topology = std::move(child);
+		stencils = std::move(childStencils);
+		faceNodes = std::move(childFaceNodes);
+
+		if (!BuildAdjacency(topology, adjacency))
+		{
+			ELOG("Error : BuildAdjacency() Failed. level = %u", level + 1);
+			Term();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void AdaptiveCatmullClarkRefiner::Term()
+{
+	m_IsolationLevel = 0;
+	m_Patches.clear();
+	m_PatchPointIndices.clear();
+	m_Nodes.clear();
+	m_DomainNodes.clear();
+	m_PatchPointStencils.Clear();
+}
+
+size_t AdaptiveCatmullClarkRefiner::GetMemorySize() const
+{
+	return m_PatchPointStencils.GetMemorySize()
+		+ m_Patches.size() * sizeof(SubdPatch)
+		+ m_PatchPointIndices.size() * sizeof(uint32_t)
+		+ m_Nodes.size() * sizeof(PatchNode)
+		+ m_DomainNodes.size() * sizeof(uint32_t);
+}
+
+void AdaptiveCatmullClarkRefiner::EvaluatePatchPoints(const Vector3* pControlPoints, Vector3* pPatchPoints) const
+{
+	m_PatchPointStencils.Apply(pControlPoints, pPatchPoints);
+}
+
+void AdaptiveCatmullClarkRefiner::Evaluate(
+	uint32_t domain,
+	float u,
+	float v,
+	const Vector3* pPatchPoints,
+	Vector3* pPosition,
+	Vector3* pDu,
+	Vector3* pDv) const
+{
+	// 子のノードは親の面の頂点順に、親の(u, v)の4分の1の領域を、その頂点を原点として親の向きを90度ずつ回した座標系で覆う。
+	// jacobianは子の(u, v)のドメインの(u, v)による偏微分
+	float jacobian[2][2] = {{1.0f, 0.0f}, {0.0f, 1.0f}};
+	const PatchNode* pNode = &m_Nodes[m_DomainNodes[domain]];
+	while (pNode->Patch == INVALID_INDEX)
+	{
+		uint32_t corner;
+		float childU;
+		float childV;
+		float m[2][2];
+		if (v < 0.5f)
+		{
+			if (u < 0.5f)
+			{
+				corner = 0; childU = 2.0f * u; childV = 2.0f * v;
+				m[0][0] = 2.0f; m[0][1] = 0.0f; m[1][0] = 0.0f; m[1][1] = 2.0f;
+			}
+			else
+			{
+				corner = 1; childU = 2.0f * v; childV = 2.0f - 2.0f * u;
+				m[0][0] = 0.0f; m[0][1] = 2.0f; m[1][0] = -2.0f; m[1][1] = 0.0f;
+			}
+		}
+		else
+		{
+			if (u >= 0.5f)
+			{
+				corner = 2; childU = 2.0f - 2.0f * u; childV = 2.0f - 2.0f * v;
+				m[0][0] = -2.0f; m[0][1] = 0.0f; m[1][0] = 0.0f; m[1][1] = -2.0f;
+			}
+			else
+			{
+				corner = 3; childU = 2.0f - 2.0f * v; childV = 2.0f * u;
+				m[0][0] = 0.0f; m[0][1] = -2.0f; m[1][0] = 2.0f; m[1][1] = 0.0f;
+			}
+		}
+
+		float j00 = m[0][0] * jacobian[0][0] + m[0][1] * jacobian[1][0];
+		float j01 = m[0][0] * jacobian[0][1] + m[0][1] * jacobian[1][1];
+		float j10 = m[1][0] * jacobian[0][0] + m[1][1] * jacobian[1][0];
+		float j11 = m[1][0] * jacobian[0][1] + m[1][1] * jacobian[1][1];
+		jacobian[0][0] = j00;
+		jacobian[0][1] = j01;
+		jacobian[1][0] = j10;
+		jacobian[1][1] = j11;
+
+		u = std::min(std::max(childU, 0.0f), 1.0f);
+		v = std::min(std::max(childV, 0.0f), 1.0f);
+		pNode = &m_Nodes[pNode->FirstChild + corner];
+	}
+
+	const SubdPatch& patch = m_Patches[pNode->Patch];
+	const uint32_t* pIndices = &m_PatchPointIndices[patch.FirstIndex];
+
+	XMVECTOR position;
+	XMVECTOR du;
+	XMVECTOR dv;
+	if (patch.Type == SUBD_PATCH_TYPE_REGULAR)
+	{
+		float basisU[4];
+		float basisV[4];
+		float derivU[4];
+		float derivV[4];
+		EvaluateBSplineBasis(u, basisU, derivU);
+		EvaluateBSplineBasis(v, basisV, derivV);
+
+		position = XMVectorZero();
+		du = XMVectorZero();
+		dv = XMVectorZero();
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			XMVECTOR row = XMVectorZero();
+			XMVECTOR rowDu = XMVectorZero();
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				XMVECTOR point = XMLoadFloat3(&pPatchPoints[pIndices[j * 4 + i]]);
+				row = XMVectorMultiplyAdd(XMVectorReplicate(basisU[i]), point, row);
+				rowDu = XMVectorMultiplyAdd(XMVectorReplicate(derivU[i]), point, rowDu);
+			}
+
+			position = XMVectorMultiplyAdd(XMVectorReplicate(basisV[j]), row, position);
+			du = XMVectorMultiplyAdd(XMVectorReplicate(basisV[j]), rowDu, du);
+			dv = XMVectorMultiplyAdd(XMVectorReplicate(derivV[j]), row, dv);
+		}
+	}
+	else
+	{
+		XMVECTOR q0 = XMLoadFloat3(&pPatchPoints[pIndices[0]]);
+		XMVECTOR q1 = XMLoadFloat3(&pPatchPoints[pIndices[1]]);
+		XMVECTOR q2 = XMLoadFloat3(&pPatchPoints[pIndices[2]]);
+		XMVECTOR q3 = XMLoadFloat3(&pPatchPoints[pIndices[3]]);
+
+		XMVECTOR bottom = XMVectorLerp(q0, q1, u);
+		XMVECTOR top = XMVectorLerp(q3, q2, u);
+		position = XMVectorLerp(bottom, top, v);
+		du = XMVectorLerp(XMVectorSubtract(q1, q0), XMVectorSubtract(q2, q3), v);
+		dv = XMVectorSubtract(top, bottom);
+	}
+
+	XMStoreFloat3(pPosition, position);
+
+	if (pDu != nullptr)
+	{
+		XMStoreFloat3(pDu, XMVectorAdd(XMVectorScale(du, jacobian[0][0]), XMVectorScale(dv, jacobian[1][0])));
+	}
+
+	if (pDv != nullptr)
+	{
+		XMStoreFloat3(pDv, XMVectorAdd(XMVectorScale(du, jacobian[0][1]), XMVectorScale(dv, jacobian[1][1])));
+	}
+}
+
+void AdaptiveCatmullClarkRefiner::Evaluate(
+	uint32_t domain,
+	uint32_t count,
+	const Vector2* pUVs,
+	const Vector3* pPatchPoints,
+	Vector3* pPositions,
+	Vector3* pDus,
+	Vector3* pDvs) const
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Evaluate(
+			domain,
+			pUVs[i].x,
+			pUVs[i].y,
+			pPatchPoints,
+			&pPositions[i],
+			(pDus != nullptr) ? &pDus[i] : nullptr,
+			(pDvs != nullptr) ? &pDvs[i] : nullptr);
+	}
+}
@@ -89,4 +89,9 @@ ID3D12GraphicsCommandList6* CommandList::Reset()
 
 	m_Index = (m_Index + 1) % uint32_t(m_pAllocators.size());
 	return m_pCmdList.Get();
+}
+
+ID3D12GraphicsCommandList6* CommandList::Get() const
+{
+	return m_pCmdList.Get();
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+﻿#include "CounterBasedRandom.h"
+#include "CpuFeatures.h"
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define RANDOM_TARGET_AVX2
+#else
+#define RANDOM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+	void StoreResult(uint32_t* pDst, uint32_t value)
+	{
+		*pDst = value;
+	}
+
+	void StoreResult(float* pDst, uint32_t value)
+	{
+		*pDst = RandomToUnitFloat(value);
+	}
+
+	template<typename T>
+	void GenerateScalar(uint32_t firstId, uint32_t begin, uint32_t end, uint32_t frame, uint32_t stream, uint32_t seed, T* const pResults[4])
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t random[4];
+			GenerateRandom4(firstId + i, frame, stream, seed, random);
+
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				if (pResults[j] != nullptr)
+				{
+					StoreResult(&pResults[j][i], random[j]);
+				}
+			}
+		}
+	}
+
+	// 8レーンそれぞれの32ビットの積の下位をpLow、上位をpHighに返す。multiplierは全レーン同じ値であること
+	RANDOM_TARGET_AVX2 void MultiplyHighLow(__m256i multiplier, __m256i value, __m256i* pLow, __m256i* pHigh)
+	{
+		// _mm256_mul_epu32は偶数レーンどうしの64ビットの積なので、奇数レーンは32ビットずらして掛ける
+		__m256i evenProducts = _mm256_mul_epu32(multiplier, value);
+		__m256i oddProducts = _mm256_mul_epu32(multiplier, _mm256_srli_epi64(value, 32));
+		*pLow = _mm256_blend_epi32(evenProducts, _mm256_slli_epi64(oddProducts, 32), 0xaa);
+		*pHigh = _mm256_blend_epi32(_mm256_srli_epi64(evenProducts, 32), oddProducts, 0xaa);
+	}
+
+	RANDOM_TARGET_AVX2 void StoreResult(uint32_t* pDst, __m256i value)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst), value);
+	}
+
+	RANDOM_TARGET_AVX2 void StoreResult(float* pDst, __m256i value)
+	{
+		__m256 unitFloat = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(value, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+		_mm256_storeu_ps(pDst, unitFloat);
+	}
+
+	// GenerateRandom4()を8レーンで行う
+	template<typename T>
+	RANDOM_TARGET_AVX2 void GenerateAVX2(uint32_t firstId, uint32_t count, uint32_t frame, uint32_t stream, uint32_t seed, T* const pResults[4])
+	{
+		const __m256i multiplier0 = _mm256_set1_epi32(static_cast<int32_t>(PHILOX_MULTIPLIER_0));
+		const __m256i multiplier1 = _mm256_set1_epi32(static_cast<int32_t>(PHILOX_MULTIPLIER_1));
+		const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+		// キーはレーン間で同じなので、ラウンドごとの値を先に作っておく
+		__m256i roundKeys0[PHILOX_ROUNDS];
+		__m256i roundKeys1[PHILOX_ROUNDS];
+		for (uint32_t round = 0; round < PHILOX_ROUNDS; round++)
+		{
+			roundKeys0[round] = _mm256_set1_epi32(static_cast<int32_t>(seed + round * PHILOX_WEYL_0));
+			roundKeys1[round] = _mm256_set1_epi32(static_cast<int32_t>(round * PHILOX_WEYL_1));
+		}
+
+		uint32_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(firstId + i)), laneOffsets);
+			__m256i c1 = _mm256_set1_epi32(static_cast<int32_t>(frame));
+			__m256i c2 = _mm256_set1_epi32(static_cast<int32_t>(stream));
+			__m256i c3 = _mm256_setzero_si256();
+
+			for (uint32_t round = 0; round < PHILOX_ROUNDS; round++)
+			{
+				__m256i low0, high0, low1, high1;
+				MultiplyHighLow(multiplier0, c0, &low0, &high0);
+				MultiplyHighLow(multiplier1, c2, &low1, &high1);
+
+				c0 = _mm256_xor_si256(_mm256_xor_si256(high1, c1), roundKeys0[round]);
+				c1 = low1;
+				c2 = _mm256_xor_si256(_mm256_xor_si256(high0, c3), roundKeys1[round]);
+				c3 = low0;
+			}
+
+			if (pResults[0] != nullptr)
+			{
+				StoreResult(&pResults[0][i], c0);
+			}
+			if (pResults[1] != nullptr)
+			{
+				StoreResult(&pResults[1][i], c1);
+			}
+			if (pResults[2] != nullptr)
+			{
+				StoreResult(&pResults[2][i], c2);
+			}
+			if (pResults[3] != nullptr)
+			{
+				StoreResult(&pResults[3][i], c3);
+			}
+		}
+
+		// 端数はスカラー版で処理する。SSEの命令に戻る前にYMMの上位を明示的にクリアしておく
+		_mm256_zeroupper();
+		GenerateScalar(firstId, i, count, frame, stream, seed, pResults);
+	}
+
+	template<typename T>
+	void Generate(uint32_t firstId, uint32_t count, uint32_t frame, uint32_t stream, uint32_t seed, T* const pResults[4], bool useAVX2)
+	{
+		if (useAVX2 && IsAVX2Supported())
+		{
+			GenerateAVX2(firstId, count, frame, stream, seed, pResults);
+		}
+		else
+		{
+			GenerateScalar(firstId, 0, count, frame, stream, seed, pResults);
+		}
+	}
+}
+
+void GenerateRandomBatch(uint32_t firstId, uint32_t count, uint32_t frame, uint32_t stream, uint32_t seed, uint32_t* const pResults[4], bool useAVX2)
+{
+	Generate(firstId, count, frame, stream, seed, pResults, useAVX2);
+}
+
+void GenerateRandomUnitFloatBatch(uint32_t firstId, uint32_t count, uint32_t frame, uint32_t stream, uint32_t seed, float* const pResults[4], bool useAVX2)
+{
+	Generate(firstId, count, frame, stream, seed, pResults, useAVX2);
+}
@@ -0,0 +1,44 @@
+﻿#include "CpuFeatures.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+	bool DetectAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		// OSXSAVEとAVX
+		static constexpr int OSXSAVE_AND_AVX = (1 << 27) | (1 << 28);
+		__cpuid(info, 1);
+		if ((info[2] & OSXSAVE_AND_AVX) != OSXSAVE_AND_AVX)
+		{
+			return false;
+		}
+
+		// OSがXMMとYMMを退避するか
+		if ((_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+}
+
+bool IsAVX2Supported()
+{
+	static const bool isSupported = DetectAVX2();
+	return isSupported;
+}
@@ -0,0 +1,579 @@
+﻿#include "CpuPathTracer.h"
+#include "CounterBasedRandom.h"
+#include "ParallelFor.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+using namespace DirectX::SimpleMath;
+
+namespace
+{
+	static constexpr float F_PI = 3.14159265358979323846f;
+	// DeferredLightingPS.hlslのMIN_DIST
+	static constexpr float MIN_DIST = 0.01f;
+	// 自己交差を避けるため、交点から幾何法線の方向にずらす距離
+	static constexpr float RAY_EPSILON = 1e-3f;
+	// ComputeBRDF()のD_GGX()が発散しないよう、ラフネスをこれ以上にする
+	static constexpr float MIN_ROUGHNESS = 0.03f;
+	// ロシアンルーレットで残す確率の上限
+	static constexpr float MAX_SURVIVAL_PROBABILITY = 0.95f;
+
+	float Saturate(float value)
+	{
+		return std::min(std::max(value, 0.0f), 1.0f);
+	}
+
+	float Luminance(const Vector3& color)
+	{
+		return color.x * 0.2126f + color.y * 0.7152f + color.z * 0.0722f;
+	}
+
+	bool IsFinite(const Vector3& v)
+	{
+		return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+	}
+
+	// Nを3番目の軸とする正規直交基底。
+	// Tom Duff et al., "Building an Orthonormal Basis, Revisited", 2017
+	void BuildOrthonormalBasis(const Vector3& N, Vector3& T, Vector3& B)
+	{
+		float sign = std::copysign(1.0f, N.z);
+		float a = -1.0f / (sign + N.z);
+		float b = N.x * N.y * a;
+		T = Vector3(1.0f + sign * N.x * N.x * a, sign * b, -sign * N.x);
+		B = Vector3(b, sign + N.y * N.y * a, -N.y);
+	}
+
+	// 以下はBRDF.hlsliと同じ式
+	Vector3 SchlickFresnel(const Vector3& f0, const Vector3& f90, float VH)
+	{
+		return f0 + (f90 - f0) * powf(Saturate(1.0f - VH), 5.0f);
+	}
+
+	float D_GGX(float NdotH, float alphaRoughness)
+	{
+		float alphaRoughnessSq = alphaRoughness * alphaRoughness;
+		float f = (NdotH * NdotH) * (alphaRoughnessSq - 1.0f) + 1.0f;
+		return alphaRoughnessSq / std::max(F_PI * f * f, 1e-8f);
+	}
+
+	float V_GGX(float NdotL, float NdotV, float alphaRoughness)
+	{
+		float alphaRoughnessSq = alphaRoughness * alphaRoughness;
+
+		float GGXV = NdotL * sqrtf(NdotV * NdotV * (1.0f - alphaRoughnessSq) + alphaRoughnessSq);
+		float GGXL = NdotV * sqrtf(NdotL * NdotL * (1.0f - alphaRoughnessSq) + alphaRoughnessSq);
+
+		float GGX = GGXV + GGXL;
+		if (GGX > 0.0f)
+		{
+			return 0.5f / GGX;
+		}
+		else
+		{
+			return 0.0f;
+		}
+	}
+
+	Vector3 ComputeF0(const Vector3& baseColor, float metallic)
+	{
+		return Vector3::Lerp(Vector3(0.04f, 0.04f, 0.04f), baseColor, metallic);
+	}
+
+	Vector3 ComputeBRDF
+	(
+		const Vector3& baseColor,
+		float metallic,
+		float roughness,
+		float VdotH,
+		float NdotH,
+		float NdotV,
+		float NdotL
+	)
+	{
+		const Vector3& cDiff = baseColor * (1.0f - metallic);
+		const Vector3& f0 = ComputeF0(baseColor, metallic);
+		const Vector3& f90 = Vector3(1.0f, 1.0f, 1.0f);
+
+		const Vector3& diffuseTerm = cDiff * (1.0f / F_PI);
+
+		float alpha = roughness * roughness;
+		float D = D_GGX(NdotH, alpha);
+		float V = V_GGX(NdotL, NdotV, alpha);
+		float specularTerm = D * V;
+
+		const Vector3& F = SchlickFresnel(f0, f90, VdotH);
+
+		// lerp(diffuseTerm, specularTerm, F)
+		return (diffuseTerm + (Vector3(specularTerm, specularTerm, specularTerm) - diffuseTerm) * F) * NdotL;
+	}
+
+	Vector3 ComputeBRDF(const PathTracerMaterial& material, const Vector3& N, const Vector3& V, const Vector3& L)
+	{
+		Vector3 H = V + L;
+		H.Normalize();
+		return ComputeBRDF
+		(
+			material.BaseColor,
+			material.Metallic,
+			material.Roughness,
+			Saturate(V.Dot(H)),
+			Saturate(N.Dot(H)),
+			Saturate(N.Dot(V)),
+			Saturate(N.Dot(L))
+		);
+	}
+
+	// 以下はDeferredLightingPS.hlslと同じ式
+	float SmoothDistanceAttenuation(float squareDistance, float invSqrAttRadius)
+	{
+		float factor = squareDistance * invSqrAttRadius;
+		float smoothFactor = Saturate(1.0f - factor * factor);
+		return smoothFactor * smoothFactor;
+	}
+
+	float GetAngleAttenuation(const Vector3& normalizedLightVector, const Vector3& lightDir, float lightAngleScale, float lightAngleOffset)
+	{
+		float cd = lightDir.Dot(normalizedLightVector);
+		float attenuation = Saturate(cd * lightAngleScale + lightAngleOffset);
+		attenuation *= attenuation;
+		return attenuation;
+	}
+
+	// 拡散をコサイン分布、鏡面をGGXの法線分布で選ぶときの、鏡面を選ぶ確率
+	float ComputeSpecularProbability(const PathTracerMaterial& material, float NdotV)
+	{
+		const Vector3& F = SchlickFresnel(ComputeF0(material.BaseColor, material.Metallic), Vector3(1.0f, 1.0f, 1.0f), NdotV);
+		float specularWeight = Luminance(F);
+		float diffuseWeight = Luminance(material.BaseColor * (1.0f - material.Metallic)) * (1.0f - specularWeight);
+		if (diffuseWeight <= 0.0f)
+		{
+			return 1.0f;
+		}
+
+		return std::min(std::max(specularWeight / (specularWeight + diffuseWeight), 0.1f), 0.9f);
+	}
+
+	// 混合分布でLを選んだときの確率密度
+	float ComputeSamplingPdf(const PathTracerMaterial& material, const Vector3& N, const Vector3& V, const Vector3& L, float specularProbability)
+	{
+		float NdotL = N.Dot(L);
+		if (NdotL <= 0.0f)
+		{
+			return 0.0f;
+		}
+
+		Vector3 H = V + L;
+		H.Normalize();
+		float NdotH = Saturate(N.Dot(H));
+		float VdotH = std::max(V.Dot(H), 1e-6f);
+		float alpha = material.Roughness * material.Roughness;
+
+		float diffusePdf = NdotL / F_PI;
+		float specularPdf = D_GGX(NdotH, alpha) * NdotH / (4.0f * VdotH);
+		return specularProbability * specularPdf + (1.0f - specularProbability) * diffusePdf;
+	}
+
+	// 混合分布でLを選ぶ
+	Vector3 SampleDirection(const PathTracerMaterial& material, const Vector3& N, const Vector3& V, float specularProbability, float lobeRandom, float u1, float u2)
+	{
+		Vector3 T;
+		Vector3 B;
+		BuildOrthonormalBasis(N, T, B);
+
+		float phi = 2.0f * F_PI * u1;
+		if (lobeRandom < specularProbability)
+		{
+			float alpha = material.Roughness * material.Roughness;
+			float cosTheta = sqrtf((1.0f - u2) / (1.0f + (alpha * alpha - 1.0f) * u2));
+			float sinTheta = sqrtf(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+			const Vector3& H = T * (sinTheta * cosf(phi)) + B * (sinTheta * sinf(phi)) + N * cosTheta;
+			return H * (2.0f * V.Dot(H)) - V;
+		}
+
+		float cosTheta = sqrtf(1.0f - u2);
+		float sinTheta = sqrtf(u2);
+		return T * (sinTheta * cosf(phi)) + B * (sinTheta * sinf(phi)) + N * cosTheta;
+	}
+}
+
+bool CpuPathTracer::Init
+(
+	const std::vector<Vector3>& positions,
+	const std::vector<Vector3>& normals,
+	const std::vector<uint32_t>& meshIndices,
+	const std::vector<PathTracerMaterial>& meshMaterials,
+	const PathTracerSettings& settings
+)
+{
+	Term();
+
+	if (normals.size() != positions.size())
+	{
+		ELOG("Error : Invalid Arguments. positions = %zu, normals = %zu", positions.size(), normals.size());
+		return false;
+	}
+
+	for (uint32_t meshIdx : meshIndices)
+	{
+		if (meshIdx >= meshMaterials.size())
+		{
+			ELOG("Error : Invalid Arguments. meshIdx = %u, meshMaterials = %zu", meshIdx, meshMaterials.size());
+			return false;
+		}
+	}
+
+	BvhBuildSettings bvhSettings;
+	if (!m_Bvh.Build(positions, meshIndices, bvhSettings))
+	{
+		ELOG("Error : TriangleBvh::Build() Failed.");
+		return false;
+	}
+
+	m_Settings = settings;
+	m_Settings.TileSize = std::max(m_Settings.TileSize, 1u);
+	m_Normals = normals;
+	m_GeometricNormals.resize(meshIndices.size());
+	for (size_t i = 0; i < meshIndices.size(); i++)
+	{
+		Vector3 geometricNormal = (positions[i * 3 + 1] - positions[i * 3 + 0]).Cross(positions[i * 3 + 2] - positions[i * 3 + 0]);
+		geometricNormal.Normalize();
+		m_GeometricNormals[i] = geometricNormal;
+	}
+	m_Materials = meshMaterials;
+	for (PathTracerMaterial& material : m_Materials)
+	{
+		material.Roughness = std::max(material.Roughness, MIN_ROUGHNESS);
+	}
+
+	return true;
+}
+
+void CpuPathTracer::Term()
+{
+	m_Bvh.Term();
+	m_Normals.clear();
+	m_Normals.shrink_to_fit();
+	m_GeometricNormals.clear();
+	m_GeometricNormals.shrink_to_fit();
+	m_Materials.clear();
+	m_DirectionalLights.clear();
+	m_PointLights.clear();
+	m_SpotLights.clear();
+	m_Accumulation.clear();
+	m_Accumulation.shrink_to_fit();
+	m_Width = 0;
+	m_Height = 0;
+	m_SampleCount = 0;
+	m_LastRayCount = 0;
+	m_LastMilliseconds = 0.0;
+}
+
+void CpuPathTracer::SetResolution(uint32_t width, uint32_t height)
+{
+	m_Width = width;
+	m_Height = height;
+	m_Accumulation.resize(static_cast<size_t>(width) * height * 3);
+	ResetAccumulation();
+}
+
+void CpuPathTracer::SetCamera(const Vector3& position, const Matrix& invViewProj)
+{
+	m_CameraPosition = position;
+	m_InvViewProj = invViewProj;
+	ResetAccumulation();
+}
+
+void CpuPathTracer::SetLights
+(
+	const std::vector<PathTracerDirectionalLight>& directionalLights,
+	const std::vector<PathTracerPointLight>& pointLights,
+	const std::vector<PathTracerSpotLight>& spotLights
+)
+{
+	m_DirectionalLights = directionalLights;
+	m_PointLights = pointLights;
+	m_SpotLights = spotLights;
+	ResetAccumulation();
+}
+
+void CpuPathTracer::ResetAccumulation()
+{
+	std::fill(m_Accumulation.begin(), m_Accumulation.end(), 0.0);
+	m_SampleCount = 0;
+}
+
+void CpuPathTracer::RenderSample()
+{
+	if (m_Width == 0 || m_Height == 0 || m_Bvh.GetTriangleCount() == 0)
+	{
+		return;
+	}
+
+	const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+
+	uint32_t tileSize = m_Settings.TileSize;
+	uint32_t tileCountX = (m_Width + tileSize - 1) / tileSize;
+	uint32_t tileCountY = (m_Height + tileSize - 1) / tileSize;
+	std::vector<uint64_t> tileRayCounts(tileCountX * tileCountY);
+
+	ParallelFor(tileCountX * tileCountY, 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t tileIdx = begin; tileIdx < end; tileIdx++)
+		{
+			uint32_t beginX = (tileIdx % tileCountX) * tileSize;
+			uint32_t beginY = (tileIdx / tileCountX) * tileSize;
+			uint32_t endX = std::min(beginX + tileSize, m_Width);
+			uint32_t endY = std::min(beginY + tileSize, m_Height);
+
+			uint64_t rayCount = 0;
+			for (uint32_t y = beginY; y < endY; y++)
+			{
+				for (uint32_t x = beginX; x < endX; x++)
+				{
+					uint32_t pixelIdx = y * m_Width + x;
+					const Vector3& radiance = TracePath(pixelIdx, x, y, rayCount);
+					double* pAccumulation = &m_Accumulation[static_cast<size_t>(pixelIdx) * 3];
+					pAccumulation[0] += radiance.x;
+					pAccumulation[1] += radiance.y;
+					pAccumulation[2] += radiance.z;
+				}
+			}
+			tileRayCounts[tileIdx] = rayCount;
+		}
+	});
+
+	m_SampleCount++;
+
+	m_LastRayCount = 0;
+	for (uint64_t rayCount : tileRayCounts)
+	{
+		m_LastRayCount += rayCount;
+	}
+
+	const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+	m_LastMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+Vector3 CpuPathTracer::TracePath(uint32_t pixelIdx, uint32_t x, uint32_t y, uint64_t& rayCount) const
+{
+	// ストリーム0はピクセル内の位置、ストリームb + 1はb回目の反射に使う
+	uint32_t random[4];
+	GenerateRandom4(pixelIdx, m_SampleCount, 0, m_Settings.RandomSeed, random);
+
+	// PathTracing.hlslのrayGeneration()と同じく、ニアクリップ面上の点に向けて飛ばす
+	float ndcX = (x + RandomToUnitFloat(random[0])) / m_Width * 2.0f - 1.0f;
+	float ndcY = 1.0f - (y + RandomToUnitFloat(random[1])) / m_Height * 2.0f;
+	Vector3 direction = Vector3::Transform(Vector3(ndcX, ndcY, 1.0f), m_InvViewProj) - m_CameraPosition;
+	direction.Normalize();
+	Vector3 origin = m_CameraPosition;
+
+	Vector3 radiance(0.0f, 0.0f, 0.0f);
+	Vector3 throughput(1.0f, 1.0f, 1.0f);
+
+	for (uint32_t bounce = 0; bounce <= m_Settings.MaxBounces; bounce++)
+	{
+		TriangleHit hit;
+		rayCount++;
+		if (!m_Bvh.Intersect(origin, direction, FLT_MAX, hit))
+		{
+			radiance += throughput * m_Settings.SkyRadiance;
+			break;
+		}
+
+		const PathTracerMaterial& material = m_Materials[hit.MeshIdx];
+		const Vector3* pNormals = &m_Normals[static_cast<size_t>(hit.TriangleIdx) * 3];
+		Vector3 N = pNormals[0] * (1.0f - hit.U - hit.V) + pNormals[1] * hit.U + pNormals[2] * hit.V;
+		N.Normalize();
+
+		// 両面とも表として扱い、幾何法線と頂点法線をレイの来た側に向ける
+		Vector3 geometricNormal = m_GeometricNormals[hit.TriangleIdx];
+		if (geometricNormal.Dot(direction) > 0.0f)
+		{
+			geometricNormal = -geometricNormal;
+		}
+		if (N.Dot(geometricNormal) < 0.0f)
+		{
+			N = -N;
+		}
+
+		const Vector3& V = -direction;
+		const Vector3& position = origin + direction * hit.T + geometricNormal * RAY_EPSILON;
+
+		radiance += throughput * (material.Emissive + EvaluateLights(material, position, N, V, rayCount));
+
+		if (bounce == m_Settings.MaxBounces)
+		{
+			break;
+		}
+
+		GenerateRandom4(pixelIdx, m_SampleCount, bounce + 1, m_Settings.RandomSeed, random);
+
+		float specularProbability = ComputeSpecularProbability(material, Saturate(N.Dot(V)));
+		Vector3 L = SampleDirection(material, N, V, specularProbability, RandomToUnitFloat(random[0]), RandomToUnitFloat(random[1]), RandomToUnitFloat(random[2]));
+		L.Normalize();
+		if (L.Dot(geometricNormal) <= 0.0f)
+		{
+			break;
+		}
+
+		float pdf = ComputeSamplingPdf(material, N, V, L, specularProbability);
+		if (pdf <= 0.0f)
+		{
+			break;
+		}
+
+		throughput *= ComputeBRDF(material, N, V, L) / pdf;
+
+		if (bounce + 1 >= m_Settings.RussianRouletteBounce)
+		{
+			float survivalProbability = std::min(std::max({throughput.x, throughput.y, throughput.z}), MAX_SURVIVAL_PROBABILITY);
+			if (RandomToUnitFloat(random[3]) >= survivalProbability)
+			{
+				break;
+			}
+			throughput /= survivalProbability;
+		}
+
+		if (!IsFinite(throughput))
+		{
+			break;
+		}
+
+		origin = position;
+		direction = L;
+	}
+
+	return radiance;
+}
+
+Vector3 CpuPathTracer::EvaluateLights
+(
+	const PathTracerMaterial& material,
+	const Vector3& position,
+	const Vector3& N,
+	const Vector3& V,
+	uint64_t& rayCount
+) const
+{
+	Vector3 result(0.0f, 0.0f, 0.0f);
+
+	for (const PathTracerDirectionalLight& light : m_DirectionalLights)
+	{
+		Vector3 L = -light.Forward;
+		L.Normalize();
+		if (N.Dot(L) <= 0.0f)
+		{
+			continue;
+		}
+
+		rayCount++;
+		if (!m_Bvh.IsOccluded(position, L, FLT_MAX))
+		{
+			result += ComputeBRDF(material, N, V, L) * light.Color;
+		}
+	}
+
+	for (const PathTracerPointLight& light : m_PointLights)
+	{
+		const Vector3& unnormalizedLightVector = light.Position - position;
+		float sqrDist = unnormalizedLightVector.LengthSquared();
+		float attenuation = 1.0f / std::max(sqrDist, MIN_DIST * MIN_DIST) * SmoothDistanceAttenuation(sqrDist, light.InvSqrRadius);
+		float dist = sqrtf(sqrDist);
+		const Vector3& L = unnormalizedLightVector / dist;
+		if (attenuation <= 0.0f || N.Dot(L) <= 0.0f)
+		{
+			continue;
+		}
+
+		rayCount++;
+		if (!m_Bvh.IsOccluded(position, L, dist))
+		{
+			result += ComputeBRDF(material, N, V, L) * light.Color * (attenuation / (4.0f * F_PI) * light.Intensity);
+		}
+	}
+
+	for (const PathTracerSpotLight& light : m_SpotLights)
+	{
+		const Vector3& unnormalizedLightVector = light.Position - position;
+		float sqrDist = unnormalizedLightVector.LengthSquared();
+		float dist = sqrtf(sqrDist);
+		const Vector3& L = unnormalizedLightVector / dist;
+		// DeferredLightingPS.hlslのEvaluateSpotLight()と同じく距離の減衰は逆2乗だけ
+		float attenuation = 1.0f / std::max(sqrDist, MIN_DIST * MIN_DIST) * GetAngleAttenuation(L, -light.Forward, light.AngleScale, light.AngleOffset);
+		if (attenuation <= 0.0f || N.Dot(L) <= 0.0f)
+		{
+			continue;
+		}
+
+		rayCount++;
+		if (!m_Bvh.IsOccluded(position, L, dist))
+		{
+			result += ComputeBRDF(material, N, V, L) * light.Color * (attenuation / F_PI * light.Intensity);
+		}
+	}
+
+	return result;
+}
+
+void CpuPathTracer::Resolve(std::vector<float>& pixels) const
+{
+	pixels.resize(m_Accumulation.size());
+	double scale = 1.0 / std::max(m_SampleCount, 1u);
+	for (size_t i = 0; i < m_Accumulation.size(); i++)
+	{
+		pixels[i] = static_cast<float>(m_Accumulation[i] * scale);
+	}
+}
+
+bool CpuPathTracer::SaveHDR(const wchar_t* path) const
+{
+	std::vector<float> pixels;
+	Resolve(pixels);
+
+	std::ofstream stream(std::filesystem::path(path), std::ios::binary);
+	if (!stream)
+	{
+		ELOG("Error : Failed to open HDR image. path = %ls", path);
+		return false;
+	}
+
+	stream << "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " << m_Height << " +X " << m_Width << "\n";
+
+	// ランレングス圧縮はせず、ピクセルごとに共通の指数を持つRGBEで書く
+	std::vector<uint8_t> rgbe(static_cast<size_t>(m_Width) * m_Height * 4);
+	for (size_t i = 0; i < static_cast<size_t>(m_Width) * m_Height; i++)
+	{
+		float r = std::max(pixels[i * 3 + 0], 0.0f);
+		float g = std::max(pixels[i * 3 + 1], 0.0f);
+		float b = std::max(pixels[i * 3 + 2], 0.0f);
+		float maxValue = std::max({r, g, b});
+
+		uint8_t* pRGBE = &rgbe[i * 4];
+		if (maxValue < 1e-32f || !std::isfinite(maxValue))
+		{
+			pRGBE[0] = pRGBE[1] = pRGBE[2] = pRGBE[3] = 0;
+			continue;
+		}
+
+		int exponent;
+		float scale = frexpf(maxValue, &exponent) * 256.0f / maxValue;
+		pRGBE[0] = static_cast<uint8_t>(r * scale);
+		pRGBE[1] = static_cast<uint8_t>(g * scale);
+		pRGBE[2] = static_cast<uint8_t>(b * scale);
+		pRGBE[3] = static_cast<uint8_t>(exponent + 128);
+	}
+
+	stream.write(reinterpret_cast<const char*>(rgbe.data()), rgbe.size());
+	if (!stream)
+	{
+		ELOG("Error : Failed to write HDR image. path = %ls", path);
+		return false;
+	}
+
+	return true;
+}
@@ -1,5 +1,11 @@
 #include "DescriptorPool.h"
 
+namespace
+{
+	// nh̊mۂƉ͕XbhĂ΂̂ŁAXbhƂɏ󂫂𒙂߂Ă
+	static constexpr uint32_t HANDLE_MAGAZINE_SIZE = 8;
+}
+
 DescriptorPool::DescriptorPool()
 : m_RefCount(1)
 , m_Pool()
@@ -11,6 +17,7 @@ DescriptorPool::DescriptorPool()
 DescriptorPool::~DescriptorPool()
 {
 	m_Pool.Term();
+	m_TransientRing.Term();
 	m_pHeap.Reset();
 	m_pHeap = nullptr;
 	m_DescriptorSize = 0;
@@ -19,10 +26,12 @@ DescriptorPool::~DescriptorPool()
 bool DescriptorPool::Create(
 	ID3D12Device* pDevice,
 	const D3D12_DESCRIPTOR_HEAP_DESC* pDesc,
+	uint32_t transientCount,
+	uint32_t maxTransientFrameCount,
 	DescriptorPool** ppPool
 )
 {
-	if (pDevice == nullptr || pDesc == nullptr || ppPool == nullptr)
+	if (pDevice == nullptr || pDesc == nullptr || ppPool == nullptr || transientCount >= pDesc->NumDescriptors)
 	{
 		return false;
 	}
@@ -43,7 +52,13 @@ bool DescriptorPool::Create(
 		return false;
 	}
 
-	if (!instance->m_Pool.Init(pDesc->NumDescriptors))
+	if (!instance->m_Pool.Init(pDesc->NumDescriptors - transientCount, HANDLE_MAGAZINE_SIZE))
+	{
+		instance->Release();
+		return false;
+	}
+
+	if (transientCount > 0 && !instance->m_TransientRing.Init(transientCount, maxTransientFrameCount))
 	{
 		instance->Release();
 		return false;
@@ -108,6 +123,56 @@ void DescriptorPool::FreeHandle(DescriptorHandle*& pHandle)
 	}
 }
 
+bool DescriptorPool::AllocTransientHandles(uint32_t count, DescriptorHandle& handle)
+{
+	uint64_t offset = m_TransientRing.Allocate(count, 1);
+	if (offset == RingAllocator::INVALID_OFFSET)
+	{
+		return false;
+	}
+
+	uint32_t index = m_Pool.GetSize() + static_cast<uint32_t>(offset);
+	handle.m_IndexInDescriptorHeap = index;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE handleCPU = m_pHeap->GetCPUDescriptorHandleForHeapStart();
+	handleCPU.ptr += m_DescriptorSize * index;
+	handle.HandleCPU = handleCPU;
+
+	if (m_IsShaderVisible)
+	{
+		D3D12_GPU_DESCRIPTOR_HANDLE handleGPU = m_pHeap->GetGPUDescriptorHandleForHeapStart();
+		handleGPU.ptr += m_DescriptorSize * index;
+		handle.HandleGPU = handleGPU;
+	}
+
+	return true;
+}
+
+bool DescriptorPool::EndTransientFrame(uint64_t fenceValue)
+{
+	if (m_TransientRing.GetCapacity() == 0)
+	{
+		return true;
+	}
+
+	return m_TransientRing.EndFrame(fenceValue);
+}
+
+void DescriptorPool::RetireTransientFrames(uint64_t completedFenceValue)
+{
+	m_TransientRing.Retire(completedFenceValue);
+}
+
+const RingAllocatorFrameStats& DescriptorPool::GetLastTransientFrameStats() const
+{
+	return m_TransientRing.GetLastFrameStats();
+}
+
+uint64_t DescriptorPool::GetTransientHighWaterMark() const
+{
+	return m_TransientRing.GetHighWaterMark();
+}
+
 uint32_t DescriptorPool::GetAvailableHandleCount() const
 {
 	return m_Pool.GetAvailableCount();
@@ -123,6 +188,11 @@ uint32_t DescriptorPool::GetHandleCount() const
 	return m_Pool.GetSize();
 }
 
+uint32_t DescriptorPool::GetDescriptorSize() const
+{
+	return m_DescriptorSize;
+}
+
 ID3D12DescriptorHeap* const DescriptorPool::GetHeap() const
 {
 	return m_pHeap.Get();
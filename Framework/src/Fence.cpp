@@ -111,3 +111,56 @@ void Fence::Sync(ID3D12CommandQueue* pQueue)
 
 	m_Counter++;
 }
+
+UINT64 Fence::Signal(ID3D12CommandQueue* pQueue)
+{
+	if (pQueue == nullptr)
+	{
+		return 0;
+	}
+
+	const UINT fenceValue = m_Counter;
+	HRESULT hr = pQueue->Signal(m_pFence.Get(), fenceValue);
+	if (FAILED(hr))
+	{
+		return 0;
+	}
+
+	m_Counter++;
+
+	return fenceValue;
+}
+
+void Fence::WaitForValue(UINT64 fenceValue, UINT timeout)
+{
+	if (m_pFence == nullptr || m_pFence->GetCompletedValue() >= fenceValue)
+	{
+		return;
+	}
+
+	HRESULT hr = m_pFence->SetEventOnCompletion(fenceValue, m_Event);
+	if (FAILED(hr))
+	{
+		return;
+	}
+
+	if (WAIT_OBJECT_0 != WaitForSingleObjectEx(m_Event, timeout, FALSE))
+	{
+		return;
+	}
+}
+
+UINT64 Fence::GetNextValue() const
+{
+	return m_Counter;
+}
+
+UINT64 Fence::GetCompletedValue() const
+{
+	if (m_pFence == nullptr)
+	{
+		return 0;
+	}
+
+	return m_pFence->GetCompletedValue();
+}
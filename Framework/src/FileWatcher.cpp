@@ -0,0 +1,54 @@
+﻿#include "FileWatcher.h"
+#include <algorithm>
+
+FileWatcher::FileWatcher()
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	Clear();
+}
+
+void FileWatcher::Watch(const std::wstring& path)
+{
+	if (m_Files.find(path) != m_Files.end())
+	{
+		return;
+	}
+
+	Entry entry;
+	std::error_code ec;
+	entry.WriteTime = std::filesystem::last_write_time(path, ec);
+	entry.Exists = !ec;
+	m_Files.emplace(path, entry);
+}
+
+void FileWatcher::Clear()
+{
+	m_Files.clear();
+}
+
+void FileWatcher::Poll(std::vector<std::wstring>& changedFiles)
+{
+	changedFiles.clear();
+	for (std::pair<const std::wstring, Entry>& file : m_Files)
+	{
+		std::error_code ec;
+		const std::filesystem::file_time_type& writeTime = std::filesystem::last_write_time(file.first, ec);
+		if (ec)
+		{
+			// 書き直している途中かもしれないので、現れるまで待つ
+			file.second.Exists = false;
+			continue;
+		}
+
+		if (!file.second.Exists || writeTime != file.second.WriteTime)
+		{
+			changedFiles.push_back(file.first);
+		}
+		file.second.Exists = true;
+		file.second.WriteTime = writeTime;
+	}
+	std::sort(changedFiles.begin(), changedFiles.end());
+}
@@ -0,0 +1,44 @@
+﻿#include "FixedTimestep.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+void FixedTimestep::Init(double stepTime, uint32_t maxStepsPerFrame)
+{
+	assert(stepTime > 0.0);
+	assert(maxStepsPerFrame > 0);
+
+	m_StepTime = stepTime;
+	m_MaxStepsPerFrame = maxStepsPerFrame;
+	m_Accumulator = 0.0;
+	m_TotalStepCount = 0;
+	m_DroppedTime = 0.0;
+}
+
+void FixedTimestep::Reset()
+{
+	m_Accumulator = 0.0;
+}
+
+uint32_t FixedTimestep::Advance(double elapsedTime)
+{
+	m_Accumulator += std::max(elapsedTime, 0.0);
+
+	uint32_t numSteps = 0;
+	while (m_Accumulator >= m_StepTime && numSteps < m_MaxStepsPerFrame)
+	{
+		m_Accumulator -= m_StepTime;
+		numSteps++;
+	}
+
+	// 上限で打ち切った分は1ステップ未満の端数だけ残して捨てる
+	if (m_Accumulator >= m_StepTime)
+	{
+		double remainder = fmod(m_Accumulator, m_StepTime);
+		m_DroppedTime += m_Accumulator - remainder;
+		m_Accumulator = remainder;
+	}
+
+	m_TotalStepCount += numSteps;
+	return numSteps;
+}
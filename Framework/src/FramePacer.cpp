@@ -0,0 +1,66 @@
+﻿#include "FramePacer.h"
+#include "Logger.h"
+
+FramePacer::FramePacer()
+: m_LastFenceValue(0)
+{
+}
+
+FramePacer::~FramePacer()
+{
+	Term();
+}
+
+bool FramePacer::Init(uint32_t frameCount)
+{
+	if (frameCount == 0)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return false;
+	}
+
+	m_FenceValues.assign(frameCount, 0);
+	m_LastFenceValue = 0;
+	m_Stats = FramePacerStats();
+
+	return true;
+}
+
+void FramePacer::Term()
+{
+	m_FenceValues.clear();
+	m_LastFenceValue = 0;
+}
+
+void FramePacer::EndFrame(uint32_t frameIndex, uint64_t fenceValue)
+{
+	if (frameIndex >= m_FenceValues.size() || fenceValue <= m_LastFenceValue)
+	{
+		ELOG("Error : Invalid Arguments. frameIndex = %u, fenceValue = %llu", frameIndex, static_cast<unsigned long long>(fenceValue));
+		return;
+	}
+
+	m_FenceValues[frameIndex] = fenceValue;
+	m_LastFenceValue = fenceValue;
+	m_Stats.FrameCount++;
+}
+
+void FramePacer::Reset()
+{
+	// 前のフェンスの値より大きいことの検証のためにm_LastFenceValueは残す
+	m_FenceValues.assign(m_FenceValues.size(), 0);
+}
+
+uint32_t FramePacer::GetFramesInFlight(uint64_t completedFenceValue) const
+{
+	uint32_t count = 0;
+	for (uint64_t fenceValue : m_FenceValues)
+	{
+		if (fenceValue > completedFenceValue)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,230 @@
+﻿#include "JobGraph.h"
+#include "Logger.h"
+#include "ParallelFor.h"
+#include <algorithm>
+
+JobGraph::JobGraph()
+: m_HasInvalidJob(false)
+, m_ReadyHead(0)
+, m_FinishedJobCount(0)
+, m_IsFailed(false)
+{
+}
+
+JobGraph::~JobGraph()
+{
+	Clear();
+}
+
+void JobGraph::Clear()
+{
+	m_Jobs.clear();
+	m_Timeline.clear();
+	m_Stats = JobGraphStats();
+	m_HasInvalidJob = false;
+}
+
+uint32_t JobGraph::AddJob(const char* name, const std::vector<uint32_t>& dependencies, std::function<bool(uint32_t workerIndex)> func)
+{
+	uint32_t jobIdx = static_cast<uint32_t>(m_Jobs.size());
+
+	// 前に登録したジョブにしか依存できないので、循環はできない
+	for (uint32_t dependency : dependencies)
+	{
+		if (dependency >= jobIdx)
+		{
+			ELOG("Error : Invalid Job Dependency. name = %s, dependency = %u", name, dependency);
+			m_HasInvalidJob = true;
+			return INVALID_INDEX;
+		}
+	}
+
+	Job job;
+	job.Name = name;
+	job.Dependencies = dependencies;
+	job.Func = std::move(func);
+	m_Jobs.emplace_back(std::move(job));
+
+	for (uint32_t dependency : dependencies)
+	{
+		m_Jobs[dependency].Dependents.push_back(jobIdx);
+	}
+
+	return jobIdx;
+}
+
+bool JobGraph::Run(uint32_t workerCount)
+{
+	if (m_HasInvalidJob || workerCount == 0)
+	{
+		ELOG("Error : Invalid Job Graph.");
+		return false;
+	}
+
+	uint32_t jobCount = static_cast<uint32_t>(m_Jobs.size());
+	workerCount = std::min(workerCount, std::max(jobCount, 1u));
+
+	m_Timeline.assign(jobCount, JobTimelineEntry());
+	m_RemainingDependencyCounts.resize(jobCount);
+	m_ReadyJobs.clear();
+	m_ReadyJobs.reserve(jobCount);
+	for (uint32_t jobIdx = 0; jobIdx < jobCount; jobIdx++)
+	{
+		m_RemainingDependencyCounts[jobIdx] = static_cast<uint32_t>(m_Jobs[jobIdx].Dependencies.size());
+		if (m_RemainingDependencyCounts[jobIdx] == 0)
+		{
+			m_ReadyJobs.push_back(jobIdx);
+		}
+	}
+	m_ReadyHead = 0;
+	m_FinishedJobCount = 0;
+	m_IsFailed = false;
+	m_StartTime = std::chrono::steady_clock::now();
+
+	// ワーカーごとに1つのチャンクにする。同じスレッドが2つのチャンクを続けて処理しても、前のワーカーは全て終えてから抜けるので止まらない
+	ParallelFor(workerCount, 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t workerIndex = begin; workerIndex < end; workerIndex++)
+		{
+			RunWorker(workerIndex);
+		}
+	});
+
+	const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+	m_Stats = JobGraphStats();
+	m_Stats.JobCount = jobCount;
+	m_Stats.WorkerCount = workerCount;
+	m_Stats.TotalMilliseconds = std::chrono::duration<double, std::milli>(end - m_StartTime).count();
+	for (const JobTimelineEntry& entry : m_Timeline)
+	{
+		m_Stats.SerialMilliseconds += entry.EndMilliseconds - entry.StartMilliseconds;
+	}
+	FindCriticalPath();
+
+	m_RemainingDependencyCounts.clear();
+	m_ReadyJobs.clear();
+
+	return !m_IsFailed;
+}
+
+void JobGraph::RunWorker(uint32_t workerIndex)
+{
+	uint32_t jobCount = static_cast<uint32_t>(m_Jobs.size());
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_ReadyCV.wait(lock, [&]() { return m_IsFailed || m_FinishedJobCount == jobCount || m_ReadyHead < m_ReadyJobs.size(); });
+		if (m_IsFailed || m_FinishedJobCount == jobCount)
+		{
+			return;
+		}
+
+		uint32_t jobIdx = m_ReadyJobs[m_ReadyHead++];
+		lock.unlock();
+
+		const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+		bool isSucceeded = m_Jobs[jobIdx].Func(workerIndex);
+		const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+		lock.lock();
+
+		JobTimelineEntry& entry = m_Timeline[jobIdx];
+		entry.WorkerIndex = workerIndex;
+		entry.StartMilliseconds = std::chrono::duration<double, std::milli>(start - m_StartTime).count();
+		entry.EndMilliseconds = std::chrono::duration<double, std::milli>(end - m_StartTime).count();
+		m_FinishedJobCount++;
+
+		if (!isSucceeded)
+		{
+			ELOG("Error : Job Failed. name = %s", m_Jobs[jobIdx].Name.c_str());
+			m_IsFailed = true;
+			m_ReadyCV.notify_all();
+			return;
+		}
+
+		for (uint32_t dependent : m_Jobs[jobIdx].Dependents)
+		{
+			if (--m_RemainingDependencyCounts[dependent] == 0)
+			{
+				m_ReadyJobs.push_back(dependent);
+			}
+		}
+
+		// 新しく実行できるようになったジョブか、全て終えたことを待っているワーカーに知らせる
+		m_ReadyCV.notify_all();
+	}
+}
+
+void JobGraph::FindCriticalPath()
+{
+	uint32_t jobCount = static_cast<uint32_t>(m_Jobs.size());
+	if (jobCount == 0)
+	{
+		return;
+	}
+
+	// 依存は前のジョブにしか向かないので、登録順に1回なめれば各ジョブで終わる鎖の最長が求まる
+	std::vector<double> pathMilliseconds(jobCount, 0.0);
+	std::vector<uint32_t> predecessors(jobCount, INVALID_INDEX);
+	uint32_t lastJobIdx = 0;
+	for (uint32_t jobIdx = 0; jobIdx < jobCount; jobIdx++)
+	{
+		double longest = 0.0;
+		for (uint32_t dependency : m_Jobs[jobIdx].Dependencies)
+		{
+			if (predecessors[jobIdx] == INVALID_INDEX || pathMilliseconds[dependency] > longest)
+			{
+				longest = pathMilliseconds[dependency];
+				predecessors[jobIdx] = dependency;
+			}
+		}
+
+		const JobTimelineEntry& entry = m_Timeline[jobIdx];
+		pathMilliseconds[jobIdx] = longest + (entry.EndMilliseconds - entry.StartMilliseconds);
+		if (pathMilliseconds[jobIdx] > pathMilliseconds[lastJobIdx])
+		{
+			lastJobIdx = jobIdx;
+		}
+	}
+
+	m_Stats.CriticalPathMilliseconds = pathMilliseconds[lastJobIdx];
+	for (uint32_t jobIdx = lastJobIdx; jobIdx != INVALID_INDEX; jobIdx = predecessors[jobIdx])
+	{
+		m_Timeline[jobIdx].IsCritical = true;
+	}
+}
+
+void JobGraph::LogTimeline() const
+{
+	std::vector<uint32_t> order(m_Timeline.size());
+	for (uint32_t jobIdx = 0; jobIdx < order.size(); jobIdx++)
+	{
+		order[jobIdx] = jobIdx;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+	{
+		return m_Timeline[a].StartMilliseconds < m_Timeline[b].StartMilliseconds;
+	});
+
+	for (uint32_t jobIdx : order)
+	{
+		const JobTimelineEntry& entry = m_Timeline[jobIdx];
+		ELOG("  %c %8.2f - %8.2f ms (%7.2f ms) worker %2u : %s",
+			entry.IsCritical ? '*' : ' ',
+			entry.StartMilliseconds,
+			entry.EndMilliseconds,
+			entry.EndMilliseconds - entry.StartMilliseconds,
+			entry.WorkerIndex,
+			m_Jobs[jobIdx].Name.c_str());
+	}
+
+	// 合計がクリティカルパスに近ければ依存の鎖が、ジョブの合計 / ワーカー数に近ければワーカーの数が律速している
+	ELOG("JobGraph : %u jobs on %u workers, %.2f ms (serial %.2f ms, critical path %.2f ms)",
+		m_Stats.JobCount,
+		m_Stats.WorkerCount,
+		m_Stats.TotalMilliseconds,
+		m_Stats.SerialMilliseconds,
+		m_Stats.CriticalPathMilliseconds);
+}
@@ -1,7 +1,52 @@
 #include "Logger.h"
 #include <Windows.h>
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
+#include <new>
+
+namespace
+{
+	// 4096Ŗ2MBBÑ[hňxɂoĂ̂ĂȂx
+	static constexpr uint32_t LOG_QUEUE_CAPACITY = 4096;
+	// oXbh܂Ƃ߂Sinkɓn傫̖ڈ
+	static constexpr size_t LOG_FLUSH_SIZE = 16 * 1024;
+	// bZ[WtH[}bgƂ̍ŏ̑傫BȂ΍LĂxtH[}bg
+	static constexpr size_t LOG_MESSAGE_SIZE = 2048;
+	// N˂͂ȂAÔߐQĂĂ̊ԊuŌɍs
+	static constexpr uint32_t LOG_SLEEP_TIMEOUT_MS = 100;
+
+	void WriteToConsole(const char* text, size_t length)
+	{
+		// R\[ɏo
+		fwrite(text, 1, length, stdout);
+		fflush(stdout);
+
+		// VisualStudiȍo̓EBhEɏo
+		OutputDebugStringA(text);
+	}
+
+	// vȌIɎcoăXbh~߂
+	struct LoggerTerminator
+	{
+		AsyncLogger* pLogger;
+
+		~LoggerTerminator()
+		{
+			pLogger->Term();
+		}
+	};
+
+	AsyncLogger* CreateLogger()
+	{
+		AsyncLogger* pLogger = new AsyncLogger();
+		pLogger->Init(LOG_QUEUE_CAPACITY, WriteToConsole);
+
+		// ɍX^eBbNȃIuWFNg̃fXgN^̃ÓATerm()̌Ȃ̂ŌĂяoXbhŏo
+		static LoggerTerminator s_Terminator = {pLogger};
+		return pLogger;
+	}
+}
 
 void OutputLog(const char* format, ...)
 {
@@ -19,3 +64,311 @@ void OutputLog(const char* format, ...)
 	// VisualStudiȍo̓EBhEɏo
 	OutputDebugStringA(msg);
 }
+
+AsyncLogger& GetLogger()
+{
+	// Iɂǂ̃X^eBbNȃIuWFNg̃fXgN^Ă΂Ăg悤ɁAK[͉̂Ȃ
+	static AsyncLogger* s_pLogger = CreateLogger();
+	return *s_pLogger;
+}
+
+AsyncLogger::AsyncLogger()
+: m_pSlots(nullptr)
+, m_Capacity(0)
+, m_IsRunning(false)
+, m_WriterCount(0)
+, m_EnqueuePosition(0)
+, m_DequeuePosition(0)
+, m_WrittenCount(0)
+, m_DroppedCount(0)
+, m_TruncatedCount(0)
+, m_IsSleeping(false)
+, m_IsTerminating(false)
+{
+}
+
+AsyncLogger::~AsyncLogger()
+{
+	Term();
+}
+
+bool AsyncLogger::Init(uint32_t capacity, Sink sink)
+{
+	Term();
+
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0 || !sink)
+	{
+		return false;
+	}
+
+	m_pSlots = new (std::nothrow) Slot[capacity];
+	if (m_pSlots == nullptr)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < capacity; i++)
+	{
+		m_pSlots[i].Sequence.store(i, std::memory_order_relaxed);
+	}
+
+	m_Capacity = capacity;
+	m_Sink = std::move(sink);
+	m_StartTime = std::chrono::steady_clock::now();
+	m_EnqueuePosition.store(0, std::memory_order_relaxed);
+	m_DequeuePosition.store(0, std::memory_order_relaxed);
+	m_WrittenCount.store(0, std::memory_order_relaxed);
+	m_DroppedCount.store(0, std::memory_order_relaxed);
+	m_TruncatedCount.store(0, std::memory_order_relaxed);
+	m_IsSleeping.store(false, std::memory_order_relaxed);
+	m_IsTerminating = false;
+
+	m_IsRunning.store(true, std::memory_order_release);
+	m_Thread = std::thread([this]() { Run(); });
+
+	return true;
+}
+
+void AsyncLogger::Term()
+{
+	if (m_Thread.joinable())
+	{
+		// ȍ~Write()͌ĂяoXbhŏo
+		m_IsRunning.store(false, std::memory_order_seq_cst);
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_IsTerminating = true;
+		}
+		m_WakeCV.notify_one();
+		m_FlushedCV.notify_all();
+		m_Thread.join();
+	}
+
+	// m_IsRunningĂ̂Write()̓XbgI܂m_WriterCount𑫂܂܂ɂĂB
+	// Ƃɑ̂̓XbgɐGȂ̂ŁA0ɂȂ̂҂ĂΉĂ
+	while (m_WriterCount.load(std::memory_order_seq_cst) != 0)
+	{
+		std::this_thread::yield();
+	}
+
+	delete[] m_pSlots;
+	m_pSlots = nullptr;
+	m_Capacity = 0;
+}
+
+void AsyncLogger::Flush()
+{
+	if (!m_IsRunning.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	uint64_t position = m_EnqueuePosition.load(std::memory_order_acquire);
+
+	// ŌTerm()n܂ƁAXbh͎coďIANĂȂ
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_WakeCV.notify_one();
+	m_FlushedCV.wait(lock, [&]() { return m_IsTerminating || m_DequeuePosition.load(std::memory_order_acquire) >= position; });
+}
+
+LogStats AsyncLogger::GetStats() const
+{
+	LogStats stats;
+	stats.WrittenCount = m_WrittenCount.load(std::memory_order_relaxed);
+	stats.DroppedCount = m_DroppedCount.load(std::memory_order_relaxed);
+	stats.TruncatedCount = m_TruncatedCount.load(std::memory_order_relaxed);
+	return stats;
+}
+
+AsyncLogger::Record* AsyncLogger::BeginRecord(uint64_t& position)
+{
+	// Term()m_IsRunning𗎂ƂĂm_WriterCount̂ŁAǂseq_cstɂĂ΁A
+	// Ă͕̂̂KTerm()ɐĂ
+	m_WriterCount.fetch_add(1, std::memory_order_seq_cst);
+	if (!m_IsRunning.load(std::memory_order_seq_cst))
+	{
+		m_WriterCount.fetch_sub(1, std::memory_order_release);
+		static thread_local Record s_SyncRecord;
+		position = UINT64_MAX;
+		return &s_SyncRecord;
+	}
+
+	uint64_t enqueuePosition = m_EnqueuePosition.load(std::memory_order_relaxed);
+	while (true)
+	{
+		Slot& slot = m_pSlots[enqueuePosition & (m_Capacity - 1)];
+		int64_t diff = static_cast<int64_t>(slot.Sequence.load(std::memory_order_acquire) - enqueuePosition);
+		if (diff == 0)
+		{
+			// senqueuePositionɍ̒l̂ŁÂ܂܎
+			if (m_EnqueuePosition.compare_exchange_weak(enqueuePosition, enqueuePosition + 1, std::memory_order_relaxed))
+			{
+				position = enqueuePosition;
+				return &slot.Data;
+			}
+		}
+		else if (diff < 0)
+		{
+			// 1ÕR[h܂oĂȂ
+			m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+			m_WriterCount.fetch_sub(1, std::memory_order_release);
+			return nullptr;
+		}
+		else
+		{
+			enqueuePosition = m_EnqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void AsyncLogger::EndRecord(Record* pRecord, uint64_t position)
+{
+	if (position == UINT64_MAX)
+	{
+		std::lock_guard<std::mutex> lock(m_SyncMutex);
+		if (m_Sink)
+		{
+			m_SyncText.clear();
+			FormatRecord(*pRecord, m_SyncText);
+			m_WrittenCount.fetch_add(1, std::memory_order_relaxed);
+			m_SyncText.push_back('\0');
+			m_Sink(m_SyncText.data(), m_SyncText.size() - 1);
+		}
+		else if (pRecord->pReleaseFunc != nullptr)
+		{
+			pRecord->pReleaseFunc(pRecord->Payload);
+		}
+		return;
+	}
+
+	m_pSlots[position & (m_Capacity - 1)].Sequence.store(position + 1, std::memory_order_release);
+
+	// oXbh͐QOm_IsSleeping𗧂ĂĂXbĝŁAǂ炩KɋCÂB
+	// QĂ̂ƂAbNĂN̂ŋN˂Ȃ
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_IsSleeping.load(std::memory_order_relaxed))
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+		}
+		m_WakeCV.notify_one();
+	}
+
+	m_WriterCount.fetch_sub(1, std::memory_order_release);
+}
+
+void AsyncLogger::FormatRecord(const Record& record, std::vector<char>& text)
+{
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::duration(record.Timestamp) - m_StartTime.time_since_epoch()).count();
+
+	char header[512];
+	int headerLength = snprintf(header, sizeof(header), "[%10.3f][File : %s, Line : %u]", seconds, record.File, record.Line);
+	if (headerLength > 0)
+	{
+		text.insert(text.end(), header, header + std::min<size_t>(headerLength, sizeof(header) - 1));
+	}
+
+	size_t offset = text.size();
+	text.resize(offset + LOG_MESSAGE_SIZE);
+	int length = record.pFormatFunc(text.data() + offset, LOG_MESSAGE_SIZE, record.Format, record.Payload);
+	if (length >= static_cast<int>(LOG_MESSAGE_SIZE))
+	{
+		// ͓̂傫ɂĂx
+		text.resize(offset + length + 1);
+		length = record.pFormatFunc(text.data() + offset, length + 1, record.Format, record.Payload);
+	}
+	text.resize(offset + std::max(length, 0));
+
+	if (record.pReleaseFunc != nullptr)
+	{
+		record.pReleaseFunc(record.Payload);
+	}
+	if ((record.ArgFlags & LogDetail::ARG_FLAG_TRUNCATED) != 0)
+	{
+		m_TruncatedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void AsyncLogger::Run()
+{
+	std::vector<char> text;
+	text.reserve(LOG_FLUSH_SIZE * 2);
+	uint64_t position = m_DequeuePosition.load(std::memory_order_relaxed);
+	uint64_t reportedDroppedCount = 0;
+
+	while (true)
+	{
+		// ς܂Ă镪SătH[}bgAx܂珑o
+		uint32_t count = 0;
+		while (true)
+		{
+			Slot& slot = m_pSlots[position & (m_Capacity - 1)];
+			if (slot.Sequence.load(std::memory_order_acquire) != position + 1)
+			{
+				break;
+			}
+
+			FormatRecord(slot.Data, text);
+			slot.Sequence.store(position + m_Capacity, std::memory_order_release);
+			position++;
+			count++;
+
+			if (text.size() >= LOG_FLUSH_SIZE)
+			{
+				text.push_back('\0');
+				m_Sink(text.data(), text.size() - 1);
+				text.clear();
+			}
+		}
+
+		// ̂Ă̂΁A̐ô̍Ōɑ
+		uint64_t droppedCount = m_DroppedCount.load(std::memory_order_relaxed);
+		if (droppedCount != reportedDroppedCount)
+		{
+			char message[128];
+			int length = snprintf(message, sizeof(message), "[Logger] %llu messages dropped. total = %llu\n",
+				static_cast<unsigned long long>(droppedCount - reportedDroppedCount),
+				static_cast<unsigned long long>(droppedCount));
+			text.insert(text.end(), message, message + std::max(length, 0));
+			reportedDroppedCount = droppedCount;
+		}
+
+		if (!text.empty())
+		{
+			text.push_back('\0');
+			m_Sink(text.data(), text.size() - 1);
+			text.clear();
+		}
+
+		if (count > 0)
+		{
+			m_WrittenCount.fetch_add(count, std::memory_order_relaxed);
+			m_DequeuePosition.store(position, std::memory_order_release);
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+			}
+			m_FlushedCV.notify_all();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		if (m_IsTerminating)
+		{
+			// Xbgmۂ܂܏ݒ̂̂҂
+			if (m_WriterCount.load(std::memory_order_seq_cst) == 0 && m_EnqueuePosition.load(std::memory_order_acquire) == position)
+			{
+				return;
+			}
+			lock.unlock();
+			std::this_thread::yield();
+			continue;
+		}
+
+		m_IsSleeping.store(true, std::memory_order_seq_cst);
+		if (m_pSlots[position & (m_Capacity - 1)].Sequence.load(std::memory_order_seq_cst) != position + 1)
+		{
+			m_WakeCV.wait_for(lock, std::chrono::milliseconds(LOG_SLEEP_TIMEOUT_MS));
+		}
+		m_IsSleeping.store(false, std::memory_order_relaxed);
+	}
+}
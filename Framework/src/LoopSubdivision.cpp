@@ -0,0 +1,722 @@
+﻿#include "LoopSubdivision.h"
+#include "ParallelFor.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+using namespace DirectX::SimpleMath;
+
+namespace
+{
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+	// ステンシルテーブルを並列に作るときの1チャンクの行数
+	static constexpr uint32_t BUILD_GRAIN_SIZE = 4096;
+
+	// 1レベル上の頂点の重み付き和
+	struct LocalStencil
+	{
+		std::vector<uint32_t> Indices;
+		std::vector<float> Weights;
+
+		void Clear()
+		{
+			Indices.clear();
+			Weights.clear();
+		}
+
+		void Add(uint32_t index, float weight)
+		{
+			Indices.push_back(index);
+			Weights.push_back(weight);
+		}
+
+		void Scale(float scale)
+		{
+			for (float& weight : Weights)
+			{
+				weight *= scale;
+			}
+		}
+	};
+
+	struct PositionKey
+	{
+		uint32_t Bits[3];
+
+		bool operator==(const PositionKey& rhs) const
+		{
+			return Bits[0] == rhs.Bits[0] && Bits[1] == rhs.Bits[1] && Bits[2] == rhs.Bits[2];
+		}
+	};
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& key) const
+		{
+			return (static_cast<size_t>(key.Bits[0]) * 73856093u) ^ (static_cast<size_t>(key.Bits[1]) * 19349663u) ^ (static_cast<size_t>(key.Bits[2]) * 83492791u);
+		}
+	};
+
+	// 細分割前の1レベル分の状態
+	struct LevelState
+	{
+		SubdTopology Topology;
+		SubdAdjacency Adjacency;
+		// 三角形の角ごとのResMeshの頂点インデックス
+		const std::vector<uint32_t>* pIndices;
+		uint32_t AttributeCount;
+
+		uint32_t GetAttribute(uint32_t triangle, uint32_t position) const
+		{
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				if (Topology.FaceVertexIndices[triangle * 3 + i] == position)
+				{
+					return (*pIndices)[triangle * 3 + i];
+				}
+			}
+			return INVALID_INDEX;
+		}
+
+		uint32_t GetOppositeVertex(uint32_t triangle, uint32_t edge) const
+		{
+			uint32_t v0 = Adjacency.EdgeVertices[edge * 2 + 0];
+			uint32_t v1 = Adjacency.EdgeVertices[edge * 2 + 1];
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				uint32_t vertex = Topology.FaceVertexIndices[triangle * 3 + i];
+				if (vertex != v0 && vertex != v1)
+				{
+					return vertex;
+				}
+			}
+			return INVALID_INDEX;
+		}
+
+		// 2つの三角形で共有され、両端の属性が両側で同じならtrue
+		bool IsAttributeContinuous(uint32_t edge) const
+		{
+			if (Adjacency.EdgeFaceCounts[edge] != 2)
+			{
+				return false;
+			}
+
+			uint32_t t0 = Adjacency.EdgeFaces[edge * 2 + 0];
+			uint32_t t1 = Adjacency.EdgeFaces[edge * 2 + 1];
+			uint32_t v0 = Adjacency.EdgeVertices[edge * 2 + 0];
+			uint32_t v1 = Adjacency.EdgeVertices[edge * 2 + 1];
+			return GetAttribute(t0, v0) == GetAttribute(t1, v0) && GetAttribute(t0, v1) == GetAttribute(t1, v1);
+		}
+	};
+
+	// Loopのエッジの点 : スムースは3/8(v0 + v1) + 1/8(a + b)、シャープは中点
+	void ComputeEdgePointStencil(const LevelState& state, uint32_t edge, LocalStencil& stencil)
+	{
+		const SubdAdjacency& adjacency = state.Adjacency;
+		uint32_t v0 = adjacency.EdgeVertices[edge * 2 + 0];
+		uint32_t v1 = adjacency.EdgeVertices[edge * 2 + 1];
+
+		stencil.Clear();
+
+		float sharpness = adjacency.IsBoundaryEdge(edge) ? SUBD_INFINITE_SHARPNESS : adjacency.EdgeSharpness[edge];
+		if (sharpness >= 1.0f)
+		{
+			stencil.Add(v0, 0.5f);
+			stencil.Add(v1, 0.5f);
+			return;
+		}
+
+		stencil.Add(v0, 0.375f);
+		stencil.Add(v1, 0.375f);
+		stencil.Add(state.GetOppositeVertex(adjacency.EdgeFaces[edge * 2 + 0], edge), 0.125f);
+		stencil.Add(state.GetOppositeVertex(adjacency.EdgeFaces[edge * 2 + 1], edge), 0.125f);
+
+		if (sharpness > 0.0f)
+		{
+			stencil.Scale(1.0f - sharpness);
+			stencil.Add(v0, 0.5f * sharpness);
+			stencil.Add(v1, 0.5f * sharpness);
+		}
+	}
+
+	// Loopの頂点の点 : スムースは(1 - nβ)v + βΣe、クリースは3/4v + 1/8(a + b)、コーナーは動かさない
+	void ComputeVertexPointStencil(const LevelState& state, uint32_t vertex, LocalStencil& stencil)
+	{
+		const SubdAdjacency& adjacency = state.Adjacency;
+		uint32_t edgeBegin = adjacency.VertexEdgeOffsets[vertex];
+		uint32_t edgeEnd = adjacency.VertexEdgeOffsets[vertex + 1];
+		uint32_t valence = edgeEnd - edgeBegin;
+
+		stencil.Clear();
+
+		uint32_t sharpNeighbors[2] = {};
+		uint32_t sharpEdgeCount = 0;
+		float sharpnessSum = 0.0f;
+		bool isBoundary = false;
+		bool isNonManifold = false;
+		for (uint32_t i = edgeBegin; i < edgeEnd; i++)
+		{
+			uint32_t edge = adjacency.VertexEdges[i];
+			if (adjacency.EdgeFaceCounts[edge] > 2)
+			{
+				isNonManifold = true;
+			}
+
+			if (adjacency.IsSharpEdge(edge))
+			{
+				if (sharpEdgeCount < 2)
+				{
+					sharpNeighbors[sharpEdgeCount] = (adjacency.EdgeVertices[edge * 2 + 0] == vertex) ? adjacency.EdgeVertices[edge * 2 + 1] : adjacency.EdgeVertices[edge * 2 + 0];
+				}
+				sharpEdgeCount++;
+
+				bool isBoundaryEdge = adjacency.IsBoundaryEdge(edge);
+				isBoundary |= isBoundaryEdge;
+				sharpnessSum += isBoundaryEdge ? SUBD_INFINITE_SHARPNESS : adjacency.EdgeSharpness[edge];
+			}
+		}
+
+		if (valence == 0 || isNonManifold || sharpEdgeCount > 2 || (isBoundary && sharpEdgeCount != 2))
+		{
+			stencil.Add(vertex, 1.0f);
+			return;
+		}
+
+		float sharpness = (sharpEdgeCount == 0) ? 0.0f : std::min(sharpnessSum / sharpEdgeCount, 1.0f);
+		if (sharpEdgeCount == 1)
+		{
+			// ダーツはスムースのルール
+			sharpness = 0.0f;
+		}
+
+		if (sharpness < 1.0f)
+		{
+			// Loopのオリジナルの係数
+			float n = static_cast<float>(valence);
+			float c = 0.375f + 0.25f * cosf(DirectX::XM_2PI / n);
+			float beta = (0.625f - c * c) / n;
+
+			stencil.Add(vertex, 1.0f - n * beta);
+			for (uint32_t i = edgeBegin; i < edgeEnd; i++)
+			{
+				uint32_t edge = adjacency.VertexEdges[i];
+				stencil.Add((adjacency.EdgeVertices[edge * 2 + 0] == vertex) ? adjacency.EdgeVertices[edge * 2 + 1] : adjacency.EdgeVertices[edge * 2 + 0], beta);
+			}
+
+			if (sharpness <= 0.0f)
+			{
+				return;
+			}
+
+			// セミシャープはスムースとクリースの線形補間
+			stencil.Scale(1.0f - sharpness);
+		}
+
+		stencil.Add(vertex, 0.75f * sharpness);
+		stencil.Add(sharpNeighbors[0], 0.125f * sharpness);
+		stencil.Add(sharpNeighbors[1], 0.125f * sharpness);
+	}
+
+	// 位置のステンシルの頂点を、attribute周りの三角形での属性に置き換える
+	bool MapToAttributes(const LevelState& state, const std::vector<uint32_t>& triangles, LocalStencil& stencil)
+	{
+		for (uint32_t& index : stencil.Indices)
+		{
+			uint32_t attribute = INVALID_INDEX;
+			for (uint32_t triangle : triangles)
+			{
+				attribute = state.GetAttribute(triangle, index);
+				if (attribute != INVALID_INDEX)
+				{
+					break;
+				}
+			}
+
+			if (attribute == INVALID_INDEX)
+			{
+				return false;
+			}
+			index = attribute;
+		}
+
+		return true;
+	}
+
+	// 頂点の属性の点。属性が連続な範囲（同じ属性を共有する三角形の扇）の中では位置と同じルール、
+	// 範囲がシームで区切られていればシームに沿ったクリースのルールで補間する
+	void ComputeVertexAttributeStencil(const LevelState& state, uint32_t attribute, uint32_t vertex, std::vector<uint32_t>& regionTriangles, LocalStencil& stencil)
+	{
+		const SubdAdjacency& adjacency = state.Adjacency;
+
+		regionTriangles.clear();
+		for (uint32_t i = adjacency.VertexFaceOffsets[vertex]; i < adjacency.VertexFaceOffsets[vertex + 1]; i++)
+		{
+			uint32_t triangle = adjacency.VertexFaces[i];
+			if (state.GetAttribute(triangle, vertex) == attribute)
+			{
+				regionTriangles.push_back(triangle);
+			}
+		}
+
+		stencil.Clear();
+		if (regionTriangles.empty())
+		{
+			// どの三角形からも参照されていない頂点
+			stencil.Add(attribute, 1.0f);
+			return;
+		}
+
+		// 範囲の縁になるエッジ。seamCountは属性が不連続なもの
+		uint32_t boundaryNeighbors[2] = {};
+		uint32_t boundaryCount = 0;
+		uint32_t seamCount = 0;
+		for (uint32_t i = adjacency.VertexEdgeOffsets[vertex]; i < adjacency.VertexEdgeOffsets[vertex + 1]; i++)
+		{
+			uint32_t edge = adjacency.VertexEdges[i];
+			uint32_t t0 = adjacency.EdgeFaces[edge * 2 + 0];
+			uint32_t t1 = (adjacency.EdgeFaceCounts[edge] >= 2) ? adjacency.EdgeFaces[edge * 2 + 1] : INVALID_INDEX;
+			bool inRegion0 = std::find(regionTriangles.begin(), regionTriangles.end(), t0) != regionTriangles.end();
+			bool inRegion1 = (t1 != INVALID_INDEX) && std::find(regionTriangles.begin(), regionTriangles.end(), t1) != regionTriangles.end();
+			if (!inRegion0 && !inRegion1)
+			{
+				continue;
+			}
+
+			if (adjacency.IsBoundaryEdge(edge) || !state.IsAttributeContinuous(edge))
+			{
+				if (!adjacency.IsBoundaryEdge(edge))
+				{
+					seamCount++;
+				}
+
+				if (boundaryCount < 2)
+				{
+					uint32_t other = (adjacency.EdgeVertices[edge * 2 + 0] == vertex) ? adjacency.EdgeVertices[edge * 2 + 1] : adjacency.EdgeVertices[edge * 2 + 0];
+					boundaryNeighbors[boundaryCount] = state.GetAttribute(inRegion0 ? t0 : t1, other);
+				}
+				boundaryCount++;
+			}
+		}
+
+		ComputeVertexPointStencil(state, vertex, stencil);
+		if (seamCount == 0)
+		{
+			if (!MapToAttributes(state, regionTriangles, stencil))
+			{
+				stencil.Clear();
+				stencil.Add(attribute, 1.0f);
+			}
+			return;
+		}
+
+		// 位置がコーナーのとき、シームが境界に達するとき、シームが分岐するときは属性も動かさない
+		bool isCorner = (stencil.Indices.size() == 1);
+		stencil.Clear();
+		if (isCorner || seamCount != 2 || boundaryCount != 2)
+		{
+			stencil.Add(attribute, 1.0f);
+			return;
+		}
+
+		stencil.Add(attribute, 0.75f);
+		stencil.Add(boundaryNeighbors[0], 0.125f);
+		stencil.Add(boundaryNeighbors[1], 0.125f);
+	}
+
+	// triangleのlocalEdge番目のエッジの属性の点。属性が不連続なエッジでは三角形側の両端の中点
+	void ComputeEdgeAttributeStencil(const LevelState& state, uint32_t triangle, uint32_t localEdge, std::vector<uint32_t>& regionTriangles, LocalStencil& stencil)
+	{
+		uint32_t edge = state.Adjacency.FaceEdges[triangle * 3 + localEdge];
+
+		stencil.Clear();
+		if (!state.IsAttributeContinuous(edge))
+		{
+			stencil.Add((*state.pIndices)[triangle * 3 + localEdge], 0.5f);
+			stencil.Add((*state.pIndices)[triangle * 3 + (localEdge + 1) % 3], 0.5f);
+			return;
+		}
+
+		regionTriangles.clear();
+		regionTriangles.push_back(state.Adjacency.EdgeFaces[edge * 2 + 0]);
+		regionTriangles.push_back(state.Adjacency.EdgeFaces[edge * 2 + 1]);
+
+		ComputeEdgePointStencil(state, edge, stencil);
+		MapToAttributes(state, regionTriangles, stencil);
+	}
+
+	// rowCount行のステンシルを並列に計算してresultに並べる
+	void BuildStencilTable(uint32_t rowCount, const std::function<void(uint32_t row, std::vector<uint32_t>& work, LocalStencil& stencil)>& computeRow, StencilTable& result)
+	{
+		uint32_t chunkCount = (rowCount + BUILD_GRAIN_SIZE - 1) / BUILD_GRAIN_SIZE;
+		std::vector<StencilTable> chunkTables(chunkCount);
+
+		ParallelFor(rowCount, BUILD_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+		{
+			StencilTable& table = chunkTables[begin / BUILD_GRAIN_SIZE];
+			std::vector<uint32_t> work;
+			LocalStencil stencil;
+
+			for (uint32_t row = begin; row < end; row++)
+			{
+				computeRow(row, work, stencil);
+				table.AddStencil(static_cast<uint32_t>(stencil.Indices.size()), stencil.Indices.data(), stencil.Weights.data());
+			}
+		});
+
+		result.Clear();
+		for (const StencilTable& table : chunkTables)
+		{
+			result.Append(table);
+		}
+	}
+
+	template<typename T>
+	void ApplyLevel(const StencilTable& table, std::vector<T>& src, std::vector<T>& dst)
+	{
+		dst.resize(table.GetStencilCount());
+		table.Apply(src.data(), dst.data());
+		src.swap(dst);
+	}
+}
+
+LoopSubdivision::~LoopSubdivision()
+{
+	Term();
+}
+
+bool LoopSubdivision::Init(const ResMesh& mesh, uint32_t maxLevel, bool creaseSplitNormals, const std::vector<SubdCrease>& creases)
+{
+	Term();
+
+	if (maxLevel == 0)
+	{
+		ELOG("Error : maxLevel must be 1 or more.");
+		return false;
+	}
+
+	if (mesh.Indices.size() % 3 != 0)
+	{
+		ELOG("Error : Mesh is not a triangle list.");
+		return false;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	m_Levels.resize(maxLevel + 1);
+
+	// 位置が同じ頂点を溶接する
+	Level& base = m_Levels[0];
+	uint32_t attributeCount = static_cast<uint32_t>(mesh.Vertices.size());
+	base.AttributeToPosition.resize(attributeCount);
+	{
+		std::unordered_map<PositionKey, uint32_t, PositionKeyHash> positionMap;
+		positionMap.reserve(attributeCount);
+
+		for (uint32_t i = 0; i < attributeCount; i++)
+		{
+			PositionKey key;
+			memcpy(key.Bits, &mesh.Vertices[i].Position, sizeof(key.Bits));
+			const auto& result = positionMap.emplace(key, base.PositionCount);
+			if (result.second)
+			{
+				base.PositionCount++;
+			}
+			base.AttributeToPosition[i] = result.first->second;
+		}
+	}
+
+	// 溶接すると潰れる三角形は取り除く
+	base.Indices.reserve(mesh.Indices.size());
+	for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+	{
+		uint32_t p0 = base.AttributeToPosition[mesh.Indices[i + 0]];
+		uint32_t p1 = base.AttributeToPosition[mesh.Indices[i + 1]];
+		uint32_t p2 = base.AttributeToPosition[mesh.Indices[i + 2]];
+		if (p0 != p1 && p1 != p2 && p2 != p0)
+		{
+			base.Indices.insert(base.Indices.end(), &mesh.Indices[i], &mesh.Indices[i] + 3);
+		}
+	}
+
+	if (base.Indices.size() != mesh.Indices.size())
+	{
+		ELOG("Warning : %zu degenerate triangles are removed.", (mesh.Indices.size() - base.Indices.size()) / 3);
+	}
+
+	LevelState state;
+	state.Topology.VertexCount = base.PositionCount;
+	for (const SubdCrease& crease : creases)
+	{
+		if (crease.V0 < attributeCount && crease.V1 < attributeCount)
+		{
+			state.Topology.Creases.push_back({base.AttributeToPosition[crease.V0], base.AttributeToPosition[crease.V1], crease.Sharpness});
+		}
+	}
+
+	for (uint32_t level = 0; level < maxLevel; level++)
+	{
+		const Level& parent = m_Levels[level];
+		Level& child = m_Levels[level + 1];
+
+		std::chrono::steady_clock::time_point levelStart = std::chrono::steady_clock::now();
+
+		state.Topology.VertexCount = parent.PositionCount;
+		state.Topology.FaceVertexCounts.assign(parent.Indices.size() / 3, 3);
+		state.Topology.FaceVertexIndices.resize(parent.Indices.size());
+		for (size_t i = 0; i < parent.Indices.size(); i++)
+		{
+			state.Topology.FaceVertexIndices[i] = parent.AttributeToPosition[parent.Indices[i]];
+		}
+		state.pIndices = &parent.Indices;
+		state.AttributeCount = static_cast<uint32_t>(parent.AttributeToPosition.size());
+
+		if (!BuildAdjacency(state.Topology, state.Adjacency))
+		{
+			ELOG("Error : BuildAdjacency() Failed. level = %u", level);
+			Term();
+			return false;
+		}
+
+		const SubdAdjacency& adjacency = state.Adjacency;
+		uint32_t triangleCount = adjacency.GetFaceCount();
+		uint32_t edgeCount = adjacency.GetEdgeCount();
+
+		if (level == 0 && creaseSplitNormals)
+		{
+			// 法線が分割されているエッジは元のメッシュのハードエッジ
+			for (uint32_t edge = 0; edge < edgeCount; edge++)
+			{
+				if (adjacency.EdgeFaceCounts[edge] != 2)
+				{
+					continue;
+				}
+
+				uint32_t t0 = adjacency.EdgeFaces[edge * 2 + 0];
+				uint32_t t1 = adjacency.EdgeFaces[edge * 2 + 1];
+				uint32_t v0 = adjacency.EdgeVertices[edge * 2 + 0];
+				uint32_t v1 = adjacency.EdgeVertices[edge * 2 + 1];
+				if (mesh.Vertices[state.GetAttribute(t0, v0)].Normal != mesh.Vertices[state.GetAttribute(t1, v0)].Normal
+				 || mesh.Vertices[state.GetAttribute(t0, v1)].Normal != mesh.Vertices[state.GetAttribute(t1, v1)].Normal)
+				{
+					state.Adjacency.EdgeSharpness[edge] = SUBD_INFINITE_SHARPNESS;
+				}
+			}
+		}
+
+		// 子の位置は頂点の点、エッジの点の順
+		child.PositionCount = parent.PositionCount + edgeCount;
+
+		// 子の属性は頂点の属性、エッジの属性の順。属性が連続なエッジは1つ、不連続なエッジは三角形ごとに持つ
+		std::vector<uint32_t> cornerEdgeAttributes(triangleCount * 3);
+		std::vector<uint32_t> edgeAttributeSources;
+		{
+			std::vector<uint32_t> sharedEdgeAttributes(edgeCount, INVALID_INDEX);
+			for (uint32_t i = 0; i < triangleCount * 3; i++)
+			{
+				uint32_t edge = adjacency.FaceEdges[i];
+				bool isShared = state.IsAttributeContinuous(edge);
+				if (isShared && sharedEdgeAttributes[edge] != INVALID_INDEX)
+				{
+					cornerEdgeAttributes[i] = sharedEdgeAttributes[edge];
+					continue;
+				}
+
+				cornerEdgeAttributes[i] = state.AttributeCount + static_cast<uint32_t>(edgeAttributeSources.size());
+				edgeAttributeSources.push_back(i);
+				if (isShared)
+				{
+					sharedEdgeAttributes[edge] = cornerEdgeAttributes[i];
+				}
+			}
+		}
+
+		uint32_t childAttributeCount = state.AttributeCount + static_cast<uint32_t>(edgeAttributeSources.size());
+		child.AttributeToPosition.resize(childAttributeCount);
+		for (uint32_t i = 0; i < state.AttributeCount; i++)
+		{
+			child.AttributeToPosition[i] = parent.AttributeToPosition[i];
+		}
+		for (size_t i = 0; i < edgeAttributeSources.size(); i++)
+		{
+			child.AttributeToPosition[state.AttributeCount + i] = parent.PositionCount + adjacency.FaceEdges[edgeAttributeSources[i]];
+		}
+
+		// 1三角形を4つに分割する。元の向きを保つ
+		child.Indices.resize(triangleCount * 12);
+		for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			const uint32_t* a = &parent.Indices[triangle * 3];
+			const uint32_t* e = &cornerEdgeAttributes[triangle * 3];
+			uint32_t* pDst = &child.Indices[triangle * 12];
+
+			pDst[0] = a[0]; pDst[1] = e[0]; pDst[2] = e[2];
+			pDst[3] = a[1]; pDst[4] = e[1]; pDst[5] = e[0];
+			pDst[6] = a[2]; pDst[7] = e[2]; pDst[8] = e[1];
+			pDst[9] = e[0]; pDst[10] = e[1]; pDst[11] = e[2];
+		}
+
+		BuildStencilTable(child.PositionCount, [&](uint32_t row, std::vector<uint32_t>& work, LocalStencil& stencil)
+		{
+			if (row < parent.PositionCount)
+			{
+				ComputeVertexPointStencil(state, row, stencil);
+			}
+			else
+			{
+				ComputeEdgePointStencil(state, row - parent.PositionCount, stencil);
+			}
+		}, child.PositionStencils);
+
+		BuildStencilTable(childAttributeCount, [&](uint32_t row, std::vector<uint32_t>& work, LocalStencil& stencil)
+		{
+			if (row < state.AttributeCount)
+			{
+				ComputeVertexAttributeStencil(state, row, parent.AttributeToPosition[row], work, stencil);
+			}
+			else
+			{
+				uint32_t corner = edgeAttributeSources[row - state.AttributeCount];
+				ComputeEdgeAttributeStencil(state, corner / 3, corner % 3, work, stencil);
+			}
+		}, child.AttributeStencils);
+
+		// 子のクリース。無限でなければシャープネスを1減らす
+		std::vector<SubdCrease> childCreases;
+		for (uint32_t edge = 0; edge < edgeCount; edge++)
+		{
+			float sharpness = adjacency.EdgeSharpness[edge];
+			if (adjacency.IsBoundaryEdge(edge) || sharpness <= 0.0f)
+			{
+				continue;
+			}
+
+			float childSharpness = (sharpness >= SUBD_INFINITE_SHARPNESS) ? SUBD_INFINITE_SHARPNESS : (sharpness - 1.0f);
+			if (childSharpness <= 0.0f)
+			{
+				continue;
+			}
+
+			uint32_t edgePoint = parent.PositionCount + edge;
+			childCreases.push_back({adjacency.EdgeVertices[edge * 2 + 0], edgePoint, childSharpness});
+			childCreases.push_back({edgePoint, adjacency.EdgeVertices[edge * 2 + 1], childSharpness});
+		}
+		state.Topology.Creases.swap(childCreases);
+
+		child.Info.BuildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - levelStart).count();
+	}
+
+	for (Level& level : m_Levels)
+	{
+		level.Info.VertexCount = level.PositionCount;
+		level.Info.AttributeCount = static_cast<uint32_t>(level.AttributeToPosition.size());
+		level.Info.TriangleCount = static_cast<uint32_t>(level.Indices.size() / 3);
+		level.Info.MemorySize = level.PositionStencils.GetMemorySize()
+			+ level.AttributeStencils.GetMemorySize()
+			+ level.Indices.size() * sizeof(uint32_t)
+			+ level.AttributeToPosition.size() * sizeof(uint32_t);
+	}
+	base.Info.BuildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	return true;
+}
+
+void LoopSubdivision::Term()
+{
+	m_Levels.clear();
+}
+
+uint32_t LoopSubdivision::GetMaxLevel() const
+{
+	return m_Levels.empty() ? 0 : static_cast<uint32_t>(m_Levels.size()) - 1;
+}
+
+const LoopSubdivision::LevelInfo& LoopSubdivision::GetLevelInfo(uint32_t level) const
+{
+	assert(level < m_Levels.size());
+	return m_Levels[level].Info;
+}
+
+bool LoopSubdivision::Evaluate(const ResMesh& mesh, uint32_t level, ResMesh& result, std::vector<double>* pLevelMilliseconds) const
+{
+	if (level >= m_Levels.size())
+	{
+		ELOG("Error : Invalid level. level = %u", level);
+		return false;
+	}
+
+	const Level& base = m_Levels[0];
+	if (mesh.Vertices.size() != base.AttributeToPosition.size())
+	{
+		ELOG("Error : Vertex count mismatch.");
+		return false;
+	}
+
+	std::vector<Vector3> positions(base.PositionCount);
+	std::vector<Vector3> normals(mesh.Vertices.size());
+	std::vector<Vector2> texCoords(mesh.Vertices.size());
+	std::vector<Vector3> tangents(mesh.Vertices.size());
+	for (size_t i = 0; i < mesh.Vertices.size(); i++)
+	{
+		const MeshVertex& vertex = mesh.Vertices[i];
+		positions[base.AttributeToPosition[i]] = vertex.Position;
+		normals[i] = vertex.Normal;
+		texCoords[i] = vertex.TexCoord;
+		tangents[i] = vertex.Tangent;
+	}
+
+	if (pLevelMilliseconds != nullptr)
+	{
+		pLevelMilliseconds->assign(level + 1, 0.0);
+	}
+
+	std::vector<Vector3> work3;
+	std::vector<Vector2> work2;
+	for (uint32_t i = 1; i <= level; i++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		const Level& current = m_Levels[i];
+		ApplyLevel(current.PositionStencils, positions, work3);
+		ApplyLevel(current.AttributeStencils, normals, work3);
+		ApplyLevel(current.AttributeStencils, texCoords, work2);
+		ApplyLevel(current.AttributeStencils, tangents, work3);
+
+		if (pLevelMilliseconds != nullptr)
+		{
+			(*pLevelMilliseconds)[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+
+	const Level& target = m_Levels[level];
+	uint32_t attributeCount = static_cast<uint32_t>(target.AttributeToPosition.size());
+
+	result.Vertices.resize(attributeCount);
+	ParallelFor(attributeCount, 4096, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			MeshVertex& vertex = result.Vertices[i];
+			vertex.Position = positions[target.AttributeToPosition[i]];
+			vertex.Normal = normals[i];
+			vertex.Normal.Normalize();
+			vertex.TexCoord = texCoords[i];
+			vertex.Tangent = tangents[i];
+			vertex.Tangent.Normalize();
+		}
+	});
+
+	result.Indices = target.Indices;
+	result.Meshlets.clear();
+	result.MeshletsVertices.clear();
+	result.MeshletsTriangles.clear();
+	result.Bounds.clear();
+	result.AABBs.clear();
+	result.MaterialIdx = mesh.MaterialIdx;
+
+	return true;
+}
@@ -3,6 +3,7 @@
 #include "Logger.h"
 #include "App.h"
 #include "FileUtil.h"
+#include "ResourceStateTracker.h"
 
 #include <DirectXHelpers.h>
 
@@ -13,6 +14,9 @@ namespace
 	// SponzâƂɉԕrߑłœ߂̃CfbNX
 	static constexpr uint32_t MOVABLE_MESH_INDEX = 2;
 
+	// bVƂ̒_AMeshletACfbNX̃obt@؂oy[W̑傫B傫obt@͐p̃y[WɂȂ
+	static constexpr uint64_t MESH_BUFFER_PAGE_SIZE = 16 * 1024 * 1024;
+
 	struct alignas(256) CbMesh
 	{
 		Matrix World;
@@ -154,6 +158,7 @@ void MeshManager::Term()
 	m_resMeshes.clear();
 	m_resMaterials.clear();
 	m_resMaterialIdxTbl.clear();
+	m_SceneBvh.Term();
 
 	if (m_pPoolGpuVisible != nullptr)
 	{
@@ -266,6 +271,9 @@ void MeshManager::Term()
 	}
 	m_IBs.clear();
 
+	// ؂o͈͂͏Term()ŕԋpĂ
+	m_MeshBufferAllocator.Term();
+
 	m_BlasScratchBB.Term();
 	m_BlasResultBB.Term();
 	m_TlasScratchBB.Term();
@@ -330,6 +338,13 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 	assert(pPoolGpuVisible != nullptr);
 	assert(pPoolCpuVisible != nullptr);
 
+	// bVƂ̃obt@͏̂AꂼR~bg64KBPʂɐ؂グ̂ŁA傫ȃy[W؂o
+	if (!m_MeshBufferAllocator.Init(pDevice, MESH_BUFFER_PAGE_SIZE, D3D12_RESOURCE_FLAG_NONE, L"MeshBufferPage"))
+	{
+		ELOG("Error : BufferSuballocator::Init() Failed.");
+		return false;
+	}
+
 	size_t meshCount = m_resMeshes.size();
 	m_MeshCBs.resize(meshCount);
 	m_VBs.resize(meshCount);
@@ -403,16 +418,14 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 
 		meshesDescHeapIndices.CbMesh[validMeshIdx] = m_MeshCBs[validMeshIdx].GetHandleCBV()->GetDescriptorIndex();
 
-		if (!m_VBs[validMeshIdx].InitAsStructuredBuffer<MeshVertex>(
+		if (!m_VBs[validMeshIdx].InitAsSubAllocatedStructuredBuffer<MeshVertex>(
 			pDevice,
+			&m_MeshBufferAllocator,
 			resMesh.Vertices.size(),
-			D3D12_RESOURCE_FLAG_NONE,
-			pPoolGpuVisible,
-			nullptr,
-			L"SbVertexBuffer"
+			pPoolGpuVisible
 		))
 		{
-			ELOG("Error : Resource::InitAsStructuredBuffer() Failed.");
+			ELOG("Error : Resource::InitAsSubAllocatedStructuredBuffer() Failed.");
 			return false;
 		}
 
@@ -429,16 +442,14 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 
 		meshesDescHeapIndices.SbVertexBuffer[validMeshIdx] = m_VBs[validMeshIdx].GetHandleSRV()->GetDescriptorIndex();
 
-		if (!m_MeshletsSBs[validMeshIdx].InitAsStructuredBuffer<meshopt_Meshlet>(
+		if (!m_MeshletsSBs[validMeshIdx].InitAsSubAllocatedStructuredBuffer<meshopt_Meshlet>(
 			pDevice,
+			&m_MeshBufferAllocator,
 			localMeshletCount,
-			D3D12_RESOURCE_FLAG_NONE,
-			pPoolGpuVisible,
-			nullptr,
-			L"MeshletsSB"
+			pPoolGpuVisible
 		))
 		{
-			ELOG("Error : Resource::InitAsStructuredBuffer() Failed.");
+			ELOG("Error : Resource::InitAsSubAllocatedStructuredBuffer() Failed.");
 			return false;
 		}
 
@@ -455,16 +466,14 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 
 		meshesDescHeapIndices.SbMeshletBuffer[validMeshIdx] = m_MeshletsSBs[validMeshIdx].GetHandleSRV()->GetDescriptorIndex();
 
-		if (!m_MeshletsVerticesSBs[validMeshIdx].InitAsStructuredBuffer<uint32_t>(
+		if (!m_MeshletsVerticesSBs[validMeshIdx].InitAsSubAllocatedStructuredBuffer<uint32_t>(
 			pDevice,
+			&m_MeshBufferAllocator,
 			resMesh.MeshletsVertices.size(),
-			D3D12_RESOURCE_FLAG_NONE,
-			pPoolGpuVisible,
-			nullptr,
-			L"MeshletsVerticesSB"
+			pPoolGpuVisible
 		))
 		{
-			ELOG("Error : Resource::InitAsStructuredBuffer() Failed.");
+			ELOG("Error : Resource::InitAsSubAllocatedStructuredBuffer() Failed.");
 			return false;
 		}
 
@@ -489,16 +498,14 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 			meshletsTriangles.push_back(static_cast<uint32_t>(index));
 		}
 
-		if (!m_MeshletsTrianglesSBs[validMeshIdx].InitAsStructuredBuffer<uint32_t>(
+		if (!m_MeshletsTrianglesSBs[validMeshIdx].InitAsSubAllocatedStructuredBuffer<uint32_t>(
 			pDevice,
+			&m_MeshBufferAllocator,
 			meshletsTriangles.size(),
-			D3D12_RESOURCE_FLAG_NONE,
-			pPoolGpuVisible,
-			nullptr,
-			L"MeshletsTrianglesBB"
+			pPoolGpuVisible
 		))
 		{
-			ELOG("Error : Resource::InitAsStructuredBuffer() Failed.");
+			ELOG("Error : Resource::InitAsSubAllocatedStructuredBuffer() Failed.");
 			return false;
 		}
 
@@ -517,16 +524,14 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 
 		assert(resMesh.AABBs.size() == localMeshletCount);
 
-		if (!m_MeshletsAABBInfosSBs[validMeshIdx].InitAsStructuredBuffer<AABB>(
+		if (!m_MeshletsAABBInfosSBs[validMeshIdx].InitAsSubAllocatedStructuredBuffer<AABB>(
 			pDevice,
+			&m_MeshBufferAllocator,
 			localMeshletCount,
-			D3D12_RESOURCE_FLAG_NONE,
-			pPoolGpuVisible,
-			nullptr,
-			L"AABBInfosSB"
+			pPoolGpuVisible
 		))
 		{
-			ELOG("Error : Resource::InitAsStructuredBuffer() Failed.");
+			ELOG("Error : Resource::InitAsSubAllocatedStructuredBuffer() Failed.");
 			return false;
 		}
 
@@ -560,16 +565,14 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 				positions[i] = resMesh.Vertices[i].Position;
 			}
 				
-			if (!m_PositionVBs[validMeshIdx].InitAsVertexBuffer<Vector3>(
+			if (!m_PositionVBs[validMeshIdx].InitAsSubAllocatedStructuredBuffer<Vector3>(
 				pDevice,
+				&m_MeshBufferAllocator,
 				positions.size(),
-				D3D12_RESOURCE_FLAG_NONE,
-				D3D12_RESOURCE_STATE_COMMON,
-				nullptr,
-				L"PositionVB"
+				nullptr
 			))
 			{
-				ELOG("Error : Resource::InitAsVertexBuffer() Failed.");
+				ELOG("Error : Resource::InitAsSubAllocatedStructuredBuffer() Failed.");
 				return false;
 			}
 
@@ -584,16 +587,14 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 				return false;
 			}
 
-			if (!m_IBs[validMeshIdx].InitAsStructuredBuffer<uint32_t>(
+			if (!m_IBs[validMeshIdx].InitAsSubAllocatedStructuredBuffer<uint32_t>(
 				pDevice,
+				&m_MeshBufferAllocator,
 				resMesh.Indices.size(),
-				D3D12_RESOURCE_FLAG_NONE,
-				pPoolGpuVisible,
-				nullptr,
-				L"MeshIB"
+				pPoolGpuVisible
 			))
 			{
-				ELOG("Error : Resource::InitAsIndexBuffer() Failed.");
+				ELOG("Error : Resource::InitAsSubAllocatedStructuredBuffer() Failed.");
 				return false;
 			}
 
@@ -609,13 +610,13 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 			}
 
 			D3D12_RAYTRACING_GEOMETRY_DESC geomDesc = {};
-			geomDesc.Triangles.VertexBuffer.StartAddress = m_PositionVBs[validMeshIdx].GetResource()->GetGPUVirtualAddress();
+			geomDesc.Triangles.VertexBuffer.StartAddress = m_PositionVBs[validMeshIdx].GetGPUVirtualAddress();
 			geomDesc.Triangles.VertexBuffer.StrideInBytes = sizeof(Vector3);
 			geomDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
 			geomDesc.Triangles.VertexCount = static_cast<UINT>(positions.size());
 			// Transform3x4AIB̎w̓IvV
 			geomDesc.Triangles.Transform3x4 = 0;
-			geomDesc.Triangles.IndexBuffer = m_IBs[validMeshIdx].GetResource()->GetGPUVirtualAddress();;
+			geomDesc.Triangles.IndexBuffer = m_IBs[validMeshIdx].GetGPUVirtualAddress();
 			geomDesc.Triangles.IndexCount = static_cast<UINT>(resMesh.Indices.size());
 			geomDesc.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
 			// TODO: łׂOpaqueƂĂ
@@ -629,6 +630,19 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 
 	m_MeshCount = validMeshIdx;
 
+	{
+		const BufferSuballocatorStats& stats = m_MeshBufferAllocator.GetStats();
+		ELOG("MeshManager : %u mesh buffers in %u pages. used %.2f MB, pages %.2f MB (committed per buffer %.2f MB), free blocks %u, fragmentation %.3f",
+			stats.AllocationCount,
+			stats.PageCount,
+			stats.UsedSize / (1024.0 * 1024.0),
+			stats.PageSize / (1024.0 * 1024.0),
+			stats.CommittedEquivalentSize / (1024.0 * 1024.0),
+			stats.FreeBlockCount,
+			stats.Fragmentation
+		);
+	}
+
 	// MeshletMeshMaterial̑Ήe[u̐
 	if (!m_MeshletMeshMaterialTableSB.InitAsStructuredBuffer<MeshletMeshMaterial>
 	(
@@ -744,6 +758,9 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 		}
 	}
 
+	// JOʂ̃obt@UAVւ̑Jڂ́A6ƂĂ1ResourceBarrier()Ŕs
+	ResourceStateTracker stateTracker;
+
 	// OpaqueMeshlet`pMeshletJE^[DispatchIndirectArg̐
 	if (!m_DrawOpaqueMeshletIndirectArgBB.InitAsByteAddressBuffer
 	(
@@ -760,7 +777,7 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 		return false;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_DrawOpaqueMeshletIndirectArgBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	stateTracker.Transition(m_DrawOpaqueMeshletIndirectArgBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
 	// OpaqueMeshlet`p̃JOςMeshletIdxXg̐
 	if (!m_DrawOpaqueMeshletIndicesBB.InitAsByteAddressBuffer
@@ -778,7 +795,7 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 		return false;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_DrawOpaqueMeshletIndicesBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	stateTracker.Transition(m_DrawOpaqueMeshletIndicesBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
 	// MaskedMeshlet`pMeshletJE^[DispatchIndirectArg̐
 	if (!m_DrawMaskedMeshletIndirectArgBB.InitAsByteAddressBuffer
@@ -796,7 +813,7 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 		return false;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_DrawMaskedMeshletIndirectArgBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	stateTracker.Transition(m_DrawMaskedMeshletIndirectArgBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
 	// MaskedMeshlet`p̃JOςMeshletIdxXg̐
 	if (!m_DrawMaskedMeshletIndicesBB.InitAsByteAddressBuffer
@@ -814,7 +831,7 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 		return false;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_DrawMaskedMeshletIndicesBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	stateTracker.Transition(m_DrawMaskedMeshletIndicesBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
 	// MovableMeshlet`pMeshletJE^[DispatchIndirectArg̐
 	if (!m_DrawMovableMeshletIndirectArgBB.InitAsByteAddressBuffer
@@ -832,7 +849,7 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 		return false;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_DrawMovableMeshletIndirectArgBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	stateTracker.Transition(m_DrawMovableMeshletIndirectArgBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
 	// MovableMeshlet`p̃JOςMeshletIdxXg̐
 	if (!m_DrawMovableMeshletIndicesBB.InitAsByteAddressBuffer
@@ -850,7 +867,8 @@ bool MeshManager::Update(ID3D12Device5* pDevice, ID3D12CommandQueue* pQueue, ID3
 		return false;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_DrawMovableMeshletIndicesBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	stateTracker.Transition(m_DrawMovableMeshletIndicesBB.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	stateTracker.Finish(pCmdList);
 
 	if (!m_MeshesDescHeapIndicesCB.InitAsConstantBuffer<CbMeshesDescHeapIndices>(
 		pDevice,
@@ -1182,6 +1200,17 @@ bool MeshManager::SetMovableWorldMatrix(ID3D12Device* pDevice, ID3D12GraphicsCom
 		return false;
 	}
 
+	// CPUBVH͓CX^X̕TLASXV
+	if (m_SceneBvh.GetInstanceCount() > MOVABLE_MESH_INDEX)
+	{
+		m_SceneBvh.SetWorldMatrix(MOVABLE_MESH_INDEX, worldMat);
+		if (!m_SceneBvh.Refit())
+		{
+			ELOG("Error : SceneBvh::Refit() Failed.");
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -1272,6 +1301,135 @@ uint32_t MeshManager::GetMaterialIdx(uint32_t meshIdx) const
 	return m_resMaterialIdxTbl[meshIdx];
 }
 
+const ResMaterial& MeshManager::GetResMaterial(uint32_t materialIdx) const
+{
+	assert(materialIdx < m_resMaterials.size());
+	return m_resMaterials[materialIdx];
+}
+
+void MeshManager::GetMeshletWorldAABBs(std::vector<AABB>& aabbs) const
+{
+	aabbs.clear();
+
+	for (size_t meshIdx = 0; meshIdx < m_resMeshes.size(); meshIdx++)
+	{
+		const ResMesh& resMesh = m_resMeshes[meshIdx];
+		if (!IsMaterialValid(m_resMaterials[resMesh.MaterialIdx]))
+		{
+			continue;
+		}
+
+		// S͍sŕϊAa͍s̊e̐Βlŕϊ
+		const Matrix& world = m_worldMatrices[meshIdx];
+		Matrix absWorld = world;
+		for (uint32_t row = 0; row < 3; row++)
+		{
+			for (uint32_t column = 0; column < 3; column++)
+			{
+				absWorld.m[row][column] = fabsf(world.m[row][column]);
+			}
+		}
+
+		for (const AABB& aabb : resMesh.AABBs)
+		{
+			AABB worldAABB;
+			worldAABB.Center = Vector3::Transform(aabb.Center, world);
+			worldAABB.HalfExtent = Vector3::TransformNormal(aabb.HalfExtent, absWorld);
+			aabbs.push_back(worldAABB);
+		}
+	}
+}
+
+void MeshManager::GetWorldTriangles(std::vector<Vector3>& positions, std::vector<uint32_t>& meshIndices) const
+{
+	positions.clear();
+	meshIndices.clear();
+
+	uint32_t validMeshIdx = 0;
+	for (size_t meshIdx = 0; meshIdx < m_resMeshes.size(); meshIdx++)
+	{
+		const ResMesh& resMesh = m_resMeshes[meshIdx];
+		if (!IsMaterialValid(m_resMaterials[resMesh.MaterialIdx]))
+		{
+			continue;
+		}
+
+		const Matrix& world = m_worldMatrices[meshIdx];
+		for (uint32_t index : resMesh.Indices)
+		{
+			positions.push_back(Vector3::Transform(resMesh.Vertices[index].Position, world));
+		}
+		meshIndices.insert(meshIndices.end(), resMesh.Indices.size() / 3, validMeshIdx);
+		validMeshIdx++;
+	}
+}
+
+void MeshManager::GetWorldTriangleNormals(std::vector<Vector3>& normals) const
+{
+	normals.clear();
+
+	for (size_t meshIdx = 0; meshIdx < m_resMeshes.size(); meshIdx++)
+	{
+		const ResMesh& resMesh = m_resMeshes[meshIdx];
+		if (!IsMaterialValid(m_resMaterials[resMesh.MaterialIdx]))
+		{
+			continue;
+		}
+
+		// @͋t]usŕϊ
+		const Matrix& normalMatrix = m_worldMatrices[meshIdx].Invert().Transpose();
+		for (uint32_t index : resMesh.Indices)
+		{
+			Vector3 normal = Vector3::TransformNormal(resMesh.Vertices[index].Normal, normalMatrix);
+			normal.Normalize();
+			normals.push_back(normal);
+		}
+	}
+}
+
+void MeshManager::GetLocalTriangles(std::vector<std::vector<Vector3>>& meshPositions, std::vector<Matrix>& worldMatrices) const
+{
+	meshPositions.clear();
+	worldMatrices.clear();
+
+	for (size_t meshIdx = 0; meshIdx < m_resMeshes.size(); meshIdx++)
+	{
+		const ResMesh& resMesh = m_resMeshes[meshIdx];
+		if (!IsMaterialValid(m_resMaterials[resMesh.MaterialIdx]))
+		{
+			continue;
+		}
+
+		std::vector<Vector3>& positions = meshPositions.emplace_back();
+		positions.reserve(resMesh.Indices.size());
+		for (uint32_t index : resMesh.Indices)
+		{
+			positions.push_back(resMesh.Vertices[index].Position);
+		}
+		worldMatrices.push_back(m_worldMatrices[meshIdx]);
+	}
+}
+
+bool MeshManager::BuildSceneBvh(const BvhBuildSettings& settings)
+{
+	std::vector<std::vector<Vector3>> meshPositions;
+	std::vector<Matrix> worldMatrices;
+	GetLocalTriangles(meshPositions, worldMatrices);
+
+	if (!m_SceneBvh.Build(meshPositions, worldMatrices, settings))
+	{
+		ELOG("Error : SceneBvh::Build() Failed.");
+		return false;
+	}
+
+	return true;
+}
+
+const SceneBvh& MeshManager::GetSceneBvh() const
+{
+	return m_SceneBvh;
+}
+
 const Resource& MeshManager::GetVB(uint32_t meshIdx) const
 {
 	return m_VBs[meshIdx];
@@ -0,0 +1,174 @@
+﻿#include "ParallelFor.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// ParallelForのチャンク処理中のスレッドか。入れ子の呼び出しの検出に使う
+	thread_local bool t_IsInsideParallelFor = false;
+
+	class WorkerPool
+	{
+	public:
+		WorkerPool()
+		{
+			uint32_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+			m_Threads.reserve(numThreads - 1);
+			for (uint32_t i = 0; i < numThreads - 1; i++)
+			{
+				m_Threads.emplace_back([this]() { WorkerMain(); });
+			}
+		}
+
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> guard(m_Mutex);
+				m_Exit = true;
+			}
+			m_WakeCV.notify_all();
+
+			for (std::thread& thread : m_Threads)
+			{
+				thread.join();
+			}
+		}
+
+		uint32_t GetThreadCount() const
+		{
+			return static_cast<uint32_t>(m_Threads.size()) + 1;
+		}
+
+		void Run(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& func)
+		{
+			// 同時に実行するジョブは1つだけ
+			std::lock_guard<std::mutex> runGuard(m_RunMutex);
+
+			{
+				std::lock_guard<std::mutex> guard(m_Mutex);
+				m_pFunc = &func;
+				m_Count = count;
+				m_GrainSize = grainSize;
+				m_NumChunks = (count + grainSize - 1) / grainSize;
+				m_NextChunk = 0;
+				m_NumFinishedChunks = 0;
+				m_JobID++;
+			}
+			m_WakeCV.notify_all();
+
+			t_IsInsideParallelFor = true;
+			ProcessChunks();
+			t_IsInsideParallelFor = false;
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_DoneCV.wait(lock, [this]() { return (m_NumFinishedChunks == m_NumChunks) && (m_NumActiveWorkers == 0); });
+			// ここでクリアしておけば、遅れて起きたワーカーが終了済みのジョブを参照することはない
+			m_pFunc = nullptr;
+		}
+
+	private:
+		std::vector<std::thread> m_Threads;
+
+		std::mutex m_RunMutex;
+		std::mutex m_Mutex;
+		std::condition_variable m_WakeCV;
+		std::condition_variable m_DoneCV;
+		bool m_Exit = false;
+		uint64_t m_JobID = 0;
+		uint32_t m_NumActiveWorkers = 0;
+
+		const std::function<void(uint32_t, uint32_t)>* m_pFunc = nullptr;
+		uint32_t m_Count = 0;
+		uint32_t m_GrainSize = 1;
+		uint32_t m_NumChunks = 0;
+		std::atomic<uint32_t> m_NextChunk = 0;
+		std::atomic<uint32_t> m_NumFinishedChunks = 0;
+
+		void ProcessChunks()
+		{
+			while (true)
+			{
+				uint32_t chunk = m_NextChunk.fetch_add(1);
+				if (chunk >= m_NumChunks)
+				{
+					break;
+				}
+
+				uint32_t begin = chunk * m_GrainSize;
+				uint32_t end = std::min(begin + m_GrainSize, m_Count);
+				(*m_pFunc)(begin, end);
+
+				m_NumFinishedChunks.fetch_add(1);
+			}
+		}
+
+		void WorkerMain()
+		{
+			t_IsInsideParallelFor = true;
+			uint64_t lastJobID = 0;
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			while (true)
+			{
+				m_WakeCV.wait(lock, [&]() { return m_Exit || ((m_pFunc != nullptr) && (m_JobID != lastJobID)); });
+				if (m_Exit)
+				{
+					return;
+				}
+
+				lastJobID = m_JobID;
+				m_NumActiveWorkers++;
+				lock.unlock();
+
+				ProcessChunks();
+
+				lock.lock();
+				m_NumActiveWorkers--;
+				if (m_NumActiveWorkers == 0)
+				{
+					m_DoneCV.notify_all();
+				}
+			}
+		}
+
+		WorkerPool(const WorkerPool&) = delete;
+		void operator=(const WorkerPool&) = delete;
+	};
+
+	WorkerPool& GetWorkerPool()
+	{
+		static WorkerPool pool;
+		return pool;
+	}
+}
+
+void ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)>& func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	grainSize = std::max(grainSize, 1u);
+
+	if (t_IsInsideParallelFor || count <= grainSize || GetWorkerPool().GetThreadCount() == 1)
+	{
+		for (uint32_t begin = 0; begin < count; begin += grainSize)
+		{
+			func(begin, std::min(begin + grainSize, count));
+		}
+		return;
+	}
+
+	GetWorkerPool().Run(count, grainSize, func);
+}
+
+uint32_t GetParallelForThreadCount()
+{
+	return GetWorkerPool().GetThreadCount();
+}
@@ -0,0 +1,153 @@
+﻿#include "ParticleReplay.h"
+#include "Logger.h"
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	static constexpr uint32_t REPLAY_MAGIC = 0x4c505250;
+	static constexpr uint32_t REPLAY_VERSION = 1;
+
+	// ファイルの先頭に置く。後ろに初期状態のスナップショット、ステップごとのParticleUpdateDescが続く
+	struct ReplayHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t MaxParticles;
+		uint32_t StepCount;
+		uint64_t InitialSnapshotSize;
+		uint32_t HasExpectedHash;
+		uint32_t StepSize;
+		uint64_t ExpectedHash;
+	};
+
+	// ステップはそのままの並びで書き込むので、パディングがないこと
+	static_assert(sizeof(ParticleUpdateDesc) == sizeof(uint32_t) * 6);
+}
+
+void ParticleReplay::BeginRecording(uint32_t maxParticles)
+{
+	m_MaxParticles = maxParticles;
+	m_InitialSnapshot.clear();
+	m_Steps.clear();
+	m_ExpectedHash = 0;
+	m_HasExpectedHash = false;
+}
+
+void ParticleReplay::BeginRecording(const ParticleSimulator& simulator)
+{
+	BeginRecording(simulator.GetMaxParticles());
+	simulator.SaveSnapshot(m_InitialSnapshot);
+}
+
+void ParticleReplay::RecordStep(const ParticleUpdateDesc& desc)
+{
+	m_Steps.push_back(desc);
+}
+
+bool ParticleReplay::Save(const wchar_t* path) const
+{
+	std::ofstream stream(std::filesystem::path(path), std::ios::binary);
+	if (!stream)
+	{
+		ELOG("Error : Failed to open particle replay. path = %ls", path);
+		return false;
+	}
+
+	ReplayHeader header;
+	header.Magic = REPLAY_MAGIC;
+	header.Version = REPLAY_VERSION;
+	header.MaxParticles = m_MaxParticles;
+	header.StepCount = GetStepCount();
+	header.InitialSnapshotSize = m_InitialSnapshot.size();
+	header.HasExpectedHash = m_HasExpectedHash ? 1 : 0;
+	header.StepSize = sizeof(ParticleUpdateDesc);
+	header.ExpectedHash = m_ExpectedHash;
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	stream.write(reinterpret_cast<const char*>(m_InitialSnapshot.data()), m_InitialSnapshot.size());
+	stream.write(reinterpret_cast<const char*>(m_Steps.data()), sizeof(ParticleUpdateDesc) * m_Steps.size());
+	if (!stream)
+	{
+		ELOG("Error : Failed to write particle replay. path = %ls", path);
+		return false;
+	}
+
+	return true;
+}
+
+bool ParticleReplay::Load(const wchar_t* path)
+{
+	std::ifstream stream(std::filesystem::path(path), std::ios::binary);
+	if (!stream)
+	{
+		ELOG("Error : Failed to open particle replay. path = %ls", path);
+		return false;
+	}
+
+	ReplayHeader header;
+	if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+	{
+		ELOG("Error : Failed to read particle replay. path = %ls", path);
+		return false;
+	}
+
+	if (header.Magic != REPLAY_MAGIC || header.Version != REPLAY_VERSION || header.StepSize != sizeof(ParticleUpdateDesc))
+	{
+		ELOG("Error : Invalid particle replay. path = %ls, magic = 0x%08x, version = %u", path, header.Magic, header.Version);
+		return false;
+	}
+
+	std::vector<uint8_t> initialSnapshot(header.InitialSnapshotSize);
+	std::vector<ParticleUpdateDesc> steps(header.StepCount);
+	stream.read(reinterpret_cast<char*>(initialSnapshot.data()), initialSnapshot.size());
+	stream.read(reinterpret_cast<char*>(steps.data()), sizeof(ParticleUpdateDesc) * steps.size());
+	if (!stream)
+	{
+		ELOG("Error : Particle replay is truncated. path = %ls", path);
+		return false;
+	}
+
+	m_MaxParticles = header.MaxParticles;
+	m_InitialSnapshot = std::move(initialSnapshot);
+	m_Steps = std::move(steps);
+	m_ExpectedHash = header.ExpectedHash;
+	m_HasExpectedHash = (header.HasExpectedHash != 0);
+	return true;
+}
+
+bool ParticleReplay::Restart(ParticleSimulator& simulator) const
+{
+	if (simulator.GetMaxParticles() != m_MaxParticles)
+	{
+		// Init()し直すとSIMDのモードが既定に戻るので、初期化済みだったなら設定し直す
+		bool isInitialized = (simulator.GetMaxParticles() > 0);
+		PARTICLE_SIMD_MODE mode = simulator.GetSIMDMode();
+		if (!simulator.Init(m_MaxParticles))
+		{
+			ELOG("Error : ParticleSimulator::Init() Failed.");
+			return false;
+		}
+
+		if (isInitialized)
+		{
+			simulator.SetSIMDMode(mode);
+		}
+	}
+
+	if (m_InitialSnapshot.empty())
+	{
+		simulator.Clear();
+		return true;
+	}
+
+	return simulator.LoadSnapshot(m_InitialSnapshot.data(), m_InitialSnapshot.size());
+}
+
+void ParticleReplay::Play(ParticleSimulator& simulator, uint32_t beginStep, uint32_t endStep) const
+{
+	for (uint32_t step = beginStep; step < endStep; step++)
+	{
+		simulator.Update(m_Steps[step]);
+	}
+}
@@ -0,0 +1,592 @@
+﻿#include "ParticleSimulator.h"
+#include "CounterBasedRandom.h"
+#include "CpuFeatures.h"
+#include "ParallelFor.h"
+#include "RadixSort.h"
+#include "SpatialHashGrid.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define PARTICLE_TARGET_AVX2
+#else
+#define PARTICLE_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+
+namespace
+{
+	// UpdateParticlesCS.hlslと合わせている
+	static constexpr float GRAVITY = 9.8f;
+	static constexpr float PI = 3.14159265358979323f;
+	static constexpr uint32_t RANDOM_STREAM_SPAWN = 0;
+
+	// スナップショットの先頭に置く
+	static constexpr uint32_t SNAPSHOT_MAGIC = 0x50534e50;
+	static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+	struct SnapshotHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t NumParticles;
+		uint32_t NumSurvivors;
+		float LastDeltaTime;
+	};
+
+	// 64ビットのFNV-1a
+	static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+	static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	uint64_t HashBytes(uint64_t hash, const void* pData, size_t size)
+	{
+		const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ pBytes[i]) * FNV_PRIME;
+		}
+		return hash;
+	}
+
+	// 1チャンクのパーティクル数。AVX2の8レーンの倍数
+	static constexpr uint32_t CHUNK_SIZE = 16384;
+	static_assert(CHUNK_SIZE % 8 == 0);
+
+	// SoAの配列の先頭をまとめたもの
+	struct StreamPointers
+	{
+		float* PositionX;
+		float* PositionY;
+		float* PositionZ;
+		float* VelocityX;
+		float* VelocityY;
+		float* VelocityZ;
+		uint32_t* Life;
+	};
+
+	uint32_t CountSurvivorsScalar(const uint32_t* pLife, uint32_t begin, uint32_t end)
+	{
+		uint32_t count = 0;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			// uintの減算なのでLife == 0は死なない（シェーダと同じ）
+			count += (pLife[i] - 1 != 0) ? 1 : 0;
+		}
+		return count;
+	}
+
+	// [begin, end)の生存したパーティクルを更新してdstのdstOffsetから詰めて書き込む
+	void UpdateSurvivorsScalar(const StreamPointers& src, const StreamPointers& dst, uint32_t begin, uint32_t end, uint32_t dstOffset, float deltaTime)
+	{
+		float gravityDelta = -GRAVITY * deltaTime;
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t life = src.Life[i] - 1;
+			if (life == 0)
+			{
+				// death
+				continue;
+			}
+
+			// integrate
+			float velocityX = src.VelocityX[i];
+			float velocityY = src.VelocityY[i] + gravityDelta;
+			float velocityZ = src.VelocityZ[i];
+
+			dst.PositionX[dstOffset] = src.PositionX[i] + velocityX * deltaTime;
+			dst.PositionY[dstOffset] = src.PositionY[i] + velocityY * deltaTime;
+			dst.PositionZ[dstOffset] = src.PositionZ[i] + velocityZ * deltaTime;
+			dst.VelocityX[dstOffset] = velocityX;
+			dst.VelocityY[dstOffset] = velocityY;
+			dst.VelocityZ[dstOffset] = velocityZ;
+			dst.Life[dstOffset] = life;
+			dstOffset++;
+		}
+	}
+
+	// 8ビットの生存マスクから、生存したレーンを前に詰めるpermutevar8x32のインデックス
+	struct CompactionTable
+	{
+		alignas(32) uint32_t Permutations[256][8];
+
+		CompactionTable()
+		{
+			for (uint32_t mask = 0; mask < 256; mask++)
+			{
+				uint32_t count = 0;
+				for (uint32_t lane = 0; lane < 8; lane++)
+				{
+					if (mask & (1 << lane))
+					{
+						Permutations[mask][count++] = lane;
+					}
+				}
+
+				for (; count < 8; count++)
+				{
+					Permutations[mask][count] = 0;
+				}
+			}
+		}
+	};
+
+	const CompactionTable COMPACTION_TABLE;
+
+	// &STORE_MASKS[8 - count]から8要素読むと先頭count要素だけ書き込むマスクになる
+	alignas(32) static const int32_t STORE_MASKS[16] = {-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+
+	PARTICLE_TARGET_AVX2 uint32_t CountSurvivorsAVX2(const uint32_t* pLife, uint32_t begin, uint32_t end)
+	{
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256i zero = _mm256_setzero_si256();
+
+		uint32_t count = 0;
+		uint32_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256i life = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&pLife[i])), one);
+			uint32_t deadMask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(life, zero))));
+			count += 8 - static_cast<uint32_t>(_mm_popcnt_u32(deadMask));
+		}
+
+		return count + CountSurvivorsScalar(pLife, i, end);
+	}
+
+	PARTICLE_TARGET_AVX2 void CompactStore(float* pDst, __m256i permutation, __m256i storeMask, __m256 value)
+	{
+		_mm256_maskstore_ps(pDst, storeMask, _mm256_permutevar8x32_ps(value, permutation));
+	}
+
+	PARTICLE_TARGET_AVX2 void UpdateSurvivorsAVX2(const StreamPointers& src, const StreamPointers& dst, uint32_t begin, uint32_t end, uint32_t dstOffset, float deltaTime)
+	{
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256 dt = _mm256_set1_ps(deltaTime);
+		const __m256 gravityDelta = _mm256_set1_ps(-GRAVITY * deltaTime);
+
+		uint32_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256i life = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src.Life[i])), one);
+			uint32_t aliveMask = static_cast<uint32_t>(~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(life, zero)))) & 0xff;
+			if (aliveMask == 0)
+			{
+				continue;
+			}
+
+			// integrate。スカラー版と結果を一致させるためFMAは使わない
+			__m256 velocityX = _mm256_loadu_ps(&src.VelocityX[i]);
+			__m256 velocityY = _mm256_add_ps(_mm256_loadu_ps(&src.VelocityY[i]), gravityDelta);
+			__m256 velocityZ = _mm256_loadu_ps(&src.VelocityZ[i]);
+			__m256 positionX = _mm256_add_ps(_mm256_loadu_ps(&src.PositionX[i]), _mm256_mul_ps(velocityX, dt));
+			__m256 positionY = _mm256_add_ps(_mm256_loadu_ps(&src.PositionY[i]), _mm256_mul_ps(velocityY, dt));
+			__m256 positionZ = _mm256_add_ps(_mm256_loadu_ps(&src.PositionZ[i]), _mm256_mul_ps(velocityZ, dt));
+
+			// 生存したレーンを前に詰めて、その数だけ書き込む。
+			// 隣のチャンクの書き込み先を壊さないよう、8要素まとめての書き込みはしない
+			uint32_t count = static_cast<uint32_t>(_mm_popcnt_u32(aliveMask));
+			__m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i*>(COMPACTION_TABLE.Permutations[aliveMask]));
+			__m256i storeMask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&STORE_MASKS[8 - count]));
+
+			CompactStore(&dst.PositionX[dstOffset], permutation, storeMask, positionX);
+			CompactStore(&dst.PositionY[dstOffset], permutation, storeMask, positionY);
+			CompactStore(&dst.PositionZ[dstOffset], permutation, storeMask, positionZ);
+			CompactStore(&dst.VelocityX[dstOffset], permutation, storeMask, velocityX);
+			CompactStore(&dst.VelocityY[dstOffset], permutation, storeMask, velocityY);
+			CompactStore(&dst.VelocityZ[dstOffset], permutation, storeMask, velocityZ);
+			CompactStore(reinterpret_cast<float*>(&dst.Life[dstOffset]), permutation, storeMask, _mm256_castsi256_ps(life));
+			dstOffset += count;
+		}
+
+		// 端数はスカラー版で処理する。SSEの命令に戻る前にYMMの上位を明示的にクリアしておく
+		_mm256_zeroupper();
+		UpdateSurvivorsScalar(src, dst, i, end, dstOffset, deltaTime);
+	}
+}
+
+ParticleSimulator::~ParticleSimulator()
+{
+	Term();
+}
+
+bool ParticleSimulator::Init(uint32_t maxParticles)
+{
+	Term();
+
+	if (maxParticles == 0)
+	{
+		ELOG("Error : maxParticles must be 1 or more.");
+		return false;
+	}
+
+	m_MaxParticles = maxParticles;
+	for (Stream& stream : m_Streams)
+	{
+		stream.PositionX.resize(maxParticles);
+		stream.PositionY.resize(maxParticles);
+		stream.PositionZ.resize(maxParticles);
+		stream.VelocityX.resize(maxParticles);
+		stream.VelocityY.resize(maxParticles);
+		stream.VelocityZ.resize(maxParticles);
+		stream.Life.resize(maxParticles);
+	}
+	m_ChunkOffsets.resize((maxParticles + CHUNK_SIZE - 1) / CHUNK_SIZE);
+
+	if (IsAVX2Supported())
+	{
+		m_SIMDMode = PARTICLE_SIMD_MODE_AVX2;
+	}
+
+	return true;
+}
+
+void ParticleSimulator::Term()
+{
+	for (Stream& stream : m_Streams)
+	{
+		stream = Stream();
+	}
+	m_ChunkOffsets.clear();
+	m_MaxParticles = 0;
+	m_NumParticles = 0;
+	m_NumSurvivors = 0;
+	m_LastDeltaTime = 0.0f;
+	m_CurrStream = 0;
+	m_SIMDMode = PARTICLE_SIMD_MODE_SCALAR;
+}
+
+void ParticleSimulator::Clear()
+{
+	m_NumParticles = 0;
+	m_NumSurvivors = 0;
+	m_LastDeltaTime = 0.0f;
+}
+
+void ParticleSimulator::Update(const ParticleUpdateDesc& desc)
+{
+	Stream& prev = m_Streams[m_CurrStream];
+	Stream& curr = m_Streams[m_CurrStream ^ 1];
+
+	const StreamPointers src = {prev.PositionX.data(), prev.PositionY.data(), prev.PositionZ.data(), prev.VelocityX.data(), prev.VelocityY.data(), prev.VelocityZ.data(), prev.Life.data()};
+	const StreamPointers dst = {curr.PositionX.data(), curr.PositionY.data(), curr.PositionZ.data(), curr.VelocityX.data(), curr.VelocityY.data(), curr.VelocityZ.data(), curr.Life.data()};
+
+	uint32_t prevNumParticles = m_NumParticles;
+	uint32_t chunkCount = (prevNumParticles + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	bool useAVX2 = (m_SIMDMode == PARTICLE_SIMD_MODE_AVX2);
+
+	// チャンクごとの生存数
+	ForEachChunk(prevNumParticles, [&](uint32_t begin, uint32_t end)
+	{
+		m_ChunkOffsets[begin / CHUNK_SIZE] = useAVX2 ? CountSurvivorsAVX2(src.Life, begin, end) : CountSurvivorsScalar(src.Life, begin, end);
+	});
+
+	// 排他的前置和。1Mパーティクルでもチャンク数は64なので逐次で十分
+	uint32_t numSurvivors = 0;
+	for (uint32_t i = 0; i < chunkCount; i++)
+	{
+		uint32_t count = m_ChunkOffsets[i];
+		m_ChunkOffsets[i] = numSurvivors;
+		numSurvivors += count;
+	}
+
+	// 更新と詰め直し
+	float deltaTime = desc.DeltaTime;
+	ForEachChunk(prevNumParticles, [&](uint32_t begin, uint32_t end)
+	{
+		uint32_t dstOffset = m_ChunkOffsets[begin / CHUNK_SIZE];
+		if (useAVX2)
+		{
+			UpdateSurvivorsAVX2(src, dst, begin, end, dstOffset, deltaTime);
+		}
+		else
+		{
+			UpdateSurvivorsScalar(src, dst, begin, end, dstOffset, deltaTime);
+		}
+	});
+
+	// 生成。乱数のキーはシェーダと同じく生存数によらない生成の番号iにする
+	uint32_t numSpawn = std::min(desc.NumSpawnPerFrame, m_MaxParticles - numSurvivors);
+	ForEachChunk(numSpawn, [&](uint32_t begin, uint32_t end)
+	{
+		// 速度の書き込み先を乱数の置き場所に使い、その場で速度に変換する
+		float* pRandomVals = &dst.VelocityX[numSurvivors];
+		float* pRandomAngles = &dst.VelocityZ[numSurvivors];
+		float* const pResults[4] = {pRandomVals + begin, pRandomAngles + begin, nullptr, nullptr};
+		GenerateRandomUnitFloatBatch(begin, end - begin, desc.FrameIndex, RANDOM_STREAM_SPAWN, desc.RandomSeed, pResults, useAVX2);
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t dstIdx = numSurvivors + i;
+
+			float randomVal = pRandomVals[i];
+			float angle = pRandomAngles[i] * 2.0f * PI;
+			float sinVal = sinf(angle);
+			float cosVal = cosf(angle);
+
+			dst.PositionX[dstIdx] = 0.0f;
+			dst.PositionY[dstIdx] = 0.0f;
+			dst.PositionZ[dstIdx] = 0.0f;
+			dst.VelocityX[dstIdx] = cosVal * randomVal * desc.InitialVelocityScale;
+			dst.VelocityY[dstIdx] = 2.0f * randomVal * desc.InitialVelocityScale;
+			dst.VelocityZ[dstIdx] = sinVal * randomVal * desc.InitialVelocityScale;
+			dst.Life[dstIdx] = desc.InitialLife;
+		}
+	});
+
+	m_NumParticles = numSurvivors + numSpawn;
+	m_NumSurvivors = numSurvivors;
+	m_LastDeltaTime = deltaTime;
+	m_CurrStream ^= 1;
+}
+
+uint32_t ParticleSimulator::CollideWithAABBs(const AABBHashGrid& grid, float radius, float restitution)
+{
+	assert(grid.GetMargin() >= radius);
+
+	Stream& curr = m_Streams[m_CurrStream];
+	uint32_t chunkCount = (m_NumParticles + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	std::vector<uint32_t> chunkHitCounts(chunkCount, 0);
+
+	ForEachChunk(m_NumParticles, [&](uint32_t begin, uint32_t end)
+	{
+		uint32_t hitCount = 0;
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			float position[3] = {curr.PositionX[i], curr.PositionY[i], curr.PositionZ[i]};
+			float velocity[3] = {curr.VelocityX[i], curr.VelocityY[i], curr.VelocityZ[i]};
+			bool isHit = false;
+
+			grid.ForEachCandidate(DirectX::SimpleMath::Vector3(position[0], position[1], position[2]), [&](uint32_t aabbIdx, const AABB& aabb)
+			{
+				const float center[3] = {aabb.Center.x, aabb.Center.y, aabb.Center.z};
+				const float halfExtent[3] = {aabb.HalfExtent.x + radius, aabb.HalfExtent.y + radius, aabb.HalfExtent.z + radius};
+
+				uint32_t pushAxis = 0;
+				float minPenetration = FLT_MAX;
+				for (uint32_t axis = 0; axis < 3; axis++)
+				{
+					float penetration = halfExtent[axis] - fabsf(position[axis] - center[axis]);
+					if (penetration <= 0.0f)
+					{
+						return;
+					}
+
+					if (penetration < minPenetration)
+					{
+						minPenetration = penetration;
+						pushAxis = axis;
+					}
+				}
+
+				float normal = (position[pushAxis] >= center[pushAxis]) ? 1.0f : -1.0f;
+				position[pushAxis] = center[pushAxis] + normal * halfExtent[pushAxis];
+				if (velocity[pushAxis] * normal < 0.0f)
+				{
+					velocity[pushAxis] = -velocity[pushAxis] * restitution;
+				}
+				isHit = true;
+			});
+
+			if (isHit)
+			{
+				curr.PositionX[i] = position[0];
+				curr.PositionY[i] = position[1];
+				curr.PositionZ[i] = position[2];
+				curr.VelocityX[i] = velocity[0];
+				curr.VelocityY[i] = velocity[1];
+				curr.VelocityZ[i] = velocity[2];
+				hitCount++;
+			}
+		}
+
+		chunkHitCounts[begin / CHUNK_SIZE] = hitCount;
+	});
+
+	uint32_t totalHitCount = 0;
+	for (uint32_t hitCount : chunkHitCounts)
+	{
+		totalHitCount += hitCount;
+	}
+	return totalHitCount;
+}
+
+void ParticleSimulator::ComputeViewDepthKeys(const DirectX::SimpleMath::Matrix& view, float alpha, bool backToFront, uint32_t* pKeys) const
+{
+	const Stream& curr = m_Streams[m_CurrStream];
+	float rewindTime = (1.0f - alpha) * m_LastDeltaTime;
+
+	// 行ベクトルなので、ビュー空間のzは3列目との内積。視線方向は-z
+	float viewZX = -view._13;
+	float viewZY = -view._23;
+	float viewZZ = -view._33;
+	float viewZW = -view._43;
+	uint32_t keyMask = backToFront ? UINT32_MAX : 0;
+
+	ForEachChunk(m_NumParticles, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			// 生成したばかりのパーティクルは補間しない
+			float t = (i < m_NumSurvivors) ? rewindTime : 0.0f;
+			float positionX = curr.PositionX[i] - curr.VelocityX[i] * t;
+			float positionY = curr.PositionY[i] - curr.VelocityY[i] * t;
+			float positionZ = curr.PositionZ[i] - curr.VelocityZ[i] * t;
+			float depth = positionX * viewZX + positionY * viewZY + positionZ * viewZZ + viewZW;
+			pKeys[i] = FloatToSortableKey(depth) ^ keyMask;
+		}
+	});
+}
+
+void ParticleSimulator::CopyParticles(ParticleData* pDst) const
+{
+	const Stream& curr = m_Streams[m_CurrStream];
+
+	ForEachChunk(m_NumParticles, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			ParticleData& particle = pDst[i];
+			particle.Position = DirectX::SimpleMath::Vector3(curr.PositionX[i], curr.PositionY[i], curr.PositionZ[i]);
+			particle.Velocity = DirectX::SimpleMath::Vector3(curr.VelocityX[i], curr.VelocityY[i], curr.VelocityZ[i]);
+			particle.Life = curr.Life[i];
+		}
+	});
+}
+
+void ParticleSimulator::CopyInterpolatedParticles(float alpha, ParticleData* pDst) const
+{
+	const Stream& curr = m_Streams[m_CurrStream];
+	// 積分は位置 += 速度 * DeltaTimeなので、(1 - alpha) * DeltaTime分だけ巻き戻す
+	float rewindTime = (1.0f - alpha) * m_LastDeltaTime;
+
+	ForEachChunk(m_NumParticles, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			float t = (i < m_NumSurvivors) ? rewindTime : 0.0f;
+			ParticleData& particle = pDst[i];
+			particle.Position = DirectX::SimpleMath::Vector3(curr.PositionX[i] - curr.VelocityX[i] * t, curr.PositionY[i] - curr.VelocityY[i] * t, curr.PositionZ[i] - curr.VelocityZ[i] * t);
+			particle.Velocity = DirectX::SimpleMath::Vector3(curr.VelocityX[i], curr.VelocityY[i], curr.VelocityZ[i]);
+			particle.Life = curr.Life[i];
+		}
+	});
+}
+
+void ParticleSimulator::SaveSnapshot(std::vector<uint8_t>& data) const
+{
+	const Stream& curr = m_Streams[m_CurrStream];
+
+	SnapshotHeader header;
+	header.Magic = SNAPSHOT_MAGIC;
+	header.Version = SNAPSHOT_VERSION;
+	header.NumParticles = m_NumParticles;
+	header.NumSurvivors = m_NumSurvivors;
+	header.LastDeltaTime = m_LastDeltaTime;
+
+	// ヘッダの後ろにSoAの各配列を有効な要素数だけ並べる
+	const void* pArrays[] = {curr.PositionX.data(), curr.PositionY.data(), curr.PositionZ.data(), curr.VelocityX.data(), curr.VelocityY.data(), curr.VelocityZ.data(), curr.Life.data()};
+	size_t arraySize = sizeof(uint32_t) * m_NumParticles;
+
+	data.resize(sizeof(header) + arraySize * std::size(pArrays));
+	uint8_t* pDst = data.data();
+	memcpy(pDst, &header, sizeof(header));
+	pDst += sizeof(header);
+	for (const void* pArray : pArrays)
+	{
+		memcpy(pDst, pArray, arraySize);
+		pDst += arraySize;
+	}
+}
+
+bool ParticleSimulator::LoadSnapshot(const uint8_t* pData, size_t size)
+{
+	SnapshotHeader header;
+	if (size < sizeof(header))
+	{
+		ELOG("Error : Particle snapshot is too small. size = %zu", size);
+		return false;
+	}
+	memcpy(&header, pData, sizeof(header));
+
+	if (header.Magic != SNAPSHOT_MAGIC || header.Version != SNAPSHOT_VERSION)
+	{
+		ELOG("Error : Invalid particle snapshot. magic = 0x%08x, version = %u", header.Magic, header.Version);
+		return false;
+	}
+
+	if (header.NumParticles > m_MaxParticles || header.NumSurvivors > header.NumParticles)
+	{
+		ELOG("Error : Particle snapshot has too many particles. numParticles = %u, maxParticles = %u", header.NumParticles, m_MaxParticles);
+		return false;
+	}
+
+	Stream& curr = m_Streams[m_CurrStream];
+	void* pArrays[] = {curr.PositionX.data(), curr.PositionY.data(), curr.PositionZ.data(), curr.VelocityX.data(), curr.VelocityY.data(), curr.VelocityZ.data(), curr.Life.data()};
+	size_t arraySize = sizeof(uint32_t) * header.NumParticles;
+
+	if (size != sizeof(header) + arraySize * std::size(pArrays))
+	{
+		ELOG("Error : Particle snapshot size mismatch. size = %zu, numParticles = %u", size, header.NumParticles);
+		return false;
+	}
+
+	const uint8_t* pSrc = pData + sizeof(header);
+	for (void* pArray : pArrays)
+	{
+		memcpy(pArray, pSrc, arraySize);
+		pSrc += arraySize;
+	}
+
+	m_NumParticles = header.NumParticles;
+	m_NumSurvivors = header.NumSurvivors;
+	m_LastDeltaTime = header.LastDeltaTime;
+	return true;
+}
+
+uint64_t ParticleSimulator::ComputeStateHash() const
+{
+	const Stream& curr = m_Streams[m_CurrStream];
+	size_t arraySize = sizeof(uint32_t) * m_NumParticles;
+
+	uint64_t hash = FNV_OFFSET_BASIS;
+	hash = HashBytes(hash, &m_NumParticles, sizeof(m_NumParticles));
+	hash = HashBytes(hash, curr.PositionX.data(), arraySize);
+	hash = HashBytes(hash, curr.PositionY.data(), arraySize);
+	hash = HashBytes(hash, curr.PositionZ.data(), arraySize);
+	hash = HashBytes(hash, curr.VelocityX.data(), arraySize);
+	hash = HashBytes(hash, curr.VelocityY.data(), arraySize);
+	hash = HashBytes(hash, curr.VelocityZ.data(), arraySize);
+	hash = HashBytes(hash, curr.Life.data(), arraySize);
+	return hash;
+}
+
+bool ParticleSimulator::SetSIMDMode(PARTICLE_SIMD_MODE mode)
+{
+	if (mode == PARTICLE_SIMD_MODE_AVX2 && !IsAVX2Supported())
+	{
+		return false;
+	}
+
+	m_SIMDMode = mode;
+	return true;
+}
+
+void ParticleSimulator::ForEachChunk(uint32_t count, const std::function<void(uint32_t begin, uint32_t end)>& func) const
+{
+	if (m_Multithreaded)
+	{
+		ParallelFor(count, CHUNK_SIZE, func);
+		return;
+	}
+
+	for (uint32_t begin = 0; begin < count; begin += CHUNK_SIZE)
+	{
+		func(begin, std::min(begin + CHUNK_SIZE, count));
+	}
+}
@@ -0,0 +1,127 @@
+﻿#include "RadixSort.h"
+#include "ParallelFor.h"
+#include <algorithm>
+
+namespace
+{
+	static constexpr uint32_t RADIX_BITS = 8;
+	static constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+	static constexpr uint32_t RADIX_MASK = RADIX_SIZE - 1;
+	static constexpr uint32_t NUM_PASSES = 32 / RADIX_BITS;
+	// これより少ない要素数のチャンクには分けない
+	static constexpr uint32_t MIN_GRAIN_SIZE = 16384;
+	// スレッドごとの処理量の偏りを均すため、スレッド数より多めのチャンクに分ける
+	static constexpr uint32_t CHUNKS_PER_THREAD = 2;
+}
+
+void RadixSorter::Sort(uint32_t count, uint32_t* pKeys, uint32_t* pValues)
+{
+	m_LastPassCount = 0;
+	if (count <= 1)
+	{
+		return;
+	}
+
+	m_TempKeys.resize(count);
+	m_TempValues.resize(count);
+
+	uint32_t numThreads = m_Multithreaded ? GetParallelForThreadCount() : 1;
+	uint32_t targetChunkCount = numThreads * CHUNKS_PER_THREAD;
+	uint32_t grainSize = std::max(MIN_GRAIN_SIZE, (count + targetChunkCount - 1) / targetChunkCount);
+	uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+	m_Histograms.resize(chunkCount * RADIX_SIZE);
+
+	auto forEachChunk = [&](const std::function<void(uint32_t begin, uint32_t end)>& func)
+	{
+		if (m_Multithreaded && chunkCount > 1)
+		{
+			ParallelFor(count, grainSize, func);
+			return;
+		}
+
+		for (uint32_t begin = 0; begin < count; begin += grainSize)
+		{
+			func(begin, std::min(begin + grainSize, count));
+		}
+	};
+
+	uint32_t* pSrcKeys = pKeys;
+	uint32_t* pSrcValues = pValues;
+	uint32_t* pDstKeys = m_TempKeys.data();
+	uint32_t* pDstValues = m_TempValues.data();
+
+	for (uint32_t pass = 0; pass < NUM_PASSES; pass++)
+	{
+		uint32_t shift = pass * RADIX_BITS;
+
+		// チャンクごとのヒストグラム
+		forEachChunk([&](uint32_t begin, uint32_t end)
+		{
+			uint32_t* pHistogram = &m_Histograms[(begin / grainSize) * RADIX_SIZE];
+			std::fill(pHistogram, pHistogram + RADIX_SIZE, 0);
+
+			for (uint32_t i = begin; i < end; i++)
+			{
+				pHistogram[(pSrcKeys[i] >> shift) & RADIX_MASK]++;
+			}
+		});
+
+		// 全要素がこの桁で同じ値なら並びは変わらない。キーの上位が揃いやすい深度では多い
+		bool isUniformDigit = false;
+		for (uint32_t digit = 0; digit < RADIX_SIZE && !isUniformDigit; digit++)
+		{
+			uint32_t total = 0;
+			for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+			{
+				total += m_Histograms[chunk * RADIX_SIZE + digit];
+			}
+			isUniformDigit = (total == count);
+		}
+		if (isUniformDigit)
+		{
+			continue;
+		}
+
+		// 排他的前置和。桁の順、同じ桁の中ではチャンクの順に並べるとソートが安定になる
+		uint32_t offset = 0;
+		for (uint32_t digit = 0; digit < RADIX_SIZE; digit++)
+		{
+			for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+			{
+				uint32_t& histogram = m_Histograms[chunk * RADIX_SIZE + digit];
+				uint32_t digitCount = histogram;
+				histogram = offset;
+				offset += digitCount;
+			}
+		}
+
+		// チャンクごとに元の順番で書き込む
+		forEachChunk([&](uint32_t begin, uint32_t end)
+		{
+			uint32_t cursors[RADIX_SIZE];
+			memcpy(cursors, &m_Histograms[(begin / grainSize) * RADIX_SIZE], sizeof(cursors));
+
+			for (uint32_t i = begin; i < end; i++)
+			{
+				uint32_t key = pSrcKeys[i];
+				uint32_t dstIdx = cursors[(key >> shift) & RADIX_MASK]++;
+				pDstKeys[dstIdx] = key;
+				pDstValues[dstIdx] = pSrcValues[i];
+			}
+		});
+
+		std::swap(pSrcKeys, pDstKeys);
+		std::swap(pSrcValues, pDstValues);
+		m_LastPassCount++;
+	}
+
+	// 奇数回のパスで終わったときは結果が作業用のバッファにある
+	if (pSrcKeys != pKeys)
+	{
+		forEachChunk([&](uint32_t begin, uint32_t end)
+		{
+			memcpy(&pKeys[begin], &pSrcKeys[begin], (end - begin) * sizeof(uint32_t));
+			memcpy(&pValues[begin], &pSrcValues[begin], (end - begin) * sizeof(uint32_t));
+		});
+	}
+}
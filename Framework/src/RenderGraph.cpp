@@ -0,0 +1,275 @@
+﻿#include "RenderGraph.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+
+RenderGraph::RenderGraph()
+: m_PassCount(0)
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+	Term();
+}
+
+void RenderGraph::Term()
+{
+	m_Resources.clear();
+	m_Passes.clear();
+	m_PassCount = 0;
+	m_Stats = RenderGraphStats();
+}
+
+uint32_t RenderGraph::AddTransientResource(const char* name, uint64_t size, uint64_t alignment)
+{
+	if (size == 0 || alignment == 0)
+	{
+		ELOG("Error : Invalid Arguments. name = %s", name);
+		return INVALID_INDEX;
+	}
+
+	return AddResource(name, size, alignment, false);
+}
+
+uint32_t RenderGraph::AddImportedResource(const char* name)
+{
+	return AddResource(name, 0, 1, true);
+}
+
+uint32_t RenderGraph::AddResource(const char* name, uint64_t size, uint64_t alignment, bool isImported)
+{
+	Resource resource;
+	resource.Name = (name != nullptr) ? name : "";
+	resource.Size = size;
+	resource.Alignment = alignment;
+	resource.IsImported = isImported;
+	resource.IsNeeded = false;
+	resource.FirstPass = INVALID_INDEX;
+	resource.LastPass = INVALID_INDEX;
+
+	m_Resources.emplace_back(std::move(resource));
+	return static_cast<uint32_t>(m_Resources.size() - 1);
+}
+
+void RenderGraph::ResetPasses()
+{
+	m_PassCount = 0;
+}
+
+uint32_t RenderGraph::AddPass(const char* name, std::initializer_list<uint32_t> reads, std::initializer_list<uint32_t> writes, std::function<void()> execute)
+{
+	for (uint32_t resourceIdx : reads)
+	{
+		if (resourceIdx >= m_Resources.size())
+		{
+			ELOG("Error : Invalid Read Resource. pass = %s", name);
+			return INVALID_INDEX;
+		}
+	}
+
+	for (uint32_t resourceIdx : writes)
+	{
+		if (resourceIdx >= m_Resources.size())
+		{
+			ELOG("Error : Invalid Write Resource. pass = %s", name);
+			return INVALID_INDEX;
+		}
+	}
+
+	if (m_PassCount == m_Passes.size())
+	{
+		m_Passes.emplace_back();
+	}
+
+	Pass& pass = m_Passes[m_PassCount];
+	pass.Name = (name != nullptr) ? name : "";
+	pass.Reads.assign(reads.begin(), reads.end());
+	pass.Writes.assign(writes.begin(), writes.end());
+	pass.Execute = std::move(execute);
+	pass.IsCulled = false;
+
+	return m_PassCount++;
+}
+
+void RenderGraph::Compile()
+{
+	CullPasses();
+	ComputeLifetimes();
+	ComputeStats();
+}
+
+void RenderGraph::Execute() const
+{
+	for (uint32_t passIdx = 0; passIdx < m_PassCount; passIdx++)
+	{
+		const Pass& pass = m_Passes[passIdx];
+		if (!pass.IsCulled && pass.Execute)
+		{
+			pass.Execute();
+		}
+	}
+}
+
+bool RenderGraph::IsPassCulled(uint32_t passIdx) const
+{
+	assert(passIdx < m_PassCount);
+	return m_Passes[passIdx].IsCulled;
+}
+
+uint32_t RenderGraph::GetFirstPass(uint32_t resourceIdx) const
+{
+	assert(resourceIdx < m_Resources.size());
+	return m_Resources[resourceIdx].FirstPass;
+}
+
+uint32_t RenderGraph::GetLastPass(uint32_t resourceIdx) const
+{
+	assert(resourceIdx < m_Resources.size());
+	return m_Resources[resourceIdx].LastPass;
+}
+
+uint64_t RenderGraph::GetSize(uint32_t resourceIdx) const
+{
+	assert(resourceIdx < m_Resources.size());
+	return m_Resources[resourceIdx].Size;
+}
+
+uint64_t RenderGraph::GetAlignment(uint32_t resourceIdx) const
+{
+	assert(resourceIdx < m_Resources.size());
+	return m_Resources[resourceIdx].Alignment;
+}
+
+void RenderGraph::CullPasses()
+{
+	// 後ろのパスから辿り、インポートしたリソースを書くか、後ろの生きているパスが読むリソースを書くパスを残す。
+	// 残したパスが読むリソースは、それより前で書くパスにとって必要になる。
+	// 前で書いたものを読むのは後ろのパスだけなので、フレームの中で書く前に読むもの(前のフレームの中身)は書くパスを生かさない
+	for (Resource& resource : m_Resources)
+	{
+		resource.IsNeeded = false;
+	}
+
+	for (uint32_t passIdx = m_PassCount; passIdx-- > 0;)
+	{
+		Pass& pass = m_Passes[passIdx];
+
+		bool isAlive = false;
+		for (uint32_t resourceIdx : pass.Writes)
+		{
+			const Resource& resource = m_Resources[resourceIdx];
+			if (resource.IsImported || resource.IsNeeded)
+			{
+				isAlive = true;
+				break;
+			}
+		}
+
+		pass.IsCulled = !isAlive;
+		if (!isAlive)
+		{
+			continue;
+		}
+
+		// 重ね描きするものは前の中身を読むので、前で書くパスも残す
+		for (uint32_t resourceIdx : pass.Reads)
+		{
+			m_Resources[resourceIdx].IsNeeded = true;
+		}
+	}
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+	for (Resource& resource : m_Resources)
+	{
+		resource.FirstPass = INVALID_INDEX;
+		resource.LastPass = INVALID_INDEX;
+	}
+
+	uint32_t lastAlivePass = 0;
+	for (uint32_t passIdx = 0; passIdx < m_PassCount; passIdx++)
+	{
+		if (!m_Passes[passIdx].IsCulled)
+		{
+			lastAlivePass = passIdx;
+		}
+	}
+
+	for (uint32_t passIdx = 0; passIdx < m_PassCount; passIdx++)
+	{
+		const Pass& pass = m_Passes[passIdx];
+		if (pass.IsCulled)
+		{
+			continue;
+		}
+
+		// フレームの中で書く前に読むものは前のフレームの中身を使っているので、フレーム全体を寿命にして他と共有させない
+		for (uint32_t resourceIdx : pass.Reads)
+		{
+			Resource& resource = m_Resources[resourceIdx];
+			if (!resource.IsImported && resource.FirstPass == INVALID_INDEX)
+			{
+				resource.FirstPass = 0;
+				resource.LastPass = lastAlivePass;
+			}
+		}
+
+		for (uint32_t resourceIdx : pass.Writes)
+		{
+			Resource& resource = m_Resources[resourceIdx];
+			if (!resource.IsImported && resource.FirstPass == INVALID_INDEX)
+			{
+				resource.FirstPass = passIdx;
+				resource.LastPass = passIdx;
+			}
+		}
+
+		for (uint32_t resourceIdx : pass.Reads)
+		{
+			Resource& resource = m_Resources[resourceIdx];
+			if (!resource.IsImported)
+			{
+				resource.LastPass = std::max(resource.LastPass, passIdx);
+			}
+		}
+
+		for (uint32_t resourceIdx : pass.Writes)
+		{
+			Resource& resource = m_Resources[resourceIdx];
+			if (!resource.IsImported)
+			{
+				resource.LastPass = std::max(resource.LastPass, passIdx);
+			}
+		}
+	}
+}
+
+void RenderGraph::ComputeStats()
+{
+	m_Stats = RenderGraphStats();
+	m_Stats.PassCount = m_PassCount;
+	for (uint32_t passIdx = 0; passIdx < m_PassCount; passIdx++)
+	{
+		if (m_Passes[passIdx].IsCulled)
+		{
+			m_Stats.CulledPassCount++;
+		}
+	}
+
+	for (const Resource& resource : m_Resources)
+	{
+		if (resource.IsImported)
+		{
+			continue;
+		}
+
+		m_Stats.DeclaredSize += resource.Size;
+		if (resource.FirstPass != INVALID_INDEX)
+		{
+			m_Stats.TransientResourceCount++;
+			m_Stats.TransientSize += resource.Size;
+		}
+	}
+}
@@ -50,11 +50,11 @@ namespace
 			std::vector<ResMesh>& meshes,
 			std::vector<ResMaterial>& materials
 		);
+		void BuildMeshlet(ResMesh& dstMesh, bool useMetis);
 	
 	private:
 		void ParseMesh(ResMesh& dstMesh, const aiMesh* pSrcMesh);
 		void ParseMaterial(ResMaterial& dstMaterial, const aiMaterial* pSrcMaterial);
-		void BuildMeshlet(ResMesh& dstMesh, bool useMetis);
 	};
 
 	MeshLoader::MeshLoader()
@@ -803,3 +803,15 @@ bool LoadMesh
 	MeshLoader loader;
 	return loader.Load(filename, buildMeshlet, useMetis, meshes, materials);
 }
+
+void BuildMeshlet(ResMesh& mesh, bool useMetis)
+{
+	mesh.Meshlets.clear();
+	mesh.MeshletsVertices.clear();
+	mesh.MeshletsTriangles.clear();
+	mesh.Bounds.clear();
+	mesh.AABBs.clear();
+
+	MeshLoader loader;
+	loader.BuildMeshlet(mesh, useMetis);
+}
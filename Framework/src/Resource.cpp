@@ -1,6 +1,9 @@
 #include "Resource.h"
 #include "DescriptorPool.h"
-#include <DirectXHelpers.h>
+#include "UploadRing.h"
+#include "Logger.h"
+
+UploadRing* Resource::s_pUploadRing = nullptr;
 
 Resource::~Resource()
 {
@@ -581,10 +584,74 @@ bool Resource::InitAsAccelerationStructure(ID3D12Device* pDevice, size_t size, D
 	return false;
 }
 
+bool Resource::InitAsSubAllocatedStructuredBuffer
+(
+	ID3D12Device* pDevice,
+	BufferSuballocator* pSuballocator,
+	size_t count,
+	size_t structureSize,
+	DescriptorPool* pPoolSRV
+)
+{
+	if (pDevice == nullptr || pSuballocator == nullptr || count == 0 || structureSize == 0)
+	{
+		return false;
+	}
+
+	assert(m_pResource == nullptr);
+	assert(m_pPoolSRV == nullptr);
+	assert(m_pHandleSRV == nullptr);
+
+	m_size = count * structureSize;
+
+	// FirstElementŔ͈͂̐擪w悤ɁAvf̑傫̔{̃ItZbg؂o
+	if (!pSuballocator->Allocate(m_size, structureSize, m_Allocation))
+	{
+		ELOG("Error : BufferSuballocator::Allocate() Failed.");
+		return false;
+	}
+
+	m_pSuballocator = pSuballocator;
+	m_pResource = m_Allocation.pResource;
+	// y[WCOMMONōĂāA͈͂ƂɂStateĂȂ̂ŏCOMMONƂĈ
+	m_state = D3D12_RESOURCE_STATE_COMMON;
+
+	if (pPoolSRV != nullptr)
+	{
+		m_pPoolSRV = pPoolSRV;
+		m_pPoolSRV->AddRef();
+
+		m_pHandleSRV = pPoolSRV->AllocHandle();
+		if (m_pHandleSRV == nullptr)
+		{
+			return false;
+		}
+
+		const D3D12_SHADER_RESOURCE_VIEW_DESC& srvDesc = BufferSuballocator::GetStructuredBufferSRVDesc(m_Allocation, static_cast<uint32_t>(structureSize));
+		pDevice->CreateShaderResourceView(
+			m_pResource.Get(),
+			&srvDesc,
+			m_pHandleSRV->HandleCPU
+		);
+	}
+
+	m_VBV.BufferLocation = GetGPUVirtualAddress();
+	m_VBV.StrideInBytes = static_cast<UINT>(structureSize);
+	m_VBV.SizeInBytes = static_cast<UINT>(m_size);
+
+	return true;
+}
+
 void Resource::Term()
 {
 	m_pResource.Reset();
-	m_pUploadBuffer.Reset(); // TODO:{̓R[obN΃Rs[ExecuteCommandListsɂ̂łB
+
+	if (m_pSuballocator != nullptr)
+	{
+		m_pSuballocator->Free(m_Allocation);
+		m_pSuballocator = nullptr;
+		m_Allocation = BufferAllocation();
+	}
 
 	if (m_pHandleSRV != nullptr && m_pPoolSRV != nullptr)
 	{
@@ -636,58 +703,24 @@ bool Resource::UploadBufferData
 		return false;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_pResource.Get(), m_state, D3D12_RESOURCE_STATE_COPY_DEST);
-
-	D3D12_HEAP_PROPERTIES prop = {};
-	prop.Type = D3D12_HEAP_TYPE_UPLOAD;
-	prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-	prop.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	prop.CreationNodeMask = 1;
-	prop.VisibleNodeMask = 1;
-
-	D3D12_RESOURCE_DESC desc = {};
-	desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-	desc.Alignment = 0;
-	desc.Width = size;
-	desc.Height = 1;
-	desc.DepthOrArraySize = 1;
-	desc.MipLevels = 1;
-	desc.Format = DXGI_FORMAT_UNKNOWN;
-	desc.SampleDesc.Count = 1;
-	desc.SampleDesc.Quality = 0;
-	desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-	desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-	HRESULT hr = pDevice->CreateCommittedResource
-	(
-		&prop,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_COMMON,
-		nullptr,
-		IID_PPV_ARGS(m_pUploadBuffer.GetAddressOf())
-	);
-	if (FAILED(hr))
+	if (s_pUploadRing == nullptr)
 	{
+		ELOG("Error : UploadRing is not set.");
 		return false;
 	}
 
-	void* ptr;
-	hr = m_pUploadBuffer->Map(0, nullptr, &ptr);
-	if (FAILED(hr) || ptr == nullptr)
+	// ÕR}hXgł̓obt@COMMONÖقCOPY_DESTɂȂ̂ŁȀԂɂ炸ɃRs[ł
+	if (m_pSuballocator != nullptr)
 	{
-		return false;
+		return m_pSuballocator->Upload(s_pUploadRing, m_Allocation, size, pData);
 	}
 
-	memcpy(ptr, pData, size);
-
-	m_pUploadBuffer->Unmap(0, nullptr);
-
-	pCmdList->CopyBufferRegion(m_pResource.Get(), 0, m_pUploadBuffer.Get(), 0, size);
-
-	DirectX::TransitionResource(pCmdList, m_pResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, m_state);
+	return s_pUploadRing->Upload(m_pResource.Get(), 0, size, pData);
+}
 
-	return true;
+void Resource::SetUploadRing(UploadRing* pUploadRing)
+{
+	s_pUploadRing = pUploadRing;
 }
 
 void* Resource::Map() const
@@ -762,6 +795,11 @@ ID3D12Resource* Resource::GetResource() const
 	return m_pResource.Get();
 }
 
+D3D12_GPU_VIRTUAL_ADDRESS Resource::GetGPUVirtualAddress() const
+{
+	return m_pResource->GetGPUVirtualAddress() + m_Allocation.Offset;
+}
+
 size_t Resource::GetSize() const
 {
 	return m_size;
@@ -0,0 +1,350 @@
+﻿#include "ResourceStateTracker.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+
+ResourceStateTracker::ResourceStateTracker()
+: m_ResourceCount(0)
+{
+}
+
+ResourceStateTracker::~ResourceStateTracker()
+{
+}
+
+void ResourceStateTracker::Transition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+	if (pResource == nullptr)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return;
+	}
+
+	// DirectX::TransitionResource()と同じく、同じ状態への遷移は何もしない
+	if (before == after)
+	{
+		return;
+	}
+
+	m_Stats.RequestedCount++;
+
+	uint32_t resourceIdx = FindOrAddResource(pResource, before);
+	CompleteSplitTransition(resourceIdx);
+
+	ResourceState& state = m_Resources[resourceIdx];
+#if defined(DEBUG) || defined(_DEBUG)
+	for (D3D12_RESOURCE_STATES pending : state.Pending)
+	{
+		assert(pending == before);
+	}
+#endif
+
+	state.Pending.assign(state.Pending.size(), after);
+	MarkDirty(resourceIdx);
+}
+
+void ResourceStateTracker::TransitionSubresource(ID3D12Resource* pResource, uint32_t subresourceCount, uint32_t subresource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+	if (pResource == nullptr || subresource >= subresourceCount)
+	{
+		ELOG("Error : Invalid Arguments. subresource = %u, subresourceCount = %u", subresource, subresourceCount);
+		return;
+	}
+
+	if (before == after)
+	{
+		return;
+	}
+
+	m_Stats.RequestedCount++;
+
+	uint32_t resourceIdx = FindOrAddResource(pResource, before);
+	CompleteSplitTransition(resourceIdx);
+
+	ResourceState& state = m_Resources[resourceIdx];
+	if (state.Pending.size() == 1 && subresourceCount > 1)
+	{
+		// assign()に自分の要素を渡さないように値を取り出しておく
+		D3D12_RESOURCE_STATES current = state.Current[0];
+		D3D12_RESOURCE_STATES pending = state.Pending[0];
+		state.Current.assign(subresourceCount, current);
+		state.Pending.assign(subresourceCount, pending);
+	}
+
+	assert(state.Pending.size() == subresourceCount);
+	assert(state.Pending[subresource] == before);
+
+	state.Pending[subresource] = after;
+	MarkDirty(resourceIdx);
+}
+
+void ResourceStateTracker::BeginSplitTransition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+	if (pResource == nullptr)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return;
+	}
+
+	if (before == after)
+	{
+		return;
+	}
+
+	uint32_t resourceIdx = FindOrAddResource(pResource, before);
+	CompleteSplitTransition(resourceIdx);
+
+	// サブリソースごとに状態を追跡しているものは分割せずに普通の遷移にする
+	if (m_Resources[resourceIdx].Pending.size() != 1)
+	{
+		Transition(pResource, before, after);
+		return;
+	}
+
+	m_Stats.RequestedCount++;
+
+	ResourceState& state = m_Resources[resourceIdx];
+	assert(state.Pending[0] == before);
+
+	state.Pending[0] = after;
+	state.SplitBefore = before;
+	state.SplitAfter = after;
+	state.SplitPhase = SPLIT_PHASE::BEGIN_PENDING;
+	MarkDirty(resourceIdx);
+}
+
+void ResourceStateTracker::EndSplitTransition(ID3D12Resource* pResource)
+{
+	std::unordered_map<ID3D12Resource*, uint32_t>::const_iterator it = m_ResourceIndices.find(pResource);
+	if (it == m_ResourceIndices.end())
+	{
+		return;
+	}
+
+	CompleteSplitTransition(it->second);
+}
+
+void ResourceStateTracker::UAVBarrier(ID3D12Resource* pResource)
+{
+	m_Stats.RequestedCount++;
+
+	if (std::find(m_UAVBarriers.begin(), m_UAVBarriers.end(), pResource) == m_UAVBarriers.end())
+	{
+		m_UAVBarriers.push_back(pResource);
+	}
+}
+
+uint32_t ResourceStateTracker::FindOrAddResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES before)
+{
+	std::unordered_map<ID3D12Resource*, uint32_t>::const_iterator it = m_ResourceIndices.find(pResource);
+	if (it != m_ResourceIndices.end())
+	{
+		return it->second;
+	}
+
+	if (m_ResourceCount == m_Resources.size())
+	{
+		m_Resources.emplace_back();
+	}
+
+	ResourceState& state = m_Resources[m_ResourceCount];
+	state.pResource = pResource;
+	state.Current.assign(1, before);
+	state.Pending.assign(1, before);
+	state.SplitBefore = before;
+	state.SplitAfter = before;
+	state.SplitPhase = SPLIT_PHASE::NONE;
+	state.IsDirty = false;
+
+	m_ResourceIndices.emplace(pResource, m_ResourceCount);
+	return m_ResourceCount++;
+}
+
+void ResourceStateTracker::MarkDirty(uint32_t resourceIdx)
+{
+	ResourceState& state = m_Resources[resourceIdx];
+	if (!state.IsDirty)
+	{
+		state.IsDirty = true;
+		m_DirtyResources.push_back(resourceIdx);
+	}
+}
+
+void ResourceStateTracker::CompleteSplitTransition(uint32_t resourceIdx)
+{
+	ResourceState& state = m_Resources[resourceIdx];
+	switch (state.SplitPhase)
+	{
+		case SPLIT_PHASE::BEGIN_PENDING:
+			// まだ何も発行していないので、Pendingへの普通の遷移として他の遷移とまとめる
+			state.SplitPhase = SPLIT_PHASE::NONE;
+			break;
+		case SPLIT_PHASE::BEGUN:
+			state.SplitPhase = SPLIT_PHASE::END_PENDING;
+			MarkDirty(resourceIdx);
+			break;
+		case SPLIT_PHASE::NONE:
+		case SPLIT_PHASE::END_PENDING:
+			break;
+		default:
+			assert(false);
+			break;
+	}
+}
+
+void ResourceStateTracker::EndAllSplitTransitions()
+{
+	for (uint32_t resourceIdx = 0; resourceIdx < m_ResourceCount; resourceIdx++)
+	{
+		CompleteSplitTransition(resourceIdx);
+	}
+}
+
+const std::vector<D3D12_RESOURCE_BARRIER>& ResourceStateTracker::ResolveBarriers()
+{
+	m_Barriers.clear();
+
+	for (uint32_t resourceIdx : m_DirtyResources)
+	{
+		ResourceState& state = m_Resources[resourceIdx];
+		ResolveTransitions(state);
+		state.IsDirty = false;
+	}
+	m_DirtyResources.clear();
+
+	size_t transitionCount = m_Barriers.size();
+	bool hasGlobalUAVBarrier = (std::find(m_UAVBarriers.begin(), m_UAVBarriers.end(), nullptr) != m_UAVBarriers.end());
+	for (ID3D12Resource* pResource : m_UAVBarriers)
+	{
+		// 全てのUAVアクセスを待つバリアがあれば、リソースごとのものはいらない
+		if (hasGlobalUAVBarrier && pResource != nullptr)
+		{
+			continue;
+		}
+
+		// 同じバッチでUAVの状態から出ていくリソースは、遷移のバリアが書き込みの完了を待つのでUAVバリアはいらない
+		bool isTransitionedFromUAV = false;
+		for (size_t i = 0; i < transitionCount; i++)
+		{
+			const D3D12_RESOURCE_TRANSITION_BARRIER& transition = m_Barriers[i].Transition;
+			if (transition.pResource == pResource && (transition.StateBefore & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0)
+			{
+				isTransitionedFromUAV = true;
+				break;
+			}
+		}
+		if (isTransitionedFromUAV)
+		{
+			continue;
+		}
+
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		barrier.UAV.pResource = pResource;
+		m_Barriers.push_back(barrier);
+	}
+	m_UAVBarriers.clear();
+
+	if (!m_Barriers.empty())
+	{
+		m_Stats.IssuedCount += static_cast<uint32_t>(m_Barriers.size());
+		m_Stats.FlushCount++;
+	}
+
+	return m_Barriers;
+}
+
+void ResourceStateTracker::ResolveTransitions(ResourceState& state)
+{
+	if (state.SplitPhase == SPLIT_PHASE::END_PENDING)
+	{
+		AddTransitionBarrier(state.pResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, state.SplitBefore, state.SplitAfter, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+		state.Current.assign(state.Current.size(), state.SplitAfter);
+		state.SplitPhase = SPLIT_PHASE::NONE;
+	}
+
+	switch (state.SplitPhase)
+	{
+		case SPLIT_PHASE::BEGIN_PENDING:
+			// 分割バリアの前に要求された遷移があれば、先に普通の遷移で開始の状態にしておく
+			assert(state.Current.size() == 1);
+			if (state.Current[0] != state.SplitBefore)
+			{
+				AddTransitionBarrier(state.pResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, state.Current[0], state.SplitBefore, D3D12_RESOURCE_BARRIER_FLAG_NONE);
+			}
+			AddTransitionBarrier(state.pResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, state.SplitBefore, state.SplitAfter, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+			state.Current[0] = state.SplitBefore;
+			state.SplitPhase = SPLIT_PHASE::BEGUN;
+			m_Stats.SplitCount++;
+			return;
+		case SPLIT_PHASE::BEGUN:
+			// END_ONLYを発行するまではCurrentのままにしておく
+			return;
+		case SPLIT_PHASE::NONE:
+			break;
+		case SPLIT_PHASE::END_PENDING:
+		default:
+			assert(false);
+			return;
+	}
+
+	assert(state.Current.size() == state.Pending.size());
+
+	bool isCurrentUniform = std::all_of(state.Current.begin(), state.Current.end(), [&state](D3D12_RESOURCE_STATES s) { return s == state.Current[0]; });
+	bool isPendingUniform = std::all_of(state.Pending.begin(), state.Pending.end(), [&state](D3D12_RESOURCE_STATES s) { return s == state.Pending[0]; });
+
+	if (isCurrentUniform && isPendingUniform)
+	{
+		// 全サブリソースが同じ状態から同じ状態へ移るなら1つのバリアにする。行って戻るだけのものはここで消える
+		if (state.Current[0] != state.Pending[0])
+		{
+			AddTransitionBarrier(state.pResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, state.Current[0], state.Pending[0], D3D12_RESOURCE_BARRIER_FLAG_NONE);
+		}
+	}
+	else
+	{
+		for (uint32_t subresource = 0; subresource < state.Current.size(); subresource++)
+		{
+			if (state.Current[subresource] != state.Pending[subresource])
+			{
+				AddTransitionBarrier(state.pResource, subresource, state.Current[subresource], state.Pending[subresource], D3D12_RESOURCE_BARRIER_FLAG_NONE);
+			}
+		}
+	}
+
+	// 全サブリソースが同じ状態に揃ったら、またまとめて追跡する
+	D3D12_RESOURCE_STATES pending = state.Pending[0];
+	if (isPendingUniform)
+	{
+		state.Current.assign(1, pending);
+		state.Pending.assign(1, pending);
+	}
+	else
+	{
+		state.Current = state.Pending;
+	}
+}
+
+void ResourceStateTracker::AddTransitionBarrier(ID3D12Resource* pResource, uint32_t subresource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after, D3D12_RESOURCE_BARRIER_FLAGS flags)
+{
+	D3D12_RESOURCE_BARRIER barrier = {};
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	barrier.Flags = flags;
+	barrier.Transition.pResource = pResource;
+	barrier.Transition.Subresource = subresource;
+	barrier.Transition.StateBefore = before;
+	barrier.Transition.StateAfter = after;
+	m_Barriers.push_back(barrier);
+}
+
+void ResourceStateTracker::Reset()
+{
+	m_ResourceIndices.clear();
+	m_ResourceCount = 0;
+	m_DirtyResources.clear();
+	m_UAVBarriers.clear();
+
+	m_LastFrameStats = m_Stats;
+	m_Stats = ResourceStateTrackerStats();
+}
@@ -0,0 +1,111 @@
+﻿#include "RingAllocator.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+
+bool RingAllocator::Init(uint64_t capacity, uint32_t maxFrameCount)
+{
+	Term();
+
+	if (capacity == 0 || maxFrameCount == 0)
+	{
+		ELOG("Error : Invalid Arguments. capacity = %llu, maxFrameCount = %u", static_cast<unsigned long long>(capacity), maxFrameCount);
+		return false;
+	}
+
+	m_Capacity = capacity;
+	m_PendingFrames.resize(maxFrameCount);
+	return true;
+}
+
+void RingAllocator::Term()
+{
+	m_Head.store(0, std::memory_order_relaxed);
+	m_Tail.store(0, std::memory_order_relaxed);
+	m_Capacity = 0;
+	m_FrameBeginPosition = 0;
+	m_PendingFrames.clear();
+	m_PendingFrames.shrink_to_fit();
+	m_FirstPendingFrame = 0;
+	m_PendingFrameCount = 0;
+	m_LastFrameStats = RingAllocatorFrameStats();
+	m_HighWaterMark = 0;
+}
+
+uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	assert(alignment > 0);
+	if (size == 0 || size > m_Capacity)
+	{
+		return INVALID_OFFSET;
+	}
+
+	// Tailはフレームの境目でしか進まないので、確保の間は読むだけでよい
+	uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+	uint64_t head = m_Head.load(std::memory_order_relaxed);
+	while (true)
+	{
+		uint64_t offset = head % m_Capacity;
+		uint64_t alignedOffset = (offset + alignment - 1) / alignment * alignment;
+		uint64_t begin = head + (alignedOffset - offset);
+		// 末尾をまたぐなら残りを飛ばして先頭から確保する
+		if (alignedOffset + size > m_Capacity)
+		{
+			begin = head + (m_Capacity - offset);
+		}
+
+		uint64_t end = begin + size;
+		if (end - tail > m_Capacity)
+		{
+			return INVALID_OFFSET;
+		}
+
+		if (m_Head.compare_exchange_weak(head, end, std::memory_order_relaxed, std::memory_order_relaxed))
+		{
+			return begin % m_Capacity;
+		}
+	}
+}
+
+bool RingAllocator::EndFrame(uint64_t fenceValue)
+{
+	if (m_PendingFrameCount == m_PendingFrames.size())
+	{
+		ELOG("Error : Too many pending frames. count = %u", m_PendingFrameCount);
+		return false;
+	}
+
+	uint64_t head = m_Head.load(std::memory_order_relaxed);
+	uint32_t frameIdx = (m_FirstPendingFrame + m_PendingFrameCount) % static_cast<uint32_t>(m_PendingFrames.size());
+	m_PendingFrames[frameIdx].FenceValue = fenceValue;
+	m_PendingFrames[frameIdx].EndPosition = head;
+	m_PendingFrameCount++;
+
+	m_LastFrameStats.AllocatedSize = head - m_FrameBeginPosition;
+	m_LastFrameStats.InFlightSize = head - m_Tail.load(std::memory_order_relaxed);
+	m_HighWaterMark = std::max(m_HighWaterMark, m_LastFrameStats.InFlightSize);
+	m_FrameBeginPosition = head;
+	return true;
+}
+
+void RingAllocator::Retire(uint64_t completedFenceValue)
+{
+	// フェンスの値は区切った順に増えるので、先頭から完了したところまで返却する
+	while (m_PendingFrameCount > 0)
+	{
+		const PendingFrame& frame = m_PendingFrames[m_FirstPendingFrame];
+		if (frame.FenceValue > completedFenceValue)
+		{
+			break;
+		}
+
+		m_Tail.store(frame.EndPosition, std::memory_order_relaxed);
+		m_FirstPendingFrame = (m_FirstPendingFrame + 1) % static_cast<uint32_t>(m_PendingFrames.size());
+		m_PendingFrameCount--;
+	}
+}
+
+uint64_t RingAllocator::GetUsedSize() const
+{
+	return m_Head.load(std::memory_order_relaxed) - m_Tail.load(std::memory_order_relaxed);
+}
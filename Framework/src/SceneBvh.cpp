@@ -0,0 +1,233 @@
+﻿#include "SceneBvh.h"
+#include "ParallelFor.h"
+#include "Logger.h"
+#include <chrono>
+#include <cmath>
+
+using namespace DirectX::SimpleMath;
+
+bool SceneBvh::Build(const std::vector<std::vector<Vector3>>& meshPositions, const std::vector<Matrix>& worldMatrices, const BvhBuildSettings& settings)
+{
+	Term();
+
+	uint32_t instanceCount = static_cast<uint32_t>(meshPositions.size());
+	if (instanceCount == 0 || worldMatrices.size() != instanceCount)
+	{
+		ELOG("Error : Invalid Arguments. meshPositions = %zu, worldMatrices = %zu", meshPositions.size(), worldMatrices.size());
+		return false;
+	}
+
+	m_Instances.resize(instanceCount);
+	for (uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++)
+	{
+		if (meshPositions[instanceIdx].empty() || meshPositions[instanceIdx].size() % 3 != 0)
+		{
+			ELOG("Error : Invalid Mesh. instanceIdx = %u, positions = %zu", instanceIdx, meshPositions[instanceIdx].size());
+			Term();
+			return false;
+		}
+
+		Instance& instance = m_Instances[instanceIdx];
+		instance.World = worldMatrices[instanceIdx];
+		instance.InvWorld = instance.World.Invert();
+		instance.FirstTriangleIdx = m_TriangleCount;
+		instance.IsDirty = false;
+		m_TriangleCount += static_cast<uint32_t>(meshPositions[instanceIdx].size() / 3);
+	}
+
+	// BLASはメッシュごとに並列に構築する。入れ子のParallelForは逐次になるので、1つのBLASの構築は1スレッドで行われる
+	m_Blases.resize(instanceCount);
+	std::vector<uint8_t> results(instanceCount, 0);
+	ParallelFor(instanceCount, 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t instanceIdx = begin; instanceIdx < end; instanceIdx++)
+		{
+			const std::vector<Vector3>& positions = meshPositions[instanceIdx];
+			std::vector<uint32_t> meshIndices(positions.size() / 3, instanceIdx);
+			results[instanceIdx] = m_Blases[instanceIdx].Build(positions, meshIndices, settings) ? 1 : 0;
+		}
+	});
+
+	for (uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++)
+	{
+		if (results[instanceIdx] == 0)
+		{
+			ELOG("Error : TriangleBvh::Build() Failed. instanceIdx = %u", instanceIdx);
+			Term();
+			return false;
+		}
+	}
+
+	m_InstanceBounds.resize(instanceCount);
+	for (uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++)
+	{
+		UpdateInstanceBounds(instanceIdx);
+	}
+
+	// TLASはインスタンス数が少ないので1スレッドで構築する。
+	// 葉ごとに光線をオブジェクト空間に変換し直すので、葉には1インスタンスずつ入れる
+	BvhBuildSettings tlasSettings = settings;
+	tlasSettings.MaxLeafSize = 1;
+	tlasSettings.Multithreaded = false;
+	tlasSettings.Refittable = true;
+	if (!m_Tlas.Build(instanceCount, m_InstanceBounds.data(), tlasSettings))
+	{
+		ELOG("Error : Bvh::Build() Failed.");
+		Term();
+		return false;
+	}
+
+	return true;
+}
+
+void SceneBvh::Term()
+{
+	m_Blases.clear();
+	m_Blases.shrink_to_fit();
+	m_Instances.clear();
+	m_Instances.shrink_to_fit();
+	m_InstanceBounds.clear();
+	m_InstanceBounds.shrink_to_fit();
+	m_Tlas.Term();
+	m_DirtyInstances.clear();
+	m_TriangleCount = 0;
+	m_LastRefitInstanceCount = 0;
+	m_LastRefitMilliseconds = 0.0;
+}
+
+const Matrix& SceneBvh::GetWorldMatrix(uint32_t instanceIdx) const
+{
+	assert(instanceIdx < m_Instances.size());
+	return m_Instances[instanceIdx].World;
+}
+
+const TriangleBvh& SceneBvh::GetBlas(uint32_t instanceIdx) const
+{
+	assert(instanceIdx < m_Blases.size());
+	return m_Blases[instanceIdx];
+}
+
+size_t SceneBvh::GetMemorySize() const
+{
+	size_t size = m_Tlas.GetMemorySize() + m_Instances.size() * sizeof(Instance) + m_InstanceBounds.size() * sizeof(BvhPrimitiveBounds);
+	for (const TriangleBvh& blas : m_Blases)
+	{
+		size += blas.GetMemorySize();
+	}
+	return size;
+}
+
+void SceneBvh::SetWorldMatrix(uint32_t instanceIdx, const Matrix& world)
+{
+	assert(instanceIdx < m_Instances.size());
+	Instance& instance = m_Instances[instanceIdx];
+	instance.World = world;
+	instance.InvWorld = world.Invert();
+
+	if (!instance.IsDirty)
+	{
+		instance.IsDirty = true;
+		m_DirtyInstances.push_back(instanceIdx);
+	}
+}
+
+bool SceneBvh::Refit()
+{
+	const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+
+	for (uint32_t instanceIdx : m_DirtyInstances)
+	{
+		UpdateInstanceBounds(instanceIdx);
+		m_Instances[instanceIdx].IsDirty = false;
+	}
+
+	bool result = m_Tlas.Refit(m_DirtyInstances.data(), static_cast<uint32_t>(m_DirtyInstances.size()), m_InstanceBounds.data());
+	m_LastRefitInstanceCount = static_cast<uint32_t>(m_DirtyInstances.size());
+	m_DirtyInstances.clear();
+
+	const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+	m_LastRefitMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+	if (!result)
+	{
+		ELOG("Error : Bvh::Refit() Failed.");
+		return false;
+	}
+
+	return true;
+}
+
+bool SceneBvh::Intersect(const Vector3& origin, const Vector3& direction, float tMax, TriangleHit& hit) const
+{
+	bool isHit = false;
+	const std::vector<uint32_t>& primIndices = m_Tlas.GetPrimIndices();
+	m_Tlas.Traverse(origin, direction, tMax, [&](const BvhNode& leaf)
+	{
+		for (uint32_t i = leaf.LeftOrFirst; i < leaf.LeftOrFirst + leaf.PrimCount; i++)
+		{
+			uint32_t instanceIdx = primIndices[i];
+			const Instance& instance = m_Instances[instanceIdx];
+
+			// 方向は正規化しないので、オブジェクト空間でもtはワールド空間と同じになる
+			const Vector3& localOrigin = Vector3::Transform(origin, instance.InvWorld);
+			const Vector3& localDirection = Vector3::TransformNormal(direction, instance.InvWorld);
+			TriangleHit localHit;
+			if (m_Blases[instanceIdx].Intersect(localOrigin, localDirection, tMax, localHit))
+			{
+				tMax = localHit.T;
+				hit = localHit;
+				hit.TriangleIdx += instance.FirstTriangleIdx;
+				isHit = true;
+			}
+		}
+		return false;
+	});
+
+	return isHit;
+}
+
+bool SceneBvh::IsOccluded(const Vector3& origin, const Vector3& direction, float tMax) const
+{
+	bool isHit = false;
+	const std::vector<uint32_t>& primIndices = m_Tlas.GetPrimIndices();
+	m_Tlas.Traverse(origin, direction, tMax, [&](const BvhNode& leaf)
+	{
+		for (uint32_t i = leaf.LeftOrFirst; i < leaf.LeftOrFirst + leaf.PrimCount; i++)
+		{
+			uint32_t instanceIdx = primIndices[i];
+			const Instance& instance = m_Instances[instanceIdx];
+
+			const Vector3& localOrigin = Vector3::Transform(origin, instance.InvWorld);
+			const Vector3& localDirection = Vector3::TransformNormal(direction, instance.InvWorld);
+			if (m_Blases[instanceIdx].IsOccluded(localOrigin, localDirection, tMax))
+			{
+				isHit = true;
+				return true;
+			}
+		}
+		return false;
+	});
+
+	return isHit;
+}
+
+void SceneBvh::UpdateInstanceBounds(uint32_t instanceIdx)
+{
+	const BvhNode& root = m_Blases[instanceIdx].GetBvh().GetNodes()[0];
+	const Matrix& world = m_Instances[instanceIdx].World;
+
+	// 中心は行列で変換し、半径は行列の各成分の絶対値で変換する
+	Matrix absWorld = world;
+	for (uint32_t row = 0; row < 3; row++)
+	{
+		for (uint32_t column = 0; column < 3; column++)
+		{
+			absWorld.m[row][column] = fabsf(world.m[row][column]);
+		}
+	}
+
+	const Vector3& center = Vector3::Transform((root.BoundsMin + root.BoundsMax) * 0.5f, world);
+	const Vector3& halfExtent = Vector3::TransformNormal((root.BoundsMax - root.BoundsMin) * 0.5f, absWorld);
+	m_InstanceBounds[instanceIdx].Min = center - halfExtent;
+	m_InstanceBounds[instanceIdx].Max = center + halfExtent;
+}
@@ -0,0 +1,450 @@
+﻿#include "ShaderCache.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <unordered_set>
+
+namespace
+{
+	static constexpr uint32_t CACHE_FILE_MAGIC = 0x43444853; // 'SHDC'
+	// ファイルの形式を変えたら上げる
+	static constexpr uint32_t CACHE_FILE_FORMAT_VERSION = 1;
+	// キーの2つのハッシュのシード
+	static constexpr uint64_t KEY_SEEDS[2] = {0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full};
+
+	struct CacheFileHeader
+	{
+		uint32_t Magic;
+		uint32_t FormatVersion;
+		uint64_t Key[2];
+		uint64_t DataSize;
+		double CompileMilliseconds;
+	};
+
+	// MurmurHash64A
+	uint64_t HashBytes(const void* pData, size_t size, uint64_t seed)
+	{
+		static constexpr uint64_t M = 0xc6a4a7935bd1e995ull;
+		static constexpr int R = 47;
+
+		const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+		uint64_t h = seed ^ (size * M);
+
+		size_t blockCount = size / 8;
+		for (size_t i = 0; i < blockCount; i++)
+		{
+			uint64_t k;
+			memcpy(&k, pBytes + i * 8, sizeof(k));
+
+			k *= M;
+			k ^= k >> R;
+			k *= M;
+
+			h ^= k;
+			h *= M;
+		}
+
+		const uint8_t* pTail = pBytes + blockCount * 8;
+		switch (size & 7)
+		{
+			case 7: h ^= uint64_t(pTail[6]) << 48; [[fallthrough]];
+			case 6: h ^= uint64_t(pTail[5]) << 40; [[fallthrough]];
+			case 5: h ^= uint64_t(pTail[4]) << 32; [[fallthrough]];
+			case 4: h ^= uint64_t(pTail[3]) << 24; [[fallthrough]];
+			case 3: h ^= uint64_t(pTail[2]) << 16; [[fallthrough]];
+			case 2: h ^= uint64_t(pTail[1]) << 8; [[fallthrough]];
+			case 1: h ^= uint64_t(pTail[0]);
+				h *= M;
+				break;
+			default:
+				break;
+		}
+
+		h ^= h >> R;
+		h *= M;
+		h ^= h >> R;
+
+		return h;
+	}
+
+	bool ReadFileBytes(const std::filesystem::path& path, std::vector<uint8_t>& data)
+	{
+		std::ifstream stream(path, std::ios::binary | std::ios::ate);
+		if (!stream)
+		{
+			return false;
+		}
+
+		std::streamoff size = stream.tellg();
+		if (size < 0)
+		{
+			return false;
+		}
+
+		data.resize(static_cast<size_t>(size));
+		stream.seekg(0, std::ios::beg);
+		return size == 0 || static_cast<bool>(stream.read(reinterpret_cast<char*>(data.data()), size));
+	}
+
+	// -Iとdirを別の引数にしたもの、-Idir、1つの引数にした"-I dir"のいずれも受け付ける
+	std::vector<std::filesystem::path> GetIncludeDirectories(const std::vector<const wchar_t*>& args)
+	{
+		std::vector<std::filesystem::path> directories;
+		for (size_t i = 0; i < args.size(); i++)
+		{
+			const wchar_t* arg = args[i];
+			if (arg == nullptr || wcsncmp(arg, L"-I", 2) != 0)
+			{
+				continue;
+			}
+
+			const wchar_t* directory = arg + 2;
+			while (*directory == L' ')
+			{
+				directory++;
+			}
+
+			if (*directory == L'\0')
+			{
+				if (i + 1 >= args.size() || args[i + 1] == nullptr)
+				{
+					continue;
+				}
+				directory = args[++i];
+			}
+
+			directories.emplace_back(directory);
+		}
+
+		return directories;
+	}
+
+	// 行頭の#includeの""か<>で囲まれた名前を順に取り出す
+	std::vector<std::string> ScanIncludes(const std::vector<uint8_t>& source)
+	{
+		std::vector<std::string> names;
+
+		size_t pos = 0;
+		const size_t size = source.size();
+		while (pos < size)
+		{
+			size_t lineEnd = pos;
+			while (lineEnd < size && source[lineEnd] != '\n')
+			{
+				lineEnd++;
+			}
+
+			size_t i = pos;
+			while (i < lineEnd && (source[i] == ' ' || source[i] == '\t'))
+			{
+				i++;
+			}
+
+			if (i < lineEnd && source[i] == '#')
+			{
+				i++;
+				while (i < lineEnd && (source[i] == ' ' || source[i] == '\t'))
+				{
+					i++;
+				}
+
+				static constexpr char INCLUDE[] = "include";
+				static constexpr size_t INCLUDE_LENGTH = sizeof(INCLUDE) - 1;
+				if (lineEnd - i > INCLUDE_LENGTH && memcmp(&source[i], INCLUDE, INCLUDE_LENGTH) == 0)
+				{
+					i += INCLUDE_LENGTH;
+					while (i < lineEnd && (source[i] == ' ' || source[i] == '\t'))
+					{
+						i++;
+					}
+
+					if (i < lineEnd && (source[i] == '"' || source[i] == '<'))
+					{
+						char close = (source[i] == '"') ? '"' : '>';
+						size_t nameBegin = i + 1;
+						size_t nameEnd = nameBegin;
+						while (nameEnd < lineEnd && source[nameEnd] != close)
+						{
+							nameEnd++;
+						}
+
+						if (nameEnd < lineEnd && nameEnd > nameBegin)
+						{
+							names.emplace_back(reinterpret_cast<const char*>(&source[nameBegin]), nameEnd - nameBegin);
+						}
+					}
+				}
+			}
+
+			pos = lineEnd + 1;
+		}
+
+		return names;
+	}
+
+	void AppendBytes(std::vector<uint8_t>& material, const void* pData, size_t size)
+	{
+		const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+		uint64_t size64 = size;
+		material.insert(material.end(), reinterpret_cast<const uint8_t*>(&size64), reinterpret_cast<const uint8_t*>(&size64) + sizeof(size64));
+		material.insert(material.end(), pBytes, pBytes + size);
+	}
+}
+
+ShaderCache::ShaderCache()
+{
+}
+
+ShaderCache::~ShaderCache()
+{
+	Term();
+}
+
+bool ShaderCache::Init(const wchar_t* directory)
+{
+	if (directory == nullptr || directory[0] == L'\0')
+	{
+		ELOG("Error : Invalid Arguments.");
+		return false;
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(directory, ec);
+	if (ec || !std::filesystem::is_directory(directory, ec))
+	{
+		ELOG("Error : Failed to Create Shader Cache Directory. path = %ls", directory);
+		return false;
+	}
+
+	m_Directory = directory;
+
+	std::lock_guard<std::mutex> lock(m_StatsMutex);
+	m_Stats = ShaderCacheStats();
+
+	return true;
+}
+
+void ShaderCache::Term()
+{
+	m_Directory.clear();
+}
+
+bool ShaderCache::ComputeKey(const wchar_t* filePath, const std::vector<const wchar_t*>& args, const char* compilerVersion, ShaderCacheKey& key, std::vector<std::wstring>* pSourceFiles)
+{
+	if (filePath == nullptr || compilerVersion == nullptr)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return false;
+	}
+
+	// キーに入れるものを全て並べてからハッシュする。中身の前に長さを入れるので、区切りの位置が違うものは別のキーになる
+	std::vector<uint8_t> material;
+	AppendBytes(material, &CACHE_FILE_FORMAT_VERSION, sizeof(CACHE_FILE_FORMAT_VERSION));
+	AppendBytes(material, compilerVersion, strlen(compilerVersion));
+	for (const wchar_t* arg : args)
+	{
+		if (arg != nullptr)
+		{
+			AppendBytes(material, arg, wcslen(arg) * sizeof(wchar_t));
+		}
+	}
+
+	const std::filesystem::path& mainPath = std::filesystem::path(filePath);
+	std::vector<uint8_t> source;
+	if (!ReadFileBytes(mainPath, source))
+	{
+		ELOG("Error : Failed to Read Shader. path = %ls", filePath);
+		return false;
+	}
+	AppendBytes(material, source.data(), source.size());
+
+	const std::vector<std::filesystem::path>& includeDirectories = GetIncludeDirectories(args);
+
+	// 同じファイルは最初に辿ったときだけ中身を入れる。#pragma onceやインクルードガードのあるものの循環もここで止まる
+	std::unordered_set<std::wstring> visitedPaths;
+	std::error_code ec;
+	const std::wstring& normalizedMainPath = std::filesystem::absolute(mainPath, ec).lexically_normal().wstring();
+	visitedPaths.insert(normalizedMainPath);
+	if (pSourceFiles != nullptr)
+	{
+		pSourceFiles->clear();
+		pSourceFiles->push_back(normalizedMainPath);
+	}
+
+	std::function<void(const std::filesystem::path&, const std::vector<uint8_t>&)> appendIncludes =
+		[&](const std::filesystem::path& includerPath, const std::vector<uint8_t>& includerSource)
+	{
+		for (const std::string& name : ScanIncludes(includerSource))
+		{
+			AppendBytes(material, name.data(), name.size());
+
+			std::filesystem::path resolvedPath;
+			const std::filesystem::path& includerDirectory = includerPath.parent_path();
+			if (std::filesystem::is_regular_file(includerDirectory / name, ec))
+			{
+				resolvedPath = includerDirectory / name;
+			}
+			else
+			{
+				for (const std::filesystem::path& directory : includeDirectories)
+				{
+					if (std::filesystem::is_regular_file(directory / name, ec))
+					{
+						resolvedPath = directory / name;
+						break;
+					}
+				}
+			}
+
+			std::vector<uint8_t> includeSource;
+			if (resolvedPath.empty() || !ReadFileBytes(resolvedPath, includeSource))
+			{
+				static constexpr char MISSING[] = "<missing>";
+				AppendBytes(material, MISSING, sizeof(MISSING) - 1);
+				continue;
+			}
+
+			const std::wstring& normalizedPath = std::filesystem::absolute(resolvedPath, ec).lexically_normal().wstring();
+			if (!visitedPaths.insert(normalizedPath).second)
+			{
+				continue;
+			}
+			if (pSourceFiles != nullptr)
+			{
+				pSourceFiles->push_back(normalizedPath);
+			}
+
+			AppendBytes(material, includeSource.data(), includeSource.size());
+			appendIncludes(resolvedPath, includeSource);
+		}
+	};
+	appendIncludes(mainPath, source);
+
+	key.Hash[0] = HashBytes(material.data(), material.size(), KEY_SEEDS[0]);
+	key.Hash[1] = HashBytes(material.data(), material.size(), KEY_SEEDS[1]);
+
+	return true;
+}
+
+bool ShaderCache::Load(const ShaderCacheKey& key, std::vector<uint8_t>& data)
+{
+	if (!IsEnabled())
+	{
+		return false;
+	}
+
+	const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+
+	bool isHit = false;
+	CacheFileHeader header = {};
+	{
+		std::ifstream stream(std::filesystem::path(GetFilePath(key)), std::ios::binary);
+		if (stream && stream.read(reinterpret_cast<char*>(&header), sizeof(header))
+			&& header.Magic == CACHE_FILE_MAGIC
+			&& header.FormatVersion == CACHE_FILE_FORMAT_VERSION
+			&& header.Key[0] == key.Hash[0]
+			&& header.Key[1] == key.Hash[1])
+		{
+			data.resize(static_cast<size_t>(header.DataSize));
+			isHit = header.DataSize > 0 && static_cast<bool>(stream.read(reinterpret_cast<char*>(data.data()), header.DataSize))
+				&& stream.peek() == std::ifstream::traits_type::eof();
+		}
+	}
+
+	const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+	double msec = std::chrono::duration<double, std::milli>(end - start).count();
+
+	std::lock_guard<std::mutex> lock(m_StatsMutex);
+	m_Stats.LoadMilliseconds += msec;
+	if (isHit)
+	{
+		m_Stats.HitCount++;
+		m_Stats.SavedMilliseconds += std::max(0.0, header.CompileMilliseconds - msec);
+	}
+	else
+	{
+		m_Stats.MissCount++;
+		data.clear();
+	}
+
+	return isHit;
+}
+
+bool ShaderCache::Store(const ShaderCacheKey& key, const void* pData, size_t size, double compileMilliseconds)
+{
+	if (!IsEnabled())
+	{
+		return false;
+	}
+
+	if (pData == nullptr || size == 0)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return false;
+	}
+
+	CacheFileHeader header = {};
+	header.Magic = CACHE_FILE_MAGIC;
+	header.FormatVersion = CACHE_FILE_FORMAT_VERSION;
+	header.Key[0] = key.Hash[0];
+	header.Key[1] = key.Hash[1];
+	header.DataSize = size;
+	header.CompileMilliseconds = compileMilliseconds;
+
+	// 書きかけのファイルを他のスレッドや次の起動で読まないように、別名で書いてから置き換える
+	const std::wstring& filePath = GetFilePath(key);
+	const std::wstring& tempPath = filePath + L"." + std::to_wstring(std::hash<std::thread::id>()(std::this_thread::get_id())) + L".tmp";
+
+	bool isWritten = false;
+	{
+		std::ofstream stream(std::filesystem::path(tempPath), std::ios::binary | std::ios::trunc);
+		isWritten = stream
+			&& stream.write(reinterpret_cast<const char*>(&header), sizeof(header))
+			&& stream.write(static_cast<const char*>(pData), size);
+	}
+
+	std::error_code ec;
+	if (isWritten)
+	{
+		std::filesystem::rename(tempPath, filePath, ec);
+	}
+
+	if (!isWritten || ec)
+	{
+		std::filesystem::remove(tempPath, ec);
+
+		std::lock_guard<std::mutex> lock(m_StatsMutex);
+		m_Stats.StoreFailureCount++;
+		return false;
+	}
+
+	return true;
+}
+
+ShaderCacheStats ShaderCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_StatsMutex);
+	return m_Stats;
+}
+
+std::wstring ShaderCache::GetFilePath(const ShaderCacheKey& key) const
+{
+	static constexpr wchar_t HEX[] = L"0123456789abcdef";
+
+	std::wstring name;
+	name.reserve(32);
+	for (uint64_t hash : key.Hash)
+	{
+		for (int shift = 60; shift >= 0; shift -= 4)
+		{
+			name.push_back(HEX[(hash >> shift) & 0xf]);
+		}
+	}
+
+	return (std::filesystem::path(m_Directory) / (name + L".dxil")).wstring();
+}
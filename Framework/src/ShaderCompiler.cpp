@@ -1,31 +1,133 @@
-#include "ShaderCompiler.h"
+﻿#include "ShaderCompiler.h"
 #include "Logger.h"
+#include <chrono>
+#include <filesystem>
+
+namespace
+{
+	// 既定のインクルードハンドラに読み込みを任せ、読み込んだファイルのパスを記録する。
+	// Compile()の中でだけ使うスタック上のオブジェクトなので、参照カウントは数えない
+	class RecordingIncludeHandler : public IDxcIncludeHandler
+	{
+	public:
+		RecordingIncludeHandler(IDxcIncludeHandler* pDefaultHandler, std::vector<std::wstring>* pFiles)
+		: m_pDefaultHandler(pDefaultHandler)
+		, m_pFiles(pFiles)
+		{
+		}
+
+		HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR pFilename, IDxcBlob** ppIncludeSource) override
+		{
+			HRESULT hr = m_pDefaultHandler->LoadSource(pFilename, ppIncludeSource);
+			if (SUCCEEDED(hr) && m_pFiles != nullptr)
+			{
+				std::error_code ec;
+				m_pFiles->push_back(std::filesystem::absolute(pFilename, ec).lexically_normal().wstring());
+			}
+			return hr;
+		}
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+		{
+			if (ppvObject == nullptr)
+			{
+				return E_POINTER;
+			}
+
+			if (riid == __uuidof(IDxcIncludeHandler) || riid == __uuidof(IUnknown))
+			{
+				*ppvObject = static_cast<IDxcIncludeHandler*>(this);
+				return S_OK;
+			}
+
+			*ppvObject = nullptr;
+			return E_NOINTERFACE;
+		}
+
+		ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+		ULONG STDMETHODCALLTYPE Release() override { return 1; }
+
+	private:
+		IDxcIncludeHandler* m_pDefaultHandler;
+		std::vector<std::wstring>* m_pFiles;
+	};
+}
 
 ShaderCompiler::~ShaderCompiler()
 {
 	Term();
 }
 
-bool ShaderCompiler::Init()
+bool ShaderCompiler::Init(const wchar_t* cacheDirectory, uint32_t workerCount)
 {
-	HRESULT hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(m_pUtils.GetAddressOf()));
-	if (FAILED(hr))
+	if (workerCount == 0)
 	{
-		ELOG("Error : DxcCreateInstance() Failed.");
+		ELOG("Error : Invalid Arguments.");
 		return false;
 	}
 
-	hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(m_pCompiler.GetAddressOf()));
+	m_Workers.resize(workerCount);
+	for (Worker& worker : m_Workers)
+	{
+		HRESULT hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(worker.pUtils.GetAddressOf()));
+		if (FAILED(hr))
+		{
+			ELOG("Error : DxcCreateInstance() Failed.");
+			return false;
+		}
+
+		hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(worker.pCompiler.GetAddressOf()));
+		if (FAILED(hr))
+		{
+			ELOG("Error : DxcCreateInstance() Failed.");
+			return false;
+		}
+
+		hr = worker.pUtils->CreateDefaultIncludeHandler(worker.pIncludeHandler.GetAddressOf());
+		if (FAILED(hr))
+		{
+			ELOG("Error : IDxcUtils::CreateDefaultIncludeHandler() Failed.");
+			return false;
+		}
+	}
+
+	const ComPtr<IDxcCompiler3>& pCompiler = m_Workers[0].pCompiler;
+
+	UINT32 major = 0;
+	UINT32 minor = 0;
+	ComPtr<IDxcVersionInfo> pVersionInfo;
+	HRESULT hr = pCompiler.As(&pVersionInfo);
+	if (SUCCEEDED(hr))
+	{
+		hr = pVersionInfo->GetVersion(&major, &minor);
+	}
 	if (FAILED(hr))
 	{
-		ELOG("Error : DxcCreateInstance() Failed.");
+		ELOG("Error : IDxcVersionInfo::GetVersion() Failed.");
 		return false;
 	}
+	m_CompilerVersion = std::to_string(major) + "." + std::to_string(minor);
 
-	hr = m_pUtils->CreateDefaultIncludeHandler(m_pIncludeHandler.GetAddressOf());
-	if (FAILED(hr))
+	// 同じバージョン番号の開発中のビルドを区別するため、取れればコミットも入れる
+	ComPtr<IDxcVersionInfo2> pVersionInfo2;
+	if (SUCCEEDED(pCompiler.As(&pVersionInfo2)))
 	{
-		ELOG("Error : IDxcUtils::CreateDefaultIncludeHandler() Failed.");
+		UINT32 commitCount = 0;
+		char* commitHash = nullptr;
+		if (SUCCEEDED(pVersionInfo2->GetCommitInfo(&commitCount, &commitHash)))
+		{
+			m_CompilerVersion += "." + std::to_string(commitCount);
+			if (commitHash != nullptr)
+			{
+				m_CompilerVersion += std::string("-") + commitHash;
+			}
+		}
+		CoTaskMemFree(commitHash);
+	}
+
+	if (cacheDirectory != nullptr && !m_Cache.Init(cacheDirectory))
+	{
+		ELOG("Error : ShaderCache::Init() Failed.");
 		return false;
 	}
 
@@ -34,14 +136,50 @@ bool ShaderCompiler::Init()
 
 void ShaderCompiler::Term()
 {
-	m_pUtils.Reset();
-	m_pCompiler.Reset();
+	m_Cache.Term();
+	m_Workers.clear();
 }
 
-bool ShaderCompiler::Compile(const wchar_t* filePath, std::vector<const wchar_t*>& args, ComPtr<IDxcBlob>& outBlob)
+bool ShaderCompiler::Compile(uint32_t workerIndex, const wchar_t* filePath, std::vector<const wchar_t*>& args, ComPtr<IDxcBlob>& outBlob, std::vector<std::wstring>* pSourceFiles)
 {
+	if (workerIndex >= m_Workers.size())
+	{
+		ELOG("Error : Invalid Worker Index. workerIndex = %u", workerIndex);
+		return false;
+	}
+	const Worker& worker = m_Workers[workerIndex];
+
+	ShaderCacheKey key;
+	bool isCacheable = m_Cache.IsEnabled() && ShaderCache::ComputeKey(filePath, args, m_CompilerVersion.c_str(), key, pSourceFiles);
+	if (isCacheable)
+	{
+		std::vector<uint8_t> data;
+		if (m_Cache.Load(key, data))
+		{
+			ComPtr<IDxcBlobEncoding> pCachedBlob;
+			HRESULT hr = worker.pUtils->CreateBlob(data.data(), static_cast<UINT32>(data.size()), DXC_CP_ACP, pCachedBlob.GetAddressOf());
+			if (SUCCEEDED(hr))
+			{
+				outBlob = pCachedBlob;
+				return true;
+			}
+			ELOG("Error : IDxcUtils::CreateBlob() Failed.");
+		}
+	}
+
+	// キャッシュのキーを作ったときはpSourceFilesが埋まっている。作らなかったときはコンパイラが読んだファイルを記録する
+	if (pSourceFiles != nullptr && !isCacheable)
+	{
+		std::error_code ec;
+		pSourceFiles->clear();
+		pSourceFiles->push_back(std::filesystem::absolute(filePath, ec).lexically_normal().wstring());
+	}
+	RecordingIncludeHandler includeHandler(worker.pIncludeHandler.Get(), isCacheable ? nullptr : pSourceFiles);
+
+	const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+
 	ComPtr<IDxcBlobEncoding> pSourceBlob;
-	HRESULT hr = m_pUtils->LoadFile(
+	HRESULT hr = worker.pUtils->LoadFile(
 		filePath,
 		nullptr,
 		pSourceBlob.GetAddressOf()
@@ -58,11 +196,11 @@ bool ShaderCompiler::Compile(const wchar_t* filePath, std::vector<const wchar_t*
 	sourceBuffer.Encoding = DXC_CP_UTF8;
 	
 	ComPtr<IDxcResult> pResult;
-	hr = m_pCompiler->Compile(
+	hr = worker.pCompiler->Compile(
 		&sourceBuffer,
 		args.data(),
 		static_cast<UINT32>(args.size()),
-		m_pIncludeHandler.Get(),
+		&includeHandler,
 		IID_PPV_ARGS(pResult.GetAddressOf())
 	);
 	if (FAILED(hr))
@@ -106,11 +244,20 @@ bool ShaderCompiler::Compile(const wchar_t* filePath, std::vector<const wchar_t*
 		IID_PPV_ARGS(outBlob.GetAddressOf()),
 		nullptr
 	);
-	if (FAILED(status))
+	if (FAILED(hr) || outBlob == nullptr)
 	{
 		ELOG("Error : IDxcResult::GetOutput() Failed.");
 		return false;
 	}
 
+	if (isCacheable)
+	{
+		const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+		double msec = std::chrono::duration<double, std::milli>(end - start).count();
+
+		// 書き込めなくても次の起動でコンパイルし直すだけなので、結果はそのまま使う
+		m_Cache.Store(key, outBlob->GetBufferPointer(), outBlob->GetBufferSize(), msec);
+	}
+
 	return true;
 }
@@ -0,0 +1,112 @@
+﻿#include "ShaderDependencyGraph.h"
+#include <algorithm>
+#include <cwctype>
+#include <filesystem>
+
+ShaderDependencyGraph::ShaderDependencyGraph()
+{
+}
+
+ShaderDependencyGraph::~ShaderDependencyGraph()
+{
+	Clear();
+}
+
+void ShaderDependencyGraph::Clear()
+{
+	m_Shaders.clear();
+	m_FileToShaders.clear();
+}
+
+uint32_t ShaderDependencyGraph::AddShader(const wchar_t* name)
+{
+	Shader shader;
+	shader.Name = name;
+	m_Shaders.emplace_back(std::move(shader));
+	return static_cast<uint32_t>(m_Shaders.size() - 1);
+}
+
+void ShaderDependencyGraph::SetDependencies(uint32_t shaderIdx, const std::vector<std::wstring>& files)
+{
+	if (shaderIdx >= m_Shaders.size())
+	{
+		return;
+	}
+	Shader& shader = m_Shaders[shaderIdx];
+
+	// 前の依存を逆引きから外す
+	for (const std::wstring& file : shader.Files)
+	{
+		std::unordered_map<std::wstring, std::vector<uint32_t>>::iterator itr = m_FileToShaders.find(file);
+		if (itr == m_FileToShaders.end())
+		{
+			continue;
+		}
+
+		std::vector<uint32_t>& shaderIndices = itr->second;
+		shaderIndices.erase(std::remove(shaderIndices.begin(), shaderIndices.end(), shaderIdx), shaderIndices.end());
+		if (shaderIndices.empty())
+		{
+			m_FileToShaders.erase(itr);
+		}
+	}
+
+	shader.Files.clear();
+	shader.Files.reserve(files.size());
+	for (const std::wstring& file : files)
+	{
+		shader.Files.push_back(NormalizePath(file));
+	}
+	std::sort(shader.Files.begin(), shader.Files.end());
+	shader.Files.erase(std::unique(shader.Files.begin(), shader.Files.end()), shader.Files.end());
+
+	for (const std::wstring& file : shader.Files)
+	{
+		m_FileToShaders[file].push_back(shaderIdx);
+	}
+}
+
+void ShaderDependencyGraph::CollectAffectedShaders(const std::vector<std::wstring>& changedFiles, std::vector<uint32_t>& shaderIndices) const
+{
+	shaderIndices.clear();
+	for (const std::wstring& file : changedFiles)
+	{
+		std::unordered_map<std::wstring, std::vector<uint32_t>>::const_iterator itr = m_FileToShaders.find(NormalizePath(file));
+		if (itr != m_FileToShaders.end())
+		{
+			shaderIndices.insert(shaderIndices.end(), itr->second.begin(), itr->second.end());
+		}
+	}
+	std::sort(shaderIndices.begin(), shaderIndices.end());
+	shaderIndices.erase(std::unique(shaderIndices.begin(), shaderIndices.end()), shaderIndices.end());
+}
+
+void ShaderDependencyGraph::CollectFiles(std::vector<std::wstring>& files) const
+{
+	files.clear();
+	files.reserve(m_FileToShaders.size());
+	for (const std::pair<const std::wstring, std::vector<uint32_t>>& entry : m_FileToShaders)
+	{
+		files.push_back(entry.first);
+	}
+	std::sort(files.begin(), files.end());
+}
+
+std::wstring ShaderDependencyGraph::NormalizePath(const std::wstring& path)
+{
+	std::error_code ec;
+	std::wstring result = std::filesystem::absolute(path, ec).lexically_normal().wstring();
+	if (ec)
+	{
+		result = std::filesystem::path(path).lexically_normal().wstring();
+	}
+
+#ifdef _WIN32
+	for (wchar_t& c : result)
+	{
+		c = static_cast<wchar_t>(std::towlower(c));
+	}
+#endif
+
+	return result;
+}
@@ -0,0 +1,175 @@
+﻿#include "ShaderHotReloader.h"
+#include "Logger.h"
+#include "ShaderCompiler.h"
+#include <algorithm>
+#include <chrono>
+
+ShaderHotReloader::ShaderHotReloader()
+: m_pCompiler(nullptr)
+, m_WorkerIndex(0)
+, m_PollIntervalMilliseconds(0)
+, m_IsTerminating(false)
+{
+}
+
+ShaderHotReloader::~ShaderHotReloader()
+{
+	Term();
+}
+
+bool ShaderHotReloader::Init(ShaderCompiler* pCompiler, uint32_t workerIndex, uint32_t pollIntervalMilliseconds)
+{
+	if (pCompiler == nullptr || workerIndex >= pCompiler->GetWorkerCount() || pollIntervalMilliseconds == 0)
+	{
+		ELOG("Error : Invalid Argument.");
+		return false;
+	}
+
+	m_pCompiler = pCompiler;
+	m_WorkerIndex = workerIndex;
+	m_PollIntervalMilliseconds = pollIntervalMilliseconds;
+	m_IsTerminating = false;
+	m_Thread = std::thread([this]() { Run(); });
+
+	return true;
+}
+
+void ShaderHotReloader::Term()
+{
+	if (m_Thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_IsTerminating = true;
+		}
+		m_TerminateCV.notify_all();
+		m_Thread.join();
+	}
+
+	m_pCompiler = nullptr;
+	m_Shaders.clear();
+	m_Graph.Clear();
+	m_Watcher.Clear();
+	m_ReloadedShaders.clear();
+}
+
+uint32_t ShaderHotReloader::AddShader(const wchar_t* filePath, const std::vector<const wchar_t*>& args, const std::vector<std::wstring>& sourceFiles)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	Shader shader;
+	shader.FilePath = filePath;
+	shader.Args.assign(args.begin(), args.end());
+	m_Shaders.emplace_back(std::move(shader));
+
+	uint32_t shaderIdx = m_Graph.AddShader(filePath);
+	m_Graph.SetDependencies(shaderIdx, sourceFiles);
+	for (const std::wstring& file : m_Graph.GetDependencies(shaderIdx))
+	{
+		m_Watcher.Watch(file);
+	}
+
+	return shaderIdx;
+}
+
+void ShaderHotReloader::TakeReloadedShaders(std::vector<ReloadedShader>& shaders)
+{
+	shaders.clear();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (std::vector<ReloadedShader>::reverse_iterator itr = m_ReloadedShaders.rbegin(); itr != m_ReloadedShaders.rend(); ++itr)
+	{
+		bool isTaken = std::any_of(shaders.begin(), shaders.end(), [&](const ReloadedShader& shader) { return shader.ShaderIdx == itr->ShaderIdx; });
+		if (!isTaken)
+		{
+			shaders.push_back(*itr);
+		}
+	}
+	m_ReloadedShaders.clear();
+}
+
+ShaderHotReloadStats ShaderHotReloader::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	ShaderHotReloadStats stats = m_Stats;
+	stats.ShaderCount = static_cast<uint32_t>(m_Shaders.size());
+	stats.FileCount = m_Watcher.GetFileCount();
+	return stats;
+}
+
+void ShaderHotReloader::Run()
+{
+	std::vector<std::wstring> changedFiles;
+	std::vector<uint32_t> affectedShaders;
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_TerminateCV.wait_for(lock, std::chrono::milliseconds(m_PollIntervalMilliseconds), [this]() { return m_IsTerminating; });
+		if (m_IsTerminating)
+		{
+			return;
+		}
+
+		m_Watcher.Poll(changedFiles);
+		if (changedFiles.empty())
+		{
+			continue;
+		}
+		m_Stats.ChangeCount += static_cast<uint32_t>(changedFiles.size());
+
+		m_Graph.CollectAffectedShaders(changedFiles, affectedShaders);
+		std::vector<Shader> shaders;
+		for (uint32_t shaderIdx : affectedShaders)
+		{
+			shaders.push_back(m_Shaders[shaderIdx]);
+		}
+
+		// コンパイルには時間がかかるので、その間はAddShader()やTakeReloadedShaders()を止めない
+		lock.unlock();
+
+		std::vector<ComPtr<IDxcBlob>> blobs(shaders.size());
+		std::vector<std::vector<std::wstring>> sourceFiles(shaders.size());
+		for (size_t i = 0; i < shaders.size(); i++)
+		{
+			std::vector<const wchar_t*> args;
+			for (const std::wstring& arg : shaders[i].Args)
+			{
+				args.push_back(arg.c_str());
+			}
+
+			ELOG("Recompile Shader. path = %ls", shaders[i].FilePath.c_str());
+			if (!m_pCompiler->Compile(m_WorkerIndex, shaders[i].FilePath.c_str(), args, blobs[i], &sourceFiles[i]))
+			{
+				ELOG("Error : ShaderCompiler::Compile() Failed. path = %ls", shaders[i].FilePath.c_str());
+				blobs[i].Reset();
+			}
+		}
+
+		lock.lock();
+
+		for (size_t i = 0; i < shaders.size(); i++)
+		{
+			m_Stats.RecompileCount++;
+			if (blobs[i] == nullptr)
+			{
+				// 前の依存のまま監視を続け、直したらもう一度コンパイルする
+				m_Stats.FailureCount++;
+				continue;
+			}
+
+			// #includeが増えたら、そのファイルも監視する。減ったものは監視し続けても逆引きで何も引かれない
+			uint32_t shaderIdx = affectedShaders[i];
+			m_Graph.SetDependencies(shaderIdx, sourceFiles[i]);
+			for (const std::wstring& file : m_Graph.GetDependencies(shaderIdx))
+			{
+				m_Watcher.Watch(file);
+			}
+
+			ReloadedShader reloaded;
+			reloaded.ShaderIdx = shaderIdx;
+			reloaded.pBlob = blobs[i];
+			m_ReloadedShaders.push_back(reloaded);
+		}
+	}
+}
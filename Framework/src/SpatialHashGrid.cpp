@@ -0,0 +1,244 @@
+﻿#include "SpatialHashGrid.h"
+#include "ParallelFor.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX::SimpleMath;
+
+namespace
+{
+	// 1回のParallelForのチャンクで処理する点の数
+	static constexpr uint32_t BUILD_GRAIN_SIZE = 16384;
+	// 1つのAABBを登録するセル数の上限。これを超えるAABBは警告を出す
+	static constexpr uint32_t MAX_CELLS_PER_AABB = 4096;
+	// これ以下のバケット数なら重複の除去をソートせずに行う
+	static constexpr uint32_t SMALL_BUCKET_COUNT = 32;
+
+	uint32_t RoundUpToPowerOfTwo(uint32_t value)
+	{
+		uint32_t result = 1;
+		while (result < value && result < (1u << 31))
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+
+	// bucketsのバケットごとの数をstartsに数え、排他的前置和にする。startsの要素数はバケット数 + 1
+	void CountingSortStarts(const uint32_t* pBuckets, uint32_t count, std::vector<uint32_t>& starts)
+	{
+		std::fill(starts.begin(), starts.end(), 0);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			starts[pBuckets[i] + 1]++;
+		}
+
+		for (size_t b = 1; b < starts.size(); b++)
+		{
+			starts[b] += starts[b - 1];
+		}
+	}
+}
+
+void SpatialHash::Init(float cellSize, uint32_t tableSize)
+{
+	m_CellSize = cellSize;
+	m_InvCellSize = 1.0f / cellSize;
+	m_TableMask = RoundUpToPowerOfTwo(std::max(tableSize, 1u)) - 1;
+}
+
+uint32_t SpatialHash::GatherBuckets(const Vector3& minPos, const Vector3& maxPos, uint32_t maxBuckets, uint32_t* pBuckets) const
+{
+	int32_t minX = GetCellCoord(minPos.x);
+	int32_t minY = GetCellCoord(minPos.y);
+	int32_t minZ = GetCellCoord(minPos.z);
+	int32_t maxX = GetCellCoord(maxPos.x);
+	int32_t maxY = GetCellCoord(maxPos.y);
+	int32_t maxZ = GetCellCoord(maxPos.z);
+
+	uint64_t cellCount = static_cast<uint64_t>(maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+	if (cellCount > maxBuckets)
+	{
+		return maxBuckets + 1;
+	}
+
+	uint32_t count = 0;
+	for (int32_t z = minZ; z <= maxZ; z++)
+	{
+		for (int32_t y = minY; y <= maxY; y++)
+		{
+			for (int32_t x = minX; x <= maxX; x++)
+			{
+				pBuckets[count++] = GetBucket(x, y, z);
+			}
+		}
+	}
+
+	// 別のセルが同じバケットに入っていると同じ点を2回返してしまうので取り除く。
+	// 半径の問い合わせでは高々27個なのでソートより総当たりの方が速い
+	if (count > SMALL_BUCKET_COUNT)
+	{
+		std::sort(pBuckets, pBuckets + count);
+		return static_cast<uint32_t>(std::unique(pBuckets, pBuckets + count) - pBuckets);
+	}
+
+	uint32_t uniqueCount = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		bool isDuplicate = false;
+		for (uint32_t j = 0; j < uniqueCount; j++)
+		{
+			isDuplicate |= (pBuckets[j] == pBuckets[i]);
+		}
+
+		if (!isDuplicate)
+		{
+			pBuckets[uniqueCount++] = pBuckets[i];
+		}
+	}
+	return uniqueCount;
+}
+
+void SpatialHashGrid::Init(float cellSize, uint32_t tableSize)
+{
+	Term();
+
+	m_Hash.Init(cellSize, tableSize);
+	m_BucketStarts.assign(m_Hash.GetTableSize() + 1, 0);
+}
+
+void SpatialHashGrid::Term()
+{
+	m_BucketStarts.clear();
+	m_SortedIndices.clear();
+	m_SortedX.clear();
+	m_SortedY.clear();
+	m_SortedZ.clear();
+	m_PointBuckets.clear();
+}
+
+void SpatialHashGrid::Build(uint32_t count, const float* pPositionX, const float* pPositionY, const float* pPositionZ)
+{
+	assert(!m_BucketStarts.empty());
+
+	m_PointBuckets.resize(count);
+	m_SortedIndices.resize(count);
+	m_SortedX.resize(count);
+	m_SortedY.resize(count);
+	m_SortedZ.resize(count);
+
+	ParallelFor(count, BUILD_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			m_PointBuckets[i] = m_Hash.GetBucket(pPositionX[i], pPositionY[i], pPositionZ[i]);
+		}
+	});
+
+	// 計数ソート。バケット内の順番が毎回同じになるよう、散らす処理は逐次で行う
+	CountingSortStarts(m_PointBuckets.data(), count, m_BucketStarts);
+
+	// 後ろから詰めると終端が先頭まで戻って範囲が壊れないので、終端を作業用に使い回す
+	std::vector<uint32_t>& cursors = m_BucketStarts;
+	for (uint32_t b = 0; b + 1 < cursors.size(); b++)
+	{
+		cursors[b] = cursors[b + 1];
+	}
+	for (uint32_t i = count; i-- > 0;)
+	{
+		m_SortedIndices[--cursors[m_PointBuckets[i]]] = i;
+	}
+
+	// 問い合わせでキャッシュに乗るよう座標もバケット順に並べる
+	ParallelFor(count, BUILD_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t idx = m_SortedIndices[i];
+			m_SortedX[i] = pPositionX[idx];
+			m_SortedY[i] = pPositionY[idx];
+			m_SortedZ[i] = pPositionZ[idx];
+		}
+	});
+}
+
+size_t SpatialHashGrid::GetMemorySize() const
+{
+	return (m_BucketStarts.size() + m_SortedIndices.size() + m_PointBuckets.size()) * sizeof(uint32_t)
+		+ (m_SortedX.size() + m_SortedY.size() + m_SortedZ.size()) * sizeof(float);
+}
+
+bool AABBHashGrid::Build(const std::vector<AABB>& aabbs, float cellSize, uint32_t tableSize, float margin)
+{
+	Term();
+
+	if (cellSize <= 0.0f)
+	{
+		ELOG("Error : cellSize must be positive.");
+		return false;
+	}
+
+	m_Hash.Init(cellSize, tableSize);
+	m_Margin = margin;
+	m_AABBs = aabbs;
+
+	// (バケット, AABB)の組を作ってからバケットで計数ソートする
+	std::vector<uint32_t> entryBuckets;
+	std::vector<uint32_t> entryAABBs;
+	std::vector<uint32_t> buckets(MAX_CELLS_PER_AABB);
+	uint32_t oversizedCount = 0;
+
+	Vector3 extent(margin, margin, margin);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(aabbs.size()); i++)
+	{
+		const AABB& aabb = aabbs[i];
+		Vector3 minPos = aabb.Center - aabb.HalfExtent - extent;
+		Vector3 maxPos = aabb.Center + aabb.HalfExtent + extent;
+
+		uint32_t bucketCount = m_Hash.GatherBuckets(minPos, maxPos, MAX_CELLS_PER_AABB, buckets.data());
+		if (bucketCount > MAX_CELLS_PER_AABB)
+		{
+			oversizedCount++;
+			do
+			{
+				buckets.resize(buckets.size() * 2);
+				bucketCount = m_Hash.GatherBuckets(minPos, maxPos, static_cast<uint32_t>(buckets.size()), buckets.data());
+			} while (bucketCount > buckets.size());
+		}
+
+		entryBuckets.insert(entryBuckets.end(), buckets.begin(), buckets.begin() + bucketCount);
+		entryAABBs.insert(entryAABBs.end(), bucketCount, i);
+	}
+
+	if (oversizedCount > 0)
+	{
+		ELOG("Warning : %u AABBs cover more than %u cells. Consider a larger cell size.", oversizedCount, MAX_CELLS_PER_AABB);
+	}
+
+	uint32_t entryCount = static_cast<uint32_t>(entryBuckets.size());
+	m_BucketStarts.resize(m_Hash.GetTableSize() + 1);
+	CountingSortStarts(entryBuckets.data(), entryCount, m_BucketStarts);
+
+	std::vector<uint32_t> cursors(m_BucketStarts.begin(), m_BucketStarts.end() - 1);
+	m_Entries.resize(entryCount);
+	for (uint32_t i = 0; i < entryCount; i++)
+	{
+		m_Entries[cursors[entryBuckets[i]]++] = entryAABBs[i];
+	}
+
+	return true;
+}
+
+void AABBHashGrid::Term()
+{
+	m_AABBs.clear();
+	m_BucketStarts.clear();
+	m_Entries.clear();
+	m_Margin = 0.0f;
+}
+
+size_t AABBHashGrid::GetMemorySize() const
+{
+	return m_AABBs.size() * sizeof(AABB) + (m_BucketStarts.size() + m_Entries.size()) * sizeof(uint32_t);
+}
@@ -0,0 +1,95 @@
+﻿#include "StencilTable.h"
+#include "ParallelFor.h"
+
+using namespace DirectX;
+using namespace DirectX::SimpleMath;
+
+namespace
+{
+	// 1回のParallelForのチャンクで評価する行数
+	static constexpr uint32_t APPLY_GRAIN_SIZE = 1024;
+}
+
+void StencilTable::Clear()
+{
+	m_Offsets.clear();
+	m_Offsets.push_back(0);
+	m_Indices.clear();
+	m_Weights.clear();
+}
+
+void StencilTable::AddStencil(uint32_t count, const uint32_t* pIndices, const float* pWeights)
+{
+	m_Indices.insert(m_Indices.end(), pIndices, pIndices + count);
+	m_Weights.insert(m_Weights.end(), pWeights, pWeights + count);
+	m_Offsets.push_back(static_cast<uint32_t>(m_Indices.size()));
+}
+
+void StencilTable::Append(const StencilTable& table)
+{
+	uint32_t base = m_Offsets.back();
+	for (uint32_t row = 0; row < table.GetStencilCount(); row++)
+	{
+		m_Offsets.push_back(base + table.m_Offsets[row + 1]);
+	}
+
+	m_Indices.insert(m_Indices.end(), table.m_Indices.begin(), table.m_Indices.end());
+	m_Weights.insert(m_Weights.end(), table.m_Weights.begin(), table.m_Weights.end());
+}
+
+size_t StencilTable::GetMemorySize() const
+{
+	return m_Offsets.size() * sizeof(uint32_t) + m_Indices.size() * sizeof(uint32_t) + m_Weights.size() * sizeof(float);
+}
+
+void StencilTable::Apply(const Vector3* pSrc, Vector3* pDst) const
+{
+	ParallelFor(GetStencilCount(), APPLY_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+	{
+		Apply(pSrc, pDst, begin, end);
+	});
+}
+
+void StencilTable::Apply(const Vector2* pSrc, Vector2* pDst) const
+{
+	ParallelFor(GetStencilCount(), APPLY_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+	{
+		Apply(pSrc, pDst, begin, end);
+	});
+}
+
+void StencilTable::Apply(const Vector3* pSrc, Vector3* pDst, uint32_t beginRow, uint32_t endRow) const
+{
+	for (uint32_t row = beginRow; row < endRow; row++)
+	{
+		const uint32_t* pIndices = &m_Indices[m_Offsets[row]];
+		const float* pWeights = &m_Weights[m_Offsets[row]];
+		uint32_t count = m_Offsets[row + 1] - m_Offsets[row];
+
+		XMVECTOR sum = XMVectorZero();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			sum = XMVectorMultiplyAdd(XMVectorReplicate(pWeights[i]), XMLoadFloat3(&pSrc[pIndices[i]]), sum);
+		}
+
+		XMStoreFloat3(&pDst[row], sum);
+	}
+}
+
+void StencilTable::Apply(const Vector2* pSrc, Vector2* pDst, uint32_t beginRow, uint32_t endRow) const
+{
+	for (uint32_t row = beginRow; row < endRow; row++)
+	{
+		const uint32_t* pIndices = &m_Indices[m_Offsets[row]];
+		const float* pWeights = &m_Weights[m_Offsets[row]];
+		uint32_t count = m_Offsets[row + 1] - m_Offsets[row];
+
+		XMVECTOR sum = XMVectorZero();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			sum = XMVectorMultiplyAdd(XMVectorReplicate(pWeights[i]), XMLoadFloat2(&pSrc[pIndices[i]]), sum);
+		}
+
+		XMStoreFloat2(&pDst[row], sum);
+	}
+}
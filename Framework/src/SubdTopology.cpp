@@ -0,0 +1,140 @@
+﻿#include "SubdTopology.h"
+#include "Logger.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	uint64_t MakeEdgeKey(uint32_t v0, uint32_t v1)
+	{
+		return (static_cast<uint64_t>(std::min(v0, v1)) << 32) | std::max(v0, v1);
+	}
+
+	void BuildCSR(uint32_t count, const std::vector<uint32_t>& keys, const std::vector<uint32_t>& values, std::vector<uint32_t>& offsets, std::vector<uint32_t>& elements)
+	{
+		offsets.assign(count + 1, 0);
+		for (uint32_t key : keys)
+		{
+			offsets[key + 1]++;
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			offsets[i + 1] += offsets[i];
+		}
+
+		elements.resize(keys.size());
+		std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			elements[cursor[keys[i]]++] = values[i];
+		}
+	}
+}
+
+bool BuildAdjacency(const SubdTopology& topology, SubdAdjacency& adjacency)
+{
+	uint32_t faceCount = static_cast<uint32_t>(topology.FaceVertexCounts.size());
+
+	adjacency.FaceOffsets.resize(faceCount + 1);
+	adjacency.FaceOffsets[0] = 0;
+	for (uint32_t face = 0; face < faceCount; face++)
+	{
+		if (topology.FaceVertexCounts[face] < 3)
+		{
+			ELOG("Error : Degenerate face. face = %u", face);
+			return false;
+		}
+
+		adjacency.FaceOffsets[face + 1] = adjacency.FaceOffsets[face] + topology.FaceVertexCounts[face];
+	}
+
+	if (adjacency.FaceOffsets[faceCount] != topology.FaceVertexIndices.size())
+	{
+		ELOG("Error : FaceVertexCounts and FaceVertexIndices do not match.");
+		return false;
+	}
+
+	std::unordered_map<uint64_t, uint32_t> edgeMap;
+	edgeMap.reserve(topology.FaceVertexIndices.size());
+
+	adjacency.FaceEdges.resize(topology.FaceVertexIndices.size());
+	adjacency.EdgeVertices.clear();
+	adjacency.EdgeFaces.clear();
+	adjacency.EdgeFaceCounts.clear();
+
+	std::vector<uint32_t> vertexFaceKeys;
+	std::vector<uint32_t> vertexFaceValues;
+	vertexFaceKeys.reserve(topology.FaceVertexIndices.size());
+	vertexFaceValues.reserve(topology.FaceVertexIndices.size());
+
+	for (uint32_t face = 0; face < faceCount; face++)
+	{
+		uint32_t offset = adjacency.FaceOffsets[face];
+		uint32_t size = adjacency.GetFaceSize(face);
+
+		for (uint32_t i = 0; i < size; i++)
+		{
+			uint32_t v0 = topology.FaceVertexIndices[offset + i];
+			uint32_t v1 = topology.FaceVertexIndices[offset + (i + 1) % size];
+			if (v0 >= topology.VertexCount || v1 >= topology.VertexCount)
+			{
+				ELOG("Error : Vertex index out of range. face = %u", face);
+				return false;
+			}
+
+			vertexFaceKeys.push_back(v0);
+			vertexFaceValues.push_back(face);
+
+			const auto& result = edgeMap.emplace(MakeEdgeKey(v0, v1), static_cast<uint32_t>(adjacency.EdgeFaceCounts.size()));
+			uint32_t edge = result.first->second;
+			if (result.second)
+			{
+				adjacency.EdgeVertices.push_back(v0);
+				adjacency.EdgeVertices.push_back(v1);
+				adjacency.EdgeFaces.push_back(face);
+				adjacency.EdgeFaces.push_back(INVALID_INDEX);
+				adjacency.EdgeFaceCounts.push_back(1);
+			}
+			else
+			{
+				if (adjacency.EdgeFaceCounts[edge] == 1)
+				{
+					adjacency.EdgeFaces[edge * 2 + 1] = face;
+				}
+				adjacency.EdgeFaceCounts[edge]++;
+			}
+
+			adjacency.FaceEdges[offset + i] = edge;
+		}
+	}
+
+	uint32_t edgeCount = adjacency.GetEdgeCount();
+
+	adjacency.EdgeSharpness.assign(edgeCount, 0.0f);
+	for (const SubdCrease& crease : topology.Creases)
+	{
+		const auto& itr = edgeMap.find(MakeEdgeKey(crease.V0, crease.V1));
+		if (itr != edgeMap.end())
+		{
+			adjacency.EdgeSharpness[itr->second] = std::max(crease.Sharpness, 0.0f);
+		}
+	}
+
+	std::vector<uint32_t> vertexEdgeKeys(edgeCount * 2);
+	std::vector<uint32_t> vertexEdgeValues(edgeCount * 2);
+	for (uint32_t edge = 0; edge < edgeCount; edge++)
+	{
+		vertexEdgeKeys[edge * 2 + 0] = adjacency.EdgeVertices[edge * 2 + 0];
+		vertexEdgeKeys[edge * 2 + 1] = adjacency.EdgeVertices[edge * 2 + 1];
+		vertexEdgeValues[edge * 2 + 0] = edge;
+		vertexEdgeValues[edge * 2 + 1] = edge;
+	}
+
+	BuildCSR(topology.VertexCount, vertexEdgeKeys, vertexEdgeValues, adjacency.VertexEdgeOffsets, adjacency.VertexEdges);
+	BuildCSR(topology.VertexCount, vertexFaceKeys, vertexFaceValues, adjacency.VertexFaceOffsets, adjacency.VertexFaces);
+
+	return true;
+}
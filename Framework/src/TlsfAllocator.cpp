@@ -0,0 +1,372 @@
+﻿#include "TlsfAllocator.h"
+#include "Logger.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace
+{
+	uint64_t RoundUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+TlsfAllocator::TlsfAllocator()
+: m_FlBitmap(0)
+, m_Size(0)
+, m_UsedSize(0)
+, m_AllocationCount(0)
+{
+	Term();
+}
+
+TlsfAllocator::~TlsfAllocator()
+{
+	Term();
+}
+
+bool TlsfAllocator::Init(uint64_t size)
+{
+	Term();
+
+	if (size < GRANULARITY)
+	{
+		ELOG("Error : Invalid Arguments. size = %llu", static_cast<unsigned long long>(size));
+		return false;
+	}
+
+	m_Size = size / GRANULARITY * GRANULARITY;
+
+	uint32_t blockIdx = CreateBlock(0, m_Size, INVALID_BLOCK, INVALID_BLOCK);
+	InsertFreeBlock(blockIdx);
+	return true;
+}
+
+void TlsfAllocator::Term()
+{
+	m_Blocks.clear();
+	m_UnusedBlocks.clear();
+
+	m_FlBitmap = 0;
+	for (uint32_t fl = 0; fl < FL_INDEX_COUNT; fl++)
+	{
+		m_SlBitmaps[fl] = 0;
+		for (uint32_t sl = 0; sl < SL_INDEX_COUNT; sl++)
+		{
+			m_FreeLists[fl][sl] = INVALID_BLOCK;
+		}
+	}
+
+	m_Size = 0;
+	m_UsedSize = 0;
+	m_AllocationCount = 0;
+}
+
+TlsfAllocator::Allocation TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	Allocation allocation;
+	if (size == 0 || alignment == 0 || size > m_Size)
+	{
+		return allocation;
+	}
+
+	uint64_t searchSize = GetRequiredBlockSize(size, alignment);
+	uint32_t blockIdx = (searchSize <= m_Size) ? FindFreeBlock(searchSize) : INVALID_BLOCK;
+	if (blockIdx == INVALID_BLOCK)
+	{
+		return allocation;
+	}
+
+	RemoveFreeBlock(blockIdx);
+
+	uint64_t blockOffset = m_Blocks[blockIdx].Offset;
+	uint64_t offset = RoundUp(blockOffset, alignment);
+
+	// 詰め物のうちGRANULARITY以上の分は前の空きブロックとして残す
+	uint64_t frontSize = (offset - blockOffset) / GRANULARITY * GRANULARITY;
+	if (frontSize > 0)
+	{
+		uint32_t backIdx = SplitBlock(blockIdx, frontSize);
+		InsertFreeBlock(blockIdx);
+		blockIdx = backIdx;
+	}
+
+	uint64_t usedSize = RoundUp(offset - m_Blocks[blockIdx].Offset + size, GRANULARITY);
+	assert(usedSize <= m_Blocks[blockIdx].Size);
+	if (m_Blocks[blockIdx].Size - usedSize >= GRANULARITY)
+	{
+		uint32_t backIdx = SplitBlock(blockIdx, usedSize);
+		InsertFreeBlock(backIdx);
+	}
+
+	m_Blocks[blockIdx].IsFree = false;
+	m_UsedSize += m_Blocks[blockIdx].Size;
+	m_AllocationCount++;
+
+	allocation.Offset = offset;
+	allocation.BlockIdx = blockIdx;
+	return allocation;
+}
+
+void TlsfAllocator::Free(const Allocation& allocation)
+{
+	// 解放済みのものや他のアロケータのものは、ブロックが確保中でオフセットを含んでいるかで弾く
+	uint32_t blockIdx = allocation.BlockIdx;
+	if (blockIdx >= m_Blocks.size()
+		|| m_Blocks[blockIdx].IsFree
+		|| allocation.Offset < m_Blocks[blockIdx].Offset
+		|| allocation.Offset >= m_Blocks[blockIdx].Offset + m_Blocks[blockIdx].Size)
+	{
+		ELOG("Error : Invalid Allocation. offset = %llu", static_cast<unsigned long long>(allocation.Offset));
+		return;
+	}
+
+	m_Blocks[blockIdx].IsFree = true;
+	m_UsedSize -= m_Blocks[blockIdx].Size;
+	m_AllocationCount--;
+
+	// 空きブロックは常に結合してあるので、前後を1つずつ見ればよい
+	uint32_t prevIdx = m_Blocks[blockIdx].PrevPhysical;
+	if (prevIdx != INVALID_BLOCK && m_Blocks[prevIdx].IsFree)
+	{
+		RemoveFreeBlock(prevIdx);
+		MergeWithNext(prevIdx);
+		blockIdx = prevIdx;
+	}
+
+	uint32_t nextIdx = m_Blocks[blockIdx].NextPhysical;
+	if (nextIdx != INVALID_BLOCK && m_Blocks[nextIdx].IsFree)
+	{
+		RemoveFreeBlock(nextIdx);
+		MergeWithNext(blockIdx);
+	}
+
+	InsertFreeBlock(blockIdx);
+}
+
+TlsfAllocatorStats TlsfAllocator::GetStats() const
+{
+	TlsfAllocatorStats stats;
+	stats.Size = m_Size;
+	stats.UsedSize = m_UsedSize;
+	stats.FreeSize = m_Size - m_UsedSize;
+	stats.AllocationCount = m_AllocationCount;
+
+	for (uint32_t fl = 0; fl < FL_INDEX_COUNT; fl++)
+	{
+		for (uint32_t sl = 0; sl < SL_INDEX_COUNT; sl++)
+		{
+			for (uint32_t blockIdx = m_FreeLists[fl][sl]; blockIdx != INVALID_BLOCK; blockIdx = m_Blocks[blockIdx].NextFree)
+			{
+				stats.FreeBlockCount++;
+				stats.LargestFreeBlockSize = std::max(stats.LargestFreeBlockSize, m_Blocks[blockIdx].Size);
+			}
+		}
+	}
+
+	if (stats.FreeSize > 0)
+	{
+		stats.Fragmentation = 1.0f - static_cast<float>(static_cast<double>(stats.LargestFreeBlockSize) / static_cast<double>(stats.FreeSize));
+	}
+
+	return stats;
+}
+
+uint64_t TlsfAllocator::GetRequiredBlockSize(uint64_t size, uint64_t alignment)
+{
+	// 空きブロックの先頭はGRANULARITYの倍数なので、alignmentがGRANULARITYの約数なら詰め物はいらない。
+	// そうでなければ、どこから始まるブロックでも揃えられるようにalignment - 1だけ大きいブロックを探す
+	uint64_t blockSize = RoundUp(size, GRANULARITY);
+	if (alignment != 0 && GRANULARITY % alignment != 0)
+	{
+		blockSize += RoundUp(alignment - 1, GRANULARITY);
+	}
+	return blockSize;
+}
+
+void TlsfAllocator::Mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+	// GRANULARITY単位でSL_INDEX_COUNT未満の小さいブロックは第1レベルを0にして1単位ずつの段に分ける
+	uint64_t unitCount = size / GRANULARITY;
+	if (unitCount < SL_INDEX_COUNT)
+	{
+		fl = 0;
+		sl = static_cast<uint32_t>(unitCount);
+		return;
+	}
+
+	uint32_t msb = 63 - std::countl_zero(unitCount);
+	fl = msb - SL_INDEX_COUNT_LOG2 + 1;
+	sl = static_cast<uint32_t>(unitCount >> (msb - SL_INDEX_COUNT_LOG2)) - SL_INDEX_COUNT;
+}
+
+uint32_t TlsfAllocator::FindFreeBlock(uint64_t size) const
+{
+	// 段の中のブロックの大きさはまちまちなので、次の段の最小の大きさに切り上げてから探せば、見つかったブロックは必ず足りる
+	uint64_t roundedSize = size;
+	uint64_t unitCount = size / GRANULARITY;
+	if (unitCount >= SL_INDEX_COUNT)
+	{
+		uint32_t msb = 63 - std::countl_zero(unitCount);
+		roundedSize += ((1ull << (msb - SL_INDEX_COUNT_LOG2)) - 1) * GRANULARITY;
+	}
+
+	uint32_t fl = 0;
+	uint32_t sl = 0;
+	Mapping(roundedSize, fl, sl);
+	if (fl < FL_INDEX_COUNT)
+	{
+		uint32_t slMap = m_SlBitmaps[fl] & (~0u << sl);
+		uint64_t flMap = (fl + 1 < FL_INDEX_COUNT) ? (m_FlBitmap & (~0ull << (fl + 1))) : 0;
+		if (slMap != 0 || flMap != 0)
+		{
+			if (slMap == 0)
+			{
+				fl = std::countr_zero(flMap);
+				slMap = m_SlBitmaps[fl];
+			}
+
+			assert(slMap != 0);
+			return m_FreeLists[fl][std::countr_zero(slMap)];
+		}
+	}
+
+	// 切り上げた段より上に空きがなくても、sizeと同じ段に足りるブロックがあることがある。
+	// 1つの空きブロックだけの新しいページのように、大きさぎりぎりの範囲からも確保できるように段の中を辿る
+	Mapping(size, fl, sl);
+	if (fl >= FL_INDEX_COUNT)
+	{
+		return INVALID_BLOCK;
+	}
+
+	for (uint32_t blockIdx = m_FreeLists[fl][sl]; blockIdx != INVALID_BLOCK; blockIdx = m_Blocks[blockIdx].NextFree)
+	{
+		if (m_Blocks[blockIdx].Size >= size)
+		{
+			return blockIdx;
+		}
+	}
+	return INVALID_BLOCK;
+}
+
+uint32_t TlsfAllocator::CreateBlock(uint64_t offset, uint64_t size, uint32_t prevPhysical, uint32_t nextPhysical)
+{
+	uint32_t blockIdx = 0;
+	if (m_UnusedBlocks.empty())
+	{
+		blockIdx = static_cast<uint32_t>(m_Blocks.size());
+		m_Blocks.emplace_back();
+	}
+	else
+	{
+		blockIdx = m_UnusedBlocks.back();
+		m_UnusedBlocks.pop_back();
+	}
+
+	Block& block = m_Blocks[blockIdx];
+	block.Offset = offset;
+	block.Size = size;
+	block.PrevPhysical = prevPhysical;
+	block.NextPhysical = nextPhysical;
+	block.PrevFree = INVALID_BLOCK;
+	block.NextFree = INVALID_BLOCK;
+	block.IsFree = true;
+	return blockIdx;
+}
+
+void TlsfAllocator::DestroyBlock(uint32_t blockIdx)
+{
+	m_UnusedBlocks.push_back(blockIdx);
+}
+
+void TlsfAllocator::InsertFreeBlock(uint32_t blockIdx)
+{
+	Block& block = m_Blocks[blockIdx];
+	assert(block.IsFree);
+
+	uint32_t fl = 0;
+	uint32_t sl = 0;
+	Mapping(block.Size, fl, sl);
+
+	uint32_t headIdx = m_FreeLists[fl][sl];
+	block.PrevFree = INVALID_BLOCK;
+	block.NextFree = headIdx;
+	if (headIdx != INVALID_BLOCK)
+	{
+		m_Blocks[headIdx].PrevFree = blockIdx;
+	}
+	m_FreeLists[fl][sl] = blockIdx;
+
+	m_FlBitmap |= 1ull << fl;
+	m_SlBitmaps[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::RemoveFreeBlock(uint32_t blockIdx)
+{
+	Block& block = m_Blocks[blockIdx];
+
+	uint32_t fl = 0;
+	uint32_t sl = 0;
+	Mapping(block.Size, fl, sl);
+
+	if (block.PrevFree != INVALID_BLOCK)
+	{
+		m_Blocks[block.PrevFree].NextFree = block.NextFree;
+	}
+	else
+	{
+		m_FreeLists[fl][sl] = block.NextFree;
+	}
+
+	if (block.NextFree != INVALID_BLOCK)
+	{
+		m_Blocks[block.NextFree].PrevFree = block.PrevFree;
+	}
+
+	block.PrevFree = INVALID_BLOCK;
+	block.NextFree = INVALID_BLOCK;
+
+	if (m_FreeLists[fl][sl] == INVALID_BLOCK)
+	{
+		m_SlBitmaps[fl] &= ~(1u << sl);
+		if (m_SlBitmaps[fl] == 0)
+		{
+			m_FlBitmap &= ~(1ull << fl);
+		}
+	}
+}
+
+uint32_t TlsfAllocator::SplitBlock(uint32_t blockIdx, uint64_t size)
+{
+	assert(size < m_Blocks[blockIdx].Size);
+
+	// CreateBlock()でm_Blocksが再確保されることがあるので、参照は作った後に取り直す
+	uint32_t nextIdx = m_Blocks[blockIdx].NextPhysical;
+	uint32_t backIdx = CreateBlock(m_Blocks[blockIdx].Offset + size, m_Blocks[blockIdx].Size - size, blockIdx, nextIdx);
+
+	m_Blocks[blockIdx].Size = size;
+	m_Blocks[blockIdx].NextPhysical = backIdx;
+	if (nextIdx != INVALID_BLOCK)
+	{
+		m_Blocks[nextIdx].PrevPhysical = backIdx;
+	}
+
+	return backIdx;
+}
+
+void TlsfAllocator::MergeWithNext(uint32_t blockIdx)
+{
+	uint32_t nextIdx = m_Blocks[blockIdx].NextPhysical;
+	assert(nextIdx != INVALID_BLOCK);
+
+	uint32_t nextNextIdx = m_Blocks[nextIdx].NextPhysical;
+	m_Blocks[blockIdx].Size += m_Blocks[nextIdx].Size;
+	m_Blocks[blockIdx].NextPhysical = nextNextIdx;
+	if (nextNextIdx != INVALID_BLOCK)
+	{
+		m_Blocks[nextNextIdx].PrevPhysical = blockIdx;
+	}
+
+	DestroyBlock(nextIdx);
+}
@@ -0,0 +1,162 @@
+﻿#include "TriangleBvh.h"
+#include "ParallelFor.h"
+#include "Logger.h"
+#include <algorithm>
+
+using namespace DirectX::SimpleMath;
+
+namespace
+{
+	static constexpr uint32_t TRIANGLE_GRAIN_SIZE = 4096;
+}
+
+bool TriangleBvh::Build(const std::vector<Vector3>& positions, const std::vector<uint32_t>& meshIndices, const BvhBuildSettings& settings)
+{
+	Term();
+
+	uint32_t triangleCount = static_cast<uint32_t>(meshIndices.size());
+	if (triangleCount == 0 || positions.size() != triangleCount * 3)
+	{
+		ELOG("Error : Invalid Arguments. positions = %zu, meshIndices = %zu", positions.size(), meshIndices.size());
+		return false;
+	}
+
+	std::vector<BvhPrimitiveBounds> bounds;
+	ComputeBounds(positions, bounds);
+
+	if (!m_Bvh.Build(triangleCount, bounds.data(), settings))
+	{
+		ELOG("Error : Bvh::Build() Failed.");
+		return false;
+	}
+
+	// 葉の順に並べ直して、葉の中の三角形を連続して読めるようにする
+	const std::vector<uint32_t>& primIndices = m_Bvh.GetPrimIndices();
+	m_Triangles.resize(triangleCount);
+	ParallelFor(triangleCount, TRIANGLE_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t triangleIdx = primIndices[i];
+			const Vector3& p0 = positions[triangleIdx * 3 + 0];
+			Triangle& triangle = m_Triangles[i];
+			triangle.V0 = p0;
+			triangle.Edge1 = positions[triangleIdx * 3 + 1] - p0;
+			triangle.Edge2 = positions[triangleIdx * 3 + 2] - p0;
+			triangle.MeshIdx = meshIndices[triangleIdx];
+			triangle.TriangleIdx = triangleIdx;
+		}
+	});
+
+	return true;
+}
+
+void TriangleBvh::Term()
+{
+	m_Bvh.Term();
+	m_Triangles.clear();
+	m_Triangles.shrink_to_fit();
+}
+
+bool TriangleBvh::Intersect(const Vector3& origin, const Vector3& direction, float tMax, TriangleHit& hit) const
+{
+	bool isHit = false;
+	m_Bvh.Traverse(origin, direction, tMax, [&](const BvhNode& leaf)
+	{
+		for (uint32_t i = leaf.LeftOrFirst; i < leaf.LeftOrFirst + leaf.PrimCount; i++)
+		{
+			isHit |= IntersectTriangle(m_Triangles[i], origin, direction, tMax, hit);
+		}
+		return false;
+	});
+
+	return isHit;
+}
+
+bool TriangleBvh::IsOccluded(const Vector3& origin, const Vector3& direction, float tMax) const
+{
+	bool isHit = false;
+	TriangleHit hit;
+	m_Bvh.Traverse(origin, direction, tMax, [&](const BvhNode& leaf)
+	{
+		for (uint32_t i = leaf.LeftOrFirst; i < leaf.LeftOrFirst + leaf.PrimCount; i++)
+		{
+			if (IntersectTriangle(m_Triangles[i], origin, direction, tMax, hit))
+			{
+				isHit = true;
+				return true;
+			}
+		}
+		return false;
+	});
+
+	return isHit;
+}
+
+bool TriangleBvh::IntersectBruteForce(const Vector3& origin, const Vector3& direction, float tMax, TriangleHit& hit) const
+{
+	bool isHit = false;
+	for (const Triangle& triangle : m_Triangles)
+	{
+		isHit |= IntersectTriangle(triangle, origin, direction, tMax, hit);
+	}
+
+	return isHit;
+}
+
+void TriangleBvh::ComputeBounds(const std::vector<Vector3>& positions, std::vector<BvhPrimitiveBounds>& bounds)
+{
+	uint32_t triangleCount = static_cast<uint32_t>(positions.size() / 3);
+	bounds.resize(triangleCount);
+	ParallelFor(triangleCount, TRIANGLE_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const Vector3& p0 = positions[i * 3 + 0];
+			const Vector3& p1 = positions[i * 3 + 1];
+			const Vector3& p2 = positions[i * 3 + 2];
+			bounds[i].Min = Vector3(std::min({p0.x, p1.x, p2.x}), std::min({p0.y, p1.y, p2.y}), std::min({p0.z, p1.z, p2.z}));
+			bounds[i].Max = Vector3(std::max({p0.x, p1.x, p2.x}), std::max({p0.y, p1.y, p2.y}), std::max({p0.z, p1.z, p2.z}));
+		}
+	});
+}
+
+bool TriangleBvh::IntersectTriangle(const Triangle& triangle, const Vector3& origin, const Vector3& direction, float& tMax, TriangleHit& hit)
+{
+	const Vector3& p = direction.Cross(triangle.Edge2);
+	float det = triangle.Edge1.Dot(p);
+	// 光線と三角形が平行
+	if (fabsf(det) < 1e-12f)
+	{
+		return false;
+	}
+
+	float invDet = 1.0f / det;
+	const Vector3& s = origin - triangle.V0;
+	float u = s.Dot(p) * invDet;
+	if (u < 0.0f || u > 1.0f)
+	{
+		return false;
+	}
+
+	const Vector3& q = s.Cross(triangle.Edge1);
+	float v = direction.Dot(q) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+	{
+		return false;
+	}
+
+	float t = triangle.Edge2.Dot(q) * invDet;
+	if (t < 0.0f || t >= tMax)
+	{
+		return false;
+	}
+
+	tMax = t;
+	hit.T = t;
+	hit.U = u;
+	hit.V = v;
+	hit.MeshIdx = triangle.MeshIdx;
+	hit.TriangleIdx = triangle.TriangleIdx;
+	return true;
+}
@@ -0,0 +1,311 @@
+﻿#include "UploadRing.h"
+#include "CommandList.h"
+#include "Fence.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	// リングから切り出す範囲のアラインメント。CopyBufferRegion()には制約はないが、memcpy()が揃うようにしておく
+	static constexpr uint64_t UPLOAD_ALIGNMENT = 16;
+
+	// リングのコマンドリストのアロケータの数。1フレームに何度かSubmit()しても、GPUを待たずに次の記録を始められるようにする
+	static constexpr uint32_t COMMAND_ALLOCATOR_COUNT = 8;
+}
+
+UploadRing::UploadRing()
+: m_pBuffer(nullptr)
+, m_pMappedData(nullptr)
+, m_MaxChunkSize(0)
+, m_pQueue(nullptr)
+, m_pFence(nullptr)
+, m_AllocatorIndex(0)
+, m_IsRecording(false)
+{
+}
+
+UploadRing::~UploadRing()
+{
+	Term();
+}
+
+bool UploadRing::Init
+(
+	ID3D12Device* pDevice,
+	ID3D12CommandQueue* pQueue,
+	Fence* pFence,
+	uint64_t capacity,
+	uint32_t maxFrameCount
+)
+{
+	if (pDevice == nullptr || pQueue == nullptr || pFence == nullptr || capacity < UPLOAD_ALIGNMENT * 4)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return false;
+	}
+
+	Term();
+
+	D3D12_HEAP_PROPERTIES prop = {};
+	prop.Type = D3D12_HEAP_TYPE_UPLOAD;
+	prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	prop.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	prop.CreationNodeMask = 1;
+	prop.VisibleNodeMask = 1;
+
+	D3D12_RESOURCE_DESC desc = {};
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	desc.Alignment = 0;
+	desc.Width = capacity;
+	desc.Height = 1;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = 1;
+	desc.Format = DXGI_FORMAT_UNKNOWN;
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	// UPLOADヒープのリソースはGENERIC_READで作る必要がある
+	HRESULT hr = pDevice->CreateCommittedResource
+	(
+		&prop,
+		D3D12_HEAP_FLAG_NONE,
+		&desc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(m_pBuffer.GetAddressOf())
+	);
+	if (FAILED(hr))
+	{
+		ELOG("Error : ID3D12Device::CreateCommittedResource() Failed. retcode = 0x%x", hr);
+		return false;
+	}
+
+	// UPLOADヒープはMapしたままでもGPUから読めるので、Term()までUnmapしない
+	void* ptr = nullptr;
+	hr = m_pBuffer->Map(0, nullptr, &ptr);
+	if (FAILED(hr) || ptr == nullptr)
+	{
+		ELOG("Error : ID3D12Resource::Map() Failed. retcode = 0x%x", hr);
+		Term();
+		return false;
+	}
+	m_pMappedData = static_cast<uint8_t*>(ptr);
+
+	if (!m_Allocator.Init(capacity, maxFrameCount))
+	{
+		ELOG("Error : RingAllocator::Init() Failed.");
+		Term();
+		return false;
+	}
+
+	if (!m_CommandList.Init(pDevice, D3D12_COMMAND_LIST_TYPE_DIRECT, COMMAND_ALLOCATOR_COUNT))
+	{
+		ELOG("Error : CommandList::Init() Failed.");
+		Term();
+		return false;
+	}
+
+	m_pBuffer->SetName(L"UploadRing");
+	m_CommandList.Get()->SetName(L"UploadRingCommandList");
+
+	m_MaxChunkSize = capacity / 4 / UPLOAD_ALIGNMENT * UPLOAD_ALIGNMENT;
+	m_pQueue = pQueue;
+	m_pFence = pFence;
+	m_AllocatorFenceValues.assign(COMMAND_ALLOCATOR_COUNT, 0);
+	m_AllocatorIndex = 0;
+	m_IsRecording = false;
+	m_Stats = UploadRingStats();
+
+	return true;
+}
+
+void UploadRing::Term()
+{
+	// 記録したままのコピーは実行しない。実行済みのものはアプリがGPUを待ってからTerm()する
+	if (m_IsRecording)
+	{
+		m_CommandList.Get()->Close();
+		m_IsRecording = false;
+	}
+	m_CommandList.Term();
+	m_AllocatorFenceValues.clear();
+
+	if (m_pMappedData != nullptr)
+	{
+		m_pBuffer->Unmap(0, nullptr);
+		m_pMappedData = nullptr;
+	}
+
+	m_pBuffer.Reset();
+	m_Allocator.Term();
+	m_MaxChunkSize = 0;
+	m_pQueue = nullptr;
+	m_pFence = nullptr;
+}
+
+bool UploadRing::Upload
+(
+	ID3D12Resource* pDst,
+	uint64_t dstOffset,
+	uint64_t size,
+	const void* pData
+)
+{
+	if (pDst == nullptr || size == 0 || pData == nullptr)
+	{
+		ELOG("Error : Invalid Arguments.");
+		return false;
+	}
+
+	if (m_pMappedData == nullptr)
+	{
+		ELOG("Error : UploadRing is not initialized.");
+		return false;
+	}
+
+	if (!BeginRecording())
+	{
+		return false;
+	}
+
+	const uint8_t* pSrc = static_cast<const uint8_t*>(pData);
+	bool result = m_Allocator.AllocateChunks(size, UPLOAD_ALIGNMENT, m_MaxChunkSize,
+		[&](uint64_t srcOffset, uint64_t ringOffset, uint64_t chunkSize)
+		{
+			memcpy(m_pMappedData + ringOffset, pSrc + srcOffset, chunkSize);
+			m_CommandList.Get()->CopyBufferRegion(pDst, dstOffset + srcOffset, m_pBuffer.Get(), ringOffset, chunkSize);
+		},
+		[&]()
+		{
+			return Flush();
+		}
+	);
+	if (!result)
+	{
+		ELOG("Error : RingAllocator::AllocateChunks() Failed. size = %llu", static_cast<unsigned long long>(size));
+		return false;
+	}
+
+	m_Stats.UploadCount++;
+	m_Stats.UploadSize += size;
+	m_Stats.CommittedEquivalentSize += (size + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) / D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT * D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	m_Stats.PeakUsedSize = std::max(m_Stats.PeakUsedSize, m_Allocator.GetUsedSize());
+
+	return true;
+}
+
+bool UploadRing::Submit()
+{
+	if (!m_IsRecording)
+	{
+		return true;
+	}
+
+	if (Execute() == 0)
+	{
+		ELOG("Error : Fence::Signal() Failed.");
+		return false;
+	}
+
+	return true;
+}
+
+bool UploadRing::BeginRecording()
+{
+	if (m_IsRecording)
+	{
+		return true;
+	}
+
+	// CommandList::Reset()が次に使うアロケータで記録したコマンドリストの完了を待つ
+	uint64_t fenceValue = m_AllocatorFenceValues[m_AllocatorIndex];
+	if (fenceValue > m_pFence->GetCompletedValue())
+	{
+		m_pFence->WaitForValue(fenceValue, INFINITE);
+	}
+
+	if (m_CommandList.Reset() == nullptr)
+	{
+		ELOG("Error : CommandList::Reset() Failed.");
+		return false;
+	}
+
+	m_IsRecording = true;
+	return true;
+}
+
+uint64_t UploadRing::Execute()
+{
+	ID3D12GraphicsCommandList* pCmdList = m_CommandList.Get();
+	pCmdList->Close();
+	m_IsRecording = false;
+
+	ID3D12CommandList* pLists[] = {pCmdList};
+	m_pQueue->ExecuteCommandLists(1, pLists);
+
+	// 失敗して0になっても、次にこのアロケータを使うときは待たないだけなので記録しておく
+	uint64_t fenceValue = m_pFence->Signal(m_pQueue);
+	m_AllocatorFenceValues[m_AllocatorIndex] = fenceValue;
+	m_AllocatorIndex = (m_AllocatorIndex + 1) % COMMAND_ALLOCATOR_COUNT;
+	return fenceValue;
+}
+
+bool UploadRing::Flush()
+{
+	// 記録したチャンクのコピーを実行し、完了を待ってリングを全て返却する。アプリのコマンドリストには触れない
+	uint64_t fenceValue = Execute();
+	if (fenceValue == 0)
+	{
+		ELOG("Error : Fence::Signal() Failed.");
+		return false;
+	}
+
+	bool result = m_Allocator.EndFrame(fenceValue);
+	if (!result)
+	{
+		ELOG("Error : RingAllocator::EndFrame() Failed.");
+	}
+
+	m_pFence->WaitForValue(fenceValue, INFINITE);
+
+	m_Allocator.Retire(m_pFence->GetCompletedValue());
+
+	// 残りのチャンクを記録し直す
+	if (!BeginRecording())
+	{
+		return false;
+	}
+
+	m_Stats.FlushCount++;
+	return result;
+}
+
+bool UploadRing::EndFrame(uint64_t fenceValue)
+{
+	// 実行していないコピーの範囲をこのフレームで返却すると、コピーする前に上書きされてしまう
+	if (m_IsRecording)
+	{
+		ELOG("Error : UploadRing::Submit() is not called.");
+		return false;
+	}
+
+	return m_Allocator.EndFrame(fenceValue);
+}
+
+void UploadRing::Retire(uint64_t completedFenceValue)
+{
+	m_Allocator.Retire(completedFenceValue);
+}
+
+uint64_t UploadRing::GetCapacity() const
+{
+	return m_Allocator.GetCapacity();
+}
+
+const UploadRingStats& UploadRing::GetStats() const
+{
+	return m_Stats;
+}
@@ -0,0 +1,1265 @@
+﻿#include "WideBvh.h"
+#include "CpuFeatures.h"
+#include "Logger.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define WIDE_BVH_TARGET_AVX2
+#else
+#define WIDE_BVH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace DirectX::SimpleMath;
+
+namespace
+{
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+	// 光線の向きの成分がこれより小さければこの値に置き換え、逆数が無限大やNaNにならないようにする
+	static constexpr float MIN_DIRECTION = 1e-20f;
+	// TriangleBvhと同じく、行列式がこれより小さければ光線と三角形が平行とみなす
+	static constexpr float DETERMINANT_EPSILON = 1e-12f;
+	// 探索のスタックの大きさ。1段降りるごとに高々Width - 1個増える
+	static constexpr uint32_t STACK_SIZE_PER_WIDTH = BVH_MAX_DEPTH;
+
+	struct SingleRay
+	{
+		float Origin[3];
+		float Direction[3];
+		float InvDir[3];
+		// 負の向きの軸は、AABBの最大の面から入って最小の面から出る
+		bool IsNegative[3];
+	};
+
+	// レーンごとの光線と交差の結果
+	template<uint32_t Width>
+	struct alignas(32) PacketRays
+	{
+		float OriginX[Width];
+		float OriginY[Width];
+		float OriginZ[Width];
+		float DirectionX[Width];
+		float DirectionY[Width];
+		float DirectionZ[Width];
+		float InvDirX[Width];
+		float InvDirY[Width];
+		float InvDirZ[Width];
+		// 交差するたびに縮める
+		float TMax[Width];
+		float U[Width];
+		float V[Width];
+		uint32_t MeshIndices[Width];
+		uint32_t TriangleIndices[Width];
+		uint32_t HitMask;
+	};
+
+	struct StackEntry
+	{
+		uint32_t Index;
+		// 0なら内部ノード
+		uint32_t PacketCount;
+		// パケットの探索で、この子と交差した光線のビット
+		uint32_t LaneMask;
+		float TNear;
+	};
+
+	float GetHalfArea(const BvhNode& node)
+	{
+		const Vector3& extent = node.BoundsMax - node.BoundsMin;
+		return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+	}
+
+	// 2分木のノードごとに、部分木の三角形のBvh::GetPrimIndices()での範囲を求める。部分木の三角形は連続している
+	void ComputeSubtreeRanges(const std::vector<BvhNode>& nodes, uint32_t nodeIdx, std::vector<uint32_t>& firstPrims, std::vector<uint32_t>& primCounts)
+	{
+		const BvhNode& node = nodes[nodeIdx];
+		if (node.IsLeaf())
+		{
+			firstPrims[nodeIdx] = node.LeftOrFirst;
+			primCounts[nodeIdx] = node.PrimCount;
+			return;
+		}
+
+		ComputeSubtreeRanges(nodes, node.LeftOrFirst, firstPrims, primCounts);
+		ComputeSubtreeRanges(nodes, node.LeftOrFirst + 1, firstPrims, primCounts);
+		firstPrims[nodeIdx] = firstPrims[node.LeftOrFirst];
+		primCounts[nodeIdx] = primCounts[node.LeftOrFirst] + primCounts[node.LeftOrFirst + 1];
+	}
+
+	float GetSafeInverse(float value)
+	{
+		return 1.0f / ((fabsf(value) < MIN_DIRECTION) ? copysignf(MIN_DIRECTION, value) : value);
+	}
+
+	SingleRay SetupRay(const Vector3& origin, const Vector3& direction)
+	{
+		SingleRay ray;
+		const float* pOrigin = &origin.x;
+		const float* pDirection = &direction.x;
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			ray.Origin[axis] = pOrigin[axis];
+			ray.Direction[axis] = pDirection[axis];
+			ray.InvDir[axis] = GetSafeInverse(pDirection[axis]);
+			ray.IsNegative[axis] = ray.InvDir[axis] < 0.0f;
+		}
+		return ray;
+	}
+
+	// 子をtNearの遠い順に積み、近い子から取り出されるようにする
+	template<uint32_t Width>
+	void PushSortedChildren(StackEntry* pEntries, uint32_t count, StackEntry* pStack, uint32_t& stackSize)
+	{
+		for (uint32_t i = 1; i < count; i++)
+		{
+			StackEntry entry = pEntries[i];
+			uint32_t j = i;
+			for (; j > 0 && pEntries[j - 1].TNear < entry.TNear; j--)
+			{
+				pEntries[j] = pEntries[j - 1];
+			}
+			pEntries[j] = entry;
+		}
+
+		assert(stackSize + count <= STACK_SIZE_PER_WIDTH * Width);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			pStack[stackSize++] = pEntries[i];
+		}
+	}
+
+	// SIMD版と同じ順番で計算し、結果を一致させる。FMAは使わない
+	template<uint32_t Width>
+	bool IntersectTriangleLane
+	(
+		const WideTrianglePacket<Width>& packet,
+		uint32_t lane,
+		const float origin[3],
+		const float direction[3],
+		float tMax,
+		float& t,
+		float& u,
+		float& v
+	)
+	{
+		const float e1[3] = {packet.Edge1X[lane], packet.Edge1Y[lane], packet.Edge1Z[lane]};
+		const float e2[3] = {packet.Edge2X[lane], packet.Edge2Y[lane], packet.Edge2Z[lane]};
+
+		const float p[3] =
+		{
+			direction[1] * e2[2] - direction[2] * e2[1],
+			direction[2] * e2[0] - direction[0] * e2[2],
+			direction[0] * e2[1] - direction[1] * e2[0],
+		};
+		float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+		// 光線と三角形が平行か、空きのレーン
+		if (!(fabsf(det) >= DETERMINANT_EPSILON))
+		{
+			return false;
+		}
+
+		float invDet = 1.0f / det;
+		const float s[3] = {origin[0] - packet.V0X[lane], origin[1] - packet.V0Y[lane], origin[2] - packet.V0Z[lane]};
+		u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+
+		const float q[3] =
+		{
+			s[1] * e1[2] - s[2] * e1[1],
+			s[2] * e1[0] - s[0] * e1[2],
+			s[0] * e1[1] - s[1] * e1[0],
+		};
+		v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * invDet;
+		t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+
+		return (u >= 0.0f) && (u <= 1.0f) && (v >= 0.0f) && (u + v <= 1.0f) && (t >= 0.0f) && (t < tMax);
+	}
+
+	// SIMDを使わない版。AVX2が使えないCPUでのWideBvh<8>に使う
+	template<uint32_t Width>
+	struct ScalarKernel
+	{
+		static uint32_t IntersectChildren(const WideBvhNode<Width>& node, const SingleRay& ray, float tMax, float* pTNear)
+		{
+			const float* pNear[3] =
+			{
+				ray.IsNegative[0] ? node.BoundsMaxX : node.BoundsMinX,
+				ray.IsNegative[1] ? node.BoundsMaxY : node.BoundsMinY,
+				ray.IsNegative[2] ? node.BoundsMaxZ : node.BoundsMinZ,
+			};
+			const float* pFar[3] =
+			{
+				ray.IsNegative[0] ? node.BoundsMinX : node.BoundsMaxX,
+				ray.IsNegative[1] ? node.BoundsMinY : node.BoundsMaxY,
+				ray.IsNegative[2] ? node.BoundsMinZ : node.BoundsMaxZ,
+			};
+
+			uint32_t hitMask = 0;
+			for (uint32_t i = 0; i < Width; i++)
+			{
+				float nearX = (pNear[0][i] - ray.Origin[0]) * ray.InvDir[0];
+				float nearY = (pNear[1][i] - ray.Origin[1]) * ray.InvDir[1];
+				float nearZ = (pNear[2][i] - ray.Origin[2]) * ray.InvDir[2];
+				float farX = (pFar[0][i] - ray.Origin[0]) * ray.InvDir[0];
+				float farY = (pFar[1][i] - ray.Origin[1]) * ray.InvDir[1];
+				float farZ = (pFar[2][i] - ray.Origin[2]) * ray.InvDir[2];
+
+				float tNear = std::max(std::max(nearX, nearY), std::max(nearZ, 0.0f));
+				float tFar = std::min(std::min(farX, farY), std::min(farZ, tMax));
+				pTNear[i] = tNear;
+				hitMask |= (tNear <= tFar) ? (1u << i) : 0u;
+			}
+
+			return hitMask;
+		}
+
+		static bool IntersectLeaf(const WideTrianglePacket<Width>* pPackets, uint32_t packetCount, const SingleRay& ray, float& tMax, TriangleHit& hit)
+		{
+			bool isHit = false;
+			for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+			{
+				const WideTrianglePacket<Width>& packet = pPackets[packetIdx];
+				for (uint32_t lane = 0; lane < Width; lane++)
+				{
+					float t, u, v;
+					if (IntersectTriangleLane(packet, lane, ray.Origin, ray.Direction, tMax, t, u, v))
+					{
+						tMax = t;
+						hit = {t, u, v, packet.MeshIndices[lane], packet.TriangleIndices[lane]};
+						isHit = true;
+					}
+				}
+			}
+
+			return isHit;
+		}
+
+		static bool IsLeafOccluded(const WideTrianglePacket<Width>* pPackets, uint32_t packetCount, const SingleRay& ray, float tMax)
+		{
+			for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+			{
+				for (uint32_t lane = 0; lane < Width; lane++)
+				{
+					float t, u, v;
+					if (IntersectTriangleLane(pPackets[packetIdx], lane, ray.Origin, ray.Direction, tMax, t, u, v))
+					{
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		static uint32_t IntersectNodePacket(const WideBvhNode<Width>& node, const PacketRays<Width>& rays, uint32_t laneMask, uint32_t* pChildLaneMasks, float* pTNear)
+		{
+			uint32_t childMask = 0;
+			for (uint32_t child = 0; child < Width && node.Children[child] != INVALID_INDEX; child++)
+			{
+				uint32_t childLaneMask = 0;
+				float minTNear = FLT_MAX;
+				for (uint32_t mask = laneMask; mask != 0; mask &= mask - 1)
+				{
+					uint32_t lane = std::countr_zero(mask);
+					float t0X = (node.BoundsMinX[child] - rays.OriginX[lane]) * rays.InvDirX[lane];
+					float t0Y = (node.BoundsMinY[child] - rays.OriginY[lane]) * rays.InvDirY[lane];
+					float t0Z = (node.BoundsMinZ[child] - rays.OriginZ[lane]) * rays.InvDirZ[lane];
+					float t1X = (node.BoundsMaxX[child] - rays.OriginX[lane]) * rays.InvDirX[lane];
+					float t1Y = (node.BoundsMaxY[child] - rays.OriginY[lane]) * rays.InvDirY[lane];
+					float t1Z = (node.BoundsMaxZ[child] - rays.OriginZ[lane]) * rays.InvDirZ[lane];
+
+					float tNear = std::max(std::max(std::min(t0X, t1X), std::min(t0Y, t1Y)), std::max(std::min(t0Z, t1Z), 0.0f));
+					float tFar = std::min(std::min(std::max(t0X, t1X), std::max(t0Y, t1Y)), std::min(std::max(t0Z, t1Z), rays.TMax[lane]));
+					if (tNear <= tFar)
+					{
+						childLaneMask |= 1u << lane;
+						minTNear = std::min(minTNear, tNear);
+					}
+				}
+
+				if (childLaneMask != 0)
+				{
+					childMask |= 1u << child;
+					pChildLaneMasks[child] = childLaneMask;
+					pTNear[child] = minTNear;
+				}
+			}
+
+			return childMask;
+		}
+
+		static void IntersectLeafPacket(const WideTrianglePacket<Width>* pPackets, uint32_t packetCount, PacketRays<Width>& rays, uint32_t laneMask)
+		{
+			for (uint32_t mask = laneMask; mask != 0; mask &= mask - 1)
+			{
+				uint32_t lane = std::countr_zero(mask);
+				const float origin[3] = {rays.OriginX[lane], rays.OriginY[lane], rays.OriginZ[lane]};
+				const float direction[3] = {rays.DirectionX[lane], rays.DirectionY[lane], rays.DirectionZ[lane]};
+
+				for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+				{
+					const WideTrianglePacket<Width>& packet = pPackets[packetIdx];
+					for (uint32_t triangle = 0; triangle < Width && packet.MeshIndices[triangle] != INVALID_INDEX; triangle++)
+					{
+						float t, u, v;
+						if (IntersectTriangleLane(packet, triangle, origin, direction, rays.TMax[lane], t, u, v))
+						{
+							rays.TMax[lane] = t;
+							rays.U[lane] = u;
+							rays.V[lane] = v;
+							rays.MeshIndices[lane] = packet.MeshIndices[triangle];
+							rays.TriangleIndices[lane] = packet.TriangleIndices[triangle];
+							rays.HitMask |= 1u << lane;
+						}
+					}
+				}
+			}
+		}
+	};
+
+	//-------------------------------------------------------------------------
+	// SSE2。x64では常に使える
+	//-------------------------------------------------------------------------
+	struct Float3x4
+	{
+		__m128 X;
+		__m128 Y;
+		__m128 Z;
+	};
+
+	__m128 SelectSSE(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	__m128 LaneMaskToVectorSSE(uint32_t laneMask)
+	{
+		const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+		return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int32_t>(laneMask)), bits), bits));
+	}
+
+	__m128 DotSSE(const Float3x4& a, const Float3x4& b)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.X, b.X), _mm_mul_ps(a.Y, b.Y)), _mm_mul_ps(a.Z, b.Z));
+	}
+
+	Float3x4 CrossSSE(const Float3x4& a, const Float3x4& b)
+	{
+		return
+		{
+			_mm_sub_ps(_mm_mul_ps(a.Y, b.Z), _mm_mul_ps(a.Z, b.Y)),
+			_mm_sub_ps(_mm_mul_ps(a.Z, b.X), _mm_mul_ps(a.X, b.Z)),
+			_mm_sub_ps(_mm_mul_ps(a.X, b.Y), _mm_mul_ps(a.Y, b.X)),
+		};
+	}
+
+	// 4レーンの光線と三角形の交差を調べ、交差したレーンを全ビット立てたマスクを返す。
+	// 1本の光線と4個の三角形でも、4本の光線と1個の三角形でもよい
+	__m128 IntersectTrianglesSSE
+	(
+		const Float3x4& origin,
+		const Float3x4& direction,
+		const Float3x4& v0,
+		const Float3x4& edge1,
+		const Float3x4& edge2,
+		__m128 tMax,
+		__m128* pT,
+		__m128* pU,
+		__m128* pV
+	)
+	{
+		const Float3x4& p = CrossSSE(direction, edge2);
+		__m128 det = DotSSE(edge1, p);
+		__m128 isValid = _mm_cmpge_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), det), _mm_set1_ps(DETERMINANT_EPSILON));
+
+		__m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+		const Float3x4 s = {_mm_sub_ps(origin.X, v0.X), _mm_sub_ps(origin.Y, v0.Y), _mm_sub_ps(origin.Z, v0.Z)};
+		__m128 u = _mm_mul_ps(DotSSE(s, p), invDet);
+
+		const Float3x4& q = CrossSSE(s, edge1);
+		__m128 v = _mm_mul_ps(DotSSE(direction, q), invDet);
+		__m128 t = _mm_mul_ps(DotSSE(edge2, q), invDet);
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		isValid = _mm_and_ps(isValid, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+		isValid = _mm_and_ps(isValid, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+		isValid = _mm_and_ps(isValid, _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmplt_ps(t, tMax)));
+
+		*pT = t;
+		*pU = u;
+		*pV = v;
+		return isValid;
+	}
+
+	struct SSEKernel
+	{
+		static uint32_t IntersectChildren(const WideBvhNode<4>& node, const SingleRay& ray, float tMax, float* pTNear)
+		{
+			const __m128 originX = _mm_set1_ps(ray.Origin[0]);
+			const __m128 originY = _mm_set1_ps(ray.Origin[1]);
+			const __m128 originZ = _mm_set1_ps(ray.Origin[2]);
+			const __m128 invDirX = _mm_set1_ps(ray.InvDir[0]);
+			const __m128 invDirY = _mm_set1_ps(ray.InvDir[1]);
+			const __m128 invDirZ = _mm_set1_ps(ray.InvDir[2]);
+
+			__m128 nearX = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.IsNegative[0] ? node.BoundsMaxX : node.BoundsMinX), originX), invDirX);
+			__m128 nearY = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.IsNegative[1] ? node.BoundsMaxY : node.BoundsMinY), originY), invDirY);
+			__m128 nearZ = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.IsNegative[2] ? node.BoundsMaxZ : node.BoundsMinZ), originZ), invDirZ);
+			__m128 farX = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.IsNegative[0] ? node.BoundsMinX : node.BoundsMaxX), originX), invDirX);
+			__m128 farY = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.IsNegative[1] ? node.BoundsMinY : node.BoundsMaxY), originY), invDirY);
+			__m128 farZ = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.IsNegative[2] ? node.BoundsMinZ : node.BoundsMaxZ), originZ), invDirZ);
+
+			__m128 tNear = _mm_max_ps(_mm_max_ps(nearX, nearY), _mm_max_ps(nearZ, _mm_setzero_ps()));
+			__m128 tFar = _mm_min_ps(_mm_min_ps(farX, farY), _mm_min_ps(farZ, _mm_set1_ps(tMax)));
+			_mm_storeu_ps(pTNear, tNear);
+			return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+		}
+
+		static bool IntersectLeaf(const WideTrianglePacket<4>* pPackets, uint32_t packetCount, const SingleRay& ray, float& tMax, TriangleHit& hit)
+		{
+			const Float3x4 origin = {_mm_set1_ps(ray.Origin[0]), _mm_set1_ps(ray.Origin[1]), _mm_set1_ps(ray.Origin[2])};
+			const Float3x4 direction = {_mm_set1_ps(ray.Direction[0]), _mm_set1_ps(ray.Direction[1]), _mm_set1_ps(ray.Direction[2])};
+
+			bool isHit = false;
+			for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+			{
+				const WideTrianglePacket<4>& packet = pPackets[packetIdx];
+				const Float3x4 v0 = {_mm_load_ps(packet.V0X), _mm_load_ps(packet.V0Y), _mm_load_ps(packet.V0Z)};
+				const Float3x4 edge1 = {_mm_load_ps(packet.Edge1X), _mm_load_ps(packet.Edge1Y), _mm_load_ps(packet.Edge1Z)};
+				const Float3x4 edge2 = {_mm_load_ps(packet.Edge2X), _mm_load_ps(packet.Edge2Y), _mm_load_ps(packet.Edge2Z)};
+
+				__m128 t, u, v;
+				uint32_t hitMask = static_cast<uint32_t>(_mm_movemask_ps(IntersectTrianglesSSE(origin, direction, v0, edge1, edge2, _mm_set1_ps(tMax), &t, &u, &v)));
+				if (hitMask == 0)
+				{
+					continue;
+				}
+
+				alignas(16) float ts[4];
+				alignas(16) float us[4];
+				alignas(16) float vs[4];
+				_mm_store_ps(ts, t);
+				_mm_store_ps(us, u);
+				_mm_store_ps(vs, v);
+
+				// スカラー版と同じく、同じ距離ならレーンの若い方を残す
+				for (uint32_t mask = hitMask; mask != 0; mask &= mask - 1)
+				{
+					uint32_t lane = std::countr_zero(mask);
+					if (ts[lane] < tMax)
+					{
+						tMax = ts[lane];
+						hit = {ts[lane], us[lane], vs[lane], packet.MeshIndices[lane], packet.TriangleIndices[lane]};
+						isHit = true;
+					}
+				}
+			}
+
+			return isHit;
+		}
+
+		static bool IsLeafOccluded(const WideTrianglePacket<4>* pPackets, uint32_t packetCount, const SingleRay& ray, float tMax)
+		{
+			const Float3x4 origin = {_mm_set1_ps(ray.Origin[0]), _mm_set1_ps(ray.Origin[1]), _mm_set1_ps(ray.Origin[2])};
+			const Float3x4 direction = {_mm_set1_ps(ray.Direction[0]), _mm_set1_ps(ray.Direction[1]), _mm_set1_ps(ray.Direction[2])};
+
+			for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+			{
+				const WideTrianglePacket<4>& packet = pPackets[packetIdx];
+				const Float3x4 v0 = {_mm_load_ps(packet.V0X), _mm_load_ps(packet.V0Y), _mm_load_ps(packet.V0Z)};
+				const Float3x4 edge1 = {_mm_load_ps(packet.Edge1X), _mm_load_ps(packet.Edge1Y), _mm_load_ps(packet.Edge1Z)};
+				const Float3x4 edge2 = {_mm_load_ps(packet.Edge2X), _mm_load_ps(packet.Edge2Y), _mm_load_ps(packet.Edge2Z)};
+
+				__m128 t, u, v;
+				if (_mm_movemask_ps(IntersectTrianglesSSE(origin, direction, v0, edge1, edge2, _mm_set1_ps(tMax), &t, &u, &v)) != 0)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		static uint32_t IntersectNodePacket(const WideBvhNode<4>& node, const PacketRays<4>& rays, uint32_t laneMask, uint32_t* pChildLaneMasks, float* pTNear)
+		{
+			const __m128 originX = _mm_load_ps(rays.OriginX);
+			const __m128 originY = _mm_load_ps(rays.OriginY);
+			const __m128 originZ = _mm_load_ps(rays.OriginZ);
+			const __m128 invDirX = _mm_load_ps(rays.InvDirX);
+			const __m128 invDirY = _mm_load_ps(rays.InvDirY);
+			const __m128 invDirZ = _mm_load_ps(rays.InvDirZ);
+			const __m128 tMax = _mm_load_ps(rays.TMax);
+
+			uint32_t childMask = 0;
+			for (uint32_t child = 0; child < 4 && node.Children[child] != INVALID_INDEX; child++)
+			{
+				__m128 t0X = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.BoundsMinX[child]), originX), invDirX);
+				__m128 t0Y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.BoundsMinY[child]), originY), invDirY);
+				__m128 t0Z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.BoundsMinZ[child]), originZ), invDirZ);
+				__m128 t1X = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.BoundsMaxX[child]), originX), invDirX);
+				__m128 t1Y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.BoundsMaxY[child]), originY), invDirY);
+				__m128 t1Z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.BoundsMaxZ[child]), originZ), invDirZ);
+
+				__m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0X, t1X), _mm_min_ps(t0Y, t1Y)), _mm_max_ps(_mm_min_ps(t0Z, t1Z), _mm_setzero_ps()));
+				__m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0X, t1X), _mm_max_ps(t0Y, t1Y)), _mm_min_ps(_mm_max_ps(t0Z, t1Z), tMax));
+				uint32_t childLaneMask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar))) & laneMask;
+				if (childLaneMask == 0)
+				{
+					continue;
+				}
+
+				// 交差した光線のうち最も近いtNear
+				__m128 minTNear = SelectSSE(LaneMaskToVectorSSE(childLaneMask), tNear, _mm_set1_ps(FLT_MAX));
+				minTNear = _mm_min_ps(minTNear, _mm_shuffle_ps(minTNear, minTNear, _MM_SHUFFLE(2, 3, 0, 1)));
+				minTNear = _mm_min_ps(minTNear, _mm_shuffle_ps(minTNear, minTNear, _MM_SHUFFLE(1, 0, 3, 2)));
+
+				childMask |= 1u << child;
+				pChildLaneMasks[child] = childLaneMask;
+				pTNear[child] = _mm_cvtss_f32(minTNear);
+			}
+
+			return childMask;
+		}
+
+		static void IntersectLeafPacket(const WideTrianglePacket<4>* pPackets, uint32_t packetCount, PacketRays<4>& rays, uint32_t laneMask)
+		{
+			const Float3x4 origin = {_mm_load_ps(rays.OriginX), _mm_load_ps(rays.OriginY), _mm_load_ps(rays.OriginZ)};
+			const Float3x4 direction = {_mm_load_ps(rays.DirectionX), _mm_load_ps(rays.DirectionY), _mm_load_ps(rays.DirectionZ)};
+			const __m128 activeLanes = LaneMaskToVectorSSE(laneMask);
+
+			__m128 tMax = _mm_load_ps(rays.TMax);
+			__m128 hitU = _mm_load_ps(rays.U);
+			__m128 hitV = _mm_load_ps(rays.V);
+			__m128 meshIndices = _mm_load_ps(reinterpret_cast<const float*>(rays.MeshIndices));
+			__m128 triangleIndices = _mm_load_ps(reinterpret_cast<const float*>(rays.TriangleIndices));
+			uint32_t hitMask = 0;
+
+			for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+			{
+				const WideTrianglePacket<4>& packet = pPackets[packetIdx];
+				for (uint32_t triangle = 0; triangle < 4 && packet.MeshIndices[triangle] != INVALID_INDEX; triangle++)
+				{
+					const Float3x4 v0 = {_mm_set1_ps(packet.V0X[triangle]), _mm_set1_ps(packet.V0Y[triangle]), _mm_set1_ps(packet.V0Z[triangle])};
+					const Float3x4 edge1 = {_mm_set1_ps(packet.Edge1X[triangle]), _mm_set1_ps(packet.Edge1Y[triangle]), _mm_set1_ps(packet.Edge1Z[triangle])};
+					const Float3x4 edge2 = {_mm_set1_ps(packet.Edge2X[triangle]), _mm_set1_ps(packet.Edge2Y[triangle]), _mm_set1_ps(packet.Edge2Z[triangle])};
+
+					__m128 t, u, v;
+					__m128 isHit = _mm_and_ps(IntersectTrianglesSSE(origin, direction, v0, edge1, edge2, tMax, &t, &u, &v), activeLanes);
+					uint32_t triangleHitMask = static_cast<uint32_t>(_mm_movemask_ps(isHit));
+					if (triangleHitMask == 0)
+					{
+						continue;
+					}
+
+					tMax = SelectSSE(isHit, t, tMax);
+					hitU = SelectSSE(isHit, u, hitU);
+					hitV = SelectSSE(isHit, v, hitV);
+					meshIndices = SelectSSE(isHit, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(packet.MeshIndices[triangle]))), meshIndices);
+					triangleIndices = SelectSSE(isHit, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(packet.TriangleIndices[triangle]))), triangleIndices);
+					hitMask |= triangleHitMask;
+				}
+			}
+
+			_mm_store_ps(rays.TMax, tMax);
+			_mm_store_ps(rays.U, hitU);
+			_mm_store_ps(rays.V, hitV);
+			_mm_store_ps(reinterpret_cast<float*>(rays.MeshIndices), meshIndices);
+			_mm_store_ps(reinterpret_cast<float*>(rays.TriangleIndices), triangleIndices);
+			rays.HitMask |= hitMask;
+		}
+	};
+
+	//-------------------------------------------------------------------------
+	// AVX2。IsAVX2Supported()がtrueのときだけ呼ぶ
+	//-------------------------------------------------------------------------
+	struct Float3x8
+	{
+		__m256 X;
+		__m256 Y;
+		__m256 Z;
+	};
+
+	WIDE_BVH_TARGET_AVX2 __m256 LaneMaskToVectorAVX2(uint32_t laneMask)
+	{
+		const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+		return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int32_t>(laneMask)), bits), bits));
+	}
+
+	WIDE_BVH_TARGET_AVX2 __m256 DotAVX2(const Float3x8& a, const Float3x8& b)
+	{
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a.X, b.X), _mm256_mul_ps(a.Y, b.Y)), _mm256_mul_ps(a.Z, b.Z));
+	}
+
+	WIDE_BVH_TARGET_AVX2 Float3x8 CrossAVX2(const Float3x8& a, const Float3x8& b)
+	{
+		return
+		{
+			_mm256_sub_ps(_mm256_mul_ps(a.Y, b.Z), _mm256_mul_ps(a.Z, b.Y)),
+			_mm256_sub_ps(_mm256_mul_ps(a.Z, b.X), _mm256_mul_ps(a.X, b.Z)),
+			_mm256_sub_ps(_mm256_mul_ps(a.X, b.Y), _mm256_mul_ps(a.Y, b.X)),
+		};
+	}
+
+	// IntersectTrianglesSSE()の8レーン版
+	WIDE_BVH_TARGET_AVX2 __m256 IntersectTrianglesAVX2
+	(
+		const Float3x8& origin,
+		const Float3x8& direction,
+		const Float3x8& v0,
+		const Float3x8& edge1,
+		const Float3x8& edge2,
+		__m256 tMax,
+		__m256* pT,
+		__m256* pU,
+		__m256* pV
+	)
+	{
+		const Float3x8& p = CrossAVX2(direction, edge2);
+		__m256 det = DotAVX2(edge1, p);
+		__m256 isValid = _mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), det), _mm256_set1_ps(DETERMINANT_EPSILON), _CMP_GE_OQ);
+
+		__m256 invDet = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+		const Float3x8 s = {_mm256_sub_ps(origin.X, v0.X), _mm256_sub_ps(origin.Y, v0.Y), _mm256_sub_ps(origin.Z, v0.Z)};
+		__m256 u = _mm256_mul_ps(DotAVX2(s, p), invDet);
+
+		const Float3x8& q = CrossAVX2(s, edge1);
+		__m256 v = _mm256_mul_ps(DotAVX2(direction, q), invDet);
+		__m256 t = _mm256_mul_ps(DotAVX2(edge2, q), invDet);
+
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		isValid = _mm256_and_ps(isValid, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+		isValid = _mm256_and_ps(isValid, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+		isValid = _mm256_and_ps(isValid, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, tMax, _CMP_LT_OQ)));
+
+		*pT = t;
+		*pU = u;
+		*pV = v;
+		return isValid;
+	}
+
+	struct AVX2Kernel
+	{
+		WIDE_BVH_TARGET_AVX2 static uint32_t IntersectChildren(const WideBvhNode<8>& node, const SingleRay& ray, float tMax, float* pTNear)
+		{
+			const __m256 originX = _mm256_set1_ps(ray.Origin[0]);
+			const __m256 originY = _mm256_set1_ps(ray.Origin[1]);
+			const __m256 originZ = _mm256_set1_ps(ray.Origin[2]);
+			const __m256 invDirX = _mm256_set1_ps(ray.InvDir[0]);
+			const __m256 invDirY = _mm256_set1_ps(ray.InvDir[1]);
+			const __m256 invDirZ = _mm256_set1_ps(ray.InvDir[2]);
+
+			__m256 nearX = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.IsNegative[0] ? node.BoundsMaxX : node.BoundsMinX), originX), invDirX);
+			__m256 nearY = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.IsNegative[1] ? node.BoundsMaxY : node.BoundsMinY), originY), invDirY);
+			__m256 nearZ = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.IsNegative[2] ? node.BoundsMaxZ : node.BoundsMinZ), originZ), invDirZ);
+			__m256 farX = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.IsNegative[0] ? node.BoundsMinX : node.BoundsMaxX), originX), invDirX);
+			__m256 farY = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.IsNegative[1] ? node.BoundsMinY : node.BoundsMaxY), originY), invDirY);
+			__m256 farZ = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.IsNegative[2] ? node.BoundsMinZ : node.BoundsMaxZ), originZ), invDirZ);
+
+			__m256 tNear = _mm256_max_ps(_mm256_max_ps(nearX, nearY), _mm256_max_ps(nearZ, _mm256_setzero_ps()));
+			__m256 tFar = _mm256_min_ps(_mm256_min_ps(farX, farY), _mm256_min_ps(farZ, _mm256_set1_ps(tMax)));
+			_mm256_storeu_ps(pTNear, tNear);
+			return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+		}
+
+		WIDE_BVH_TARGET_AVX2 static bool IntersectLeaf(const WideTrianglePacket<8>* pPackets, uint32_t packetCount, const SingleRay& ray, float& tMax, TriangleHit& hit)
+		{
+			const Float3x8 origin = {_mm256_set1_ps(ray.Origin[0]), _mm256_set1_ps(ray.Origin[1]), _mm256_set1_ps(ray.Origin[2])};
+			const Float3x8 direction = {_mm256_set1_ps(ray.Direction[0]), _mm256_set1_ps(ray.Direction[1]), _mm256_set1_ps(ray.Direction[2])};
+
+			bool isHit = false;
+			for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+			{
+				const WideTrianglePacket<8>& packet = pPackets[packetIdx];
+				const Float3x8 v0 = {_mm256_load_ps(packet.V0X), _mm256_load_ps(packet.V0Y), _mm256_load_ps(packet.V0Z)};
+				const Float3x8 edge1 = {_mm256_load_ps(packet.Edge1X), _mm256_load_ps(packet.Edge1Y), _mm256_load_ps(packet.Edge1Z)};
+				const Float3x8 edge2 = {_mm256_load_ps(packet.Edge2X), _mm256_load_ps(packet.Edge2Y), _mm256_load_ps(packet.Edge2Z)};
+
+				__m256 t, u, v;
+				uint32_t hitMask = static_cast<uint32_t>(_mm256_movemask_ps(IntersectTrianglesAVX2(origin, direction, v0, edge1, edge2, _mm256_set1_ps(tMax), &t, &u, &v)));
+				if (hitMask == 0)
+				{
+					continue;
+				}
+
+				alignas(32) float ts[8];
+				alignas(32) float us[8];
+				alignas(32) float vs[8];
+				_mm256_store_ps(ts, t);
+				_mm256_store_ps(us, u);
+				_mm256_store_ps(vs, v);
+
+				// スカラー版と同じく、同じ距離ならレーンの若い方を残す
+				for (uint32_t mask = hitMask; mask != 0; mask &= mask - 1)
+				{
+					uint32_t lane = std::countr_zero(mask);
+					if (ts[lane] < tMax)
+					{
+						tMax = ts[lane];
+						hit = {ts[lane], us[lane], vs[lane], packet.MeshIndices[lane], packet.TriangleIndices[lane]};
+						isHit = true;
+					}
+				}
+			}
+
+			return isHit;
+		}
+
+		WIDE_BVH_TARGET_AVX2 static bool IsLeafOccluded(const WideTrianglePacket<8>* pPackets, uint32_t packetCount, const SingleRay& ray, float tMax)
+		{
+			const Float3x8 origin = {_mm256_set1_ps(ray.Origin[0]), _mm256_set1_ps(ray.Origin[1]), _mm256_set1_ps(ray.Origin[2])};
+			const Float3x8 direction = {_mm256_set1_ps(ray.Direction[0]), _mm256_set1_ps(ray.Direction[1]), _mm256_set1_ps(ray.Direction[2])};
+
+			for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+			{
+				const WideTrianglePacket<8>& packet = pPackets[packetIdx];
+				const Float3x8 v0 = {_mm256_load_ps(packet.V0X), _mm256_load_ps(packet.V0Y), _mm256_load_ps(packet.V0Z)};
+				const Float3x8 edge1 = {_mm256_load_ps(packet.Edge1X), _mm256_load_ps(packet.Edge1Y), _mm256_load_ps(packet.Edge1Z)};
+				const Float3x8 edge2 = {_mm256_load_ps(packet.Edge2X), _mm256_load_ps(packet.Edge2Y), _mm256_load_ps(packet.Edge2Z)};
+
+				__m256 t, u, v;
+				if (_mm256_movemask_ps(IntersectTrianglesAVX2(origin, direction, v0, edge1, edge2, _mm256_set1_ps(tMax), &t, &u, &v)) != 0)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		WIDE_BVH_TARGET_AVX2 static uint32_t IntersectNodePacket(const WideBvhNode<8>& node, const PacketRays<8>& rays, uint32_t laneMask, uint32_t* pChildLaneMasks, float* pTNear)
+		{
+			const __m256 originX = _mm256_load_ps(rays.OriginX);
+			const __m256 originY = _mm256_load_ps(rays.OriginY);
+			const __m256 originZ = _mm256_load_ps(rays.OriginZ);
+			const __m256 invDirX = _mm256_load_ps(rays.InvDirX);
+			const __m256 invDirY = _mm256_load_ps(rays.InvDirY);
+			const __m256 invDirZ = _mm256_load_ps(rays.InvDirZ);
+			const __m256 tMax = _mm256_load_ps(rays.TMax);
+
+			uint32_t childMask = 0;
+			for (uint32_t child = 0; child < 8 && node.Children[child] != INVALID_INDEX; child++)
+			{
+				__m256 t0X = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.BoundsMinX[child]), originX), invDirX);
+				__m256 t0Y = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.BoundsMinY[child]), originY), invDirY);
+				__m256 t0Z = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.BoundsMinZ[child]), originZ), invDirZ);
+				__m256 t1X = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.BoundsMaxX[child]), originX), invDirX);
+				__m256 t1Y = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.BoundsMaxY[child]), originY), invDirY);
+				__m256 t1Z = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.BoundsMaxZ[child]), originZ), invDirZ);
+
+				__m256 tNear = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(t0X, t1X), _mm256_min_ps(t0Y, t1Y)), _mm256_max_ps(_mm256_min_ps(t0Z, t1Z), _mm256_setzero_ps()));
+				__m256 tFar = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(t0X, t1X), _mm256_max_ps(t0Y, t1Y)), _mm256_min_ps(_mm256_max_ps(t0Z, t1Z), tMax));
+				uint32_t childLaneMask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ))) & laneMask;
+				if (childLaneMask == 0)
+				{
+					continue;
+				}
+
+				// 交差した光線のうち最も近いtNear
+				__m256 minTNear = _mm256_blendv_ps(_mm256_set1_ps(FLT_MAX), tNear, LaneMaskToVectorAVX2(childLaneMask));
+				minTNear = _mm256_min_ps(minTNear, _mm256_permute_ps(minTNear, _MM_SHUFFLE(2, 3, 0, 1)));
+				minTNear = _mm256_min_ps(minTNear, _mm256_permute_ps(minTNear, _MM_SHUFFLE(1, 0, 3, 2)));
+				minTNear = _mm256_min_ps(minTNear, _mm256_permute2f128_ps(minTNear, minTNear, 1));
+
+				childMask |= 1u << child;
+				pChildLaneMasks[child] = childLaneMask;
+				pTNear[child] = _mm256_cvtss_f32(minTNear);
+			}
+
+			return childMask;
+		}
+
+		WIDE_BVH_TARGET_AVX2 static void IntersectLeafPacket(const WideTrianglePacket<8>* pPackets, uint32_t packetCount, PacketRays<8>& rays, uint32_t laneMask)
+		{
+			const Float3x8 origin = {_mm256_load_ps(rays.OriginX), _mm256_load_ps(rays.OriginY), _mm256_load_ps(rays.OriginZ)};
+			const Float3x8 direction = {_mm256_load_ps(rays.DirectionX), _mm256_load_ps(rays.DirectionY), _mm256_load_ps(rays.DirectionZ)};
+			const __m256 activeLanes = LaneMaskToVectorAVX2(laneMask);
+
+			__m256 tMax = _mm256_load_ps(rays.TMax);
+			__m256 hitU = _mm256_load_ps(rays.U);
+			__m256 hitV = _mm256_load_ps(rays.V);
+			__m256 meshIndices = _mm256_load_ps(reinterpret_cast<const float*>(rays.MeshIndices));
+			__m256 triangleIndices = _mm256_load_ps(reinterpret_cast<const float*>(rays.TriangleIndices));
+			uint32_t hitMask = 0;
+
+			for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+			{
+				const WideTrianglePacket<8>& packet = pPackets[packetIdx];
+				for (uint32_t triangle = 0; triangle < 8 && packet.MeshIndices[triangle] != INVALID_INDEX; triangle++)
+				{
+					const Float3x8 v0 = {_mm256_set1_ps(packet.V0X[triangle]), _mm256_set1_ps(packet.V0Y[triangle]), _mm256_set1_ps(packet.V0Z[triangle])};
+					const Float3x8 edge1 = {_mm256_set1_ps(packet.Edge1X[triangle]), _mm256_set1_ps(packet.Edge1Y[triangle]), _mm256_set1_ps(packet.Edge1Z[triangle])};
+					const Float3x8 edge2 = {_mm256_set1_ps(packet.Edge2X[triangle]), _mm256_set1_ps(packet.Edge2Y[triangle]), _mm256_set1_ps(packet.Edge2Z[triangle])};
+
+					__m256 t, u, v;
+					__m256 isHit = _mm256_and_ps(IntersectTrianglesAVX2(origin, direction, v0, edge1, edge2, tMax, &t, &u, &v), activeLanes);
+					uint32_t triangleHitMask = static_cast<uint32_t>(_mm256_movemask_ps(isHit));
+					if (triangleHitMask == 0)
+					{
+						continue;
+					}
+
+					tMax = _mm256_blendv_ps(tMax, t, isHit);
+					hitU = _mm256_blendv_ps(hitU, u, isHit);
+					hitV = _mm256_blendv_ps(hitV, v, isHit);
+					meshIndices = _mm256_blendv_ps(meshIndices, _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int32_t>(packet.MeshIndices[triangle]))), isHit);
+					triangleIndices = _mm256_blendv_ps(triangleIndices, _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int32_t>(packet.TriangleIndices[triangle]))), isHit);
+					hitMask |= triangleHitMask;
+				}
+			}
+
+			_mm256_store_ps(rays.TMax, tMax);
+			_mm256_store_ps(rays.U, hitU);
+			_mm256_store_ps(rays.V, hitV);
+			_mm256_store_ps(reinterpret_cast<float*>(rays.MeshIndices), meshIndices);
+			_mm256_store_ps(reinterpret_cast<float*>(rays.TriangleIndices), triangleIndices);
+			rays.HitMask |= hitMask;
+		}
+	};
+
+	//-------------------------------------------------------------------------
+	// 探索。ノードと葉の交差判定だけをKernelで切り替える
+	//-------------------------------------------------------------------------
+	template<uint32_t Width, typename Kernel, bool IsAnyHit>
+	bool TraverseSingle
+	(
+		const WideBvhNode<Width>* pNodes,
+		const WideTrianglePacket<Width>* pPackets,
+		const SingleRay& ray,
+		float tMax,
+		TriangleHit& hit
+	)
+	{
+		StackEntry stack[STACK_SIZE_PER_WIDTH * Width];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = {0, 0, 0, 0.0f};
+
+		bool isHit = false;
+		while (stackSize > 0)
+		{
+			const StackEntry entry = stack[--stackSize];
+			// 積んだ後でもっと近い交差が見つかった
+			if (entry.TNear > tMax)
+			{
+				continue;
+			}
+
+			if (entry.PacketCount > 0)
+			{
+				if constexpr (IsAnyHit)
+				{
+					if (Kernel::IsLeafOccluded(&pPackets[entry.Index], entry.PacketCount, ray, tMax))
+					{
+						return true;
+					}
+				}
+				else
+				{
+					isHit |= Kernel::IntersectLeaf(&pPackets[entry.Index], entry.PacketCount, ray, tMax, hit);
+				}
+				continue;
+			}
+
+			const WideBvhNode<Width>& node = pNodes[entry.Index];
+			float tNear[Width];
+			uint32_t childMask = Kernel::IntersectChildren(node, ray, tMax, tNear);
+
+			StackEntry children[Width];
+			uint32_t childCount = 0;
+			for (; childMask != 0; childMask &= childMask - 1)
+			{
+				uint32_t child = std::countr_zero(childMask);
+				children[childCount++] = {node.Children[child], node.PacketCounts[child], 0, tNear[child]};
+			}
+			PushSortedChildren<Width>(children, childCount, stack, stackSize);
+		}
+
+		return isHit;
+	}
+
+	template<uint32_t Width, typename Kernel>
+	void TraversePacket
+	(
+		const WideBvhNode<Width>* pNodes,
+		const WideTrianglePacket<Width>* pPackets,
+		PacketRays<Width>& rays,
+		uint32_t laneMask
+	)
+	{
+		StackEntry stack[STACK_SIZE_PER_WIDTH * Width];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = {0, 0, laneMask, 0.0f};
+
+		while (stackSize > 0)
+		{
+			const StackEntry entry = stack[--stackSize];
+			// 交差した光線のどれもが、積んだ後でもっと近い交差を見つけた
+			float maxTMax = 0.0f;
+			for (uint32_t mask = entry.LaneMask; mask != 0; mask &= mask - 1)
+			{
+				maxTMax = std::max(maxTMax, rays.TMax[std::countr_zero(mask)]);
+			}
+			if (entry.TNear > maxTMax)
+			{
+				continue;
+			}
+
+			if (entry.PacketCount > 0)
+			{
+				Kernel::IntersectLeafPacket(&pPackets[entry.Index], entry.PacketCount, rays, entry.LaneMask);
+				continue;
+			}
+
+			const WideBvhNode<Width>& node = pNodes[entry.Index];
+			uint32_t childLaneMasks[Width];
+			float tNear[Width];
+			uint32_t childMask = Kernel::IntersectNodePacket(node, rays, entry.LaneMask, childLaneMasks, tNear);
+
+			StackEntry children[Width];
+			uint32_t childCount = 0;
+			for (; childMask != 0; childMask &= childMask - 1)
+			{
+				uint32_t child = std::countr_zero(childMask);
+				children[childCount++] = {node.Children[child], node.PacketCounts[child], childLaneMasks[child], tNear[child]};
+			}
+			PushSortedChildren<Width>(children, childCount, stack, stackSize);
+		}
+	}
+}
+
+template<uint32_t Width>
+struct WideBvh<Width>::CollapseContext
+{
+	const std::vector<BvhNode>& BinaryNodes;
+	const std::vector<uint32_t>& PrimIndices;
+	const std::vector<Vector3>& Positions;
+	const std::vector<uint32_t>& MeshIndices;
+	// 2分木のノードごとの、部分木の三角形のPrimIndicesでの範囲
+	std::vector<uint32_t> FirstPrims;
+	std::vector<uint32_t> PrimCounts;
+
+	// 三角形がWidth個以下の部分木は、それ以上開かずに葉にする
+	bool IsLeaf(uint32_t binaryIdx) const
+	{
+		return BinaryNodes[binaryIdx].IsLeaf() || PrimCounts[binaryIdx] <= Width;
+	}
+};
+
+template<uint32_t Width>
+bool WideBvh<Width>::Build(const std::vector<Vector3>& positions, const std::vector<uint32_t>& meshIndices, const BvhBuildSettings& settings)
+{
+	Term();
+
+	uint32_t triangleCount = static_cast<uint32_t>(meshIndices.size());
+	if (triangleCount == 0 || positions.size() != triangleCount * 3)
+	{
+		ELOG("Error : Invalid Arguments. positions = %zu, meshIndices = %zu", positions.size(), meshIndices.size());
+		return false;
+	}
+
+	const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+
+	std::vector<BvhPrimitiveBounds> bounds;
+	TriangleBvh::ComputeBounds(positions, bounds);
+
+	Bvh binaryBvh;
+	if (!binaryBvh.Build(triangleCount, bounds.data(), settings))
+	{
+		ELOG("Error : Bvh::Build() Failed.");
+		return false;
+	}
+
+	const std::chrono::steady_clock::time_point& binaryEnd = std::chrono::steady_clock::now();
+
+	const std::vector<BvhNode>& binaryNodes = binaryBvh.GetNodes();
+	CollapseContext context = {binaryNodes, binaryBvh.GetPrimIndices(), positions, meshIndices};
+	context.FirstPrims.resize(binaryNodes.size());
+	context.PrimCounts.resize(binaryNodes.size());
+	ComputeSubtreeRanges(binaryNodes, 0, context.FirstPrims, context.PrimCounts);
+
+	// 2分木の内部ノードはおよそWidth - 1個ずつ1つのノードにまとまる
+	m_Nodes.reserve(binaryNodes.size() / (2 * (Width - 1)) + 1);
+	m_Packets.reserve((triangleCount + Width - 1) / Width * 2);
+	Collapse(context, 0, 1);
+	m_TriangleCount = triangleCount;
+	m_UseSIMD = (Width == 4) || IsAVX2Supported();
+
+	const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+	uint32_t childCount = 0;
+	for (const WideBvhNode<Width>& node : m_Nodes)
+	{
+		for (uint32_t child = 0; child < Width && node.Children[child] != INVALID_INDEX; child++)
+		{
+			childCount++;
+		}
+	}
+
+	m_BuildStats.BinaryBuildMilliseconds = std::chrono::duration<double, std::milli>(binaryEnd - start).count();
+	m_BuildStats.CollapseMilliseconds = std::chrono::duration<double, std::milli>(end - binaryEnd).count();
+	m_BuildStats.NodeCount = static_cast<uint32_t>(m_Nodes.size());
+	m_BuildStats.PacketCount = static_cast<uint32_t>(m_Packets.size());
+	m_BuildStats.AverageChildCount = static_cast<float>(childCount) / m_Nodes.size();
+	m_BuildStats.PacketOccupancy = static_cast<float>(triangleCount) / (m_Packets.size() * Width);
+
+	return true;
+}
+
+template<uint32_t Width>
+void WideBvh<Width>::Term()
+{
+	m_Nodes.clear();
+	m_Nodes.shrink_to_fit();
+	m_Packets.clear();
+	m_Packets.shrink_to_fit();
+	m_TriangleCount = 0;
+	m_BuildStats = WideBvhBuildStats();
+}
+
+template<uint32_t Width>
+uint32_t WideBvh<Width>::Collapse(const CollapseContext& context, uint32_t binaryIdx, uint32_t depth)
+{
+	const std::vector<BvhNode>& binaryNodes = context.BinaryNodes;
+	m_BuildStats.MaxDepth = std::max(m_BuildStats.MaxDepth, depth);
+
+	// 根が葉のときは、その葉だけを子に持つノードにする
+	uint32_t children[Width];
+	uint32_t childCount = 0;
+	if (context.IsLeaf(binaryIdx))
+	{
+		children[childCount++] = binaryIdx;
+	}
+	else
+	{
+		children[childCount++] = binaryNodes[binaryIdx].LeftOrFirst;
+		children[childCount++] = binaryNodes[binaryIdx].LeftOrFirst + 1;
+	}
+
+	// 表面積の大きい内部ノードの子から開いて、孫を直接の子にする
+	while (childCount < Width)
+	{
+		uint32_t openIdx = INVALID_INDEX;
+		float maxArea = -1.0f;
+		for (uint32_t i = 0; i < childCount; i++)
+		{
+			if (!context.IsLeaf(children[i]) && GetHalfArea(binaryNodes[children[i]]) > maxArea)
+			{
+				openIdx = i;
+				maxArea = GetHalfArea(binaryNodes[children[i]]);
+			}
+		}
+
+		if (openIdx == INVALID_INDEX)
+		{
+			break;
+		}
+
+		uint32_t leftIdx = binaryNodes[children[openIdx]].LeftOrFirst;
+		children[openIdx] = leftIdx;
+		children[childCount++] = leftIdx + 1;
+	}
+
+	// 子を畳み込む間にm_Nodesが再確保されるので、ローカルで組み立ててから書き込む
+	uint32_t nodeIdx = static_cast<uint32_t>(m_Nodes.size());
+	m_Nodes.emplace_back();
+
+	WideBvhNode<Width> node;
+	for (uint32_t i = 0; i < Width; i++)
+	{
+		if (i >= childCount)
+		{
+			node.BoundsMinX[i] = node.BoundsMinY[i] = node.BoundsMinZ[i] = FLT_MAX;
+			node.BoundsMaxX[i] = node.BoundsMaxY[i] = node.BoundsMaxZ[i] = -FLT_MAX;
+			node.Children[i] = INVALID_INDEX;
+			node.PacketCounts[i] = 0;
+			continue;
+		}
+
+		const BvhNode& child = binaryNodes[children[i]];
+		node.BoundsMinX[i] = child.BoundsMin.x;
+		node.BoundsMinY[i] = child.BoundsMin.y;
+		node.BoundsMinZ[i] = child.BoundsMin.z;
+		node.BoundsMaxX[i] = child.BoundsMax.x;
+		node.BoundsMaxY[i] = child.BoundsMax.y;
+		node.BoundsMaxZ[i] = child.BoundsMax.z;
+
+		if (context.IsLeaf(children[i]))
+		{
+			node.Children[i] = AddLeafPackets(context, children[i]);
+			node.PacketCounts[i] = (context.PrimCounts[children[i]] + Width - 1) / Width;
+			m_BuildStats.LeafCount++;
+		}
+		else
+		{
+			node.Children[i] = Collapse(context, children[i], depth + 1);
+			node.PacketCounts[i] = 0;
+		}
+	}
+
+	m_Nodes[nodeIdx] = node;
+	return nodeIdx;
+}
+
+template<uint32_t Width>
+uint32_t WideBvh<Width>::AddLeafPackets(const CollapseContext& context, uint32_t binaryIdx)
+{
+	uint32_t firstPrim = context.FirstPrims[binaryIdx];
+	uint32_t primCount = context.PrimCounts[binaryIdx];
+	uint32_t firstPacketIdx = static_cast<uint32_t>(m_Packets.size());
+	uint32_t packetCount = (primCount + Width - 1) / Width;
+
+	for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+	{
+		WideTrianglePacket<Width>& packet = m_Packets.emplace_back();
+		for (uint32_t lane = 0; lane < Width; lane++)
+		{
+			uint32_t primIdx = packetIdx * Width + lane;
+			if (primIdx >= primCount)
+			{
+				// 辺が0なら行列式が0になって交差しない
+				packet.V0X[lane] = packet.V0Y[lane] = packet.V0Z[lane] = 0.0f;
+				packet.Edge1X[lane] = packet.Edge1Y[lane] = packet.Edge1Z[lane] = 0.0f;
+				packet.Edge2X[lane] = packet.Edge2Y[lane] = packet.Edge2Z[lane] = 0.0f;
+				packet.MeshIndices[lane] = INVALID_INDEX;
+				packet.TriangleIndices[lane] = INVALID_INDEX;
+				continue;
+			}
+
+			uint32_t triangleIdx = context.PrimIndices[firstPrim + primIdx];
+			const Vector3& p0 = context.Positions[triangleIdx * 3 + 0];
+			const Vector3& edge1 = context.Positions[triangleIdx * 3 + 1] - p0;
+			const Vector3& edge2 = context.Positions[triangleIdx * 3 + 2] - p0;
+			packet.V0X[lane] = p0.x;
+			packet.V0Y[lane] = p0.y;
+			packet.V0Z[lane] = p0.z;
+			packet.Edge1X[lane] = edge1.x;
+			packet.Edge1Y[lane] = edge1.y;
+			packet.Edge1Z[lane] = edge1.z;
+			packet.Edge2X[lane] = edge2.x;
+			packet.Edge2Y[lane] = edge2.y;
+			packet.Edge2Z[lane] = edge2.z;
+			packet.MeshIndices[lane] = context.MeshIndices[triangleIdx];
+			packet.TriangleIndices[lane] = triangleIdx;
+		}
+	}
+
+	return firstPacketIdx;
+}
+
+template<uint32_t Width>
+bool WideBvh<Width>::Intersect(const Vector3& origin, const Vector3& direction, float tMax, TriangleHit& hit) const
+{
+	if (m_Nodes.empty())
+	{
+		return false;
+	}
+
+	const SingleRay& ray = SetupRay(origin, direction);
+	if constexpr (Width == 4)
+	{
+		return TraverseSingle<4, SSEKernel, false>(m_Nodes.data(), m_Packets.data(), ray, tMax, hit);
+	}
+	else
+	{
+		if (m_UseSIMD)
+		{
+			return TraverseSingle<8, AVX2Kernel, false>(m_Nodes.data(), m_Packets.data(), ray, tMax, hit);
+		}
+		return TraverseSingle<8, ScalarKernel<8>, false>(m_Nodes.data(), m_Packets.data(), ray, tMax, hit);
+	}
+}
+
+template<uint32_t Width>
+bool WideBvh<Width>::IsOccluded(const Vector3& origin, const Vector3& direction, float tMax) const
+{
+	if (m_Nodes.empty())
+	{
+		return false;
+	}
+
+	const SingleRay& ray = SetupRay(origin, direction);
+	TriangleHit hit;
+	if constexpr (Width == 4)
+	{
+		return TraverseSingle<4, SSEKernel, true>(m_Nodes.data(), m_Packets.data(), ray, tMax, hit);
+	}
+	else
+	{
+		if (m_UseSIMD)
+		{
+			return TraverseSingle<8, AVX2Kernel, true>(m_Nodes.data(), m_Packets.data(), ray, tMax, hit);
+		}
+		return TraverseSingle<8, ScalarKernel<8>, true>(m_Nodes.data(), m_Packets.data(), ray, tMax, hit);
+	}
+}
+
+template<uint32_t Width>
+uint32_t WideBvh<Width>::IntersectPacket
+(
+	const Vector3* pOrigins,
+	const Vector3* pDirections,
+	const float* pTMax,
+	uint32_t rayCount,
+	TriangleHit* pHits
+) const
+{
+	assert(rayCount <= Width);
+	if (m_Nodes.empty() || rayCount == 0)
+	{
+		return 0;
+	}
+
+	// 使わないレーンは最初の光線で埋めておき、LaneMaskで結果を捨てる
+	PacketRays<Width> rays;
+	for (uint32_t lane = 0; lane < Width; lane++)
+	{
+		uint32_t rayIdx = (lane < rayCount) ? lane : 0;
+		rays.OriginX[lane] = pOrigins[rayIdx].x;
+		rays.OriginY[lane] = pOrigins[rayIdx].y;
+		rays.OriginZ[lane] = pOrigins[rayIdx].z;
+		rays.DirectionX[lane] = pDirections[rayIdx].x;
+		rays.DirectionY[lane] = pDirections[rayIdx].y;
+		rays.DirectionZ[lane] = pDirections[rayIdx].z;
+		rays.InvDirX[lane] = GetSafeInverse(pDirections[rayIdx].x);
+		rays.InvDirY[lane] = GetSafeInverse(pDirections[rayIdx].y);
+		rays.InvDirZ[lane] = GetSafeInverse(pDirections[rayIdx].z);
+		rays.TMax[lane] = pTMax[rayIdx];
+		rays.U[lane] = 0.0f;
+		rays.V[lane] = 0.0f;
+		rays.MeshIndices[lane] = INVALID_INDEX;
+		rays.TriangleIndices[lane] = INVALID_INDEX;
+	}
+	rays.HitMask = 0;
+
+	uint32_t laneMask = (1u << rayCount) - 1;
+	if constexpr (Width == 4)
+	{
+		TraversePacket<4, SSEKernel>(m_Nodes.data(), m_Packets.data(), rays, laneMask);
+	}
+	else
+	{
+		if (m_UseSIMD)
+		{
+			TraversePacket<8, AVX2Kernel>(m_Nodes.data(), m_Packets.data(), rays, laneMask);
+		}
+		else
+		{
+			TraversePacket<8, ScalarKernel<8>>(m_Nodes.data(), m_Packets.data(), rays, laneMask);
+		}
+	}
+
+	for (uint32_t mask = rays.HitMask; mask != 0; mask &= mask - 1)
+	{
+		uint32_t lane = std::countr_zero(mask);
+		pHits[lane] = {rays.TMax[lane], rays.U[lane], rays.V[lane], rays.MeshIndices[lane], rays.TriangleIndices[lane]};
+	}
+
+	return rays.HitMask;
+}
+
+template class WideBvh<4>;
+template class WideBvh<8>;
@@ -43,7 +43,7 @@ private:
 	Resource m_DispatchIndirectArgsBB;
 	Resource m_ParticlesSB[FRAME_COUNT];
 	Resource m_DrawParticlesIndirectArgsBB[FRAME_COUNT];
-	Resource m_SimulationCB;
+	Resource m_SimulationCB[FRAME_COUNT];
 	Resource m_BackBufferCB;
 
 	virtual bool OnInit(HWND hWnd) override;
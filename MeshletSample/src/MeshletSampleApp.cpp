@@ -101,7 +101,7 @@ bool MeshletSampleApp::OnInit(HWND hWnd)
 			return false;
 		}
 
-		if (!ImGui_ImplDX12_Init(m_pDevice.Get(), 1, m_BackBufferFormat, m_pPool[POOL_TYPE_RES]->GetHeap(), pHandleSRV->HandleCPU, pHandleSRV->HandleGPU))
+		if (!ImGui_ImplDX12_Init(m_pDevice.Get(), FRAME_COUNT, m_BackBufferFormat, m_pPool[POOL_TYPE_RES]->GetHeap(), pHandleSRV->HandleCPU, pHandleSRV->HandleGPU))
 		{
 			ELOG("Error : ImGui_ImplDX12_Init() Failed.");
 			return false;
@@ -671,8 +671,9 @@ bool MeshletSampleApp::OnInit(HWND hWnd)
 	}
 
 	// 時間関係の定数バッファの作成
+	for (uint32_t i = 0u; i < FRAME_COUNT; i++)
 	{
-		if (!m_SimulationCB.InitAsConstantBuffer<CbSimulation>(
+		if (!m_SimulationCB[i].InitAsConstantBuffer<CbSimulation>(
 			m_pDevice.Get(),
 			D3D12_HEAP_TYPE_UPLOAD,
 			m_pPool[POOL_TYPE_RES]
@@ -682,10 +683,10 @@ bool MeshletSampleApp::OnInit(HWND hWnd)
 			return false;
 		}
 
-		CbSimulation* ptr = m_SimulationCB.Map<CbSimulation>();
+		CbSimulation* ptr = m_SimulationCB[i].Map<CbSimulation>();
 		ptr->DeltaTime = 0.0f;
 		ptr->InitialVelocityScale = 1.0f;
-		m_SimulationCB.Unmap();
+		m_SimulationCB[i].Unmap();
 	}
 
 	// バックバッファ描画用の定数バッファの作成
@@ -709,6 +710,8 @@ bool MeshletSampleApp::OnInit(HWND hWnd)
 	}
 
 	pCmd->Close();
+	// UploadBufferData()のコピーはアップロード用のリングのコマンドリストに記録されているので、先に実行する
+	m_UploadRing.Submit();
 	ID3D12CommandList* pLists[] = {pCmd};
 	m_pQueue->ExecuteCommandLists(1, pLists);
 	// Wait command queue finishing.
@@ -735,13 +738,13 @@ void MeshletSampleApp::OnTerm()
 	for (uint32_t i = 0; i < FRAME_COUNT; i++)
 	{
 		m_CameraCB[i].Term();
+		m_SimulationCB[i].Term();
 		m_ParticlesSB[i].Term();
 		m_DrawParticlesIndirectArgsBB[i].Term();
 	}
 
 	m_DispatchIndirectArgsBB.Term();
 
-	m_SimulationCB.Term();
 	m_BackBufferCB.Term();
 
 	m_SceneDepthTarget.Term();
@@ -805,6 +808,7 @@ void MeshletSampleApp::OnRender()
 
 	pCmd->Close();
 
+	m_UploadRing.Submit();
 	ID3D12CommandList* pLists[] = {pCmd};
 	m_pQueue->ExecuteCommandLists(1, pLists);
 
@@ -955,10 +959,10 @@ void MeshletSampleApp::UpdateParticles(ID3D12GraphicsCommandList* pCmdList, cons
 
 	// 定数バッファの更新
 	{
-		CbSimulation* ptr = m_SimulationCB.Map<CbSimulation>();
+		CbSimulation* ptr = m_SimulationCB[m_FrameIndex].Map<CbSimulation>();
 		ptr->DeltaTime = deltaTimeMS.count() / 1000.0f;
 		ptr->InitialVelocityScale = m_InitialVelocityScale;
-		m_SimulationCB.Unmap();
+		m_SimulationCB[m_FrameIndex].Unmap();
 	}
 
 	DirectX::TransitionResource(pCmdList, prevParticlesSB.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
@@ -969,7 +973,7 @@ void MeshletSampleApp::UpdateParticles(ID3D12GraphicsCommandList* pCmdList, cons
 	uint32_t rootConstants[2] = {m_NumSpawnPerFrame, m_InitialLife};
 	pCmdList->SetComputeRoot32BitConstants(0, 2, rootConstants, 0);
 
-	pCmdList->SetComputeRootDescriptorTable(1, m_SimulationCB.GetHandleCBV()->HandleGPU);
+	pCmdList->SetComputeRootDescriptorTable(1, m_SimulationCB[m_FrameIndex].GetHandleCBV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(2, prevParticlesSB.GetHandleSRV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(3, currParticlesSB.GetHandleUAV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(4, prevDrawParticlesArgsBB.GetHandleSRV()->HandleGPU);
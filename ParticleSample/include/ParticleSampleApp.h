@@ -2,10 +2,15 @@
 
 #include <SimpleMath.h>
 #include <chrono>
+#include <vector>
 #include "App.h"
 #include "Resource.h"
 #include "ColorTarget.h"
 #include "DepthTarget.h"
+#include "FixedTimestep.h"
+#include "ParticleReplay.h"
+#include "ParticleSimulator.h"
+#include "RadixSort.h"
 #include "RootSignature.h"
 #include "Texture.h"
 #include "TransformManipulator.h"
@@ -24,6 +29,15 @@ private:
 	uint32_t m_NumSpawnPerFrame = 512;
 	uint32_t m_InitialLife = 512;
 	float m_InitialVelocityScale = 1.0f;
+	// 生成の乱数のキー
+	uint32_t m_SimulationFrameIndex = 0;
+	uint32_t m_RandomSeed = 0;
+	// シミュレーションは固定の刻みで進め、描画はステップの間を補間する
+	FixedTimestep m_SimulationTimestep;
+	// m_ParticlesSBとm_DrawParticlesIndirectArgsBBのうち最後のステップの結果がある方
+	uint32_t m_CurrParticlesIdx = 0;
+	// RECORD_PARTICLE_REPLAYのときにステップごとの入力を記録する
+	ParticleReplay m_ParticleReplay;
 
 	std::chrono::high_resolution_clock::time_point m_PrevTime;
 	ComPtr<ID3D12PipelineState> m_pResetNumParticlesPSO;
@@ -43,17 +57,33 @@ private:
 	Resource m_DispatchIndirectArgsBB;
 	Resource m_ParticlesSB[FRAME_COUNT];
 	Resource m_DrawParticlesIndirectArgsBB[FRAME_COUNT];
-	Resource m_SimulationCB;
+	Resource m_SimulationCB[FRAME_COUNT];
 	Resource m_BackBufferCB;
 
+	// CPU_SORTED_PARTICLESのときにCPUでシミュレーションして奥から順に描画するためのもの
+	ParticleSimulator m_CpuParticles;
+	RadixSorter m_DepthSorter;
+	std::vector<uint32_t> m_DepthKeys;
+	std::vector<uint32_t> m_SortedIndices;
+	ComPtr<ID3D12PipelineState> m_pDrawSortedParticlesPSO;
+	RootSignature m_DrawSortedParticlesRootSig;
+	// いずれもUploadヒープで、フレームごとにCPUから書き込む
+	Resource m_CpuParticlesSB[FRAME_COUNT];
+	Resource m_SortedIndicesSB[FRAME_COUNT];
+	Resource m_CpuDrawParticlesIndirectArgsBB[FRAME_COUNT];
+
 	virtual bool OnInit(HWND hWnd) override;
 	virtual void OnTerm() override;
 	virtual void OnRender() override;
 	virtual bool OnMsgProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp) override;
 
 	void ResetNumParticles(ID3D12GraphicsCommandList* pCmdList, const Resource& prevDrawParticlesArgsBB, const Resource& currDrawParticlesArgsBB);
-	void UpdateParticles(ID3D12GraphicsCommandList* pCmdList, const Resource& prevParticlesSB, const Resource& currParticlesSB, const Resource& prevDrawParticlesArgsBB, const Resource& currDrawParticlesArgsBB, const std::chrono::milliseconds& deltaTimeMS);
+	ParticleUpdateDesc NextParticleUpdateDesc();
+	void UpdateParticles(ID3D12GraphicsCommandList* pCmdList, const Resource& prevParticlesSB, const Resource& currParticlesSB, const Resource& prevDrawParticlesArgsBB, const Resource& currDrawParticlesArgsBB, const ParticleUpdateDesc& desc);
 	void DrawParticles(ID3D12GraphicsCommandList* pCmdList, const Resource& currParticlesSB, const Resource& currDrawParticlesArgsBB);
+	bool InitCpuSortedParticles();
+	void UpdateCpuSortedParticles(const DirectX::SimpleMath::Matrix& view, uint32_t numSteps, float alpha);
+	void DrawSortedParticles(ID3D12GraphicsCommandList* pCmdList);
 	void DrawBackBuffer(ID3D12GraphicsCommandList* pCmdList);
 	void DrawImGui(ID3D12GraphicsCommandList* pCmdList);
 };
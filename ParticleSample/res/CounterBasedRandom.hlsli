@@ -0,0 +1,65 @@
+#ifndef COUNTER_BASED_RANDOM_HLSLI
+#define COUNTER_BASED_RANDOM_HLSLI
+
+// Counter-based random numbers with Philox4x32-10
+// (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC 2011).
+// Counter is (id, frame, stream, 0) and key is (seed, 0).
+// Must match Framework/include/CounterBasedRandom.h bit for bit.
+
+static const uint PHILOX_MULTIPLIER_0 = 0xD2511F53u;
+static const uint PHILOX_MULTIPLIER_1 = 0xCD9E8D57u;
+static const uint PHILOX_WEYL_0 = 0x9E3779B9u;
+static const uint PHILOX_WEYL_1 = 0xBB67AE85u;
+static const uint PHILOX_ROUNDS = 10;
+
+// Full 32x32 -> 64 bit product from 16-bit halves, so that 64-bit integer shader ops are not required
+void MultiplyHighLow(uint a, uint b, out uint high, out uint low)
+{
+	uint aLow = a & 0xffff;
+	uint aHigh = a >> 16;
+	uint bLow = b & 0xffff;
+	uint bHigh = b >> 16;
+
+	uint lowLow = aLow * bLow;
+	uint lowHigh = aLow * bHigh;
+	uint highLow = aHigh * bLow;
+	uint highHigh = aHigh * bHigh;
+
+	uint middle = (lowLow >> 16) + (lowHigh & 0xffff) + (highLow & 0xffff);
+	high = highHigh + (lowHigh >> 16) + (highLow >> 16) + (middle >> 16);
+	low = a * b;
+}
+
+uint4 GeneratePhilox4x32(uint4 counter, uint2 key)
+{
+	[unroll]
+	for (uint round = 0; round < PHILOX_ROUNDS; round++)
+	{
+		uint high0, low0, high1, low1;
+		MultiplyHighLow(PHILOX_MULTIPLIER_0, counter.x, high0, low0);
+		MultiplyHighLow(PHILOX_MULTIPLIER_1, counter.z, high1, low1);
+
+		counter = uint4(high1 ^ counter.y ^ key.x, low1, high0 ^ counter.w ^ key.y, low0);
+		key += uint2(PHILOX_WEYL_0, PHILOX_WEYL_1);
+	}
+
+	return counter;
+}
+
+uint4 GenerateRandom4(uint id, uint frame, uint stream, uint seed)
+{
+	return GeneratePhilox4x32(uint4(id, frame, stream, 0), uint2(seed, 0));
+}
+
+// Maps the upper 24 bits to [0, 1). Exact in float, so it matches RandomToUnitFloat() on the CPU.
+float RandomToUnitFloat(uint value)
+{
+	return float(value >> 8) * (1.0f / 16777216.0f);
+}
+
+float4 RandomToUnitFloat(uint4 value)
+{
+	return float4(value >> 8) * (1.0f / 16777216.0f);
+}
+
+#endif // COUNTER_BASED_RANDOM_HLSLI
@@ -7,12 +7,18 @@ struct CameraData
 {
 	float4x4 View;
 	float4x4 Proj;
+	float RewindTime;
+	uint SpawnLife;
 };
 #else
 cbuffer CbCamera : register(b0)
 {
 	float4x4 View : packoffset(c0);
 	float4x4 Proj : packoffset(c4);
+	// The simulation runs in fixed steps. Positions are moved back by Velocity * RewindTime to interpolate between the last two steps.
+	float RewindTime : packoffset(c8);
+	// Particles with Life >= SpawnLife were spawned in the last step and have no previous position.
+	uint SpawnLife : packoffset(c8.y);
 }
 #endif
 
@@ -20,8 +26,28 @@ cbuffer CbCamera : register(b0)
 StructuredBuffer<ParticleData> ParticlesData : register(t0);
 #endif
 
+// Defined by DrawSortedParticlesVS.hlsl. Instances are drawn in the order of SortedIndices.
+#ifdef USE_SORTED_INDICES
+#define ROOT_SIGNATURE ""\
+"RootFlags"\
+"("\
+"ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT"\
+" | DENY_HULL_SHADER_ROOT_ACCESS"\
+" | DENY_DOMAIN_SHADER_ROOT_ACCESS"\
+" | DENY_GEOMETRY_SHADER_ROOT_ACCESS"\
+")"\
+", DescriptorTable(CBV(b0), visibility = SHADER_VISIBILITY_VERTEX)"\
+", DescriptorTable(SRV(t0), visibility = SHADER_VISIBILITY_VERTEX)"\
+", DescriptorTable(SRV(t1), visibility = SHADER_VISIBILITY_VERTEX)"\
+
+StructuredBuffer<uint> SortedIndices : register(t1);
+#endif
+
 static const float SPRITE_EXTENT = 0.02f;
 
+#ifdef USE_SORTED_INDICES
+[RootSignature(ROOT_SIGNATURE)]
+#endif
 float4 main(uint instanceID : SV_InstanceID, uint vertexID : SV_VertexID) : SV_POSITION
 {
 #ifdef DYNAMIC_RESOURCES
@@ -30,7 +56,19 @@ float4 main(uint instanceID : SV_InstanceID, uint vertexID : SV_VertexID) : SV_P
 	StructuredBuffer<ParticleData> ParticlesData = ResourceDescriptorHeap[7];
 #endif
 
-	float3 particleWPos = ParticlesData[instanceID].Position;
+#ifdef USE_SORTED_INDICES
+	uint particleIdx = SortedIndices[instanceID];
+#else
+	uint particleIdx = instanceID;
+#endif
+
+	ParticleData particle = ParticlesData[particleIdx];
+#ifdef DYNAMIC_RESOURCES
+	float rewindTime = (particle.Life < CbCamera.SpawnLife) ? CbCamera.RewindTime : 0.0f;
+#else
+	float rewindTime = (particle.Life < SpawnLife) ? RewindTime : 0.0f;
+#endif
+	float3 particleWPos = particle.Position - particle.Velocity * rewindTime;
 #ifdef DYNAMIC_RESOURCES
 	float3 particleVPos = mul(CbCamera.View, float4(particleWPos, 1)).xyz;
 #else
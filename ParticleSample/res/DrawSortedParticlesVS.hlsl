@@ -0,0 +1,3 @@
+// DrawParticlesVS that reads particles through a sorted index list
+#define USE_SORTED_INDICES
+#include "DrawParticlesVS.hlsl"
@@ -1,7 +1,8 @@
 #include "Particle.hlsli"
+#include "CounterBasedRandom.hlsli"
 
 #define ROOT_SIGNATURE ""\
-"RootConstants(b0, num32BitConstants = 2)" \
+"RootConstants(b0, num32BitConstants = 4)" \
 ", DescriptorTable(CBV(b1))"\
 ", DescriptorTable(SRV(t0))"\
 ", DescriptorTable(UAV(u0))"\
@@ -10,6 +11,8 @@
 
 static const float GRAVITY = 9.8f;
 static const float PI = 3.14159265358979323f;
+// Must match ParticleSimulator.cpp
+static const uint RANDOM_STREAM_SPAWN = 0;
 
 #define USE_WAVE_INTRINSICS 1
 
@@ -17,6 +20,8 @@ cbuffer CbRootConstants : register(b0)
 {
 	uint NumSpawnPerFrame : packoffset(c0);
 	uint InitialLife : packoffset(c0.y);
+	uint FrameIndex : packoffset(c0.z);
+	uint RandomSeed : packoffset(c0.w);
 }
 
 cbuffer CbSimulation : register(b1)
@@ -35,11 +40,6 @@ groupshared uint gsNumParticleInGroup;
 groupshared uint gsGroupParticlesIdxOffset;
 #endif 
 
-float GetRandomNumberLegacy(float2 texCoord, int Seed)
-{
-    return frac(sin(dot(texCoord.xy, float2(12.9898, 78.233)) + Seed) * 43758.5453);
-}
-
 [RootSignature(ROOT_SIGNATURE)]
 [numthreads(NUM_THREAD_X, 1, 1)]
 void main(uint dtID : SV_DispatchThreadID, uint gtID : SV_GroupThreadID)
@@ -82,9 +82,12 @@ void main(uint dtID : SV_DispatchThreadID, uint gtID : SV_GroupThreadID)
 		// spawn
 		currData.Position = float3(0, 0, 0);
 
-		float randomVal = GetRandomNumberLegacy(0, dtID);
+		// Keyed by the spawn index, not dtID, so the result does not depend on how many particles survived
+		uint spawnIdx = dtID - prevNumParticles;
+		float2 randomVals = RandomToUnitFloat(GenerateRandom4(spawnIdx, FrameIndex, RANDOM_STREAM_SPAWN, RandomSeed).xy);
+		float randomVal = randomVals.x;
 		float sin, cos;
-		sincos(randomVal * 2 * PI, sin, cos);
+		sincos(randomVals.y * 2 * PI, sin, cos);
 		currData.Velocity = float3(cos, 2, sin) * randomVal * InitialVelocityScale;
 
 		currData.Life = InitialLife;
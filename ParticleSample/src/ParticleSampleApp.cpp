@@ -14,8 +14,33 @@
 #include "FileUtil.h"
 #include "Logger.h"
 #include "ScopedTimer.h"
+#include "ParallelFor.h"
+#include "ParticleSimulator.h"
+#include "ParticleReplay.h"
+#include "CounterBasedRandom.h"
+#include <algorithm>
+#include <bit>
+#include <numeric>
 
 //#define DYNAMIC_RESOURCES
+// コメントアウトを外すと起動時にCPUのパーティクルシミュレーションのスカラー版とAVX2版の結果が一致するかを検証してログに出す
+//#define VERIFY_CPU_PARTICLES
+// コメントアウトを外すと起動時にMAX_NUM_PARTICLES個のCPUのパーティクルシミュレーションのスループットを計測してログに出す
+//#define BENCHMARK_CPU_PARTICLES
+// コメントアウトを外すと起動時にパーティクルの生成に使うカウンタベースの乱数の既知の答え、スカラー版とAVX2版の一致、統計的な性質を検定してログに出す
+//#define VERIFY_COUNTER_BASED_RANDOM
+// コメントアウトを外すと起動時にカウンタベースの乱数のCPUでの生成のスループットを計測してログに出す
+//#define BENCHMARK_COUNTER_BASED_RANDOM
+// コメントアウトを外すと起動時にMAX_NUM_PARTICLES個のパーティクルの深度の基数ソートとstd::sortの時間を計測してログに出す
+//#define BENCHMARK_PARTICLE_SORT
+// コメントアウトを外すとGPUの代わりにCPUでパーティクルをシミュレーションし、深度の基数ソートで奥から順に並べたインデックスで描画する
+//#define CPU_SORTED_PARTICLES
+// コメントアウトを外すとシミュレーションのステップごとの入力を記録し、終了時にPARTICLE_REPLAY_FILENAMEに書き出す
+//#define RECORD_PARTICLE_REPLAY
+// コメントアウトを外すと起動時に記録した入力をCPUで再生し、SIMDのモードとスレッド数、スナップショットからの再開によらず結果が一致するかと、期待値のハッシュとの一致を検証してログに出す
+//#define VERIFY_PARTICLE_REPLAY
+// コメントアウトを外すと起動時に記録した入力をCPUで描画なしで再生し、ステップあたりの更新とスナップショットの保存と復元の時間を計測してログに出す
+//#define BENCHMARK_PARTICLE_REPLAY
 
 using namespace DirectX::SimpleMath;
 
@@ -29,6 +54,10 @@ namespace
 	static constexpr Vector3 CAMERA_START_TARGET = Vector3(0.0f, 1.0f, 0.0f);
 
 	static constexpr uint32_t MAX_NUM_PARTICLES = 1024 * 1024;
+	// シミュレーションの固定の刻み。1フレームでこれ以上のステップ数が必要な分の時間は捨てる
+	static constexpr double SIMULATION_STEP_TIME = 1.0 / 60.0;
+	static constexpr uint32_t MAX_SIMULATION_STEPS_PER_FRAME = 4;
+	static constexpr const wchar_t* PARTICLE_REPLAY_FILENAME = L"ParticleReplay.bin";
 	// シェーダ側と合わせている
 	static const size_t NUM_THREAD_X = 64;
 
@@ -36,13 +65,10 @@ namespace
 	{
 		Matrix View;
 		Matrix Proj;
-	};
-
-	struct ParticleData
-	{
-		Vector3 Position;
-		Vector3 Velocity;
-		uint32_t Life;
+		// 描画する位置を速度 * RewindTimeだけ戻して、直前の2ステップの間を補間する
+		float RewindTime;
+		// Life >= SpawnLifeのパーティクルは直前のステップで生成したので補間しない
+		uint32_t SpawnLife;
 	};
 
 	struct alignas(256) CbSimulation
@@ -64,6 +90,729 @@ namespace
 	{
 		return (dividend + divisor - 1) / divisor;
 	}
+
+#ifdef VERIFY_CPU_PARTICLES
+	void VerifyCpuParticles()
+	{
+		static constexpr uint32_t NUM_FRAMES = 600;
+
+		ParticleSimulator scalar;
+		ParticleSimulator avx2;
+		if (!scalar.Init(MAX_NUM_PARTICLES) || !avx2.Init(MAX_NUM_PARTICLES))
+		{
+			ELOG("Error : ParticleSimulator::Init() Failed.");
+			return;
+		}
+
+		scalar.SetSIMDMode(PARTICLE_SIMD_MODE_SCALAR);
+		if (!avx2.SetSIMDMode(PARTICLE_SIMD_MODE_AVX2))
+		{
+			ELOG("Verify CPU Particles : AVX2 is not supported.");
+			return;
+		}
+
+		std::vector<ParticleData> scalarParticles;
+		std::vector<ParticleData> avx2Particles;
+
+		for (uint32_t frame = 0; frame < NUM_FRAMES; frame++)
+		{
+			// 生成数と寿命をフレームごとに変えて、チャンクの端数や全滅するチャンクも通るようにする
+			ParticleUpdateDesc desc;
+			desc.NumSpawnPerFrame = 1 + (frame * 7919) % 8192;
+			desc.InitialLife = 1 + (frame * 31) % 256;
+			desc.DeltaTime = 1.0f / 60.0f;
+			desc.InitialVelocityScale = 1.0f;
+			desc.FrameIndex = frame;
+			desc.RandomSeed = 0;
+
+			scalar.Update(desc);
+			avx2.Update(desc);
+
+			scalarParticles.resize(scalar.GetNumParticles());
+			scalar.CopyParticles(scalarParticles.data());
+			avx2Particles.resize(avx2.GetNumParticles());
+			avx2.CopyParticles(avx2Particles.data());
+
+			if (scalarParticles.size() != avx2Particles.size()
+				|| memcmp(scalarParticles.data(), avx2Particles.data(), scalarParticles.size() * sizeof(ParticleData)) != 0)
+			{
+				ELOG("Verify CPU Particles : Mismatch at frame %u. scalar %zu, avx2 %zu", frame, scalarParticles.size(), avx2Particles.size());
+				return;
+			}
+		}
+
+		ELOG("Verify CPU Particles : OK. %u frames, %u particles", NUM_FRAMES, scalar.GetNumParticles());
+	}
+#endif
+
+#ifdef BENCHMARK_CPU_PARTICLES
+	void BenchmarkCpuParticles()
+	{
+		static constexpr uint32_t NUM_ITERATIONS = 100;
+		// MAX_NUM_PARTICLESに達したあとも毎フレーム一定数が死んで生成される定常状態にする
+		static constexpr uint32_t NUM_SPAWN_PER_FRAME = 8192;
+		static constexpr uint32_t INITIAL_LIFE = MAX_NUM_PARTICLES / NUM_SPAWN_PER_FRAME;
+
+		static constexpr PARTICLE_SIMD_MODE SIMD_MODES[] = {PARTICLE_SIMD_MODE_SCALAR, PARTICLE_SIMD_MODE_AVX2};
+		static const char* SIMD_MODE_NAMES[] = {"Scalar", "AVX2"};
+
+		ParticleUpdateDesc desc;
+		desc.NumSpawnPerFrame = NUM_SPAWN_PER_FRAME;
+		desc.InitialLife = INITIAL_LIFE;
+		desc.DeltaTime = 1.0f / 60.0f;
+		desc.InitialVelocityScale = 1.0f;
+		desc.FrameIndex = 0;
+		desc.RandomSeed = 0;
+
+		for (uint32_t modeIdx = 0; modeIdx < _countof(SIMD_MODES); modeIdx++)
+		{
+			for (bool multithreaded : {false, true})
+			{
+				ParticleSimulator simulator;
+				if (!simulator.Init(MAX_NUM_PARTICLES))
+				{
+					ELOG("Error : ParticleSimulator::Init() Failed.");
+					return;
+				}
+
+				if (!simulator.SetSIMDMode(SIMD_MODES[modeIdx]))
+				{
+					ELOG("Benchmark CPU Particles : %s is not supported.", SIMD_MODE_NAMES[modeIdx]);
+					continue;
+				}
+				simulator.SetMultithreaded(multithreaded);
+
+				// ウォームアップを兼ねて定常状態まで進める
+				for (uint32_t i = 0; i <= INITIAL_LIFE; i++)
+				{
+					simulator.Update(desc);
+					desc.FrameIndex++;
+				}
+
+				const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+				for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+				{
+					simulator.Update(desc);
+					desc.FrameIndex++;
+				}
+				const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+				double msec = std::chrono::duration<double, std::milli>(end - start).count() / NUM_ITERATIONS;
+				uint32_t numThreads = multithreaded ? GetParallelForThreadCount() : 1;
+				double particlesPerMsec = simulator.GetNumParticles() / msec;
+				ELOG("CPU Particles %s : %u particles, %u threads, Update %.3f ms, %.0f particles/ms, %.0f particles/ms/core",
+					SIMD_MODE_NAMES[modeIdx],
+					simulator.GetNumParticles(),
+					numThreads,
+					msec,
+					particlesPerMsec,
+					particlesPerMsec / numThreads);
+			}
+		}
+	}
+#endif
+
+#ifdef VERIFY_COUNTER_BASED_RANDOM
+	// 検定統計量を標準正規分布に従うように変換した値の許容範囲
+	static constexpr double RANDOM_TEST_MAX_Z = 5.0;
+
+	bool CheckRandomTest(const char* name, double z)
+	{
+		bool isPassed = fabs(z) < RANDOM_TEST_MAX_Z;
+		ELOG("Verify Counter Based Random : %s z = %.3f %s", name, z, isPassed ? "OK" : "NG");
+		return isPassed;
+	}
+
+	// 無相関なら相関係数のsqrt(count)倍は標準正規分布に従う
+	double GetCorrelationZ(const float* pA, const float* pB, uint32_t count)
+	{
+		double sumA = 0.0;
+		double sumB = 0.0;
+		double sumAA = 0.0;
+		double sumBB = 0.0;
+		double sumAB = 0.0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			sumA += pA[i];
+			sumB += pB[i];
+			sumAA += static_cast<double>(pA[i]) * pA[i];
+			sumBB += static_cast<double>(pB[i]) * pB[i];
+			sumAB += static_cast<double>(pA[i]) * pB[i];
+		}
+
+		double covariance = sumAB / count - (sumA / count) * (sumB / count);
+		double varianceA = sumAA / count - (sumA / count) * (sumA / count);
+		double varianceB = sumBB / count - (sumB / count) * (sumB / count);
+		return covariance / sqrt(varianceA * varianceB) * sqrt(static_cast<double>(count));
+	}
+
+	void VerifyCounterBasedRandom()
+	{
+		static constexpr uint32_t NUM_SAMPLES = 1 << 22;
+		static constexpr uint32_t NUM_BINS = 256;
+		static constexpr uint32_t NUM_AVALANCHE_SAMPLES = 1 << 14;
+		static constexpr uint32_t FRAME = 100;
+		static constexpr uint32_t SEED = 0;
+
+		bool isPassed = true;
+
+		// Random123のPhilox4x32-10の既知の答え
+		{
+			struct KnownAnswer
+			{
+				uint32_t Counter[4];
+				uint32_t Key[2];
+				uint32_t Result[4];
+			};
+
+			static const KnownAnswer KNOWN_ANSWERS[] =
+			{
+				{{0, 0, 0, 0}, {0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+				{{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}, {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+				{{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}, {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+			};
+
+			for (const KnownAnswer& answer : KNOWN_ANSWERS)
+			{
+				uint32_t result[4];
+				GeneratePhilox4x32(answer.Counter, answer.Key, result);
+				if (memcmp(result, answer.Result, sizeof(result)) != 0)
+				{
+					ELOG("Verify Counter Based Random : Known answer mismatch. %08x %08x %08x %08x", result[0], result[1], result[2], result[3]);
+					isPassed = false;
+				}
+			}
+		}
+
+		// スカラー版とAVX2版の一致。端数も通るよう8の倍数でない数にする
+		{
+			static constexpr uint32_t NUM_VALUES = NUM_SAMPLES - 3;
+
+			std::vector<uint32_t> scalarValues[4];
+			std::vector<uint32_t> avx2Values[4];
+			uint32_t* pScalarValues[4];
+			uint32_t* pAVX2Values[4];
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				scalarValues[i].resize(NUM_VALUES);
+				avx2Values[i].resize(NUM_VALUES);
+				pScalarValues[i] = scalarValues[i].data();
+				pAVX2Values[i] = avx2Values[i].data();
+			}
+
+			GenerateRandomBatch(5, NUM_VALUES, FRAME, 0, SEED, pScalarValues, false);
+			GenerateRandomBatch(5, NUM_VALUES, FRAME, 0, SEED, pAVX2Values, true);
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				if (scalarValues[i] != avx2Values[i])
+				{
+					ELOG("Verify Counter Based Random : Scalar and AVX2 mismatch.");
+					isPassed = false;
+					break;
+				}
+			}
+		}
+
+		// (ID, フレーム, ストリーム)を1つずつずらした系列。相関の検定に使う
+		static constexpr uint32_t NUM_SEQUENCES = 4;
+		static const char* SEQUENCE_NAMES[NUM_SEQUENCES] = {"Base", "Next ID", "Next Frame", "Next Stream"};
+		std::vector<float> values[NUM_SEQUENCES][4];
+		for (uint32_t s = 0; s < NUM_SEQUENCES; s++)
+		{
+			float* pValues[4];
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				values[s][i].resize(NUM_SAMPLES);
+				pValues[i] = values[s][i].data();
+			}
+
+			uint32_t firstId = (s == 1) ? 1 : 0;
+			uint32_t frame = (s == 2) ? FRAME + 1 : FRAME;
+			uint32_t stream = (s == 3) ? 1 : 0;
+			GenerateRandomUnitFloatBatch(firstId, NUM_SAMPLES, frame, stream, SEED, pValues, true);
+		}
+
+		// 出力ごとの平均、分散、区間の度数のカイ二乗と、各ビットが1になる割合
+		std::vector<uint32_t> bits(NUM_SAMPLES);
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			const std::vector<float>& v = values[0][i];
+
+			double sum = 0.0;
+			double sumSq = 0.0;
+			uint32_t binCounts[NUM_BINS] = {};
+			for (float value : v)
+			{
+				sum += value;
+				sumSq += static_cast<double>(value) * value;
+				binCounts[static_cast<uint32_t>(value * NUM_BINS)]++;
+			}
+
+			// 一様分布の分散は1/12、標本分散の分散は(1/80 - 1/144) / n = 1 / (180n)
+			double mean = sum / NUM_SAMPLES;
+			double variance = sumSq / NUM_SAMPLES - mean * mean;
+			double meanZ = (mean - 0.5) / sqrt(1.0 / (12.0 * NUM_SAMPLES));
+			double varianceZ = (variance - 1.0 / 12.0) / sqrt(1.0 / (180.0 * NUM_SAMPLES));
+
+			double expected = static_cast<double>(NUM_SAMPLES) / NUM_BINS;
+			double chiSquare = 0.0;
+			for (uint32_t count : binCounts)
+			{
+				chiSquare += (count - expected) * (count - expected) / expected;
+			}
+			double chiSquareZ = (chiSquare - (NUM_BINS - 1)) / sqrt(2.0 * (NUM_BINS - 1));
+
+			// 下位8ビットはfloatにすると落ちるので整数で調べる
+			uint32_t* pBits[4] = {};
+			pBits[i] = bits.data();
+			GenerateRandomBatch(0, NUM_SAMPLES, FRAME, 0, SEED, pBits, true);
+			double maxBitZ = 0.0;
+			for (uint32_t b = 0; b < 32; b++)
+			{
+				uint32_t oneCount = 0;
+				for (uint32_t value : bits)
+				{
+					oneCount += (value >> b) & 1;
+				}
+				double bitZ = (oneCount - NUM_SAMPLES * 0.5) / sqrt(NUM_SAMPLES * 0.25);
+				maxBitZ = (fabs(bitZ) > fabs(maxBitZ)) ? bitZ : maxBitZ;
+			}
+
+			char name[64];
+			sprintf_s(name, "Output %u Mean %.6f", i, mean);
+			isPassed &= CheckRandomTest(name, meanZ);
+			sprintf_s(name, "Output %u Variance %.6f", i, variance);
+			isPassed &= CheckRandomTest(name, varianceZ);
+			sprintf_s(name, "Output %u Chi-Square %.1f", i, chiSquare);
+			isPassed &= CheckRandomTest(name, chiSquareZ);
+			sprintf_s(name, "Output %u Worst Bit", i);
+			isPassed &= CheckRandomTest(name, maxBitZ);
+		}
+
+		// 隣り合うID、フレーム、ストリームとの相関と、出力どうしの相関
+		for (uint32_t s = 1; s < NUM_SEQUENCES; s++)
+		{
+			char name[64];
+			sprintf_s(name, "Correlation with %s", SEQUENCE_NAMES[s]);
+			isPassed &= CheckRandomTest(name, GetCorrelationZ(values[0][0].data(), values[s][0].data(), NUM_SAMPLES));
+		}
+		for (uint32_t i = 1; i < 4; i++)
+		{
+			char name[64];
+			sprintf_s(name, "Correlation of Output 0 and %u", i);
+			isPassed &= CheckRandomTest(name, GetCorrelationZ(values[0][0].data(), values[0][i].data(), NUM_SAMPLES));
+		}
+
+		// アバランシェ。IDとフレームの1ビットを反転すると、128ビットの出力のうち平均64ビットが二項分布で反転する
+		double maxAvalancheZ = 0.0;
+		for (uint32_t inputBit = 0; inputBit < 64; inputBit++)
+		{
+			uint64_t flipCount = 0;
+			for (uint32_t i = 0; i < NUM_AVALANCHE_SAMPLES; i++)
+			{
+				uint32_t id = i * 2654435761u;
+				uint32_t frame = FRAME + i;
+				uint32_t base[4];
+				uint32_t flipped[4];
+				GenerateRandom4(id, frame, 0, SEED, base);
+				if (inputBit < 32)
+				{
+					GenerateRandom4(id ^ (1u << inputBit), frame, 0, SEED, flipped);
+				}
+				else
+				{
+					GenerateRandom4(id, frame ^ (1u << (inputBit - 32)), 0, SEED, flipped);
+				}
+
+				for (uint32_t j = 0; j < 4; j++)
+				{
+					flipCount += std::popcount(base[j] ^ flipped[j]);
+				}
+			}
+
+			double avalancheZ = (static_cast<double>(flipCount) / NUM_AVALANCHE_SAMPLES - 64.0) / sqrt(32.0 / NUM_AVALANCHE_SAMPLES);
+			maxAvalancheZ = (fabs(avalancheZ) > fabs(maxAvalancheZ)) ? avalancheZ : maxAvalancheZ;
+		}
+		isPassed &= CheckRandomTest("Worst Avalanche", maxAvalancheZ);
+
+		ELOG("Verify Counter Based Random : %s. %u samples", isPassed ? "OK" : "NG", NUM_SAMPLES);
+	}
+#endif
+
+#ifdef BENCHMARK_COUNTER_BASED_RANDOM
+	void BenchmarkCounterBasedRandom()
+	{
+		static constexpr uint32_t NUM_IDS = 1 << 22;
+		static constexpr uint32_t NUM_ITERATIONS = 20;
+		static constexpr uint32_t GRAIN_SIZE = 16384;
+
+		std::vector<float> values[4];
+		float* pValues[4];
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			values[i].resize(NUM_IDS);
+			pValues[i] = values[i].data();
+		}
+
+		for (bool useAVX2 : {false, true})
+		{
+			for (bool multithreaded : {false, true})
+			{
+				auto generate = [&](uint32_t frame)
+				{
+					if (!multithreaded)
+					{
+						GenerateRandomUnitFloatBatch(0, NUM_IDS, frame, 0, 0, pValues, useAVX2);
+						return;
+					}
+
+					ParallelFor(NUM_IDS, GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+					{
+						float* const pChunkValues[4] = {pValues[0] + begin, pValues[1] + begin, pValues[2] + begin, pValues[3] + begin};
+						GenerateRandomUnitFloatBatch(begin, end - begin, frame, 0, 0, pChunkValues, useAVX2);
+					});
+				};
+
+				// ウォームアップ
+				generate(0);
+
+				const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+				for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+				{
+					generate(i + 1);
+				}
+				const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+				double msec = std::chrono::duration<double, std::milli>(end - start).count() / NUM_ITERATIONS;
+				uint32_t numThreads = multithreaded ? GetParallelForThreadCount() : 1;
+				// 1つのIDから4つの乱数を生成する
+				double numbersPerSec = 4.0 * NUM_IDS / (msec / 1000.0);
+				ELOG("Counter Based Random %s : %u threads, %.3f ms, %.1f M numbers/s, %.1f M numbers/s/core",
+					useAVX2 ? "AVX2" : "Scalar",
+					numThreads,
+					msec,
+					numbersPerSec / 1000000.0,
+					numbersPerSec / 1000000.0 / numThreads);
+			}
+		}
+	}
+#endif
+
+#ifdef BENCHMARK_PARTICLE_SORT
+	void BenchmarkParticleSort()
+	{
+		static constexpr uint32_t NUM_ITERATIONS = 20;
+		static constexpr uint32_t NUM_SPAWN_PER_FRAME = 8192;
+		static constexpr uint32_t INITIAL_LIFE = MAX_NUM_PARTICLES / NUM_SPAWN_PER_FRAME;
+
+		ParticleSimulator simulator;
+		if (!simulator.Init(MAX_NUM_PARTICLES))
+		{
+			ELOG("Error : ParticleSimulator::Init() Failed.");
+			return;
+		}
+
+		// MAX_NUM_PARTICLES個まで撒いて、初期位置のカメラから見た深度をキーにする
+		ParticleUpdateDesc desc;
+		desc.NumSpawnPerFrame = NUM_SPAWN_PER_FRAME;
+		desc.InitialLife = INITIAL_LIFE;
+		desc.DeltaTime = 1.0f / 60.0f;
+		desc.InitialVelocityScale = 1.0f;
+		desc.RandomSeed = 0;
+		for (uint32_t i = 0; i <= INITIAL_LIFE; i++)
+		{
+			desc.FrameIndex = i;
+			simulator.Update(desc);
+		}
+
+		uint32_t numParticles = simulator.GetNumParticles();
+		const Matrix& view = Matrix::CreateLookAt(CAMERA_START_POSITION, CAMERA_START_TARGET, Vector3::UnitY);
+		std::vector<uint32_t> depthKeys(numParticles);
+		simulator.ComputeViewDepthKeys(view, 1.0f, true, depthKeys.data());
+
+		std::vector<uint32_t> keys(numParticles);
+		std::vector<uint32_t> indices(numParticles);
+		RadixSorter sorter;
+		uint32_t numThreadsList[] = {1, GetParallelForThreadCount()};
+
+		for (uint32_t numThreads : numThreadsList)
+		{
+			sorter.SetMultithreaded(numThreads > 1);
+
+			double totalMsec = 0.0;
+			for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+			{
+				keys = depthKeys;
+				std::iota(indices.begin(), indices.end(), 0);
+
+				const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+				sorter.Sort(numParticles, keys.data(), indices.data());
+				const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+				totalMsec += std::chrono::duration<double, std::milli>(end - start).count();
+			}
+
+			ELOG("Particle Sort Radix : %u particles, %u threads, %u passes, %.3f ms", numParticles, numThreads, sorter.GetLastPassCount(), totalMsec / NUM_ITERATIONS);
+		}
+
+		// std::sortはキーを上位、インデックスを下位に詰めた64ビットで比べる。基数ソートは安定なので結果は一致する
+		std::vector<uint64_t> pairs(numParticles);
+		double totalMsec = 0.0;
+		for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+		{
+			for (uint32_t j = 0; j < numParticles; j++)
+			{
+				pairs[j] = (static_cast<uint64_t>(depthKeys[j]) << 32) | j;
+			}
+
+			const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+			std::sort(pairs.begin(), pairs.end());
+			const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+			totalMsec += std::chrono::duration<double, std::milli>(end - start).count();
+		}
+
+		ELOG("Particle Sort std::sort : %u particles, 1 threads, %.3f ms", numParticles, totalMsec / NUM_ITERATIONS);
+
+		for (uint32_t i = 0; i < numParticles; i++)
+		{
+			if (indices[i] != static_cast<uint32_t>(pairs[i]))
+			{
+				ELOG("Particle Sort : Mismatch at %u.", i);
+				return;
+			}
+		}
+	}
+#endif
+
+#if defined(VERIFY_PARTICLE_REPLAY) || defined(BENCHMARK_PARTICLE_REPLAY)
+	// RECORD_PARTICLE_REPLAYで記録したファイルを読み込む。見つからなければ、生成数と寿命を変えながら撒く入力列を作ってpathを空にする
+	bool LoadParticleReplay(ParticleReplay& replay, std::wstring& path)
+	{
+		static constexpr uint32_t NUM_GENERATED_STEPS = 600;
+
+		if (SearchFilePath(PARTICLE_REPLAY_FILENAME, path))
+		{
+			if (!replay.Load(path.c_str()))
+			{
+				ELOG("Error : ParticleReplay::Load() Failed.");
+				return false;
+			}
+			return true;
+		}
+
+		path.clear();
+		replay.BeginRecording(MAX_NUM_PARTICLES);
+		for (uint32_t step = 0; step < NUM_GENERATED_STEPS; step++)
+		{
+			ParticleUpdateDesc desc;
+			desc.NumSpawnPerFrame = 1 + (step * 7919) % 8192;
+			desc.InitialLife = 1 + (step * 31) % 512;
+			desc.DeltaTime = static_cast<float>(SIMULATION_STEP_TIME);
+			desc.InitialVelocityScale = 1.0f;
+			desc.FrameIndex = step;
+			desc.RandomSeed = 0;
+			replay.RecordStep(desc);
+		}
+		return true;
+	}
+#endif
+
+#ifdef VERIFY_PARTICLE_REPLAY
+	void VerifyParticleReplay()
+	{
+		ParticleReplay replay;
+		std::wstring path;
+		if (!LoadParticleReplay(replay, path))
+		{
+			return;
+		}
+
+		uint32_t stepCount = replay.GetStepCount();
+		uint32_t snapshotStep = stepCount / 2;
+		bool isPassed = true;
+
+		// 基準はスカラー版の1スレッド。途中のスナップショットも取っておく
+		ParticleSimulator reference;
+		if (!replay.Restart(reference))
+		{
+			return;
+		}
+		reference.SetSIMDMode(PARTICLE_SIMD_MODE_SCALAR);
+		reference.SetMultithreaded(false);
+
+		std::vector<uint8_t> snapshot;
+		replay.Play(reference, 0, snapshotStep);
+		reference.SaveSnapshot(snapshot);
+		replay.Play(reference, snapshotStep, stepCount);
+		uint64_t referenceHash = reference.ComputeStateHash();
+
+		// 使えるなら既定のAVX2、マルチスレッドで最初から再生する
+		ParticleSimulator simulator;
+		if (!replay.Restart(simulator))
+		{
+			return;
+		}
+		replay.Play(simulator, 0, stepCount);
+		uint64_t hash = simulator.ComputeStateHash();
+		if (hash != referenceHash)
+		{
+			ELOG("Verify Particle Replay : Mismatch from start. %016llx, reference %016llx", hash, referenceHash);
+			isPassed = false;
+		}
+
+		// スナップショットから再開する
+		if (!simulator.LoadSnapshot(snapshot.data(), snapshot.size()))
+		{
+			return;
+		}
+		replay.Play(simulator, snapshotStep, stepCount);
+		hash = simulator.ComputeStateHash();
+		if (hash != referenceHash)
+		{
+			ELOG("Verify Particle Replay : Mismatch from snapshot at step %u. %016llx, reference %016llx", snapshotStep, hash, referenceHash);
+			isPassed = false;
+		}
+
+		// 期待値がなければ今回の結果を期待値としてファイルに書き込み、次回以降の回帰テストに使う
+		if (replay.HasExpectedHash())
+		{
+			if (replay.GetExpectedHash() != referenceHash)
+			{
+				ELOG("Verify Particle Replay : Regression. %016llx, expected %016llx", referenceHash, replay.GetExpectedHash());
+				isPassed = false;
+			}
+		}
+		else if (isPassed && !path.empty())
+		{
+			replay.SetExpectedHash(referenceHash);
+			if (replay.Save(path.c_str()))
+			{
+				ELOG("Verify Particle Replay : Expected hash %016llx is saved to %ls", referenceHash, path.c_str());
+			}
+		}
+
+		ELOG("Verify Particle Replay : %s. %u steps, %u particles, hash %016llx", isPassed ? "OK" : "NG", stepCount, reference.GetNumParticles(), referenceHash);
+	}
+#endif
+
+#ifdef BENCHMARK_PARTICLE_REPLAY
+	void BenchmarkParticleReplay()
+	{
+		static constexpr uint32_t NUM_SNAPSHOT_ITERATIONS = 20;
+
+		ParticleReplay replay;
+		std::wstring path;
+		if (!LoadParticleReplay(replay, path))
+		{
+			return;
+		}
+
+		static constexpr PARTICLE_SIMD_MODE SIMD_MODES[] = {PARTICLE_SIMD_MODE_SCALAR, PARTICLE_SIMD_MODE_AVX2};
+		static const char* SIMD_MODE_NAMES[] = {"Scalar", "AVX2"};
+		uint32_t stepCount = replay.GetStepCount();
+
+		ParticleSimulator simulator;
+		for (uint32_t modeIdx = 0; modeIdx < _countof(SIMD_MODES); modeIdx++)
+		{
+			for (bool multithreaded : {false, true})
+			{
+				if (!replay.Restart(simulator))
+				{
+					return;
+				}
+
+				if (!simulator.SetSIMDMode(SIMD_MODES[modeIdx]))
+				{
+					ELOG("Benchmark Particle Replay : %s is not supported.", SIMD_MODE_NAMES[modeIdx]);
+					continue;
+				}
+				simulator.SetMultithreaded(multithreaded);
+
+				const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+				replay.Play(simulator, 0, stepCount);
+				const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+				double msec = std::chrono::duration<double, std::milli>(end - start).count();
+				ELOG("Particle Replay %s : %u steps, %u threads, Total %.3f ms, %.3f ms/step, %u particles, hash %016llx",
+					SIMD_MODE_NAMES[modeIdx],
+					stepCount,
+					multithreaded ? GetParallelForThreadCount() : 1,
+					msec,
+					msec / stepCount,
+					simulator.GetNumParticles(),
+					simulator.ComputeStateHash());
+			}
+		}
+
+		// 最後の状態でスナップショットの保存と復元
+		std::vector<uint8_t> snapshot;
+		double saveMsec = 0.0;
+		double loadMsec = 0.0;
+		for (uint32_t i = 0; i < NUM_SNAPSHOT_ITERATIONS; i++)
+		{
+			const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+			simulator.SaveSnapshot(snapshot);
+			const std::chrono::steady_clock::time_point& mid = std::chrono::steady_clock::now();
+			simulator.LoadSnapshot(snapshot.data(), snapshot.size());
+			const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+			saveMsec += std::chrono::duration<double, std::milli>(mid - start).count();
+			loadMsec += std::chrono::duration<double, std::milli>(end - mid).count();
+		}
+
+		ELOG("Particle Snapshot : %u particles, %zu bytes, Save %.3f ms, Load %.3f ms",
+			simulator.GetNumParticles(),
+			snapshot.size(),
+			saveMsec / NUM_SNAPSHOT_ITERATIONS,
+			loadMsec / NUM_SNAPSHOT_ITERATIONS);
+	}
+#endif
+
+	// CPUから毎フレーム書き込むUploadヒープのバッファ。srvStrideが0ならSRVは作らない
+	bool InitUploadBuffer(Resource& resource, ID3D12Device* pDevice, DescriptorPool* pPoolSRV, size_t size, uint32_t srvStride)
+	{
+		D3D12_HEAP_PROPERTIES heapProp = {};
+		heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+		heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		heapProp.CreationNodeMask = 1;
+		heapProp.VisibleNodeMask = 1;
+
+		D3D12_RESOURCE_DESC desc = {};
+		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		desc.Alignment = 0;
+		desc.Width = static_cast<UINT64>(size);
+		desc.Height = 1;
+		desc.DepthOrArraySize = 1;
+		desc.MipLevels = 1;
+		desc.Format = DXGI_FORMAT_UNKNOWN;
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = (srvStride > 0) ? static_cast<UINT>(size / srvStride) : 0;
+		srvDesc.Buffer.StructureByteStride = srvStride;
+		srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+		D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+
+		// Uploadヒープのリソースは作成時からGENERIC_READでなければならない
+		return resource.Init(
+			pDevice,
+			heapProp,
+			desc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			(srvStride > 0) ? pPoolSRV : nullptr,
+			srvDesc,
+			nullptr,
+			nullptr,
+			uavDesc
+		);
+	}
 }
 
 ParticleSampleApp::ParticleSampleApp(uint32_t width, uint32_t height)
@@ -77,6 +826,39 @@ ParticleSampleApp::~ParticleSampleApp()
 
 bool ParticleSampleApp::OnInit(HWND hWnd)
 {
+#ifdef VERIFY_CPU_PARTICLES
+	VerifyCpuParticles();
+#endif
+
+#ifdef BENCHMARK_CPU_PARTICLES
+	BenchmarkCpuParticles();
+#endif
+
+#ifdef VERIFY_COUNTER_BASED_RANDOM
+	VerifyCounterBasedRandom();
+#endif
+
+#ifdef BENCHMARK_COUNTER_BASED_RANDOM
+	BenchmarkCounterBasedRandom();
+#endif
+
+#ifdef BENCHMARK_PARTICLE_SORT
+	BenchmarkParticleSort();
+#endif
+
+#ifdef VERIFY_PARTICLE_REPLAY
+	VerifyParticleReplay();
+#endif
+
+#ifdef BENCHMARK_PARTICLE_REPLAY
+	BenchmarkParticleReplay();
+#endif
+
+	m_SimulationTimestep.Init(SIMULATION_STEP_TIME, MAX_SIMULATION_STEPS_PER_FRAME);
+#ifdef RECORD_PARTICLE_REPLAY
+	m_ParticleReplay.BeginRecording(MAX_NUM_PARTICLES);
+#endif
+
 	m_CameraManipulator.Reset(CAMERA_START_POSITION, CAMERA_START_TARGET);
 
 	// imgui初期化
@@ -94,14 +876,14 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 			return false;
 		}
 
-		DescriptorHandle* pHandleSRV = m_pPool[POOL_TYPE_RES]->AllocHandle();
+		DescriptorHandle* pHandleSRV = m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->AllocHandle();
 		if (pHandleSRV == nullptr)
 		{
 			ELOG("Error : DescriptorPool::AllocHandle() Failed.");
 			return false;
 		}
 
-		if (!ImGui_ImplDX12_Init(m_pDevice.Get(), 1, m_BackBufferFormat, m_pPool[POOL_TYPE_RES]->GetHeap(), pHandleSRV->HandleCPU, pHandleSRV->HandleGPU))
+		if (!ImGui_ImplDX12_Init(m_pDevice.Get(), FRAME_COUNT, m_BackBufferFormat, m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->GetHeap(), pHandleSRV->HandleCPU, pHandleSRV->HandleGPU))
 		{
 			ELOG("Error : ImGui_ImplDX12_Init() Failed.");
 			return false;
@@ -148,7 +930,7 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 		(
 			m_pDevice.Get(),
 			m_pPool[POOL_TYPE_DSV],
-			m_pPool[POOL_TYPE_RES],
+			m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
 			m_Width,
 			m_Height,
 			DXGI_FORMAT_D32_FLOAT,
@@ -169,10 +951,10 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 		(
 			m_pDevice.Get(),
 			m_pPool[POOL_TYPE_RTV],
-			m_pPool[POOL_TYPE_RES],
+			m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
 			m_Width,
 			m_Height,
-			m_ColorTarget[0].GetRTVDesc().Format,
+			m_BackBuffer[0].GetRTVDesc().Format,
 			clearColor
 		))
 		{
@@ -387,6 +1169,14 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 		}
 	}
 
+#ifdef CPU_SORTED_PARTICLES
+	if (!InitCpuSortedParticles())
+	{
+		ELOG("Error : InitCpuSortedParticles() Failed.");
+		return false;
+	}
+#endif
+
 	// パーティクル描画用コマンドシグニチャの生成
 	{
 		D3D12_INDIRECT_ARGUMENT_DESC argDesc;
@@ -503,7 +1293,7 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 		desc.VS.BytecodeLength = pVSBlob->GetBufferSize();
 		desc.PS.pShaderBytecode = pPSBlob->GetBufferPointer();
 		desc.PS.BytecodeLength = pPSBlob->GetBufferSize();
-		desc.RTVFormats[0] = m_ColorTarget[0].GetRTVDesc().Format;
+		desc.RTVFormats[0] = m_BackBuffer[0].GetRTVDesc().Format;
 
 		hr = m_pDevice->CreateGraphicsPipelineState(
 			&desc,
@@ -530,7 +1320,11 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 
 		if (!m_QuadVB.InitAsVertexBuffer<Vertex>(
 			m_pDevice.Get(),
-			3
+			3,
+			D3D12_RESOURCE_FLAG_NONE,
+			D3D12_RESOURCE_STATE_COMMON,
+			m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
+			L"QuadVB"
 		))
 		{
 			ELOG("Error : Resource::InitAsVertexBuffer Failed.");
@@ -567,7 +1361,7 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 			if (!m_CameraCB[i].InitAsConstantBuffer<CbCamera>(
 				m_pDevice.Get(),
 				D3D12_HEAP_TYPE_UPLOAD,
-				m_pPool[POOL_TYPE_RES]
+				m_pPool[POOL_TYPE_RES_GPU_VISIBLE]
 			))
 			{
 				ELOG("Error : Resource::InitAsConstantBuffer() Failed.");
@@ -592,9 +1386,9 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 			m_pDevice.Get(), 
 			sizeof(args),
 			D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
-			D3D12_RESOURCE_STATE_COMMON,
-			m_pPool[POOL_TYPE_RES],
-			m_pPool[POOL_TYPE_RES]
+			m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
+			m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
+			nullptr
 		))
 		{
 			ELOG("Error : Resource::InitAsResource() Failed.");
@@ -621,9 +1415,8 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 				m_pDevice.Get(),
 				MAX_NUM_PARTICLES,
 				D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
-				D3D12_RESOURCE_STATE_COMMON,
-				m_pPool[POOL_TYPE_RES],
-				m_pPool[POOL_TYPE_RES]
+				m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
+				m_pPool[POOL_TYPE_RES_GPU_VISIBLE]
 			))
 			{
 				ELOG("Error : Resource::InitAsResource() Failed.");
@@ -648,9 +1441,9 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 				m_pDevice.Get(), 
 				sizeof(args),
 				D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
-				D3D12_RESOURCE_STATE_COMMON,
-				m_pPool[POOL_TYPE_RES],
-				m_pPool[POOL_TYPE_RES]
+				m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
+				m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
+				nullptr
 			))
 			{
 				ELOG("Error : Resource::InitAsResource() Failed.");
@@ -671,21 +1464,22 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 	}
 
 	// 時間関係の定数バッファの作成
+	for (uint32_t i = 0u; i < FRAME_COUNT; i++)
 	{
-		if (!m_SimulationCB.InitAsConstantBuffer<CbSimulation>(
+		if (!m_SimulationCB[i].InitAsConstantBuffer<CbSimulation>(
 			m_pDevice.Get(),
 			D3D12_HEAP_TYPE_UPLOAD,
-			m_pPool[POOL_TYPE_RES]
+			m_pPool[POOL_TYPE_RES_GPU_VISIBLE]
 		))
 		{
 			ELOG("Error : Resource::InitAsConstantBuffer() Failed.");
 			return false;
 		}
 
-		CbSimulation* ptr = m_SimulationCB.Map<CbSimulation>();
+		CbSimulation* ptr = m_SimulationCB[i].Map<CbSimulation>();
 		ptr->DeltaTime = 0.0f;
 		ptr->InitialVelocityScale = 1.0f;
-		m_SimulationCB.Unmap();
+		m_SimulationCB[i].Unmap();
 	}
 
 	// バックバッファ描画用の定数バッファの作成
@@ -693,7 +1487,7 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 		if (!m_BackBufferCB.InitAsConstantBuffer<CbSampleTexture>(
 			m_pDevice.Get(),
 			D3D12_HEAP_TYPE_UPLOAD,
-			m_pPool[POOL_TYPE_RES]
+			m_pPool[POOL_TYPE_RES_GPU_VISIBLE]
 		))
 		{
 			ELOG("Error : Resource::InitAsConstantBuffer() Failed.");
@@ -709,6 +1503,8 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 	}
 
 	pCmd->Close();
+	// UploadBufferData()のコピーはアップロード用のリングのコマンドリストに記録されているので、先に実行する
+	m_UploadRing.Submit();
 	ID3D12CommandList* pLists[] = {pCmd};
 	m_pQueue->ExecuteCommandLists(1, pLists);
 	// Wait command queue finishing.
@@ -721,6 +1517,13 @@ bool ParticleSampleApp::OnInit(HWND hWnd)
 
 void ParticleSampleApp::OnTerm()
 {
+#ifdef RECORD_PARTICLE_REPLAY
+	if (m_ParticleReplay.Save(PARTICLE_REPLAY_FILENAME))
+	{
+		ELOG("Particle Replay : %u steps are saved to %ls", m_ParticleReplay.GetStepCount(), PARTICLE_REPLAY_FILENAME);
+	}
+#endif
+
 	// imgui終了処理
 	if (ImGui::GetCurrentContext() != nullptr)
 	{
@@ -735,13 +1538,16 @@ void ParticleSampleApp::OnTerm()
 	for (uint32_t i = 0; i < FRAME_COUNT; i++)
 	{
 		m_CameraCB[i].Term();
+		m_SimulationCB[i].Term();
 		m_ParticlesSB[i].Term();
 		m_DrawParticlesIndirectArgsBB[i].Term();
+		m_CpuParticlesSB[i].Term();
+		m_SortedIndicesSB[i].Term();
+		m_CpuDrawParticlesIndirectArgsBB[i].Term();
 	}
 
 	m_DispatchIndirectArgsBB.Term();
 
-	m_SimulationCB.Term();
 	m_BackBufferCB.Term();
 
 	m_SceneDepthTarget.Term();
@@ -758,6 +1564,10 @@ void ParticleSampleApp::OnTerm()
 	m_DrawParticlesRootSig.Term();
 	m_pDrawParticlesCommandSig.Reset();
 
+	m_pDrawSortedParticlesPSO.Reset();
+	m_DrawSortedParticlesRootSig.Term();
+	m_CpuParticles.Term();
+
 	m_pBackBufferPSO.Reset();
 	m_BackBufferRootSig.Term();
 }
@@ -766,9 +1576,13 @@ void ParticleSampleApp::OnRender()
 {
 	using namespace std::chrono;
 	const high_resolution_clock::time_point& currTime = high_resolution_clock::now();
-	const milliseconds& deltaTimeMS = duration_cast<milliseconds>(currTime - m_PrevTime);
+	double elapsedTime = duration<double>(currTime - m_PrevTime).count();
 	m_PrevTime = currTime;
 
+	// 経過時間を固定の刻みのステップ数にする。フレームレートによってシミュレーションの結果や負荷が変わらない
+	uint32_t numSteps = m_SimulationTimestep.Advance(elapsedTime);
+	float alpha = m_SimulationTimestep.GetAlpha();
+
 	const Matrix& view = m_CameraManipulator.GetView();
 	constexpr float fovY = DirectX::XMConvertToRadians(CAMERA_FOV_Y_DEGREE);
 	float aspect = static_cast<float>(m_Width) / static_cast<float>(m_Height);
@@ -779,25 +1593,50 @@ void ParticleSampleApp::OnRender()
 		CbCamera* ptr = m_CameraCB[m_FrameIndex].Map<CbCamera>();
 		ptr->View = view;
 		ptr->Proj = proj;
+#ifdef CPU_SORTED_PARTICLES
+		// CPUで補間した位置を書き込むので戻さない
+		ptr->RewindTime = 0.0f;
+#else
+		ptr->RewindTime = (1.0f - alpha) * static_cast<float>(SIMULATION_STEP_TIME);
+#endif
+		ptr->SpawnLife = m_InitialLife;
 		m_CameraCB[m_FrameIndex].Unmap();
 	}
 
 	ID3D12GraphicsCommandList* pCmd = m_CommandList.Reset();
 
 	ID3D12DescriptorHeap* const pHeaps[] = {
-		m_pPool[POOL_TYPE_RES]->GetHeap()
+		m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->GetHeap()
 	};
 
 	pCmd->SetDescriptorHeaps(1, pHeaps);
 
-	const Resource& prevParticlesSB = m_ParticlesSB[m_FrameIndex];
-	const Resource& currParticlesSB = m_ParticlesSB[(m_FrameIndex + 1) % 2];
-	const Resource& prevDrawParticlesArgsBB = m_DrawParticlesIndirectArgsBB[m_FrameIndex];
-	const Resource& currDrawParticlesArgsBB = m_DrawParticlesIndirectArgsBB[(m_FrameIndex + 1) % 2];
+#ifdef CPU_SORTED_PARTICLES
+	UpdateCpuSortedParticles(view, numSteps, alpha);
+	DrawSortedParticles(pCmd);
+#else
+	// ステップごとに2つのバッファを入れ替える
+	for (uint32_t step = 0; step < numSteps; step++)
+	{
+		const Resource& prevParticlesSB = m_ParticlesSB[m_CurrParticlesIdx];
+		const Resource& currParticlesSB = m_ParticlesSB[m_CurrParticlesIdx ^ 1];
+		const Resource& prevDrawParticlesArgsBB = m_DrawParticlesIndirectArgsBB[m_CurrParticlesIdx];
+		const Resource& currDrawParticlesArgsBB = m_DrawParticlesIndirectArgsBB[m_CurrParticlesIdx ^ 1];
+
+		if (step > 0)
+		{
+			// 前のステップのパーティクル数の書き込みと、間接引数の読み出しを待つ
+			prevDrawParticlesArgsBB.BarrierUAV(pCmd);
+			m_DispatchIndirectArgsBB.BarrierUAV(pCmd);
+		}
+
+		ResetNumParticles(pCmd, prevDrawParticlesArgsBB, currDrawParticlesArgsBB);
+		UpdateParticles(pCmd, prevParticlesSB, currParticlesSB, prevDrawParticlesArgsBB, currDrawParticlesArgsBB, NextParticleUpdateDesc());
+		m_CurrParticlesIdx ^= 1;
+	}
 
-	ResetNumParticles(pCmd, prevDrawParticlesArgsBB, currDrawParticlesArgsBB);
-	UpdateParticles(pCmd, prevParticlesSB, currParticlesSB, prevDrawParticlesArgsBB, currDrawParticlesArgsBB, deltaTimeMS);
-	DrawParticles(pCmd, currParticlesSB, currDrawParticlesArgsBB);
+	DrawParticles(pCmd, m_ParticlesSB[m_CurrParticlesIdx], m_DrawParticlesIndirectArgsBB[m_CurrParticlesIdx]);
+#endif
 
 	DrawBackBuffer(pCmd);
 
@@ -805,6 +1644,7 @@ void ParticleSampleApp::OnRender()
 
 	pCmd->Close();
 
+	m_UploadRing.Submit();
 	ID3D12CommandList* pLists[] = {pCmd};
 	m_pQueue->ExecuteCommandLists(1, pLists);
 
@@ -949,16 +1789,33 @@ void ParticleSampleApp::ResetNumParticles(ID3D12GraphicsCommandList* pCmdList, c
 	pCmdList->Dispatch(1, 1, 1);
 }
 
-void ParticleSampleApp::UpdateParticles(ID3D12GraphicsCommandList* pCmdList, const Resource& prevParticlesSB, const Resource& currParticlesSB, const Resource& prevDrawParticlesArgsBB, const Resource& currDrawParticlesArgsBB, const std::chrono::milliseconds& deltaTimeMS)
+ParticleUpdateDesc ParticleSampleApp::NextParticleUpdateDesc()
+{
+	ParticleUpdateDesc desc;
+	desc.NumSpawnPerFrame = m_NumSpawnPerFrame;
+	desc.InitialLife = m_InitialLife;
+	desc.DeltaTime = static_cast<float>(SIMULATION_STEP_TIME);
+	desc.InitialVelocityScale = m_InitialVelocityScale;
+	desc.FrameIndex = m_SimulationFrameIndex++;
+	desc.RandomSeed = m_RandomSeed;
+
+#ifdef RECORD_PARTICLE_REPLAY
+	m_ParticleReplay.RecordStep(desc);
+#endif
+
+	return desc;
+}
+
+void ParticleSampleApp::UpdateParticles(ID3D12GraphicsCommandList* pCmdList, const Resource& prevParticlesSB, const Resource& currParticlesSB, const Resource& prevDrawParticlesArgsBB, const Resource& currDrawParticlesArgsBB, const ParticleUpdateDesc& desc)
 {
 	ScopedTimer scopedTimer(pCmdList, L"Update Particles");
 
-	// 定数バッファの更新
+	// 定数バッファの更新。1フレームの全ステップで同じ値なので、フレームごとの1つの定数バッファを使い回せる
 	{
-		CbSimulation* ptr = m_SimulationCB.Map<CbSimulation>();
-		ptr->DeltaTime = deltaTimeMS.count() / 1000.0f;
-		ptr->InitialVelocityScale = m_InitialVelocityScale;
-		m_SimulationCB.Unmap();
+		CbSimulation* ptr = m_SimulationCB[m_FrameIndex].Map<CbSimulation>();
+		ptr->DeltaTime = desc.DeltaTime;
+		ptr->InitialVelocityScale = desc.InitialVelocityScale;
+		m_SimulationCB[m_FrameIndex].Unmap();
 	}
 
 	DirectX::TransitionResource(pCmdList, prevParticlesSB.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
@@ -966,10 +1823,10 @@ void ParticleSampleApp::UpdateParticles(ID3D12GraphicsCommandList* pCmdList, con
 	pCmdList->SetComputeRootSignature(m_UpdateParticlesRootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pUpdateParticlesPSO.Get());
 
-	uint32_t rootConstants[2] = {m_NumSpawnPerFrame, m_InitialLife};
-	pCmdList->SetComputeRoot32BitConstants(0, 2, rootConstants, 0);
+	uint32_t rootConstants[4] = {desc.NumSpawnPerFrame, desc.InitialLife, desc.FrameIndex, desc.RandomSeed};
+	pCmdList->SetComputeRoot32BitConstants(0, _countof(rootConstants), rootConstants, 0);
 
-	pCmdList->SetComputeRootDescriptorTable(1, m_SimulationCB.GetHandleCBV()->HandleGPU);
+	pCmdList->SetComputeRootDescriptorTable(1, m_SimulationCB[m_FrameIndex].GetHandleCBV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(2, prevParticlesSB.GetHandleSRV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(3, currParticlesSB.GetHandleUAV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(4, prevDrawParticlesArgsBB.GetHandleSRV()->HandleGPU);
@@ -1014,6 +1871,172 @@ void ParticleSampleApp::DrawParticles(ID3D12GraphicsCommandList* pCmdList, const
 	DirectX::TransitionResource(pCmdList, currParticlesSB.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 }
 
+bool ParticleSampleApp::InitCpuSortedParticles()
+{
+	if (!m_CpuParticles.Init(MAX_NUM_PARTICLES))
+	{
+		ELOG("Error : ParticleSimulator::Init() Failed.");
+		return false;
+	}
+
+	m_DepthKeys.resize(MAX_NUM_PARTICLES);
+	m_SortedIndices.resize(MAX_NUM_PARTICLES);
+
+	// ソート済みインデックスで描画するルートシグニチャとパイプラインステートの生成
+	{
+		std::wstring vsPath;
+		std::wstring psPath;
+
+		if (!SearchFilePath(L"DrawSortedParticlesVS.cso", vsPath))
+		{
+			ELOG("Error : Vertex Shader Not Found");
+			return false;
+		}
+
+		if (!SearchFilePath(L"DrawParticlesPS.cso", psPath))
+		{
+			ELOG("Error : Pixel Shader Not Found");
+			return false;
+		}
+
+		ComPtr<ID3DBlob> pVSBlob;
+		ComPtr<ID3DBlob> pPSBlob;
+
+		HRESULT hr = D3DReadFileToBlob(vsPath.c_str(), pVSBlob.GetAddressOf());
+		if (FAILED(hr))
+		{
+			ELOG("Error : D3DReadFileToBlob Failed. path = %ls", vsPath.c_str());
+			return false;
+		}
+
+		hr = D3DReadFileToBlob(psPath.c_str(), pPSBlob.GetAddressOf());
+		if (FAILED(hr))
+		{
+			ELOG("Error : D3DReadFileToBlob Failed. path = %ls", psPath.c_str());
+			return false;
+		}
+
+		// SortedIndicesのSRVが増えるので頂点シェーダのルートシグニチャを使う
+		ComPtr<ID3DBlob> pRSBlob;
+		hr = D3DGetBlobPart(pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize(), D3D_BLOB_ROOT_SIGNATURE, 0, &pRSBlob);
+		if (FAILED(hr))
+		{
+			ELOG("Error : D3DGetBlobPart Failed. path = %ls", vsPath.c_str());
+			return false;
+		}
+
+		if (!m_DrawSortedParticlesRootSig.Init(m_pDevice.Get(), pRSBlob))
+		{
+			ELOG("Error : RootSignature::Init() Failed.");
+			return false;
+		}
+
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+		desc.InputLayout.NumElements = 0;
+		desc.InputLayout.pInputElementDescs = nullptr;
+		desc.pRootSignature = m_DrawSortedParticlesRootSig.GetPtr();
+		desc.BlendState = DirectX::CommonStates::Opaque;
+		desc.DepthStencilState = DirectX::CommonStates::DepthDefault;
+		desc.SampleMask = UINT_MAX;
+		desc.RasterizerState = DirectX::CommonStates::CullClockwise;
+		desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		desc.NumRenderTargets = 1;
+		desc.RTVFormats[0] = m_DrawParticlesTarget.GetRTVDesc().Format;
+		desc.DSVFormat = m_SceneDepthTarget.GetDSVDesc().Format;
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		desc.VS.pShaderBytecode = pVSBlob->GetBufferPointer();
+		desc.VS.BytecodeLength = pVSBlob->GetBufferSize();
+		desc.PS.pShaderBytecode = pPSBlob->GetBufferPointer();
+		desc.PS.BytecodeLength = pPSBlob->GetBufferSize();
+
+		hr = m_pDevice->CreateGraphicsPipelineState(
+			&desc,
+			IID_PPV_ARGS(m_pDrawSortedParticlesPSO.GetAddressOf())
+		);
+		if (FAILED(hr))
+		{
+			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < FRAME_COUNT; i++)
+	{
+		if (!InitUploadBuffer(m_CpuParticlesSB[i], m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(ParticleData) * MAX_NUM_PARTICLES, sizeof(ParticleData))
+			|| !InitUploadBuffer(m_SortedIndicesSB[i], m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(uint32_t) * MAX_NUM_PARTICLES, sizeof(uint32_t))
+			|| !InitUploadBuffer(m_CpuDrawParticlesIndirectArgsBB[i], m_pDevice.Get(), nullptr, sizeof(D3D12_DRAW_ARGUMENTS), 0))
+		{
+			ELOG("Error : Resource::Init() Failed.");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void ParticleSampleApp::UpdateCpuSortedParticles(const Matrix& view, uint32_t numSteps, float alpha)
+{
+	for (uint32_t step = 0; step < numSteps; step++)
+	{
+		m_CpuParticles.Update(NextParticleUpdateDesc());
+	}
+
+	uint32_t numParticles = m_CpuParticles.GetNumParticles();
+
+	// 補間した位置で奥から順に並べる。Uploadヒープは書き込み結合で読み出しが遅いので、ソートは普通のメモリで行ってからコピーする
+	m_CpuParticles.ComputeViewDepthKeys(view, alpha, true, m_DepthKeys.data());
+	std::iota(m_SortedIndices.begin(), m_SortedIndices.begin() + numParticles, 0);
+	m_DepthSorter.Sort(numParticles, m_DepthKeys.data(), m_SortedIndices.data());
+
+	// このフレームのバッファを最後に使ったFRAME_COUNTフレーム前の完了はFramePacerが待っているので、GPUから参照されていない
+	ParticleData* pParticles = m_CpuParticlesSB[m_FrameIndex].Map<ParticleData>();
+	m_CpuParticles.CopyInterpolatedParticles(alpha, pParticles);
+	m_CpuParticlesSB[m_FrameIndex].Unmap();
+
+	uint32_t* pSortedIndices = m_SortedIndicesSB[m_FrameIndex].Map<uint32_t>();
+	memcpy(pSortedIndices, m_SortedIndices.data(), sizeof(uint32_t) * numParticles);
+	m_SortedIndicesSB[m_FrameIndex].Unmap();
+
+	D3D12_DRAW_ARGUMENTS* pArgs = m_CpuDrawParticlesIndirectArgsBB[m_FrameIndex].Map<D3D12_DRAW_ARGUMENTS>();
+	pArgs->VertexCountPerInstance = 4;
+	pArgs->InstanceCount = numParticles;
+	pArgs->StartVertexLocation = 0;
+	pArgs->StartInstanceLocation = 0;
+	m_CpuDrawParticlesIndirectArgsBB[m_FrameIndex].Unmap();
+}
+
+void ParticleSampleApp::DrawSortedParticles(ID3D12GraphicsCommandList* pCmdList)
+{
+	ScopedTimer scopedTimer(pCmdList, L"Draw Sorted Particles");
+
+	DirectX::TransitionResource(pCmdList, m_DrawParticlesTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+	const DescriptorHandle* handleRTV = m_DrawParticlesTarget.GetHandleRTV();
+	const DescriptorHandle* handleDSV = m_SceneDepthTarget.GetHandleDSV();
+	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, &handleDSV->HandleCPU);
+
+	m_DrawParticlesTarget.ClearView(pCmdList);
+	m_SceneDepthTarget.ClearView(pCmdList);
+
+	pCmdList->SetGraphicsRootSignature(m_DrawSortedParticlesRootSig.GetPtr());
+	pCmdList->SetGraphicsRootDescriptorTable(0, m_CameraCB[m_FrameIndex].GetHandleCBV()->HandleGPU);
+	pCmdList->SetGraphicsRootDescriptorTable(1, m_CpuParticlesSB[m_FrameIndex].GetHandleSRV()->HandleGPU);
+	pCmdList->SetGraphicsRootDescriptorTable(2, m_SortedIndicesSB[m_FrameIndex].GetHandleSRV()->HandleGPU);
+	pCmdList->SetPipelineState(m_pDrawSortedParticlesPSO.Get());
+
+	pCmdList->RSSetViewports(1, &m_Viewport);
+	pCmdList->RSSetScissorRects(1, &m_Scissor);
+
+	pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+	pCmdList->ExecuteIndirect(m_pDrawParticlesCommandSig.Get(), 1, m_CpuDrawParticlesIndirectArgsBB[m_FrameIndex].GetResource(), 0, nullptr, 0);
+
+	DirectX::TransitionResource(pCmdList, m_DrawParticlesTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+}
+
 void ParticleSampleApp::DrawBackBuffer(ID3D12GraphicsCommandList* pCmdList)
 {
 	ScopedTimer scopedTimer(pCmdList, L"Draw BackBuffer");
@@ -1021,17 +2044,17 @@ void ParticleSampleApp::DrawBackBuffer(ID3D12GraphicsCommandList* pCmdList)
 	// R8_UNORMとR10G10B10A2_UNORMではCopyResourceでは非対応でエラーが出るのでシェーダでコピーする
 
 	//DirectX::TransitionResource(pCmd, m_SSAO_FullResTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE);
-	//DirectX::TransitionResource(pCmd, m_ColorTarget[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_COPY_DEST);
-	//pCmd->CopyResource(m_ColorTarget[m_FrameIndex].GetResource(), m_SSAO_FullResTarget.GetResource());
+	//DirectX::TransitionResource(pCmd, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_COPY_DEST);
+	//pCmd->CopyResource(m_BackBuffer[m_FrameIndex].GetResource(), m_SSAO_FullResTarget.GetResource());
 	//DirectX::TransitionResource(pCmd, m_SSAO_FullResTarget.GetResource(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	//DirectX::TransitionResource(pCmd, m_ColorTarget[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PRESENT);
+	//DirectX::TransitionResource(pCmd, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PRESENT);
 
-	DirectX::TransitionResource(pCmdList, m_ColorTarget[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	DirectX::TransitionResource(pCmdList, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
 
-	const DescriptorHandle* handleRTV = m_ColorTarget[m_FrameIndex].GetHandleRTV();
+	const DescriptorHandle* handleRTV = m_BackBuffer[m_FrameIndex].GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
 
-	m_ColorTarget[m_FrameIndex].ClearView(pCmdList);
+	m_BackBuffer[m_FrameIndex].ClearView(pCmdList);
 
 	pCmdList->SetGraphicsRootSignature(m_BackBufferRootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pBackBufferPSO.Get());
@@ -1067,7 +2090,7 @@ void ParticleSampleApp::DrawBackBuffer(ID3D12GraphicsCommandList* pCmdList)
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_ColorTarget[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+	DirectX::TransitionResource(pCmdList, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
 }
 
 void ParticleSampleApp::DrawImGui(ID3D12GraphicsCommandList* pCmdList)
@@ -1075,9 +2098,9 @@ void ParticleSampleApp::DrawImGui(ID3D12GraphicsCommandList* pCmdList)
 	ScopedTimer scopedTimer(pCmdList, L"ImGui");
 
 	// TODO: Transitionが直前のパスと重複している
-	DirectX::TransitionResource(pCmdList, m_ColorTarget[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	DirectX::TransitionResource(pCmdList, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
 
-	const DescriptorHandle* handleRTV = m_ColorTarget[m_FrameIndex].GetHandleRTV();
+	const DescriptorHandle* handleRTV = m_BackBuffer[m_FrameIndex].GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
 
 	// https://github.com/ocornut/imgui/wiki/Getting-Started#example-if-you-are-using-raw-win32-api--directx12を参考にしている
@@ -1099,5 +2122,5 @@ void ParticleSampleApp::DrawImGui(ID3D12GraphicsCommandList* pCmdList)
 	ImGui::Render();
 	ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), pCmdList);
 
-	DirectX::TransitionResource(pCmdList, m_ColorTarget[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+	DirectX::TransitionResource(pCmdList, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
 }
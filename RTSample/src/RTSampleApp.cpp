@@ -83,7 +83,7 @@ bool RTSampleApp::OnInit(HWND hWnd)
 			return false;
 		}
 
-		if (!ImGui_ImplDX12_Init(m_pDevice.Get(), 1, m_BackBufferFormat, m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->GetHeap(), pHandleSRV->HandleCPU, pHandleSRV->HandleGPU))
+		if (!ImGui_ImplDX12_Init(m_pDevice.Get(), FRAME_COUNT, m_BackBufferFormat, m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->GetHeap(), pHandleSRV->HandleCPU, pHandleSRV->HandleGPU))
 		{
 			ELOG("Error : ImGui_ImplDX12_Init() Failed.");
 			return false;
@@ -880,6 +880,8 @@ bool RTSampleApp::OnInit(HWND hWnd)
 	}
 
 	pCmd->Close();
+	// UploadBufferData()のコピーはアップロード用のリングのコマンドリストに記録されているので、先に実行する
+	m_UploadRing.Submit();
 	ID3D12CommandList* pLists[] = {pCmd};
 	m_pQueue->ExecuteCommandLists(1, pLists);
 	// Wait command queue finishing.
@@ -954,6 +956,7 @@ void RTSampleApp::OnRender()
 
 	pCmd->Close();
 
+	m_UploadRing.Submit();
 	ID3D12CommandList* pLists[] = {pCmd};
 	m_pQueue->ExecuteCommandLists(1, pLists);
 
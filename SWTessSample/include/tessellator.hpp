@@ -137,6 +137,20 @@ public:
 #ifdef ALLOW_XBOX_360_COMPARISON
     void SetXBox360Mode(bool bXboxMode) {m_bXBox360Mode = bXboxMode;}
 #endif
+
+    // Point generation can evaluate a whole run of ring edge points per call with SSE4.1/AVX2 instead of one
+    // point at a time.  This is NOT part of the hardware reference: the SIMD paths use the same fixed point math
+    // and produce bit-identical points to the scalar PlacePointIn1D/DefinePoint path (SIMD_MODE_SCALAR).
+    // By default the best mode the CPU supports is chosen.
+    typedef enum SIMD_MODE
+    {
+        SIMD_MODE_SCALAR,
+        SIMD_MODE_SSE41,
+        SIMD_MODE_AVX2
+    };
+    void SetSIMDMode(SIMD_MODE mode); // Clamped to what the CPU supports.
+    SIMD_MODE GetSIMDMode() {return m_SIMDMode;}
+
     CHWTessellator();
     ~CHWTessellator();
 //---------------------------------------------------------------------------------------------------------------------------------
@@ -177,6 +191,7 @@ private:
 #ifdef ALLOW_XBOX_360_COMPARISON
     bool                                 m_bXBox360Mode;
 #endif
+    SIMD_MODE                            m_SIMDMode;
     // PlacePointIn1D below is the workhorse for all position placement.
     // It is code that could run as preamble in a Domain Shader, so the tessellator itself
     // doesn't necessarily need to have floating point.
@@ -193,6 +208,8 @@ private:
     } TESS_FACTOR_CONTEXT;
     void ComputeTessFactorContext( FXP fxpTessFactor, TESS_FACTOR_CONTEXT& TessFactorCtx );
     void PlacePointIn1D( const TESS_FACTOR_CONTEXT& TessFactorCtx, int point, FXP& fxpLocation );
+    // Batched PlacePointIn1D: places points firstPoint, firstPoint+pointStep, ... (numPoints of them).
+    void PlacePointsIn1D( const TESS_FACTOR_CONTEXT& TessFactorCtx, int firstPoint, int pointStep, int numPoints, FXP* pfxpLocation );
 
     int NumPointsForTessFactor(FXP fxpTessFactor);
 
@@ -211,6 +228,9 @@ private:
 
     // Call these to generate new points and indices.  Max TessFactor storage is already allocated.
     int DefinePoint(FXP u, FXP v, int pointStorageOffset);
+    // Batched DefinePoint for a run of points along one edge: u = uScale*param + fxpUOffset, v = vScale*param + fxpVOffset
+    // (scales are -1, 0 or 1, math wraps the same way as the FXP expressions it replaces).
+    void DefinePoints(const FXP* pfxpParam, int numPoints, int uScale, FXP fxpUOffset, int vScale, FXP fxpVOffset, int pointStorageOffset);
     void DefineIndex(int index, int indexStorageOffset);
     void DefineClockwiseTriangle(int index0, int index1, int index2, int indexStorageBaseOffset);
 
@@ -14,8 +14,18 @@
 #include "FileUtil.h"
 #include "Logger.h"
 #include "ScopedTimer.h"
+#include "ParallelFor.h"
+
+#include "tessellator.hpp"
+#include <atomic>
+#include <cstring>
 
 //#define DYNAMIC_RESOURCES
+// 起動時にテッセレータのSIMD版のポイント生成がスカラー版と完全一致するかを、固定小数点で表せる全てのテッセレーション係数と、
+// 1/4刻みの係数での各ドメインのテッセレーションで検証する
+//#define VERIFY_TESSELLATOR_SIMD
+// 起動時にテッセレータのSIMD版とスカラー版の処理時間を計測する
+//#define BENCHMARK_TESSELLATOR_SIMD
 
 using namespace DirectX::SimpleMath;
 
@@ -42,6 +52,195 @@ namespace
 	{
 		return (dividend + divisor - 1) / divisor;
 	}
+
+	static const D3D11_TESSELLATOR_PARTITIONING TESSELLATOR_PARTITIONINGS[] = {
+		D3D11_TESSELLATOR_PARTITIONING_INTEGER,
+		D3D11_TESSELLATOR_PARTITIONING_POW2,
+		D3D11_TESSELLATOR_PARTITIONING_FRACTIONAL_ODD,
+		D3D11_TESSELLATOR_PARTITIONING_FRACTIONAL_EVEN,
+	};
+
+	bool IsSameTessellation(CHLSLTessellator& lhs, CHLSLTessellator& rhs)
+	{
+		if (lhs.GetPointCount() != rhs.GetPointCount() || lhs.GetIndexCount() != rhs.GetIndexCount())
+		{
+			return false;
+		}
+
+		// floatの値ではなくビット列で一致を見る
+		if (memcmp(lhs.GetPoints(), rhs.GetPoints(), sizeof(DOMAIN_POINT) * lhs.GetPointCount()) != 0)
+		{
+			return false;
+		}
+
+		return memcmp(lhs.GetIndices(), rhs.GetIndices(), sizeof(int) * lhs.GetIndexCount()) == 0;
+	}
+
+	// 係数ごとのポイントの配置は、テッセレーション係数を16.16の固定小数点にしたものだけで決まる。
+	// 1～64の範囲で固定小数点で表せる全ての係数をアイソラインの線上の分割数に使い、ビット単位で一致することを検証する
+	bool VerifyTessellatorSIMDAllFactors(D3D11_TESSELLATOR_PARTITIONING partitioning, CHWTessellator::SIMD_MODE mode)
+	{
+		static constexpr uint32_t NUM_STEPS_PER_FACTOR = 1 << 16;
+		static constexpr uint32_t NUM_FACTORS = (D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR - 1) * NUM_STEPS_PER_FACTOR + 1;
+		static constexpr uint32_t GRAIN_SIZE = 4096;
+
+		std::atomic<bool> isSame = true;
+		ParallelFor(NUM_FACTORS, GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+		{
+			CHLSLTessellator reference;
+			reference.Init(partitioning, D3D11_TESSELLATOR_REDUCTION_MAX, D3D11_TESSELLATOR_QUAD_REDUCTION_2_AXIS, D3D11_TESSELLATOR_OUTPUT_TRIANGLE_CW);
+			reference.SetSIMDMode(CHWTessellator::SIMD_MODE_SCALAR);
+
+			CHLSLTessellator tessellator;
+			tessellator.Init(partitioning, D3D11_TESSELLATOR_REDUCTION_MAX, D3D11_TESSELLATOR_QUAD_REDUCTION_2_AXIS, D3D11_TESSELLATOR_OUTPUT_TRIANGLE_CW);
+			tessellator.SetSIMDMode(mode);
+
+			for (uint32_t i = begin; i < end && isSame.load(std::memory_order_relaxed); i++)
+			{
+				// 64以下の1/65536の倍数はfloatで正確に表せる
+				float factor = 1.0f + static_cast<float>(i) / NUM_STEPS_PER_FACTOR;
+
+				reference.TessellateIsoLineDomain(1.0f, factor);
+				tessellator.TessellateIsoLineDomain(1.0f, factor);
+				if (!IsSameTessellation(reference, tessellator))
+				{
+					ELOG("Error : IsoLine tessellation mismatch. partitioning = %d, SIMD mode = %d, factor = %.8f", partitioning, mode, factor);
+					isSame = false;
+					return;
+				}
+			}
+		});
+
+		return isSame;
+	}
+
+	// SIMD版のポイント生成がスカラー版のリファレンスとビット単位で一致することを全パーティショニングモードで検証する。
+	// 係数は固定小数点で表せる全ての値を、リングの辿り方やエッジごとに係数が違う場合はドメインごとに1/4刻みの係数で検証する
+	bool VerifyTessellatorSIMD()
+	{
+		static const CHWTessellator::SIMD_MODE SIMD_MODES[] = {
+			CHWTessellator::SIMD_MODE_SSE41,
+			CHWTessellator::SIMD_MODE_AVX2,
+		};
+
+		static constexpr uint32_t NUM_STEPS_PER_FACTOR = 4;
+		static constexpr uint32_t NUM_FACTORS = (D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR - 1) * NUM_STEPS_PER_FACTOR + 1;
+
+		for (D3D11_TESSELLATOR_PARTITIONING partitioning : TESSELLATOR_PARTITIONINGS)
+		{
+			for (CHWTessellator::SIMD_MODE mode : SIMD_MODES)
+			{
+				CHLSLTessellator reference;
+				reference.Init(partitioning, D3D11_TESSELLATOR_REDUCTION_MAX, D3D11_TESSELLATOR_QUAD_REDUCTION_2_AXIS, D3D11_TESSELLATOR_OUTPUT_TRIANGLE_CW);
+				reference.SetSIMDMode(CHWTessellator::SIMD_MODE_SCALAR);
+
+				CHLSLTessellator tessellator;
+				tessellator.Init(partitioning, D3D11_TESSELLATOR_REDUCTION_MAX, D3D11_TESSELLATOR_QUAD_REDUCTION_2_AXIS, D3D11_TESSELLATOR_OUTPUT_TRIANGLE_CW);
+				tessellator.SetSIMDMode(mode);
+				if (tessellator.GetSIMDMode() != mode)
+				{
+					// CPUが非対応
+					continue;
+				}
+
+				if (!VerifyTessellatorSIMDAllFactors(partitioning, mode))
+				{
+					return false;
+				}
+
+				for (uint32_t i = 0; i < NUM_FACTORS; i++)
+				{
+					float factor = 1.0f + static_cast<float>(i) / NUM_STEPS_PER_FACTOR;
+					// エッジごとに係数が異なる場合もリングのつなぎ目を検証するために逆順の係数も使う
+					float reversedFactor = static_cast<float>(D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR + 1) - factor;
+
+					reference.TessellateQuadDomain(factor, factor, factor, factor, 1.0f, 1.0f);
+					tessellator.TessellateQuadDomain(factor, factor, factor, factor, 1.0f, 1.0f);
+					if (!IsSameTessellation(reference, tessellator))
+					{
+						ELOG("Error : Quad tessellation mismatch. partitioning = %d, SIMD mode = %d, factor = %f", partitioning, mode, factor);
+						return false;
+					}
+
+					reference.TessellateQuadDomain(factor, reversedFactor, factor, reversedFactor, 0.75f, 0.25f);
+					tessellator.TessellateQuadDomain(factor, reversedFactor, factor, reversedFactor, 0.75f, 0.25f);
+					if (!IsSameTessellation(reference, tessellator))
+					{
+						ELOG("Error : Quad tessellation mismatch. partitioning = %d, SIMD mode = %d, factor = %f, %f", partitioning, mode, factor, reversedFactor);
+						return false;
+					}
+
+					reference.TessellateTriDomain(factor, factor, factor, 1.0f);
+					tessellator.TessellateTriDomain(factor, factor, factor, 1.0f);
+					if (!IsSameTessellation(reference, tessellator))
+					{
+						ELOG("Error : Tri tessellation mismatch. partitioning = %d, SIMD mode = %d, factor = %f", partitioning, mode, factor);
+						return false;
+					}
+
+					reference.TessellateTriDomain(factor, reversedFactor, factor, 0.5f);
+					tessellator.TessellateTriDomain(factor, reversedFactor, factor, 0.5f);
+					if (!IsSameTessellation(reference, tessellator))
+					{
+						ELOG("Error : Tri tessellation mismatch. partitioning = %d, SIMD mode = %d, factor = %f, %f", partitioning, mode, factor, reversedFactor);
+						return false;
+					}
+
+					reference.TessellateIsoLineDomain(factor, reversedFactor);
+					tessellator.TessellateIsoLineDomain(factor, reversedFactor);
+					if (!IsSameTessellation(reference, tessellator))
+					{
+						ELOG("Error : IsoLine tessellation mismatch. partitioning = %d, SIMD mode = %d, factor = %f, %f", partitioning, mode, factor, reversedFactor);
+						return false;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// 最大係数のクアッドパッチのテッセレーションの1パッチあたりの処理時間をSIMDモードごとに計測する
+	void BenchmarkTessellatorSIMD()
+	{
+		static const CHWTessellator::SIMD_MODE SIMD_MODES[] = {
+			CHWTessellator::SIMD_MODE_SCALAR,
+			CHWTessellator::SIMD_MODE_SSE41,
+			CHWTessellator::SIMD_MODE_AVX2,
+		};
+		static const char* SIMD_MODE_NAMES[] = {
+			"Scalar",
+			"SSE4.1",
+			"AVX2",
+		};
+		static constexpr uint32_t NUM_ITERATIONS = 1000;
+		static constexpr float FACTOR = static_cast<float>(D3D11_TESSELLATOR_MAX_ODD_TESSELLATION_FACTOR);
+
+		for (D3D11_TESSELLATOR_PARTITIONING partitioning : TESSELLATOR_PARTITIONINGS)
+		{
+			for (CHWTessellator::SIMD_MODE mode : SIMD_MODES)
+			{
+				CHWTessellator tessellator;
+				tessellator.Init(partitioning, D3D11_TESSELLATOR_OUTPUT_TRIANGLE_CW);
+				tessellator.SetSIMDMode(mode);
+				if (tessellator.GetSIMDMode() != mode)
+				{
+					continue;
+				}
+
+				const std::chrono::high_resolution_clock::time_point& start = std::chrono::high_resolution_clock::now();
+				for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+				{
+					tessellator.TessellateQuadDomain(FACTOR, FACTOR, FACTOR, FACTOR, FACTOR, FACTOR);
+					tessellator.TessellateTriDomain(FACTOR, FACTOR, FACTOR, FACTOR);
+				}
+				const std::chrono::high_resolution_clock::time_point& end = std::chrono::high_resolution_clock::now();
+
+				double usecPerIteration = std::chrono::duration<double, std::micro>(end - start).count() / NUM_ITERATIONS;
+				ELOG("Tessellator Benchmark : partitioning = %d, %s, quad + tri = %.2f us", partitioning, SIMD_MODE_NAMES[mode], usecPerIteration);
+			}
+		}
+	}
 }
 
 SWTessSampleApp::SWTessSampleApp(uint32_t width, uint32_t height)
@@ -57,6 +256,18 @@ bool SWTessSampleApp::OnInit(HWND hWnd)
 {
 	m_CameraManipulator.Reset(CAMERA_START_POSITION, CAMERA_START_TARGET);
 
+#ifdef VERIFY_TESSELLATOR_SIMD
+	if (!VerifyTessellatorSIMD())
+	{
+		ELOG("Error : VerifyTessellatorSIMD() Failed.");
+		return false;
+	}
+#endif
+
+#ifdef BENCHMARK_TESSELLATOR_SIMD
+	BenchmarkTessellatorSIMD();
+#endif
+
 	// imgui初期化
 	{
 		// https://github.com/ocornut/imgui/wiki/Getting-Started#example-if-you-are-using-raw-win32-api--directx12を参考にしている
@@ -79,7 +290,7 @@ bool SWTessSampleApp::OnInit(HWND hWnd)
 			return false;
 		}
 
-		if (!ImGui_ImplDX12_Init(m_pDevice.Get(), 1, m_BackBufferFormat, m_pPool[POOL_TYPE_RES]->GetHeap(), pHandleSRV->HandleCPU, pHandleSRV->HandleGPU))
+		if (!ImGui_ImplDX12_Init(m_pDevice.Get(), FRAME_COUNT, m_BackBufferFormat, m_pPool[POOL_TYPE_RES]->GetHeap(), pHandleSRV->HandleCPU, pHandleSRV->HandleGPU))
 		{
 			ELOG("Error : ImGui_ImplDX12_Init() Failed.");
 			return false;
@@ -261,6 +472,8 @@ bool SWTessSampleApp::OnInit(HWND hWnd)
 	ID3D12GraphicsCommandList* pCmd = m_CommandList.Reset();
 
 	pCmd->Close();
+	// UploadBufferData()のコピーはアップロード用のリングのコマンドリストに記録されているので、先に実行する
+	m_UploadRing.Submit();
 	ID3D12CommandList* pLists[] = {pCmd};
 	m_pQueue->ExecuteCommandLists(1, pLists);
 	// Wait command queue finishing.
@@ -327,6 +540,7 @@ void SWTessSampleApp::OnRender()
 
 	pCmd->Close();
 
+	m_UploadRing.Submit();
 	ID3D12CommandList* pLists[] = {pCmd};
 	m_pQueue->ExecuteCommandLists(1, pLists);
 
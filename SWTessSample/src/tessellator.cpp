@@ -1,5 +1,19 @@
 #include "tessellator.hpp"
 #include <math.h> // ceil
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TESSELLATOR_ENABLE_SIMD 1
+#include <immintrin.h> // SSE4.1/AVX2 point placement
+#ifdef _MSC_VER
+#include <intrin.h> // __cpuid
+#define TESSELLATOR_TARGET_SSE41
+#define TESSELLATOR_TARGET_AVX2
+#else
+#define TESSELLATOR_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TESSELLATOR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define TESSELLATOR_ENABLE_SIMD 0
+#endif
 //#include <windows.h> // Just used for some commented out debug stat printing.
 //#include <strsafe.h> // Ditto.
 #define min(x,y) (x < y ? x : y)
@@ -376,6 +390,218 @@ FXP fxpFloor(const FXP& input)
     return (input & FXP_INTEGER_MASK);
 }
 
+#if TESSELLATOR_ENABLE_SIMD
+//=================================================================================================================================
+// SIMD point placement
+//
+// Vectorized versions of CHWTessellator::PlacePointIn1D() and CHWTessellator::DefinePoint(), evaluating 4 (SSE4.1) or
+// 8 (AVX2) points of a ring edge at once.  Every operation is the lane-wise equivalent of the scalar reference:
+// FXP multiplies are 32 bit wrapping multiplies (mullo), shifts are logical, and the fixed to float conversion
+// is done in the same two pieces as fixedToFloat(), so results are bit-identical.
+// Each function returns how many points it handled; the caller finishes the remainder with the scalar code.
+//=================================================================================================================================
+struct SIMD_PLACEMENT_CONTEXT
+{
+    FXP fxpInvNumSegmentsOnFloorTessFactor;
+    FXP fxpInvNumSegmentsOnCeilTessFactor;
+    FXP fxpHalfTessFactorFraction;
+    int numHalfTessFactorPoints;
+    int splitPointOnFloorHalfTessFactor;
+    bool bOdd;
+};
+
+//---------------------------------------------------------------------------------------------------------------------------------
+// CPUSupportsSSE41 / CPUSupportsAVX2
+//---------------------------------------------------------------------------------------------------------------------------------
+#ifdef _MSC_VER
+static bool CPUSupportsSSE41()
+{
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+}
+
+static bool CPUSupportsAVX2()
+{
+    int info[4];
+    __cpuid(info, 0);
+    if( info[0] < 7 )
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    const int osxsaveAndAVX = (1 << 27) | (1 << 28);
+    if( (info[2] & osxsaveAndAVX) != osxsaveAndAVX )
+    {
+        return false;
+    }
+    if( (_xgetbv(0) & 0x6) != 0x6 ) // OS saves XMM and YMM state
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+#else
+static bool CPUSupportsSSE41() { return __builtin_cpu_supports("sse4.1"); }
+static bool CPUSupportsAVX2() { return __builtin_cpu_supports("avx2"); }
+#endif
+
+//---------------------------------------------------------------------------------------------------------------------------------
+// PlacePointsIn1D_SSE41
+//---------------------------------------------------------------------------------------------------------------------------------
+TESSELLATOR_TARGET_SSE41 static int PlacePointsIn1D_SSE41( const SIMD_PLACEMENT_CONTEXT& ctx, int firstPoint, int pointStep, int numPoints, FXP* pfxpLocation )
+{
+    const __m128i numHalfTessFactorPoints = _mm_set1_epi32(ctx.numHalfTessFactorPoints);
+    const __m128i mirrorBase = _mm_set1_epi32((ctx.numHalfTessFactorPoints << 1) - (ctx.bOdd ? 1 : 0));
+    const __m128i splitPoint = _mm_set1_epi32(ctx.splitPointOnFloorHalfTessFactor);
+    const __m128i fxpInvFloor = _mm_set1_epi32((int)ctx.fxpInvNumSegmentsOnFloorTessFactor);
+    const __m128i fxpInvCeil = _mm_set1_epi32((int)ctx.fxpInvNumSegmentsOnCeilTessFactor);
+    const __m128i fxpFloorWeight = _mm_set1_epi32((int)(FXP_ONE - ctx.fxpHalfTessFactorFraction));
+    const __m128i fxpCeilWeight = _mm_set1_epi32((int)ctx.fxpHalfTessFactorFraction);
+    const __m128i fxpOne = _mm_set1_epi32(FXP_ONE);
+    const __m128i fxpOneHalf = _mm_set1_epi32(FXP_ONE_HALF);
+    const __m128i pointAdvance = _mm_set1_epi32(4*pointStep);
+    __m128i point = _mm_setr_epi32(firstPoint, firstPoint + pointStep, firstPoint + 2*pointStep, firstPoint + 3*pointStep);
+
+    int i = 0;
+    for( ; i + 4 <= numPoints; i += 4 )
+    {
+        // Points in the second half are mirrored into the first half and flipped at the end
+        __m128i bNoFlip = _mm_cmpgt_epi32(numHalfTessFactorPoints, point);
+        __m128i halfPoint = _mm_blendv_epi8(_mm_sub_epi32(mirrorBase, point), point, bNoFlip);
+        __m128i bMiddle = _mm_cmpeq_epi32(halfPoint, numHalfTessFactorPoints);
+
+        __m128i indexOnCeilHalfTessFactor = halfPoint;
+        __m128i indexOnFloorHalfTessFactor = _mm_add_epi32(halfPoint, _mm_cmpgt_epi32(halfPoint, splitPoint)); // -1 past the split point
+
+        __m128i fxpLocationOnFloorHalfTessFactor = _mm_mullo_epi32(indexOnFloorHalfTessFactor, fxpInvFloor);
+        __m128i fxpLocationOnCeilHalfTessFactor = _mm_mullo_epi32(indexOnCeilHalfTessFactor, fxpInvCeil);
+        __m128i fxpLocation = _mm_add_epi32(_mm_mullo_epi32(fxpLocationOnFloorHalfTessFactor, fxpFloorWeight),
+                                            _mm_mullo_epi32(fxpLocationOnCeilHalfTessFactor, fxpCeilWeight));
+        fxpLocation = _mm_srli_epi32(_mm_add_epi32(fxpLocation, fxpOneHalf/*round*/), FXP_FRACTION_BITS); // get back to n.16
+
+        fxpLocation = _mm_blendv_epi8(_mm_sub_epi32(fxpOne, fxpLocation), fxpLocation, bNoFlip);
+        fxpLocation = _mm_blendv_epi8(fxpLocation, fxpOneHalf, bMiddle); // middle is special cased as in the scalar code
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&pfxpLocation[i]), fxpLocation);
+        point = _mm_add_epi32(point, pointAdvance);
+    }
+    return i;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------------
+// PlacePointsIn1D_AVX2
+//---------------------------------------------------------------------------------------------------------------------------------
+TESSELLATOR_TARGET_AVX2 static int PlacePointsIn1D_AVX2( const SIMD_PLACEMENT_CONTEXT& ctx, int firstPoint, int pointStep, int numPoints, FXP* pfxpLocation )
+{
+    const __m256i numHalfTessFactorPoints = _mm256_set1_epi32(ctx.numHalfTessFactorPoints);
+    const __m256i mirrorBase = _mm256_set1_epi32((ctx.numHalfTessFactorPoints << 1) - (ctx.bOdd ? 1 : 0));
+    const __m256i splitPoint = _mm256_set1_epi32(ctx.splitPointOnFloorHalfTessFactor);
+    const __m256i fxpInvFloor = _mm256_set1_epi32((int)ctx.fxpInvNumSegmentsOnFloorTessFactor);
+    const __m256i fxpInvCeil = _mm256_set1_epi32((int)ctx.fxpInvNumSegmentsOnCeilTessFactor);
+    const __m256i fxpFloorWeight = _mm256_set1_epi32((int)(FXP_ONE - ctx.fxpHalfTessFactorFraction));
+    const __m256i fxpCeilWeight = _mm256_set1_epi32((int)ctx.fxpHalfTessFactorFraction);
+    const __m256i fxpOne = _mm256_set1_epi32(FXP_ONE);
+    const __m256i fxpOneHalf = _mm256_set1_epi32(FXP_ONE_HALF);
+    const __m256i pointAdvance = _mm256_set1_epi32(8*pointStep);
+    __m256i point = _mm256_add_epi32(_mm256_set1_epi32(firstPoint),
+                                     _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(pointStep)));
+
+    int i = 0;
+    for( ; i + 8 <= numPoints; i += 8 )
+    {
+        // Points in the second half are mirrored into the first half and flipped at the end
+        __m256i bNoFlip = _mm256_cmpgt_epi32(numHalfTessFactorPoints, point);
+        __m256i halfPoint = _mm256_blendv_epi8(_mm256_sub_epi32(mirrorBase, point), point, bNoFlip);
+        __m256i bMiddle = _mm256_cmpeq_epi32(halfPoint, numHalfTessFactorPoints);
+
+        __m256i indexOnCeilHalfTessFactor = halfPoint;
+        __m256i indexOnFloorHalfTessFactor = _mm256_add_epi32(halfPoint, _mm256_cmpgt_epi32(halfPoint, splitPoint)); // -1 past the split point
+
+        __m256i fxpLocationOnFloorHalfTessFactor = _mm256_mullo_epi32(indexOnFloorHalfTessFactor, fxpInvFloor);
+        __m256i fxpLocationOnCeilHalfTessFactor = _mm256_mullo_epi32(indexOnCeilHalfTessFactor, fxpInvCeil);
+        __m256i fxpLocation = _mm256_add_epi32(_mm256_mullo_epi32(fxpLocationOnFloorHalfTessFactor, fxpFloorWeight),
+                                               _mm256_mullo_epi32(fxpLocationOnCeilHalfTessFactor, fxpCeilWeight));
+        fxpLocation = _mm256_srli_epi32(_mm256_add_epi32(fxpLocation, fxpOneHalf/*round*/), FXP_FRACTION_BITS); // get back to n.16
+
+        fxpLocation = _mm256_blendv_epi8(_mm256_sub_epi32(fxpOne, fxpLocation), fxpLocation, bNoFlip);
+        fxpLocation = _mm256_blendv_epi8(fxpLocation, fxpOneHalf, bMiddle); // middle is special cased as in the scalar code
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&pfxpLocation[i]), fxpLocation);
+        point = _mm256_add_epi32(point, pointAdvance);
+    }
+    return i;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------------
+// DefinePoints_SSE41
+//---------------------------------------------------------------------------------------------------------------------------------
+TESSELLATOR_TARGET_SSE41 static int DefinePoints_SSE41( const FXP* pfxpParam, int numPoints, int uScale, FXP fxpUOffset, int vScale, FXP fxpVOffset, DOMAIN_POINT* pPoint )
+{
+    const __m128i uScaleVec = _mm_set1_epi32(uScale);
+    const __m128i vScaleVec = _mm_set1_epi32(vScale);
+    const __m128i fxpUOffsetVec = _mm_set1_epi32((int)fxpUOffset);
+    const __m128i fxpVOffsetVec = _mm_set1_epi32((int)fxpVOffset);
+    const __m128i fractionMask = _mm_set1_epi32(FXP_FRACTION_MASK);
+    const __m128 fractionScale = _mm_set1_ps(1.0f/(1<<FXP_FRACTION_BITS));
+
+    int i = 0;
+    for( ; i + 4 <= numPoints; i += 4 )
+    {
+        __m128i fxpParam = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pfxpParam[i]));
+        __m128i fxpU = _mm_add_epi32(_mm_mullo_epi32(fxpParam, uScaleVec), fxpUOffsetVec);
+        __m128i fxpV = _mm_add_epi32(_mm_mullo_epi32(fxpParam, vScaleVec), fxpVOffsetVec);
+
+        // fixedToFloat()
+        __m128 u = _mm_add_ps(_mm_cvtepi32_ps(_mm_srli_epi32(fxpU, FXP_FRACTION_BITS)),
+                              _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(fxpU, fractionMask)), fractionScale));
+        __m128 v = _mm_add_ps(_mm_cvtepi32_ps(_mm_srli_epi32(fxpV, FXP_FRACTION_BITS)),
+                              _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(fxpV, fractionMask)), fractionScale));
+
+        float* pDst = &pPoint[i].u;
+        _mm_storeu_ps(pDst, _mm_unpacklo_ps(u, v));
+        _mm_storeu_ps(pDst + 4, _mm_unpackhi_ps(u, v));
+    }
+    return i;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------------
+// DefinePoints_AVX2
+//---------------------------------------------------------------------------------------------------------------------------------
+TESSELLATOR_TARGET_AVX2 static int DefinePoints_AVX2( const FXP* pfxpParam, int numPoints, int uScale, FXP fxpUOffset, int vScale, FXP fxpVOffset, DOMAIN_POINT* pPoint )
+{
+    const __m256i uScaleVec = _mm256_set1_epi32(uScale);
+    const __m256i vScaleVec = _mm256_set1_epi32(vScale);
+    const __m256i fxpUOffsetVec = _mm256_set1_epi32((int)fxpUOffset);
+    const __m256i fxpVOffsetVec = _mm256_set1_epi32((int)fxpVOffset);
+    const __m256i fractionMask = _mm256_set1_epi32(FXP_FRACTION_MASK);
+    const __m256 fractionScale = _mm256_set1_ps(1.0f/(1<<FXP_FRACTION_BITS));
+
+    int i = 0;
+    for( ; i + 8 <= numPoints; i += 8 )
+    {
+        __m256i fxpParam = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&pfxpParam[i]));
+        __m256i fxpU = _mm256_add_epi32(_mm256_mullo_epi32(fxpParam, uScaleVec), fxpUOffsetVec);
+        __m256i fxpV = _mm256_add_epi32(_mm256_mullo_epi32(fxpParam, vScaleVec), fxpVOffsetVec);
+
+        // fixedToFloat()
+        __m256 u = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(fxpU, FXP_FRACTION_BITS)),
+                                 _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(fxpU, fractionMask)), fractionScale));
+        __m256 v = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(fxpV, FXP_FRACTION_BITS)),
+                                 _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(fxpV, fractionMask)), fractionScale));
+
+        // unpack interleaves within 128 bit lanes: lo = {p0,p1 | p4,p5}, hi = {p2,p3 | p6,p7}
+        __m256 lo = _mm256_unpacklo_ps(u, v);
+        __m256 hi = _mm256_unpackhi_ps(u, v);
+        float* pDst = &pPoint[i].u;
+        _mm256_storeu_ps(pDst, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(pDst + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    return i;
+}
+#endif // TESSELLATOR_ENABLE_SIMD
+
 //=================================================================================================================================
 // CHWTessellator
 //=================================================================================================================================
@@ -394,6 +620,8 @@ CHWTessellator::CHWTessellator()
 #ifdef ALLOW_XBOX_360_COMPARISON
 	m_bXBox360Mode = false;
 #endif
+    m_SIMDMode = SIMD_MODE_SCALAR;
+    SetSIMDMode(SIMD_MODE_AVX2);
 }
 //---------------------------------------------------------------------------------------------------------------------------------
 // CHWTessellator::~CHWTessellator
@@ -693,25 +921,33 @@ void CHWTessellator::QuadGeneratePoints( const PROCESSED_TESS_FACTORS_QUAD& proc
         int parity = edge&0x1;
         int startPoint = 0;
         int endPoint = processedTessFactors.numPointsForOutsideEdge[edge] - 1;
-        for(int p = startPoint; p < endPoint; p++,pointOffset++) // don't include end, since next edge starts with it.
+        int numPoints = endPoint - startPoint; // don't include end, since next edge starts with it.
+        if( numPoints <= 0 )
         {
-            FXP fxpParam;
-            int q = ((edge==1)||(edge==2)) ? p : endPoint - p; // reverse order 
-            SetTessellationParity(processedTessFactors.outsideTessFactorParity[edge]);
-            PlacePointIn1D(processedTessFactors.outsideTessFactorCtx[edge],q,fxpParam);
-            if( parity )
-            {
-                DefinePoint(/*U*/fxpParam,
-                            /*V*/(edge == 3) ? FXP_ONE : 0,
-                            /*pointStorageOffset*/pointOffset);
-            }
-            else
-            {
-                DefinePoint(/*U*/(edge == 2) ? FXP_ONE : 0,
-                            /*V*/fxpParam,
-                            /*pointStorageOffset*/pointOffset);
-            }
+            continue;
         }
+        FXP fxpParam[D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR+1];
+        bool bForward = ((edge==1)||(edge==2)); // otherwise reverse order
+        SetTessellationParity(processedTessFactors.outsideTessFactorParity[edge]);
+        PlacePointsIn1D(processedTessFactors.outsideTessFactorCtx[edge],
+                        /*firstPoint*/bForward ? startPoint : endPoint - startPoint,
+                        /*pointStep*/bForward ? 1 : -1,
+                        numPoints,fxpParam);
+        if( parity )
+        {
+            DefinePoints(fxpParam,numPoints,
+                         /*U*/1,0,
+                         /*V*/0,(edge == 3) ? FXP_ONE : 0,
+                         /*pointStorageOffset*/pointOffset);
+        }
+        else
+        {
+            DefinePoints(fxpParam,numPoints,
+                         /*U*/0,(edge == 2) ? FXP_ONE : 0,
+                         /*V*/1,0,
+                         /*pointStorageOffset*/pointOffset);
+        }
+        pointOffset += numPoints;
     }
 
     // Generate interior ring points, clockwise from (U==0,V==1) (bottom-left) spiralling toward center
@@ -732,24 +968,32 @@ void CHWTessellator::QuadGeneratePoints( const PROCESSED_TESS_FACTORS_QUAD& proc
             SetTessellationParity(processedTessFactors.insideTessFactorParity[parity[0]]);
             PlacePointIn1D(processedTessFactors.insideTessFactorCtx[parity[0]],perpendicularAxisPoint,fxpPerpParam);
             SetTessellationParity(processedTessFactors.insideTessFactorParity[parity[1]]);
-            for(int p = startPoint; p < endPoint[parity[1]]; p++, pointOffset++) // don't include end: next edge starts with it. 
+            int numPoints = endPoint[parity[1]] - startPoint; // don't include end: next edge starts with it. 
+            if( numPoints <= 0 )
             {
-                FXP fxpParam;
-                int q = ((edge == 1)||(edge==2)) ? p : endPoint[parity[1]] - (p - startPoint);
-                PlacePointIn1D(processedTessFactors.insideTessFactorCtx[parity[1]],q,fxpParam);
-                if( parity[1] )
-                {
-                    DefinePoint(/*U*/fxpPerpParam,
-                                /*V*/fxpParam,
-                                /*pointStorageOffset*/pointOffset);
-                }
-                else
-                {
-                    DefinePoint(/*U*/fxpParam,
-                                /*V*/fxpPerpParam,
-                                /*pointStorageOffset*/pointOffset);
-                }
+                continue;
             }
+            FXP fxpParam[D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR+1];
+            bool bForward = ((edge == 1)||(edge==2));
+            PlacePointsIn1D(processedTessFactors.insideTessFactorCtx[parity[1]],
+                            /*firstPoint*/bForward ? startPoint : endPoint[parity[1]],
+                            /*pointStep*/bForward ? 1 : -1,
+                            numPoints,fxpParam);
+            if( parity[1] )
+            {
+                DefinePoints(fxpParam,numPoints,
+                             /*U*/0,fxpPerpParam,
+                             /*V*/1,0,
+                             /*pointStorageOffset*/pointOffset);
+            }
+            else
+            {
+                DefinePoints(fxpParam,numPoints,
+                             /*U*/1,0,
+                             /*V*/0,fxpPerpParam,
+                             /*pointStorageOffset*/pointOffset);
+            }
+            pointOffset += numPoints;
         }
     }
     // For even tessellation, the inner "ring" is degenerate - a row of points
@@ -759,13 +1003,16 @@ void CHWTessellator::QuadGeneratePoints( const PROCESSED_TESS_FACTORS_QUAD& proc
         int startPoint = numRings;
         int endPoint = processedTessFactors.numPointsForInsideTessFactor[U] - 1 - startPoint;
         SetTessellationParity(processedTessFactors.insideTessFactorParity[U]);
-        for( int p = startPoint; p <= endPoint; p++, pointOffset++ )
+        int numPoints = endPoint - startPoint + 1;
+        if( numPoints > 0 )
         {
-            FXP fxpParam;
-            PlacePointIn1D(processedTessFactors.insideTessFactorCtx[U],p,fxpParam);
-            DefinePoint(/*U*/fxpParam,
-                        /*V*/FXP_ONE_HALF, // middle
-                        /*pointStorageOffset*/pointOffset);
+            FXP fxpParam[D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR+1];
+            PlacePointsIn1D(processedTessFactors.insideTessFactorCtx[U],startPoint,/*pointStep*/1,numPoints,fxpParam);
+            DefinePoints(fxpParam,numPoints,
+                         /*U*/1,0,
+                         /*V*/0,FXP_ONE_HALF, // middle
+                         /*pointStorageOffset*/pointOffset);
+            pointOffset += numPoints;
         }
     }
     else if( (processedTessFactors.numPointsForInsideTessFactor[V] >= processedTessFactors.numPointsForInsideTessFactor[U]) && 
@@ -773,15 +1020,18 @@ void CHWTessellator::QuadGeneratePoints( const PROCESSED_TESS_FACTORS_QUAD& proc
     {
         int startPoint = numRings;
         int endPoint;
-        FXP fxpParam;
         endPoint = processedTessFactors.numPointsForInsideTessFactor[V] - 1 - startPoint;
         SetTessellationParity(processedTessFactors.insideTessFactorParity[V]);
-        for( int p = endPoint; p >= startPoint; p--, pointOffset++ )
+        int numPoints = endPoint - startPoint + 1;
+        if( numPoints > 0 )
         {
-            PlacePointIn1D(processedTessFactors.insideTessFactorCtx[V],p,fxpParam);
-            DefinePoint(/*U*/FXP_ONE_HALF, // middle
-                        /*V*/fxpParam,
-                        /*pointStorageOffset*/pointOffset);
+            FXP fxpParam[D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR+1];
+            PlacePointsIn1D(processedTessFactors.insideTessFactorCtx[V],endPoint,/*pointStep*/-1,numPoints,fxpParam);
+            DefinePoints(fxpParam,numPoints,
+                         /*U*/0,FXP_ONE_HALF, // middle
+                         /*V*/1,0,
+                         /*pointStorageOffset*/pointOffset);
+            pointOffset += numPoints;
         }
     }
 }
@@ -1199,28 +1449,36 @@ void CHWTessellator::TriGeneratePoints( const PROCESSED_TESS_FACTORS_TRI& proces
         int parity = edge&0x1;
         int startPoint = 0;
         int endPoint = processedTessFactors.numPointsForOutsideEdge[edge] - 1;
-        for(int p = startPoint; p < endPoint; p++, pointOffset++) // don't include end, since next edge starts with it.
-        {
-            FXP fxpParam;
-            int q = (parity) ? p : endPoint - p; // whether to reverse point order given we are defining V or U (W implicit):
-                                                 // edge0, VW, has V decreasing, so reverse 1D points below
-                                                 // edge1, WU, has U increasing, so don't reverse 1D points  below
-                                                 // edge2, UV, has U decreasing, so reverse 1D points below
-            SetTessellationParity(processedTessFactors.outsideTessFactorParity[edge]);
-            PlacePointIn1D(processedTessFactors.outsideTessFactorCtx[edge],q,fxpParam);
-            if( edge == 0 )
-            {
-                DefinePoint(/*U*/0,
-                            /*V*/fxpParam,
-                            /*pointStorageOffset*/pointOffset);
-            }
-            else
-            {
-                DefinePoint(/*U*/fxpParam,
-                            /*V*/(edge == 2) ? FXP_ONE - fxpParam : 0,
-                            /*pointStorageOffset*/pointOffset);
-            }
+        int numPoints = endPoint - startPoint; // don't include end, since next edge starts with it.
+        if( numPoints <= 0 )
+        {
+            continue;
+        }
+        FXP fxpParam[D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR+1];
+        // whether to reverse point order given we are defining V or U (W implicit):
+        // edge0, VW, has V decreasing, so reverse 1D points below
+        // edge1, WU, has U increasing, so don't reverse 1D points  below
+        // edge2, UV, has U decreasing, so reverse 1D points below
+        SetTessellationParity(processedTessFactors.outsideTessFactorParity[edge]);
+        PlacePointsIn1D(processedTessFactors.outsideTessFactorCtx[edge],
+                        /*firstPoint*/(parity) ? startPoint : endPoint - startPoint,
+                        /*pointStep*/(parity) ? 1 : -1,
+                        numPoints,fxpParam);
+        if( edge == 0 )
+        {
+            DefinePoints(fxpParam,numPoints,
+                         /*U*/0,0,
+                         /*V*/1,0,
+                         /*pointStorageOffset*/pointOffset);
         }
+        else
+        {
+            DefinePoints(fxpParam,numPoints,
+                         /*U*/1,0,
+                         /*V*/(edge == 2) ? -1 : 0,(edge == 2) ? FXP_ONE : 0,
+                         /*pointStorageOffset*/pointOffset);
+        }
+        pointOffset += numPoints;
     }
 
     // Generate interior ring points, clockwise spiralling in
@@ -1242,37 +1500,47 @@ void CHWTessellator::TriGeneratePoints( const PROCESSED_TESS_FACTORS_TRI& proces
                                          // I (amarp) can draw a picture to explain.
                                          // We know this fixed point math won't over/underflow
             fxpPerpParam = (fxpPerpParam+FXP_ONE_HALF/*round*/)>>FXP_FRACTION_BITS; // get back to n.16
-            for(int p = startPoint; p < endPoint; p++, pointOffset++) // don't include end: next edge starts with it. 
+            int numPoints = endPoint - startPoint; // don't include end: next edge starts with it. 
+            if( numPoints <= 0 )
             {
-                FXP fxpParam;
-                int q = (parity) ? p : endPoint - (p - startPoint); // whether to reverse point given we are defining V or U (W implicit):
-                                                         // edge0, VW, has V decreasing, so reverse 1D points below
-                                                         // edge1, WU, has U increasing, so don't reverse 1D points  below
-                                                         // edge2, UV, has U decreasing, so reverse 1D points below
-                PlacePointIn1D(processedTessFactors.insideTessFactorCtx,q,fxpParam);
-                // edge0 VW, has perpendicular parameter U constant
-                // edge1 WU, has perpendicular parameter V constant
-                // edge2 UV, has perpendicular parameter W constant 
-                const unsigned int deriv = 2; // reciprocal is the rate of change of edge-parallel parameters as they are pushed into the triangle
-                switch(edge)
-                {
-                case 0:
-                    DefinePoint(/*U*/fxpPerpParam,
-                                /*V*/fxpParam - (fxpPerpParam+1/*round*/)/deriv, // we know this fixed point math won't over/underflow
-                                /*pointStorageOffset*/pointOffset);
-                    break;
-                case 1:
-                    DefinePoint(/*U*/fxpParam - (fxpPerpParam+1/*round*/)/deriv,// we know this fixed point math won't over/underflow
-                                /*V*/fxpPerpParam,
-                                /*pointStorageOffset*/pointOffset);
-                    break;
-                case 2:
-                    DefinePoint(/*U*/fxpParam - (fxpPerpParam+1/*round*/)/deriv,// we know this fixed point math won't over/underflow
-                                /*V*/FXP_ONE - (fxpParam - (fxpPerpParam+1/*round*/)/deriv) - fxpPerpParam,// we know this fixed point math won't over/underflow
-                                /*pointStorageOffset*/pointOffset);
-                    break;
-                }
+                continue;
+            }
+            FXP fxpParam[D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR+1];
+            // whether to reverse point given we are defining V or U (W implicit):
+            // edge0, VW, has V decreasing, so reverse 1D points below
+            // edge1, WU, has U increasing, so don't reverse 1D points  below
+            // edge2, UV, has U decreasing, so reverse 1D points below
+            PlacePointsIn1D(processedTessFactors.insideTessFactorCtx,
+                            /*firstPoint*/(parity) ? startPoint : endPoint,
+                            /*pointStep*/(parity) ? 1 : -1,
+                            numPoints,fxpParam);
+            // edge0 VW, has perpendicular parameter U constant
+            // edge1 WU, has perpendicular parameter V constant
+            // edge2 UV, has perpendicular parameter W constant 
+            const unsigned int deriv = 2; // reciprocal is the rate of change of edge-parallel parameters as they are pushed into the triangle
+            const FXP fxpParallelOffset = (fxpPerpParam+1/*round*/)/deriv; // we know this fixed point math won't over/underflow
+            switch(edge)
+            {
+            case 0:
+                DefinePoints(fxpParam,numPoints,
+                             /*U*/0,fxpPerpParam,
+                             /*V*/1,0 - fxpParallelOffset, // fxpParam - fxpParallelOffset
+                             /*pointStorageOffset*/pointOffset);
+                break;
+            case 1:
+                DefinePoints(fxpParam,numPoints,
+                             /*U*/1,0 - fxpParallelOffset, // fxpParam - fxpParallelOffset
+                             /*V*/0,fxpPerpParam,
+                             /*pointStorageOffset*/pointOffset);
+                break;
+            case 2:
+                DefinePoints(fxpParam,numPoints,
+                             /*U*/1,0 - fxpParallelOffset, // fxpParam - fxpParallelOffset
+                             /*V*/-1,FXP_ONE + fxpParallelOffset - fxpPerpParam, // FXP_ONE - (fxpParam - fxpParallelOffset) - fxpPerpParam
+                             /*pointStorageOffset*/pointOffset);
+                break;
             }
+            pointOffset += numPoints;
         }
     }
     if( !Odd() )
@@ -1492,17 +1760,20 @@ void CHWTessellator::IsoLineGeneratePoints( const PROCESSED_TESS_FACTORS_ISOLINE
     int line, pointOffset;
     for(line = 0, pointOffset = 0; line < processedTessFactors.numLines; line++)
     {
-        for(int point = 0; point < processedTessFactors.numPointsPerLine; point++)
+        if( processedTessFactors.numPointsPerLine <= 0 )
         {
-            FXP fxpU,fxpV;
-            SetTessellationParity(processedTessFactors.lineDensityParity);
-            PlacePointIn1D(processedTessFactors.lineDensityTessFactorCtx,line,fxpV);
+            continue;
+        }
+        FXP fxpU[D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR+1];
+        FXP fxpV;
+        SetTessellationParity(processedTessFactors.lineDensityParity);
+        PlacePointIn1D(processedTessFactors.lineDensityTessFactorCtx,line,fxpV);
 
-            SetTessellationParity(processedTessFactors.lineDetailParity);
-            PlacePointIn1D(processedTessFactors.lineDetailTessFactorCtx,point,fxpU);
+        SetTessellationParity(processedTessFactors.lineDetailParity);
+        PlacePointsIn1D(processedTessFactors.lineDetailTessFactorCtx,/*firstPoint*/0,/*pointStep*/1,processedTessFactors.numPointsPerLine,fxpU);
 
-            DefinePoint(fxpU,fxpV,pointOffset++);
-        }
+        DefinePoints(fxpU,processedTessFactors.numPointsPerLine,/*U*/1,0,/*V*/0,fxpV,pointOffset);
+        pointOffset += processedTessFactors.numPointsPerLine;
     }
 }
 
@@ -1587,6 +1858,30 @@ int CHWTessellator::DefinePoint(FXP fxpU, FXP fxpV, int pointStorageOffset)
     return pointStorageOffset;
 }
 
+//---------------------------------------------------------------------------------------------------------------------------------
+// CHWTessellator::DefinePoints()
+//---------------------------------------------------------------------------------------------------------------------------------
+void CHWTessellator::DefinePoints(const FXP* pfxpParam, int numPoints, int uScale, FXP fxpUOffset, int vScale, FXP fxpVOffset, int pointStorageOffset)
+{
+    int point = 0;
+#if TESSELLATOR_ENABLE_SIMD
+    if( m_SIMDMode == SIMD_MODE_AVX2 )
+    {
+        point = DefinePoints_AVX2(pfxpParam,numPoints,uScale,fxpUOffset,vScale,fxpVOffset,&m_Point[pointStorageOffset]);
+    }
+    else if( m_SIMDMode == SIMD_MODE_SSE41 )
+    {
+        point = DefinePoints_SSE41(pfxpParam,numPoints,uScale,fxpUOffset,vScale,fxpVOffset,&m_Point[pointStorageOffset]);
+    }
+#endif
+    for( ; point < numPoints; point++ )
+    {
+        DefinePoint(/*U*/FXP(uScale)*pfxpParam[point] + fxpUOffset,
+                    /*V*/FXP(vScale)*pfxpParam[point] + fxpVOffset,
+                    /*pointStorageOffset*/pointStorageOffset + point);
+    }
+}
+
 //---------------------------------------------------------------------------------------------------------------------------------
 // CHWTessellator::DefineIndex()
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -1749,6 +2044,58 @@ void CHWTessellator::ComputeTessFactorContext( FXP fxpTessFactor, TESS_FACTOR_CO
     TessFactorCtx.fxpInvNumSegmentsOnCeilTessFactor = s_fixedReciprocal[numCeilSegments];
 }
 
+//---------------------------------------------------------------------------------------------------------------------------------
+// CHWTessellator::PlacePointsIn1D()
+//---------------------------------------------------------------------------------------------------------------------------------
+void CHWTessellator::PlacePointsIn1D( const TESS_FACTOR_CONTEXT& TessFactorCtx, int firstPoint, int pointStep, int numPoints, FXP* pfxpLocation )
+{
+    int i = 0;
+#if TESSELLATOR_ENABLE_SIMD
+    if( m_SIMDMode != SIMD_MODE_SCALAR )
+    {
+        SIMD_PLACEMENT_CONTEXT SIMDCtx;
+        SIMDCtx.fxpInvNumSegmentsOnFloorTessFactor = TessFactorCtx.fxpInvNumSegmentsOnFloorTessFactor;
+        SIMDCtx.fxpInvNumSegmentsOnCeilTessFactor = TessFactorCtx.fxpInvNumSegmentsOnCeilTessFactor;
+        SIMDCtx.fxpHalfTessFactorFraction = TessFactorCtx.fxpHalfTessFactorFraction;
+        SIMDCtx.numHalfTessFactorPoints = TessFactorCtx.numHalfTessFactorPoints;
+        SIMDCtx.splitPointOnFloorHalfTessFactor = TessFactorCtx.splitPointOnFloorHalfTessFactor;
+        SIMDCtx.bOdd = Odd();
+        if( m_SIMDMode == SIMD_MODE_AVX2 )
+        {
+            i = PlacePointsIn1D_AVX2(SIMDCtx,firstPoint,pointStep,numPoints,pfxpLocation);
+        }
+        else
+        {
+            i = PlacePointsIn1D_SSE41(SIMDCtx,firstPoint,pointStep,numPoints,pfxpLocation);
+        }
+    }
+#endif
+    for( ; i < numPoints; i++ ) // scalar reference for whatever didn't fill a full vector
+    {
+        PlacePointIn1D(TessFactorCtx,firstPoint + i*pointStep,pfxpLocation[i]);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------------------
+// CHWTessellator::SetSIMDMode()
+//---------------------------------------------------------------------------------------------------------------------------------
+void CHWTessellator::SetSIMDMode(SIMD_MODE mode)
+{
+#if TESSELLATOR_ENABLE_SIMD
+    if( (mode == SIMD_MODE_AVX2) && !CPUSupportsAVX2() )
+    {
+        mode = SIMD_MODE_SSE41;
+    }
+    if( (mode == SIMD_MODE_SSE41) && !CPUSupportsSSE41() )
+    {
+        mode = SIMD_MODE_SCALAR;
+    }
+#else
+    mode = SIMD_MODE_SCALAR;
+#endif
+    m_SIMDMode = mode;
+}
+
 //---------------------------------------------------------------------------------------------------------------------------------
 // CHWTessellator::PlacePointIn1D()
 //---------------------------------------------------------------------------------------------------------------------------------
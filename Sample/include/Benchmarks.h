@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include <SimpleMath.h>
+#include <vector>
+#include "ResMesh.h"
+#include "CpuPathTracer.h"
+
+class MeshManager;
+
+// 起動時にSampleAppから呼ぶベンチマーク。呼ぶものはSampleApp.cppのBENCHMARK_*で選ぶ。
+// どれも速度や統計をログに出し、結果を総当たりや期待する値と比べて食い違えばエラーをログに出してfalseを返す
+
+// GeometryBenchmarks.cpp
+// レベルごとの時間、メモリ、Meshlet数。細分割した三角形の数とMeshletに入った三角形の数を検証する
+bool BenchmarkLoopSubdivision(const std::vector<ResMesh>& meshes, bool useMetis);
+// ハッシュグリッドの構築、近傍探索、MeshletのAABBとの衝突の時間。近傍の数を総当たりと比べる
+bool BenchmarkParticleSpatialHash(const MeshManager& meshManager);
+
+// BvhBenchmarks.cpp
+// 1スレッドと全スレッドでの構築時間、ノード数、SAHのコスト、レイの交差判定の速度。交差を総当たりと比べる
+bool BenchmarkBvh(const MeshManager& meshManager);
+// BLASとTLASの2段のBVHの構築と、1つのメッシュを動かしたときのRefitの時間。交差を全三角形を1つにしたBVHと比べる
+bool BenchmarkSceneBvh(const MeshManager& meshManager);
+// カメラからのレイとランダムなレイでのBVH4/BVH8の速度。交差を2分木と比べる
+bool BenchmarkWideBvh(const MeshManager& meshManager, uint32_t width, uint32_t height, const DirectX::SimpleMath::Vector3& cameraPosition, const DirectX::SimpleMath::Matrix& invViewProj);
+// CPUのパストレーサでリファレンス画像を描いてHDRで書き出す
+bool RenderPathTracingReference
+(
+	const MeshManager& meshManager,
+	uint32_t width,
+	uint32_t height,
+	const DirectX::SimpleMath::Vector3& cameraPosition,
+	const DirectX::SimpleMath::Matrix& invViewProj,
+	const std::vector<PathTracerDirectionalLight>& directionalLights,
+	const std::vector<PathTracerPointLight>& pointLights,
+	const std::vector<PathTracerSpotLight>& spotLights,
+	const DirectX::SimpleMath::Vector3& skyRadiance
+);
+
+// MemoryBenchmarks.cpp
+// 1～32スレッドでのPool、LockFreePool、マガジン付きのLockFreePoolの確保と解放の速度。確保の失敗と解放漏れを検証する
+bool BenchmarkPool();
+// TlsfAllocatorのロードとアンロードの速度と断片化。範囲の重なり、アラインメント、空きブロックの結合を検証する
+bool BenchmarkTlsfAllocator();
+
+// RenderGraphBenchmarks.cpp
+// RenderGraphのコンパイルと配置の時間。除かれるパスを総当たりと比べ、寿命の重なるリソースがメモリを共有していないことを検証する
+bool BenchmarkRenderGraph();
+// ResourceStateTrackerでまとめたバリアの数。モックのコマンドリストでサブリソースごとの状態の食い違いがないことを検証する
+bool BenchmarkResourceStateTracker();
+// 同時に実行するフレームの数ごとのフレーム時間とCPUの待ち時間。実行中のフレームの資源を使い回していないことを検証する
+bool BenchmarkFramePacing();
+
+// ShaderBenchmarks.cpp
+// ShaderCacheのキーの計算と読み込みの時間。キーが入力の変化に従うことと、キャッシュのファイルの読み書きを検証する
+bool BenchmarkShaderCache();
+// 変わったファイルからコンパイルし直すシェーダを引く時間。引いたシェーダとFileWatcherが見つける更新を検証する
+bool BenchmarkShaderHotReload();
+
+// LoggerBenchmarks.cpp
+// AsyncLoggerの呼び出し側の時間。全てのメッセージが順に正しくフォーマットされることと、捨てた数を数えることを検証する
+bool BenchmarkAsyncLogger();
+
+// JobGraphBenchmarks.cpp
+// JobGraphの実行時間とクリティカルパス。依存するジョブより先に始めたものがないことと、失敗したジョブの後続を実行しないことを検証する
+bool BenchmarkJobGraph();
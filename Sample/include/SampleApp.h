@@ -3,6 +3,7 @@
 #include <SimpleMath.h>
 #include "App.h"
 #include "ShaderCompiler.h"
+#include "ShaderHotReloader.h"
 #include "VertexBuffer.h"
 #include "ConstantBuffer.h"
 #include "ColorTarget.h"
@@ -15,6 +16,9 @@
 #include "SphereMapConverter.h"
 #include "IBLBaker.h"
 #include "SkyBox.h"
+#include "RenderGraph.h"
+#include "AliasingPlanner.h"
+#include "ResourceStateTracker.h"
 
 class SampleApp : public App
 {
@@ -32,6 +36,52 @@ private:
 	// VF[_̒`ƒl̈vKv
 	static constexpr uint32_t MAX_MESH_COUNT = 256;
 
+	// _[Otɓo^郊\[XBOnInit()œo^鏇Ԃƈv
+	enum RENDER_GRAPH_RESOURCE : uint32_t
+	{
+		// C|[g
+		RG_BACK_BUFFER = 0,
+		RG_MESHLET_CULLING_RESULT,
+		RG_HZB,
+		RG_SSGI_HISTORY,
+		RG_VOLUMETRIC_FOG_HISTORY,
+		RG_TEMPORAL_AA_HISTORY,
+		// ꎞ\[X
+		RG_DIR_LIGHT_SHADOW_MAP,
+		RG_SKY_TRANSMITTANCE_LUT,
+		RG_SKY_MULTI_SCATTERING_LUT,
+		RG_SKY_VIEW_LUT,
+		RG_CLOUD_TRACING,
+		RG_CLOUD_SECONDARY_TRACING,
+		RG_CLOUD_TRACING_DEPTH,
+		RG_SCENE_COLOR,
+		RG_GBUFFER_BASE_COLOR,
+		RG_GBUFFER_NORMAL,
+		RG_GBUFFER_METALLIC_ROUGHNESS,
+		RG_GBUFFER_EMISSIVE,
+		RG_VBUFFER,
+		RG_SCENE_DEPTH,
+		RG_HCB,
+		RG_OBJECT_VELOCITY,
+		RG_VELOCITY,
+		RG_SSAO_SETUP,
+		RG_SSAO_HALF_RES,
+		RG_SSAO_FULL_RES,
+		RG_SSGI,
+		RG_SSGI_DENOISE,
+		RG_AMBIENT_LIGHT,
+		RG_SSR,
+		RG_VOLUMETRIC_FOG_INTEGRATION,
+		RG_VOLUMETRIC_COMPOSITION,
+		RG_MOTION_BLUR,
+		RG_BLOOM_SETUP,
+		RG_BLOOM_HORIZONTAL = RG_BLOOM_SETUP + BLOOM_NUM_DOWN_SAMPLE,
+		RG_BLOOM_VERTICAL = RG_BLOOM_HORIZONTAL + BLOOM_NUM_DOWN_SAMPLE,
+		RG_TONEMAP = RG_BLOOM_VERTICAL + BLOOM_NUM_DOWN_SAMPLE,
+		RG_FXAA,
+		RG_RESOURCE_COUNT,
+	};
+
 	// true:n[hR[fBOŔzu͓ICgSkyBoxgSponza`
 	// false:IBLł̃fr[
 	bool m_drawSponza = false;
@@ -45,6 +95,9 @@ private:
 	bool m_usePathTracing = false;
 
 	ShaderCompiler m_ShaderCompiler;
+	// sɃRpCVF[_̃t@CςʃXbhŃRpCBDeferredLightingPSΏ
+	ShaderHotReloader m_ShaderHotReloader;
+	uint32_t m_DeferredLightingPSReloadIdx = UINT32_MAX;
 	Texture m_DummyTexture;
 	ComPtr<ID3D12PipelineState> m_pSkyTransmittanceLUT_PSO;
 	RootSignature m_SkyTransmittanceLUT_RootSig;
@@ -161,16 +214,16 @@ private:
 	ColorTarget m_TonemapTarget;
 	ColorTarget m_FXAA_Target;
 	VertexBuffer m_QuadVB;
-	ConstantBuffer m_CullingCB;
+	ConstantBuffer m_CullingCB[FRAME_COUNT];
 	ConstantBuffer m_DirectionalLightCB[FRAME_COUNT];
-	ConstantBuffer m_PointLightCB[NUM_POINT_LIGHTS];
-	ConstantBuffer m_SpotLightCB[NUM_SPOT_LIGHTS];
+	ConstantBuffer m_PointLightCB[FRAME_COUNT][NUM_POINT_LIGHTS];
+	ConstantBuffer m_SpotLightCB[FRAME_COUNT][NUM_SPOT_LIGHTS];
 	ConstantBuffer m_CameraCB[FRAME_COUNT];
 	ConstantBuffer m_DirLightCameraCB[FRAME_COUNT];
 	ConstantBuffer m_SpotLightCameraCB[NUM_SPOT_LIGHTS];
 	ConstantBuffer m_SkyAtmosphereCB[FRAME_COUNT];
 	ConstantBuffer m_VolumetricCloudCB;
-	ConstantBuffer m_ShadowTransformCB;
+	ConstantBuffer m_ShadowTransformCB[FRAME_COUNT];
 	ConstantBuffer m_HCB_CB;
 	std::vector<ConstantBuffer*> m_pHZB_CBs;
 	ConstantBuffer m_ObjectVelocityCB[FRAME_COUNT];
@@ -178,19 +231,19 @@ private:
 	ConstantBuffer m_SSAOSetupCB;
 	ConstantBuffer m_SSAO_HalfResCB[FRAME_COUNT];
 	ConstantBuffer m_SSAO_FullResCB[FRAME_COUNT];
-	ConstantBuffer m_SSGI_CB;
+	ConstantBuffer m_SSGI_CB[FRAME_COUNT];
 	ConstantBuffer m_SSGI_DenoiseCB;
 	ConstantBuffer m_SSGI_TemporalAccumulationCB;
-	ConstantBuffer m_SSR_CB;
-	ConstantBuffer m_VolumetricFogCB;
+	ConstantBuffer m_SSR_CB[FRAME_COUNT];
+	ConstantBuffer m_VolumetricFogCB[FRAME_COUNT];
 	ConstantBuffer m_TemporalAA_CB[FRAME_COUNT];
-	ConstantBuffer m_MotionBlurCB;
+	ConstantBuffer m_MotionBlurCB[FRAME_COUNT];
 	ConstantBuffer m_TonemapCB[FRAME_COUNT];
-	ConstantBuffer m_FXAA_CB;
+	ConstantBuffer m_FXAA_CB[FRAME_COUNT];
 	ConstantBuffer m_DownsampleCB[BLOOM_NUM_DOWN_SAMPLE - 1];
 	ConstantBuffer m_BloomHorizontalCB[BLOOM_NUM_DOWN_SAMPLE];
 	ConstantBuffer m_BloomVerticalCB[BLOOM_NUM_DOWN_SAMPLE];
-	ConstantBuffer m_BackBufferCB;
+	ConstantBuffer m_BackBufferCB[FRAME_COUNT];
 	ConstantBuffer m_IBL_CB;
 	Texture m_SphereMap;
 	SphereMapConverter m_SphereMapConverter;
@@ -199,7 +252,6 @@ private:
 
 	std::vector<class Model*> m_pModels;
 	MeshManager m_MeshManager;
-	std::vector<DescriptorHandle*> m_pHZB_ParentMipSRVs;
 	float m_RotateAngle;
 	enum class TONE_MAP m_ToneMapType;
 	enum class COLOR_SPACE m_ColorSpace;
@@ -218,6 +270,15 @@ private:
 	DirectX::SimpleMath::Matrix m_PrevWorldForMovable;
 	DirectX::SimpleMath::Matrix m_PrevViewProjNoJitter;
 	DirectX::SimpleMath::Matrix m_PrevViewProjNoJitterForVolumetricFog;
+	RenderGraph m_RenderGraph;
+	// ŌɃOɏoƂ̓v
+	RenderGraphStats m_RenderGraphStats;
+	// ꎞ^[Qbg̎狤Lꍇ̃ʂ̌ςB^[Qbg̓R~bgꂽ\[X̂܂܂ŁA̔zuɂ͒uȂ
+	AliasingPlanner m_AliasingPlanner;
+	// pX̑Jڂ߂ĂApX̋ڂ1ResourceBarrier()ɂ܂Ƃ߂Ĕs
+	ResourceStateTracker m_StateTracker;
+	// ŌɃOɏoƂ̃oA̓v
+	ResourceStateTrackerStats m_StateTrackerStats;
 
 	enum class DEBUG_VIEW_MODE m_debugViewMode;
 	bool m_enableFrustomCulling;
@@ -256,6 +317,8 @@ private:
 	virtual void OnRender() override;
 	virtual bool OnMsgProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp) override;
 	void ChangeDisplayMode(bool hdr);
+	bool CreateDeferredShadingPipeline(IDxcBlob* pPSBlob, const wchar_t* psPath, RootSignature& rootSig, ComPtr<ID3D12PipelineState>& pPSO);
+	void ApplyReloadedShaders();
 	bool isEnableTemporalAA() const;
 	void DrawDirectionalLightShadowMap(ID3D12GraphicsCommandList* pCmdList, const DirectX::SimpleMath::Vector3& lightForward);
 	void DrawSpotLightShadowMap(ID3D12GraphicsCommandList* pCmdList, uint32_t spotLightIdx);
@@ -0,0 +1,605 @@
+﻿#include "Benchmarks.h"
+#include "Logger.h"
+#include "MeshManager.h"
+#include "TriangleBvh.h"
+#include "WideBvh.h"
+#include "SceneBvh.h"
+#include "CpuPathTracer.h"
+#include "ParallelFor.h"
+#include "CounterBasedRandom.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <functional>
+
+using namespace DirectX::SimpleMath;
+
+namespace
+{
+	// 変換やSIMDで計算の順番が変わると、三角形の辺をかすめるレイは丸め誤差で交差の有無が変わることがあるので、
+	// 比べる相手とこの割合までは食い違ってもいい
+	static constexpr double MAX_MISMATCH_RATIO = 0.001;
+
+	bool IsMismatchAcceptable(uint32_t mismatchCount, uint32_t rayCount)
+	{
+		return mismatchCount <= rayCount * MAX_MISMATCH_RATIO;
+	}
+
+	// meshPositionsをworldMatricesでワールド空間に変換し、GetWorldTriangles()と同じ形に並べる
+	void TransformLocalTriangles
+	(
+		const std::vector<std::vector<Vector3>>& meshPositions,
+		const std::vector<Matrix>& worldMatrices,
+		std::vector<Vector3>& positions,
+		std::vector<uint32_t>& meshIndices
+	)
+	{
+		positions.clear();
+		meshIndices.clear();
+		for (uint32_t meshIdx = 0; meshIdx < meshPositions.size(); meshIdx++)
+		{
+			for (const Vector3& position : meshPositions[meshIdx])
+			{
+				positions.push_back(Vector3::Transform(position, worldMatrices[meshIdx]));
+			}
+			meshIndices.insert(meshIndices.end(), meshPositions[meshIdx].size() / 3, meshIdx);
+		}
+	}
+
+	// 全三角形を1つにしたBVHと、レイごとの最も近い交差の距離と三角形を比べる
+	uint32_t ValidateSceneBvh(const SceneBvh& sceneBvh, const TriangleBvh& flatBvh, uint32_t rayCount)
+	{
+		const BvhNode& root = flatBvh.GetBvh().GetNodes()[0];
+		uint32_t mismatchCount = 0;
+		for (uint32_t rayIdx = 0; rayIdx < rayCount; rayIdx++)
+		{
+			// BenchmarkBvh()と同じく、ルートのAABBの中の一様な点から一様な方向に飛ばす
+			uint32_t random[8];
+			GenerateRandom4(rayIdx, 0, 0, 0, &random[0]);
+			GenerateRandom4(rayIdx, 0, 1, 0, &random[4]);
+
+			const Vector3 origin(
+				root.BoundsMin.x + (root.BoundsMax.x - root.BoundsMin.x) * RandomToUnitFloat(random[0]),
+				root.BoundsMin.y + (root.BoundsMax.y - root.BoundsMin.y) * RandomToUnitFloat(random[1]),
+				root.BoundsMin.z + (root.BoundsMax.z - root.BoundsMin.z) * RandomToUnitFloat(random[2])
+			);
+
+			float cosTheta = 1.0f - 2.0f * RandomToUnitFloat(random[3]);
+			float sinTheta = sqrtf(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+			float phi = DirectX::XM_2PI * RandomToUnitFloat(random[4]);
+			const Vector3 direction(sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta);
+
+			TriangleHit sceneHit;
+			TriangleHit flatHit;
+			bool isSceneHit = sceneBvh.Intersect(origin, direction, FLT_MAX, sceneHit);
+			bool isFlatHit = flatBvh.Intersect(origin, direction, FLT_MAX, flatHit);
+			// オブジェクト空間で交差を調べるので距離は丸め誤差を許す
+			if (isSceneHit != isFlatHit || (isSceneHit && fabsf(sceneHit.T - flatHit.T) > 1e-4f * std::max(flatHit.T, 1.0f)))
+			{
+				mismatchCount++;
+			}
+			else if (isSceneHit != sceneBvh.IsOccluded(origin, direction, FLT_MAX))
+			{
+				mismatchCount++;
+			}
+		}
+		return mismatchCount;
+	}
+
+	// [0, count)をParallelForで処理した時間
+	double MeasureParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)>& func)
+	{
+		const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+		ParallelFor(count, grainSize, func);
+		const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	// 交差しなかったレイはFLT_MAXとして、2分木の結果と距離を比べる
+	uint32_t CountMismatches(const std::vector<float>& hitT, const std::vector<float>& referenceT)
+	{
+		uint32_t mismatchCount = 0;
+		for (size_t i = 0; i < hitT.size(); i++)
+		{
+			bool isHit = (hitT[i] != FLT_MAX);
+			bool isReferenceHit = (referenceT[i] != FLT_MAX);
+			// SIMDと2分木で内積の足す順番が違うことがあるので、距離は誤差を許す
+			if (isHit != isReferenceHit || (isHit && fabsf(hitT[i] - referenceT[i]) > 1e-4f * std::max(referenceT[i], 1.0f)))
+			{
+				mismatchCount++;
+			}
+		}
+		return mismatchCount;
+	}
+
+	template<uint32_t Width>
+	bool BenchmarkWideBvhRays
+	(
+		const WideBvh<Width>& bvh,
+		const char* rayName,
+		const std::vector<Vector3>& origins,
+		const std::vector<Vector3>& directions,
+		const std::vector<float>& referenceT
+	)
+	{
+		static constexpr uint32_t RAY_GRAIN_SIZE = 1024;
+		static constexpr uint32_t PACKET_GRAIN_SIZE = RAY_GRAIN_SIZE / Width;
+
+		uint32_t rayCount = static_cast<uint32_t>(origins.size());
+		std::vector<float> hitT(rayCount);
+
+		double singleMsec = MeasureParallelFor(rayCount, RAY_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t rayIdx = begin; rayIdx < end; rayIdx++)
+			{
+				TriangleHit hit;
+				hitT[rayIdx] = bvh.Intersect(origins[rayIdx], directions[rayIdx], FLT_MAX, hit) ? hit.T : FLT_MAX;
+			}
+		});
+		uint32_t singleMismatchCount = CountMismatches(hitT, referenceT);
+
+		// レイの数はWidthの倍数にしてある
+		double packetMsec = MeasureParallelFor(rayCount / Width, PACKET_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+		{
+			float tMax[Width];
+			std::fill(tMax, tMax + Width, FLT_MAX);
+
+			for (uint32_t packetIdx = begin; packetIdx < end; packetIdx++)
+			{
+				uint32_t firstRayIdx = packetIdx * Width;
+				TriangleHit hits[Width];
+				uint32_t hitMask = bvh.IntersectPacket(&origins[firstRayIdx], &directions[firstRayIdx], tMax, Width, hits);
+				for (uint32_t i = 0; i < Width; i++)
+				{
+					hitT[firstRayIdx + i] = (hitMask & (1u << i)) ? hits[i].T : FLT_MAX;
+				}
+			}
+		});
+		uint32_t packetMismatchCount = CountMismatches(hitT, referenceT);
+
+		ELOG("BVH%u %s %u rays : Single %.3f ms %.2f Mrays/s, Packet %.3f ms %.2f Mrays/s, Mismatch Single %u Packet %u (SIMD %s, %u threads)",
+			Width,
+			rayName,
+			rayCount,
+			singleMsec,
+			rayCount / (singleMsec * 1000.0),
+			packetMsec,
+			rayCount / (packetMsec * 1000.0),
+			singleMismatchCount,
+			packetMismatchCount,
+			bvh.IsSIMDEnabled() ? "On" : "Off",
+			GetParallelForThreadCount());
+
+		if (!IsMismatchAcceptable(singleMismatchCount, rayCount) || !IsMismatchAcceptable(packetMismatchCount, rayCount))
+		{
+			ELOG("Error : BVH%u Validation Failed. %u / %u single rays and %u / %u packet rays mismatch.", Width, singleMismatchCount, rayCount, packetMismatchCount, rayCount);
+			return false;
+		}
+
+		return true;
+	}
+}
+
+bool BenchmarkBvh(const MeshManager& meshManager)
+{
+	// 総当たりと結果を比べるレイの数
+	static constexpr uint32_t NUM_VALIDATION_RAYS = 1000;
+	// 速度を計測するレイの数
+	static constexpr uint32_t NUM_BENCHMARK_RAYS = 1000 * 1000;
+	static constexpr uint32_t RAY_GRAIN_SIZE = 1024;
+
+	std::vector<Vector3> positions;
+	std::vector<uint32_t> meshIndices;
+	meshManager.GetWorldTriangles(positions, meshIndices);
+	if (meshIndices.empty())
+	{
+		// 計測するものがない
+		return true;
+	}
+
+	TriangleBvh bvh;
+	for (bool multithreaded : {false, true})
+	{
+		BvhBuildSettings settings;
+		settings.Multithreaded = multithreaded;
+		if (!bvh.Build(positions, meshIndices, settings))
+		{
+			ELOG("Error : TriangleBvh::Build() Failed.");
+			return false;
+		}
+
+		const BvhBuildStats& stats = bvh.GetBvh().GetBuildStats();
+		ELOG("BVH %u triangles : Build %.3f ms (%u threads), %u nodes, %u leaves, Max Depth %u, Max Leaf %u triangles, SAH Cost %.2f, Memory %zu KB",
+			bvh.GetTriangleCount(),
+			stats.BuildMilliseconds,
+			multithreaded ? GetParallelForThreadCount() : 1,
+			stats.NodeCount,
+			stats.LeafCount,
+			stats.MaxDepth,
+			stats.MaxLeafPrimCount,
+			stats.SAHCost,
+			bvh.GetMemorySize() / 1024);
+	}
+
+	// ルートのAABBの中の一様な点から一様な方向に飛ばす
+	const BvhNode& root = bvh.GetBvh().GetNodes()[0];
+	auto generateRay = [&root](uint32_t rayIdx, Vector3& origin, Vector3& direction)
+	{
+		uint32_t random[8];
+		GenerateRandom4(rayIdx, 0, 0, 0, &random[0]);
+		GenerateRandom4(rayIdx, 0, 1, 0, &random[4]);
+
+		origin = Vector3(
+			root.BoundsMin.x + (root.BoundsMax.x - root.BoundsMin.x) * RandomToUnitFloat(random[0]),
+			root.BoundsMin.y + (root.BoundsMax.y - root.BoundsMin.y) * RandomToUnitFloat(random[1]),
+			root.BoundsMin.z + (root.BoundsMax.z - root.BoundsMin.z) * RandomToUnitFloat(random[2])
+		);
+
+		float cosTheta = 1.0f - 2.0f * RandomToUnitFloat(random[3]);
+		float sinTheta = sqrtf(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+		float phi = DirectX::XM_2PI * RandomToUnitFloat(random[4]);
+		direction = Vector3(sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta);
+	};
+
+	uint32_t mismatchCount = 0;
+	for (uint32_t rayIdx = 0; rayIdx < NUM_VALIDATION_RAYS; rayIdx++)
+	{
+		Vector3 origin;
+		Vector3 direction;
+		generateRay(rayIdx, origin, direction);
+
+		TriangleHit bvhHit;
+		TriangleHit bruteForceHit;
+		bool isBvhHit = bvh.Intersect(origin, direction, FLT_MAX, bvhHit);
+		bool isBruteForceHit = bvh.IntersectBruteForce(origin, direction, FLT_MAX, bruteForceHit);
+		// 同じ距離の三角形が複数あるとどちらを返すかは順番次第なので、距離だけ比べる
+		if (isBvhHit != isBruteForceHit || (isBvhHit && bvhHit.T != bruteForceHit.T))
+		{
+			mismatchCount++;
+		}
+	}
+
+	// 総当たりと同じ三角形の交差判定を使うので、食い違いは許さない
+	if (mismatchCount > 0)
+	{
+		ELOG("Error : BVH Validation Failed. %u / %u rays mismatch.", mismatchCount, NUM_VALIDATION_RAYS);
+		return false;
+	}
+
+	std::vector<uint8_t> isHits(NUM_BENCHMARK_RAYS);
+	const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+	ParallelFor(NUM_BENCHMARK_RAYS, RAY_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t rayIdx = begin; rayIdx < end; rayIdx++)
+		{
+			Vector3 origin;
+			Vector3 direction;
+			generateRay(rayIdx, origin, direction);
+
+			TriangleHit hit;
+			isHits[rayIdx] = bvh.Intersect(origin, direction, FLT_MAX, hit) ? 1 : 0;
+		}
+	});
+	const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+	uint32_t hitCount = 0;
+	for (uint8_t isHit : isHits)
+	{
+		hitCount += isHit;
+	}
+
+	double msec = std::chrono::duration<double, std::milli>(end - start).count();
+	ELOG("BVH Closest Hit %u rays : %.3f ms, %.2f Mrays/s, %u hits, Validation %u / %u rays matched (%u threads)",
+		NUM_BENCHMARK_RAYS,
+		msec,
+		NUM_BENCHMARK_RAYS / (msec * 1000.0),
+		hitCount,
+		NUM_VALIDATION_RAYS - mismatchCount,
+		NUM_VALIDATION_RAYS,
+		GetParallelForThreadCount());
+
+	return true;
+}
+
+bool BenchmarkSceneBvh(const MeshManager& meshManager)
+{
+	static constexpr uint32_t NUM_VALIDATION_RAYS = 10000;
+	// 動かすインスタンス。MeshManagerでSetMovableWorldMatrix()が動かすメッシュと同じ
+	static constexpr uint32_t MOVED_INSTANCE_IDX = 2;
+
+	std::vector<std::vector<Vector3>> meshPositions;
+	std::vector<Matrix> worldMatrices;
+	meshManager.GetLocalTriangles(meshPositions, worldMatrices);
+	if (meshPositions.size() <= MOVED_INSTANCE_IDX)
+	{
+		// 動かすインスタンスがない
+		return true;
+	}
+
+	BvhBuildSettings settings;
+	SceneBvh sceneBvh;
+	const std::chrono::steady_clock::time_point& buildStart = std::chrono::steady_clock::now();
+	if (!sceneBvh.Build(meshPositions, worldMatrices, settings))
+	{
+		ELOG("Error : SceneBvh::Build() Failed.");
+		return false;
+	}
+	const std::chrono::steady_clock::time_point& buildEnd = std::chrono::steady_clock::now();
+
+	std::vector<Vector3> positions;
+	std::vector<uint32_t> meshIndices;
+	TransformLocalTriangles(meshPositions, worldMatrices, positions, meshIndices);
+	TriangleBvh flatBvh;
+	if (!flatBvh.Build(positions, meshIndices, settings))
+	{
+		ELOG("Error : TriangleBvh::Build() Failed.");
+		return false;
+	}
+	uint32_t mismatchCount = ValidateSceneBvh(sceneBvh, flatBvh, NUM_VALIDATION_RAYS);
+
+	// 毎フレームの更新と同じく1つのインスタンスだけ動かし、Refitと全三角形の再構築を比べる
+	worldMatrices[MOVED_INSTANCE_IDX] = worldMatrices[MOVED_INSTANCE_IDX] * Matrix::CreateTranslation(0.0f, 0.0f, 1.0f);
+	sceneBvh.SetWorldMatrix(MOVED_INSTANCE_IDX, worldMatrices[MOVED_INSTANCE_IDX]);
+	if (!sceneBvh.Refit())
+	{
+		ELOG("Error : SceneBvh::Refit() Failed.");
+		return false;
+	}
+
+	const std::chrono::steady_clock::time_point& rebuildStart = std::chrono::steady_clock::now();
+	TransformLocalTriangles(meshPositions, worldMatrices, positions, meshIndices);
+	if (!flatBvh.Build(positions, meshIndices, settings))
+	{
+		ELOG("Error : TriangleBvh::Build() Failed.");
+		return false;
+	}
+	const std::chrono::steady_clock::time_point& rebuildEnd = std::chrono::steady_clock::now();
+	uint32_t movedMismatchCount = ValidateSceneBvh(sceneBvh, flatBvh, NUM_VALIDATION_RAYS);
+
+	ELOG("Scene BVH %u instances %u triangles : Build %.3f ms, Memory %zu KB, Refit %u instances %.4f ms, Flat Rebuild %.3f ms, Validation %u / %u rays matched, after move %u / %u (%u threads)",
+		sceneBvh.GetInstanceCount(),
+		sceneBvh.GetTriangleCount(),
+		std::chrono::duration<double, std::milli>(buildEnd - buildStart).count(),
+		sceneBvh.GetMemorySize() / 1024,
+		sceneBvh.GetLastRefitInstanceCount(),
+		sceneBvh.GetLastRefitMilliseconds(),
+		std::chrono::duration<double, std::milli>(rebuildEnd - rebuildStart).count(),
+		NUM_VALIDATION_RAYS - mismatchCount,
+		NUM_VALIDATION_RAYS,
+		NUM_VALIDATION_RAYS - movedMismatchCount,
+		NUM_VALIDATION_RAYS,
+		GetParallelForThreadCount());
+
+	if (!IsMismatchAcceptable(mismatchCount, NUM_VALIDATION_RAYS) || !IsMismatchAcceptable(movedMismatchCount, NUM_VALIDATION_RAYS))
+	{
+		ELOG("Error : Scene BVH Validation Failed. %u / %u rays mismatch, after move %u / %u.", mismatchCount, NUM_VALIDATION_RAYS, movedMismatchCount, NUM_VALIDATION_RAYS);
+		return false;
+	}
+
+	return true;
+}
+
+bool BenchmarkWideBvh(const MeshManager& meshManager, uint32_t width, uint32_t height, const Vector3& cameraPosition, const Matrix& invViewProj)
+{
+	static constexpr uint32_t NUM_INCOHERENT_RAYS = 1000 * 1000;
+	static constexpr uint32_t RAY_GRAIN_SIZE = 1024;
+	// カメラからのレイは横4x縦2ピクセルずつ並べ、BVH8のパケットは4x2、BVH4のパケットは4x1のピクセルになるようにする
+	static constexpr uint32_t TILE_WIDTH = 4;
+	static constexpr uint32_t TILE_HEIGHT = 2;
+
+	std::vector<Vector3> positions;
+	std::vector<uint32_t> meshIndices;
+	meshManager.GetWorldTriangles(positions, meshIndices);
+	if (meshIndices.empty())
+	{
+		// 計測するものがない
+		return true;
+	}
+
+	TriangleBvh binaryBvh;
+	Bvh4 bvh4;
+	Bvh8 bvh8;
+	BvhBuildSettings settings;
+	if (!binaryBvh.Build(positions, meshIndices, settings) || !bvh4.Build(positions, meshIndices, settings) || !bvh8.Build(positions, meshIndices, settings))
+	{
+		ELOG("Error : BVH Build Failed.");
+		return false;
+	}
+
+	auto logBuildStats = [](uint32_t bvhWidth, const WideBvhBuildStats& stats, size_t memorySize)
+	{
+		ELOG("BVH%u : Binary Build %.3f ms, Collapse %.3f ms, %u nodes, %u leaves, %u packets, Max Depth %u, %.2f children/node, Packet Occupancy %.1f%%, Memory %zu KB",
+			bvhWidth,
+			stats.BinaryBuildMilliseconds,
+			stats.CollapseMilliseconds,
+			stats.NodeCount,
+			stats.LeafCount,
+			stats.PacketCount,
+			stats.MaxDepth,
+			stats.AverageChildCount,
+			stats.PacketOccupancy * 100.0f,
+			memorySize / 1024);
+	};
+	logBuildStats(4, bvh4.GetBuildStats(), bvh4.GetMemorySize());
+	logBuildStats(8, bvh8.GetBuildStats(), bvh8.GetMemorySize());
+
+	// 画面の端で余ったピクセルは端のピクセルで埋める
+	uint32_t tileCountX = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+	uint32_t tileCountY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+	uint32_t primaryRayCount = tileCountX * tileCountY * TILE_WIDTH * TILE_HEIGHT;
+	std::vector<Vector3> primaryOrigins(primaryRayCount, cameraPosition);
+	std::vector<Vector3> primaryDirections(primaryRayCount);
+	for (uint32_t rayIdx = 0; rayIdx < primaryRayCount; rayIdx++)
+	{
+		uint32_t tileIdx = rayIdx / (TILE_WIDTH * TILE_HEIGHT);
+		uint32_t pixelInTile = rayIdx % (TILE_WIDTH * TILE_HEIGHT);
+		uint32_t x = std::min((tileIdx % tileCountX) * TILE_WIDTH + pixelInTile % TILE_WIDTH, width - 1);
+		uint32_t y = std::min((tileIdx / tileCountX) * TILE_HEIGHT + pixelInTile / TILE_WIDTH, height - 1);
+
+		float ndcX = (x + 0.5f) / width * 2.0f - 1.0f;
+		float ndcY = 1.0f - (y + 0.5f) / height * 2.0f;
+		primaryDirections[rayIdx] = Vector3::Transform(Vector3(ndcX, ndcY, 1.0f), invViewProj) - cameraPosition;
+		primaryDirections[rayIdx].Normalize();
+	}
+
+	// BenchmarkBvh()と同じく、ルートのAABBの中の一様な点から一様な方向に飛ばす
+	const BvhNode& root = binaryBvh.GetBvh().GetNodes()[0];
+	std::vector<Vector3> incoherentOrigins(NUM_INCOHERENT_RAYS);
+	std::vector<Vector3> incoherentDirections(NUM_INCOHERENT_RAYS);
+	for (uint32_t rayIdx = 0; rayIdx < NUM_INCOHERENT_RAYS; rayIdx++)
+	{
+		uint32_t random[8];
+		GenerateRandom4(rayIdx, 0, 0, 0, &random[0]);
+		GenerateRandom4(rayIdx, 0, 1, 0, &random[4]);
+
+		incoherentOrigins[rayIdx] = Vector3(
+			root.BoundsMin.x + (root.BoundsMax.x - root.BoundsMin.x) * RandomToUnitFloat(random[0]),
+			root.BoundsMin.y + (root.BoundsMax.y - root.BoundsMin.y) * RandomToUnitFloat(random[1]),
+			root.BoundsMin.z + (root.BoundsMax.z - root.BoundsMin.z) * RandomToUnitFloat(random[2])
+		);
+
+		float cosTheta = 1.0f - 2.0f * RandomToUnitFloat(random[3]);
+		float sinTheta = sqrtf(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+		float phi = DirectX::XM_2PI * RandomToUnitFloat(random[4]);
+		incoherentDirections[rayIdx] = Vector3(sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta);
+	}
+
+	const char* rayNames[] = {"Primary", "Incoherent"};
+	const std::vector<Vector3>* pOrigins[] = {&primaryOrigins, &incoherentOrigins};
+	const std::vector<Vector3>* pDirections[] = {&primaryDirections, &incoherentDirections};
+	for (uint32_t i = 0; i < _countof(rayNames); i++)
+	{
+		const std::vector<Vector3>& origins = *pOrigins[i];
+		const std::vector<Vector3>& directions = *pDirections[i];
+		uint32_t rayCount = static_cast<uint32_t>(origins.size());
+
+		// 2分木の結果を正解にする
+		std::vector<float> referenceT(rayCount);
+		double binaryMsec = MeasureParallelFor(rayCount, RAY_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t rayIdx = begin; rayIdx < end; rayIdx++)
+			{
+				TriangleHit hit;
+				referenceT[rayIdx] = binaryBvh.Intersect(origins[rayIdx], directions[rayIdx], FLT_MAX, hit) ? hit.T : FLT_MAX;
+			}
+		});
+
+		ELOG("BVH2 %s %u rays : Single %.3f ms %.2f Mrays/s (%u threads)",
+			rayNames[i],
+			rayCount,
+			binaryMsec,
+			rayCount / (binaryMsec * 1000.0),
+			GetParallelForThreadCount());
+
+		if (!BenchmarkWideBvhRays(bvh4, rayNames[i], origins, directions, referenceT)
+			|| !BenchmarkWideBvhRays(bvh8, rayNames[i], origins, directions, referenceT))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool RenderPathTracingReference
+(
+	const MeshManager& meshManager,
+	uint32_t width,
+	uint32_t height,
+	const Vector3& cameraPosition,
+	const Matrix& invViewProj,
+	const std::vector<PathTracerDirectionalLight>& directionalLights,
+	const std::vector<PathTracerPointLight>& pointLights,
+	const std::vector<PathTracerSpotLight>& spotLights,
+	const Vector3& skyRadiance
+)
+{
+	static constexpr uint32_t NUM_SAMPLES = 256;
+	// 途中経過をログに出すサンプル数の間隔
+	static constexpr uint32_t LOG_INTERVAL = 16;
+	static constexpr wchar_t OUTPUT_FILENAME[] = L"PathTracingReference.hdr";
+
+	std::vector<Vector3> positions;
+	std::vector<Vector3> normals;
+	std::vector<uint32_t> meshIndices;
+	meshManager.GetWorldTriangles(positions, meshIndices);
+	meshManager.GetWorldTriangleNormals(normals);
+
+	// テクスチャはGPUにしかないので、マテリアルは係数だけを使う
+	std::vector<PathTracerMaterial> materials(meshManager.GetMeshCount());
+	for (uint32_t meshIdx = 0; meshIdx < materials.size(); meshIdx++)
+	{
+		const ResMaterial& resMaterial = meshManager.GetResMaterial(meshManager.GetMaterialIdx(meshIdx));
+		materials[meshIdx].BaseColor = resMaterial.BaseColor;
+		materials[meshIdx].Metallic = resMaterial.MetallicFactor;
+		materials[meshIdx].Roughness = resMaterial.RoughnessFactor;
+		// BasePassPS.hlsliと同じくエミッシブテクスチャがなければ発光しない
+		materials[meshIdx].Emissive = resMaterial.EmissiveMap.empty() ? Vector3::Zero : resMaterial.EmissiveFactor;
+	}
+
+	PathTracerSettings settings;
+	settings.SkyRadiance = skyRadiance;
+
+	CpuPathTracer pathTracer;
+	if (!pathTracer.Init(positions, normals, meshIndices, materials, settings))
+	{
+		ELOG("Error : CpuPathTracer::Init() Failed.");
+		return false;
+	}
+
+	ELOG("Path Tracing Reference : %u triangles, BVH Build %.3f ms, %ux%u, %u samples (%u threads)",
+		pathTracer.GetBvh().GetTriangleCount(),
+		pathTracer.GetBvh().GetBvh().GetBuildStats().BuildMilliseconds,
+		width,
+		height,
+		NUM_SAMPLES,
+		GetParallelForThreadCount());
+
+	pathTracer.SetResolution(width, height);
+	pathTracer.SetCamera(cameraPosition, invViewProj);
+	pathTracer.SetLights(directionalLights, pointLights, spotLights);
+
+	double totalMsec = 0.0;
+	uint64_t totalRayCount = 0;
+	for (uint32_t i = 0; i < NUM_SAMPLES; i++)
+	{
+		pathTracer.RenderSample();
+		totalMsec += pathTracer.GetLastMilliseconds();
+		totalRayCount += pathTracer.GetLastRayCount();
+
+		if (pathTracer.GetSampleCount() % LOG_INTERVAL == 0)
+		{
+			ELOG("Path Tracing Reference %u / %u samples : %.3f ms/sample, %.2f Mrays/s",
+				pathTracer.GetSampleCount(),
+				NUM_SAMPLES,
+				pathTracer.GetLastMilliseconds(),
+				pathTracer.GetLastRayCount() / (pathTracer.GetLastMilliseconds() * 1000.0));
+		}
+	}
+
+	ELOG("Path Tracing Reference : Total %.3f s, %llu rays, %.2f Mrays/s",
+		totalMsec / 1000.0,
+		totalRayCount,
+		totalRayCount / (totalMsec * 1000.0));
+
+	// 放射輝度は負にもNaNにもならない
+	std::vector<float> pixels;
+	pathTracer.Resolve(pixels);
+	for (size_t i = 0; i < pixels.size(); i++)
+	{
+		if (!(pixels[i] >= 0.0f) || std::isinf(pixels[i]))
+		{
+			ELOG("Error : Invalid Radiance. pixel = %zu, value = %f", i / 3, pixels[i]);
+			return false;
+		}
+	}
+
+	if (!pathTracer.SaveHDR(OUTPUT_FILENAME))
+	{
+		ELOG("Error : CpuPathTracer::SaveHDR() Failed.");
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,231 @@
+﻿#include "Benchmarks.h"
+#include "Logger.h"
+#include "MeshManager.h"
+#include "LoopSubdivision.h"
+#include "ParallelFor.h"
+#include "ParticleSimulator.h"
+#include "SpatialHashGrid.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace DirectX::SimpleMath;
+
+bool BenchmarkLoopSubdivision(const std::vector<ResMesh>& meshes, bool useMetis)
+{
+	static constexpr uint32_t MAX_LEVEL = 3;
+
+	for (size_t meshIdx = 0; meshIdx < meshes.size(); meshIdx++)
+	{
+		const ResMesh& mesh = meshes[meshIdx];
+
+		LoopSubdivision subdivision;
+		if (!subdivision.Init(mesh, MAX_LEVEL, true))
+		{
+			ELOG("Error : LoopSubdivision::Init() Failed. mesh = %zu", meshIdx);
+			continue;
+		}
+
+		for (uint32_t level = 0; level <= MAX_LEVEL; level++)
+		{
+			const LoopSubdivision::LevelInfo& info = subdivision.GetLevelInfo(level);
+
+			ResMesh result;
+			std::vector<double> levelMilliseconds;
+			if (!subdivision.Evaluate(mesh, level, result, &levelMilliseconds))
+			{
+				ELOG("Error : LoopSubdivision::Evaluate() Failed. mesh = %zu, level = %u", meshIdx, level);
+				return false;
+			}
+
+			// 1回細分割するごとに三角形は4つに分かれる
+			if (result.Vertices.size() != info.AttributeCount
+				|| result.Indices.size() != static_cast<size_t>(info.TriangleCount) * 3
+				|| (level > 0 && info.TriangleCount != subdivision.GetLevelInfo(level - 1).TriangleCount * 4))
+			{
+				ELOG("Error : Subdivided Mesh Size Mismatch. mesh = %zu, level = %u", meshIdx, level);
+				return false;
+			}
+
+			const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+			BuildMeshlet(result, useMetis);
+			const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+			// Meshletは全ての三角形を1回ずつ含む
+			size_t meshletTriangleCount = 0;
+			for (const meshopt_Meshlet& meshlet : result.Meshlets)
+			{
+				meshletTriangleCount += meshlet.triangle_count;
+			}
+			if (meshletTriangleCount != info.TriangleCount)
+			{
+				ELOG("Error : Meshlet Triangle Count Mismatch. mesh = %zu, level = %u", meshIdx, level);
+				return false;
+			}
+
+			double evaluateMsec = 0.0;
+			for (double msec : levelMilliseconds)
+			{
+				evaluateMsec += msec;
+			}
+
+			ELOG("Loop Subdivision Mesh %zu Level %u : Positions %u, Vertices %u, Triangles %u, Memory %zu KB, Build %.3f ms, Evaluate %.3f ms, Meshlets %zu, BuildMeshlet %.3f ms (%u threads)",
+				meshIdx,
+				level,
+				info.VertexCount,
+				info.AttributeCount,
+				info.TriangleCount,
+				info.MemorySize / 1024,
+				info.BuildMilliseconds,
+				evaluateMsec,
+				result.Meshlets.size(),
+				std::chrono::duration<double, std::milli>(end - start).count(),
+				GetParallelForThreadCount());
+		}
+	}
+
+	return true;
+}
+
+bool BenchmarkParticleSpatialHash(const MeshManager& meshManager)
+{
+	static constexpr uint32_t NUM_PARTICLES[] = {100 * 1000, 1000 * 1000};
+	static constexpr uint32_t NUM_ITERATIONS = 10;
+	// パーティクルを撒くフレーム数
+	static constexpr uint32_t NUM_SPAWN_FRAMES = 120;
+	static constexpr float PARTICLE_RADIUS = 0.02f;
+	static constexpr float NEIGHBOR_RADIUS = 0.05f;
+	static constexpr float AABB_CELL_SIZE = 0.5f;
+	static constexpr float RESTITUTION = 0.5f;
+	// 総当たりと近傍の数を比べるパーティクルの数
+	static constexpr uint32_t NUM_VALIDATION_PARTICLES = 256;
+
+	std::vector<AABB> aabbs;
+	meshManager.GetMeshletWorldAABBs(aabbs);
+
+	AABBHashGrid aabbGrid;
+	const std::chrono::steady_clock::time_point& aabbStart = std::chrono::steady_clock::now();
+	if (!aabbGrid.Build(aabbs, AABB_CELL_SIZE, static_cast<uint32_t>(aabbs.size()) * 4, PARTICLE_RADIUS))
+	{
+		ELOG("Error : AABBHashGrid::Build() Failed.");
+		return false;
+	}
+	const std::chrono::steady_clock::time_point& aabbEnd = std::chrono::steady_clock::now();
+
+	ELOG("AABB Hash Grid : %u meshlet AABBs, %u entries, Memory %zu KB, Build %.3f ms",
+		aabbGrid.GetAABBCount(),
+		aabbGrid.GetEntryCount(),
+		aabbGrid.GetMemorySize() / 1024,
+		std::chrono::duration<double, std::milli>(aabbEnd - aabbStart).count());
+
+	for (uint32_t numParticles : NUM_PARTICLES)
+	{
+		ParticleSimulator simulator;
+		if (!simulator.Init(numParticles))
+		{
+			ELOG("Error : ParticleSimulator::Init() Failed.");
+			return false;
+		}
+
+		// 原点から撒いてシーンに落とす
+		ParticleUpdateDesc desc;
+		desc.NumSpawnPerFrame = (numParticles + NUM_SPAWN_FRAMES - 1) / NUM_SPAWN_FRAMES;
+		desc.InitialLife = UINT32_MAX;
+		desc.DeltaTime = 1.0f / 60.0f;
+		desc.InitialVelocityScale = 3.0f;
+		desc.RandomSeed = 0;
+
+		for (uint32_t i = 0; i < NUM_SPAWN_FRAMES; i++)
+		{
+			desc.FrameIndex = i;
+			simulator.Update(desc);
+			simulator.CollideWithAABBs(aabbGrid, PARTICLE_RADIUS, RESTITUTION);
+		}
+		desc.NumSpawnPerFrame = 0;
+
+		SpatialHashGrid grid;
+		grid.Init(NEIGHBOR_RADIUS * 2.0f, numParticles);
+		std::vector<uint32_t> neighborCounts(numParticles);
+
+		double collideMsec = 0.0;
+		double buildMsec = 0.0;
+		double queryMsec = 0.0;
+		uint32_t hitCount = 0;
+		uint64_t neighborCount = 0;
+
+		for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+		{
+			simulator.Update(desc);
+
+			const std::chrono::steady_clock::time_point& collideStart = std::chrono::steady_clock::now();
+			hitCount = simulator.CollideWithAABBs(aabbGrid, PARTICLE_RADIUS, RESTITUTION);
+			const std::chrono::steady_clock::time_point& buildStart = std::chrono::steady_clock::now();
+			grid.Build(simulator.GetNumParticles(), simulator.GetPositionX(), simulator.GetPositionY(), simulator.GetPositionZ());
+			const std::chrono::steady_clock::time_point& queryStart = std::chrono::steady_clock::now();
+
+			const float* pPositionX = simulator.GetPositionX();
+			const float* pPositionY = simulator.GetPositionY();
+			const float* pPositionZ = simulator.GetPositionZ();
+			ParallelFor(simulator.GetNumParticles(), 4096, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t p = begin; p < end; p++)
+				{
+					uint32_t count = 0;
+					grid.ForEachNeighbor(Vector3(pPositionX[p], pPositionY[p], pPositionZ[p]), NEIGHBOR_RADIUS, [&count](uint32_t, float)
+					{
+						count++;
+					});
+					neighborCounts[p] = count;
+				}
+			});
+			const std::chrono::steady_clock::time_point& queryEnd = std::chrono::steady_clock::now();
+
+			collideMsec += std::chrono::duration<double, std::milli>(buildStart - collideStart).count();
+			buildMsec += std::chrono::duration<double, std::milli>(queryStart - buildStart).count();
+			queryMsec += std::chrono::duration<double, std::milli>(queryEnd - queryStart).count();
+		}
+
+		neighborCount = 0;
+		for (uint32_t p = 0; p < simulator.GetNumParticles(); p++)
+		{
+			neighborCount += neighborCounts[p];
+		}
+
+		// 最後に構築したグリッドの近傍の数を、全パーティクルとの総当たりと比べる。距離の計算はTestPoint()と同じ順にする
+		const float* pPositionX = simulator.GetPositionX();
+		const float* pPositionY = simulator.GetPositionY();
+		const float* pPositionZ = simulator.GetPositionZ();
+		uint32_t validationStride = std::max(simulator.GetNumParticles() / NUM_VALIDATION_PARTICLES, 1u);
+		for (uint32_t p = 0; p < simulator.GetNumParticles(); p += validationStride)
+		{
+			uint32_t count = 0;
+			for (uint32_t q = 0; q < simulator.GetNumParticles(); q++)
+			{
+				float dx = pPositionX[q] - pPositionX[p];
+				float dy = pPositionY[q] - pPositionY[p];
+				float dz = pPositionZ[q] - pPositionZ[p];
+				if (dx * dx + dy * dy + dz * dz <= NEIGHBOR_RADIUS * NEIGHBOR_RADIUS)
+				{
+					count++;
+				}
+			}
+
+			if (count != neighborCounts[p])
+			{
+				ELOG("Error : Neighbor Count Mismatch. particle = %u, grid = %u, brute force = %u", p, neighborCounts[p], count);
+				return false;
+			}
+		}
+
+		ELOG("Particle Spatial Hash %u particles : Build %.3f ms, Neighbor Query %.3f ms (avg %.1f neighbors), AABB Collision %.3f ms (%u hits), Grid Memory %zu KB (%u threads)",
+			simulator.GetNumParticles(),
+			buildMsec / NUM_ITERATIONS,
+			queryMsec / NUM_ITERATIONS,
+			static_cast<double>(neighborCount) / std::max(simulator.GetNumParticles(), 1u),
+			collideMsec / NUM_ITERATIONS,
+			hitCount,
+			grid.GetMemorySize() / 1024,
+			GetParallelForThreadCount());
+	}
+
+	return true;
+}
@@ -0,0 +1,110 @@
+﻿#include "Benchmarks.h"
+#include "Logger.h"
+#include "JobGraph.h"
+#include "ParallelFor.h"
+#include "CounterBasedRandom.h"
+#include <algorithm>
+#include <atomic>
+
+bool BenchmarkJobGraph()
+{
+	static constexpr uint32_t NUM_JOBS = 64;
+	static constexpr uint32_t MAX_DEPENDENCIES = 3;
+	static constexpr uint32_t WORK_ITERATIONS = 200000;
+
+	// 起動時のパイプラインの生成のように、ほとんどのジョブは独立していて、一部だけが前のジョブに依存する
+	std::vector<std::vector<uint32_t>> dependencies(NUM_JOBS);
+	for (uint32_t jobIdx = 0; jobIdx < NUM_JOBS; jobIdx++)
+	{
+		uint32_t random[4];
+		GenerateRandom4(jobIdx, 0, 0, 0, random);
+		if (jobIdx == 0 || (random[0] % 4) != 0)
+		{
+			continue;
+		}
+
+		uint32_t dependencyCount = 1 + random[1] % MAX_DEPENDENCIES;
+		for (uint32_t i = 0; i < dependencyCount; i++)
+		{
+			uint32_t dependency = random[2 + i % 2] % jobIdx;
+			if (std::find(dependencies[jobIdx].begin(), dependencies[jobIdx].end(), dependency) == dependencies[jobIdx].end())
+			{
+				dependencies[jobIdx].push_back(dependency);
+			}
+			random[2 + i % 2] = random[2 + i % 2] * 1664525u + 1013904223u;
+		}
+	}
+
+	std::vector<std::atomic<uint32_t>> results(NUM_JOBS);
+	std::atomic<uint32_t> orderErrorCount = 0;
+
+	JobGraph jobGraph;
+	for (uint32_t jobIdx = 0; jobIdx < NUM_JOBS; jobIdx++)
+	{
+		jobGraph.AddJob("Job", dependencies[jobIdx], [&, jobIdx](uint32_t workerIndex) -> bool
+		{
+			for (uint32_t dependency : dependencies[jobIdx])
+			{
+				if (results[dependency].load() == 0)
+				{
+					orderErrorCount++;
+				}
+			}
+
+			// ジョブの時間がばらつくように、インデックスで仕事の量を変える
+			uint32_t value = jobIdx + 1;
+			uint32_t iterations = WORK_ITERATIONS * (1 + jobIdx % 4);
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				value = value * 1664525u + 1013904223u;
+			}
+			results[jobIdx] = value | 1;
+			return true;
+		});
+	}
+
+	if (!jobGraph.Run(GetParallelForThreadCount()))
+	{
+		ELOG("Error : JobGraph::Run() Failed.");
+		return false;
+	}
+
+	for (uint32_t jobIdx = 0; jobIdx < NUM_JOBS; jobIdx++)
+	{
+		if (results[jobIdx].load() == 0)
+		{
+			ELOG("Error : Job is not Executed. job = %u", jobIdx);
+			return false;
+		}
+	}
+	if (orderErrorCount.load() != 0)
+	{
+		ELOG("Error : Job Started before its Dependencies. count = %u", orderErrorCount.load());
+		return false;
+	}
+
+	const JobGraphStats& stats = jobGraph.GetStats();
+	ELOG("JobGraph : %u jobs on %u workers, %.2f ms (serial %.2f ms, critical path %.2f ms)",
+		stats.JobCount,
+		stats.WorkerCount,
+		stats.TotalMilliseconds,
+		stats.SerialMilliseconds,
+		stats.CriticalPathMilliseconds);
+
+	// 失敗したジョブに依存するジョブは実行しない
+	JobGraph failingGraph;
+	bool isDependentExecuted = false;
+	uint32_t failingJob = failingGraph.AddJob("Failing", {}, [](uint32_t workerIndex) -> bool { return false; });
+	failingGraph.AddJob("Dependent", {failingJob}, [&](uint32_t workerIndex) -> bool
+	{
+		isDependentExecuted = true;
+		return true;
+	});
+	if (failingGraph.Run(GetParallelForThreadCount()) || isDependentExecuted)
+	{
+		ELOG("Error : JobGraph Ignored a Failed Job.");
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,283 @@
+﻿#include "Benchmarks.h"
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace
+{
+	// 書き出されたテキストを1行ずつ、スレッドごとの順で同期でフォーマットしたものと比べる
+	bool ValidateAsyncLogger()
+	{
+		static constexpr uint32_t NUM_THREADS = 4;
+		static constexpr uint32_t NUM_MESSAGES = 10000;
+		static constexpr uint32_t LONG_MESSAGE_INTERVAL = 1000;
+		static constexpr char FORMAT[] = "thread %u message %u value %.3f name %s wide %ls\n";
+		static const char* const NAMES[] = {"Sponza", "FlowerVase", ""};
+
+		// シェーダのコンパイルエラーのように、レコードに入らない長さの文字列もときどき混ぜる
+		const std::string& longName = std::string(3000, 'x');
+		auto getName = [&](uint32_t i) { return (i % LONG_MESSAGE_INTERVAL == 0) ? longName.c_str() : NAMES[i % 3]; };
+
+		std::string output;
+		AsyncLogger logger;
+		if (!logger.Init(65536, [&](const char* text, size_t length) { output.append(text, length); }))
+		{
+			ELOG("Error : AsyncLogger::Init() Failed.");
+			return false;
+		}
+
+		std::vector<std::thread> threads;
+		for (uint32_t threadIdx = 0; threadIdx < NUM_THREADS; threadIdx++)
+		{
+			threads.emplace_back([&, threadIdx]()
+			{
+				for (uint32_t i = 0; i < NUM_MESSAGES; i++)
+				{
+					// 呼び出した後にすぐ消える文字列も、コピーしてあるので正しく出る
+					const std::wstring& wide = std::to_wstring(i);
+					logger.Write(LOG_SEVERITY_INFO, "Validate.cpp", threadIdx, FORMAT, threadIdx, i, i * 0.5, getName(i), wide.c_str());
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		logger.Flush();
+
+		const LogStats& stats = logger.GetStats();
+		if (stats.WrittenCount != NUM_THREADS * NUM_MESSAGES || stats.DroppedCount != 0 || stats.TruncatedCount != 0)
+		{
+			ELOG("Error : AsyncLogger Lost Messages. written = %llu, dropped = %llu, truncated = %llu", stats.WrittenCount, stats.DroppedCount, stats.TruncatedCount);
+			return false;
+		}
+
+		std::vector<uint32_t> nextIndices(NUM_THREADS, 0);
+		std::vector<char> expected;
+		size_t lineBegin = 0;
+		while (lineBegin < output.size())
+		{
+			size_t lineEnd = output.find('\n', lineBegin);
+			size_t fileBegin = output.find("][File : Validate.cpp, Line : ", lineBegin);
+			uint32_t threadIdx = NUM_THREADS;
+			if (lineEnd == std::string::npos || fileBegin == std::string::npos || fileBegin > lineEnd
+				|| sscanf_s(output.c_str() + fileBegin, "][File : Validate.cpp, Line : %u]", &threadIdx) != 1
+				|| threadIdx >= NUM_THREADS
+				|| nextIndices[threadIdx] >= NUM_MESSAGES)
+			{
+				ELOG("Error : AsyncLogger Wrote a Broken Line.");
+				return false;
+			}
+
+			uint32_t i = nextIndices[threadIdx]++;
+			const std::wstring& wide = std::to_wstring(i);
+			expected.resize(longName.size() + 256);
+			int length = snprintf(expected.data(), expected.size(), FORMAT, threadIdx, i, i * 0.5, getName(i), wide.c_str());
+			size_t messageBegin = output.find(']', fileBegin + 1) + 1;
+			if (output.compare(messageBegin, lineEnd + 1 - messageBegin, expected.data(), length) != 0)
+			{
+				ELOG("Error : AsyncLogger Message Mismatch. thread = %u, message = %u", threadIdx, i);
+				return false;
+			}
+
+			lineBegin = lineEnd + 1;
+		}
+		for (uint32_t threadIdx = 0; threadIdx < NUM_THREADS; threadIdx++)
+		{
+			if (nextIndices[threadIdx] != NUM_MESSAGES)
+			{
+				ELOG("Error : AsyncLogger Missed Messages. thread = %u, count = %u", threadIdx, nextIndices[threadIdx]);
+				return false;
+			}
+		}
+
+		// 止めた後は呼び出したスレッドで書き出す
+		logger.Term();
+		size_t outputSize = output.size();
+		logger.Write(LOG_SEVERITY_INFO, "Validate.cpp", 0, "after term\n");
+		if (output.size() <= outputSize)
+		{
+			ELOG("Error : AsyncLogger Dropped a Message after Term().");
+			return false;
+		}
+
+		// 書き出しが遅くてキューが一杯になったら、待たずに捨てて数を書き出す
+		std::atomic<uint64_t> sinkLength = 0;
+		AsyncLogger slowLogger;
+		if (!slowLogger.Init(16, [&](const char* text, size_t length)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			sinkLength += length;
+			if (strstr(text, "[Logger]") != nullptr)
+			{
+				output += "[Logger]";
+			}
+		}))
+		{
+			ELOG("Error : AsyncLogger::Init() Failed.");
+			return false;
+		}
+
+		threads.clear();
+		output.clear();
+		for (uint32_t threadIdx = 0; threadIdx < NUM_THREADS; threadIdx++)
+		{
+			threads.emplace_back([&, threadIdx]()
+			{
+				for (uint32_t i = 0; i < NUM_MESSAGES; i++)
+				{
+					slowLogger.Write(LOG_SEVERITY_INFO, "Validate.cpp", threadIdx, FORMAT, threadIdx, i, i * 0.5, NAMES[i % 3], L"");
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		slowLogger.Term();
+
+		const LogStats& slowStats = slowLogger.GetStats();
+		if (slowStats.WrittenCount + slowStats.DroppedCount != NUM_THREADS * NUM_MESSAGES || slowStats.DroppedCount == 0 || output.find("[Logger]") == std::string::npos)
+		{
+			ELOG("Error : AsyncLogger Miscounted Dropped Messages. written = %llu, dropped = %llu", slowStats.WrittenCount, slowStats.DroppedCount);
+			return false;
+		}
+
+		// 書き込みやFlush()の途中でTerm()しても、書き込み中のスロットを解放せず、Flush()も戻ってくる。
+		// 止める前に積んだものと止めた後に呼び出したスレッドで書き出したもので、捨てたもの以外は全て数えられている
+		static constexpr uint32_t NUM_TERM_ROUNDS = 256;
+		static constexpr uint32_t NUM_TERM_MESSAGES = 256;
+		for (uint32_t round = 0; round < NUM_TERM_ROUNDS; round++)
+		{
+			AsyncLogger termLogger;
+			if (!termLogger.Init(64, [](const char*, size_t) {}))
+			{
+				ELOG("Error : AsyncLogger::Init() Failed.");
+				return false;
+			}
+
+			threads.clear();
+			for (uint32_t threadIdx = 0; threadIdx < NUM_THREADS; threadIdx++)
+			{
+				threads.emplace_back([&, threadIdx]()
+				{
+					for (uint32_t i = 0; i < NUM_TERM_MESSAGES; i++)
+					{
+						termLogger.Write(LOG_SEVERITY_INFO, "Validate.cpp", threadIdx, "round %u message %u\n", round, i);
+						if (i % 64 == 0)
+						{
+							termLogger.Flush();
+						}
+					}
+				});
+			}
+			termLogger.Term();
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+
+			const LogStats& termStats = termLogger.GetStats();
+			if (termStats.WrittenCount + termStats.DroppedCount != NUM_THREADS * NUM_TERM_MESSAGES)
+			{
+				ELOG("Error : AsyncLogger Lost Messages during Term(). written = %llu, dropped = %llu", termStats.WrittenCount, termStats.DroppedCount);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// threadCount個のスレッドが同時にmessageCount回ずつ書き込み、1回ごとにかかった時間をlatenciesに入れる
+	template<typename WriteFunc>
+	void MeasureLogLatency(uint32_t threadCount, uint32_t messageCount, const WriteFunc& write, std::vector<double>& latencies)
+	{
+		latencies.resize(threadCount * messageCount);
+
+		std::vector<std::thread> threads;
+		for (uint32_t threadIdx = 0; threadIdx < threadCount; threadIdx++)
+		{
+			threads.emplace_back([&, threadIdx]()
+			{
+				for (uint32_t i = 0; i < messageCount; i++)
+				{
+					const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+					write(threadIdx, i);
+					const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+					latencies[threadIdx * messageCount + i] = std::chrono::duration<double, std::nano>(end - start).count();
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		std::sort(latencies.begin(), latencies.end());
+	}
+}
+
+bool BenchmarkAsyncLogger()
+{
+	static constexpr uint32_t NUM_MESSAGES = 20000;
+
+	if (!ValidateAsyncLogger())
+	{
+		return false;
+	}
+
+	// マクロで消えたログは引数も評価しない
+	uint32_t evaluatedCount = 0;
+	DLOG("AsyncLogger : DLOG is enabled. %u", ++evaluatedCount);
+	if (evaluatedCount != ((LOG_MIN_SEVERITY <= LOG_SEVERITY_DEBUG) ? 1u : 0u))
+	{
+		ELOG("Error : LOG_MIN_SEVERITY is not Applied.");
+		return false;
+	}
+
+	for (uint32_t threadCount : {1u, 4u})
+	{
+		// 書き出し先にかかる時間は呼び出し側から見えないので、捨てるだけにする
+		AsyncLogger logger;
+		if (!logger.Init(65536, [](const char*, size_t) {}))
+		{
+			ELOG("Error : AsyncLogger::Init() Failed.");
+			return false;
+		}
+
+		std::vector<double> asyncLatencies;
+		MeasureLogLatency(threadCount, NUM_MESSAGES, [&](uint32_t threadIdx, uint32_t i)
+		{
+			logger.Write(LOG_SEVERITY_INFO, __FILE__, __LINE__, "thread %u message %u value %.3f name %s\n", threadIdx, i, i * 0.5, "Sponza");
+		}, asyncLatencies);
+		logger.Term();
+		const LogStats& stats = logger.GetStats();
+
+		// 以前のOutputLog()と同じく、呼び出したスレッドでフォーマットして書き出す。コンソールへの出力の時間は含めない
+		std::mutex syncMutex;
+		std::vector<double> syncLatencies;
+		MeasureLogLatency(threadCount, NUM_MESSAGES, [&](uint32_t threadIdx, uint32_t i)
+		{
+			char msg[2048];
+			snprintf(msg, sizeof(msg), "[File : %s, Line : %d]thread %u message %u value %.3f name %s\n", __FILE__, __LINE__, threadIdx, i, i * 0.5, "Sponza");
+			std::lock_guard<std::mutex> lock(syncMutex);
+		}, syncLatencies);
+
+		auto percentile = [](const std::vector<double>& latencies, double p) { return latencies[static_cast<size_t>((latencies.size() - 1) * p)]; };
+		ELOG("AsyncLogger %u threads : p50 %.0f ns, p99 %.0f ns, max %.0f ns, %llu dropped / format on caller : p50 %.0f ns, p99 %.0f ns, max %.0f ns",
+			threadCount,
+			percentile(asyncLatencies, 0.5),
+			percentile(asyncLatencies, 0.99),
+			asyncLatencies.back(),
+			stats.DroppedCount,
+			percentile(syncLatencies, 0.5),
+			percentile(syncLatencies, 0.99),
+			syncLatencies.back());
+	}
+
+	return true;
+}
@@ -0,0 +1,347 @@
+﻿#include "Benchmarks.h"
+#include "Logger.h"
+#include "Pool.h"
+#include "LockFreePool.h"
+#include "TlsfAllocator.h"
+#include "CounterBasedRandom.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace
+{
+	struct PoolBenchmarkItem
+	{
+		uint32_t Index;
+		uint32_t Value;
+	};
+
+	// threadCount個のスレッドが同時に、BATCH_SIZE個ずつ確保して解放するのを繰り返した速度をmopsPerSecondに入れる。
+	// 確保に失敗したか、全て解放した後に確保中の要素が残っていればfalse
+	template<typename PoolType>
+	bool MeasurePoolContention(PoolType& pool, uint32_t threadCount, double& mopsPerSecond)
+	{
+		static constexpr uint32_t BATCH_SIZE = 16;
+		static constexpr uint32_t NUM_ITERATIONS = 20000;
+
+		std::atomic<uint32_t> readyCount = 0;
+		std::atomic<bool> isStarted = false;
+		std::atomic<uint32_t> failureCount = 0;
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		for (uint32_t threadIdx = 0; threadIdx < threadCount; threadIdx++)
+		{
+			threads.emplace_back([&]()
+			{
+				PoolBenchmarkItem* pItems[BATCH_SIZE];
+				readyCount++;
+				while (!isStarted.load(std::memory_order_acquire))
+				{
+					std::this_thread::yield();
+				}
+
+				for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+				{
+					for (uint32_t j = 0; j < BATCH_SIZE; j++)
+					{
+						pItems[j] = pool.Alloc([](uint32_t index, PoolBenchmarkItem* pItem)
+						{
+							pItem->Index = index;
+						});
+						if (pItems[j] == nullptr)
+						{
+							failureCount++;
+						}
+					}
+					for (uint32_t j = 0; j < BATCH_SIZE; j++)
+					{
+						pool.Free(pItems[j]);
+					}
+				}
+			});
+		}
+
+		// 全スレッドがそろってから始める
+		while (readyCount.load() < threadCount)
+		{
+			std::this_thread::yield();
+		}
+		const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+		isStarted.store(true, std::memory_order_release);
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+		if (failureCount > 0 || pool.GetUsedCount() != 0)
+		{
+			ELOG("Error : Pool Benchmark Failed. %u allocations failed, %u items leaked.", failureCount.load(), pool.GetUsedCount());
+			return false;
+		}
+
+		// 確保と解放をそれぞれ1回と数える
+		double msec = std::chrono::duration<double, std::milli>(end - start).count();
+		mopsPerSecond = 2.0 * threadCount * NUM_ITERATIONS * BATCH_SIZE / (msec * 1000.0);
+		return true;
+	}
+}
+
+bool BenchmarkPool()
+{
+	// 全スレッドがBATCH_SIZE個ずつ持ってもマガジンの分まで足りる数
+	static constexpr uint32_t POOL_CAPACITY = 4096;
+	static constexpr uint32_t MAGAZINE_SIZE = 32;
+
+	for (uint32_t threadCount : {1u, 2u, 4u, 8u, 16u, 32u})
+	{
+		Pool<PoolBenchmarkItem> mutexPool;
+		LockFreePool<PoolBenchmarkItem> lockFreePool;
+		LockFreePool<PoolBenchmarkItem> magazinePool;
+		if (!mutexPool.Init(POOL_CAPACITY) || !lockFreePool.Init(POOL_CAPACITY, 0) || !magazinePool.Init(POOL_CAPACITY, MAGAZINE_SIZE))
+		{
+			ELOG("Error : Pool::Init() Failed.");
+			return false;
+		}
+
+		double mutexRate = 0.0;
+		double lockFreeRate = 0.0;
+		double magazineRate = 0.0;
+		if (!MeasurePoolContention(mutexPool, threadCount, mutexRate)
+			|| !MeasurePoolContention(lockFreePool, threadCount, lockFreeRate)
+			|| !MeasurePoolContention(magazinePool, threadCount, magazineRate))
+		{
+			return false;
+		}
+
+		ELOG("Pool %u threads : Mutex %.2f Mops/s, Lock-Free %.2f Mops/s, Lock-Free with Magazine %.2f Mops/s",
+			threadCount,
+			mutexRate,
+			lockFreeRate,
+			magazineRate);
+	}
+
+	// 以前のPoolは確保のたびにstd::functionを作り、要素の隣にインデックスと前後のポインタを持っていた
+	struct LegacyPoolItem
+	{
+		PoolBenchmarkItem Value;
+		uint32_t Index;
+		LegacyPoolItem* pPrev;
+		LegacyPoolItem* pNext;
+	};
+
+	static constexpr uint32_t NUM_ITERATIONS = 1000;
+	Pool<PoolBenchmarkItem> pool;
+	if (!pool.Init(POOL_CAPACITY))
+	{
+		ELOG("Error : Pool::Init() Failed.");
+		return false;
+	}
+
+	std::vector<PoolBenchmarkItem*> pItems(POOL_CAPACITY);
+	auto measureAlloc = [&](auto&& func)
+	{
+		const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+		{
+			for (uint32_t j = 0; j < POOL_CAPACITY; j++)
+			{
+				pItems[j] = pool.Alloc(func);
+			}
+			for (uint32_t j = 0; j < POOL_CAPACITY; j++)
+			{
+				pool.Free(pItems[j]);
+			}
+		}
+		const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+		return static_cast<double>(NUM_ITERATIONS) * POOL_CAPACITY / (std::chrono::duration<double, std::milli>(end - start).count() * 1000.0);
+	};
+
+	auto initItem = [](uint32_t index, PoolBenchmarkItem* pItem)
+	{
+		pItem->Index = index;
+		pItem->Value = 1;
+	};
+	double functionAllocRate = measureAlloc(std::function<void(uint32_t, PoolBenchmarkItem*)>(initItem));
+	double lambdaAllocRate = measureAlloc(initItem);
+
+	// 半分を飛び飛びに解放してから、残りを辿る
+	for (uint32_t j = 0; j < POOL_CAPACITY; j++)
+	{
+		pItems[j] = pool.Alloc(initItem);
+	}
+	for (uint32_t j = 0; j < POOL_CAPACITY; j += 2)
+	{
+		pool.Free(pItems[j]);
+	}
+
+	uint64_t sum = 0;
+	const std::chrono::steady_clock::time_point& iterateStart = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+	{
+		pool.ForEachActive([&sum](uint32_t index, PoolBenchmarkItem* pItem)
+		{
+			sum += pItem->Value;
+		});
+	}
+	const std::chrono::steady_clock::time_point& iterateEnd = std::chrono::steady_clock::now();
+	double iterateRate = static_cast<double>(NUM_ITERATIONS) * pool.GetUsedCount() / (std::chrono::duration<double, std::milli>(iterateEnd - iterateStart).count() * 1000.0);
+
+	// 解放していない半分だけを毎回1回ずつ辿る
+	if (pool.GetUsedCount() != POOL_CAPACITY / 2 || sum != static_cast<uint64_t>(NUM_ITERATIONS) * (POOL_CAPACITY / 2))
+	{
+		ELOG("Error : Pool::ForEachActive() Visited Wrong Items. used = %u, sum = %llu", pool.GetUsedCount(), static_cast<unsigned long long>(sum));
+		return false;
+	}
+
+	ELOG("Pool 1 thread : Alloc with std::function %.2f Mallocs/s, with lambda %.2f Mallocs/s, Slot %zu bytes (legacy %zu bytes), ForEachActive %.2f Mitems/s (sum %llu)",
+		functionAllocRate,
+		lambdaAllocRate,
+		Pool<PoolBenchmarkItem>::GetSlotSize(),
+		sizeof(LegacyPoolItem),
+		iterateRate,
+		static_cast<unsigned long long>(sum));
+
+	return true;
+}
+
+bool BenchmarkTlsfAllocator()
+{
+	static constexpr uint64_t HEAP_SIZE = 128 * 1024 * 1024;
+	static constexpr uint32_t NUM_ROUNDS = 64;
+	static constexpr uint32_t LOAD_COUNT = 256;
+	// StructuredBufferの要素の大きさ。MeshVertex、meshopt_Meshlet、uint32_t、AABB、Vector3に相当する
+	static constexpr uint64_t STRIDES[] = {48, 16, 4, 24, 12};
+
+	struct Range
+	{
+		TlsfAllocator::Allocation Allocation;
+		uint64_t Size;
+	};
+
+	TlsfAllocator allocator;
+	if (!allocator.Init(HEAP_SIZE))
+	{
+		ELOG("Error : TlsfAllocator::Init() Failed.");
+		return false;
+	}
+
+	std::vector<Range> ranges;
+	uint32_t failureCount = 0;
+	uint64_t operationCount = 0;
+	double msec = 0.0;
+
+	for (uint32_t round = 0; round < NUM_ROUNDS; round++)
+	{
+		// ロードでまとめて確保し、アンロードでランダムにおよそ半分を解放する
+		const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < LOAD_COUNT; i++)
+		{
+			uint32_t random[4];
+			GenerateRandom4(i, round, 0, 0, random);
+			uint64_t stride = STRIDES[random[0] % _countof(STRIDES)];
+			// 64B～1MBを対数的に一様に選ぶ
+			uint64_t size = std::max<uint64_t>(static_cast<uint64_t>(exp2f(6.0f + 14.0f * RandomToUnitFloat(random[1]))) / stride, 1) * stride;
+			const TlsfAllocator::Allocation& allocation = allocator.Allocate(size, stride);
+			uint64_t offset = allocation.Offset;
+			if (offset == TlsfAllocator::INVALID_OFFSET)
+			{
+				failureCount++;
+				continue;
+			}
+
+			if (offset % stride != 0 || offset + size > allocator.GetSize())
+			{
+				ELOG("Error : Invalid Range. offset = %llu, size = %llu, stride = %llu", static_cast<unsigned long long>(offset), static_cast<unsigned long long>(size), static_cast<unsigned long long>(stride));
+				return false;
+			}
+			ranges.push_back({allocation, size});
+		}
+
+		size_t keepCount = 0;
+		for (size_t i = 0; i < ranges.size(); i++)
+		{
+			uint32_t random[4];
+			GenerateRandom4(static_cast<uint32_t>(i), round, 1, 0, random);
+			if (RandomToUnitFloat(random[0]) < 0.5f)
+			{
+				ranges[keepCount++] = ranges[i];
+			}
+			else
+			{
+				allocator.Free(ranges[i].Allocation);
+			}
+		}
+		operationCount += LOAD_COUNT + (ranges.size() - keepCount);
+		ranges.resize(keepCount);
+		const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+		msec += std::chrono::duration<double, std::milli>(end - start).count();
+
+		std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) { return a.Allocation.Offset < b.Allocation.Offset; });
+		for (size_t i = 1; i < ranges.size(); i++)
+		{
+			if (ranges[i - 1].Allocation.Offset + ranges[i - 1].Size > ranges[i].Allocation.Offset)
+			{
+				ELOG("Error : Overlapped Range. offset = %llu", static_cast<unsigned long long>(ranges[i].Allocation.Offset));
+				return false;
+			}
+		}
+
+		if (round % 16 == 15)
+		{
+			const TlsfAllocatorStats& stats = allocator.GetStats();
+			ELOG("TlsfAllocator round %u : %u allocations, used %.2f MB, free %.2f MB in %u blocks, largest %.2f MB, fragmentation %.3f",
+				round + 1,
+				stats.AllocationCount,
+				stats.UsedSize / (1024.0 * 1024.0),
+				stats.FreeSize / (1024.0 * 1024.0),
+				stats.FreeBlockCount,
+				stats.LargestFreeBlockSize / (1024.0 * 1024.0),
+				stats.Fragmentation);
+		}
+	}
+
+	// 全て解放すれば1つの空きブロックに結合されているはず
+	for (const Range& range : ranges)
+	{
+		allocator.Free(range.Allocation);
+	}
+	const TlsfAllocatorStats& stats = allocator.GetStats();
+	if (stats.FreeBlockCount != 1 || stats.LargestFreeBlockSize != allocator.GetSize())
+	{
+		ELOG("Error : Free Blocks are not Coalesced. %u blocks", stats.FreeBlockCount);
+		return false;
+	}
+
+	// 大きいバッファはBufferSuballocatorが専用のページを足すので、GetRequiredBlockSize()を64KBに切り上げた大きさの
+	// 新しいページから、どのアラインメントでも確保できることを確かめる
+	static constexpr uint64_t LARGE_SIZES[] = {5000000, 16 * 1024 * 1024 + 48, 20 * 1000 * 1000, 100 * 1024 * 1024 - 12};
+	static constexpr uint64_t PAGE_ALIGNMENT = 64 * 1024;
+	for (uint64_t largeSize : LARGE_SIZES)
+	{
+		for (uint64_t stride : STRIDES)
+		{
+			uint64_t size = (largeSize + stride - 1) / stride * stride;
+			uint64_t pageSize = (TlsfAllocator::GetRequiredBlockSize(size, stride) + PAGE_ALIGNMENT - 1) / PAGE_ALIGNMENT * PAGE_ALIGNMENT;
+			TlsfAllocator page;
+			if (!page.Init(pageSize))
+			{
+				ELOG("Error : TlsfAllocator::Init() Failed.");
+				return false;
+			}
+
+			const TlsfAllocator::Allocation& allocation = page.Allocate(size, stride);
+			if (allocation.Offset == TlsfAllocator::INVALID_OFFSET || allocation.Offset % stride != 0 || allocation.Offset + size > pageSize)
+			{
+				ELOG("Error : Large Allocation Failed. size = %llu, stride = %llu, page = %llu", static_cast<unsigned long long>(size), static_cast<unsigned long long>(stride), static_cast<unsigned long long>(pageSize));
+				return false;
+			}
+		}
+	}
+
+	ELOG("TlsfAllocator : %.2f Mops/s, %u allocations failed", operationCount / (msec * 1000.0), failureCount);
+
+	return true;
+}
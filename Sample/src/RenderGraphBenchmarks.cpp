@@ -0,0 +1,499 @@
+﻿#include "Benchmarks.h"
+#include "Logger.h"
+#include "RenderGraph.h"
+#include "AliasingPlanner.h"
+#include "ResourceStateTracker.h"
+#include "FramePacer.h"
+#include "CounterBasedRandom.h"
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+namespace
+{
+	// ResourceBarrier()だけを持つコマンドリストのモック。サブリソースごとの状態を再現し、beforeが食い違うバリアを数える
+	struct MockBarrierCommandList
+	{
+		std::unordered_map<ID3D12Resource*, std::vector<D3D12_RESOURCE_STATES>> States;
+		// BEGIN_ONLYを受けてEND_ONLYを待っているリソースの遷移先
+		std::unordered_map<ID3D12Resource*, D3D12_RESOURCE_STATES> SplitAfters;
+		uint32_t CallCount = 0;
+		uint32_t BarrierCount = 0;
+		uint32_t ErrorCount = 0;
+
+		void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER* pBarriers)
+		{
+			CallCount++;
+			BarrierCount += count;
+
+			for (UINT i = 0; i < count; i++)
+			{
+				const D3D12_RESOURCE_BARRIER& barrier = pBarriers[i];
+				if (barrier.Type != D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+				{
+					continue;
+				}
+
+				const D3D12_RESOURCE_TRANSITION_BARRIER& transition = barrier.Transition;
+				std::unordered_map<ID3D12Resource*, std::vector<D3D12_RESOURCE_STATES>>::iterator it = States.find(transition.pResource);
+				if (it == States.end())
+				{
+					ErrorCount++;
+					continue;
+				}
+
+				std::vector<D3D12_RESOURCE_STATES>& states = it->second;
+				bool isAll = (transition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+				size_t first = isAll ? 0 : transition.Subresource;
+				size_t last = isAll ? states.size() : transition.Subresource + 1;
+				if (last > states.size())
+				{
+					ErrorCount++;
+					continue;
+				}
+
+				for (size_t subresource = first; subresource < last; subresource++)
+				{
+					if (states[subresource] != transition.StateBefore)
+					{
+						ErrorCount++;
+					}
+				}
+
+				bool isInSplit = (SplitAfters.find(transition.pResource) != SplitAfters.end());
+				if (barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+				{
+					// END_ONLYまでは遷移の途中なので状態は変えない
+					if (isInSplit)
+					{
+						ErrorCount++;
+					}
+					SplitAfters[transition.pResource] = transition.StateAfter;
+					continue;
+				}
+
+				if (barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_END_ONLY)
+				{
+					if (!isInSplit || SplitAfters[transition.pResource] != transition.StateAfter)
+					{
+						ErrorCount++;
+					}
+					SplitAfters.erase(transition.pResource);
+				}
+				else if (isInSplit)
+				{
+					// 分割バリアの途中のリソースは使えない
+					ErrorCount++;
+				}
+
+				for (size_t subresource = first; subresource < last; subresource++)
+				{
+					states[subresource] = transition.StateAfter;
+				}
+			}
+		}
+	};
+
+	// 1本のコマンドキューのシミュレーション。時刻はミリ秒で、実行したフレームはlatencyの後にGPUが受け取り、前のフレームが終わってから順に実行する
+	struct SimulatedQueue
+	{
+		double Latency = 0.0;
+		double GpuEndTime = 0.0;
+		// フェンスの値 - 1をインデックスにした、その値がシグナルされる時刻
+		std::vector<double> CompletionTimes;
+
+		// 時刻nowにGPUでgpuTimeかかるフレームを実行し、その後にシグナルするフェンスの値を返す
+		uint64_t ExecuteAndSignal(double now, double gpuTime)
+		{
+			double startTime = std::max(now + Latency, GpuEndTime);
+			GpuEndTime = startTime + gpuTime;
+			CompletionTimes.push_back(GpuEndTime);
+			return CompletionTimes.size();
+		}
+
+		uint64_t GetCompletedValue(double now) const
+		{
+			// シグナルされる時刻は昇順に並んでいる
+			return std::upper_bound(CompletionTimes.begin(), CompletionTimes.end(), now) - CompletionTimes.begin();
+		}
+
+		double GetCompletionTime(uint64_t fenceValue) const
+		{
+			return CompletionTimes[fenceValue - 1];
+		}
+	};
+}
+
+bool BenchmarkRenderGraph()
+{
+	static constexpr uint32_t NUM_GRAPHS = 256;
+	static constexpr uint32_t NUM_RESOURCES = 48;
+	static constexpr uint32_t NUM_PASSES = 64;
+	static constexpr uint32_t NUM_IMPORTED_RESOURCES = 4;
+
+	uint64_t transientSize = 0;
+	uint64_t aliasedSize = 0;
+	uint32_t culledPassCount = 0;
+	double msec = 0.0;
+
+	AliasingPlanner planner;
+	for (uint32_t graphIdx = 0; graphIdx < NUM_GRAPHS; graphIdx++)
+	{
+		RenderGraph graph;
+		std::vector<uint64_t> sizes(NUM_RESOURCES, 0);
+		for (uint32_t i = 0; i < NUM_RESOURCES; i++)
+		{
+			if (i < NUM_IMPORTED_RESOURCES)
+			{
+				graph.AddImportedResource("Imported");
+				continue;
+			}
+
+			// 1/4解像度から全解像度のRGBA16Fくらいの大きさ
+			uint32_t random[4];
+			GenerateRandom4(i, graphIdx, 0, 0, random);
+			sizes[i] = (1 + random[0] % 16) * 1024 * 1024;
+			graph.AddTransientResource("Transient", sizes[i], D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+		}
+
+		// パスは2つ読んで1つ書く。書くリソースは前の方のパスほど若い番号にして、ポストプロセスの連鎖に近づける
+		std::vector<uint32_t> reads(NUM_PASSES * 2);
+		std::vector<uint32_t> writes(NUM_PASSES);
+		uint32_t executedCount = 0;
+		for (uint32_t passIdx = 0; passIdx < NUM_PASSES; passIdx++)
+		{
+			uint32_t random[4];
+			GenerateRandom4(passIdx, graphIdx, 1, 0, random);
+			uint32_t center = NUM_IMPORTED_RESOURCES + passIdx * (NUM_RESOURCES - NUM_IMPORTED_RESOURCES) / NUM_PASSES;
+			writes[passIdx] = (random[0] % 16 == 0) ? random[0] % NUM_IMPORTED_RESOURCES : std::min(center + random[1] % 4, NUM_RESOURCES - 1);
+			reads[passIdx * 2 + 0] = (center > 8) ? center - 1 - random[2] % 8 : random[2] % NUM_RESOURCES;
+			reads[passIdx * 2 + 1] = random[3] % NUM_RESOURCES;
+			graph.AddPass("Pass", {reads[passIdx * 2 + 0], reads[passIdx * 2 + 1]}, {writes[passIdx]}, [&executedCount]() { executedCount++; });
+		}
+
+		// 寿命のあるリソースのプランナーでのインデックス
+		std::vector<uint32_t> plannedIndices(NUM_RESOURCES, UINT32_MAX);
+
+		const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+		graph.Compile();
+		planner.Reset();
+		for (uint32_t i = 0; i < NUM_RESOURCES; i++)
+		{
+			if (graph.GetFirstPass(i) != RenderGraph::INVALID_INDEX)
+			{
+				plannedIndices[i] = planner.AddResource(graph.GetSize(i), graph.GetAlignment(i), graph.GetFirstPass(i), graph.GetLastPass(i));
+			}
+		}
+		planner.Plan();
+		const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+		msec += std::chrono::duration<double, std::milli>(end - start).count();
+
+		graph.Execute();
+
+		// 総当たり。後ろの生きているパスが読むものを書くか、インポートしたものを書くパスが生きている
+		std::vector<uint8_t> isAlive(NUM_PASSES, 0);
+		for (uint32_t passIdx = NUM_PASSES; passIdx-- > 0;)
+		{
+			bool alive = (writes[passIdx] < NUM_IMPORTED_RESOURCES);
+			for (uint32_t laterIdx = passIdx + 1; laterIdx < NUM_PASSES && !alive; laterIdx++)
+			{
+				alive = isAlive[laterIdx] && (reads[laterIdx * 2 + 0] == writes[passIdx] || reads[laterIdx * 2 + 1] == writes[passIdx]);
+			}
+			isAlive[passIdx] = alive ? 1 : 0;
+
+			if (alive == graph.IsPassCulled(passIdx))
+			{
+				ELOG("Error : Culling Mismatch. graph = %u, pass = %u", graphIdx, passIdx);
+				return false;
+			}
+		}
+
+		const RenderGraphStats& stats = graph.GetStats();
+		if (executedCount != stats.PassCount - stats.CulledPassCount)
+		{
+			ELOG("Error : Executed Pass Count Mismatch. graph = %u", graphIdx);
+			return false;
+		}
+
+		for (uint32_t i = NUM_IMPORTED_RESOURCES; i < NUM_RESOURCES; i++)
+		{
+			for (uint32_t j = i + 1; j < NUM_RESOURCES; j++)
+			{
+				if (plannedIndices[i] == UINT32_MAX || plannedIndices[j] == UINT32_MAX)
+				{
+					continue;
+				}
+
+				uint64_t offsetI = planner.GetOffset(plannedIndices[i]);
+				uint64_t offsetJ = planner.GetOffset(plannedIndices[j]);
+				bool isLifetimeOverlapped = (graph.GetFirstPass(i) <= graph.GetLastPass(j) && graph.GetFirstPass(j) <= graph.GetLastPass(i));
+				bool isMemoryOverlapped = (offsetI < offsetJ + sizes[j] && offsetJ < offsetI + sizes[i]);
+				if (isLifetimeOverlapped && isMemoryOverlapped)
+				{
+					ELOG("Error : Aliased Resources Overlap. graph = %u, resource = %u, %u", graphIdx, i, j);
+					return false;
+				}
+			}
+		}
+
+		if (planner.GetStats().TotalSize != stats.TransientSize)
+		{
+			ELOG("Error : Planned Size Mismatch. graph = %u", graphIdx);
+			return false;
+		}
+
+		transientSize += stats.TransientSize;
+		aliasedSize += planner.GetStats().AliasedSize;
+		culledPassCount += stats.CulledPassCount;
+	}
+
+	ELOG("RenderGraph : %u graphs of %u passes, %.2f us per compile and plan, %.1f%% passes culled, aliased / transient memory %.1f%%",
+		NUM_GRAPHS,
+		NUM_PASSES,
+		msec * 1000.0 / NUM_GRAPHS,
+		100.0 * culledPassCount / (NUM_GRAPHS * NUM_PASSES),
+		100.0 * aliasedSize / std::max<uint64_t>(transientSize, 1));
+
+	return true;
+}
+
+bool BenchmarkResourceStateTracker()
+{
+	static constexpr uint32_t NUM_FRAMES = 256;
+	static constexpr uint32_t NUM_PASSES = 48;
+	static constexpr uint32_t NUM_RESOURCES = 32;
+	// 先頭のリソースはHZBのようにミップごとに書くもので、その次がシャドウマップ
+	static constexpr uint32_t NUM_MIP_RESOURCES = 4;
+	static constexpr uint32_t NUM_MIPS = 8;
+	static constexpr uint32_t SHADOW_MAP_IDX = NUM_MIP_RESOURCES;
+	static constexpr uint32_t FIRST_TARGET_IDX = SHADOW_MAP_IDX + 1;
+	static constexpr D3D12_RESOURCE_STATES RESTING_STATE = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+
+	// 中身には触らないので、ポインタは区別できれば何でもいい
+	std::vector<ID3D12Resource*> resources(NUM_RESOURCES);
+	for (uint32_t i = 0; i < NUM_RESOURCES; i++)
+	{
+		resources[i] = reinterpret_cast<ID3D12Resource*>(static_cast<uintptr_t>(i + 1) * 256);
+	}
+
+	ResourceStateTracker tracker;
+	uint64_t requestedCount = 0;
+	uint64_t issuedCount = 0;
+	uint64_t flushCount = 0;
+	uint64_t splitCount = 0;
+	double msec = 0.0;
+
+	for (uint32_t frameIdx = 0; frameIdx < NUM_FRAMES; frameIdx++)
+	{
+		MockBarrierCommandList cmdList;
+		for (uint32_t i = 0; i < NUM_RESOURCES; i++)
+		{
+			cmdList.States[resources[i]].assign((i < NUM_MIP_RESOURCES) ? NUM_MIPS : 1, RESTING_STATE);
+		}
+
+		const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+
+		// シャドウマップを描いて、PIXEL_SHADER_RESOURCEへの遷移をフレームの途中まで分割する
+		tracker.Transition(resources[SHADOW_MAP_IDX], RESTING_STATE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+		tracker.Flush(&cmdList);
+		tracker.BeginSplitTransition(resources[SHADOW_MAP_IDX], D3D12_RESOURCE_STATE_DEPTH_WRITE, RESTING_STATE);
+
+		// パスは書くものを遷移させてFlush()し、終わったら元の状態に戻す。読むものは置かれている状態のまま使う
+		for (uint32_t passIdx = 1; passIdx < NUM_PASSES; passIdx++)
+		{
+			if (passIdx == NUM_PASSES / 2)
+			{
+				tracker.EndSplitTransition(resources[SHADOW_MAP_IDX]);
+			}
+
+			uint32_t random[4];
+			GenerateRandom4(passIdx, frameIdx, 0, 0, random);
+			switch (random[0] % 4)
+			{
+				case 0:
+				case 1:
+				{
+					// 1～3枚のレンダーターゲットに描く。GBufferやポストプロセスのように続くパスは近いものを書く
+					uint32_t targets[3];
+					uint32_t targetCount = 1 + random[1] % 3;
+					for (uint32_t i = 0; i < targetCount; i++)
+					{
+						targets[i] = FIRST_TARGET_IDX + (passIdx / 4 + (random[2] + i) % 4) % (NUM_RESOURCES - FIRST_TARGET_IDX);
+						tracker.Transition(resources[targets[i]], RESTING_STATE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+					}
+					tracker.Flush(&cmdList);
+					for (uint32_t i = 0; i < targetCount; i++)
+					{
+						tracker.Transition(resources[targets[i]], D3D12_RESOURCE_STATE_RENDER_TARGET, RESTING_STATE);
+					}
+					break;
+				}
+				case 2:
+				{
+					// 同じUAVに2回ディスパッチする
+					ID3D12Resource* pResource = resources[FIRST_TARGET_IDX + (passIdx / 4 + random[1] % 4) % (NUM_RESOURCES - FIRST_TARGET_IDX)];
+					tracker.Transition(pResource, RESTING_STATE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+					tracker.Flush(&cmdList);
+					tracker.UAVBarrier(pResource);
+					tracker.Flush(&cmdList);
+					tracker.UAVBarrier(pResource);
+					tracker.Transition(pResource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, RESTING_STATE);
+					break;
+				}
+				case 3:
+				{
+					// DrawHZB()のようにミップを1つずつUAVにして書き、次のミップの前に戻す
+					ID3D12Resource* pResource = resources[random[1] % NUM_MIP_RESOURCES];
+					for (uint32_t mip = 0; mip < NUM_MIPS; mip++)
+					{
+						tracker.TransitionSubresource(pResource, NUM_MIPS, mip, RESTING_STATE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+						tracker.Flush(&cmdList);
+						tracker.TransitionSubresource(pResource, NUM_MIPS, mip, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, RESTING_STATE);
+					}
+					break;
+				}
+				default:
+					break;
+			}
+		}
+
+		tracker.Finish(&cmdList);
+
+		const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+		msec += std::chrono::duration<double, std::milli>(end - start).count();
+
+		if (cmdList.ErrorCount != 0 || !cmdList.SplitAfters.empty())
+		{
+			ELOG("Error : Barrier State Mismatch. frame = %u, %u errors", frameIdx, cmdList.ErrorCount);
+			return false;
+		}
+
+		// Finish()の後は全リソースが置かれている状態に戻っている
+		for (const std::pair<ID3D12Resource* const, std::vector<D3D12_RESOURCE_STATES>>& entry : cmdList.States)
+		{
+			for (D3D12_RESOURCE_STATES state : entry.second)
+			{
+				if (state != RESTING_STATE)
+				{
+					ELOG("Error : Resource is not Restored. frame = %u", frameIdx);
+					return false;
+				}
+			}
+		}
+
+		const ResourceStateTrackerStats& stats = tracker.GetLastFrameStats();
+		if (stats.IssuedCount != cmdList.BarrierCount || stats.FlushCount != cmdList.CallCount)
+		{
+			ELOG("Error : Stats Mismatch. frame = %u", frameIdx);
+			return false;
+		}
+
+		requestedCount += stats.RequestedCount;
+		issuedCount += stats.IssuedCount;
+		flushCount += stats.FlushCount;
+		splitCount += stats.SplitCount;
+	}
+
+	// 遷移ごとにResourceBarrier()を呼んでいたときは、要求された数だけバリアと呼び出しがあった
+	ELOG("ResourceStateTracker : %u frames of %u passes, per frame %.1f barriers in %.1f calls -> %.1f barriers in %.1f calls (%.1f split), %.2f us per frame",
+		NUM_FRAMES,
+		NUM_PASSES,
+		static_cast<double>(requestedCount) / NUM_FRAMES,
+		static_cast<double>(requestedCount) / NUM_FRAMES,
+		static_cast<double>(issuedCount) / NUM_FRAMES,
+		static_cast<double>(flushCount) / NUM_FRAMES,
+		static_cast<double>(splitCount) / NUM_FRAMES,
+		msec * 1000.0 / NUM_FRAMES);
+
+	return true;
+}
+
+bool BenchmarkFramePacing()
+{
+	static constexpr uint32_t NUM_FRAMES = 1000;
+	static constexpr uint32_t MAX_FRAME_COUNT = 3;
+
+	// CPUの記録時間、GPUの実行時間、GPUが受け取るまでの遅延
+	struct Workload
+	{
+		double CpuTime;
+		double GpuTime;
+		double Latency;
+	};
+	const Workload workloads[] = {
+		{8.0, 8.0, 1.0},
+		{4.0, 12.0, 1.0},
+		{12.0, 4.0, 1.0},
+		{8.0, 8.0, 6.0},
+	};
+
+	for (const Workload& workload : workloads)
+	{
+		// frameCountが1なら、フレームごとにGPUの完了を全て待っていたときと同じになる
+		for (uint32_t frameCount = 1; frameCount <= MAX_FRAME_COUNT; frameCount++)
+		{
+			FramePacer pacer;
+			if (!pacer.Init(frameCount))
+			{
+				ELOG("Error : FramePacer::Init() Failed.");
+				return false;
+			}
+
+			SimulatedQueue queue;
+			queue.Latency = workload.Latency;
+
+			// フレームのインデックスごとに、資源を最後に使ったフレームのフェンスの値
+			std::vector<uint64_t> lastUsedFenceValues(frameCount, 0);
+			double now = 0.0;
+			double waitTime = 0.0;
+			uint32_t maxFramesInFlight = 0;
+			uint64_t fenceValue = 0;
+
+			for (uint32_t frame = 0; frame < NUM_FRAMES; frame++)
+			{
+				uint32_t frameIndex = frame % frameCount;
+
+				pacer.BeginFrame(frameIndex, queue.GetCompletedValue(now), [&](uint64_t waitValue)
+				{
+					double completionTime = queue.GetCompletionTime(waitValue);
+					waitTime += completionTime - now;
+					now = completionTime;
+				});
+
+				// 記録を始める時点で、このフレームの資源を最後に使ったフレームは終わっている
+				uint64_t completedValue = queue.GetCompletedValue(now);
+				if (lastUsedFenceValues[frameIndex] > completedValue)
+				{
+					ELOG("Error : Frame Resources are Reused in Flight. frame = %u, frameCount = %u", frame, frameCount);
+					return false;
+				}
+
+				uint32_t framesInFlight = pacer.GetFramesInFlight(completedValue);
+				if (framesInFlight >= frameCount)
+				{
+					ELOG("Error : Too Many Frames in Flight. frame = %u, frameCount = %u", frame, frameCount);
+					return false;
+				}
+				maxFramesInFlight = std::max(maxFramesInFlight, framesInFlight);
+
+				now += workload.CpuTime;
+				fenceValue = queue.ExecuteAndSignal(now, workload.GpuTime);
+				lastUsedFenceValues[frameIndex] = fenceValue;
+				pacer.EndFrame(frameIndex, fenceValue);
+			}
+
+			// 最後のフレームをGPUが終えるまで
+			double totalTime = queue.GetCompletionTime(fenceValue);
+			ELOG("FramePacer : CPU %.1f ms, GPU %.1f ms, latency %.1f ms, %u frames : %.2f ms per frame, CPU waits %.2f ms per frame, max %u frames in flight",
+				workload.CpuTime,
+				workload.GpuTime,
+				workload.Latency,
+				frameCount,
+				totalTime / NUM_FRAMES,
+				waitTime / NUM_FRAMES,
+				maxFramesInFlight);
+		}
+	}
+
+	return true;
+}
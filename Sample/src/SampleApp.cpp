@@ -7,6 +7,7 @@
 
 // stl
 #include <sstream>
+#include <algorithm>
 
 // DirectX libraries
 #include <DirectXMath.h>
@@ -30,9 +31,62 @@
 #include "RootSignature.h"
 #include "RenderModel.h"
 #include "ResMesh.h"
+#include "ParallelFor.h"
+#include "SceneBvh.h"
+#include "RenderGraph.h"
+#include "ResourceStateTracker.h"
+#include "FramePacer.h"
+#include "ShaderCache.h"
+#include "JobGraph.h"
+
+// Sample
+#include "Benchmarks.h"
 
 using namespace DirectX::SimpleMath;
 
+// 以下のベンチマークの本体は*Benchmarks.cppにある。結果の検証に失敗したらOnInit()を失敗させる
+// コメントアウトを外すと起動時にロードしたモデルをLoop細分割してレベルごとの時間、メモリ、Meshlet数をログに出す
+//#define BENCHMARK_LOOP_SUBDIVISION
+// コメントアウトを外すと起動時にパーティクルのハッシュグリッドの構築、近傍探索、MeshletのAABBとの衝突の時間を計測してログに出す
+//#define BENCHMARK_PARTICLE_SPATIAL_HASH
+// コメントアウトを外すと起動時に全メッシュの三角形のBVHを1スレッドと全スレッドで構築して、構築時間、ノード数、SAHのコスト、レイの交差判定の速度をログに出す
+//#define BENCHMARK_BVH
+// コメントアウトを外すと起動時に現在のカメラからのレイとランダムなレイでBVH4/BVH8を2分木と比べて計測し、ログに出す
+//#define BENCHMARK_WIDE_BVH
+// コメントアウトを外すと起動時に現在のカメラとライトでCPUのパストレーサのリファレンス画像を描いてHDRで書き出し、速度をログに出す
+//#define RENDER_PATH_TRACING_REFERENCE
+// コメントアウトを外すと起動時にメッシュごとのBLASとTLASの2段のBVHを構築して、1つのメッシュを動かしたときのTLASのRefitと全体の再構築の時間をログに出す。
+// 以降は毎フレーム、動くメッシュの分だけTLASをRefitする
+//#define BENCHMARK_SCENE_BVH
+// コメントアウトを外すと起動時に1～32スレッドで同時に確保と解放をして、Pool、LockFreePool、マガジン付きのLockFreePoolの速度をログに出す。
+// あわせてPoolの1スレッドでの確保の速度、1要素あたりのメモリ、確保中の要素を辿る速度もログに出す
+//#define BENCHMARK_POOL
+// コメントアウトを外すと起動時にメッシュのバッファに似た大きさとアラインメントでTlsfAllocatorのロードとアンロードを繰り返し、
+// 範囲の重なりとアラインメントを検証して、確保と解放の速度と断片化の統計をログに出す
+//#define BENCHMARK_TLSF_ALLOCATOR
+// コメントアウトを外すと起動時にランダムなパスの並びのRenderGraphをコンパイルし、除かれるパスを総当たりの結果と比べ、
+// 寿命からAliasingPlannerで立てた配置で寿命の重なるリソースがメモリを共有していないことを検証して、
+// コンパイルと配置の時間と共有した場合のメモリ量の割合をログに出す
+//#define BENCHMARK_RENDER_GRAPH
+// コメントアウトを外すと起動時にランダムなパスの並びの遷移をResourceStateTrackerでまとめてモックのコマンドリストに発行し、
+// サブリソースごとの状態の食い違いがないことを検証して、遷移ごとに発行した場合とのバリアの数とResourceBarrier()の呼び出し回数をログに出す
+//#define BENCHMARK_RESOURCE_STATE_TRACKER
+// コメントアウトを外すと起動時にCPUの記録時間、GPUの実行時間、GPUが受け取るまでの遅延を変えたキューのシミュレーションでFramePacerを動かし、
+// 実行中のフレームの資源を使い回していないことを検証して、同時に実行するフレームの数ごとのフレーム時間とCPUの待ち時間をログに出す
+//#define BENCHMARK_FRAME_PACING
+// コメントアウトを外すと起動時に一時ディレクトリに置いたシェーダでShaderCacheのキーが入れ子のインクルード、引数、コンパイラのバージョンの
+// 変化に従うことと、キャッシュのファイルの読み書きを検証して、キーの計算と読み込みの時間をログに出す
+//#define BENCHMARK_SHADER_CACHE
+// コメントアウトを外すと起動時にランダムな依存関係のジョブをJobGraphで実行し、依存するジョブより先に始めたものがないことと、
+// 失敗したジョブの後続を実行しないことを検証して、順に実行した場合の時間とクリティカルパスの長さをログに出す
+//#define BENCHMARK_JOB_GRAPH
+// コメントアウトを外すと起動時に一時ディレクトリに置いたシェーダで、入れ子のインクルードが変わったときにそれを使うシェーダだけが
+// コンパイルし直す対象になることと、FileWatcherが更新を見つけることを検証して、変わったファイルから対象を引く時間をログに出す
+//#define BENCHMARK_SHADER_HOT_RELOAD
+// コメントアウトを外すと起動時に複数のスレッドからAsyncLoggerに書き込み、全てのメッセージが順に正しくフォーマットされることと、
+// キューが一杯のときに捨てた数を数えることを検証して、呼び出し側で1回にかかる時間をその場でフォーマットした場合と比べてログに出す
+//#define BENCHMARK_ASYNC_LOGGER
+
 enum class COLOR_SPACE : int
 {
 	BT709,
@@ -127,6 +181,9 @@ namespace
 	// カメラのフラスタムカリングにかからないようnear以上far以下になるように注意が必要
 	static constexpr float SKY_BOX_HALF_EXTENT = 50.0f;
 
+	// シェーダのファイルの更新を調べる間隔。保存してから画面に出るまでの遅延はこれとコンパイルの時間になる
+	static constexpr uint32_t SHADER_HOT_RELOAD_POLL_INTERVAL_MS = 250;
+
 	struct alignas(256) CbMesh
 	{
 		Matrix World;
@@ -748,6 +805,57 @@ namespace
 		const Vector3& opticalepthRGB = OpticalDepth(worldPos, worldDir);
 		return Vector3(expf(-opticalepthRGB.x), expf(-opticalepthRGB.y), expf(-opticalepthRGB.z));
 	}
+
+	// スクリーンスペース描画パス用のD3D12_GRAPHICS_PIPELINE_STATE_DESCの共通項
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC CreateSSPassPSODescCommon()
+	{
+		// シェーダをリロードしたときにもパイプラインステートを作り直すので、InputElementは静的に持つ
+		static D3D12_INPUT_ELEMENT_DESC SSPassInputElements[2];
+		SSPassInputElements[0].SemanticName = "POSITION";
+		SSPassInputElements[0].SemanticIndex = 0;
+		SSPassInputElements[0].Format = DXGI_FORMAT_R32G32_FLOAT;
+		SSPassInputElements[0].InputSlot = 0;
+		SSPassInputElements[0].AlignedByteOffset = 0;
+		SSPassInputElements[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+		SSPassInputElements[0].InstanceDataStepRate = 0;
+
+		SSPassInputElements[1].SemanticName = "TEXCOORD";
+		SSPassInputElements[1].SemanticIndex = 0;
+		SSPassInputElements[1].Format = DXGI_FORMAT_R32G32_FLOAT;
+		SSPassInputElements[1].InputSlot = 0;
+		SSPassInputElements[1].AlignedByteOffset = 8;
+		SSPassInputElements[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+		SSPassInputElements[1].InstanceDataStepRate = 0;
+
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC SSPassPSODescCommon = {};
+		{
+			SSPassPSODescCommon.InputLayout.pInputElementDescs = SSPassInputElements;
+			SSPassPSODescCommon.InputLayout.NumElements = 2;
+			SSPassPSODescCommon.pRootSignature = nullptr; // 上書き必須
+			SSPassPSODescCommon.VS.pShaderBytecode = nullptr; // 上書き必須。TODO:使いまわそうとしたらエラーになった。
+			SSPassPSODescCommon.VS.BytecodeLength = 0; // 上書き必須。TODO:使いまわそうとしたらエラーになった。
+			SSPassPSODescCommon.PS.pShaderBytecode = nullptr; // 上書き必須
+			SSPassPSODescCommon.PS.BytecodeLength = 0; // 上書き必須
+			SSPassPSODescCommon.RasterizerState = DirectX::CommonStates::CullCounterClockwise;
+			SSPassPSODescCommon.BlendState = DirectX::CommonStates::Opaque;
+			SSPassPSODescCommon.DepthStencilState = DirectX::CommonStates::DepthNone;
+			SSPassPSODescCommon.SampleMask = UINT_MAX;
+			SSPassPSODescCommon.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+			SSPassPSODescCommon.NumRenderTargets = 1;
+			SSPassPSODescCommon.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM; // 上書き必須
+			SSPassPSODescCommon.SampleDesc.Count = 1;
+			SSPassPSODescCommon.SampleDesc.Quality = 0;
+		}
+
+		return SSPassPSODescCommon;
+	}
+
+	const D3D12_GRAPHICS_PIPELINE_STATE_DESC& GetSSPassPSODescCommon()
+	{
+		// 起動時は複数のジョブから同時に呼ばれるが、関数内のstaticの初期化は1回だけ行われる
+		static const D3D12_GRAPHICS_PIPELINE_STATE_DESC SSPassPSODescCommon = CreateSSPassPSODescCommon();
+		return SSPassPSODescCommon;
+	}
 }
 
 SampleApp::SampleApp(int argc, wchar_t** argv, uint32_t width, uint32_t height)
@@ -837,7 +945,85 @@ bool SampleApp::OnInit(HWND hWnd)
 	m_CameraManipulator.Reset(CAMERA_START_POSITION, CAMERA_START_TARGET);
 	m_DirLightManipulator.Reset(DIRECTIONAL_LIGHT_START_POSITION, DIRECTIONAL_LIGHT_START_TARGET);
 
-	m_ShaderCompiler.Init();
+	// 起動時のパイプラインの生成でParallelFor()の全てのスレッドがコンパイルできるように、スレッドの数だけDXCを作る。
+	// 最後の1つはシェーダのホットリロード用
+	if (!m_ShaderCompiler.Init(L"ShaderCache", GetParallelForThreadCount() + 1))
+	{
+		ELOG("Error : ShaderCompiler::Init() Failed.");
+		return false;
+	}
+
+#ifdef BENCHMARK_POOL
+	if (!BenchmarkPool())
+	{
+		ELOG("Error : BenchmarkPool() Failed.");
+		return false;
+	}
+#endif
+
+#ifdef BENCHMARK_TLSF_ALLOCATOR
+	if (!BenchmarkTlsfAllocator())
+	{
+		ELOG("Error : BenchmarkTlsfAllocator() Failed.");
+		return false;
+	}
+#endif
+
+#ifdef BENCHMARK_RENDER_GRAPH
+	if (!BenchmarkRenderGraph())
+	{
+		ELOG("Error : BenchmarkRenderGraph() Failed.");
+		return false;
+	}
+#endif
+
+#ifdef BENCHMARK_RESOURCE_STATE_TRACKER
+	if (!BenchmarkResourceStateTracker())
+	{
+		ELOG("Error : BenchmarkResourceStateTracker() Failed.");
+		return false;
+	}
+#endif
+
+#ifdef BENCHMARK_FRAME_PACING
+	if (!BenchmarkFramePacing())
+	{
+		ELOG("Error : BenchmarkFramePacing() Failed.");
+		return false;
+	}
+#endif
+
+#ifdef BENCHMARK_SHADER_CACHE
+	if (!BenchmarkShaderCache())
+	{
+		ELOG("Error : BenchmarkShaderCache() Failed.");
+		return false;
+	}
+#endif
+
+#ifdef BENCHMARK_JOB_GRAPH
+	if (!BenchmarkJobGraph())
+	{
+		ELOG("Error : BenchmarkJobGraph() Failed.");
+		return false;
+	}
+#endif
+
+#ifdef BENCHMARK_SHADER_HOT_RELOAD
+	if (!BenchmarkShaderHotReload())
+	{
+		ELOG("Error : BenchmarkShaderHotReload() Failed.");
+		return false;
+	}
+#endif
+
+#ifdef BENCHMARK_ASYNC_LOGGER
+	if (!BenchmarkAsyncLogger())
+	{
+		ELOG("Error : BenchmarkAsyncLogger() Failed.");
+		return false;
+	}
+#endif
 
 #if defined(DEBUG) || defined(_DEBUG)
 	// nvapi初期化
@@ -914,7 +1100,8 @@ bool SampleApp::OnInit(HWND hWnd)
 			return false;
 		}
 
-		if (!ImGui_ImplDX12_Init(m_pDevice.Get(), 1, m_BackBufferFormat, m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->GetHeap(), pHandleSRV->HandleCPU, pHandleSRV->HandleGPU))
+		// 頂点バッファはフレームごとに持つので、GPUが実行中のフレームの分も含めてFRAME_COUNTにする
+		if (!ImGui_ImplDX12_Init(m_pDevice.Get(), FRAME_COUNT, m_BackBufferFormat, m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->GetHeap(), pHandleSRV->HandleCPU, pHandleSRV->HandleGPU))
 		{
 			ELOG("Error : ImGui_ImplDX12_Init() Failed.");
 			return false;
@@ -936,6 +1123,8 @@ bool SampleApp::OnInit(HWND hWnd)
 		}
 
 		pCmd->Close();
+		// UploadBufferData()のコピーはアップロード用のリングのコマンドリストに記録されているので、先に実行する
+		m_UploadRing.Submit();
 		ID3D12CommandList* pLists[] = {pCmd};
 		m_pQueue->ExecuteCommandLists(1, pLists);
 		m_Fence.Wait(m_pQueue.Get(), INFINITE);
@@ -970,6 +1159,14 @@ bool SampleApp::OnInit(HWND hWnd)
 			return false;
 		}
 
+#ifdef BENCHMARK_LOOP_SUBDIVISION
+		if (!BenchmarkLoopSubdivision(resMesh, m_useMetis))
+		{
+			ELOG("Error : BenchmarkLoopSubdivision() Failed.");
+			return false;
+		}
+#endif
+
 		ID3D12GraphicsCommandList* pCmd = m_CommandList.Reset();
 
 		if (m_useMeshlet)
@@ -1108,6 +1305,7 @@ bool SampleApp::OnInit(HWND hWnd)
 
 		pCmd->Close();
 
+		m_UploadRing.Submit();
 		ID3D12CommandList* pLists[] = {pCmd};
 		m_pQueue->ExecuteCommandLists(1, pLists);
 
@@ -1260,6 +1458,7 @@ bool SampleApp::OnInit(HWND hWnd)
 
 			pCmd->Close();
 
+			m_UploadRing.Submit();
 			ID3D12CommandList* pLists[] = {pCmd};
 			m_pQueue->ExecuteCommandLists(1, pLists);
 
@@ -1291,26 +1490,61 @@ bool SampleApp::OnInit(HWND hWnd)
 
 		pCmd->Close();
 
+		m_UploadRing.Submit();
 		ID3D12CommandList* pLists[] = {pCmd};
 		m_pQueue->ExecuteCommandLists(1, pLists);
 
 		// Wait command queue finishing.
 		m_Fence.Wait(m_pQueue.Get(), INFINITE);
+
+#ifdef BENCHMARK_PARTICLE_SPATIAL_HASH
+		if (!BenchmarkParticleSpatialHash(m_MeshManager))
+		{
+			ELOG("Error : BenchmarkParticleSpatialHash() Failed.");
+			return false;
+		}
+#endif
+
+#ifdef BENCHMARK_BVH
+		if (!BenchmarkBvh(m_MeshManager))
+		{
+			ELOG("Error : BenchmarkBvh() Failed.");
+			return false;
+		}
+#endif
+
+#ifdef BENCHMARK_SCENE_BVH
+		if (!BenchmarkSceneBvh(m_MeshManager))
+		{
+			ELOG("Error : BenchmarkSceneBvh() Failed.");
+			return false;
+		}
+
+		// 以降はSetMovableWorldMatrix()のたびにTLASがRefitされる
+		if (!m_MeshManager.BuildSceneBvh(BvhBuildSettings()))
+		{
+			ELOG("Error : MeshManager::BuildSceneBvh() Failed.");
+			return false;
+		}
+#endif
 	}
 
 	// カリングフラグ定数バッファの生成
 	if (m_useMeshlet)
 	{
-		if (!m_CullingCB.Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbCulling), L"CbCulling"))
+		for (uint32_t i = 0u; i < FRAME_COUNT; i++)
 		{
-			ELOG("Error : ConstantBuffer::Init() Failed.");
-			return false;
-		}
+			if (!m_CullingCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbCulling), L"CbCulling"))
+			{
+				ELOG("Error : ConstantBuffer::Init() Failed.");
+				return false;
+			}
 
-		CbCulling* ptr = m_CullingCB.GetPtr<CbCulling>();
-		ptr->bEnableFrustumCulling = m_enableFrustomCulling ? 1 : 0;
-		ptr->bEnableOcclusionCulling = m_enableOcclusionCulling ? 1 : 0;
-		ptr->bEnableBackFaceCulling = m_enableBackFaceCulling ? 1 : 0;
+			CbCulling* ptr = m_CullingCB[i].GetPtr<CbCulling>();
+			ptr->bEnableFrustumCulling = m_enableFrustomCulling ? 1 : 0;
+			ptr->bEnableOcclusionCulling = m_enableOcclusionCulling ? 1 : 0;
+			ptr->bEnableBackFaceCulling = m_enableBackFaceCulling ? 1 : 0;
+		}
 	}
 
 	if (m_drawSponza)
@@ -1329,46 +1563,57 @@ bool SampleApp::OnInit(HWND hWnd)
 
 		// ポイントライトバッファの設定
 		{
-			for (uint32_t i = 0u; i < NUM_POINT_LIGHTS; i++)
+			for (uint32_t frameIndex = 0u; frameIndex < FRAME_COUNT; frameIndex++)
 			{
-				if (!m_PointLightCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbPointLight), L"CbPointLight"))
+				for (uint32_t i = 0u; i < NUM_POINT_LIGHTS; i++)
 				{
-					ELOG("Error : ConstantBuffer::Init() Failed.");
-					return false;
+					if (!m_PointLightCB[frameIndex][i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbPointLight), L"CbPointLight"))
+					{
+						ELOG("Error : ConstantBuffer::Init() Failed.");
+						return false;
+					}
 				}
 			}
 
-			// ポイントライトは動かさないないので毎フレームの更新はしない
+			// ポイントライトは動かさないないので毎フレーム更新するのは強度だけ
 
-			CbPointLight* ptr = m_PointLightCB[0].GetPtr<CbPointLight>();
+			CbPointLight pointLights[NUM_POINT_LIGHTS];
 			// 少し黄色っぽい光
-			//*ptr = ComputePointLight(Vector3(-4.95f, 1.10f, 1.15f), 5.0f, Vector3(1.0f, 1.0f, 0.5f), 100.0f);
-			*ptr = ComputePointLight(Vector3(-4.95f, 1.10f, 1.15f), 20.0f, Vector3(1.0f, 1.0f, 0.5f), m_pointLightIntensity);
+			//pointLights[0] = ComputePointLight(Vector3(-4.95f, 1.10f, 1.15f), 5.0f, Vector3(1.0f, 1.0f, 0.5f), 100.0f);
+			pointLights[0] = ComputePointLight(Vector3(-4.95f, 1.10f, 1.15f), 20.0f, Vector3(1.0f, 1.0f, 0.5f), m_pointLightIntensity);
 
-			ptr = m_PointLightCB[1].GetPtr<CbPointLight>();
 			// 少し黄色っぽい光
-			//*ptr = ComputePointLight(Vector3(-4.95f, 1.10f, -1.75f), 5.0f, Vector3(1.0f, 1.0f, 0.5f), 100.0f);
-			*ptr = ComputePointLight(Vector3(-4.95f, 1.10f, -1.75f), 20.0f, Vector3(1.0f, 1.0f, 0.5f), m_pointLightIntensity);
+			//pointLights[1] = ComputePointLight(Vector3(-4.95f, 1.10f, -1.75f), 5.0f, Vector3(1.0f, 1.0f, 0.5f), 100.0f);
+			pointLights[1] = ComputePointLight(Vector3(-4.95f, 1.10f, -1.75f), 20.0f, Vector3(1.0f, 1.0f, 0.5f), m_pointLightIntensity);
 
-			ptr = m_PointLightCB[2].GetPtr<CbPointLight>();
 			// 少し黄色っぽい光
-			//*ptr = ComputePointLight(Vector3(3.90f, 1.10f, 1.15f), 5.0f, Vector3(1.0f, 1.0f, 0.5f), 100.0f);
-			*ptr = ComputePointLight(Vector3(3.90f, 1.10f, 1.15f), 20.0f, Vector3(1.0f, 1.0f, 0.5f), m_pointLightIntensity);
+			//pointLights[2] = ComputePointLight(Vector3(3.90f, 1.10f, 1.15f), 5.0f, Vector3(1.0f, 1.0f, 0.5f), 100.0f);
+			pointLights[2] = ComputePointLight(Vector3(3.90f, 1.10f, 1.15f), 20.0f, Vector3(1.0f, 1.0f, 0.5f), m_pointLightIntensity);
 
-			ptr = m_PointLightCB[3].GetPtr<CbPointLight>();
 			// 少し黄色っぽい光
-			//*ptr = ComputePointLight(Vector3(3.90f, 1.10f, -1.75f), 5.0f, Vector3(1.0f, 1.0f, 0.5f), 100.0f);
-			*ptr = ComputePointLight(Vector3(3.90f, 1.10f, -1.75f), 20.0f, Vector3(1.0f, 1.0f, 0.5f), m_pointLightIntensity);
+			//pointLights[3] = ComputePointLight(Vector3(3.90f, 1.10f, -1.75f), 5.0f, Vector3(1.0f, 1.0f, 0.5f), 100.0f);
+			pointLights[3] = ComputePointLight(Vector3(3.90f, 1.10f, -1.75f), 20.0f, Vector3(1.0f, 1.0f, 0.5f), m_pointLightIntensity);
+
+			for (uint32_t frameIndex = 0u; frameIndex < FRAME_COUNT; frameIndex++)
+			{
+				for (uint32_t i = 0u; i < NUM_POINT_LIGHTS; i++)
+				{
+					*m_PointLightCB[frameIndex][i].GetPtr<CbPointLight>() = pointLights[i];
+				}
+			}
 		}
 
 		// スポットライトバッファの設定
 		{
 			for (uint32_t i = 0u; i < NUM_SPOT_LIGHTS; i++)
 			{
-				if (!m_SpotLightCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbSpotLight), L"CbSpotLight"))
+				for (uint32_t frameIndex = 0u; frameIndex < FRAME_COUNT; frameIndex++)
 				{
-					ELOG("Error : ConstantBuffer::Init() Failed.");
-					return false;
+					if (!m_SpotLightCB[frameIndex][i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbSpotLight), L"CbSpotLight"))
+					{
+						ELOG("Error : ConstantBuffer::Init() Failed.");
+						return false;
+					}
 				}
 
 				if (!m_SpotLightCameraCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbCamera)))
@@ -1378,31 +1623,38 @@ bool SampleApp::OnInit(HWND hWnd)
 				}
 			}
 
+			CbSpotLight spotLights[NUM_SPOT_LIGHTS];
+
 			const Vector3& SpotLight1Dir = Vector3(-20.0f, -4.0f, 0.0f);
 			const Vector3& SpotLight1Pos = Vector3(0.0f, 4.0f, 0.0f);
-			CbSpotLight* ptr = m_SpotLightCB[0].GetPtr<CbSpotLight>();
 			// 少し赤っぽい光
-			*ptr = ComputeSpotLight(0, SpotLight1Dir, SpotLight1Pos, 20.0f, Vector3(1.0f, 0.5f, 0.5f), m_spotLightIntensity, DirectX::XMConvertToRadians(5.0f), DirectX::XMConvertToRadians(10.0f), SPOT_LIGHT_SHADOW_MAP_SIZE);
+			spotLights[0] = ComputeSpotLight(0, SpotLight1Dir, SpotLight1Pos, 20.0f, Vector3(1.0f, 0.5f, 0.5f), m_spotLightIntensity, DirectX::XMConvertToRadians(5.0f), DirectX::XMConvertToRadians(10.0f), SPOT_LIGHT_SHADOW_MAP_SIZE);
 			CbCamera* tptr = m_SpotLightCameraCB[0].GetPtr<CbCamera>();
 			tptr->ViewProj = ComputeSpotLightViewProj(SpotLight1Dir, SpotLight1Pos, 20.0f, DirectX::XMConvertToRadians(10.0f));
 
 			const Vector3& SpotLight2Dir = Vector3(0.0f, -10.0f, 2.0f);
 			const Vector3& SpotLight2Pos = Vector3(0.0f, 10.0f, 0.0f);
-			ptr = m_SpotLightCB[1].GetPtr<CbSpotLight>();
 			// 少し緑っぽい光
-			*ptr = ComputeSpotLight(0, SpotLight2Dir, SpotLight2Pos, 20.0f, Vector3(0.5f, 1.0f, 0.5f), m_spotLightIntensity, DirectX::XMConvertToRadians(5.0f), DirectX::XMConvertToRadians(10.0f), SPOT_LIGHT_SHADOW_MAP_SIZE);
+			spotLights[1] = ComputeSpotLight(0, SpotLight2Dir, SpotLight2Pos, 20.0f, Vector3(0.5f, 1.0f, 0.5f), m_spotLightIntensity, DirectX::XMConvertToRadians(5.0f), DirectX::XMConvertToRadians(10.0f), SPOT_LIGHT_SHADOW_MAP_SIZE);
 
 			tptr = m_SpotLightCameraCB[1].GetPtr<CbCamera>();
 			tptr->ViewProj = ComputeSpotLightViewProj(SpotLight2Dir, SpotLight2Pos, 20.0f, DirectX::XMConvertToRadians(10.0f));
 
 			const Vector3& SpotLight3Dir = Vector3(20.0f, -4.0f, 0.0f);
 			const Vector3& SpotLight3Pos = Vector3(0.0f, 4.0f, 0.0f);
-			ptr = m_SpotLightCB[2].GetPtr<CbSpotLight>();
 			// 少し青っぽい光
-			*ptr = ComputeSpotLight(0, SpotLight3Dir, SpotLight3Pos, 20.0f, Vector3(0.5f, 0.5f, 1.0f), m_spotLightIntensity, DirectX::XMConvertToRadians(5.0f), DirectX::XMConvertToRadians(10.0f), SPOT_LIGHT_SHADOW_MAP_SIZE);
+			spotLights[2] = ComputeSpotLight(0, SpotLight3Dir, SpotLight3Pos, 20.0f, Vector3(0.5f, 0.5f, 1.0f), m_spotLightIntensity, DirectX::XMConvertToRadians(5.0f), DirectX::XMConvertToRadians(10.0f), SPOT_LIGHT_SHADOW_MAP_SIZE);
 
 			tptr = m_SpotLightCameraCB[2].GetPtr<CbCamera>();
 			tptr->ViewProj = ComputeSpotLightViewProj(SpotLight3Dir, SpotLight3Pos, 20.0f, DirectX::XMConvertToRadians(10.0f));
+
+			for (uint32_t frameIndex = 0u; frameIndex < FRAME_COUNT; frameIndex++)
+			{
+				for (uint32_t i = 0u; i < NUM_SPOT_LIGHTS; i++)
+				{
+					*m_SpotLightCB[frameIndex][i].GetPtr<CbSpotLight>() = spotLights[i];
+				}
+			}
 		}
 
 		// 空の描画用のバッファの設定
@@ -1871,7 +2123,7 @@ bool SampleApp::OnInit(HWND hWnd)
 		}
 	}
 
-	// HZB用ターゲットの生成と参照用にMipレベルを制限したSRVの例外的生成
+	// HZB用ターゲットの生成。参照用にMipレベルを制限したSRVはDrawHZB()で一時的なディスクリプタに作る
 	{
 		float clearColor[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 
@@ -1897,41 +2149,6 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ColorTarget::InitUnorderedAccessTarget() Failed.");
 			return false;
 		}
-
-		uint32_t numDrawCall = DivideAndRoundUp(numMips, HZB_MAX_NUM_OUTPUT_MIP);
-
-		m_pHZB_ParentMipSRVs.reserve(numDrawCall - 1);
-		for (uint32_t i = 1; i < numDrawCall; i++) // 最初のドローコールはSceneDepthを使うので作らない
-		{
-			uint32_t minMipLevel = i * HZB_MAX_NUM_OUTPUT_MIP;
-
-			// https://learn.microsoft.com/en-us/windows/win32/api/d3d12/ns-d3d12-d3d12_tex2d_srv
-			D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc;
-			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-			srvDesc.Format = m_HZB_Target.GetDesc().Format;
-			srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-			// ひとつ小さいMipレベルを参照する
-			srvDesc.Texture2D.MostDetailedMip = minMipLevel - 1;
-			// Mipレベル一枚だけでSRVを作る
-			srvDesc.Texture2D.MipLevels = 1;
-			srvDesc.Texture2D.PlaneSlice = 0;
-			srvDesc.Texture2D.ResourceMinLODClamp = 0;
-
-			DescriptorHandle* pHandleSRV = m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->AllocHandle();
-			if (pHandleSRV == nullptr)
-			{
-				ELOG("Error : DescriptorPool::AllocHandle() Failed.");
-				return false;
-			}
-
-			m_pDevice.Get()->CreateShaderResourceView(
-				m_HZB_Target.GetResource(),
-				&srvDesc,
-				pHandleSRV->HandleCPU
-			);
-
-			m_pHZB_ParentMipSRVs.push_back(pHandleSRV);
-		}
 	}
 
 	// ObjectVelocity用カラーターゲットの生成
@@ -2092,6 +2309,7 @@ bool SampleApp::OnInit(HWND hWnd)
 
 		pCmd->Close();
 
+		m_UploadRing.Submit();
 		ID3D12CommandList* pLists[] = {pCmd};
 		m_pQueue->ExecuteCommandLists(1, pLists);
 
@@ -2447,9 +2665,14 @@ bool SampleApp::OnInit(HWND hWnd)
 		}
 	}
 
+	// シェーダのコンパイルとルートシグニチャ、パイプラインステートの生成はジョブにして、全て登録してからワーカーで並列に実行する。
+	// ジョブはそれぞれ自分のメンバだけを作り、OnInit()のローカル変数は登録し終えた時点で決まっているものを読むだけにする
+	JobGraph pipelineJobs;
+
 	if (m_drawSponza)
 	{
 		// 空の透過率LUT用ルートシグニチャとパイプラインステートの生成
+		pipelineJobs.AddJob("SkyTransmittanceLUT", {}, [&](uint32_t workerIndex) -> bool
 		{
 			std::wstring csPath;
 
@@ -2500,9 +2723,12 @@ bool SampleApp::OnInit(HWND hWnd)
 				ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 				return false;
 			}
-		}
+
+			return true;
+		});
 
 		// 空の多重散乱LUT用ルートシグニチャとパイプラインステートの生成
+		pipelineJobs.AddJob("SkyMultiScatteringLUT", {}, [&](uint32_t workerIndex) -> bool
 		{
 			std::wstring csPath;
 
@@ -2553,9 +2779,12 @@ bool SampleApp::OnInit(HWND hWnd)
 				ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 				return false;
 			}
-		}
+
+			return true;
+		});
 
 		// 空のLUT用ルートシグニチャとパイプラインステートの生成
+		pipelineJobs.AddJob("SkyViewLUT", {}, [&](uint32_t workerIndex) -> bool
 		{
 			std::wstring csPath;
 
@@ -2606,9 +2835,12 @@ bool SampleApp::OnInit(HWND hWnd)
 				ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 				return false;
 			}
-		}
+
+			return true;
+		});
 
 		// 雲のレイマーチ描画用のルートシグニチャとパイプラインステートの生成
+		pipelineJobs.AddJob("VolumetricCloud", {}, [&](uint32_t workerIndex) -> bool
 		{
 			std::wstring csPath;
 
@@ -2659,12 +2891,19 @@ bool SampleApp::OnInit(HWND hWnd)
 				ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 				return false;
 			}
-		}
+
+			return true;
+		});
 	}
 
     // デプスだけの描画用ルートシグニチャとパイプラインステートの生成
-	if (m_drawSponza)
+	pipelineJobs.AddJob("Depth", {}, [&](uint32_t workerIndex) -> bool
 	{
+		if (!m_drawSponza)
+		{
+			return true;
+		}
+
 		if (m_useMeshlet)
 		{
 			std::wstring psPath;
@@ -2864,11 +3103,18 @@ bool SampleApp::OnInit(HWND hWnd)
 				return false;
 			}
 		}
-	}
+
+		return true;
+	});
 
 	// GBuffer描画用ルートシグニチャとパイプラインステートの生成
-	if (!m_useMeshlet)
+	pipelineJobs.AddJob("GBuffer", {}, [&](uint32_t workerIndex) -> bool
 	{
+		if (m_useMeshlet)
+		{
+			return true;
+		}
+
 		// AlphaModeがOpaqueのマテリアル用
 		std::wstring psPath;
 		if (!SearchFilePath(L"GBufferOpaquePS.cso", psPath))
@@ -2988,11 +3234,18 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
 	// Meshletカリング用ルートシグニチャとパイプラインステートの生成
-	if (m_useMeshlet)
+	pipelineJobs.AddJob("MeshletCulling", {}, [&](uint32_t workerIndex) -> bool
 	{
+		if (!m_useMeshlet)
+		{
+			return true;
+		}
+
 		std::wstring csPath;
 		if (!SearchFilePath(L"MeshletsCulling.cso", csPath))
 		{
@@ -3041,11 +3294,18 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
 	// Visibilityパス用ルートシグニチャとパイプラインステートの生成
-	if (m_useMeshlet)
+	pipelineJobs.AddJob("DrawVBuffer", {}, [&](uint32_t workerIndex) -> bool
 	{
+		if (!m_useMeshlet)
+		{
+			return true;
+		}
+
 		if (m_useSWRasterizer)
 		{
 			std::wstring csPath;
@@ -3223,9 +3483,12 @@ bool SampleApp::OnInit(HWND hWnd)
 				return false;
 			}
 		}
-	}
+
+		return true;
+	});
 
     // HCB作成パス用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("HCB", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring csPath;
 
@@ -3276,9 +3539,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // HZB作成パス用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("HZB", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring csPath;
 
@@ -3329,9 +3595,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // ObjectVelocity用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("ObjectVelocity", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring psPath;
 		if (!SearchFilePath(L"ObjectVelocityPS.cso", psPath))
@@ -3478,48 +3747,14 @@ bool SampleApp::OnInit(HWND hWnd)
 				return false;
 			}
 		}
-	}
-
-	// スクリーンスペース描画パス用のInputElement。解放されないようにスコープ外で定義。
-	D3D12_INPUT_ELEMENT_DESC SSPassInputElements[2];
-	SSPassInputElements[0].SemanticName = "POSITION";
-	SSPassInputElements[0].SemanticIndex = 0;
-	SSPassInputElements[0].Format = DXGI_FORMAT_R32G32_FLOAT;
-	SSPassInputElements[0].InputSlot = 0;
-	SSPassInputElements[0].AlignedByteOffset = 0;
-	SSPassInputElements[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
-	SSPassInputElements[0].InstanceDataStepRate = 0;
 
-	SSPassInputElements[1].SemanticName = "TEXCOORD";
-	SSPassInputElements[1].SemanticIndex = 0;
-	SSPassInputElements[1].Format = DXGI_FORMAT_R32G32_FLOAT;
-	SSPassInputElements[1].InputSlot = 0;
-	SSPassInputElements[1].AlignedByteOffset = 8;
-	SSPassInputElements[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
-	SSPassInputElements[1].InstanceDataStepRate = 0;
+		return true;
+	});
 
-	// スクリーンスペース描画パス用のD3D12_GRAPHICS_PIPELINE_STATE_DESCの共通項
-	D3D12_GRAPHICS_PIPELINE_STATE_DESC SSPassPSODescCommon = {};
-	{
-		SSPassPSODescCommon.InputLayout.pInputElementDescs = SSPassInputElements;
-		SSPassPSODescCommon.InputLayout.NumElements = 2;
-		SSPassPSODescCommon.pRootSignature = nullptr; // 上書き必須
-		SSPassPSODescCommon.VS.pShaderBytecode = nullptr; // 上書き必須。TODO:使いまわそうとしたらエラーになった。
-		SSPassPSODescCommon.VS.BytecodeLength = 0; // 上書き必須。TODO:使いまわそうとしたらエラーになった。
-		SSPassPSODescCommon.PS.pShaderBytecode = nullptr; // 上書き必須
-		SSPassPSODescCommon.PS.BytecodeLength = 0; // 上書き必須
-		SSPassPSODescCommon.RasterizerState = DirectX::CommonStates::CullCounterClockwise;
-		SSPassPSODescCommon.BlendState = DirectX::CommonStates::Opaque;
-		SSPassPSODescCommon.DepthStencilState = DirectX::CommonStates::DepthNone;
-		SSPassPSODescCommon.SampleMask = UINT_MAX;
-		SSPassPSODescCommon.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-		SSPassPSODescCommon.NumRenderTargets = 1;
-		SSPassPSODescCommon.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM; // 上書き必須
-		SSPassPSODescCommon.SampleDesc.Count = 1;
-		SSPassPSODescCommon.SampleDesc.Quality = 0;
-	}
+	const D3D12_GRAPHICS_PIPELINE_STATE_DESC& SSPassPSODescCommon = GetSSPassPSODescCommon();
 
 	// VBufferからのDepthBuffer描画パス用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("DepthBufferFromVBuffer", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 
@@ -3587,9 +3822,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
 	// VBufferからのGBuffer描画パス用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("GBufferFromVBuffer", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 
@@ -3657,34 +3895,27 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
-
-	// ディファードシェーディングパス用ルートシグニチャとパイプラインステートの生成
-	{
-		std::wstring vsPath;
-
-		if (!SearchFilePath(L"QuadVS.cso", vsPath))
-		{
-			ELOG("Error : Vertex Shader Not Found");
-			return false;
-		}
-		ComPtr<ID3DBlob> pVSBlob;
 
-		HRESULT hr = D3DReadFileToBlob(vsPath.c_str(), pVSBlob.GetAddressOf());
-		if (FAILED(hr))
-		{
-			ELOG("Error : D3DReadFileToBlob Failed. path = %ls", vsPath.c_str());
-			return false;
-		}
+		return true;
+	});
 
-		std::wstring psPath;
-		if (!SearchFilePath(L"DeferredLightingPS.hlsl", psPath))
+	// ディファードシェーディングパス用ピクセルシェーダのコンパイル。結果はパイプラインステートを作るジョブが使う
+	// ファイルが変わったら同じ引数でコンパイルし直すので、パスと引数と使ったファイルも残す。
+	// 実行時にコンパイルしているのはこのシェーダだけで、ほかのパスはビルド時に作った.csoを読み込むのでリロードできない
+	std::wstring deferredLightingPSPath;
+	std::vector<const wchar_t*> deferredLightingPSArgs;
+	std::vector<std::wstring> deferredLightingPSSourceFiles;
+	ComPtr<IDxcBlob> pDeferredLightingPSBlob;
+	uint32_t deferredLightingPSJob = pipelineJobs.AddJob("DeferredLightingPS", {}, [&](uint32_t workerIndex) -> bool
+	{
+		if (!SearchFilePath(L"DeferredLightingPS.hlsl", deferredLightingPSPath))
 		{
 			ELOG("Error : Pixel Shader Not Found");
 			return false;
 		}
 
-		std::vector<const wchar_t*> compileArgs =
+		std::vector<const wchar_t*>& compileArgs = deferredLightingPSArgs;
+		compileArgs =
 		{
 			L"-T ps_6_7",
 			L"-I", L"../res",
@@ -3699,48 +3930,23 @@ bool SampleApp::OnInit(HWND hWnd)
 			compileArgs.push_back(L"-D DRAW_SPONZA");
 		}
 
-		ComPtr<IDxcBlob> pPSBlob;
-		if (!m_ShaderCompiler.Compile(psPath.c_str(), compileArgs, pPSBlob))
-		{
-			ELOG("Error : ShaderCompiler::Compile() Failed. path = %ls", psPath.c_str());
-			return false;
-		}
-
-		ComPtr<ID3DBlob> pRSBlob;
-		hr = D3DGetBlobPart(pPSBlob->GetBufferPointer(), pPSBlob->GetBufferSize(), D3D_BLOB_ROOT_SIGNATURE, 0, &pRSBlob);
-		if (FAILED(hr))
-		{
-			ELOG("Error : D3DGetBlobPart Failed. path = %ls", psPath.c_str());
-			return false;
-		}
-
-		if (!m_DeferredShadingRootSig.Init(m_pDevice.Get(), pRSBlob))
+		if (!m_ShaderCompiler.Compile(workerIndex, deferredLightingPSPath.c_str(), compileArgs, pDeferredLightingPSBlob, &deferredLightingPSSourceFiles))
 		{
-			ELOG("Error : RootSignature::Init() Failed.");
+			ELOG("Error : ShaderCompiler::Compile() Failed. path = %ls", deferredLightingPSPath.c_str());
 			return false;
 		}
 
-		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = SSPassPSODescCommon;
-		desc.pRootSignature = m_DeferredShadingRootSig.GetPtr();
-		desc.VS.pShaderBytecode = pVSBlob->GetBufferPointer();
-		desc.VS.BytecodeLength = pVSBlob->GetBufferSize();
-		desc.PS.pShaderBytecode = pPSBlob->GetBufferPointer();
-		desc.PS.BytecodeLength = pPSBlob->GetBufferSize();
-		desc.NumRenderTargets = 1;
-		desc.RTVFormats[0] = m_SceneColorTarget.GetRTVDesc().Format;
+		return true;
+	});
 
-		hr = m_pDevice->CreateGraphicsPipelineState(
-			&desc,
-			IID_PPV_ARGS(m_pDeferredShadingPSO.GetAddressOf())
-		);
-		if (FAILED(hr))
-		{
-			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
-			return false;
-		}
-	}
+	// ディファードシェーディングパス用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("DeferredShading", {deferredLightingPSJob}, [&](uint32_t workerIndex) -> bool
+	{
+		return CreateDeferredShadingPipeline(pDeferredLightingPSBlob.Get(), deferredLightingPSPath.c_str(), m_DeferredShadingRootSig, m_pDeferredShadingPSO);
+	});
 
     // CameraVelocity用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("CameraVelocity", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -3805,9 +4011,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // SSAO準備パス用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("SSAOSetup", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -3872,9 +4081,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // SSAO用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("SSAO", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -3939,9 +4151,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // SSGI用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("SSGI", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring csPath;
 
@@ -3992,9 +4207,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // SSGIデノイズパス用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("SSGI_Denoise", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring csPath;
 
@@ -4045,9 +4263,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // SSGI Temporal Acclumulationパス用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("SSGI_TemporalAccumulation", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring csPath;
 
@@ -4098,9 +4319,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // AmbientLight用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("AmbientLight", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -4165,9 +4389,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // SSR用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("SSR", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -4232,11 +4459,14 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
 	if (m_drawSponza)
 	{
 		// VolumetricFog Scattering用ルートシグニチャとパイプラインステートの生成
+		pipelineJobs.AddJob("VolumetricFogScattering", {}, [&](uint32_t workerIndex) -> bool
 		{
 			std::wstring csPath;
 
@@ -4287,9 +4517,12 @@ bool SampleApp::OnInit(HWND hWnd)
 				ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 				return false;
 			}
-		}
+
+			return true;
+		});
 
 		// VolumetricFog Integration用ルートシグニチャとパイプラインステートの生成
+		pipelineJobs.AddJob("VolumetricFogIntegration", {}, [&](uint32_t workerIndex) -> bool
 		{
 			std::wstring csPath;
 
@@ -4340,9 +4573,12 @@ bool SampleApp::OnInit(HWND hWnd)
 				ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 				return false;
 			}
-		}
+
+			return true;
+		});
 
 		// VolumetricFog Composition用パイプラインステートの生成
+		pipelineJobs.AddJob("VolumetricFogComposition", {}, [&](uint32_t workerIndex) -> bool
 		{
 			std::wstring vsPath;
 			std::wstring psPath;
@@ -4407,10 +4643,13 @@ bool SampleApp::OnInit(HWND hWnd)
 				ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 				return false;
 			}
-		}
+
+			return true;
+		});
 	}
 
     // TemporalAA用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("TemporalAA", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring csPath;
 
@@ -4461,9 +4700,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateComputePipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // MotionBlur用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("MotionBlur", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -4528,9 +4770,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // Bloom前工程用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("BloomSetup", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -4595,9 +4840,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // トーンマップ用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("Tonemap", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -4662,9 +4910,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // FXAA用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("FXAA", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -4729,11 +4980,18 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
 	// VBuffer関連デバッグ描画用ルートシグニチャとパイプラインステートの生成
-	if (m_useMeshlet)
+	pipelineJobs.AddJob("DebugVBuffer", {}, [&](uint32_t workerIndex) -> bool
 	{
+		if (!m_useMeshlet)
+		{
+			return true;
+		}
+
 		std::wstring vsPath;
 		std::wstring psPath;
 
@@ -4797,11 +5055,18 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
 	// Meshlet AABB表示用ルートシグニチャとパイプラインステートの生成
-	if (m_useMeshlet)
+	pipelineJobs.AddJob("MeshletAABB", {}, [&](uint32_t workerIndex) -> bool
 	{
+		if (!m_useMeshlet)
+		{
+			return true;
+		}
+
 		std::wstring msPath;
 		if (!SearchFilePath(L"AABBs_MS.cso", msPath))
 		{
@@ -4883,9 +5148,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreatePipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // 汎用ダウンサンプルパス用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("Downsample", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -4950,9 +5218,12 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // 汎用フィルタ用ルートシグニチャとパイプラインステートの生成
+	pipelineJobs.AddJob("Filter", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -5017,10 +5288,13 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
-	}
+
+		return true;
+	});
 
     // バックバッファ描画用ルートシグニチャとパイプラインステートの生成
 	// DXGIフォーマットを指定する必要があるので一般のテクスチャコピー用にはできなかった
+	pipelineJobs.AddJob("BackBuffer", {}, [&](uint32_t workerIndex) -> bool
 	{
 		std::wstring vsPath;
 		std::wstring psPath;
@@ -5085,6 +5359,33 @@ bool SampleApp::OnInit(HWND hWnd)
 			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
 			return false;
 		}
+
+		return true;
+	});
+
+	// 以前は上のジョブを登録した順に1つずつ実行していた。ログの*の付いたジョブがクリティカルパスになる
+	if (!pipelineJobs.Run(GetParallelForThreadCount()))
+	{
+		ELOG("Error : JobGraph::Run() Failed.");
+		return false;
+	}
+	pipelineJobs.LogTimeline();
+
+	// 起動時のコンパイルを全て終えてから、ParallelFor()のスレッドが使わない最後のワーカーでコンパイルし直すスレッドを始める
+	if (!m_ShaderHotReloader.Init(&m_ShaderCompiler, GetParallelForThreadCount(), SHADER_HOT_RELOAD_POLL_INTERVAL_MS))
+	{
+		ELOG("Error : ShaderHotReloader::Init() Failed.");
+		return false;
+	}
+	m_DeferredLightingPSReloadIdx = m_ShaderHotReloader.AddShader(deferredLightingPSPath.c_str(), deferredLightingPSArgs, deferredLightingPSSourceFiles);
+
+	// .csoを読み込むパスは監視していないので、変更を反映するには再起動がいる
+	{
+		const ShaderHotReloadStats& stats = m_ShaderHotReloader.GetStats();
+		ELOG("ShaderHotReloader : watching %u files of %u runtime-compiled shaders. Shaders loaded from .cso are not reloaded.",
+			stats.FileCount,
+			stats.ShaderCount
+		);
 	}
 
 	// スクリーンスペースパス用頂点バッファの生成
@@ -5263,14 +5564,15 @@ bool SampleApp::OnInit(HWND hWnd)
 	}
 
 	// SSGIパス用定数バッファの作成
+	for (uint32_t i = 0u; i < FRAME_COUNT; i++)
 	{
-		if (!m_SSGI_CB.Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbSSGI)))
+		if (!m_SSGI_CB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbSSGI)))
 		{
 			ELOG("Error : ConstantBuffer::Init() Failed.");
 			return false;
 		}
 
-		CbSSGI* ptr = m_SSGI_CB.GetPtr<CbSSGI>();
+		CbSSGI* ptr = m_SSGI_CB[i].GetPtr<CbSSGI>();
 		ptr->ProjMatrix = Matrix::Identity;
 		ptr->VRotPMatrix = Matrix::Identity;
 		ptr->InvVRotPMatrix = Matrix::Identity;
@@ -5295,14 +5597,15 @@ bool SampleApp::OnInit(HWND hWnd)
 	}
 
 	// SSR用定数バッファの作成
+	for (uint32_t i = 0; i < FRAME_COUNT; i++)
 	{
-		if (!m_SSR_CB.Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbSSR)))
+		if (!m_SSR_CB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbSSR)))
 		{
 			ELOG("Error : ConstantBuffer::Init() Failed.");
 			return false;
 		}
 
-		CbSSR* ptr = m_SSR_CB.GetPtr<CbSSR>();
+		CbSSR* ptr = m_SSR_CB[i].GetPtr<CbSSR>();
 		ptr->ProjMatrix = Matrix::Identity;
 		ptr->VRotPMatrix = Matrix::Identity;
 		ptr->InvVRotPMatrix = Matrix::Identity;
@@ -5317,23 +5620,26 @@ bool SampleApp::OnInit(HWND hWnd)
 	// VolumetricFog用定数バッファの作成
 	if (m_drawSponza)
 	{
-		if (!m_VolumetricFogCB.Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbVolumetricFog)))
+		for (uint32_t i = 0; i < FRAME_COUNT; i++)
 		{
-			ELOG("Error : ConstantBuffer::Init() Failed.");
-			return false;
-		}
+			if (!m_VolumetricFogCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbVolumetricFog)))
+			{
+				ELOG("Error : ConstantBuffer::Init() Failed.");
+				return false;
+			}
 
-		CbVolumetricFog* ptr = m_VolumetricFogCB.GetPtr<CbVolumetricFog>();
-		ptr->InvVRotPMatrix = Matrix::Identity;
-		ptr->ClipToPrevClip = Matrix::Identity;
-		ptr->GridSizeX = (int)m_VolumetricFogScatteringTarget[m_FrameIndex].GetDesc().Width;
-		ptr->GridSizeY = m_VolumetricFogScatteringTarget[m_FrameIndex].GetDesc().Height;
-		ptr->GridSizeZ = m_VolumetricFogScatteringTarget[m_FrameIndex].GetDesc().DepthOrArraySize;
-		ptr->Near = VOLUMETRIC_FOG_FROXEL_NEAR;
-		ptr->Far = VOLUMETRIC_FOG_FROXEL_FAR;
-		ptr->FrameJitterOffsetValue = VolumetricFogTemporalRandom(m_FrameNumber);
-		ptr->DirectionalLightScatteringIntensity = m_directionalLightVolumetricFogScatteringIntensity;
-		ptr->SpotLightScatteringIntensity = m_spotLightVolumetricFogScatteringIntensity;
+			CbVolumetricFog* ptr = m_VolumetricFogCB[i].GetPtr<CbVolumetricFog>();
+			ptr->InvVRotPMatrix = Matrix::Identity;
+			ptr->ClipToPrevClip = Matrix::Identity;
+			ptr->GridSizeX = (int)m_VolumetricFogScatteringTarget[i].GetDesc().Width;
+			ptr->GridSizeY = m_VolumetricFogScatteringTarget[i].GetDesc().Height;
+			ptr->GridSizeZ = m_VolumetricFogScatteringTarget[i].GetDesc().DepthOrArraySize;
+			ptr->Near = VOLUMETRIC_FOG_FROXEL_NEAR;
+			ptr->Far = VOLUMETRIC_FOG_FROXEL_FAR;
+			ptr->FrameJitterOffsetValue = VolumetricFogTemporalRandom(m_FrameNumber);
+			ptr->DirectionalLightScatteringIntensity = m_directionalLightVolumetricFogScatteringIntensity;
+			ptr->SpotLightScatteringIntensity = m_spotLightVolumetricFogScatteringIntensity;
+		}
 	}
 
 	// TemporalAA用定数バッファの作成
@@ -5391,14 +5697,15 @@ bool SampleApp::OnInit(HWND hWnd)
 	}
 
 	// MotionBlur用定数バッファの作成
+	for (uint32_t i = 0; i < FRAME_COUNT; i++)
 	{
-		if (!m_MotionBlurCB.Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbMotionBlur)))
+		if (!m_MotionBlurCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbMotionBlur)))
 		{
 			ELOG("Error : ConstantBuffer::Init() Failed.");
 			return false;
 		}
 
-		CbMotionBlur* ptr = m_MotionBlurCB.GetPtr<CbMotionBlur>();
+		CbMotionBlur* ptr = m_MotionBlurCB[i].GetPtr<CbMotionBlur>();
 		ptr->Width = m_Width;
 		ptr->Height = m_Height;
 		ptr->Scale = m_motionBlurScale;
@@ -5479,14 +5786,15 @@ bool SampleApp::OnInit(HWND hWnd)
 	}
 
 	// FXAA用定数バッファの作成
+	for (uint32_t i = 0u; i < FRAME_COUNT; i++)
 	{
-		if (!m_FXAA_CB.Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbFXAA)))
+		if (!m_FXAA_CB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbFXAA)))
 		{
 			ELOG("Error : ConstantBuffer::Init() Failed.");
 			return false;
 		}
 
-		CbFXAA* ptr = m_FXAA_CB.GetPtr<CbFXAA>();
+		CbFXAA* ptr = m_FXAA_CB[i].GetPtr<CbFXAA>();
 		ptr->Width = m_Width;
 		ptr->Height = m_Height;
 		ptr->bEnableFXAA = (m_enableFXAA ? 1 : 0);
@@ -5508,14 +5816,15 @@ bool SampleApp::OnInit(HWND hWnd)
 	}
 
 	// バックバッファ描画用の定数バッファの作成
+	for (uint32_t i = 0u; i < FRAME_COUNT; i++)
 	{
-		if (!m_BackBufferCB.Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbSampleTexture)))
+		if (!m_BackBufferCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbSampleTexture)))
 		{
 			ELOG("Error : ConstantBuffer::Init() Failed.");
 			return false;
 		}
 
-		CbSampleTexture* ptr = m_BackBufferCB.GetPtr<CbSampleTexture>();
+		CbSampleTexture* ptr = m_BackBufferCB[i].GetPtr<CbSampleTexture>();
 		ptr->bOnlyRedChannel = 1;
 		ptr->Contrast = 1.0f;
 		ptr->Scale = 1.0f;
@@ -5550,14 +5859,15 @@ bool SampleApp::OnInit(HWND hWnd)
 			ptr->ViewProj = dirLightShadowViewProj;
 		}
 
+		for (uint32_t i = 0u; i < FRAME_COUNT; i++)
 		{
-			if (!m_ShadowTransformCB.Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbShadowTransform), L"CbShadowTransform"))
+			if (!m_ShadowTransformCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES_GPU_VISIBLE], sizeof(CbShadowTransform), L"CbShadowTransform"))
 			{
 				ELOG("Error : ConstantBuffer::Init() Failed.");
 				return false;
 			}
 
-			CbShadowTransform* ptr = m_ShadowTransformCB.GetPtr<CbShadowTransform>();
+			CbShadowTransform* ptr = m_ShadowTransformCB[i].GetPtr<CbShadowTransform>();
 
 			// プロジェクション座標の[-1,-1]*[-1,1]*[0,1]をシャドウマップ用座標[0,1]*[1,0]*[0,1]に変換する
 			const Matrix& toShadowMap = Matrix::CreateScale(0.5f, -0.5f, 1.0f) * Matrix::CreateTranslation(0.5f, 0.5f, 0.0f);
@@ -5606,6 +5916,7 @@ bool SampleApp::OnInit(HWND hWnd)
 
 			pCmd->Close();
 
+			m_UploadRing.Submit();
 			ID3D12CommandList* pLists[] = {pCmd};
 			m_pQueue->ExecuteCommandLists(1, pLists);
 
@@ -5706,6 +6017,7 @@ bool SampleApp::OnInit(HWND hWnd)
 
 			pCmd->Close();
 
+			m_UploadRing.Submit();
 			ID3D12CommandList* pLists[] = {pCmd};
 			m_pQueue->ExecuteCommandLists(1, pLists);
 
@@ -6210,6 +6522,7 @@ bool SampleApp::OnInit(HWND hWnd)
 		}
 
 		pCmd->Close();
+		m_UploadRing.Submit();
 		ID3D12CommandList* pLists[] = {pCmd};
 		m_pQueue->ExecuteCommandLists(1, pLists);
 		// Wait command queue finishing.
@@ -6220,13 +6533,252 @@ bool SampleApp::OnInit(HWND hWnd)
 	#endif
 	}
 
+#if defined(BENCHMARK_WIDE_BVH) || defined(RENDER_PATH_TRACING_REFERENCE)
+	if (m_useMeshlet)
+	{
+		constexpr float fovY = DirectX::XMConvertToRadians(CAMERA_FOV_Y_DEGREE);
+		float aspect = static_cast<float>(m_Width) / static_cast<float>(m_Height);
+		const Matrix& viewProj = m_CameraManipulator.GetView() * CreatePerspectiveFieldOfViewInfinityFarReverseZ(fovY, aspect, CAMERA_NEAR);
+
+#ifdef BENCHMARK_WIDE_BVH
+		if (!BenchmarkWideBvh(m_MeshManager, m_Width, m_Height, m_CameraManipulator.GetPosition(), viewProj.Invert()))
+		{
+			ELOG("Error : BenchmarkWideBvh() Failed.");
+			return false;
+		}
+#endif
+
+#ifdef RENDER_PATH_TRACING_REFERENCE
+		std::vector<PathTracerDirectionalLight> directionalLights;
+		std::vector<PathTracerPointLight> pointLights;
+		std::vector<PathTracerSpotLight> spotLights;
+		Vector3 skyRadiance = Vector3::Zero;
+
+		if (m_drawSponza)
+		{
+			// ライトバッファと同じ値を使う
+			PathTracerDirectionalLight directionalLight;
+			directionalLight.Forward = m_DirLightManipulator.GetForward();
+			directionalLight.Color = GetTransmittanceAtGroundLevel(m_CameraManipulator.GetPosition(), -directionalLight.Forward) * GetSunLightOuterSpaceIlluminance(m_directionalLightIntensity, Vector3::One);
+			directionalLights.push_back(directionalLight);
+
+			for (uint32_t i = 0u; i < NUM_POINT_LIGHTS; i++)
+			{
+				const CbPointLight* ptr = m_PointLightCB[m_FrameIndex][i].GetPtr<CbPointLight>();
+				pointLights.push_back({ptr->LightPosition, ptr->LightInvSqrRadius, ptr->LightColor, m_pointLightIntensity});
+			}
+
+			for (uint32_t i = 0u; i < NUM_SPOT_LIGHTS; i++)
+			{
+				const CbSpotLight* ptr = m_SpotLightCB[m_FrameIndex][i].GetPtr<CbSpotLight>();
+				spotLights.push_back({ptr->LightPosition, ptr->LightInvSqrRadius, ptr->LightColor, m_spotLightIntensity, ptr->LightForward, ptr->LightAngleScale, ptr->LightAngleOffset});
+			}
+		}
+		else
+		{
+			// IBLの環境マップはCPUから読めないので、一様な白い空で代用する
+			skyRadiance = Vector3::One;
+		}
+
+		if (!RenderPathTracingReference(m_MeshManager, m_Width, m_Height, m_CameraManipulator.GetPosition(), viewProj.Invert(), directionalLights, pointLights, spotLights, skyRadiance))
+		{
+			ELOG("Error : RenderPathTracingReference() Failed.");
+			return false;
+		}
+#endif
+	}
+#endif
+
+	// レンダーグラフのリソースの登録。毎フレーム描き直すターゲットは一時リソースにし、
+	// 前のフレームの結果を使うものはインポートにする。作っていないターゲットはそれを使うパスも追加しないので、インポートとして番号だけ取っておく
+	{
+		const auto& addTarget = [this](const char* name, const D3D12_RESOURCE_DESC& desc)
+		{
+			if (desc.Width == 0)
+			{
+				return m_RenderGraph.AddImportedResource(name);
+			}
+
+			const D3D12_RESOURCE_ALLOCATION_INFO& info = m_pDevice->GetResourceAllocationInfo(0, 1, &desc);
+			return m_RenderGraph.AddTransientResource(name, info.SizeInBytes, info.Alignment);
+		};
+
+		m_RenderGraph.AddImportedResource("BackBuffer");
+		m_RenderGraph.AddImportedResource("MeshletCullingResult");
+		m_RenderGraph.AddImportedResource("HZB");
+		m_RenderGraph.AddImportedResource("SSGI_TemporalAccumulation");
+		m_RenderGraph.AddImportedResource("VolumetricFogScattering");
+		m_RenderGraph.AddImportedResource("TemporalAA");
+
+		addTarget("DirLightShadowMap", m_DirLightShadowMapTarget.GetDesc());
+		addTarget("SkyTransmittanceLUT", m_SkyTransmittanceLUT_Target.GetDesc());
+		addTarget("SkyMultiScatteringLUT", m_SkyMultiScatteringLUT_Target.GetDesc());
+		addTarget("SkyViewLUT", m_SkyViewLUT_Target.GetDesc());
+		addTarget("CloudTracing", m_CloudTracingTarget.GetDesc());
+		addTarget("CloudSecondaryTracing", m_CloudSecondaryTracingTarget.GetDesc());
+		addTarget("CloudTracingDepth", m_CloudTracingDepthTarget.GetDesc());
+		addTarget("SceneColor", m_SceneColorTarget.GetDesc());
+		addTarget("GBufferBaseColor", m_GBufferBaseColorTarget.GetDesc());
+		addTarget("GBufferNormal", m_GBufferNormalTarget.GetDesc());
+		addTarget("GBufferMetallicRoughness", m_GBufferMetallicRoughnessTarget.GetDesc());
+		addTarget("GBufferEmissive", m_GBufferEmissiveTarget.GetDesc());
+		addTarget("VBuffer", m_VBufferTarget.GetDesc());
+		addTarget("SceneDepth", m_SceneDepthTarget.GetDesc());
+		addTarget("HCB", m_HCB_Target.GetDesc());
+		addTarget("ObjectVelocity", m_ObjectVelocityTarget.GetDesc());
+		addTarget("Velocity", m_VelocityTarget.GetDesc());
+		addTarget("SSAOSetup", m_SSAOSetupTarget.GetDesc());
+		addTarget("SSAO_HalfRes", m_SSAO_HalfResTarget.GetDesc());
+		addTarget("SSAO_FullRes", m_SSAO_FullResTarget.GetDesc());
+		addTarget("SSGI", m_SSGI_Target.GetDesc());
+		addTarget("SSGI_Denoise", m_SSGI_DenoiseTarget.GetDesc());
+		addTarget("AmbientLight", m_AmbientLightTarget.GetDesc());
+		addTarget("SSR", m_SSR_Target.GetDesc());
+		addTarget("VolumetricFogIntegration", m_VolumetricFogIntegrationTarget.GetDesc());
+		addTarget("VolumetricComposition", m_VolumetricCompositionTarget.GetDesc());
+		addTarget("MotionBlur", m_MotionBlurTarget.GetDesc());
+		for (uint32_t i = 0; i < BLOOM_NUM_DOWN_SAMPLE; i++)
+		{
+			addTarget("BloomSetup", m_BloomSetupTarget[i].GetDesc());
+		}
+		for (uint32_t i = 0; i < BLOOM_NUM_DOWN_SAMPLE; i++)
+		{
+			addTarget("BloomHorizontal", m_BloomHorizontalTarget[i].GetDesc());
+		}
+		for (uint32_t i = 0; i < BLOOM_NUM_DOWN_SAMPLE; i++)
+		{
+			addTarget("BloomVertical", m_BloomVerticalTarget[i].GetDesc());
+		}
+		addTarget("Tonemap", m_TonemapTarget.GetDesc());
+		addTarget("FXAA", m_FXAA_Target.GetDesc());
+
+		if (m_RenderGraph.GetResourceCount() != RG_RESOURCE_COUNT)
+		{
+			ELOG("Error : RenderGraph Resource Count Mismatch. count = %u", m_RenderGraph.GetResourceCount());
+			return false;
+		}
+	}
+
+	// 以前はアップロードごとにコミットしたUPLOADヒープのバッファを持ち続けていたので、起動時のピークはその合計になっていた
+	{
+		const UploadRingStats& stats = m_UploadRing.GetStats();
+		ELOG("UploadRing : %u uploads, %.2f MB. Peak staging memory : committed per upload %.2f MB -> ring %.2f MB (peak used %.2f MB, %u flushes)",
+			stats.UploadCount,
+			stats.UploadSize / (1024.0 * 1024.0),
+			stats.CommittedEquivalentSize / (1024.0 * 1024.0),
+			m_UploadRing.GetCapacity() / (1024.0 * 1024.0),
+			stats.PeakUsedSize / (1024.0 * 1024.0),
+			stats.FlushCount
+		);
+	}
+
+	// 2回目以降の起動では、変わっていないシェーダはコンパイルせずにキャッシュから読み込む
+	{
+		const ShaderCacheStats& stats = m_ShaderCompiler.GetCacheStats();
+		ELOG("ShaderCache : %u hits, %u misses, saved %.1f ms (load %.1f ms)",
+			stats.HitCount,
+			stats.MissCount,
+			stats.SavedMilliseconds,
+			stats.LoadMilliseconds
+		);
+	}
+
+	return true;
+}
+
+// 起動時とシェーダをリロードしたときに呼ぶ。失敗したらrootSigとpPSOは途中までしか作られていない
+bool SampleApp::CreateDeferredShadingPipeline(IDxcBlob* pPSBlob, const wchar_t* psPath, RootSignature& rootSig, ComPtr<ID3D12PipelineState>& pPSO)
+{
+	std::wstring vsPath;
+
+	if (!SearchFilePath(L"QuadVS.cso", vsPath))
+	{
+		ELOG("Error : Vertex Shader Not Found");
+		return false;
+	}
+	ComPtr<ID3DBlob> pVSBlob;
+
+	HRESULT hr = D3DReadFileToBlob(vsPath.c_str(), pVSBlob.GetAddressOf());
+	if (FAILED(hr))
+	{
+		ELOG("Error : D3DReadFileToBlob Failed. path = %ls", vsPath.c_str());
+		return false;
+	}
+
+	ComPtr<ID3DBlob> pRSBlob;
+	hr = D3DGetBlobPart(pPSBlob->GetBufferPointer(), pPSBlob->GetBufferSize(), D3D_BLOB_ROOT_SIGNATURE, 0, &pRSBlob);
+	if (FAILED(hr))
+	{
+		ELOG("Error : D3DGetBlobPart Failed. path = %ls", psPath);
+		return false;
+	}
+
+	if (!rootSig.Init(m_pDevice.Get(), pRSBlob))
+	{
+		ELOG("Error : RootSignature::Init() Failed.");
+		return false;
+	}
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = GetSSPassPSODescCommon();
+	desc.pRootSignature = rootSig.GetPtr();
+	desc.VS.pShaderBytecode = pVSBlob->GetBufferPointer();
+	desc.VS.BytecodeLength = pVSBlob->GetBufferSize();
+	desc.PS.pShaderBytecode = pPSBlob->GetBufferPointer();
+	desc.PS.BytecodeLength = pPSBlob->GetBufferSize();
+	desc.NumRenderTargets = 1;
+	desc.RTVFormats[0] = m_SceneColorTarget.GetRTVDesc().Format;
+
+	hr = m_pDevice->CreateGraphicsPipelineState(
+		&desc,
+		IID_PPV_ARGS(pPSO.GetAddressOf())
+	);
+	if (FAILED(hr))
+	{
+		ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
+		return false;
+	}
+
 	return true;
 }
 
+void SampleApp::ApplyReloadedShaders()
+{
+	std::vector<ReloadedShader> reloadedShaders;
+	m_ShaderHotReloader.TakeReloadedShaders(reloadedShaders);
+
+	for (const ReloadedShader& reloaded : reloadedShaders)
+	{
+		if (reloaded.ShaderIdx != m_DeferredLightingPSReloadIdx)
+		{
+			continue;
+		}
+
+		// 作り直しに失敗したら前のパイプラインステートのまま描画を続ける
+		RootSignature rootSig;
+		ComPtr<ID3D12PipelineState> pPSO;
+		if (!CreateDeferredShadingPipeline(reloaded.pBlob.Get(), L"DeferredLightingPS.hlsl", rootSig, pPSO))
+		{
+			ELOG("Error : SampleApp::CreateDeferredShadingPipeline() Failed.");
+			continue;
+		}
+
+		// 実行中のフレームが前のパイプラインステートを使っているので、GPUの完了を待ってから差し替える
+		m_Fence.Sync(m_pQueue.Get());
+		m_FramePacer.Reset();
+		m_DeferredShadingRootSig = rootSig;
+		m_pDeferredShadingPSO = pPSO;
+		ELOG("Reload Shader. path = DeferredLightingPS.hlsl");
+	}
+}
+
 void SampleApp::OnTerm()
 {
+	// コンパイル中ならその終わりを待つので、ShaderCompilerより先に止める
+	m_ShaderHotReloader.Term();
 	m_ShaderCompiler.Term();
 
+	m_RenderGraph.Term();
+
 	// imgui終了処理
 	if (ImGui::GetCurrentContext() != nullptr)
 	{
@@ -6242,6 +6794,9 @@ void SampleApp::OnTerm()
 
 	for (uint32_t i = 0; i < FRAME_COUNT; i++)
 	{
+		m_CullingCB[i].Term();
+		m_ShadowTransformCB[i].Term();
+		m_SSGI_CB[i].Term();
 		m_DirectionalLightCB[i].Term();
 		m_CameraCB[i].Term();
 		m_DirLightCameraCB[i].Term();
@@ -6249,22 +6804,30 @@ void SampleApp::OnTerm()
 		m_CameraVelocityCB[i].Term();
 		m_SSAO_HalfResCB[i].Term();
 		m_SSAO_FullResCB[i].Term();
+		m_SSR_CB[i].Term();
+		m_VolumetricFogCB[i].Term();
 		m_TemporalAA_CB[i].Term();
+		m_MotionBlurCB[i].Term();
 		m_TonemapCB[i].Term();
+		m_FXAA_CB[i].Term();
+		m_BackBufferCB[i].Term();
 		m_SkyAtmosphereCB[i].Term();
-	}
 
-	m_VolumetricCloudCB.Term();
-	m_ShadowTransformCB.Term();
+		for (uint32_t j = 0u; j < NUM_POINT_LIGHTS; j++)
+		{
+			m_PointLightCB[i][j].Term();
+		}
 
-	for (uint32_t i = 0u; i < NUM_POINT_LIGHTS; i++)
-	{
-		m_PointLightCB[i].Term();
+		for (uint32_t j = 0u; j < NUM_SPOT_LIGHTS; j++)
+		{
+			m_SpotLightCB[i][j].Term();
+		}
 	}
 
+	m_VolumetricCloudCB.Term();
+
 	for (uint32_t i = 0u; i < NUM_SPOT_LIGHTS; i++)
 	{
-		m_SpotLightCB[i].Term();
 		m_SpotLightCameraCB[i].Term();
 	}
 
@@ -6279,14 +6842,8 @@ void SampleApp::OnTerm()
 
 	m_SSAOSetupCB.Term();
 
-	m_SSGI_CB.Term();
-
 	m_SSGI_DenoiseCB.Term();
 
-	m_SSR_CB.Term();
-
-	m_VolumetricFogCB.Term();
-
 	for (uint32_t i = 0; i < BLOOM_NUM_DOWN_SAMPLE - 1; i++)
 	{
 		m_DownsampleCB[i].Term();
@@ -6298,10 +6855,6 @@ void SampleApp::OnTerm()
 		m_BloomVerticalCB[i].Term();
 	}
 
-	m_MotionBlurCB.Term();
-
-	m_BackBufferCB.Term();
-
 	m_IBL_CB.Term();
 
 	for (Model* model : m_pModels)
@@ -6313,15 +6866,6 @@ void SampleApp::OnTerm()
 	}
 	m_pModels.clear();
 
-	for (DescriptorHandle* handle : m_pHZB_ParentMipSRVs)
-	{
-		if (handle != nullptr && m_pPool[POOL_TYPE_RES_GPU_VISIBLE] != nullptr)
-		{
-			m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->FreeHandle(handle);
-		}
-	}
-	m_pHZB_ParentMipSRVs.clear();
-
 	m_DirLightShadowMapTarget.Term();
 
 	for (uint32_t i = 0u; i < NUM_SPOT_LIGHTS; i++)
@@ -6520,6 +7064,9 @@ void SampleApp::OnTerm()
 
 void SampleApp::OnRender()
 {
+	// 別スレッドでコンパイルし直したシェーダは、フレームの記録を始める前に差し替える
+	ApplyReloadedShaders();
+
 	// 共通変数の更新
 	float temporalJitetrPixelsX;
 	float temporalJitetrPixelsY;
@@ -6615,13 +7162,13 @@ void SampleApp::OnRender()
 
 		for (uint32_t i = 0u; i < NUM_POINT_LIGHTS; i++)
 		{
-			CbPointLight* ptr = m_PointLightCB[i].GetPtr<CbPointLight>();
+			CbPointLight* ptr = m_PointLightCB[m_FrameIndex][i].GetPtr<CbPointLight>();
 			ptr->LightIntensity = m_pointLightIntensity;
 		}
 
 		for (uint32_t i = 0u; i < NUM_SPOT_LIGHTS; i++)
 		{
-			CbSpotLight* ptr = m_SpotLightCB[i].GetPtr<CbSpotLight>();
+			CbSpotLight* ptr = m_SpotLightCB[m_FrameIndex][i].GetPtr<CbSpotLight>();
 			ptr->LightIntensity = m_spotLightIntensity;
 		}
 	}
@@ -6629,7 +7176,7 @@ void SampleApp::OnRender()
 	// シャドウ定数バッファの更新
 	if (m_drawSponza)
 	{
-		CbShadowTransform* ptr = m_ShadowTransformCB.GetPtr<CbShadowTransform>();
+		CbShadowTransform* ptr = m_ShadowTransformCB[m_FrameIndex].GetPtr<CbShadowTransform>();
 		// ViewProjはDrawVBuffer()で更新済み
 
 		float zNear = 0.0f;
@@ -6719,173 +7266,294 @@ void SampleApp::OnRender()
 	};
 
 	pCmd->SetDescriptorHeaps(1, pHeaps);
-	
+
+	const ColorTarget& SSGI_PrevTarget = m_SSGI_TemporalAccumulationTarget[m_FrameIndex];
+	const ColorTarget& SSGI_CurTarget = m_SSGI_TemporalAccumulationTarget[(m_FrameIndex + 1) % FRAME_COUNT]; // FRAME_COUNT=2前提だとm_FrameIndex ^ 1でも可能
+
+	const ColorTarget& volumetricFogScatteringPrevTarget = m_VolumetricFogScatteringTarget[m_FrameIndex];
+	const ColorTarget& volumetricFogScatteringCurTarget = m_VolumetricFogScatteringTarget[(m_FrameIndex + 1) % FRAME_COUNT]; // FRAME_COUNT=2前提だとm_FrameIndex ^ 1でも可能
+
+	const Matrix& projNoJitterForVolumetricFog = Matrix::CreatePerspectiveFieldOfView(fovY, aspect, VOLUMETRIC_FOG_FROXEL_NEAR, VOLUMETRIC_FOG_FROXEL_FAR);
+	const Matrix& viewProjNoJitterForVolumetricFog = view * projNoJitterForVolumetricFog; // 行ベクトル形式の順序で乗算するのがXMMatrixMultiply()
+	const Matrix& viewRotProjNoJitterForVolumetricFog = viewRot * projNoJitterForVolumetricFog;
+
+	const ColorTarget& temporalAA_PrevTarget = m_TemporalAA_Target[m_FrameIndex];
+	const ColorTarget& temporalAA_CurTarget = m_TemporalAA_Target[(m_FrameIndex + 1) % FRAME_COUNT]; // FRAME_COUNT=2前提だとm_FrameIndex ^ 1でも可能
+
+	// パスは実行する順に、読み書きするリソースと合わせて毎フレーム追加し直す。
+	// 出力がバックバッファにも次のフレームにも届かないパスはCompile()で除かれ、Execute()で実行されない
+	m_RenderGraph.ResetPasses();
+
 	if (m_usePathTracing)
 	{
-		DoPathTracing(static_cast<ID3D12GraphicsCommandList4*>(pCmd));
+		m_RenderGraph.AddPass("PathTracing", {}, {RG_GBUFFER_BASE_COLOR, RG_GBUFFER_NORMAL, RG_GBUFFER_METALLIC_ROUGHNESS, RG_GBUFFER_EMISSIVE, RG_VBUFFER}, [&]()
+		{
+			DoPathTracing(static_cast<ID3D12GraphicsCommandList4*>(pCmd));
+		});
 
 		// DepthはVBufferに書くのでそこからコピーする
-		DrawDepthBufferFromVBuffer(pCmd);
+		m_RenderGraph.AddPass("DepthBufferFromVBuffer", {RG_VBUFFER}, {RG_SCENE_DEPTH}, [&]()
+		{
+			DrawDepthBufferFromVBuffer(pCmd);
+		});
 
-		DoDeferredShading(pCmd, lightForward);
+		m_RenderGraph.AddPass("DeferredShading", {RG_GBUFFER_BASE_COLOR, RG_GBUFFER_NORMAL, RG_GBUFFER_METALLIC_ROUGHNESS, RG_GBUFFER_EMISSIVE, RG_SCENE_DEPTH, RG_DIR_LIGHT_SHADOW_MAP}, {RG_SCENE_COLOR}, [&]()
+		{
+			DoDeferredShading(pCmd, lightForward);
+		});
 	}
 	else
 	{
 		if (m_drawSponza)
 		{
-			DrawDirectionalLightShadowMap(pCmd, lightForward);
+			m_RenderGraph.AddPass("DirectionalLightShadowMap", {}, {RG_DIR_LIGHT_SHADOW_MAP}, [&]()
+			{
+				DrawDirectionalLightShadowMap(pCmd, lightForward);
+			});
 
-			DrawSkyTransmittanceLUT(pCmd);
-			DrawSkyMultiScatteringLUT(pCmd);
-			DrawSkyViewLUT(pCmd, skyViewLutReferential, lightForward);
+			m_RenderGraph.AddPass("SkyTransmittanceLUT", {}, {RG_SKY_TRANSMITTANCE_LUT}, [&]()
+			{
+				DrawSkyTransmittanceLUT(pCmd);
+			});
+			m_RenderGraph.AddPass("SkyMultiScatteringLUT", {RG_SKY_TRANSMITTANCE_LUT}, {RG_SKY_MULTI_SCATTERING_LUT}, [&]()
+			{
+				DrawSkyMultiScatteringLUT(pCmd);
+			});
+			m_RenderGraph.AddPass("SkyViewLUT", {RG_SKY_TRANSMITTANCE_LUT, RG_SKY_MULTI_SCATTERING_LUT}, {RG_SKY_VIEW_LUT}, [&]()
+			{
+				DrawSkyViewLUT(pCmd, skyViewLutReferential, lightForward);
+			});
 
-			DrawVolumetricCloud(pCmd);
+			// 雲のトレース結果はまだどのパスも読まないので除かれる
+			m_RenderGraph.AddPass("VolumetricCloud", {}, {RG_CLOUD_TRACING, RG_CLOUD_SECONDARY_TRACING, RG_CLOUD_TRACING_DEPTH}, [&]()
+			{
+				DrawVolumetricCloud(pCmd);
+			});
 		}
 
 		if (m_useMeshlet)
 		{
-			DoMeshletCulling(pCmd);
-		}
+			// オクルージョンカリングには前のフレームのHZBを使う
+			m_RenderGraph.AddPass("MeshletCulling", {RG_HZB}, {RG_MESHLET_CULLING_RESULT}, [&]()
+			{
+				DoMeshletCulling(pCmd);
+			});
 
-		if (m_useMeshlet)
-		{
-			DrawVBuffer(pCmd);
+			m_RenderGraph.AddPass("VBuffer", {RG_MESHLET_CULLING_RESULT}, {RG_VBUFFER, RG_SCENE_DEPTH}, [&]()
+			{
+				DrawVBuffer(pCmd);
+			});
 
 			if (m_useSWRasterizer)
 			{
-				DrawDepthBufferFromVBuffer(pCmd);
+				m_RenderGraph.AddPass("DepthBufferFromVBuffer", {RG_VBUFFER}, {RG_SCENE_DEPTH}, [&]()
+				{
+					DrawDepthBufferFromVBuffer(pCmd);
+				});
 			}
 
-			DrawGBufferFromVBuffer(pCmd);
-			DoDeferredShading(pCmd, lightForward);
+			m_RenderGraph.AddPass("GBufferFromVBuffer", {RG_VBUFFER}, {RG_GBUFFER_BASE_COLOR, RG_GBUFFER_NORMAL, RG_GBUFFER_METALLIC_ROUGHNESS, RG_GBUFFER_EMISSIVE}, [&]()
+			{
+				DrawGBufferFromVBuffer(pCmd);
+			});
 		}
 		else
 		{
-			DrawGBuffer(pCmd);
-			DoDeferredShading(pCmd, lightForward);
+			m_RenderGraph.AddPass("GBuffer", {}, {RG_GBUFFER_BASE_COLOR, RG_GBUFFER_NORMAL, RG_GBUFFER_METALLIC_ROUGHNESS, RG_GBUFFER_EMISSIVE, RG_SCENE_DEPTH}, [&]()
+			{
+				DrawGBuffer(pCmd);
+			});
 		}
+
+		m_RenderGraph.AddPass("DeferredShading", {RG_GBUFFER_BASE_COLOR, RG_GBUFFER_NORMAL, RG_GBUFFER_METALLIC_ROUGHNESS, RG_GBUFFER_EMISSIVE, RG_SCENE_DEPTH, RG_DIR_LIGHT_SHADOW_MAP}, {RG_SCENE_COLOR}, [&]()
+		{
+			DoDeferredShading(pCmd, lightForward);
+		});
 	}
 
-	DrawSkyBox(pCmd, lightForward, viewRotProjWithJitter, view, projWithJitter, skyViewLutReferential);
+	// シェーディング結果に重ねて描く
+	m_RenderGraph.AddPass("SkyBox",
+		{RG_SKY_TRANSMITTANCE_LUT, RG_SKY_VIEW_LUT, RG_SCENE_COLOR, RG_GBUFFER_NORMAL, RG_GBUFFER_METALLIC_ROUGHNESS, RG_SCENE_DEPTH},
+		{RG_SCENE_COLOR, RG_GBUFFER_NORMAL, RG_GBUFFER_METALLIC_ROUGHNESS, RG_SCENE_DEPTH},
+		[&]()
+		{
+			DrawSkyBox(pCmd, lightForward, viewRotProjWithJitter, view, projWithJitter, skyViewLutReferential);
+		}
+	);
 
-	DrawHCB(pCmd);
+	m_RenderGraph.AddPass("HCB", {RG_SCENE_COLOR}, {RG_HCB}, [&]()
+	{
+		DrawHCB(pCmd);
+	});
 
-	DrawHZB(pCmd);
+	m_RenderGraph.AddPass("HZB", {RG_SCENE_DEPTH}, {RG_HZB}, [&]()
+	{
+		DrawHZB(pCmd);
+	});
 
 	if (m_enableVelocity)
+	{
+		m_RenderGraph.AddPass("ObjectVelocity", {RG_SCENE_DEPTH}, {RG_OBJECT_VELOCITY}, [&]()
+		{
+			if (isEnableTemporalAA())
+			{
+				DrawObjectVelocity(pCmd, worldForMovable, m_PrevWorldForMovable, viewProjWithJitter, viewProjNoJitter, m_PrevViewProjNoJitter);
+			}
+			else
+			{
+				DrawObjectVelocity(pCmd, worldForMovable, m_PrevWorldForMovable, viewProjNoJitter, viewProjNoJitter, m_PrevViewProjNoJitter);
+			}
+		});
+
+		m_RenderGraph.AddPass("CameraVelocity", {RG_OBJECT_VELOCITY, RG_SCENE_DEPTH}, {RG_VELOCITY}, [&]()
+		{
+			DrawCameraVelocity(pCmd, viewProjNoJitter);
+		});
+	}
+
+	m_RenderGraph.AddPass("SSAOSetup", {RG_SCENE_DEPTH, RG_GBUFFER_NORMAL}, {RG_SSAO_SETUP}, [&]()
+	{
+		DrawSSAOSetup(pCmd);
+	});
+
+	m_RenderGraph.AddPass("SSAO", {RG_SCENE_DEPTH, RG_GBUFFER_NORMAL, RG_SSAO_SETUP}, {RG_SSAO_HALF_RES, RG_SSAO_FULL_RES}, [&]()
 	{
 		if (isEnableTemporalAA())
 		{
-			DrawObjectVelocity(pCmd, worldForMovable, m_PrevWorldForMovable, viewProjWithJitter, viewProjNoJitter, m_PrevViewProjNoJitter);
+			DrawSSAO(pCmd, projWithJitter);
 		}
 		else
 		{
-			DrawObjectVelocity(pCmd, worldForMovable, m_PrevWorldForMovable, viewProjNoJitter, viewProjNoJitter, m_PrevViewProjNoJitter);
+			DrawSSAO(pCmd, projNoJitter);
 		}
+	});
 
-		DrawCameraVelocity(pCmd, viewProjNoJitter);
-	}
-
-	DrawSSAOSetup(pCmd);
-
-	if (isEnableTemporalAA())
-	{
-		DrawSSAO(pCmd, projWithJitter);
-	}
-	else
+	m_RenderGraph.AddPass("SSGI", {RG_HCB, RG_HZB, RG_GBUFFER_NORMAL}, {RG_SSGI}, [&]()
 	{
-		DrawSSAO(pCmd, projNoJitter);
-	}
+		if (isEnableTemporalAA())
+		{
+			DrawSSGI(pCmd, projWithJitter, viewProjWithJitter);
+		}
+		else
+		{
+			DrawSSGI(pCmd, projNoJitter, viewProjNoJitter);
+		}
+	});
 
-	if (isEnableTemporalAA())
+	m_RenderGraph.AddPass("SSGI_Denoise", {RG_SSGI}, {RG_SSGI_DENOISE}, [&]()
 	{
-		DrawSSGI(pCmd, projWithJitter, viewProjWithJitter);
-	}
-	else
-	{
-		DrawSSGI(pCmd, projNoJitter, viewProjNoJitter);
-	}
-
-	DrawSSGI_Denoise(pCmd);
-
-	const ColorTarget& SSGI_PrevTarget = m_SSGI_TemporalAccumulationTarget[m_FrameIndex];
-	const ColorTarget& SSGI_CurTarget = m_SSGI_TemporalAccumulationTarget[(m_FrameIndex + 1) % FRAME_COUNT]; // FRAME_COUNT=2前提だとm_FrameIndex ^ 1でも可能
-
-	DrawSSGI_TemporalAccumulation(pCmd, SSGI_PrevTarget, SSGI_CurTarget);
+		DrawSSGI_Denoise(pCmd);
+	});
 
-	DrawAmbientLight(pCmd, SSGI_CurTarget);
+	m_RenderGraph.AddPass("SSGI_TemporalAccumulation", {RG_SSGI_DENOISE, RG_SSGI_HISTORY, RG_VELOCITY}, {RG_SSGI_HISTORY}, [&]()
+	{
+		DrawSSGI_TemporalAccumulation(pCmd, SSGI_PrevTarget, SSGI_CurTarget);
+	});
 
-	if (isEnableTemporalAA())
+	m_RenderGraph.AddPass("AmbientLight", {RG_SSGI_HISTORY, RG_SSAO_FULL_RES, RG_SCENE_COLOR}, {RG_AMBIENT_LIGHT}, [&]()
 	{
-		DrawSSR(pCmd, projWithJitter, viewRotProjWithJitter);
-	}
-	else
+		DrawAmbientLight(pCmd, SSGI_CurTarget);
+	});
+
+	m_RenderGraph.AddPass("SSR", {RG_AMBIENT_LIGHT, RG_GBUFFER_METALLIC_ROUGHNESS, RG_GBUFFER_NORMAL, RG_HZB, RG_SCENE_DEPTH}, {RG_SSR}, [&]()
 	{
-		DrawSSR(pCmd, projNoJitter, viewRotProjNoJitter);
-	}
+		if (isEnableTemporalAA())
+		{
+			DrawSSR(pCmd, projWithJitter, viewRotProjWithJitter);
+		}
+		else
+		{
+			DrawSSR(pCmd, projNoJitter, viewRotProjNoJitter);
+		}
+	});
 
 	if (m_drawSponza)
 	{
-		const ColorTarget& volumetricFogScatteringPrevTarget = m_VolumetricFogScatteringTarget[m_FrameIndex];
-		const ColorTarget& volumetricFogScatteringCurTarget = m_VolumetricFogScatteringTarget[(m_FrameIndex + 1) % FRAME_COUNT]; // FRAME_COUNT=2前提だとm_FrameIndex ^ 1でも可能
+		m_RenderGraph.AddPass("VolumetricFogScattering", {RG_DIR_LIGHT_SHADOW_MAP, RG_VOLUMETRIC_FOG_HISTORY}, {RG_VOLUMETRIC_FOG_HISTORY}, [&]()
+		{
+			DrawVolumetricFogScattering
+			(
+				pCmd,
+				viewRotProjNoJitterForVolumetricFog,
+				viewProjNoJitterForVolumetricFog,
+				m_PrevViewProjNoJitterForVolumetricFog,
+				volumetricFogScatteringPrevTarget,
+				volumetricFogScatteringCurTarget
+			);
 
-		Matrix projNoJitterForVolumetricFog = Matrix::CreatePerspectiveFieldOfView(fovY, aspect, VOLUMETRIC_FOG_FROXEL_NEAR, VOLUMETRIC_FOG_FROXEL_FAR);
-		Matrix viewProjNoJitterForVolumetricFog = view * projNoJitterForVolumetricFog; // 行ベクトル形式の順序で乗算するのがXMMatrixMultiply()
-		Matrix viewRotProjNoJitterForVolumetricFog = viewRot * projNoJitterForVolumetricFog;
+			m_PrevViewProjNoJitterForVolumetricFog = viewProjNoJitterForVolumetricFog;
+		});
 
-		DrawVolumetricFogScattering
-		(
-			pCmd,
-			viewRotProjNoJitterForVolumetricFog,
-			viewProjNoJitterForVolumetricFog,
-			m_PrevViewProjNoJitterForVolumetricFog,
-			volumetricFogScatteringPrevTarget,
-			volumetricFogScatteringCurTarget
-		);
-		DrawVolumetricFogIntegration(pCmd, volumetricFogScatteringCurTarget);
-		DrawVolumetricFogComposition(pCmd);
+		m_RenderGraph.AddPass("VolumetricFogIntegration", {RG_VOLUMETRIC_FOG_HISTORY}, {RG_VOLUMETRIC_FOG_INTEGRATION}, [&]()
+		{
+			DrawVolumetricFogIntegration(pCmd, volumetricFogScatteringCurTarget);
+		});
 
-		m_PrevViewProjNoJitterForVolumetricFog = viewProjNoJitterForVolumetricFog;
+		m_RenderGraph.AddPass("VolumetricFogComposition", {RG_SSR, RG_SCENE_DEPTH, RG_VOLUMETRIC_FOG_INTEGRATION}, {RG_VOLUMETRIC_COMPOSITION}, [&]()
+		{
+			DrawVolumetricFogComposition(pCmd);
+		});
 	}
 
-	const ColorTarget& temporalAA_PrevTarget = m_TemporalAA_Target[m_FrameIndex];
-	const ColorTarget& temporalAA_CurTarget = m_TemporalAA_Target[(m_FrameIndex + 1) % FRAME_COUNT]; // FRAME_COUNT=2前提だとm_FrameIndex ^ 1でも可能
-
-	DrawTemporalAA(pCmd, temporalJitetrPixelsX, temporalJitetrPixelsY, temporalAA_PrevTarget, temporalAA_CurTarget);
-
-	DrawMotionBlur(pCmd, temporalAA_CurTarget);
+	// Sponzaのときはフォグを合成した結果、それ以外はSSRの結果を入力にする
+	m_RenderGraph.AddPass("TemporalAA", {m_drawSponza ? RG_VOLUMETRIC_COMPOSITION : RG_SSR, RG_TEMPORAL_AA_HISTORY, RG_VELOCITY}, {RG_TEMPORAL_AA_HISTORY}, [&]()
+	{
+		DrawTemporalAA(pCmd, temporalJitetrPixelsX, temporalJitetrPixelsY, temporalAA_PrevTarget, temporalAA_CurTarget);
+	});
 
-	DrawBloomSetup(pCmd);
+	m_RenderGraph.AddPass("MotionBlur", {RG_TEMPORAL_AA_HISTORY, RG_VELOCITY}, {RG_MOTION_BLUR}, [&]()
+	{
+		DrawMotionBlur(pCmd, temporalAA_CurTarget);
+	});
 
+	m_RenderGraph.AddPass("BloomSetup", {RG_MOTION_BLUR}, {RG_BLOOM_SETUP}, [&]()
 	{
-		::PIXScopedEvent(pCmd, 0, L"Downsample");
+		DrawBloomSetup(pCmd);
+	});
 
-		for (uint32_t i = 0; i < BLOOM_NUM_DOWN_SAMPLE - 1; i++)
+	for (uint32_t i = 0; i < BLOOM_NUM_DOWN_SAMPLE - 1; i++)
+	{
+		m_RenderGraph.AddPass("Downsample", {RG_BLOOM_SETUP + i}, {RG_BLOOM_SETUP + i + 1}, [&, i]()
 		{
+			::PIXScopedEvent(pCmd, 0, L"Downsample");
+
 			DrawDownsample(pCmd, m_BloomSetupTarget[i], m_BloomSetupTarget[i + 1], i);
-		}
+		});
 	}
 
+	for (int32_t i = BLOOM_NUM_DOWN_SAMPLE - 1; i >= 0; i--) // 解像度の小さい方から重ねていくので降順
 	{
-		::PIXScopedEvent(pCmd, 0, L"BloomGaussianFilter");
-
-		for (int32_t i = BLOOM_NUM_DOWN_SAMPLE - 1; i >= 0; i--) // 解像度の小さい方から重ねていくので降順
+		const uint32_t level = static_cast<uint32_t>(i);
+		if (i == (BLOOM_NUM_DOWN_SAMPLE - 1))
 		{
-			if (i == (BLOOM_NUM_DOWN_SAMPLE - 1))
+			// m_SceneColorTargetをDownerResultColorとして使っているのはダミー
+			m_RenderGraph.AddPass("BloomGaussianFilter", {RG_BLOOM_SETUP + level, RG_SCENE_COLOR}, {RG_BLOOM_HORIZONTAL + level, RG_BLOOM_VERTICAL + level}, [&, i]()
 			{
-				// m_SceneColorTargetをDownerResultColorとして使っているのはダミー
+				::PIXScopedEvent(pCmd, 0, L"BloomGaussianFilter");
+
 				DrawFilter(pCmd, m_BloomSetupTarget[i], m_BloomHorizontalTarget[i], m_BloomVerticalTarget[i], m_SceneColorTarget, m_BloomHorizontalCB[i], m_BloomVerticalCB[i]);
-			}
-			else
+			});
+		}
+		else
+		{
+			m_RenderGraph.AddPass("BloomGaussianFilter", {RG_BLOOM_SETUP + level, RG_BLOOM_VERTICAL + level + 1}, {RG_BLOOM_HORIZONTAL + level, RG_BLOOM_VERTICAL + level}, [&, i]()
 			{
+				::PIXScopedEvent(pCmd, 0, L"BloomGaussianFilter");
+
 				DrawFilter(pCmd, m_BloomSetupTarget[i], m_BloomHorizontalTarget[i], m_BloomVerticalTarget[i], m_BloomVerticalTarget[i + 1], m_BloomHorizontalCB[i], m_BloomVerticalCB[i]);
-			}
+			});
 		}
 	}
 
-	DrawTonemap(pCmd);
+	m_RenderGraph.AddPass("Tonemap", {RG_MOTION_BLUR, RG_BLOOM_VERTICAL}, {RG_TONEMAP}, [&]()
+	{
+		DrawTonemap(pCmd);
+	});
 
-	DrawFXAA(pCmd);
+	m_RenderGraph.AddPass("FXAA", {RG_TONEMAP}, {RG_FXAA}, [&]()
+	{
+		DrawFXAA(pCmd);
+	});
 
 	if (m_useMeshlet)
 	{
@@ -6894,12 +7562,21 @@ void SampleApp::OnRender()
 			using enum DEBUG_VIEW_MODE;
 			case TRIANGLE_INDEX:
 			case MESHLET_INDEX:
-				DrawDebugVBuffer(pCmd);
+				m_RenderGraph.AddPass("DebugVBuffer", {RG_VBUFFER, RG_FXAA}, {RG_FXAA}, [&]()
+				{
+					DrawDebugVBuffer(pCmd);
+				});
 				break;
 			case MESHLET_AABB:
 				// AABBのときはMeshletIdxも同時に表示する
-				DrawDebugVBuffer(pCmd);
-				DrawMeshletAABB(pCmd);
+				m_RenderGraph.AddPass("DebugVBuffer", {RG_VBUFFER, RG_FXAA}, {RG_FXAA}, [&]()
+				{
+					DrawDebugVBuffer(pCmd);
+				});
+				m_RenderGraph.AddPass("MeshletAABB", {RG_FXAA, RG_SCENE_DEPTH}, {RG_FXAA, RG_SCENE_DEPTH}, [&]()
+				{
+					DrawMeshletAABB(pCmd);
+				});
 				break;
 			case NONE:
 			case DEPTH:
@@ -6920,12 +7597,117 @@ void SampleApp::OnRender()
 		}
 	}
 
-	DrawBackBuffer(pCmd);
+	// デバッグ表示では表示するターゲットだけを読むので、ポストプロセスは除かれる
+	uint32_t backBufferSource = RG_FXAA;
+	switch (m_debugViewMode)
+	{
+		using enum DEBUG_VIEW_MODE;
+		case NONE:
+		case MESHLET_INDEX:
+		case MESHLET_AABB:
+			backBufferSource = RG_FXAA;
+			break;
+		case DEPTH:
+			backBufferSource = RG_SCENE_DEPTH;
+			break;
+		case BASECOLOR:
+		case TEXCOORD:
+			backBufferSource = RG_GBUFFER_BASE_COLOR;
+			break;
+		case NORMAL:
+			backBufferSource = RG_GBUFFER_NORMAL;
+			break;
+		case METALLIC_ROUGHNESS:
+			backBufferSource = RG_GBUFFER_METALLIC_ROUGHNESS;
+			break;
+		case EMISSIVE:
+			backBufferSource = RG_GBUFFER_EMISSIVE;
+			break;
+		case SSAO_FULL_RES:
+			backBufferSource = RG_SSAO_FULL_RES;
+			break;
+		case SSAO_HALF_RES:
+			backBufferSource = RG_SSAO_HALF_RES;
+			break;
+		case SSGI:
+			backBufferSource = RG_SSGI_DENOISE;
+			break;
+		case VELOCITY:
+			backBufferSource = RG_VELOCITY;
+			break;
+		case TRIANGLE_INDEX:
+			backBufferSource = m_useMeshlet ? RG_FXAA : RG_SCENE_COLOR;
+			break;
+		default:
+			assert(false);
+			break;
+	}
+
+	m_RenderGraph.AddPass("BackBuffer", {backBufferSource}, {RG_BACK_BUFFER}, [&]()
+	{
+		DrawBackBuffer(pCmd);
+	});
+
+	m_RenderGraph.AddPass("ImGui", {RG_BACK_BUFFER}, {RG_BACK_BUFFER}, [&]()
+	{
+		DrawImGui(pCmd);
+	});
+
+	m_RenderGraph.Compile();
+
+	// パスの組み合わせが変わったときだけ、一時ターゲットを寿命で共有した場合の配置を計画し直し、
+	// 除いたパスとメモリ量をログに出す。ターゲットはコミットされたリソースのままなので、共有した量は見積もりになる
+	{
+		const RenderGraphStats& stats = m_RenderGraph.GetStats();
+		if (stats.PassCount != m_RenderGraphStats.PassCount || stats.CulledPassCount != m_RenderGraphStats.CulledPassCount || stats.TransientSize != m_RenderGraphStats.TransientSize)
+		{
+			m_AliasingPlanner.Reset();
+			for (uint32_t i = 0; i < m_RenderGraph.GetResourceCount(); i++)
+			{
+				if (m_RenderGraph.GetFirstPass(i) != RenderGraph::INVALID_INDEX)
+				{
+					m_AliasingPlanner.AddResource(m_RenderGraph.GetSize(i), m_RenderGraph.GetAlignment(i), m_RenderGraph.GetFirstPass(i), m_RenderGraph.GetLastPass(i));
+				}
+			}
+			m_AliasingPlanner.Plan();
+
+			const AliasingPlanStats& planStats = m_AliasingPlanner.GetStats();
+			ELOG("RenderGraph : %u passes (%u culled). Transient targets : all %.2f MB, used %u targets %.2f MB, estimated %.2f MB if aliased in %u slots",
+				stats.PassCount,
+				stats.CulledPassCount,
+				stats.DeclaredSize / (1024.0 * 1024.0),
+				stats.TransientResourceCount,
+				stats.TransientSize / (1024.0 * 1024.0),
+				planStats.AliasedSize / (1024.0 * 1024.0),
+				planStats.SlotCount
+			);
+			m_RenderGraphStats = stats;
+		}
+	}
+
+	m_RenderGraph.Execute();
+
+	// 終えていない分割バリアとパスの終わりに戻した遷移を発行し、トラッカーを次のフレームに備えて空にする
+	m_StateTracker.Finish(pCmd);
 
-	DrawImGui(pCmd);
+	// バリアの数が変わったときだけログに出す
+	{
+		const ResourceStateTrackerStats& stats = m_StateTracker.GetLastFrameStats();
+		if (stats.RequestedCount != m_StateTrackerStats.RequestedCount || stats.IssuedCount != m_StateTrackerStats.IssuedCount || stats.FlushCount != m_StateTrackerStats.FlushCount)
+		{
+			ELOG("ResourceStateTracker : %u barriers requested -> %u issued in %u ResourceBarrier() calls (%u split)",
+				stats.RequestedCount,
+				stats.IssuedCount,
+				stats.FlushCount,
+				stats.SplitCount
+			);
+			m_StateTrackerStats = stats;
+		}
+	}
 
 	pCmd->Close();
 
+	m_UploadRing.Submit();
 	ID3D12CommandList* pLists[] = {pCmd};
 	m_pQueue->ExecuteCommandLists(1, pLists);
 
@@ -6957,7 +7739,8 @@ void SampleApp::DrawDirectionalLightShadowMap(ID3D12GraphicsCommandList* pCmdLis
 		ptr->ViewProj = view * proj; // 行ベクトル形式の順序で乗算するのがXMMatrixMultiply()
 	}
 
-	DirectX::TransitionResource(pCmdList, m_DirLightShadowMapTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Transition(m_DirLightShadowMapTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleDSV = m_DirLightShadowMapTarget.GetHandleDSV();
 
@@ -6988,7 +7771,8 @@ void SampleApp::DrawDirectionalLightShadowMap(ID3D12GraphicsCommandList* pCmdLis
 	pCmdList->SetPipelineState(m_pDepthMaskPSO.Get());
 	DrawDepthBuffer(pCmdList, ALPHA_MODE::ALPHA_MODE_MASK);
 
-	DirectX::TransitionResource(pCmdList, m_DirLightShadowMapTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	// 読むのはDoDeferredShading()なので、間の空やVBufferのパスの分だけGPUが遷移を先に進められるように分割バリアにする
+	m_StateTracker.BeginSplitTransition(m_DirLightShadowMapTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawSpotLightShadowMap(ID3D12GraphicsCommandList* pCmdList, uint32_t spotLightIdx)
@@ -7022,7 +7806,8 @@ void SampleApp::DrawSkyTransmittanceLUT(ID3D12GraphicsCommandList* pCmdList)
 {
 	::PIXScopedEvent(pCmdList, 0, L"SkyTransmittanceLUT");
 
-	DirectX::TransitionResource(pCmdList, m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_SkyTransmittanceLUT_RootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pSkyTransmittanceLUT_PSO.Get());
@@ -7039,17 +7824,18 @@ void SampleApp::DrawSkyTransmittanceLUT(ID3D12GraphicsCommandList* pCmdList)
 	UINT NumGroupZ = 1;
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	m_SkyTransmittanceLUT_Target.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(m_SkyTransmittanceLUT_Target.GetResource());
 
-	DirectX::TransitionResource(pCmdList, m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawSkyMultiScatteringLUT(ID3D12GraphicsCommandList* pCmdList)
 {
 	::PIXScopedEvent(pCmdList, 0, L"SkyMultiScatteringLUT");
 
-	DirectX::TransitionResource(pCmdList, m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SkyMultiScatteringLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SkyMultiScatteringLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_SkyMultiScatteringLUT_RootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pSkyMultiScatteringLUT_PSO.Get());
@@ -7067,10 +7853,10 @@ void SampleApp::DrawSkyMultiScatteringLUT(ID3D12GraphicsCommandList* pCmdList)
 	UINT NumGroupZ = 1;
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	m_SkyMultiScatteringLUT_Target.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(m_SkyMultiScatteringLUT_Target.GetResource());
 
-	DirectX::TransitionResource(pCmdList, m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SkyMultiScatteringLUT_Target.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SkyMultiScatteringLUT_Target.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawSkyViewLUT(ID3D12GraphicsCommandList* pCmdList, const Matrix& skyViewLutReferential, const Vector3& dirLightDir)
@@ -7081,9 +7867,10 @@ void SampleApp::DrawSkyViewLUT(ID3D12GraphicsCommandList* pCmdList, const Matrix
 	ptr->SkyViewLutReferential = skyViewLutReferential;
 	ptr->AtmosphereLightDirection = -dirLightDir;
 
-	DirectX::TransitionResource(pCmdList, m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SkyMultiScatteringLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SkyViewLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SkyMultiScatteringLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SkyViewLUT_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_SkyViewLUT_RootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pSkyViewLUT_PSO.Get());
@@ -7103,20 +7890,21 @@ void SampleApp::DrawSkyViewLUT(ID3D12GraphicsCommandList* pCmdList, const Matrix
 	UINT NumGroupZ = 1;
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	m_SkyViewLUT_Target.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(m_SkyViewLUT_Target.GetResource());
 
-	DirectX::TransitionResource(pCmdList, m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SkyMultiScatteringLUT_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SkyViewLUT_Target.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SkyTransmittanceLUT_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SkyMultiScatteringLUT_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SkyViewLUT_Target.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawVolumetricCloud(ID3D12GraphicsCommandList* pCmdList)
 {
 	::PIXScopedEvent(pCmdList, 0, L"VolumetricCloud");
 
-	DirectX::TransitionResource(pCmdList, m_CloudTracingTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	DirectX::TransitionResource(pCmdList, m_CloudSecondaryTracingTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	DirectX::TransitionResource(pCmdList, m_CloudTracingDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_CloudTracingTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_CloudSecondaryTracingTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_CloudTracingDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_VolumetricCloudRootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pVolumetricCloudPSO.Get());
@@ -7141,13 +7929,13 @@ void SampleApp::DrawVolumetricCloud(ID3D12GraphicsCommandList* pCmdList)
 	UINT NumGroupZ = 1;
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	m_CloudTracingTarget.BarrierUAV(pCmdList);
-	m_CloudSecondaryTracingTarget.BarrierUAV(pCmdList);
-	m_CloudTracingDepthTarget.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(m_CloudTracingTarget.GetResource());
+	m_StateTracker.UAVBarrier(m_CloudSecondaryTracingTarget.GetResource());
+	m_StateTracker.UAVBarrier(m_CloudTracingDepthTarget.GetResource());
 
-	DirectX::TransitionResource(pCmdList, m_CloudTracingTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_CloudSecondaryTracingTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_CloudTracingDepthTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_CloudTracingTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_CloudSecondaryTracingTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_CloudTracingDepthTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DoMeshletCulling(ID3D12GraphicsCommandList* pCmdList)
@@ -7163,33 +7951,34 @@ void SampleApp::DoMeshletCulling(ID3D12GraphicsCommandList* pCmdList)
 
 	// 定数バッファの更新
 	{
-		CbCulling* ptrCulling = m_CullingCB.GetPtr<CbCulling>();
+		CbCulling* ptrCulling = m_CullingCB[m_FrameIndex].GetPtr<CbCulling>();
 		ptrCulling->bEnableFrustumCulling = m_enableFrustomCulling ? 1 : 0;
 		ptrCulling->bEnableOcclusionCulling = m_enableOcclusionCulling ? 1 : 0;
 		ptrCulling->bEnableBackFaceCulling = m_enableBackFaceCulling ? 1 : 0;
 	}
 
+	// 前のパスで要求された遷移を発行しておく
+	m_StateTracker.Flush(pCmdList);
+
 	// DispatchIndirectArg、VisibleMeshletListクリア
 	{
 		uint32_t clearValue[4] = {0, 0, 0, 0};
 		// 本来はX=0、Y=1、Z=1にしたいが、ClearUavWithUintValue()とByteAddressBufferではそれができないようだ。[0]の値ですべてクリアされてしまう。よってY=1、Z=1はシェーダで入れる。
 		m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().ClearUavWithUintValue(pCmdList, clearValue);
 		m_MeshManager.GetDrawOpaqueMeshletIndicesBB().ClearUavWithUintValue(pCmdList, clearValue);
-
-		m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().BarrierUAV(pCmdList);
-		m_MeshManager.GetDrawOpaqueMeshletIndicesBB().BarrierUAV(pCmdList);
-
 		m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().ClearUavWithUintValue(pCmdList, clearValue);
 		m_MeshManager.GetDrawMaskedMeshletIndicesBB().ClearUavWithUintValue(pCmdList, clearValue);
-
-		m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().BarrierUAV(pCmdList);
-		m_MeshManager.GetDrawMaskedMeshletIndicesBB().BarrierUAV(pCmdList);
-
 		m_MeshManager.GetDrawMovableMeshletIndirectArgBB().ClearUavWithUintValue(pCmdList, clearValue);
 		m_MeshManager.GetDrawMovableMeshletIndicesBB().ClearUavWithUintValue(pCmdList, clearValue);
 
-		m_MeshManager.GetDrawMovableMeshletIndirectArgBB().BarrierUAV(pCmdList);
-		m_MeshManager.GetDrawMovableMeshletIndicesBB().BarrierUAV(pCmdList);
+		// 別々のバッファのクリアは互いに待たなくてよいので、UAVバリアはカリングの前にまとめて発行する
+		m_StateTracker.UAVBarrier(m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource());
+		m_StateTracker.UAVBarrier(m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource());
+		m_StateTracker.UAVBarrier(m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource());
+		m_StateTracker.UAVBarrier(m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource());
+		m_StateTracker.UAVBarrier(m_MeshManager.GetDrawMovableMeshletIndirectArgBB().GetResource());
+		m_StateTracker.UAVBarrier(m_MeshManager.GetDrawMovableMeshletIndicesBB().GetResource());
+		m_StateTracker.Flush(pCmdList);
 	}
 
 	pCmdList->SetComputeRootSignature(m_MeshletCullingRootSig.GetPtr());
@@ -7198,7 +7987,7 @@ void SampleApp::DoMeshletCulling(ID3D12GraphicsCommandList* pCmdList)
 	pCmdList->SetComputeRoot32BitConstant(0, static_cast<UINT>(m_MeshManager.GetMeshletCount()), 0);
 	pCmdList->SetComputeRootDescriptorTable(1, m_MeshManager.GetMeshesDescHeapIndicesCB().GetHandleCBV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(2, m_CameraCB[m_FrameIndex].GetHandle()->HandleGPU);
-	pCmdList->SetComputeRootDescriptorTable(3, m_CullingCB.GetHandle()->HandleGPU);
+	pCmdList->SetComputeRootDescriptorTable(3, m_CullingCB[m_FrameIndex].GetHandle()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(4, m_MeshManager.GetMeshletMeshMaterialTableSB().GetHandleSRV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(5, m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetHandleUAV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(6, m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetHandleUAV()->HandleGPU);
@@ -7213,12 +8002,12 @@ void SampleApp::DoMeshletCulling(ID3D12GraphicsCommandList* pCmdList)
 	UINT NumGroupX = static_cast<UINT>((m_MeshManager.GetMeshletCount() + GROUP_SIZE_X - 1) / GROUP_SIZE_X);
 	pCmdList->Dispatch(NumGroupX, 1, 1);
 
-	m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().BarrierUAV(pCmdList);
-	m_MeshManager.GetDrawOpaqueMeshletIndicesBB().BarrierUAV(pCmdList);
-	m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().BarrierUAV(pCmdList);
-	m_MeshManager.GetDrawMaskedMeshletIndicesBB().BarrierUAV(pCmdList);
-	m_MeshManager.GetDrawMovableMeshletIndirectArgBB().BarrierUAV(pCmdList);
-	m_MeshManager.GetDrawMovableMeshletIndicesBB().BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource());
+	m_StateTracker.UAVBarrier(m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource());
+	m_StateTracker.UAVBarrier(m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource());
+	m_StateTracker.UAVBarrier(m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource());
+	m_StateTracker.UAVBarrier(m_MeshManager.GetDrawMovableMeshletIndirectArgBB().GetResource());
+	m_StateTracker.UAVBarrier(m_MeshManager.GetDrawMovableMeshletIndicesBB().GetResource());
 }
 
 void SampleApp::DrawVBuffer(ID3D12GraphicsCommandList* pCmdList)
@@ -7229,7 +8018,8 @@ void SampleApp::DrawVBuffer(ID3D12GraphicsCommandList* pCmdList)
 
 	// VBufferクリア
 	{
-		DirectX::TransitionResource(pCmdList, m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_StateTracker.Transition(m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_StateTracker.Flush(pCmdList);
 
 		// シェーダ側の定義と値の一致が必要
 		const uint32_t INVALID_VISIBILITY = UINT32_MAX;
@@ -7237,10 +8027,8 @@ void SampleApp::DrawVBuffer(ID3D12GraphicsCommandList* pCmdList)
 		uint32_t clearValue[4] = {INVALID_VISIBILITY, 0, INVALID_VISIBILITY, INVALID_VISIBILITY};
 		m_VBufferTarget.ClearUavWithUintValue(pCmdList, clearValue);
 
-		D3D12_RESOURCE_BARRIER b = {};
-		b.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-		b.UAV.pResource = m_VBufferTarget.GetResource();
-		pCmdList->ResourceBarrier(1, &b);
+		// HWラスタライザではRTVへの遷移がクリアの完了を待つので、次のFlush()でUAVバリアは除かれる
+		m_StateTracker.UAVBarrier(m_VBufferTarget.GetResource());
 	}
 
 	//TODO: if-elseでもう少し共通の処理をブロックの外に出せそう
@@ -7250,8 +8038,9 @@ void SampleApp::DrawVBuffer(ID3D12GraphicsCommandList* pCmdList)
 
 		// Opaqueマテリアルのメッシュの描画
 		{
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+			m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_StateTracker.Flush(pCmdList);
 
 			pCmdList->SetComputeRootDescriptorTable(0, m_MeshManager.GetMeshesDescHeapIndicesCB().GetHandleCBV()->HandleGPU);
 			pCmdList->SetComputeRootDescriptorTable(1, m_CameraCB[m_FrameIndex].GetHandle()->HandleGPU);
@@ -7271,14 +8060,15 @@ void SampleApp::DrawVBuffer(ID3D12GraphicsCommandList* pCmdList)
 				0
 			);
 
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 		}
 
 		// AlphaMask, DoubleSidedマテリアルのメッシュの描画
 		{
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+			m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_StateTracker.Flush(pCmdList);
 
 			pCmdList->SetComputeRootDescriptorTable(2, m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetHandleSRV()->HandleGPU);
 
@@ -7293,16 +8083,17 @@ void SampleApp::DrawVBuffer(ID3D12GraphicsCommandList* pCmdList)
 				0
 			);
 
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 		}
 
-		DirectX::TransitionResource(pCmdList, m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
 	else
 	{
-		DirectX::TransitionResource(pCmdList, m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_RENDER_TARGET);
-		DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+		m_StateTracker.Transition(m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+		m_StateTracker.Flush(pCmdList);
 
 		D3D12_CPU_DESCRIPTOR_HANDLE rtv = m_VBufferTarget.GetHandleRTV()->HandleCPU;
 		const DescriptorHandle* handleDSV = m_SceneDepthTarget.GetHandleDSV();
@@ -7317,8 +8108,9 @@ void SampleApp::DrawVBuffer(ID3D12GraphicsCommandList* pCmdList)
 
 		// Opaqueマテリアルのメッシュの描画
 		{
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+			m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_StateTracker.Flush(pCmdList);
 
 			pCmdList->SetGraphicsRootDescriptorTable(0, m_MeshManager.GetMeshesDescHeapIndicesCB().GetHandleCBV()->HandleGPU);
 			pCmdList->SetGraphicsRootDescriptorTable(1, m_CameraCB[m_FrameIndex].GetHandle()->HandleGPU);
@@ -7338,14 +8130,15 @@ void SampleApp::DrawVBuffer(ID3D12GraphicsCommandList* pCmdList)
 				0
 			);
 
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 		}
 
 		// AlphaMask, DoubleSidedマテリアルのメッシュの描画
 		{
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+			m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_StateTracker.Flush(pCmdList);
 
 			pCmdList->SetGraphicsRootDescriptorTable(2, m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetHandleSRV()->HandleGPU);
 
@@ -7360,12 +8153,12 @@ void SampleApp::DrawVBuffer(ID3D12GraphicsCommandList* pCmdList)
 				0
 			);
 
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-			DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 		}
 
-		DirectX::TransitionResource(pCmdList, m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-		DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
 }
 
@@ -7374,11 +8167,12 @@ void SampleApp::DrawGBuffer(ID3D12GraphicsCommandList* pCmdList)
 	assert(!m_useMeshlet);
 	::PIXScopedEvent(pCmdList, 0, L"DrawGBuffer");
 
-	DirectX::TransitionResource(pCmdList, m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Transition(m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Flush(pCmdList);
 
 	D3D12_CPU_DESCRIPTOR_HANDLE rtvs[4] = {
 		m_GBufferBaseColorTarget.GetHandleRTV()->HandleCPU,
@@ -7418,11 +8212,11 @@ void SampleApp::DrawGBuffer(ID3D12GraphicsCommandList* pCmdList)
 	pCmdList->SetPipelineState(m_pGBufferMaskPSO.Get());
 	DrawMeshToGBuffer(pCmdList, ALPHA_MODE::ALPHA_MODE_MASK);
 
-	DirectX::TransitionResource(pCmdList, m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawGBufferFromVBuffer(ID3D12GraphicsCommandList* pCmdList)
@@ -7431,10 +8225,11 @@ void SampleApp::DrawGBufferFromVBuffer(ID3D12GraphicsCommandList* pCmdList)
 	::PIXScopedEvent(pCmdList, 0, L"DrawGBufferFromVBuffer");
 
 
-	DirectX::TransitionResource(pCmdList, m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 	
 	D3D12_CPU_DESCRIPTOR_HANDLE rtvs[4] = {
 		m_GBufferBaseColorTarget.GetHandleRTV()->HandleCPU,
@@ -7468,17 +8263,20 @@ void SampleApp::DrawGBufferFromVBuffer(ID3D12GraphicsCommandList* pCmdList)
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DoDeferredShading(ID3D12GraphicsCommandList* pCmdList, const DirectX::SimpleMath::Vector3& lightForward)
 {
 	::PIXScopedEvent(pCmdList, 0, L"DeferredShading");
 
-	DirectX::TransitionResource(pCmdList, m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	// DrawDirectionalLightShadowMap()で始めた分割バリアを終える。パスが除かれて始めていなければ何もしない
+	m_StateTracker.EndSplitTransition(m_DirLightShadowMapTarget.GetResource());
+	m_StateTracker.Transition(m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_SceneColorTarget.GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -7494,17 +8292,17 @@ void SampleApp::DoDeferredShading(ID3D12GraphicsCommandList* pCmdList, const Dir
 
 	if (m_drawSponza)
 	{
-		pCmdList->SetGraphicsRootDescriptorTable(1, m_ShadowTransformCB.GetHandle()->HandleGPU);
+		pCmdList->SetGraphicsRootDescriptorTable(1, m_ShadowTransformCB[m_FrameIndex].GetHandle()->HandleGPU);
 		pCmdList->SetGraphicsRootDescriptorTable(2, m_DirectionalLightCB[m_FrameIndex].GetHandle()->HandleGPU);
 
 		for (uint32_t i = 0u; i < NUM_POINT_LIGHTS; i++)
 		{
-			pCmdList->SetGraphicsRootDescriptorTable(3 + i, m_PointLightCB[i].GetHandle()->HandleGPU);
+			pCmdList->SetGraphicsRootDescriptorTable(3 + i, m_PointLightCB[m_FrameIndex][i].GetHandle()->HandleGPU);
 		}
 
 		for (uint32_t i = 0u; i < NUM_SPOT_LIGHTS; i++)
 		{
-			pCmdList->SetGraphicsRootDescriptorTable(3 + NUM_POINT_LIGHTS + i, m_SpotLightCB[i].GetHandle()->HandleGPU);
+			pCmdList->SetGraphicsRootDescriptorTable(3 + NUM_POINT_LIGHTS + i, m_SpotLightCB[m_FrameIndex][i].GetHandle()->HandleGPU);
 		}
 
 		pCmdList->SetGraphicsRootDescriptorTable(3 + NUM_POINT_LIGHTS + NUM_SPOT_LIGHTS, m_SceneDepthTarget.GetHandleSRV()->HandleGPU);
@@ -7541,17 +8339,18 @@ void SampleApp::DoDeferredShading(ID3D12GraphicsCommandList* pCmdList, const Dir
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawSkyBox(ID3D12GraphicsCommandList* pCmdList, const Vector3& lightForward, const Matrix& viewRotProj, const Matrix& view, const Matrix& proj, const Matrix& skyViewLutReferential)
 {
 	::PIXScopedEvent(pCmdList, 0, L"DrawSkyBox");
 
-	DirectX::TransitionResource(pCmdList, m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Transition(m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Flush(pCmdList);
 
 	D3D12_CPU_DESCRIPTOR_HANDLE rtvs[3] = {
 		m_SceneColorTarget.GetHandleRTV()->HandleCPU,
@@ -7587,10 +8386,10 @@ void SampleApp::DrawSkyBox(ID3D12GraphicsCommandList* pCmdList, const Vector3& l
 		m_SkyBox.DrawEnvironmentCubeMap(pCmdList, m_SphereMapConverter.GetHandleGPU(), view, proj, SKY_BOX_HALF_EXTENT);
 	}
 
-	DirectX::TransitionResource(pCmdList, m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawDepthBuffer(ID3D12GraphicsCommandList* pCmdList, ALPHA_MODE AlphaMode)
@@ -7674,7 +8473,8 @@ void SampleApp::DrawDepthBufferFromVBuffer(ID3D12GraphicsCommandList* pCmdList)
 {
 	::PIXScopedEvent(pCmdList, 0, L"DrawDepthBufferFromVBuffer");
 
-	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleDSV = m_SceneDepthTarget.GetHandleDSV();
 	pCmdList->OMSetRenderTargets(0, nullptr, FALSE, &handleDSV->HandleCPU);
@@ -7694,7 +8494,7 @@ void SampleApp::DrawDepthBufferFromVBuffer(ID3D12GraphicsCommandList* pCmdList)
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawHCB(ID3D12GraphicsCommandList* pCmdList)
@@ -7707,28 +8507,17 @@ void SampleApp::DrawHCB(ID3D12GraphicsCommandList* pCmdList)
 
 	uint32_t mip0SizeX = (uint32_t)m_HCB_Target.GetDesc().Width;
 	uint32_t mip0SizeY = (uint32_t)m_HCB_Target.GetDesc().Height;
-
-	D3D12_RESOURCE_BARRIER templateBarrier = {};
-	templateBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	templateBarrier.Transition.pResource = m_HCB_Target.GetResource();
-
-	std::vector<D3D12_RESOURCE_BARRIER> mipBarriers;
+	uint32_t numMips = m_HCB_Target.GetDesc().MipLevels;
 
 	// バリアの設定。HZBの場合はサブリソースごとにSRVかUAVかで指定を変える
-	DirectX::TransitionResource(pCmdList, m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 
 	for (uint32_t mip = 0; mip < HCB_MAX_NUM_OUTPUT_MIP; mip++)
 	{
-		D3D12_RESOURCE_BARRIER mipBarrier = templateBarrier;
-		mipBarrier.Transition.Subresource = mip;
-		mipBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-		mipBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
-
-		mipBarriers.push_back(mipBarrier);
+		m_StateTracker.TransitionSubresource(m_HCB_Target.GetResource(), numMips, mip, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	}
 
-	// DirectX::TransitionResource()ではサブリソースごとの指定はできないのでScopedBarrierを使う
-	DirectX::ScopedBarrier mipTransitions(pCmdList, mipBarriers.data(), mipBarriers.size());
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_HCB_RootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pHCB_PSO.Get());
@@ -7746,9 +8535,14 @@ void SampleApp::DrawHCB(ID3D12GraphicsCommandList* pCmdList)
 	UINT NumGroupZ = 1;
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	m_HCB_Target.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(m_HCB_Target.GetResource());
 
-	DirectX::TransitionResource(pCmdList, m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	for (uint32_t mip = 0; mip < HCB_MAX_NUM_OUTPUT_MIP; mip++)
+	{
+		m_StateTracker.TransitionSubresource(m_HCB_Target.GetResource(), numMips, mip, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+
+	m_StateTracker.Transition(m_SceneColorTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawHZB(ID3D12GraphicsCommandList* pCmdList)
@@ -7765,10 +8559,6 @@ void SampleApp::DrawHZB(ID3D12GraphicsCommandList* pCmdList)
 	uint32_t numDrawCall = (uint32_t)m_pHZB_CBs.size();
 	assert(numDrawCall > 0);
 
-	D3D12_RESOURCE_BARRIER templateBarrier = {};
-	templateBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	templateBarrier.Transition.pResource = m_HZB_Target.GetResource();
-
 	for (uint32_t i = 0; i < numDrawCall; i++)
 	{
 		uint32_t numOutputMip = 0;
@@ -7782,35 +8572,47 @@ void SampleApp::DrawHZB(ID3D12GraphicsCommandList* pCmdList)
 		}
 		assert(numOutputMip > 0);
 
-		std::vector<D3D12_RESOURCE_BARRIER> mipBarriers;
+		// ひとつ小さいMipレベルだけを参照するSRVは、このフレームの一時的なディスクリプタに作る。
+		// 失敗して抜けるときに遷移を残さないように、遷移を要求する前に作っておく
+		DescriptorHandle parentMipSRV;
+		if (i > 0)
+		{
+			// https://learn.microsoft.com/en-us/windows/win32/api/d3d12/ns-d3d12-d3d12_tex2d_srv
+			D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc;
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Format = m_HZB_Target.GetDesc().Format;
+			srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+			srvDesc.Texture2D.MostDetailedMip = HZB_MAX_NUM_OUTPUT_MIP * i - 1;
+			srvDesc.Texture2D.MipLevels = 1;
+			srvDesc.Texture2D.PlaneSlice = 0;
+			srvDesc.Texture2D.ResourceMinLODClamp = 0;
+
+			if (!m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->AllocTransientHandles(1, parentMipSRV))
+			{
+				ELOG("Error : DescriptorPool::AllocTransientHandles() Failed.");
+				return;
+			}
+
+			m_pDevice->CreateShaderResourceView(m_HZB_Target.GetResource(), &srvDesc, parentMipSRV.HandleCPU);
+		}
 
 		// バリアの設定。HZBの場合はサブリソースごとにSRVかUAVかで指定を変える
 		if (i == 0)
 		{
-			DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 		}
 		else
 		{
-			D3D12_RESOURCE_BARRIER parentMipBarrier = templateBarrier;
-			parentMipBarrier.Transition.Subresource = HZB_MAX_NUM_OUTPUT_MIP * i - 1;
-			parentMipBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-			parentMipBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-
-			mipBarriers.push_back(parentMipBarrier);
+			m_StateTracker.TransitionSubresource(m_HZB_Target.GetResource(), numMips, HZB_MAX_NUM_OUTPUT_MIP * i - 1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 		}
 
 		for (uint32_t mip = 0; mip < numOutputMip; mip++)
 		{
-			D3D12_RESOURCE_BARRIER mipBarrier = templateBarrier;
-			mipBarrier.Transition.Subresource = HZB_MAX_NUM_OUTPUT_MIP * i + mip;
-			mipBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-			mipBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
-
-			mipBarriers.push_back(mipBarrier);
+			m_StateTracker.TransitionSubresource(m_HZB_Target.GetResource(), numMips, HZB_MAX_NUM_OUTPUT_MIP * i + mip, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 		}
 
-		// DirectX::TransitionResource()ではサブリソースごとの指定はできないのでScopedBarrierを使う
-		DirectX::ScopedBarrier mipTransitions(pCmdList, mipBarriers.data(), mipBarriers.size());
+		// 前の回で書いたMipをUAVからSRVに戻す遷移も、ここでまとめて発行される
+		m_StateTracker.Flush(pCmdList);
 
 		pCmdList->SetComputeRootSignature(m_HZB_RootSig.GetPtr());
 		pCmdList->SetPipelineState(m_pHZB_PSO.Get());
@@ -7821,7 +8623,7 @@ void SampleApp::DrawHZB(ID3D12GraphicsCommandList* pCmdList)
 		}
 		else
 		{
-			pCmdList->SetComputeRootDescriptorTable(1, m_pHZB_ParentMipSRVs[i - 1]->HandleGPU);
+			pCmdList->SetComputeRootDescriptorTable(1, parentMipSRV.HandleGPU);
 		}
 
 		for (uint32_t mip = 0; mip < numOutputMip; mip++)
@@ -7839,11 +8641,20 @@ void SampleApp::DrawHZB(ID3D12GraphicsCommandList* pCmdList)
 
 		if (i == 0)
 		{
-			DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		}
+		else
+		{
+			m_StateTracker.TransitionSubresource(m_HZB_Target.GetResource(), numMips, HZB_MAX_NUM_OUTPUT_MIP * i - 1, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		}
+
+		for (uint32_t mip = 0; mip < numOutputMip; mip++)
+		{
+			m_StateTracker.TransitionSubresource(m_HZB_Target.GetResource(), numMips, HZB_MAX_NUM_OUTPUT_MIP * i + mip, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 		}
 	}
 	
-	m_HZB_Target.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(m_HZB_Target.GetResource());
 }
 
 void SampleApp::DrawObjectVelocity(ID3D12GraphicsCommandList* pCmdList, const DirectX::SimpleMath::Matrix& world, const DirectX::SimpleMath::Matrix& prevWorld, const DirectX::SimpleMath::Matrix& viewProjWithJitter, const DirectX::SimpleMath::Matrix& viewProjNoJitter, const DirectX::SimpleMath::Matrix& prevViewProjNoJitter)
@@ -7859,8 +8670,9 @@ void SampleApp::DrawObjectVelocity(ID3D12GraphicsCommandList* pCmdList, const Di
 		ptr->PrevWVPNoJitter = prevWorld * prevViewProjNoJitter;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_ObjectVelocityTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Transition(m_ObjectVelocityTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_ObjectVelocityTarget.GetHandleRTV();
 	const DescriptorHandle* handleDSV = m_SceneDepthTarget.GetHandleDSV();
@@ -7883,8 +8695,9 @@ void SampleApp::DrawObjectVelocity(ID3D12GraphicsCommandList* pCmdList, const Di
 	// Movableなものだけ描画
 	if (m_useMeshlet)
 	{
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMovableMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMovableMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_MeshManager.GetDrawMovableMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+		m_StateTracker.Transition(m_MeshManager.GetDrawMovableMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Flush(pCmdList);
 
 		pCmdList->SetGraphicsRootDescriptorTable(1, m_MeshManager.GetMeshesDescHeapIndicesCB().GetHandleCBV()->HandleGPU);
 		pCmdList->SetGraphicsRootDescriptorTable(2, m_MeshManager.GetDrawMovableMeshletIndicesBB().GetHandleSRV()->HandleGPU);
@@ -7902,8 +8715,8 @@ void SampleApp::DrawObjectVelocity(ID3D12GraphicsCommandList* pCmdList, const Di
 		);
 #endif
 
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMovableMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMovableMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_StateTracker.Transition(m_MeshManager.GetDrawMovableMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_StateTracker.Transition(m_MeshManager.GetDrawMovableMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	}
 	else
 	{
@@ -7922,8 +8735,8 @@ void SampleApp::DrawObjectVelocity(ID3D12GraphicsCommandList* pCmdList, const Di
 		}
 	}
 
-	DirectX::TransitionResource(pCmdList, m_ObjectVelocityTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_ObjectVelocityTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawCameraVelocity(ID3D12GraphicsCommandList* pCmdList, const DirectX::SimpleMath::Matrix& viewProjNoJitter)
@@ -7936,7 +8749,8 @@ void SampleApp::DrawCameraVelocity(ID3D12GraphicsCommandList* pCmdList, const Di
 		ptr->ClipToPrevClip = viewProjNoJitter.Invert() * m_PrevViewProjNoJitter;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_VelocityTarget.GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -7958,14 +8772,15 @@ void SampleApp::DrawCameraVelocity(ID3D12GraphicsCommandList* pCmdList, const Di
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawSSAOSetup(ID3D12GraphicsCommandList* pCmdList)
 {
 	::PIXScopedEvent(pCmdList, 0, L"SSAOSetup");
 
-	DirectX::TransitionResource(pCmdList, m_SSAOSetupTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_SSAOSetupTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_SSAOSetupTarget.GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -7994,7 +8809,7 @@ void SampleApp::DrawSSAOSetup(ID3D12GraphicsCommandList* pCmdList)
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_SSAOSetupTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SSAOSetupTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 //TODO:SSパスは処理を共通化したい
@@ -8015,7 +8830,8 @@ void SampleApp::DrawSSAO(ID3D12GraphicsCommandList* pCmdList, const DirectX::Sim
 			ptr->Intensity = m_SSAO_Intensity;
 		}
 
-		DirectX::TransitionResource(pCmdList, m_SSAO_HalfResTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		m_StateTracker.Transition(m_SSAO_HalfResTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		m_StateTracker.Flush(pCmdList);
 
 		const DescriptorHandle* handleRTV = m_SSAO_HalfResTarget.GetHandleRTV();
 		pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8045,7 +8861,7 @@ void SampleApp::DrawSSAO(ID3D12GraphicsCommandList* pCmdList, const DirectX::Sim
 
 		pCmdList->DrawInstanced(3, 1, 0, 0);
 
-		DirectX::TransitionResource(pCmdList, m_SSAO_HalfResTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_SSAO_HalfResTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
 
 	// フル解像度パス
@@ -8063,7 +8879,8 @@ void SampleApp::DrawSSAO(ID3D12GraphicsCommandList* pCmdList, const DirectX::Sim
 			ptr->Intensity = m_SSAO_Intensity;
 		}
 
-		DirectX::TransitionResource(pCmdList, m_SSAO_FullResTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		m_StateTracker.Transition(m_SSAO_FullResTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		m_StateTracker.Flush(pCmdList);
 
 		const DescriptorHandle* handleRTV = m_SSAO_FullResTarget.GetHandleRTV();
 		pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8088,7 +8905,7 @@ void SampleApp::DrawSSAO(ID3D12GraphicsCommandList* pCmdList, const DirectX::Sim
 
 		pCmdList->DrawInstanced(3, 1, 0, 0);
 
-		DirectX::TransitionResource(pCmdList, m_SSAO_FullResTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_SSAO_FullResTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
 }
 
@@ -8097,7 +8914,7 @@ void SampleApp::DrawSSGI(ID3D12GraphicsCommandList* pCmdList, const DirectX::Sim
 	::PIXScopedEvent(pCmdList, 0, L"SSGI");
 
 	{
-		CbSSGI* ptr = m_SSGI_CB.GetPtr<CbSSGI>();
+		CbSSGI* ptr = m_SSGI_CB[m_FrameIndex].GetPtr<CbSSGI>();
 		ptr->ProjMatrix = proj;
 		ptr->VRotPMatrix = viewRotProj;
 		ptr->InvVRotPMatrix = viewRotProj.Invert();
@@ -8105,14 +8922,15 @@ void SampleApp::DrawSSGI(ID3D12GraphicsCommandList* pCmdList, const DirectX::Sim
 		ptr->Intensity = m_SSGI_Intensity;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_HCB_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_HZB_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SSGI_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_HCB_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_HZB_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SSGI_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_SSGI_RootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pSSGI_PSO.Get());
-	pCmdList->SetComputeRootDescriptorTable(0, m_SSGI_CB.GetHandle()->HandleGPU);
+	pCmdList->SetComputeRootDescriptorTable(0, m_SSGI_CB[m_FrameIndex].GetHandle()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(1, m_HCB_Target.GetHandleSRV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(2, m_HZB_Target.GetHandleSRV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(3, m_GBufferNormalTarget.GetHandleSRV()->HandleGPU);
@@ -8128,20 +8946,21 @@ void SampleApp::DrawSSGI(ID3D12GraphicsCommandList* pCmdList, const DirectX::Sim
 	UINT NumGroupZ = 1;
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	m_SSGI_Target.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(m_SSGI_Target.GetResource());
 
-	DirectX::TransitionResource(pCmdList, m_HCB_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_HZB_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SSGI_Target.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_HCB_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_HZB_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SSGI_Target.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawSSGI_Denoise(ID3D12GraphicsCommandList* pCmdList)
 {
 	::PIXScopedEvent(pCmdList, 0, L"SSGI Denoise");
 
-	DirectX::TransitionResource(pCmdList, m_SSGI_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SSGI_DenoiseTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_SSGI_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SSGI_DenoiseTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_SSGI_DenoiseRootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pSSGI_DenoisePSO.Get());
@@ -8159,10 +8978,10 @@ void SampleApp::DrawSSGI_Denoise(ID3D12GraphicsCommandList* pCmdList)
 	UINT NumGroupZ = 1;
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	m_SSGI_DenoiseTarget.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(m_SSGI_DenoiseTarget.GetResource());
 
-	DirectX::TransitionResource(pCmdList, m_SSGI_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SSGI_DenoiseTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SSGI_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SSGI_DenoiseTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 // TODO: SSGIのTemporalAccumulationはUEの実装が汎用的すぎて参考にするのが難しいので一旦開発を止めている
@@ -8170,10 +8989,11 @@ void SampleApp::DrawSSGI_TemporalAccumulation(ID3D12GraphicsCommandList* pCmdLis
 {
 	::PIXScopedEvent(pCmdList, 0, L"SSGI TemporalAccumulation");
 
-	DirectX::TransitionResource(pCmdList, m_SSGI_DenoiseTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, prevTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, curTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_SSGI_DenoiseTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(prevTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(curTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_SSGI_TemporalAccumulationRootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pSSGI_TemporalAccumulationPSO.Get());
@@ -8193,19 +9013,20 @@ void SampleApp::DrawSSGI_TemporalAccumulation(ID3D12GraphicsCommandList* pCmdLis
 	UINT NumGroupZ = 1;
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	curTarget.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(curTarget.GetResource());
 
-	DirectX::TransitionResource(pCmdList, m_SSGI_DenoiseTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, prevTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, curTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SSGI_DenoiseTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(prevTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(curTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawAmbientLight(ID3D12GraphicsCommandList* pCmdList, const ColorTarget& SSGI_CurTarget)
 {
 	::PIXScopedEvent(pCmdList, 0, L"AmbientLight");
 
-	DirectX::TransitionResource(pCmdList, m_AmbientLightTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_AmbientLightTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_AmbientLightTarget.GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8227,7 +9048,7 @@ void SampleApp::DrawAmbientLight(ID3D12GraphicsCommandList* pCmdList, const Colo
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_AmbientLightTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_AmbientLightTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawSSR(ID3D12GraphicsCommandList* pCmdList, const DirectX::SimpleMath::Matrix& proj, const DirectX::SimpleMath::Matrix& viewRotProj)
@@ -8235,7 +9056,7 @@ void SampleApp::DrawSSR(ID3D12GraphicsCommandList* pCmdList, const DirectX::Simp
 	::PIXScopedEvent(pCmdList, 0, L"SSR");
 
 	{
-		CbSSR* ptr = m_SSR_CB.GetPtr<CbSSR>();
+		CbSSR* ptr = m_SSR_CB[m_FrameIndex].GetPtr<CbSSR>();
 		ptr->ProjMatrix = proj;
 		ptr->VRotPMatrix = viewRotProj;
 		ptr->InvVRotPMatrix = viewRotProj.Invert();
@@ -8244,7 +9065,8 @@ void SampleApp::DrawSSR(ID3D12GraphicsCommandList* pCmdList, const DirectX::Simp
 		ptr->bDebugViewSSR = m_debugViewSSR ? 1 : 0;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_SSR_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_SSR_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_SSR_Target.GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8252,7 +9074,7 @@ void SampleApp::DrawSSR(ID3D12GraphicsCommandList* pCmdList, const DirectX::Simp
 	m_SSR_Target.ClearView(pCmdList);
 
 	pCmdList->SetGraphicsRootSignature(m_SSR_RootSig.GetPtr());
-	pCmdList->SetGraphicsRootDescriptorTable(0, m_SSR_CB.GetHandle()->HandleGPU);
+	pCmdList->SetGraphicsRootDescriptorTable(0, m_SSR_CB[m_FrameIndex].GetHandle()->HandleGPU);
 	pCmdList->SetGraphicsRootDescriptorTable(1, m_AmbientLightTarget.GetHandleSRV()->HandleGPU);
 	pCmdList->SetGraphicsRootDescriptorTable(2, m_SceneDepthTarget.GetHandleSRV()->HandleGPU);
 	pCmdList->SetGraphicsRootDescriptorTable(3, m_GBufferNormalTarget.GetHandleSRV()->HandleGPU);
@@ -8269,7 +9091,7 @@ void SampleApp::DrawSSR(ID3D12GraphicsCommandList* pCmdList, const DirectX::Simp
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_SSR_Target.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SSR_Target.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawVolumetricFogScattering(ID3D12GraphicsCommandList* pCmdList, const DirectX::SimpleMath::Matrix& viewRotProjNoJitter, const DirectX::SimpleMath::Matrix& viewProjNoJitter, const DirectX::SimpleMath::Matrix& prevViewProjNoJitter, const ColorTarget& prevTarget, const ColorTarget& curTarget)
@@ -8279,7 +9101,7 @@ void SampleApp::DrawVolumetricFogScattering(ID3D12GraphicsCommandList* pCmdList,
 	::PIXScopedEvent(pCmdList, 0, L"VolumetricFogScattering");
 
 	{
-		CbVolumetricFog* ptr = m_VolumetricFogCB.GetPtr<CbVolumetricFog>();
+		CbVolumetricFog* ptr = m_VolumetricFogCB[m_FrameIndex].GetPtr<CbVolumetricFog>();
 		ptr->InvVRotPMatrix = viewRotProjNoJitter.Invert();
 		// これはfloat精度の誤差が入る。前フレームとVPが変わらなくても誤差で単位行列にはならない
 		ptr->ClipToPrevClip = viewProjNoJitter.Invert() * prevViewProjNoJitter;
@@ -8288,24 +9110,25 @@ void SampleApp::DrawVolumetricFogScattering(ID3D12GraphicsCommandList* pCmdList,
 		ptr->SpotLightScatteringIntensity = m_spotLightVolumetricFogScatteringIntensity;
 	}
 
-	DirectX::TransitionResource(pCmdList, prevTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_DirLightShadowMapTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(prevTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_DirLightShadowMapTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	for (uint32_t i = 0u; i < NUM_SPOT_LIGHTS; i++)
 	{
-		DirectX::TransitionResource(pCmdList, m_SpotLightShadowMapTarget[i].GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_SpotLightShadowMapTarget[i].GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	}
-	DirectX::TransitionResource(pCmdList, curTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(curTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_VolumetricFogScatteringRootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pVolumetricFogScatteringPSO.Get());
-	pCmdList->SetComputeRootDescriptorTable(0, m_VolumetricFogCB.GetHandle()->HandleGPU);
+	pCmdList->SetComputeRootDescriptorTable(0, m_VolumetricFogCB[m_FrameIndex].GetHandle()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(1, m_DirectionalLightCB[m_FrameIndex].GetHandle()->HandleGPU);
 	for (uint32_t i = 0u; i < NUM_SPOT_LIGHTS; i++)
 	{
-		pCmdList->SetComputeRootDescriptorTable(2 + i, m_SpotLightCB[i].GetHandle()->HandleGPU);
+		pCmdList->SetComputeRootDescriptorTable(2 + i, m_SpotLightCB[m_FrameIndex][i].GetHandle()->HandleGPU);
 	}
 	pCmdList->SetComputeRootDescriptorTable(2 + NUM_SPOT_LIGHTS, m_CameraCB[m_FrameIndex].GetHandle()->HandleGPU);
-	pCmdList->SetComputeRootDescriptorTable(3 + NUM_SPOT_LIGHTS, m_ShadowTransformCB.GetHandle()->HandleGPU);
+	pCmdList->SetComputeRootDescriptorTable(3 + NUM_SPOT_LIGHTS, m_ShadowTransformCB[m_FrameIndex].GetHandle()->HandleGPU);
 
 	pCmdList->SetComputeRootDescriptorTable(4 + NUM_SPOT_LIGHTS, prevTarget.GetHandleSRV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(5 + NUM_SPOT_LIGHTS, m_DirLightShadowMapTarget.GetHandleSRV()->HandleGPU);
@@ -8324,15 +9147,15 @@ void SampleApp::DrawVolumetricFogScattering(ID3D12GraphicsCommandList* pCmdList,
 	UINT NumGroupZ = DivideAndRoundUp(curTarget.GetDesc().DepthOrArraySize, GROUP_SIZE_XYZ);
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	curTarget.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(curTarget.GetResource());
 
-	DirectX::TransitionResource(pCmdList, prevTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_DirLightShadowMapTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(prevTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_DirLightShadowMapTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	for (uint32_t i = 0u; i < NUM_SPOT_LIGHTS; i++)
 	{
-		DirectX::TransitionResource(pCmdList, m_SpotLightShadowMapTarget[i].GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_SpotLightShadowMapTarget[i].GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
-	DirectX::TransitionResource(pCmdList, curTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(curTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawVolumetricFogIntegration(ID3D12GraphicsCommandList* pCmdList, const ColorTarget& curTarget)
@@ -8341,12 +9164,13 @@ void SampleApp::DrawVolumetricFogIntegration(ID3D12GraphicsCommandList* pCmdList
 
 	::PIXScopedEvent(pCmdList, 0, L"VolumetricFogIntegration");
 
-	DirectX::TransitionResource(pCmdList, curTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_VolumetricFogIntegrationTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(curTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_VolumetricFogIntegrationTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_VolumetricFogIntegrationRootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pVolumetricFogIntegrationPSO.Get());
-	pCmdList->SetComputeRootDescriptorTable(0, m_VolumetricFogCB.GetHandle()->HandleGPU);
+	pCmdList->SetComputeRootDescriptorTable(0, m_VolumetricFogCB[m_FrameIndex].GetHandle()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(1, curTarget.GetHandleSRV()->HandleGPU);
 	pCmdList->SetComputeRootDescriptorTable(2, m_VolumetricFogIntegrationTarget.GetHandleUAVs()[0]->HandleGPU);
 
@@ -8358,10 +9182,10 @@ void SampleApp::DrawVolumetricFogIntegration(ID3D12GraphicsCommandList* pCmdList
 	UINT NumGroupZ = 1;
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	m_VolumetricFogIntegrationTarget.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(m_VolumetricFogIntegrationTarget.GetResource());
 
-	DirectX::TransitionResource(pCmdList, curTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_VolumetricFogIntegrationTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(curTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_VolumetricFogIntegrationTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawVolumetricFogComposition(ID3D12GraphicsCommandList* pCmdList)
@@ -8370,7 +9194,8 @@ void SampleApp::DrawVolumetricFogComposition(ID3D12GraphicsCommandList* pCmdList
 
 	::PIXScopedEvent(pCmdList, 0, L"VolumetricFogComposition");
 
-	DirectX::TransitionResource(pCmdList, m_VolumetricCompositionTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_VolumetricCompositionTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_VolumetricCompositionTarget.GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8378,7 +9203,7 @@ void SampleApp::DrawVolumetricFogComposition(ID3D12GraphicsCommandList* pCmdList
 	m_VolumetricCompositionTarget.ClearView(pCmdList);
 
 	pCmdList->SetGraphicsRootSignature(m_VolumetricFogCompositionRootSig.GetPtr());
-	pCmdList->SetGraphicsRootDescriptorTable(0, m_VolumetricFogCB.GetHandle()->HandleGPU);
+	pCmdList->SetGraphicsRootDescriptorTable(0, m_VolumetricFogCB[m_FrameIndex].GetHandle()->HandleGPU);
 	pCmdList->SetGraphicsRootDescriptorTable(1, m_SSR_Target.GetHandleSRV()->HandleGPU);
 	pCmdList->SetGraphicsRootDescriptorTable(2, m_SceneDepthTarget.GetHandleSRV()->HandleGPU);
 	pCmdList->SetGraphicsRootDescriptorTable(3, m_VolumetricFogIntegrationTarget.GetHandleSRV()->HandleGPU);
@@ -8393,7 +9218,7 @@ void SampleApp::DrawVolumetricFogComposition(ID3D12GraphicsCommandList* pCmdList
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_VolumetricCompositionTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_VolumetricCompositionTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawTemporalAA(ID3D12GraphicsCommandList* pCmdList, float temporalJitetrPixelsX, float temporalJitetrPixelsY, const ColorTarget& prevTarget, const ColorTarget& curTarget)
@@ -8442,15 +9267,16 @@ void SampleApp::DrawTemporalAA(ID3D12GraphicsCommandList* pCmdList, float tempor
 
 	if (m_drawSponza)
 	{
-		DirectX::TransitionResource(pCmdList, m_VolumetricCompositionTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_VolumetricCompositionTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	}
 	else
 	{
-		DirectX::TransitionResource(pCmdList, m_SSR_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_SSR_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	}
-	DirectX::TransitionResource(pCmdList, prevTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, curTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(prevTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(curTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	pCmdList->SetComputeRootSignature(m_TemporalAA_RootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pTemporalAA_PSO.Get());
@@ -8477,19 +9303,19 @@ void SampleApp::DrawTemporalAA(ID3D12GraphicsCommandList* pCmdList, float tempor
 	UINT NumGroupZ = 1;
 	pCmdList->Dispatch(NumGroupX, NumGroupY, NumGroupZ);
 
-	curTarget.BarrierUAV(pCmdList);
+	m_StateTracker.UAVBarrier(curTarget.GetResource());
 
 	if (m_drawSponza)
 	{
-		DirectX::TransitionResource(pCmdList, m_VolumetricCompositionTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_VolumetricCompositionTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
 	else
 	{
-		DirectX::TransitionResource(pCmdList, m_SSR_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_SSR_Target.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
-	DirectX::TransitionResource(pCmdList, prevTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, curTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(prevTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_VelocityTarget.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(curTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawMotionBlur(ID3D12GraphicsCommandList* pCmdList, const ColorTarget& InputColor)
@@ -8497,11 +9323,12 @@ void SampleApp::DrawMotionBlur(ID3D12GraphicsCommandList* pCmdList, const ColorT
 	::PIXScopedEvent(pCmdList, 0, L"MotionBlur");
 
 	{
-		CbMotionBlur* ptr = m_MotionBlurCB.GetPtr<CbMotionBlur>();
+		CbMotionBlur* ptr = m_MotionBlurCB[m_FrameIndex].GetPtr<CbMotionBlur>();
 		ptr->Scale = m_motionBlurScale;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_MotionBlurTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_MotionBlurTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_MotionBlurTarget.GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8509,7 +9336,7 @@ void SampleApp::DrawMotionBlur(ID3D12GraphicsCommandList* pCmdList, const ColorT
 	m_MotionBlurTarget.ClearView(pCmdList);
 
 	pCmdList->SetGraphicsRootSignature(m_MotionBlurRootSig.GetPtr());
-	pCmdList->SetGraphicsRootDescriptorTable(0, m_MotionBlurCB.GetHandle()->HandleGPU);
+	pCmdList->SetGraphicsRootDescriptorTable(0, m_MotionBlurCB[m_FrameIndex].GetHandle()->HandleGPU);
 	pCmdList->SetGraphicsRootDescriptorTable(1, InputColor.GetHandleSRV()->HandleGPU);
 	pCmdList->SetGraphicsRootDescriptorTable(2, m_VelocityTarget.GetHandleSRV()->HandleGPU);
 	pCmdList->SetPipelineState(m_pMotionBlurPSO.Get());
@@ -8523,14 +9350,15 @@ void SampleApp::DrawMotionBlur(ID3D12GraphicsCommandList* pCmdList, const ColorT
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_MotionBlurTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_MotionBlurTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawBloomSetup(ID3D12GraphicsCommandList* pCmdList)
 {
 	::PIXScopedEvent(pCmdList, 0, L"BloomSetup");
 
-	DirectX::TransitionResource(pCmdList, m_BloomSetupTarget[0].GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_BloomSetupTarget[0].GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_BloomSetupTarget[0].GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8555,7 +9383,7 @@ void SampleApp::DrawBloomSetup(ID3D12GraphicsCommandList* pCmdList)
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_BloomSetupTarget[0].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_BloomSetupTarget[0].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawTonemap(ID3D12GraphicsCommandList* pCmdList)
@@ -8571,7 +9399,8 @@ void SampleApp::DrawTonemap(ID3D12GraphicsCommandList* pCmdList)
 		ptr->BloomIntensity = m_BloomIntensity;
 	}
 
-	DirectX::TransitionResource(pCmdList, m_TonemapTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_TonemapTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_TonemapTarget.GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8593,7 +9422,7 @@ void SampleApp::DrawTonemap(ID3D12GraphicsCommandList* pCmdList)
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_TonemapTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_TonemapTarget.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawFXAA(ID3D12GraphicsCommandList* pCmdList)
@@ -8601,12 +9430,13 @@ void SampleApp::DrawFXAA(ID3D12GraphicsCommandList* pCmdList)
 	::PIXScopedEvent(pCmdList, 0, L"FXAA");
 
 	{
-		CbFXAA* ptr = m_FXAA_CB.GetPtr<CbFXAA>();
+		CbFXAA* ptr = m_FXAA_CB[m_FrameIndex].GetPtr<CbFXAA>();
 		ptr->bEnableFXAA = (m_enableFXAA ? 1 : 0);
 		ptr->bEnableFXAAHighQuality = (m_enableFXAA_HighQuality ? 1 : 0);
 	}
 
-	DirectX::TransitionResource(pCmdList, m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_FXAA_Target.GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8614,7 +9444,7 @@ void SampleApp::DrawFXAA(ID3D12GraphicsCommandList* pCmdList)
 	m_FXAA_Target.ClearView(pCmdList);
 
 	pCmdList->SetGraphicsRootSignature(m_FXAA_RootSig.GetPtr());
-	pCmdList->SetGraphicsRootDescriptorTable(0, m_FXAA_CB.GetHandle()->HandleGPU);
+	pCmdList->SetGraphicsRootDescriptorTable(0, m_FXAA_CB[m_FrameIndex].GetHandle()->HandleGPU);
 	pCmdList->SetGraphicsRootDescriptorTable(1, m_TonemapTarget.GetHandleSRV()->HandleGPU);
 	pCmdList->SetPipelineState(m_pFXAA_PSO.Get());
 
@@ -8627,7 +9457,7 @@ void SampleApp::DrawFXAA(ID3D12GraphicsCommandList* pCmdList)
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawDebugVBuffer(ID3D12GraphicsCommandList* pCmdList)
@@ -8641,7 +9471,8 @@ void SampleApp::DrawDebugVBuffer(ID3D12GraphicsCommandList* pCmdList)
 
 	::PIXScopedEvent(pCmdList, 0, L"Debug VBuffer");
 
-	DirectX::TransitionResource(pCmdList, m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	D3D12_CPU_DESCRIPTOR_HANDLE rtv = m_FXAA_Target.GetHandleRTV()->HandleCPU;
 	pCmdList->OMSetRenderTargets(1, &rtv, FALSE, nullptr);
@@ -8660,7 +9491,7 @@ void SampleApp::DrawDebugVBuffer(ID3D12GraphicsCommandList* pCmdList)
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawMeshletAABB(ID3D12GraphicsCommandList* pCmdList)
@@ -8669,8 +9500,8 @@ void SampleApp::DrawMeshletAABB(ID3D12GraphicsCommandList* pCmdList)
 
 	::PIXScopedEvent(pCmdList, 0, L"Meshlet AABB");
 
-	DirectX::TransitionResource(pCmdList, m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_StateTracker.Transition(m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
 	D3D12_CPU_DESCRIPTOR_HANDLE rtv = m_FXAA_Target.GetHandleRTV()->HandleCPU;
 	const DescriptorHandle* handleDSV = m_SceneDepthTarget.GetHandleDSV();
@@ -8684,8 +9515,9 @@ void SampleApp::DrawMeshletAABB(ID3D12GraphicsCommandList* pCmdList)
 
 	// Opaqueマテリアルのメッシュの描画
 	{
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+		m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Flush(pCmdList);
 
 		pCmdList->SetGraphicsRootDescriptorTable(0, m_MeshManager.GetMeshesDescHeapIndicesCB().GetHandleCBV()->HandleGPU);
 		pCmdList->SetGraphicsRootDescriptorTable(1, m_CameraCB[m_FrameIndex].GetHandle()->HandleGPU);
@@ -8706,14 +9538,15 @@ void SampleApp::DrawMeshletAABB(ID3D12GraphicsCommandList* pCmdList)
 			0
 		);
 
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_StateTracker.Transition(m_MeshManager.GetDrawOpaqueMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	}
 
 	// AlphaMask, DoubleSidedマテリアルのメッシュの描画
 	{
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+		m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Flush(pCmdList);
 
 		pCmdList->SetGraphicsRootDescriptorTable(2, m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetHandleSRV()->HandleGPU);
 
@@ -8727,19 +9560,20 @@ void SampleApp::DrawMeshletAABB(ID3D12GraphicsCommandList* pCmdList)
 			0
 		);
 
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		DirectX::TransitionResource(pCmdList, m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndirectArgBB().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_StateTracker.Transition(m_MeshManager.GetDrawMaskedMeshletIndicesBB().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	}
 
-	DirectX::TransitionResource(pCmdList, m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_FXAA_Target.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawDownsample(ID3D12GraphicsCommandList* pCmdList, const ColorTarget& SrcColor, const ColorTarget& DstColor, uint32_t CBIdx)
 {
 	::PIXScopedEvent(pCmdList, 0, L"Downsample %d x %d", DstColor.GetDesc().Width, DstColor.GetDesc().Height);
 
-	DirectX::TransitionResource(pCmdList, DstColor.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(DstColor.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = DstColor.GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8766,7 +9600,7 @@ void SampleApp::DrawDownsample(ID3D12GraphicsCommandList* pCmdList, const ColorT
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, DstColor.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(DstColor.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawFilter(ID3D12GraphicsCommandList* pCmdList, const ColorTarget& SrcColor, const ColorTarget& IntermediateColor, const ColorTarget& DstColor, const ColorTarget& DownerResultColor, const ConstantBuffer& HorizontalConstantBuffer, const ConstantBuffer& VerticalConstantBuffer)
@@ -8775,7 +9609,8 @@ void SampleApp::DrawFilter(ID3D12GraphicsCommandList* pCmdList, const ColorTarge
 	{
 		::PIXScopedEvent(pCmdList, 0, L"FilterHorizontal %dx%d", IntermediateColor.GetDesc().Width, IntermediateColor.GetDesc().Height);
 
-		DirectX::TransitionResource(pCmdList, IntermediateColor.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		m_StateTracker.Transition(IntermediateColor.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		m_StateTracker.Flush(pCmdList);
 
 		const DescriptorHandle* handleRTV = IntermediateColor.GetHandleRTV();
 		pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8802,14 +9637,15 @@ void SampleApp::DrawFilter(ID3D12GraphicsCommandList* pCmdList, const ColorTarge
 
 		pCmdList->DrawInstanced(3, 1, 0, 0);
 
-		DirectX::TransitionResource(pCmdList, IntermediateColor.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(IntermediateColor.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
 
 	// Vertical Gaussian Filter
 	{
 		::PIXScopedEvent(pCmdList, 0, L"FilterVertical %dx%d", DstColor.GetDesc().Width, DstColor.GetDesc().Height);
 
-		DirectX::TransitionResource(pCmdList, DstColor.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		m_StateTracker.Transition(DstColor.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		m_StateTracker.Flush(pCmdList);
 
 		const DescriptorHandle* handleRTV = DstColor.GetHandleRTV();
 		pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8836,7 +9672,7 @@ void SampleApp::DrawFilter(ID3D12GraphicsCommandList* pCmdList, const ColorTarge
 
 		pCmdList->DrawInstanced(3, 1, 0, 0);
 
-		DirectX::TransitionResource(pCmdList, DstColor.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_StateTracker.Transition(DstColor.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
 }
 
@@ -8844,11 +9680,12 @@ void SampleApp::DoPathTracing(ID3D12GraphicsCommandList4* pCmdList)
 {
 	::PIXScopedEvent(pCmdList, 0, L"PathTracing");
 
-	DirectX::TransitionResource(pCmdList, m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	DirectX::TransitionResource(pCmdList, m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	DirectX::TransitionResource(pCmdList, m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	DirectX::TransitionResource(pCmdList, m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	DirectX::TransitionResource(pCmdList, m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Transition(m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_StateTracker.Flush(pCmdList);
 
 	D3D12_DISPATCH_RAYS_DESC dispatchDesc;
 	dispatchDesc.Width = m_Width;
@@ -8877,11 +9714,11 @@ void SampleApp::DoPathTracing(ID3D12GraphicsCommandList4* pCmdList)
 
 	pCmdList->DispatchRays(&dispatchDesc);
 
-	DirectX::TransitionResource(pCmdList, m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	DirectX::TransitionResource(pCmdList, m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferBaseColorTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferNormalTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferMetallicRoughnessTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_GBufferEmissiveTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	m_StateTracker.Transition(m_VBufferTarget.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void SampleApp::DrawBackBuffer(ID3D12GraphicsCommandList* pCmdList)
@@ -8941,7 +9778,7 @@ void SampleApp::DrawBackBuffer(ID3D12GraphicsCommandList* pCmdList)
 	::PIXScopedEvent(pCmdList, 0, L"Draw %s to BackBuffer", renderTargetName.c_str());
 
 	{
-		CbSampleTexture* ptr = m_BackBufferCB.GetPtr<CbSampleTexture>();
+		CbSampleTexture* ptr = m_BackBufferCB[m_FrameIndex].GetPtr<CbSampleTexture>();
 		ptr->Contrast = m_debugViewContrast;
 
 		switch (m_debugViewMode)
@@ -8987,7 +9824,8 @@ void SampleApp::DrawBackBuffer(ID3D12GraphicsCommandList* pCmdList)
 	//DirectX::TransitionResource(pCmd, m_SSAO_FullResTarget.GetResource(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	//DirectX::TransitionResource(pCmd, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PRESENT);
 
-	DirectX::TransitionResource(pCmdList, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Transition(m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_BackBuffer[m_FrameIndex].GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -8996,7 +9834,7 @@ void SampleApp::DrawBackBuffer(ID3D12GraphicsCommandList* pCmdList)
 
 	pCmdList->SetGraphicsRootSignature(m_BackBufferRootSig.GetPtr());
 	pCmdList->SetPipelineState(m_pBackBufferPSO.Get());
-	pCmdList->SetGraphicsRootDescriptorTable(0, m_BackBufferCB.GetHandle()->HandleGPU);
+	pCmdList->SetGraphicsRootDescriptorTable(0, m_BackBufferCB[m_FrameIndex].GetHandle()->HandleGPU);
 	switch (m_debugViewMode)
 	{
 		using enum DEBUG_VIEW_MODE;
@@ -9079,15 +9917,16 @@ void SampleApp::DrawBackBuffer(ID3D12GraphicsCommandList* pCmdList)
 
 	pCmdList->DrawInstanced(3, 1, 0, 0);
 
-	DirectX::TransitionResource(pCmdList, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+	m_StateTracker.Transition(m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
 }
 
 void SampleApp::DrawImGui(ID3D12GraphicsCommandList* pCmdList)
 {
 	::PIXScopedEvent(pCmdList, 0, L"ImGui");
 
-	// TODO: Transitionが直前のパスと重複している
-	DirectX::TransitionResource(pCmdList, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	// 直前のDrawBackBuffer()のRENDER_TARGETからPRESENTへの遷移と打ち消し合うので、バリアは発行されない
+	m_StateTracker.Transition(m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_StateTracker.Flush(pCmdList);
 
 	const DescriptorHandle* handleRTV = m_BackBuffer[m_FrameIndex].GetHandleRTV();
 	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, nullptr);
@@ -9101,6 +9940,17 @@ void SampleApp::DrawImGui(ID3D12GraphicsCommandList* pCmdList)
 
 	ImGui::Text("Pix Gpu Capture : Ins");
 
+	// 直前のフレームの一時的なディスクリプタの数と、GPUが使い終わっていない分も含めた数の最大値
+	const DescriptorPool* pPoolGpuVisible = m_pPool[POOL_TYPE_RES_GPU_VISIBLE];
+	ImGui::Text("Transient Descriptors : %llu (In Flight %llu, High Water %llu)",
+		static_cast<unsigned long long>(pPoolGpuVisible->GetLastTransientFrameStats().AllocatedSize),
+		static_cast<unsigned long long>(pPoolGpuVisible->GetLastTransientFrameStats().InFlightSize),
+		static_cast<unsigned long long>(pPoolGpuVisible->GetTransientHighWaterMark()));
+
+	// 直前のフレームで要求されたバリアと、まとめて実際に発行したバリア
+	const ResourceStateTrackerStats& barrierStats = m_StateTracker.GetLastFrameStats();
+	ImGui::Text("Barriers : %u -> %u (%u Calls, %u Split)", barrierStats.RequestedCount, barrierStats.IssuedCount, barrierStats.FlushCount, barrierStats.SplitCount);
+
 	// imgui_demo.cppを参考にしている。右列のラベル部分のサイズを固定する
     ImGui::PushItemWidth(ImGui::GetFontSize() * -12);
 
@@ -9198,7 +10048,7 @@ void SampleApp::DrawImGui(ID3D12GraphicsCommandList* pCmdList)
 	ImGui::Render();
 	ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), pCmdList);
 
-	DirectX::TransitionResource(pCmdList, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+	m_StateTracker.Transition(m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
 }
 
 void SampleApp::ChangeDisplayMode(bool hdr)
@@ -0,0 +1,389 @@
+﻿#include "Benchmarks.h"
+#include "Logger.h"
+#include "ShaderCache.h"
+#include "ShaderDependencyGraph.h"
+#include "FileWatcher.h"
+#include "CounterBasedRandom.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+	bool WriteTextFile(const std::filesystem::path& path, const char* text)
+	{
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		return stream && stream.write(text, strlen(text));
+	}
+
+	// rootの下にシェーダとキャッシュを置き、キーが入力の変化に従うことと、キャッシュのファイルの読み書きを検証する
+	bool ValidateShaderCache(const std::filesystem::path& root)
+	{
+		static constexpr uint32_t NUM_ITERATIONS = 100;
+		static constexpr size_t BLOB_SIZE = 64 * 1024;
+		static constexpr char COMPILER_VERSION[] = "1.8.2405";
+
+		const std::filesystem::path& mainPath = root / "main.hlsl";
+		const std::filesystem::path& includePath = root / "inc" / "b.hlsli";
+		static constexpr char INCLUDE_SOURCE[] = "float4 B() { return 1.0; }\n";
+
+		// main.hlslは同じディレクトリのa.hlsliを、a.hlsliは-Iのディレクトリのb.hlsliをインクルードする
+		std::error_code ec;
+		std::filesystem::create_directories(root / "inc", ec);
+		if (ec
+			|| !WriteTextFile(mainPath, "#include \"a.hlsli\"\nfloat4 main() : SV_Target { return A(); }\n")
+			|| !WriteTextFile(root / "a.hlsli", "#pragma once\n  #  include <b.hlsli>\nfloat4 A() { return B(); }\n")
+			|| !WriteTextFile(includePath, INCLUDE_SOURCE))
+		{
+			ELOG("Error : Failed to Write Shader Sources.");
+			return false;
+		}
+
+		const std::wstring& mainFilePath = mainPath.wstring();
+		const std::wstring& includeDirectory = (root / "inc").wstring();
+		std::vector<const wchar_t*> args = {L"-T ps_6_7", L"-I", includeDirectory.c_str()};
+
+		ShaderCacheKey key;
+		ShaderCacheKey otherKey;
+		if (!ShaderCache::ComputeKey(mainFilePath.c_str(), args, COMPILER_VERSION, key, nullptr)
+			|| !ShaderCache::ComputeKey(mainFilePath.c_str(), args, COMPILER_VERSION, otherKey, nullptr)
+			|| key != otherKey)
+		{
+			ELOG("Error : ShaderCache Key is not Stable.");
+			return false;
+		}
+
+		// 2段目のインクルードを変えたらキーが変わり、戻したら元のキーになる
+		if (!WriteTextFile(includePath, "float4 B() { return 0.5; }\n")
+			|| !ShaderCache::ComputeKey(mainFilePath.c_str(), args, COMPILER_VERSION, otherKey, nullptr)
+			|| key == otherKey)
+		{
+			ELOG("Error : ShaderCache Key Ignores Nested Include.");
+			return false;
+		}
+		if (!WriteTextFile(includePath, INCLUDE_SOURCE)
+			|| !ShaderCache::ComputeKey(mainFilePath.c_str(), args, COMPILER_VERSION, otherKey, nullptr)
+			|| key != otherKey)
+		{
+			ELOG("Error : ShaderCache Key is not Restored.");
+			return false;
+		}
+
+		std::vector<const wchar_t*> debugArgs = args;
+		debugArgs.push_back(L"-Od");
+		if (!ShaderCache::ComputeKey(mainFilePath.c_str(), debugArgs, COMPILER_VERSION, otherKey, nullptr) || key == otherKey)
+		{
+			ELOG("Error : ShaderCache Key Ignores Arguments.");
+			return false;
+		}
+
+		if (!ShaderCache::ComputeKey(mainFilePath.c_str(), args, "1.8.2407", otherKey, nullptr) || key == otherKey)
+		{
+			ELOG("Error : ShaderCache Key Ignores Compiler Version.");
+			return false;
+		}
+
+		ShaderCache cache;
+		const std::wstring& cacheDirectory = (root / "cache").wstring();
+		if (!cache.Init(cacheDirectory.c_str()))
+		{
+			ELOG("Error : ShaderCache::Init() Failed.");
+			return false;
+		}
+
+		std::vector<uint8_t> blob(BLOB_SIZE);
+		for (size_t i = 0; i < blob.size(); i += 4)
+		{
+			uint32_t random[4];
+			GenerateRandom4(static_cast<uint32_t>(i), 0, 0, 0, random);
+			memcpy(&blob[i], random, std::min<size_t>(sizeof(random), blob.size() - i));
+		}
+
+		std::vector<uint8_t> data;
+		if (cache.Load(key, data))
+		{
+			ELOG("Error : ShaderCache Hit before Store.");
+			return false;
+		}
+
+		// ヒットしたら前のコンパイルにかかった時間から読み込みの時間を引いた分を節約したことになる
+		if (!cache.Store(key, blob.data(), blob.size(), 250.0) || !cache.Load(key, data) || data != blob)
+		{
+			ELOG("Error : ShaderCache Round Trip Failed.");
+			return false;
+		}
+
+		double keyMilliseconds = 0.0;
+		double loadMilliseconds = 0.0;
+		for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+		{
+			const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+			ShaderCache::ComputeKey(mainFilePath.c_str(), args, COMPILER_VERSION, otherKey, nullptr);
+			const std::chrono::steady_clock::time_point& middle = std::chrono::steady_clock::now();
+			cache.Load(otherKey, data);
+			const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+			keyMilliseconds += std::chrono::duration<double, std::milli>(middle - start).count();
+			loadMilliseconds += std::chrono::duration<double, std::milli>(end - middle).count();
+		}
+
+		// 途中までしか書かれていないファイルはミスになる
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(cacheDirectory, ec))
+		{
+			std::filesystem::resize_file(entry.path(), BLOB_SIZE / 2, ec);
+		}
+		if (cache.Load(key, data))
+		{
+			ELOG("Error : ShaderCache Hit on Truncated File.");
+			return false;
+		}
+
+		const ShaderCacheStats& stats = cache.GetStats();
+		ELOG("ShaderCache : key %.3f ms, load %.3f ms for %.1f KB, %u hits, %u misses, saved %.1f ms",
+			keyMilliseconds / NUM_ITERATIONS,
+			loadMilliseconds / NUM_ITERATIONS,
+			BLOB_SIZE / 1024.0,
+			stats.HitCount,
+			stats.MissCount,
+			stats.SavedMilliseconds);
+
+		return true;
+	}
+
+	bool ExpectAffectedShaders(const ShaderDependencyGraph& graph, const std::filesystem::path& changedFile, const std::vector<uint32_t>& expected)
+	{
+		std::vector<uint32_t> shaderIndices;
+		graph.CollectAffectedShaders({changedFile.wstring()}, shaderIndices);
+		if (shaderIndices != expected)
+		{
+			ELOG("Error : Unexpected Affected Shaders. file = %ls, count = %zu, expected = %zu", changedFile.wstring().c_str(), shaderIndices.size(), expected.size());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool SetShaderDependencies(ShaderDependencyGraph& graph, uint32_t shaderIdx, const std::filesystem::path& filePath)
+	{
+		// #includeを辿る規則はShaderCacheのキーと同じなので、DXCがなくても依存するファイルが求まる
+		std::vector<const wchar_t*> args = {L"-T ps_6_7"};
+		std::vector<std::wstring> sourceFiles;
+		ShaderCacheKey key;
+		if (!ShaderCache::ComputeKey(filePath.wstring().c_str(), args, "", key, &sourceFiles))
+		{
+			ELOG("Error : ShaderCache::ComputeKey() Failed. path = %ls", filePath.wstring().c_str());
+			return false;
+		}
+
+		graph.SetDependencies(shaderIdx, sourceFiles);
+		return true;
+	}
+
+	// rootの下にシェーダを置き、変わったファイルからコンパイルし直すシェーダだけが引けることと、FileWatcherが変化を見つけることを検証する
+	bool ValidateShaderHotReload(const std::filesystem::path& root)
+	{
+		// common.hlsliはa.hlsliからだけインクルードされる。s0はa、s1はb、s2はaとbをインクルードする
+		std::error_code ec;
+		std::filesystem::create_directories(root, ec);
+		if (ec
+			|| !WriteTextFile(root / "common.hlsli", "float4 Common() { return 1.0; }\n")
+			|| !WriteTextFile(root / "a.hlsli", "#include \"common.hlsli\"\nfloat4 A() { return Common(); }\n")
+			|| !WriteTextFile(root / "b.hlsli", "float4 B() { return 0.5; }\n")
+			|| !WriteTextFile(root / "unused.hlsli", "float4 Unused() { return 0.0; }\n")
+			|| !WriteTextFile(root / "s0.hlsl", "#include \"a.hlsli\"\nfloat4 main() : SV_Target { return A(); }\n")
+			|| !WriteTextFile(root / "s1.hlsl", "#include \"b.hlsli\"\nfloat4 main() : SV_Target { return B(); }\n")
+			|| !WriteTextFile(root / "s2.hlsl", "#include \"a.hlsli\"\n#include \"b.hlsli\"\nfloat4 main() : SV_Target { return A() * B(); }\n"))
+		{
+			ELOG("Error : Failed to Write Shader Sources.");
+			return false;
+		}
+
+		ShaderDependencyGraph graph;
+		for (const char* name : {"s0.hlsl", "s1.hlsl", "s2.hlsl"})
+		{
+			const std::filesystem::path& filePath = root / name;
+			if (!SetShaderDependencies(graph, graph.AddShader(filePath.wstring().c_str()), filePath))
+			{
+				return false;
+			}
+		}
+
+		// 入れ子のインクルードが変わっても、それを辿るシェーダだけをコンパイルし直す
+		if (!ExpectAffectedShaders(graph, root / "common.hlsli", {0, 2})
+			|| !ExpectAffectedShaders(graph, root / "b.hlsli", {1, 2})
+			|| !ExpectAffectedShaders(graph, root / "s1.hlsl", {1})
+			|| !ExpectAffectedShaders(graph, root / "." / "a.hlsli", {0, 2})
+			|| !ExpectAffectedShaders(graph, root / "unused.hlsli", {}))
+		{
+			return false;
+		}
+
+		// s1がaをインクルードするように変えたら、コンパイルし直したときの依存に入れ替わる
+		if (!WriteTextFile(root / "s1.hlsl", "#include \"a.hlsli\"\nfloat4 main() : SV_Target { return A(); }\n")
+			|| !SetShaderDependencies(graph, 1, root / "s1.hlsl"))
+		{
+			return false;
+		}
+		if (!ExpectAffectedShaders(graph, root / "common.hlsli", {0, 1, 2})
+			|| !ExpectAffectedShaders(graph, root / "b.hlsli", {2}))
+		{
+			return false;
+		}
+
+		FileWatcher watcher;
+		std::vector<std::wstring> files;
+		graph.CollectFiles(files);
+		for (const std::wstring& file : files)
+		{
+			watcher.Watch(file);
+		}
+
+		std::vector<std::wstring> changedFiles;
+		watcher.Poll(changedFiles);
+		if (!changedFiles.empty())
+		{
+			ELOG("Error : FileWatcher Reported Unchanged Files.");
+			return false;
+		}
+
+		// 更新時刻の分解能に頼らないように、時刻を直接進める
+		const std::wstring& commonPath = ShaderDependencyGraph::NormalizePath((root / "common.hlsli").wstring());
+		std::filesystem::last_write_time(commonPath, std::filesystem::last_write_time(commonPath, ec) + std::chrono::seconds(2), ec);
+		watcher.Poll(changedFiles);
+		if (ec || changedFiles != std::vector<std::wstring>{commonPath})
+		{
+			ELOG("Error : FileWatcher Missed a Modified File.");
+			return false;
+		}
+		watcher.Poll(changedFiles);
+		if (!changedFiles.empty())
+		{
+			ELOG("Error : FileWatcher Reported a File Twice.");
+			return false;
+		}
+
+		// 消してから書き直すエディタでは、消えている間は知らせず、現れたときに知らせる
+		const std::wstring& bPath = ShaderDependencyGraph::NormalizePath((root / "b.hlsli").wstring());
+		std::filesystem::remove(bPath, ec);
+		watcher.Poll(changedFiles);
+		if (!changedFiles.empty())
+		{
+			ELOG("Error : FileWatcher Reported a Removed File.");
+			return false;
+		}
+		if (!WriteTextFile(bPath, "float4 B() { return 0.25; }\n"))
+		{
+			ELOG("Error : Failed to Write Shader Sources.");
+			return false;
+		}
+		watcher.Poll(changedFiles);
+		if (changedFiles != std::vector<std::wstring>{bPath})
+		{
+			ELOG("Error : FileWatcher Missed a Rewritten File.");
+			return false;
+		}
+
+		return true;
+	}
+}
+
+bool BenchmarkShaderCache()
+{
+	std::error_code ec;
+	const std::filesystem::path& root = std::filesystem::temp_directory_path(ec) / "ShaderCacheBenchmark";
+	if (ec)
+	{
+		ELOG("Error : std::filesystem::temp_directory_path() Failed.");
+		return false;
+	}
+
+	std::filesystem::remove_all(root, ec);
+	bool isValid = ValidateShaderCache(root);
+	std::filesystem::remove_all(root, ec);
+
+	return isValid;
+}
+
+bool BenchmarkShaderHotReload()
+{
+	static constexpr uint32_t NUM_SHADERS = 1000;
+	static constexpr uint32_t NUM_FILES = 200;
+	static constexpr uint32_t NUM_DEPENDENCIES = 8;
+	static constexpr uint32_t NUM_ITERATIONS = 1000;
+
+	std::error_code ec;
+	const std::filesystem::path& root = std::filesystem::temp_directory_path(ec) / "ShaderHotReloadBenchmark";
+	if (ec)
+	{
+		ELOG("Error : std::filesystem::temp_directory_path() Failed.");
+		return false;
+	}
+
+	std::filesystem::remove_all(root, ec);
+	bool isValid = ValidateShaderHotReload(root);
+	std::filesystem::remove_all(root, ec);
+	if (!isValid)
+	{
+		return false;
+	}
+
+	// 1つのファイルが変わったときにコンパイルし直すシェーダを引く時間を、全てのシェーダをコンパイルし直す場合の数と比べる
+	ShaderDependencyGraph graph;
+	// ファイルごとの、それに依存するシェーダの数
+	std::vector<uint32_t> dependentCounts(NUM_FILES, 0);
+	for (uint32_t shaderIdx = 0; shaderIdx < NUM_SHADERS; shaderIdx++)
+	{
+		std::vector<std::wstring> files;
+		std::vector<uint32_t> fileIndices;
+		for (uint32_t i = 0; i < NUM_DEPENDENCIES; i += 4)
+		{
+			uint32_t random[4];
+			GenerateRandom4(shaderIdx, i, 0, 0, random);
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				files.push_back((root / ("file" + std::to_string(random[j] % NUM_FILES) + ".hlsli")).wstring());
+				fileIndices.push_back(random[j] % NUM_FILES);
+			}
+		}
+		graph.SetDependencies(graph.AddShader(L"shader"), files);
+
+		std::sort(fileIndices.begin(), fileIndices.end());
+		fileIndices.erase(std::unique(fileIndices.begin(), fileIndices.end()), fileIndices.end());
+		for (uint32_t fileIdx : fileIndices)
+		{
+			dependentCounts[fileIdx]++;
+		}
+	}
+
+	std::vector<uint32_t> shaderIndices;
+	uint64_t affectedCount = 0;
+	const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+	{
+		graph.CollectAffectedShaders({(root / ("file" + std::to_string(i % NUM_FILES) + ".hlsli")).wstring()}, shaderIndices);
+		affectedCount += shaderIndices.size();
+	}
+	const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+	uint64_t expectedCount = 0;
+	for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+	{
+		expectedCount += dependentCounts[i % NUM_FILES];
+	}
+	if (affectedCount != expectedCount)
+	{
+		ELOG("Error : Affected Shader Count Mismatch. count = %llu, expected = %llu", static_cast<unsigned long long>(affectedCount), static_cast<unsigned long long>(expectedCount));
+		return false;
+	}
+
+	ELOG("ShaderHotReload : %u shaders, %u files, lookup %.3f us per change, %.1f shaders recompiled per change instead of %u",
+		NUM_SHADERS,
+		NUM_FILES,
+		std::chrono::duration<double, std::micro>(end - start).count() / NUM_ITERATIONS,
+		static_cast<double>(affectedCount) / NUM_ITERATIONS,
+		NUM_SHADERS);
+
+	return true;
+}
@@ -2,7 +2,9 @@
 
 #include <SimpleMath.h>
 #include <chrono>
+#include <vector>
 #include "App.h"
+#include "Resource.h"
 #include "VertexBuffer.h"
 #include "ConstantBuffer.h"
 #include "StructuredBuffer.h"
@@ -12,10 +14,39 @@
 #include "RootSignature.h"
 #include "Texture.h"
 #include "TransformManipulator.h"
+#include "CatmullClark.h"
 
 class SubdSampleApp : public App
 {
 public:
 	SubdSampleApp(uint32_t width, uint32_t height);
 	virtual ~SubdSampleApp();
+
+private:
+	CatmullClarkRefiner m_Refiner;
+	// ADAPTIVE_CATMULL_CLARKのときはm_Refinerの代わりにこちらで評価する
+	AdaptiveCatmullClarkRefiner m_AdaptiveRefiner;
+	std::vector<DirectX::SimpleMath::Vector3> m_PatchPoints;
+	std::vector<DirectX::SimpleMath::Vector2> m_DomainPoints;
+	std::vector<DirectX::SimpleMath::Vector3> m_CagePositions;
+	std::vector<DirectX::SimpleMath::Vector3> m_AnimatedCagePositions;
+	std::vector<DirectX::SimpleMath::Vector3> m_RefinedPositions;
+	std::vector<DirectX::SimpleMath::Vector3> m_RefinedNormals;
+	std::chrono::steady_clock::time_point m_StartTime;
+
+	ComPtr<ID3D12PipelineState> m_pSubdPSO;
+	RootSignature m_SubdRootSig;
+	DepthTarget m_SceneDepthTarget;
+	Resource m_CameraCB[FRAME_COUNT];
+	// 細分割した頂点は毎フレームUploadBufferData()で書き換えるので、GPUが読んでいる間に上書きしないようにFRAME_COUNT個持つ
+	Resource m_PositionVB[FRAME_COUNT];
+	Resource m_NormalVB[FRAME_COUNT];
+	Resource m_SubdIB;
+
+	virtual bool OnInit(HWND hWnd) override;
+	virtual void OnTerm() override;
+	virtual void OnRender() override;
+
+	void AnimateCage(float time);
+	void DrawSubd(ID3D12GraphicsCommandList* pCmdList);
 };
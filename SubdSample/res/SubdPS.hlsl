@@ -0,0 +1,27 @@
+#define ROOT_SIGNATURE ""\
+"RootFlags"\
+"("\
+"ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT"\
+" | DENY_HULL_SHADER_ROOT_ACCESS"\
+" | DENY_DOMAIN_SHADER_ROOT_ACCESS"\
+" | DENY_GEOMETRY_SHADER_ROOT_ACCESS"\
+")"\
+", DescriptorTable(CBV(b0), visibility = SHADER_VISIBILITY_VERTEX)"\
+
+struct VSOutput
+{
+	float4 Position : SV_POSITION;
+	float3 Normal : NORMAL;
+};
+
+static const float3 LIGHT_DIRECTION = float3(0.36f, 0.8f, 0.48f);
+static const float3 BASE_COLOR = float3(0.8f, 0.8f, 0.8f);
+static const float AMBIENT = 0.15f;
+
+[RootSignature(ROOT_SIGNATURE)]
+float4 main(const VSOutput input) : SV_TARGET
+{
+	// Face winding follows the cage vertex order, so light both sides the same.
+	float NdotL = abs(dot(normalize(input.Normal), LIGHT_DIRECTION));
+	return float4(BASE_COLOR * (AMBIENT + (1.0f - AMBIENT) * NdotL), 1.0f);
+}
@@ -0,0 +1,29 @@
+cbuffer CbCamera : register(b0)
+{
+	float4x4 View : packoffset(c0);
+	float4x4 Proj : packoffset(c4);
+}
+
+struct VSInput
+{
+	float3 Position : POSITION;
+	float3 Normal : NORMAL;
+};
+
+struct VSOutput
+{
+	float4 Position : SV_POSITION;
+	float3 Normal : NORMAL;
+};
+
+VSOutput main(const VSInput input)
+{
+	VSOutput output = (VSOutput)0;
+
+	// The refined mesh is already in world space.
+	float4 viewPos = mul(View, float4(input.Position, 1.0f));
+	output.Position = mul(Proj, viewPos);
+	output.Normal = input.Normal;
+
+	return output;
+}
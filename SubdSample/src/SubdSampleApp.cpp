@@ -12,13 +12,441 @@
 #include <CommonStates.h>
 #include <DirectXHelpers.h>
 
+// SWTessSample
+#include "tessellator.hpp"
+
 // Framework
+#include "CatmullClark.h"
 #include "FileUtil.h"
+#include "ParallelFor.h"
 #include "Logger.h"
 #include "ScopedTimer.h"
+#include <algorithm>
 
 using namespace DirectX::SimpleMath;
 
+// コメントアウトを外すと起動時に細分割レベル1～4のステンシル適用のスループットを計測してログに出す
+//#define BENCHMARK_CATMULL_CLARK
+// コメントアウトを外すと起動時に一様細分割と特徴適応細分割のメモリ、評価コスト、誤差を比較してログに出す
+//#define BENCHMARK_ADAPTIVE_CATMULL_CLARK
+// コメントアウトを外すと一様細分割の代わりに、特徴適応細分割のパッチをテッセレータの四角形ドメインの点で評価して描画する
+//#define ADAPTIVE_CATMULL_CLARK
+
+namespace
+{
+	static constexpr float CAMERA_FOV_Y_DEGREE = 37.5f;
+	static constexpr float CAMERA_NEAR = 0.1f;
+	static constexpr float CAMERA_FAR = 100.0f;
+
+	static constexpr Vector3 CAMERA_POSITION = Vector3(0.0f, 2.5f, 3.5f);
+	static constexpr Vector3 CAMERA_TARGET = Vector3(0.0f, 0.0f, 0.0f);
+
+	// 描画する細分割レベル。64x32のトーラスでは約13万の四角形になる。
+	// ADAPTIVE_CATMULL_CLARKのときは孤立レベルにし、ドメインを同じ頂点密度になる1 << SUBD_LEVELの係数でテッセレーションする
+	static constexpr uint32_t SUBD_LEVEL = 3;
+
+	struct alignas(256) CbCamera
+	{
+		Matrix View;
+		Matrix Proj;
+	};
+
+	static constexpr uint32_t TORUS_MAJOR_SEGMENTS = 64;
+	static constexpr uint32_t TORUS_MINOR_SEGMENTS = 32;
+	static constexpr float TORUS_MAJOR_RADIUS = 1.0f;
+	static constexpr float TORUS_MINOR_RADIUS = 0.3f;
+
+	// トーラスの四角形ケージ。外周の1周をシャープネス2のクリースにする
+	void CreateTorusCage(uint32_t majorSegments, uint32_t minorSegments, SubdTopology& topology, std::vector<Vector3>& positions)
+	{
+		topology.VertexCount = majorSegments * minorSegments;
+		topology.FaceVertexCounts.assign(majorSegments * minorSegments, 4);
+		topology.FaceVertexIndices.clear();
+		topology.FaceVertexIndices.reserve(majorSegments * minorSegments * 4);
+		topology.Creases.clear();
+		positions.resize(topology.VertexCount);
+
+		for (uint32_t i = 0; i < majorSegments; i++)
+		{
+			float theta = DirectX::XM_2PI * i / majorSegments;
+			uint32_t nextI = (i + 1) % majorSegments;
+
+			for (uint32_t j = 0; j < minorSegments; j++)
+			{
+				float phi = DirectX::XM_2PI * j / minorSegments;
+				uint32_t nextJ = (j + 1) % minorSegments;
+
+				float r = TORUS_MAJOR_RADIUS + TORUS_MINOR_RADIUS * cosf(phi);
+				positions[i * minorSegments + j] = Vector3(r * cosf(theta), TORUS_MINOR_RADIUS * sinf(phi), r * sinf(theta));
+
+				topology.FaceVertexIndices.push_back(i * minorSegments + j);
+				topology.FaceVertexIndices.push_back(i * minorSegments + nextJ);
+				topology.FaceVertexIndices.push_back(nextI * minorSegments + nextJ);
+				topology.FaceVertexIndices.push_back(nextI * minorSegments + j);
+			}
+
+			topology.Creases.push_back({i * minorSegments, nextI * minorSegments, 2.0f});
+		}
+	}
+
+	// 四角形の面の法線を頂点に足し合わせて正規化する。対角線の外積は平面でない四角形でも面積で重み付けした法線になる
+	void ComputeQuadNormals(const std::vector<uint32_t>& faceVertexIndices, const std::vector<Vector3>& positions, std::vector<Vector3>& normals)
+	{
+		std::fill(normals.begin(), normals.end(), Vector3::Zero);
+
+		for (size_t i = 0; i < faceVertexIndices.size(); i += 4)
+		{
+			const Vector3& p0 = positions[faceVertexIndices[i + 0]];
+			const Vector3& p1 = positions[faceVertexIndices[i + 1]];
+			const Vector3& p2 = positions[faceVertexIndices[i + 2]];
+			const Vector3& p3 = positions[faceVertexIndices[i + 3]];
+			const Vector3& faceNormal = (p2 - p0).Cross(p3 - p1);
+
+			for (size_t j = 0; j < 4; j++)
+			{
+				normals[faceVertexIndices[i + j]] += faceNormal;
+			}
+		}
+
+		for (Vector3& normal : normals)
+		{
+			normal.Normalize();
+		}
+	}
+
+#ifdef BENCHMARK_CATMULL_CLARK
+	static constexpr uint32_t MAX_SUBD_LEVEL = 4;
+
+	void BenchmarkCatmullClark()
+	{
+		static constexpr uint32_t NUM_ITERATIONS = 100;
+
+		SubdTopology cage;
+		std::vector<Vector3> cagePositions;
+		CreateTorusCage(TORUS_MAJOR_SEGMENTS, TORUS_MINOR_SEGMENTS, cage, cagePositions);
+
+		// トポロジの細分割とステンシルの計算は一度だけ行う。ケージのアニメーションにはステンシルの適用だけでいい
+		CatmullClarkRefiner refiner;
+		const std::chrono::steady_clock::time_point& initStart = std::chrono::steady_clock::now();
+		if (!refiner.Init(cage, MAX_SUBD_LEVEL))
+		{
+			ELOG("Error : CatmullClarkRefiner::Init() Failed.");
+			return;
+		}
+		const std::chrono::steady_clock::time_point& initEnd = std::chrono::steady_clock::now();
+		ELOG("CatmullClarkRefiner::Init() : Control Points %u, Level %u, %.3f ms", cage.VertexCount, MAX_SUBD_LEVEL, std::chrono::duration<double, std::milli>(initEnd - initStart).count());
+
+		std::vector<Vector3> refined(refiner.GetVertexCount(refiner.GetMaxLevel()));
+
+		for (uint32_t level = 1; level <= refiner.GetMaxLevel(); level++)
+		{
+			const StencilTable& table = refiner.GetStencilTable(level);
+
+			// ウォームアップ
+			refiner.Evaluate(level, cagePositions.data(), refined.data());
+
+			const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+			{
+				refiner.Evaluate(level, cagePositions.data(), refined.data());
+			}
+			const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+
+			double msec = std::chrono::duration<double, std::milli>(end - start).count() / NUM_ITERATIONS;
+			ELOG("Catmull-Clark Level %u : Vertices %u, Stencil Entries %zu, Memory %zu KB, Apply %.3f ms, %.1f MVertices/s, %.1f MEntries/s (%u threads)",
+				level,
+				table.GetStencilCount(),
+				table.GetEntryCount(),
+				table.GetMemorySize() / 1024,
+				msec,
+				table.GetStencilCount() / msec / 1000.0,
+				table.GetEntryCount() / msec / 1000.0,
+				GetParallelForThreadCount());
+		}
+	}
+#endif
+
+#if defined(ADAPTIVE_CATMULL_CLARK) || defined(BENCHMARK_ADAPTIVE_CATMULL_CLARK)
+	// CHWTessellatorで四角形ドメインを全エッジ同じ係数で分割した点と三角形のインデックス
+	void TessellateQuadDomain(uint32_t tessFactor, std::vector<Vector2>& domainPoints, std::vector<uint32_t>& domainIndices)
+	{
+		CHWTessellator tessellator;
+		tessellator.Init(D3D11_TESSELLATOR_PARTITIONING_INTEGER, D3D11_TESSELLATOR_OUTPUT_TRIANGLE_CW);
+
+		float factor = static_cast<float>(tessFactor);
+		tessellator.TessellateQuadDomain(factor, factor, factor, factor, factor, factor);
+
+		const DOMAIN_POINT* pPoints = tessellator.GetPoints();
+		domainPoints.resize(tessellator.GetPointCount());
+		for (size_t i = 0; i < domainPoints.size(); i++)
+		{
+			domainPoints[i] = Vector2(pPoints[i].u, pPoints[i].v);
+		}
+
+		const int* pIndices = tessellator.GetIndices();
+		domainIndices.assign(pIndices, pIndices + tessellator.GetIndexCount());
+	}
+
+	// 全ドメインを同じ点で評価する。出力はドメインごとにdomainPoints.size()個ずつ並ぶ
+	void EvaluateAdaptivePatches(
+		const AdaptiveCatmullClarkRefiner& refiner,
+		const std::vector<Vector3>& patchPoints,
+		const std::vector<Vector2>& domainPoints,
+		std::vector<Vector3>& positions,
+		std::vector<Vector3>& normals)
+	{
+		uint32_t pointCount = static_cast<uint32_t>(domainPoints.size());
+
+		ParallelFor(refiner.GetDomainCount(), 1, [&](uint32_t begin, uint32_t end)
+		{
+			std::vector<Vector3> dus(pointCount);
+			std::vector<Vector3> dvs(pointCount);
+
+			for (uint32_t domain = begin; domain < end; domain++)
+			{
+				Vector3* pPositions = &positions[domain * pointCount];
+				Vector3* pNormals = &normals[domain * pointCount];
+				refiner.Evaluate(domain, pointCount, domainPoints.data(), patchPoints.data(), pPositions, dus.data(), dvs.data());
+
+				for (uint32_t i = 0; i < pointCount; i++)
+				{
+					pNormals[i] = dus[i].Cross(dvs[i]);
+					pNormals[i].Normalize();
+				}
+			}
+		});
+	}
+#endif
+
+#ifdef BENCHMARK_ADAPTIVE_CATMULL_CLARK
+	// 6面をそれぞれsegments x segmentsに分割した立方体の四角形ケージ。8隅が価数3の非正則頂点になる
+	void CreateCubeCage(uint32_t segments, SubdTopology& topology, std::vector<Vector3>& positions)
+	{
+		// 格子点の座標(x, y, z)は[0, segments]の整数。面の法線 = U x V
+		static constexpr int32_t FACE_FRAMES[6][3][3] = {
+			{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, // +X : 原点, U, V
+			{{0, 0, 0}, {0, 0, 1}, {0, 1, 0}}, // -X
+			{{0, 1, 0}, {0, 0, 1}, {1, 0, 0}}, // +Y
+			{{0, 0, 0}, {1, 0, 0}, {0, 0, 1}}, // -Y
+			{{0, 0, 1}, {1, 0, 0}, {0, 1, 0}}, // +Z
+			{{0, 0, 0}, {0, 1, 0}, {1, 0, 0}}, // -Z
+		};
+
+		uint32_t n = segments;
+		std::vector<uint32_t> latticeToVertex((n + 1) * (n + 1) * (n + 1), UINT32_MAX);
+
+		topology.VertexCount = 0;
+		topology.FaceVertexCounts.assign(6 * n * n, 4);
+		topology.FaceVertexIndices.clear();
+		topology.Creases.clear();
+		positions.clear();
+
+		auto getVertex = [&](const int32_t frame[3][3], uint32_t i, uint32_t j)
+		{
+			uint32_t p[3];
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				p[axis] = frame[0][axis] * n + frame[1][axis] * i + frame[2][axis] * j;
+			}
+
+			uint32_t& vertex = latticeToVertex[(p[0] * (n + 1) + p[1]) * (n + 1) + p[2]];
+			if (vertex == UINT32_MAX)
+			{
+				vertex = topology.VertexCount++;
+				positions.push_back(Vector3(2.0f * p[0] / n - 1.0f, 2.0f * p[1] / n - 1.0f, 2.0f * p[2] / n - 1.0f));
+			}
+			return vertex;
+		};
+
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			for (uint32_t j = 0; j < n; j++)
+			{
+				for (uint32_t i = 0; i < n; i++)
+				{
+					topology.FaceVertexIndices.push_back(getVertex(FACE_FRAMES[face], i, j));
+					topology.FaceVertexIndices.push_back(getVertex(FACE_FRAMES[face], i + 1, j));
+					topology.FaceVertexIndices.push_back(getVertex(FACE_FRAMES[face], i + 1, j + 1));
+					topology.FaceVertexIndices.push_back(getVertex(FACE_FRAMES[face], i, j + 1));
+				}
+			}
+		}
+	}
+
+	// 四角形のみのケージで、一様細分割のlevelの面のうちドメイン(face, u, v)を含む面を探し、(u, v)をその面の座標に変換する。
+	// 子の面の並びと座標系はAdaptiveCatmullClarkRefinerのドメインの4分木と同じ
+	uint32_t FindUniformFace(uint32_t face, uint32_t level, float& u, float& v)
+	{
+		for (uint32_t i = 0; i < level; i++)
+		{
+			uint32_t corner;
+			float childU;
+			float childV;
+			if (v < 0.5f)
+			{
+				if (u < 0.5f) { corner = 0; childU = 2.0f * u; childV = 2.0f * v; }
+				else { corner = 1; childU = 2.0f * v; childV = 2.0f - 2.0f * u; }
+			}
+			else
+			{
+				if (u >= 0.5f) { corner = 2; childU = 2.0f - 2.0f * u; childV = 2.0f - 2.0f * v; }
+				else { corner = 3; childU = 2.0f - 2.0f * v; childV = 2.0f * u; }
+			}
+
+			face = face * 4 + corner;
+			u = childU;
+			v = childV;
+		}
+
+		return face;
+	}
+
+	// 一様細分割と特徴適応細分割を、十分細かいレベルの極限位置を基準にした誤差で比較する。
+	// 一様細分割の誤差はそのレベルの四角形を双一次で描いたときの誤差、特徴適応細分割の誤差は双一次のエンドキャップによる誤差
+	void BenchmarkAdaptiveCatmullClark(const char* name, const SubdTopology& cage, const std::vector<Vector3>& cagePositions)
+	{
+		static constexpr uint32_t MAX_LEVEL = 4;
+		static constexpr uint32_t REFERENCE_LEVEL = 6;
+		static constexpr uint32_t NUM_ITERATIONS = 20;
+
+		CatmullClarkRefiner uniform;
+		StencilTable referenceLimit;
+		if (!uniform.Init(cage, REFERENCE_LEVEL) || !uniform.ComputeLimitStencilTable(REFERENCE_LEVEL, referenceLimit))
+		{
+			ELOG("Error : Failed to build reference. %s", name);
+			return;
+		}
+
+		std::vector<Vector3> reference(referenceLimit.GetStencilCount());
+		referenceLimit.Apply(cagePositions.data(), reference.data());
+
+		uint32_t faceCount = static_cast<uint32_t>(cage.FaceVertexCounts.size());
+		uint32_t sampleCount = 1 << REFERENCE_LEVEL;
+
+		// 全ドメインの(sampleCount + 1)^2個の格子点で、基準の極限位置とevaluateの結果の最大距離
+		auto measureError = [&](const std::function<Vector3(uint32_t face, float u, float v)>& evaluate)
+		{
+			float maxError = 0.0f;
+			for (uint32_t face = 0; face < faceCount; face++)
+			{
+				for (uint32_t j = 0; j <= sampleCount; j++)
+				{
+					for (uint32_t i = 0; i <= sampleCount; i++)
+					{
+						float u = static_cast<float>(i) / sampleCount;
+						float v = static_cast<float>(j) / sampleCount;
+
+						float leafU = u;
+						float leafV = v;
+						uint32_t leaf = FindUniformFace(face, REFERENCE_LEVEL, leafU, leafV);
+						uint32_t corner = (leafU < 0.5f) ? ((leafV < 0.5f) ? 0 : 3) : ((leafV < 0.5f) ? 1 : 2);
+						const Vector3& expected = reference[uniform.GetTopology(REFERENCE_LEVEL).FaceVertexIndices[leaf * 4 + corner]];
+
+						maxError = std::max(maxError, Vector3::Distance(evaluate(face, u, v), expected));
+					}
+				}
+			}
+			return maxError;
+		};
+
+		ELOG("Adaptive Catmull-Clark Benchmark : %s, Control Points %u, Faces %u", name, cage.VertexCount, faceCount);
+
+		struct AdaptiveResult
+		{
+			float Error;
+			uint32_t PatchCount;
+			uint32_t PatchPointCount;
+			size_t MemorySize;
+		};
+		std::vector<AdaptiveResult> adaptiveResults(MAX_LEVEL + 1);
+		std::vector<AdaptiveCatmullClarkRefiner> adaptives(MAX_LEVEL + 1);
+		std::vector<std::vector<Vector3>> adaptivePatchPoints(MAX_LEVEL + 1);
+
+		for (uint32_t depth = 1; depth <= MAX_LEVEL; depth++)
+		{
+			AdaptiveCatmullClarkRefiner& adaptive = adaptives[depth];
+			std::vector<Vector3>& patchPoints = adaptivePatchPoints[depth];
+			adaptive.Init(cage, depth);
+			patchPoints.resize(adaptive.GetPatchPointCount());
+			adaptive.EvaluatePatchPoints(cagePositions.data(), patchPoints.data());
+
+			AdaptiveResult& result = adaptiveResults[depth];
+			result.PatchCount = static_cast<uint32_t>(adaptive.GetPatches().size());
+			result.PatchPointCount = adaptive.GetPatchPointCount();
+			result.MemorySize = adaptive.GetMemorySize();
+			result.Error = measureError([&](uint32_t face, float u, float v)
+			{
+				Vector3 position;
+				adaptive.Evaluate(face, u, v, patchPoints.data(), &position, nullptr, nullptr);
+				return position;
+			});
+
+			ELOG("  Adaptive Depth %u : Patches %u, Patch Points %u, Memory %zu KB, Max Error %f",
+				depth, result.PatchCount, result.PatchPointCount, result.MemorySize / 1024, result.Error);
+		}
+
+		for (uint32_t level = 1; level <= MAX_LEVEL; level++)
+		{
+			const StencilTable& table = uniform.GetStencilTable(level);
+			const std::vector<uint32_t>& indices = uniform.GetTopology(level).FaceVertexIndices;
+
+			std::vector<Vector3> refined(table.GetStencilCount());
+			table.Apply(cagePositions.data(), refined.data());
+
+			float uniformError = measureError([&](uint32_t face, float u, float v)
+			{
+				uint32_t leaf = FindUniformFace(face, level, u, v);
+				const Vector3& bottom = Vector3::Lerp(refined[indices[leaf * 4 + 0]], refined[indices[leaf * 4 + 1]], u);
+				const Vector3& top = Vector3::Lerp(refined[indices[leaf * 4 + 3]], refined[indices[leaf * 4 + 2]], u);
+				return Vector3::Lerp(bottom, top, v);
+			});
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+			{
+				table.Apply(cagePositions.data(), refined.data());
+			}
+			double uniformMsec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / NUM_ITERATIONS;
+
+			ELOG("  Uniform Level %u : Vertices %u, Memory %zu KB, Apply %.3f ms, Max Error %f",
+				level, table.GetStencilCount(), table.GetMemorySize() / 1024, uniformMsec, uniformError);
+
+			// 誤差が一様細分割以下になる最小の孤立レベルを、同じ頂点密度のテッセレーションで評価する
+			uint32_t depth = 1;
+			while (depth < MAX_LEVEL && adaptiveResults[depth].Error > uniformError)
+			{
+				depth++;
+			}
+
+			const AdaptiveCatmullClarkRefiner& adaptive = adaptives[depth];
+			std::vector<Vector3>& patchPoints = adaptivePatchPoints[depth];
+
+			std::vector<Vector2> domainPoints;
+			std::vector<uint32_t> domainIndices;
+			TessellateQuadDomain(1 << level, domainPoints, domainIndices);
+			std::vector<Vector3> positions(adaptive.GetDomainCount() * domainPoints.size());
+			std::vector<Vector3> normals(positions.size());
+
+			start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < NUM_ITERATIONS; i++)
+			{
+				adaptive.EvaluatePatchPoints(cagePositions.data(), patchPoints.data());
+				EvaluateAdaptivePatches(adaptive, patchPoints, domainPoints, positions, normals);
+			}
+			double adaptiveMsec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / NUM_ITERATIONS;
+
+			ELOG("  -> Adaptive Depth %u (Error %f) : Memory %zu KB (%.1f%%), Tessellated Points %zu, Evaluate %.3f ms with normals",
+				depth,
+				adaptiveResults[depth].Error,
+				adaptiveResults[depth].MemorySize / 1024,
+				100.0 * adaptiveResults[depth].MemorySize / table.GetMemorySize(),
+				positions.size(),
+				adaptiveMsec);
+		}
+	}
+#endif
+}
+
 SubdSampleApp::SubdSampleApp(uint32_t width, uint32_t height)
 : App(width, height, DXGI_FORMAT_R10G10B10A2_UNORM)
 {
@@ -28,3 +456,419 @@ SubdSampleApp::~SubdSampleApp()
 {
 }
 
+bool SubdSampleApp::OnInit(HWND hWnd)
+{
+#ifdef BENCHMARK_CATMULL_CLARK
+	BenchmarkCatmullClark();
+#endif
+
+#ifdef BENCHMARK_ADAPTIVE_CATMULL_CLARK
+	{
+		SubdTopology benchmarkCage;
+		std::vector<Vector3> benchmarkPositions;
+
+		CreateTorusCage(16, 8, benchmarkCage, benchmarkPositions);
+		BenchmarkAdaptiveCatmullClark("Torus 16x8", benchmarkCage, benchmarkPositions);
+
+		CreateCubeCage(4, benchmarkCage, benchmarkPositions);
+		BenchmarkAdaptiveCatmullClark("Cube 4x4x6", benchmarkCage, benchmarkPositions);
+	}
+#endif
+
+	// ケージの生成と細分割。トポロジの細分割とステンシルの計算はここで一度だけ行い、毎フレームはステンシルの適用と評価だけを行う
+	std::vector<uint32_t> indices;
+	{
+		SubdTopology cage;
+		CreateTorusCage(TORUS_MAJOR_SEGMENTS, TORUS_MINOR_SEGMENTS, cage, m_CagePositions);
+
+#ifdef ADAPTIVE_CATMULL_CLARK
+		const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+		if (!m_AdaptiveRefiner.Init(cage, SUBD_LEVEL))
+		{
+			ELOG("Error : AdaptiveCatmullClarkRefiner::Init() Failed.");
+			return false;
+		}
+		const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+		ELOG("AdaptiveCatmullClarkRefiner::Init() : Control Points %u, Isolation Level %u, Patches %zu, %.3f ms", cage.VertexCount, SUBD_LEVEL, m_AdaptiveRefiner.GetPatches().size(), std::chrono::duration<double, std::milli>(end - start).count());
+
+		std::vector<uint32_t> domainIndices;
+		TessellateQuadDomain(1 << SUBD_LEVEL, m_DomainPoints, domainIndices);
+		m_PatchPoints.resize(m_AdaptiveRefiner.GetPatchPointCount());
+		m_RefinedPositions.resize(m_AdaptiveRefiner.GetDomainCount() * m_DomainPoints.size());
+
+		// 評価した点はドメインごとにm_DomainPoints.size()個ずつ並ぶので、ドメインの三角形をその分ずらして並べる。
+		// ドメインの境界の点は隣のドメインでも重複して評価し、頂点を共有しない
+		indices.reserve(m_AdaptiveRefiner.GetDomainCount() * domainIndices.size());
+		for (uint32_t domain = 0; domain < m_AdaptiveRefiner.GetDomainCount(); domain++)
+		{
+			uint32_t baseVertex = domain * static_cast<uint32_t>(m_DomainPoints.size());
+			for (uint32_t index : domainIndices)
+			{
+				indices.push_back(baseVertex + index);
+			}
+		}
+#else
+		const std::chrono::steady_clock::time_point& start = std::chrono::steady_clock::now();
+		if (!m_Refiner.Init(cage, SUBD_LEVEL))
+		{
+			ELOG("Error : CatmullClarkRefiner::Init() Failed.");
+			return false;
+		}
+		const std::chrono::steady_clock::time_point& end = std::chrono::steady_clock::now();
+		ELOG("CatmullClarkRefiner::Init() : Control Points %u, Level %u, %.3f ms", cage.VertexCount, SUBD_LEVEL, std::chrono::duration<double, std::milli>(end - start).count());
+
+		m_RefinedPositions.resize(m_Refiner.GetVertexCount(SUBD_LEVEL));
+
+		// レベル1以降の面は全て四角形なので、2つの三角形に分ける
+		const std::vector<uint32_t>& faceVertexIndices = m_Refiner.GetTopology(SUBD_LEVEL).FaceVertexIndices;
+		indices.reserve(faceVertexIndices.size() / 4 * 6);
+		for (size_t i = 0; i < faceVertexIndices.size(); i += 4)
+		{
+			indices.push_back(faceVertexIndices[i + 0]);
+			indices.push_back(faceVertexIndices[i + 1]);
+			indices.push_back(faceVertexIndices[i + 2]);
+			indices.push_back(faceVertexIndices[i + 0]);
+			indices.push_back(faceVertexIndices[i + 2]);
+			indices.push_back(faceVertexIndices[i + 3]);
+		}
+#endif
+
+		m_AnimatedCagePositions = m_CagePositions;
+		m_RefinedNormals.resize(m_RefinedPositions.size());
+		m_StartTime = std::chrono::steady_clock::now();
+	}
+
+	// シーン用デプスターゲットの生成
+	{
+		if (!m_SceneDepthTarget.Init
+		(
+			m_pDevice.Get(),
+			m_pPool[POOL_TYPE_DSV],
+			m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
+			m_Width,
+			m_Height,
+			DXGI_FORMAT_D32_FLOAT,
+			1.0f,
+			0
+		))
+		{
+			ELOG("Error : DepthTarget::Init() Failed.");
+			return false;
+		}
+	}
+
+	// 細分割したメッシュの描画用ルートシグニチャとパイプラインステートの生成
+	{
+		std::wstring vsPath;
+		std::wstring psPath;
+
+		if (!SearchFilePath(L"SubdVS.cso", vsPath))
+		{
+			ELOG("Error : Vertex Shader Not Found");
+			return false;
+		}
+
+		if (!SearchFilePath(L"SubdPS.cso", psPath))
+		{
+			ELOG("Error : Pixel Shader Not Found");
+			return false;
+		}
+
+		ComPtr<ID3DBlob> pVSBlob;
+		ComPtr<ID3DBlob> pPSBlob;
+
+		HRESULT hr = D3DReadFileToBlob(vsPath.c_str(), pVSBlob.GetAddressOf());
+		if (FAILED(hr))
+		{
+			ELOG("Error : D3DReadFileToBlob Failed. path = %ls", vsPath.c_str());
+			return false;
+		}
+
+		hr = D3DReadFileToBlob(psPath.c_str(), pPSBlob.GetAddressOf());
+		if (FAILED(hr))
+		{
+			ELOG("Error : D3DReadFileToBlob Failed. path = %ls", psPath.c_str());
+			return false;
+		}
+
+		ComPtr<ID3DBlob> pRSBlob;
+		hr = D3DGetBlobPart(pPSBlob->GetBufferPointer(), pPSBlob->GetBufferSize(), D3D_BLOB_ROOT_SIGNATURE, 0, &pRSBlob);
+		if (FAILED(hr))
+		{
+			ELOG("Error : D3DGetBlobPart Failed. path = %ls", psPath.c_str());
+			return false;
+		}
+
+		if (!m_SubdRootSig.Init(m_pDevice.Get(), pRSBlob))
+		{
+			ELOG("Error : RootSignature::Init() Failed.");
+			return false;
+		}
+
+		// 位置と法線は別々に求めるので、別々の頂点バッファのままスロットを分けて入力する
+		D3D12_INPUT_ELEMENT_DESC inputElements[2];
+		inputElements[0].SemanticName = "POSITION";
+		inputElements[0].SemanticIndex = 0;
+		inputElements[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+		inputElements[0].InputSlot = 0;
+		inputElements[0].AlignedByteOffset = 0;
+		inputElements[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+		inputElements[0].InstanceDataStepRate = 0;
+		inputElements[1].SemanticName = "NORMAL";
+		inputElements[1].SemanticIndex = 0;
+		inputElements[1].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+		inputElements[1].InputSlot = 1;
+		inputElements[1].AlignedByteOffset = 0;
+		inputElements[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+		inputElements[1].InstanceDataStepRate = 0;
+
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+		desc.InputLayout.NumElements = 2;
+		desc.InputLayout.pInputElementDescs = inputElements;
+		desc.pRootSignature = m_SubdRootSig.GetPtr();
+		desc.BlendState = DirectX::CommonStates::Opaque;
+		desc.DepthStencilState = DirectX::CommonStates::DepthDefault;
+		desc.SampleMask = UINT_MAX;
+		// 面の向きはケージの頂点の順で決まるので、カリングせずに両面をシェーダで照らす
+		desc.RasterizerState = DirectX::CommonStates::CullNone;
+		desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		desc.NumRenderTargets = 1;
+		desc.RTVFormats[0] = m_BackBuffer[0].GetRTVDesc().Format;
+		desc.DSVFormat = m_SceneDepthTarget.GetDSVDesc().Format;
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		desc.VS.pShaderBytecode = pVSBlob->GetBufferPointer();
+		desc.VS.BytecodeLength = pVSBlob->GetBufferSize();
+		desc.PS.pShaderBytecode = pPSBlob->GetBufferPointer();
+		desc.PS.BytecodeLength = pPSBlob->GetBufferSize();
+
+		hr = m_pDevice->CreateGraphicsPipelineState(
+			&desc,
+			IID_PPV_ARGS(m_pSubdPSO.GetAddressOf())
+		);
+		if (FAILED(hr))
+		{
+			ELOG("Error : ID3D12Device::CreateGraphicsPipelineState Failed. retcode = 0x%x", hr);
+			return false;
+		}
+	}
+
+	ID3D12GraphicsCommandList* pCmd = m_CommandList.Reset();
+
+	// 細分割したメッシュの頂点バッファとインデックスバッファの生成。頂点は毎フレーム書き換え、インデックスは一度だけ書き込む
+	{
+		size_t vertexCount = m_RefinedPositions.size();
+
+		for (uint32_t i = 0; i < FRAME_COUNT; i++)
+		{
+			if (!m_PositionVB[i].InitAsVertexBuffer<Vector3>(
+				m_pDevice.Get(),
+				vertexCount,
+				D3D12_RESOURCE_FLAG_NONE,
+				D3D12_RESOURCE_STATE_COMMON,
+				m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
+				L"SubdPositionVB"
+			))
+			{
+				ELOG("Error : Resource::InitAsVertexBuffer() Failed.");
+				return false;
+			}
+
+			if (!m_NormalVB[i].InitAsVertexBuffer<Vector3>(
+				m_pDevice.Get(),
+				vertexCount,
+				D3D12_RESOURCE_FLAG_NONE,
+				D3D12_RESOURCE_STATE_COMMON,
+				m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
+				L"SubdNormalVB"
+			))
+			{
+				ELOG("Error : Resource::InitAsVertexBuffer() Failed.");
+				return false;
+			}
+		}
+
+		if (!m_SubdIB.InitAsIndexBuffer<uint32_t>(
+			m_pDevice.Get(),
+			DXGI_FORMAT_R32_UINT,
+			indices.size(),
+			D3D12_RESOURCE_FLAG_NONE,
+			D3D12_RESOURCE_STATE_COMMON,
+			m_pPool[POOL_TYPE_RES_GPU_VISIBLE],
+			L"SubdIB"
+		))
+		{
+			ELOG("Error : Resource::InitAsIndexBuffer() Failed.");
+			return false;
+		}
+
+		if (!m_SubdIB.UploadBufferTypeData<uint32_t>(
+			m_pDevice.Get(),
+			pCmd,
+			indices.size(),
+			indices.data()
+		))
+		{
+			ELOG("Error : Resource::UploadBufferTypeData() Failed.");
+			return false;
+		}
+	}
+
+	// カメラの定数バッファの作成
+	{
+		constexpr float fovY = DirectX::XMConvertToRadians(CAMERA_FOV_Y_DEGREE);
+		float aspect = static_cast<float>(m_Width) / static_cast<float>(m_Height);
+
+		const Matrix& view = Matrix::CreateLookAt(CAMERA_POSITION, CAMERA_TARGET, Vector3::UnitY);
+		const Matrix& proj = Matrix::CreatePerspectiveFieldOfView(fovY, aspect, CAMERA_NEAR, CAMERA_FAR);
+
+		for (uint32_t i = 0u; i < FRAME_COUNT; i++)
+		{
+			if (!m_CameraCB[i].InitAsConstantBuffer<CbCamera>(
+				m_pDevice.Get(),
+				D3D12_HEAP_TYPE_UPLOAD,
+				m_pPool[POOL_TYPE_RES_GPU_VISIBLE]
+			))
+			{
+				ELOG("Error : Resource::InitAsConstantBuffer() Failed.");
+				return false;
+			}
+
+			CbCamera* ptr = m_CameraCB[i].Map<CbCamera>();
+			ptr->View = view;
+			ptr->Proj = proj;
+			m_CameraCB[i].Unmap();
+		}
+	}
+
+	pCmd->Close();
+
+	// UploadBufferData()のコピーはアップロード用のリングのコマンドリストに記録されているので、先に実行する
+	m_UploadRing.Submit();
+	ID3D12CommandList* pLists[] = {pCmd};
+	m_pQueue->ExecuteCommandLists(1, pLists);
+	// Wait command queue finishing.
+	m_Fence.Wait(m_pQueue.Get(), INFINITE);
+
+	return true;
+}
+
+void SubdSampleApp::OnTerm()
+{
+	for (uint32_t i = 0; i < FRAME_COUNT; i++)
+	{
+		m_CameraCB[i].Term();
+		m_PositionVB[i].Term();
+		m_NormalVB[i].Term();
+	}
+
+	m_SubdIB.Term();
+	m_SceneDepthTarget.Term();
+
+	m_pSubdPSO.Reset();
+	m_SubdRootSig.Term();
+
+	m_Refiner.Term();
+	m_AdaptiveRefiner.Term();
+	m_PatchPoints.clear();
+	m_DomainPoints.clear();
+	m_CagePositions.clear();
+	m_AnimatedCagePositions.clear();
+	m_RefinedPositions.clear();
+	m_RefinedNormals.clear();
+}
+
+void SubdSampleApp::OnRender()
+{
+	float time = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_StartTime).count();
+
+	// ケージのアニメーションに対してはトポロジの細分割をやり直さず、ステンシルの適用だけを行う
+	AnimateCage(time);
+#ifdef ADAPTIVE_CATMULL_CLARK
+	// パッチのコントロールポイントだけをステンシルで求め、ドメインの点で極限曲面の位置と偏微分から法線を評価する
+	m_AdaptiveRefiner.EvaluatePatchPoints(m_AnimatedCagePositions.data(), m_PatchPoints.data());
+	EvaluateAdaptivePatches(m_AdaptiveRefiner, m_PatchPoints, m_DomainPoints, m_RefinedPositions, m_RefinedNormals);
+#else
+	m_Refiner.Evaluate(SUBD_LEVEL, m_AnimatedCagePositions.data(), m_RefinedPositions.data());
+	ComputeQuadNormals(m_Refiner.GetTopology(SUBD_LEVEL).FaceVertexIndices, m_RefinedPositions, m_RefinedNormals);
+#endif
+
+	ID3D12GraphicsCommandList* pCmd = m_CommandList.Reset();
+
+	// このフレームの頂点バッファへのコピーはアップロード用のリングのコマンドリストに記録され、pCmdより先に実行される
+	if (!m_PositionVB[m_FrameIndex].UploadBufferTypeData<Vector3>(m_pDevice.Get(), pCmd, m_RefinedPositions.size(), m_RefinedPositions.data())
+		|| !m_NormalVB[m_FrameIndex].UploadBufferTypeData<Vector3>(m_pDevice.Get(), pCmd, m_RefinedNormals.size(), m_RefinedNormals.data()))
+	{
+		ELOG("Error : Resource::UploadBufferTypeData() Failed.");
+	}
+
+	ID3D12DescriptorHeap* const pHeaps[] = {
+		m_pPool[POOL_TYPE_RES_GPU_VISIBLE]->GetHeap()
+	};
+
+	pCmd->SetDescriptorHeaps(1, pHeaps);
+
+	DrawSubd(pCmd);
+
+	pCmd->Close();
+
+	// UploadBufferData()のコピーはアップロード用のリングのコマンドリストに記録されているので、先に実行する
+	m_UploadRing.Submit();
+	ID3D12CommandList* pLists[] = {pCmd};
+	m_pQueue->ExecuteCommandLists(1, pLists);
+
+	Present(1);
+}
+
+void SubdSampleApp::AnimateCage(float time)
+{
+	// 大円方向に進む波で小円の半径方向に揺らす
+	for (uint32_t i = 0; i < TORUS_MAJOR_SEGMENTS; i++)
+	{
+		float theta = DirectX::XM_2PI * i / TORUS_MAJOR_SEGMENTS;
+		float scale = 1.0f + 0.3f * sinf(theta * 4.0f + time * 2.0f);
+		Vector3 center(TORUS_MAJOR_RADIUS * cosf(theta), 0.0f, TORUS_MAJOR_RADIUS * sinf(theta));
+
+		for (uint32_t j = 0; j < TORUS_MINOR_SEGMENTS; j++)
+		{
+			uint32_t index = i * TORUS_MINOR_SEGMENTS + j;
+			m_AnimatedCagePositions[index] = center + (m_CagePositions[index] - center) * scale;
+		}
+	}
+}
+
+void SubdSampleApp::DrawSubd(ID3D12GraphicsCommandList* pCmdList)
+{
+	ScopedTimer scopedTimer(pCmdList, L"Draw Subd");
+
+	DirectX::TransitionResource(pCmdList, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+	const DescriptorHandle* handleRTV = m_BackBuffer[m_FrameIndex].GetHandleRTV();
+	const DescriptorHandle* handleDSV = m_SceneDepthTarget.GetHandleDSV();
+	pCmdList->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, &handleDSV->HandleCPU);
+
+	m_BackBuffer[m_FrameIndex].ClearView(pCmdList);
+	m_SceneDepthTarget.ClearView(pCmdList);
+
+	pCmdList->SetGraphicsRootSignature(m_SubdRootSig.GetPtr());
+	pCmdList->SetGraphicsRootDescriptorTable(0, m_CameraCB[m_FrameIndex].GetHandleCBV()->HandleGPU);
+	pCmdList->SetPipelineState(m_pSubdPSO.Get());
+
+	pCmdList->RSSetViewports(1, &m_Viewport);
+	pCmdList->RSSetScissorRects(1, &m_Scissor);
+
+	pCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	const D3D12_VERTEX_BUFFER_VIEW VBVs[] = {
+		m_PositionVB[m_FrameIndex].GetVBV(),
+		m_NormalVB[m_FrameIndex].GetVBV(),
+	};
+	pCmdList->IASetVertexBuffers(0, 2, VBVs);
+	const D3D12_INDEX_BUFFER_VIEW& IBV = m_SubdIB.GetIBV();
+	pCmdList->IASetIndexBuffer(&IBV);
+
+	pCmdList->DrawIndexedInstanced(static_cast<UINT>(IBV.SizeInBytes / sizeof(uint32_t)), 1, 0, 0, 0);
+
+	DirectX::TransitionResource(pCmdList, m_BackBuffer[m_FrameIndex].GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+	DirectX::TransitionResource(pCmdList, m_SceneDepthTarget.GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+}